@@ -0,0 +1,125 @@
+/**
+ * @file bench.c
+ * @brief Harness of the micro-benchmarks.
+ *
+ * @date 2025-01-01
+ */
+
+/* Includes ------------------------------------------------------------------*/
+#if defined(FAKE_STM32F4)
+#define _POSIX_C_SOURCE 199309L /* clock_gettime() */
+#endif
+
+/* Standard C includes */
+#include <stdio.h>
+#include <stdbool.h>
+#if defined(FAKE_STM32F4)
+#include <time.h>
+#endif
+
+/* HW dependent includes */
+#include "port_system.h"
+#include "port_timer.h"
+
+/* Project includes */
+#include "bench.h"
+
+/* Typedefs --------------------------------------------------------------------*/
+/**
+ * @brief Time of a repetition
+ */
+typedef struct
+{
+    uint32_t counts; /*!< Counts of `_bench_get_counts()` */
+    uint32_t us;     /*!< Microseconds of `port_timer_get_micros()` */
+} bench_time_t;
+
+/* Global variables -----------------------------------------------------------*/
+static bool first_result = true; /*!< No result has been printed yet in the suite */
+
+/* Private functions ----------------------------------------------------------*/
+#if defined(FAKE_STM32F4)
+/* The DWT of the register model of the STM32F4 only counts virtual cycles, so the host code is measured in nanoseconds of real time, as in the native port */
+#define BENCH_COUNTS_PER_US 1000U /*!< Counts of `_bench_get_counts()` per microsecond */
+
+/**
+ * @brief Get the counts of the time base of the benchmarks
+ * @return Nanoseconds of the monotonic clock of the host
+ */
+static uint32_t _bench_get_counts(void)
+{
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (uint32_t)((uint64_t)now.tv_sec * 1000000000U + (uint64_t)now.tv_nsec);
+}
+#else
+#define BENCH_COUNTS_PER_US port_system_get_cycles_per_us() /*!< Counts of `_bench_get_counts()` per microsecond */
+#define _bench_get_counts port_system_get_cycles            /*!< Time base of the benchmarks */
+#endif
+
+/**
+ * @brief Empty benchmark, to subtract the cost of the loop and the call
+ * @param p_arg Not used
+ */
+static void _bench_empty(void *p_arg)
+{
+    __asm__ volatile("" ::: "memory"); /* Keep the call */
+}
+
+/**
+ * @brief Run a benchmark `BENCH_REPEATS` times and keep the fastest repetition
+ * @param iterations Calls per repetition
+ * @param func Function under test, called through a volatile pointer so it is not inlined
+ * @param p_arg Argument of the function
+ * @return Time of the fastest repetition
+ */
+static bench_time_t _bench_measure(uint32_t iterations, bench_func_t func, void *p_arg)
+{
+    bench_func_t volatile p_func = func;
+    bench_time_t best = {.counts = UINT32_MAX, .us = UINT32_MAX};
+
+    p_func(p_arg); /* Warm up the caches and the lazy initializations */
+    for (uint32_t repeat = 0; repeat < BENCH_REPEATS; repeat++)
+    {
+        uint32_t start_us = port_timer_get_micros();
+        uint32_t start = _bench_get_counts();
+        for (uint32_t i = 0; i < iterations; i++)
+        {
+            p_func(p_arg);
+        }
+        uint32_t counts = _bench_get_counts() - start;
+        uint32_t us = port_timer_get_micros() - start_us;
+        best.counts = (counts < best.counts) ? counts : best.counts;
+        best.us = (us < best.us) ? us : best.us;
+    }
+    return best;
+}
+
+/* Public functions -----------------------------------------------------------*/
+void bench_begin(const char *p_suite)
+{
+    port_system_init();
+    first_result = true;
+    printf("{\"suite\": \"%s\", \"platform\": \"%s\", \"counts_per_us\": %lu, \"results\": [\n", p_suite, BENCH_PLATFORM, (unsigned long)BENCH_COUNTS_PER_US);
+}
+
+void bench_run(const char *p_name, uint32_t iterations, bench_func_t func, void *p_arg)
+{
+    bench_time_t baseline = _bench_measure(iterations, _bench_empty, NULL);
+    bench_time_t measured = _bench_measure(iterations, func, p_arg);
+
+    uint32_t counts = (measured.counts > baseline.counts) ? (measured.counts - baseline.counts) : 0U;
+    uint32_t us = (measured.us > baseline.us) ? (measured.us - baseline.us) : 0U;
+    uint32_t counts_per_iter = counts / iterations;
+    uint32_t timer_ns_per_iter = (uint32_t)(((uint64_t)us * 1000U) / iterations);
+
+    printf("%s  {\"name\": \"%s\", \"iterations\": %lu, \"total_counts\": %lu, \"counts_per_iter\": %lu, \"timer_ns_per_iter\": %lu}", first_result ? "" : ",\n", p_name, (unsigned long)iterations, (unsigned long)counts, (unsigned long)counts_per_iter, (unsigned long)timer_ns_per_iter);
+    first_result = false;
+}
+
+int bench_end(void)
+{
+    printf("\n]}\n");
+    fflush(stdout);
+    return 0;
+}
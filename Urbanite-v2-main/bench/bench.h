@@ -0,0 +1,61 @@
+/**
+ * @file bench.h
+ * @brief Header for the harness of the micro-benchmarks.
+ *
+ * A benchmark is a function that runs the code under test once. `bench_run()` calls it `iterations` times, `BENCH_REPEATS` times in a row, and keeps the fastest repetition, minus the time of calling an empty function the same number of times. The results are printed to the standard output (semihosting in the STM32F4) as one JSON document per executable, so they can be stored and compared across commits:
+ *
+ * `{"suite": "<suite>", "platform": "<platform>", "counts_per_us": <n>, "results": [{"name": "<name>", "iterations": <n>, "total_counts": <n>, "counts_per_iter": <n>, "timer_ns_per_iter": <n>}, ...]}`
+ *
+ * Two times are reported for each benchmark:
+ * - `counts_per_iter`: counts of `port_system_get_cycles()` (`total_counts` for all the iterations, to keep the fraction). They are CPU cycles (DWT CYCCNT) in the STM32F4 and nanoseconds of real time in the host. QEMU does not emulate the DWT, so they are 0 there. With the register model of the STM32F4 (`stm32f4-fake`), they are nanoseconds of real time of the STM32F4 drivers running in the host.
+ * - `timer_ns_per_iter`: time measured with `port_timer_get_micros()`. In QEMU with `-icount shift=0` the virtual clock advances 1 ns per instruction, so this is the deterministic number of instructions of the benchmark. In the host the timer is the virtual time, which does not advance while the code runs, so it is 0 there.
+ *
+ * @date 2025-01-01
+ */
+#ifndef BENCH_H_
+#define BENCH_H_
+
+/* Includes ------------------------------------------------------------------*/
+/* Standard C includes */
+#include <stdint.h>
+
+/* Defines and enums ----------------------------------------------------------*/
+#define BENCH_REPEATS 5U /*!< Repetitions of each benchmark. The fastest one is reported */
+
+#if defined(__arm__)
+#define BENCH_PLATFORM "stm32f4" /*!< Platform in the results */
+#elif defined(FAKE_STM32F4)
+#define BENCH_PLATFORM "stm32f4-fake"
+#else
+#define BENCH_PLATFORM "native"
+#endif
+
+/* Typedefs --------------------------------------------------------------------*/
+typedef void (*bench_func_t)(void *p_arg); /*!< Code under test. It runs once per call */
+
+/* Function prototypes and explanation -------------------------------------------------*/
+/**
+ * @brief Initialize the system and start the JSON document of a suite.
+ *
+ * @param p_suite Name of the suite
+ */
+void bench_begin(const char *p_suite);
+
+/**
+ * @brief Measure a benchmark and print its result.
+ *
+ * @param p_name Name of the benchmark, unique in the suite
+ * @param iterations Calls of the function per repetition
+ * @param func Function under test
+ * @param p_arg Argument of the function
+ */
+void bench_run(const char *p_name, uint32_t iterations, bench_func_t func, void *p_arg);
+
+/**
+ * @brief Finish the JSON document of the suite.
+ *
+ * @return Exit code of the benchmark executable
+ */
+int bench_end(void);
+
+#endif /* BENCH_H_ */
@@ -0,0 +1,84 @@
+/**
+ * @file bench_distance_batch.c
+ * @brief Micro-benchmark of the batch filter of the distances of several ultrasound sensors.
+ *
+ * The windows of `DISTANCE_BATCH_MAX_SENSORS` sensors are filtered three ways: with `distance_batch_filter()` (packed instructions of the platform), with `distance_batch_filter_scalar()`, and with one `qsort()` median per sensor, as `do_set_distance()` does today. Every call filters all the sensors, so the times are comparable.
+ *
+ * @date 2025-01-01
+ */
+/* Standard C libraries */
+#include <stdlib.h>
+#include <string.h>
+
+/* Project libraries */
+#include "distance_batch.h"
+#include "bench.h"
+
+/* Global variables ----------------------------------------------------------*/
+static distance_batch_t batch;          /*!< Windows of the sensors */
+static distance_batch_result_t result;  /*!< Results of the batch filters */
+static volatile uint32_t median;        /*!< Result of the per-sensor filter, volatile so it is not optimized out */
+
+/* Private functions ---------------------------------------------------------*/
+/**
+ * @brief Comparison function of `qsort()`, as in the ultrasound FSM
+ */
+static int _bench_compare(const void *a, const void *b)
+{
+    uint32_t x = *(const uint32_t *)a;
+    uint32_t y = *(const uint32_t *)b;
+    return (x > y) - (x < y);
+}
+
+/**
+ * @brief Median of every sensor with `qsort()`, one call per sensor
+ * @param p_arg Not used
+ */
+static void _bench_qsort_per_sensor(void *p_arg)
+{
+    for (uint32_t sensor = 0; sensor < DISTANCE_BATCH_MAX_SENSORS; sensor++)
+    {
+        uint32_t distance_arr[DISTANCE_BATCH_NUM_MEASUREMENTS];
+        for (uint32_t k = 0; k < DISTANCE_BATCH_NUM_MEASUREMENTS; k++)
+        {
+            distance_arr[k] = batch.window_arr[k][sensor];
+        }
+        qsort(distance_arr, DISTANCE_BATCH_NUM_MEASUREMENTS, sizeof(uint32_t), _bench_compare);
+        median = distance_arr[DISTANCE_BATCH_NUM_MEASUREMENTS / 2];
+    }
+}
+
+/**
+ * @brief Minimum, maximum and median of every sensor, one lane at a time
+ * @param p_arg Not used
+ */
+static void _bench_batch_scalar(void *p_arg)
+{
+    distance_batch_filter_scalar(&batch, DISTANCE_BATCH_MAX_SENSORS, &result);
+}
+
+/**
+ * @brief Minimum, maximum and median of every sensor with the packed instructions of the platform
+ * @param p_arg Not used
+ */
+static void _bench_batch(void *p_arg)
+{
+    distance_batch_filter(&batch, DISTANCE_BATCH_MAX_SENSORS, &result);
+}
+
+int main(void)
+{
+    for (uint32_t sensor = 0; sensor < DISTANCE_BATCH_MAX_SENSORS; sensor++)
+    {
+        for (uint32_t k = 0; k < DISTANCE_BATCH_NUM_MEASUREMENTS; k++)
+        {
+            distance_batch_set(&batch, sensor, k, (37U * (sensor + 1U) * (k + 3U)) % 400U); /* Unsorted windows, different for every sensor */
+        }
+    }
+
+    bench_begin("distance_batch");
+    bench_run("qsort_per_sensor", 10000, _bench_qsort_per_sensor, NULL);
+    bench_run("batch_scalar", 10000, _bench_batch_scalar, NULL);
+    bench_run("batch_simd", 10000, _bench_batch, NULL);
+    return bench_end();
+}
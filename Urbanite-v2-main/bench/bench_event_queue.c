@@ -0,0 +1,89 @@
+/**
+ * @file bench_event_queue.c
+ * @brief Micro-benchmark of the event queues: the events of the scheduler and the queues of key and gesture events.
+ *
+ * @date 2025-01-01
+ */
+/* Standard C libraries */
+#include <stddef.h>
+
+/* HW libraries */
+#include "port_debounce.h"
+
+/* Project libraries */
+#include "scheduler.h"
+#include "fsm_gesture.h"
+#include "bench.h"
+
+/* Defines ------------------------------------------------------------------*/
+#define BENCH_EVENT_ITERATIONS 10000U /*!< Operations per repetition */
+#define BENCH_EVENT (1U << 0)         /*!< Event that releases the task */
+
+/* Global variables ----------------------------------------------------------*/
+static volatile uint32_t task_runs; /*!< Runs of the task, volatile so the calls are not optimized out */
+
+/* Private functions ---------------------------------------------------------*/
+/**
+ * @brief Task released by the event
+ * @param p_arg Not used
+ */
+static void _bench_task(void *p_arg)
+{
+    task_runs++;
+}
+
+/**
+ * @brief Post an event to the scheduler and dispatch the task it releases
+ * @param p_arg Not used
+ */
+static void _bench_post_and_dispatch(void *p_arg)
+{
+    scheduler_post_event(BENCH_EVENT);
+    scheduler_dispatch();
+}
+
+/**
+ * @brief Dispatch without any task released
+ * @param p_arg Not used
+ */
+static void _bench_dispatch_idle(void *p_arg)
+{
+    scheduler_dispatch();
+}
+
+/**
+ * @brief Poll the empty queue of key events
+ * @param p_arg Not used
+ */
+static void _bench_debounce_get_event(void *p_arg)
+{
+    port_debounce_event_t event;
+    task_runs += port_debounce_get_event(&event) ? 1U : 0U;
+}
+
+/**
+ * @brief Poll the empty queue of gesture events
+ * @param p_arg Not used
+ */
+static void _bench_gesture_get_event(void *p_arg)
+{
+    fsm_gesture_event_t event;
+    task_runs += fsm_gesture_get_event(&event) ? 1U : 0U;
+}
+
+int main(void)
+{
+    bench_begin("event_queue");
+
+    scheduler_init();
+    scheduler_task_config_t config = {.p_name = "bench", .func = _bench_task, .p_arg = NULL, .event_mask = BENCH_EVENT, .deadline_ms = 1000};
+    scheduler_add_task(&config);
+    bench_run("scheduler_post_and_dispatch", BENCH_EVENT_ITERATIONS, _bench_post_and_dispatch, NULL);
+    bench_run("scheduler_dispatch_idle", BENCH_EVENT_ITERATIONS, _bench_dispatch_idle, NULL);
+
+    port_debounce_init();
+    bench_run("debounce_get_event_empty", BENCH_EVENT_ITERATIONS, _bench_debounce_get_event, NULL);
+    bench_run("gesture_get_event_empty", BENCH_EVENT_ITERATIONS, _bench_gesture_get_event, NULL);
+
+    return bench_end();
+}
@@ -0,0 +1,71 @@
+/**
+ * @file bench_fsm.c
+ * @brief Micro-benchmark of `fsm_fire()` of each FSM of the project.
+ *
+ * Each FSM is fired in its idle state, where the guards of the state are evaluated and no transition is taken. That is the cost paid by the FSMs in every dispatch while nothing happens.
+ *
+ * @date 2025-01-01
+ */
+/* Standard C libraries */
+#include <stdlib.h>
+
+/* HW libraries */
+#include "port_button.h"
+#include "port_ultrasound.h"
+
+/* Project libraries */
+#include "fsm_button.h"
+#include "fsm_gesture.h"
+#include "fsm_ultrasound.h"
+#include "bench.h"
+
+/* Defines ------------------------------------------------------------------*/
+#define BENCH_FSM_ITERATIONS 10000U /*!< Fires per repetition */
+#define BENCH_DEBOUNCE_MS 100U      /*!< Debounce time of the button FSM */
+
+/* Private functions ---------------------------------------------------------*/
+/**
+ * @brief Fire the button FSM
+ * @param p_arg Pointer to the FSM
+ */
+static void _bench_button_fire(void *p_arg)
+{
+    fsm_button_fire((fsm_button_t *)p_arg);
+}
+
+/**
+ * @brief Fire the gesture FSM
+ * @param p_arg Pointer to the FSM
+ */
+static void _bench_gesture_fire(void *p_arg)
+{
+    fsm_gesture_fire((fsm_gesture_t *)p_arg);
+}
+
+/**
+ * @brief Fire the ultrasound FSM
+ * @param p_arg Pointer to the FSM
+ */
+static void _bench_ultrasound_fire(void *p_arg)
+{
+    fsm_ultrasound_fire((fsm_ultrasound_t *)p_arg);
+}
+
+int main(void)
+{
+    bench_begin("fsm_fire");
+
+    fsm_button_t *p_fsm_button = fsm_button_new(BENCH_DEBOUNCE_MS, PORT_PARKING_BUTTON_ID);
+    bench_run("button_idle", BENCH_FSM_ITERATIONS, _bench_button_fire, p_fsm_button);
+    fsm_button_destroy(p_fsm_button);
+
+    fsm_gesture_t *p_fsm_gesture = fsm_gesture_new(NULL, 0);
+    bench_run("gesture_idle", BENCH_FSM_ITERATIONS, _bench_gesture_fire, p_fsm_gesture);
+    fsm_gesture_destroy(p_fsm_gesture);
+
+    fsm_ultrasound_t *p_fsm_ultrasound = fsm_ultrasound_new(PORT_REAR_PARKING_SENSOR_ID);
+    bench_run("ultrasound_idle", BENCH_FSM_ITERATIONS, _bench_ultrasound_fire, p_fsm_ultrasound);
+    fsm_ultrasound_destroy(p_fsm_ultrasound);
+
+    return bench_end();
+}
@@ -0,0 +1,77 @@
+/**
+ * @file bench_log.c
+ * @brief Micro-benchmark of the deferred logger.
+ *
+ * The records are discarded after each write, moving the tail of the ring buffer to its head, so every call takes the path of a buffer with free space. The drain depends on the sink and is not measured.
+ *
+ * @date 2025-01-01
+ */
+/* Standard C libraries */
+#include <stddef.h>
+
+/* HW libraries */
+#include "port_log.h"
+#include "bench.h"
+
+/* Defines ------------------------------------------------------------------*/
+#define BENCH_LOG_ITERATIONS 10000U /*!< Records per repetition */
+
+/* Private functions ---------------------------------------------------------*/
+/**
+ * @brief Discard the records written
+ */
+static void _bench_log_discard(void)
+{
+    port_log_buffer.tail = port_log_buffer.head;
+}
+
+/**
+ * @brief Write a record without arguments
+ * @param p_arg Not used
+ */
+static void _bench_log_0_args(void *p_arg)
+{
+    PORT_LOG_ERROR(PORT_LOG_MSG_BOOT);
+    _bench_log_discard();
+}
+
+/**
+ * @brief Write a record with 2 arguments
+ * @param p_arg Not used
+ */
+static void _bench_log_2_args(void *p_arg)
+{
+    PORT_LOG_ERROR(PORT_LOG_MSG_DISTANCE, 0, 42);
+    _bench_log_discard();
+}
+
+/**
+ * @brief Write a record with 4 arguments
+ * @param p_arg Not used
+ */
+static void _bench_log_4_args(void *p_arg)
+{
+    PORT_LOG_ERROR(PORT_LOG_MSG_PROFILE_CYCLES, 1, 2, 3, 4);
+    _bench_log_discard();
+}
+
+/**
+ * @brief Write a record to a full buffer, which drops it
+ * @param p_arg Not used
+ */
+static void _bench_log_dropped(void *p_arg)
+{
+    PORT_LOG_ERROR(PORT_LOG_MSG_DISTANCE, 0, 42);
+}
+
+int main(void)
+{
+    bench_begin("log");
+
+    bench_run("write_0_args", BENCH_LOG_ITERATIONS, _bench_log_0_args, NULL);
+    bench_run("write_2_args", BENCH_LOG_ITERATIONS, _bench_log_2_args, NULL);
+    bench_run("write_4_args", BENCH_LOG_ITERATIONS, _bench_log_4_args, NULL);
+    bench_run("write_dropped", BENCH_LOG_ITERATIONS, _bench_log_dropped, NULL);
+
+    return bench_end();
+}
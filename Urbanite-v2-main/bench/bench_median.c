@@ -0,0 +1,61 @@
+/**
+ * @file bench_median.c
+ * @brief Micro-benchmark of the median filter of the ultrasound FSM.
+ *
+ * The filter sorts the last `FSM_ULTRASOUND_NUM_MEASUREMENTS` distances with `qsort()` and takes the central one, as `do_set_distance()` does. The input is refreshed before every call, so each call sorts unsorted data.
+ *
+ * @date 2025-01-01
+ */
+/* Standard C libraries */
+#include <stdlib.h>
+#include <string.h>
+
+/* Project libraries */
+#include "fsm_ultrasound.h"
+#include "bench.h"
+
+/* Global variables ----------------------------------------------------------*/
+static const uint32_t input_arr[FSM_ULTRASOUND_NUM_MEASUREMENTS] = {120, 35, 400, 36, 118}; /*!< Distances in cm, with an outlier */
+static volatile uint32_t median;                                                            /*!< Result, volatile so the filter is not optimized out */
+
+/* Private functions ---------------------------------------------------------*/
+/**
+ * @brief Comparison function of `qsort()`, as in the ultrasound FSM
+ */
+static int _bench_compare(const void *a, const void *b)
+{
+    uint32_t x = *(const uint32_t *)a;
+    uint32_t y = *(const uint32_t *)b;
+    return (x > y) - (x < y);
+}
+
+/**
+ * @brief Median of the measurements with `qsort()`
+ * @param p_arg Not used
+ */
+static void _bench_median_qsort(void *p_arg)
+{
+    uint32_t distance_arr[FSM_ULTRASOUND_NUM_MEASUREMENTS];
+    memcpy(distance_arr, input_arr, sizeof(distance_arr));
+    qsort(distance_arr, FSM_ULTRASOUND_NUM_MEASUREMENTS, sizeof(uint32_t), _bench_compare);
+    median = distance_arr[FSM_ULTRASOUND_NUM_MEASUREMENTS / 2];
+}
+
+/**
+ * @brief Copy of the input alone, to tell its cost apart from the filter
+ * @param p_arg Not used
+ */
+static void _bench_copy(void *p_arg)
+{
+    uint32_t distance_arr[FSM_ULTRASOUND_NUM_MEASUREMENTS];
+    memcpy(distance_arr, input_arr, sizeof(distance_arr));
+    median = distance_arr[FSM_ULTRASOUND_NUM_MEASUREMENTS / 2];
+}
+
+int main(void)
+{
+    bench_begin("median");
+    bench_run("copy_input", 10000, _bench_copy, NULL);
+    bench_run("median_qsort", 10000, _bench_median_qsort, NULL);
+    return bench_end();
+}
@@ -0,0 +1,104 @@
+/**
+ * @file bench_port.c
+ * @brief Micro-benchmark of the accessors of the port layer called by the FSMs.
+ *
+ * @date 2025-01-01
+ */
+/* Standard C libraries */
+#include <stddef.h>
+
+/* HW libraries */
+#include "port_system.h"
+#include "port_button.h"
+#include "port_ultrasound.h"
+#include "port_timer.h"
+#include "bench.h"
+
+/* Defines ------------------------------------------------------------------*/
+#define BENCH_PORT_ITERATIONS 100000U /*!< Calls per repetition */
+#define BENCH_PORT_INIT_ITERATIONS 1000U /*!< Calls per repetition of the initializations, which program the peripherals */
+
+/* Global variables ----------------------------------------------------------*/
+static volatile uint32_t sink; /*!< Result, volatile so the calls are not optimized out */
+
+/* Private functions ---------------------------------------------------------*/
+/**
+ * @brief Read the state of the button
+ * @param p_arg Not used
+ */
+static void _bench_button_get_pressed(void *p_arg)
+{
+    sink = port_button_get_pressed(PORT_PARKING_BUTTON_ID);
+}
+
+/**
+ * @brief Read a tick of the echo of the ultrasound sensor
+ * @param p_arg Not used
+ */
+static void _bench_ultrasound_get_echo_init_tick(void *p_arg)
+{
+    sink = port_ultrasound_get_echo_init_tick(PORT_REAR_PARKING_SENSOR_ID);
+}
+
+/**
+ * @brief Read the trigger flag of the ultrasound sensor
+ * @param p_arg Not used
+ */
+static void _bench_ultrasound_get_trigger_ready(void *p_arg)
+{
+    sink = port_ultrasound_get_trigger_ready(PORT_REAR_PARKING_SENSOR_ID);
+}
+
+/**
+ * @brief Read the system time in milliseconds
+ * @param p_arg Not used
+ */
+static void _bench_system_get_millis(void *p_arg)
+{
+    sink = port_system_get_millis();
+}
+
+/**
+ * @brief Read the system time in microseconds
+ * @param p_arg Not used
+ */
+static void _bench_timer_get_micros(void *p_arg)
+{
+    sink = port_timer_get_micros();
+}
+
+/**
+ * @brief Initialize the ultrasound sensor: GPIOs and the timers of the trigger and the echo
+ * @param p_arg Not used
+ */
+static void _bench_ultrasound_init(void *p_arg)
+{
+    port_ultrasound_init(PORT_REAR_PARKING_SENSOR_ID);
+}
+
+/**
+ * @brief Enter and exit a critical section
+ * @param p_arg Not used
+ */
+static void _bench_critical_section(void *p_arg)
+{
+    port_system_enter_critical();
+    port_system_exit_critical();
+}
+
+int main(void)
+{
+    bench_begin("port");
+    port_button_init(PORT_PARKING_BUTTON_ID);
+    port_ultrasound_init(PORT_REAR_PARKING_SENSOR_ID);
+
+    bench_run("button_get_pressed", BENCH_PORT_ITERATIONS, _bench_button_get_pressed, NULL);
+    bench_run("ultrasound_get_echo_init_tick", BENCH_PORT_ITERATIONS, _bench_ultrasound_get_echo_init_tick, NULL);
+    bench_run("ultrasound_get_trigger_ready", BENCH_PORT_ITERATIONS, _bench_ultrasound_get_trigger_ready, NULL);
+    bench_run("system_get_millis", BENCH_PORT_ITERATIONS, _bench_system_get_millis, NULL);
+    bench_run("timer_get_micros", BENCH_PORT_ITERATIONS, _bench_timer_get_micros, NULL);
+    bench_run("critical_section", BENCH_PORT_ITERATIONS, _bench_critical_section, NULL);
+    bench_run("ultrasound_init", BENCH_PORT_INIT_ITERATIONS, _bench_ultrasound_init, NULL);
+
+    return bench_end();
+}
@@ -0,0 +1,19 @@
+# Run a benchmark and store its JSON results:
+#   cmake -DBENCH_COMMAND="<command line>" -DBENCH_OUTPUT=<file.json> -P run_bench.cmake
+# QEMU may not exit when the benchmark returns, so the run ends with a timeout and is valid if the JSON document is complete.
+SET(BENCH_TIMEOUT_S 600)
+
+SEPARATE_ARGUMENTS(BENCH_COMMAND_LIST UNIX_COMMAND "${BENCH_COMMAND}")
+GET_FILENAME_COMPONENT(BENCH_OUTPUT_DIR ${BENCH_OUTPUT} DIRECTORY)
+FILE(MAKE_DIRECTORY ${BENCH_OUTPUT_DIR})
+EXECUTE_PROCESS(COMMAND ${BENCH_COMMAND_LIST}
+    OUTPUT_FILE ${BENCH_OUTPUT}
+    TIMEOUT ${BENCH_TIMEOUT_S}
+    RESULT_VARIABLE BENCH_RESULT)
+
+FILE(READ ${BENCH_OUTPUT} BENCH_JSON)
+STRING(FIND "${BENCH_JSON}" "]}" BENCH_END)
+IF(BENCH_END EQUAL -1)
+    MESSAGE(FATAL_ERROR "Incomplete results in ${BENCH_OUTPUT} (${BENCH_RESULT})")
+ENDIF()
+MESSAGE(STATUS "Results in ${BENCH_OUTPUT}")
@@ -0,0 +1,89 @@
+/**
+ * @file distance_batch.h
+ * @brief Header for distance_batch.c file, a batch filter of the windows of distances of several ultrasound sensors.
+ *
+ * The windows of up to `DISTANCE_BATCH_MAX_SENSORS` sensors are kept in a structure-of-arrays layout: `window_arr[k][s]` is the k-th measurement of the sensor `s`, in cm as `uint16_t`. So every row holds the same measurement of all the sensors, and two sensors (lanes) fit in a 32-bit word. `distance_batch_filter()` computes the minimum, the maximum and the median of the window of every sensor with a branchless sorting network over the rows, so all the lanes are filtered at once:
+ * - Cortex-M4 (`__ARM_FEATURE_SIMD32`): two lanes per instruction with the packed 16-bit instructions (`USUB16` + `SEL` for the minimum and the maximum, `UHADD16` for the mean of the two central values of an even window). They are the `__USUB16()`, `__SEL()` and `__UHADD16()` of CMSIS.
+ * - Host with SSE2 (`__SSE2__`): the eight lanes in a 128-bit register.
+ * - Otherwise the portable `distance_batch_filter_scalar()`, which is also the reference of the others.
+ *
+ * `distance_batch_filter_lane()` filters the window of one sensor only, for a user that gets the measurements of the sensors one at a time (e.g., the median stage of the pipeline, see distance_stages.h): it does not read the windows of the other sensors, so each sensor can be filled and filtered from its own thread. It is the filter of the ultrasound FSM: the packed paths of `distance_batch_filter()` only run for a user that fills the windows of all the sensors before filtering them (e.g., bench_distance_batch.c).
+ *
+ * The median is the one of `do_set_distance()`: the central value of the sorted window, or the floor of the mean of the two central values if the window is even.
+ *
+ * @date 2025-01-01
+ */
+#ifndef DISTANCE_BATCH_H_
+#define DISTANCE_BATCH_H_
+
+/* Includes ------------------------------------------------------------------*/
+/* Standard C includes */
+#include <stdint.h>
+
+/* Project includes */
+#include "fsm_ultrasound.h"
+
+/* Defines and enums ----------------------------------------------------------*/
+#define DISTANCE_BATCH_MAX_SENSORS 8U                                    /*!< Sensors (lanes) of a batch */
+#define DISTANCE_BATCH_NUM_MEASUREMENTS FSM_ULTRASOUND_NUM_MEASUREMENTS /*!< Measurements in the window of each sensor */
+
+/* Typedefs --------------------------------------------------------------------*/
+/**
+ * @brief Windows of the sensors of a batch, in structure-of-arrays layout
+ */
+typedef struct
+{
+    _Alignas(16) uint16_t window_arr[DISTANCE_BATCH_NUM_MEASUREMENTS][DISTANCE_BATCH_MAX_SENSORS]; /*!< `window_arr[k][s]`: k-th measurement of the sensor s, in cm */
+} distance_batch_t;
+
+/**
+ * @brief Results of the filter, one lane per sensor
+ */
+typedef struct
+{
+    _Alignas(16) uint16_t min_arr[DISTANCE_BATCH_MAX_SENSORS]; /*!< Minimum distance of the window of each sensor, in cm */
+    _Alignas(16) uint16_t max_arr[DISTANCE_BATCH_MAX_SENSORS]; /*!< Maximum distance of the window of each sensor, in cm */
+    _Alignas(16) uint16_t median_arr[DISTANCE_BATCH_MAX_SENSORS]; /*!< Median distance of the window of each sensor, in cm */
+} distance_batch_result_t;
+
+/* Function prototypes and explanation -------------------------------------------------*/
+/**
+ * @brief Store a measurement of a sensor in its window.
+ *
+ * @param p_batch Pointer to the batch
+ * @param sensor Sensor (lane) of the measurement
+ * @param idx Position of the measurement in the window
+ * @param distance_cm Distance in cm. Distances above `UINT16_MAX` are saturated
+ */
+void distance_batch_set(distance_batch_t *p_batch, uint32_t sensor, uint32_t idx, uint32_t distance_cm);
+
+/**
+ * @brief Compute the minimum, the maximum and the median of the windows of a batch, with the packed instructions of the platform if it has them.
+ *
+ * The lanes are filtered in groups (two in the Cortex-M4, eight with SSE2), so the results of the lanes from `num_sensors` to the end of the last group are also written, from whatever their windows hold.
+ *
+ * @param p_batch Pointer to the batch
+ * @param num_sensors Sensors to filter, from lane 0 (at most `DISTANCE_BATCH_MAX_SENSORS`)
+ * @param p_result Pointer to store the results
+ */
+void distance_batch_filter(const distance_batch_t *p_batch, uint32_t num_sensors, distance_batch_result_t *p_result);
+
+/**
+ * @brief Compute the minimum, the maximum and the median of the windows of a batch, one lane at a time and without packed instructions. Only the lanes below `num_sensors` are written.
+ *
+ * @param p_batch Pointer to the batch
+ * @param num_sensors Sensors to filter, from lane 0 (at most `DISTANCE_BATCH_MAX_SENSORS`)
+ * @param p_result Pointer to store the results
+ */
+void distance_batch_filter_scalar(const distance_batch_t *p_batch, uint32_t num_sensors, distance_batch_result_t *p_result);
+
+/**
+ * @brief Compute the minimum, the maximum and the median of the window of one sensor of a batch, without packed instructions. Only the lane of the sensor is read and written.
+ *
+ * @param p_batch Pointer to the batch
+ * @param sensor Sensor (lane) to filter. Nothing is done if it is not in the batch
+ * @param p_result Pointer to store the results
+ */
+void distance_batch_filter_lane(const distance_batch_t *p_batch, uint32_t sensor, distance_batch_result_t *p_result);
+
+#endif /* DISTANCE_BATCH_H_ */
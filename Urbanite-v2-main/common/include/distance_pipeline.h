@@ -0,0 +1,74 @@
+/**
+ * @file distance_pipeline.h
+ * @brief Pipeline of stages that process the distances of the ultrasound sensors, declared at build time.
+ *
+ * The ultrasound FSM computes the distance of every echo and pushes its record (see distance_stages.h) through the stages of the pipeline, in order. Each stage consumes the record and produces it updated, or drops it. The FSM only reports a new distance when the record gets through all the stages.
+ *
+ * The stages are a static list, `DISTANCE_PIPELINE_STAGES`, of the names of the stages:
+ *
+ * @code
+ * #define DISTANCE_PIPELINE_STAGES(STAGE) STAGE(median) STAGE(outlier)
+ * @endcode
+ *
+ * `DISTANCE_PIPELINE_DEFINE()` expands the list into a struct with the state of every stage and into `static inline` functions that call the stages one after the other, so there is no heap, no table of function pointers, and the compiler can inline the stages. The default list is the median of the last `FSM_ULTRASOUND_NUM_MEASUREMENTS` distances, without the outlier stage: it would hold back a sudden close obstacle for `DISTANCE_STAGE_OUTLIER_MAX_REJECTS` medians. The median stage still attaches a confidence from the spread of the window (see `fsm_ultrasound_get_confidence()`); the outlier stage, when added, lowers it further with the history of the distances. An installation defines its own list (and includes the headers of its own stages) in a header given with `-DDISTANCE_PIPELINE_CONFIG=<header>` to cmake.
+ *
+ * The state of the stages is kept for `DISTANCE_PIPELINE_LANES` sensors, one lane each, as the banks of ultrasound FSMs.
+ *
+ * @date 2025-01-01
+ */
+#ifndef DISTANCE_PIPELINE_H_
+#define DISTANCE_PIPELINE_H_
+
+/* Includes ------------------------------------------------------------------*/
+/* Standard C includes */
+#include <stdint.h>
+#include <stdbool.h>
+
+/* Project includes */
+#include "distance_stages.h"
+
+#ifdef DISTANCE_PIPELINE_CONFIG
+#include DISTANCE_PIPELINE_CONFIG
+#endif
+
+/* Defines and enums ----------------------------------------------------------*/
+#ifndef DISTANCE_PIPELINE_STAGES
+#define DISTANCE_PIPELINE_STAGES(STAGE) STAGE(median) /*!< Stages of the pipeline of the ultrasound FSM, in order */
+#endif
+
+/* Macros ----------------------------------------------------------------------*/
+#define DISTANCE_PIPELINE_STAGE_STATE(stage) distance_stage_##stage##_t stage;                        /*!< Field of the state of a stage in the pipeline */
+#define DISTANCE_PIPELINE_STAGE_RESET(stage) distance_stage_##stage##_reset(&p_pipeline->stage, lane); /*!< Reset of a stage in the pipeline */
+#define DISTANCE_PIPELINE_STAGE_PROCESS(stage)                                  \
+    if (!distance_stage_##stage##_process(&p_pipeline->stage, lane, p_record)) \
+    {                                                                           \
+        return false;                                                           \
+    } /*!< Call to a stage in the pipeline, that stops the pipeline if the stage drops the record */
+
+/**
+ * @brief Define a pipeline: the type `name_t` with the state of the stages, `name_reset()` and `name_push()`.
+ *
+ * `void name_reset(name_t *p_pipeline, uint32_t lane)` resets all the stages of a sensor. `bool name_push(name_t *p_pipeline, uint32_t lane, distance_record_t *p_record)` pushes the record of a measurement of a sensor through the stages and returns true if it got through all of them.
+ *
+ * @param name Prefix of the type and functions of the pipeline
+ * @param STAGES List of the stages, as `DISTANCE_PIPELINE_STAGES`. It must have at least one stage, and each stage at most once (its state is a field named after it)
+ */
+#define DISTANCE_PIPELINE_DEFINE(name, STAGES)                                                        \
+    typedef struct                                                                                    \
+    {                                                                                                 \
+        STAGES(DISTANCE_PIPELINE_STAGE_STATE)                                                         \
+    } name##_t;                                                                                       \
+    static inline void name##_reset(name##_t *p_pipeline, uint32_t lane)                              \
+    {                                                                                                 \
+        STAGES(DISTANCE_PIPELINE_STAGE_RESET)                                                         \
+    }                                                                                                 \
+    static inline bool name##_push(name##_t *p_pipeline, uint32_t lane, distance_record_t *p_record) \
+    {                                                                                                 \
+        STAGES(DISTANCE_PIPELINE_STAGE_PROCESS)                                                       \
+        return true;                                                                                  \
+    }
+
+/* Typedefs and functions --------------------------------------------------------*/
+DISTANCE_PIPELINE_DEFINE(distance_pipeline, DISTANCE_PIPELINE_STAGES) /*!< Pipeline of the ultrasound FSM: `distance_pipeline_t`, `distance_pipeline_reset()` and `distance_pipeline_push()` */
+
+#endif /* DISTANCE_PIPELINE_H_ */
@@ -0,0 +1,266 @@
+/**
+ * @file distance_stages.h
+ * @brief Measurement record and stages of the distance pipeline of the ultrasound sensors (see distance_pipeline.h).
+ *
+ * A stage `name` is three things with the same prefix, so `DISTANCE_PIPELINE_DEFINE()` can put it in a pipeline by its name only:
+ * - `distance_stage_name_t`: state of the stage for the `DISTANCE_PIPELINE_LANES` sensors of a pipeline, of fixed size. It is a field of the pipeline, so it needs no heap.
+ * - `void distance_stage_name_reset(distance_stage_name_t *p_state, uint32_t lane)`: forget the past measurements of a sensor.
+ * - `bool distance_stage_name_process(distance_stage_name_t *p_state, uint32_t lane, distance_record_t *p_record)`: consume the record of a measurement of the sensor and update it in place. If it returns false the record is dropped: the next stages do not see it and the pipeline produces nothing (e.g., the window of the median is not full yet).
+ *
+ * The functions are `static inline`, so the compiler can inline the whole pipeline in `distance_pipeline_push()`. The stages of an installation are defined the same way in their own header (see `DISTANCE_PIPELINE_CONFIG`).
+ *
+ * Stages here:
+ * - `median`: median of the last `FSM_ULTRASOUND_NUM_MEASUREMENTS` distances (the default pipeline). It lowers the confidence with the spread of the window.
+ * - `outlier`: drop the impossible jumps of the distance and attach its confidence from the history of the distances taken. It is not in the default pipeline. Its parameters (`DISTANCE_STAGE_OUTLIER_xxx`) can be defined in the header of the installation.
+ *
+ * A stage only lowers the confidence of a record, so the confidence out of the pipeline is the one of the stage that doubts the distance most.
+ *
+ * @date 2025-01-01
+ */
+#ifndef DISTANCE_STAGES_H_
+#define DISTANCE_STAGES_H_
+
+/* Includes ------------------------------------------------------------------*/
+/* Standard C includes */
+#include <stdint.h>
+#include <stdbool.h>
+
+/* Project includes */
+#include "distance_batch.h"
+
+/* Defines and enums ----------------------------------------------------------*/
+#define DISTANCE_PIPELINE_LANES DISTANCE_BATCH_MAX_SENSORS /*!< Sensors of a pipeline: one lane of the state of every stage each */
+#define DISTANCE_RECORD_CONFIDENCE_MAX 255U                 /*!< Confidence of a distance that no stage doubts */
+
+#ifndef DISTANCE_STAGE_MEDIAN_SPREAD_MARGIN_CM
+#define DISTANCE_STAGE_MEDIAN_SPREAD_MARGIN_CM 5U /*!< Spread of the window (maximum - minimum), in cm, that keeps the full confidence: resolution of the sensor and the movement during a window */
+#endif
+#ifndef DISTANCE_STAGE_MEDIAN_CONFIDENCE_CM
+#define DISTANCE_STAGE_MEDIAN_CONFIDENCE_CM 8U /*!< Spread of the window above the margin, in cm, that halves the confidence */
+#endif
+
+#ifndef DISTANCE_STAGE_OUTLIER_WINDOW
+#define DISTANCE_STAGE_OUTLIER_WINDOW 8U /*!< Last distances kept by the outlier stage for the median absolute deviation (MAD) */
+#endif
+#ifndef DISTANCE_STAGE_OUTLIER_MAX_SPEED_CM_S
+#define DISTANCE_STAGE_OUTLIER_MAX_SPEED_CM_S 300U /*!< Maximum closing speed between a sensor and an obstacle, in cm/s. A faster jump is impossible */
+#endif
+#ifndef DISTANCE_STAGE_OUTLIER_MARGIN_CM
+#define DISTANCE_STAGE_OUTLIER_MARGIN_CM 5U /*!< Jump always allowed, in cm: resolution of the sensor and the movement between two ticks */
+#endif
+#ifndef DISTANCE_STAGE_OUTLIER_MAD_FACTOR
+#define DISTANCE_STAGE_OUTLIER_MAD_FACTOR 4U /*!< Jump allowed for the noise of the sensor, in MADs (about 3 standard deviations of a Gaussian noise) */
+#endif
+#ifndef DISTANCE_STAGE_OUTLIER_MAX_REJECTS
+#define DISTANCE_STAGE_OUTLIER_MAX_REJECTS 3U /*!< Consecutive distances dropped before the stage takes the new one: the obstacle has really changed */
+#endif
+#ifndef DISTANCE_STAGE_OUTLIER_CONFIDENCE_CM
+#define DISTANCE_STAGE_OUTLIER_CONFIDENCE_CM 8U /*!< Spread of the distances, in cm, that halves the confidence */
+#endif
+#define DISTANCE_STAGE_OUTLIER_MAX_DT_MS 60000U /*!< Maximum time between two distances in the computation of the allowed jump, so it does not overflow */
+
+/* Typedefs --------------------------------------------------------------------*/
+/**
+ * @brief Record of a measurement, consumed and produced by every stage
+ */
+typedef struct
+{
+    uint16_t raw_distance_cm; /*!< Distance of the echo, in cm, before the stages. The stages do not change it */
+    uint16_t distance_cm;     /*!< Distance, in cm, as left by the previous stages */
+    uint32_t time_ms;         /*!< System time of the echo, in ms */
+    uint8_t confidence;       /*!< Confidence of the distance, from 0 to `DISTANCE_RECORD_CONFIDENCE_MAX`. It starts at the maximum and the stages lower it */
+} distance_record_t;
+
+/**
+ * @brief State of the median stage: the windows of the sensors, in the layout of a batch. Each sensor is filtered on its own with `distance_batch_filter_lane()`
+ */
+typedef struct
+{
+    distance_batch_t window;                          /*!< Last distances of every sensor, in cm */
+    uint8_t distance_idx_arr[DISTANCE_PIPELINE_LANES]; /*!< Next position in the window of every sensor */
+} distance_stage_median_t;
+
+/**
+ * @brief State of the outlier stage: the last distances taken of every sensor
+ */
+typedef struct
+{
+    uint16_t history_arr[DISTANCE_STAGE_OUTLIER_WINDOW][DISTANCE_PIPELINE_LANES]; /*!< `history_arr[k][s]`: last distances taken of the sensor s, in cm */
+    uint16_t last_cm_arr[DISTANCE_PIPELINE_LANES];                              /*!< Last distance taken of every sensor, in cm */
+    uint32_t last_time_ms_arr[DISTANCE_PIPELINE_LANES];                         /*!< System time of the last distance taken of every sensor, in ms */
+    uint8_t count_arr[DISTANCE_PIPELINE_LANES];                                 /*!< Distances in the history of every sensor */
+    uint8_t idx_arr[DISTANCE_PIPELINE_LANES];                                   /*!< Next position in the history of every sensor */
+    uint8_t rejects_arr[DISTANCE_PIPELINE_LANES];                               /*!< Consecutive distances dropped of every sensor */
+} distance_stage_outlier_t;
+
+/* Stages ----------------------------------------------------------------------*/
+/**
+ * @brief Reset the window of a sensor of the median stage
+ * @param p_state Pointer to the state of the stage
+ * @param lane Lane of the sensor
+ */
+static inline void distance_stage_median_reset(distance_stage_median_t *p_state, uint32_t lane)
+{
+    for (uint32_t k = 0; k < DISTANCE_BATCH_NUM_MEASUREMENTS; k++)
+    {
+        distance_batch_set(&p_state->window, lane, k, 0);
+    }
+    p_state->distance_idx_arr[lane] = 0;
+}
+
+/**
+ * @brief Median stage: store the distance in the window of the sensor and, when the window is full, replace it with the median of the window. The next median is computed with new measurements only.
+ *
+ * The confidence of the median falls with the spread of the window beyond `DISTANCE_STAGE_MEDIAN_SPREAD_MARGIN_CM`: `255 * C / (C + spread - margin)`, with `C = DISTANCE_STAGE_MEDIAN_CONFIDENCE_CM`. So a median of noisy echoes (e.g., rain) or of a window that straddles a change of obstacle is not trusted, without holding back the distance as the outlier stage does.
+ *
+ * @param p_state Pointer to the state of the stage
+ * @param lane Lane of the sensor
+ * @param p_record Pointer to the record of the measurement
+ * @return true if the window was full and the record has the median
+ * @return false otherwise: the record is dropped
+ */
+static inline bool distance_stage_median_process(distance_stage_median_t *p_state, uint32_t lane, distance_record_t *p_record)
+{
+    distance_batch_set(&p_state->window, lane, p_state->distance_idx_arr[lane], p_record->distance_cm);
+    if (++p_state->distance_idx_arr[lane] < DISTANCE_BATCH_NUM_MEASUREMENTS)
+    {
+        return false;
+    }
+    p_state->distance_idx_arr[lane] = 0;
+
+    distance_batch_result_t result;
+    distance_batch_filter_lane(&p_state->window, lane, &result); /* Only the window of this sensor: the others are filled at their own pace */
+    p_record->distance_cm = result.median_arr[lane];
+
+    uint32_t spread_cm = (uint32_t)result.max_arr[lane] - result.min_arr[lane];
+    uint32_t excess_cm = (spread_cm > DISTANCE_STAGE_MEDIAN_SPREAD_MARGIN_CM) ? (spread_cm - DISTANCE_STAGE_MEDIAN_SPREAD_MARGIN_CM) : 0U;
+    uint32_t confidence = (DISTANCE_RECORD_CONFIDENCE_MAX * DISTANCE_STAGE_MEDIAN_CONFIDENCE_CM) / (DISTANCE_STAGE_MEDIAN_CONFIDENCE_CM + excess_cm);
+    if (confidence < p_record->confidence)
+    {
+        p_record->confidence = (uint8_t)confidence;
+    }
+    return true;
+}
+
+/**
+ * @brief Median of some values. The values are sorted in place
+ * @param p_values Values
+ * @param n Number of values (at least 1)
+ * @return Central value, or the floor of the mean of the two central values if `n` is even
+ */
+static inline uint32_t _distance_stage_median_of(uint16_t *p_values, uint32_t n)
+{
+    for (uint32_t i = 1; i < n; i++)
+    {
+        uint16_t value = p_values[i];
+        uint32_t j = i;
+        for (; (j > 0) && (p_values[j - 1U] > value); j--)
+        {
+            p_values[j] = p_values[j - 1U];
+        }
+        p_values[j] = value;
+    }
+    if (n % 2U == 1U)
+    {
+        return p_values[n / 2U];
+    }
+    return ((uint32_t)p_values[n / 2U - 1U] + p_values[n / 2U]) / 2U;
+}
+
+/**
+ * @brief Median and median absolute deviation (MAD) of the history of a sensor of the outlier stage
+ * @param p_state Pointer to the state of the stage
+ * @param lane Lane of the sensor
+ * @param p_median Pointer to store the median, in cm
+ * @param p_mad Pointer to store the MAD, in cm
+ */
+static inline void _distance_stage_outlier_mad(const distance_stage_outlier_t *p_state, uint32_t lane, uint32_t *p_median, uint32_t *p_mad)
+{
+    uint32_t n = p_state->count_arr[lane];
+    uint16_t values_arr[DISTANCE_STAGE_OUTLIER_WINDOW];
+    for (uint32_t k = 0; k < n; k++)
+    {
+        values_arr[k] = p_state->history_arr[k][lane];
+    }
+    uint32_t median = _distance_stage_median_of(values_arr, n);
+    for (uint32_t k = 0; k < n; k++)
+    {
+        values_arr[k] = (uint16_t)((values_arr[k] > median) ? (values_arr[k] - median) : (median - values_arr[k]));
+    }
+    *p_median = median;
+    *p_mad = _distance_stage_median_of(values_arr, n);
+}
+
+/**
+ * @brief Reset the history of a sensor of the outlier stage
+ * @param p_state Pointer to the state of the stage
+ * @param lane Lane of the sensor
+ */
+static inline void distance_stage_outlier_reset(distance_stage_outlier_t *p_state, uint32_t lane)
+{
+    p_state->count_arr[lane] = 0;
+    p_state->idx_arr[lane] = 0;
+    p_state->rejects_arr[lane] = 0;
+}
+
+/**
+ * @brief Outlier stage: drop the impossible jumps and attach the confidence of the distance, in integer arithmetic only.
+ *
+ * A distance is impossible if it is farther from the last distance taken than the obstacle can move at `DISTANCE_STAGE_OUTLIER_MAX_SPEED_CM_S` since then, plus the noise of the sensor (`DISTANCE_STAGE_OUTLIER_MAD_FACTOR` times the MAD of the history) and `DISTANCE_STAGE_OUTLIER_MARGIN_CM`. After `DISTANCE_STAGE_OUTLIER_MAX_REJECTS` impossible distances in a row the obstacle has really changed (e.g., a new one in front of the sensor), so the distance is taken and the history starts again from it.
+ *
+ * The confidence falls with the spread of the history (its MAD) and with the deviation of the distance from the median of the history: `255 * C / (C + MAD + |distance - median|)`, with `C = DISTANCE_STAGE_OUTLIER_CONFIDENCE_CM`. It is scaled down while the history is not full, so the first distances after a start or a change of obstacle are not trusted yet.
+ *
+ * @param p_state Pointer to the state of the stage
+ * @param lane Lane of the sensor
+ * @param p_record Pointer to the record of the measurement
+ * @return true if the distance is taken, with its confidence in the record
+ * @return false if it is impossible: the record is dropped
+ */
+static inline bool distance_stage_outlier_process(distance_stage_outlier_t *p_state, uint32_t lane, distance_record_t *p_record)
+{
+    uint32_t distance_cm = p_record->distance_cm;
+    uint32_t median;
+    uint32_t mad;
+    if (p_state->count_arr[lane] > 0)
+    {
+        _distance_stage_outlier_mad(p_state, lane, &median, &mad);
+        uint32_t dt_ms = p_record->time_ms - p_state->last_time_ms_arr[lane];
+        if (dt_ms > DISTANCE_STAGE_OUTLIER_MAX_DT_MS)
+        {
+            dt_ms = DISTANCE_STAGE_OUTLIER_MAX_DT_MS;
+        }
+        uint32_t max_jump_cm = DISTANCE_STAGE_OUTLIER_MAD_FACTOR * mad + (DISTANCE_STAGE_OUTLIER_MAX_SPEED_CM_S * dt_ms) / 1000U + DISTANCE_STAGE_OUTLIER_MARGIN_CM;
+        uint32_t last_cm = p_state->last_cm_arr[lane];
+        uint32_t jump_cm = (distance_cm > last_cm) ? (distance_cm - last_cm) : (last_cm - distance_cm);
+        if (jump_cm > max_jump_cm)
+        {
+            if (++p_state->rejects_arr[lane] < DISTANCE_STAGE_OUTLIER_MAX_REJECTS)
+            {
+                return false;
+            }
+            distance_stage_outlier_reset(p_state, lane); /* A new obstacle: the history is of the previous one */
+        }
+    }
+    p_state->rejects_arr[lane] = 0;
+
+    p_state->history_arr[p_state->idx_arr[lane]][lane] = (uint16_t)distance_cm;
+    p_state->idx_arr[lane] = (uint8_t)((p_state->idx_arr[lane] + 1U) % DISTANCE_STAGE_OUTLIER_WINDOW);
+    if (p_state->count_arr[lane] < DISTANCE_STAGE_OUTLIER_WINDOW)
+    {
+        p_state->count_arr[lane]++;
+    }
+    p_state->last_cm_arr[lane] = (uint16_t)distance_cm;
+    p_state->last_time_ms_arr[lane] = p_record->time_ms;
+
+    _distance_stage_outlier_mad(p_state, lane, &median, &mad);
+    uint32_t deviation_cm = (distance_cm > median) ? (distance_cm - median) : (median - distance_cm);
+    uint32_t confidence = (DISTANCE_RECORD_CONFIDENCE_MAX * DISTANCE_STAGE_OUTLIER_CONFIDENCE_CM) / (DISTANCE_STAGE_OUTLIER_CONFIDENCE_CM + mad + deviation_cm);
+    confidence = (confidence * p_state->count_arr[lane]) / DISTANCE_STAGE_OUTLIER_WINDOW;
+    if (confidence < p_record->confidence)
+    {
+        p_record->confidence = (uint8_t)confidence;
+    }
+    return true;
+}
+
+#endif /* DISTANCE_STAGES_H_ */
@@ -10,7 +10,6 @@
 /* Standard C includes */
 #include <stdint.h>
 #include <stdbool.h>
-#include "stm32f4xx.h"
 
 /* Other includes */
 #include "fsm.h"
@@ -0,0 +1,142 @@
+/**
+ * @file fsm_gesture.h
+ * @brief Header for fsm_gesture.c file, defines the FSM that recognizes gestures of a debounced key.
+ *
+ * Each gesture FSM watches one key of the debounce engine and classifies its presses into clicks, double clicks, long presses (fired while the key is still held) and auto-repeat events. The FSMs are driven by the timestamped press and release events of the debounce engine, not by polling the state of the keys: a press and release that both happen between two fires are still recognized, and every gesture carries the time of the edge or deadline that completed it, with the resolution of one debounce period. The events of all the keys are pushed to a single queue, so the application reads them with `fsm_gesture_get_event()` instead of polling press durations.
+ *
+ * @date 2025-01-01
+ */
+#ifndef FSM_GESTURE_H_
+#define FSM_GESTURE_H_
+
+/* Includes ------------------------------------------------------------------*/
+/* Standard C includes */
+#include <stdint.h>
+#include <stdbool.h>
+
+/* Other includes */
+#include "fsm.h"
+
+/* Defines and enums ----------------------------------------------------------*/
+/* Defines */
+#define FSM_GESTURE_QUEUE_SIZE 16U              /*!< Number of gesture events that can be queued. It must be a power of 2 */
+#define FSM_GESTURE_DEFAULT_LONG_PRESS_MS 800U  /*!< Default time a key must be held to fire a long press */
+#define FSM_GESTURE_DEFAULT_DOUBLE_CLICK_MS 300U /*!< Default maximum time between a release and the next press of a double click */
+#define FSM_GESTURE_DEFAULT_REPEAT_DELAY_MS 400U /*!< Default time between the long press and the first repeat */
+#define FSM_GESTURE_DEFAULT_REPEAT_PERIOD_MS 150U /*!< Default time between repeats */
+
+/* Enums */
+/**
+ * @brief States of the gesture FSM
+ */
+enum FSM_GESTURE
+{
+    GESTURE_IDLE = 0,        /*!< Key released, no gesture in progress */
+    GESTURE_PRESSED,         /*!< First press of a gesture */
+    GESTURE_WAIT_SECOND,     /*!< Key released after a short press, waiting for a second press */
+    GESTURE_SECOND_PRESSED,  /*!< Second press of a double click */
+    GESTURE_HELD             /*!< Long press fired, the key is still held */
+};
+
+/**
+ * @brief Types of gesture events
+ */
+typedef enum
+{
+    GESTURE_EVENT_CLICK = 0,    /*!< Short press not followed by a second press */
+    GESTURE_EVENT_DOUBLE_CLICK, /*!< Two short presses. Fired on the second press */
+    GESTURE_EVENT_LONG_PRESS,   /*!< Key held longer than the long press time. Fired while held */
+    GESTURE_EVENT_REPEAT        /*!< Auto-repeat while the key is held after a long press */
+} fsm_gesture_event_type_t;
+
+/* Typedefs --------------------------------------------------------------------*/
+/**
+ * @brief Thresholds of the gestures of a key. A time of 0 disables the gesture
+ */
+typedef struct
+{
+    uint32_t long_press_ms;    /*!< Time the key must be held to fire a long press. 0 disables long presses and repeats */
+    uint32_t double_click_ms;  /*!< Maximum time between a release and the next press of a double click. 0 disables double clicks */
+    uint32_t repeat_delay_ms;  /*!< Time between the long press and the first repeat */
+    uint32_t repeat_period_ms; /*!< Time between repeats. 0 disables repeats */
+} fsm_gesture_config_t;
+
+/**
+ * @brief Gesture event
+ */
+typedef struct
+{
+    uint32_t timestamp_ms;         /*!< System time when the gesture happened: the debounced edge, or the deadline of long presses, repeats and single clicks */
+    uint32_t key_id;               /*!< Key ID */
+    fsm_gesture_event_type_t type; /*!< Type of gesture */
+} fsm_gesture_event_t;
+
+typedef struct fsm_gesture_t fsm_gesture_t;
+
+/* Function prototypes and explanation -------------------------------------------------*/
+/**
+ * @brief Create a new gesture FSM. The first FSM created starts the debounce engine.
+ *
+ * @param p_config Pointer to the thresholds of the gestures. NULL selects the default thresholds
+ * @param key_id Key ID of the debounce engine
+ * @return fsm_gesture_t* pointer to the gesture FSM
+ */
+fsm_gesture_t *fsm_gesture_new(const fsm_gesture_config_t *p_config, uint32_t key_id);
+
+/**
+ * @brief Destroy a gesture FSM
+ *
+ * @param p_fsm Pointer to an fsm_gesture_t struct
+ */
+void fsm_gesture_destroy(fsm_gesture_t *p_fsm);
+
+/**
+ * @brief Fire the gesture FSM.
+ *
+ * Drains the queue of the debounce engine and processes every edge, in order, with the FSM of its key. Then checks the deadlines of this FSM. The rate of the fires only delays the delivery of the events: their order and timestamps do not depend on it.
+ *
+ * @param p_fsm Pointer to an fsm_gesture_t struct
+ */
+void fsm_gesture_fire(fsm_gesture_t *p_fsm);
+
+/**
+ * @brief Get the inner FSM of the gesture FSM
+ *
+ * @param p_fsm Pointer to an fsm_gesture_t struct
+ * @return fsm_t* pointer to the inner FSM
+ */
+fsm_t *fsm_gesture_get_inner_fsm(fsm_gesture_t *p_fsm);
+
+/**
+ * @brief Get the state of the gesture FSM
+ *
+ * @param p_fsm Pointer to an fsm_gesture_t struct
+ * @return uint32_t Current state of the gesture FSM
+ */
+uint32_t fsm_gesture_get_state(fsm_gesture_t *p_fsm);
+
+/**
+ * @brief Check if the gesture FSM is active or not
+ *
+ * @param p_fsm Pointer to an fsm_gesture_t struct
+ * @return true if a gesture is in progress
+ * @return false if the key is released and there is no gesture in progress
+ */
+bool fsm_gesture_check_activity(fsm_gesture_t *p_fsm);
+
+/**
+ * @brief Get the oldest gesture event of any key and remove it from the queue
+ *
+ * @param p_event Pointer to store the event
+ * @return true if there was an event, false if the queue was empty
+ */
+bool fsm_gesture_get_event(fsm_gesture_event_t *p_event);
+
+/**
+ * @brief Get the number of gesture events lost because the queue was full
+ *
+ * @return Number of events lost
+ */
+uint32_t fsm_gesture_get_dropped_events(void);
+
+#endif /* FSM_GESTURE_H_ */
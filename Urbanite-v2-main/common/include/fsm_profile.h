@@ -0,0 +1,154 @@
+/**
+ * @file fsm_profile.h
+ * @brief Header for fsm_profile.c file, an opt-in profiler of the guards and actions of the FSMs.
+ *
+ * When the project is configured with `-DFSM_PROFILE=ON`, `FSM_PROFILE_FIRE()` replaces `fsm_fire()` with an equivalent loop over the transition table that measures every guard and every action with `port_system_get_cycles()` (the DWT cycle counter in the STM32F4, `clock_gettime()` nanoseconds in the native port). The statistics are kept per row of the transition table in a static `fsm_profile_t` of each FSM type, together with the transitions taken from each state and the time of the whole fire. `FSM_PROFILE_BLOCK()` measures any other statement, e.g., the distance pipeline inside an action. `fsm_profile_dump()` sends all of it through the deferred logger.
+ *
+ * Without `FSM_PROFILE` the macros expand to the plain code (`fsm_fire()` and the statement), so the instrumentation costs nothing.
+ *
+ * The FSMs must be fired from the thread code (e.g., the tasks of the scheduler): the statistics are not protected against the ISRs.
+ *
+ * @date 2025-01-01
+ */
+#ifndef FSM_PROFILE_H_
+#define FSM_PROFILE_H_
+
+/* Includes ------------------------------------------------------------------*/
+/* Standard C includes */
+#include <stdint.h>
+#include <stdbool.h>
+
+/* Other includes */
+#include "fsm.h"
+
+/* Defines and enums ----------------------------------------------------------*/
+#define FSM_PROFILE_MAX_ROWS 16U   /*!< Rows of a transition table that are profiled. The next ones run without being measured */
+#define FSM_PROFILE_MAX_STATES 16U /*!< States whose transitions are counted */
+
+/**
+ * @brief Identifiers of the profiled FSM types and blocks. They appear in the dump instead of the names, which are not sent by the logger
+ */
+enum FSM_PROFILE_ID
+{
+    FSM_PROFILE_ID_BUTTON = 0,          /*!< Button FSM */
+    FSM_PROFILE_ID_ULTRASOUND,          /*!< Ultrasound FSM */
+    FSM_PROFILE_ID_GESTURE,             /*!< Gesture FSM */
+    FSM_PROFILE_ID_ULTRASOUND_PIPELINE, /*!< Distance pipeline of the ultrasound FSM (median filter and the other stages) */
+};
+
+/* Typedefs --------------------------------------------------------------------*/
+/**
+ * @brief Execution time of a guard, an action or a block, in counts of `port_system_get_cycles()`
+ */
+typedef struct
+{
+    uint32_t calls;        /*!< Number of calls */
+    uint32_t taken;        /*!< Calls of a guard that returned true */
+    uint32_t min_cycles;   /*!< Minimum execution time */
+    uint32_t max_cycles;   /*!< Maximum execution time */
+    uint64_t total_cycles; /*!< Accumulated execution time */
+} fsm_profile_stats_t;
+
+/**
+ * @brief Profile of an FSM type. It is filled the first time an FSM of the type is fired
+ */
+typedef struct fsm_profile
+{
+    uint32_t id;                                             /*!< Identifier (`FSM_PROFILE_ID_xxx`) */
+    bool registered;                                         /*!< The profile is in the list of `fsm_profile_dump()` */
+    uint32_t num_rows;                                       /*!< Rows of the transition table, without the last one */
+    fsm_profile_stats_t fire;                                /*!< Time of the whole `fsm_fire()` */
+    fsm_profile_stats_t guards_arr[FSM_PROFILE_MAX_ROWS];    /*!< Time of the guard of each row */
+    fsm_profile_stats_t actions_arr[FSM_PROFILE_MAX_ROWS];   /*!< Time of the action of each row */
+    uint32_t transitions_arr[FSM_PROFILE_MAX_STATES];        /*!< Transitions taken from each state */
+    struct fsm_profile *p_next;                              /*!< Next profile of the list */
+} fsm_profile_t;
+
+/**
+ * @brief Profile of a block of code
+ */
+typedef struct fsm_profile_block
+{
+    uint32_t id;                      /*!< Identifier (`FSM_PROFILE_ID_xxx`) */
+    bool registered;                  /*!< The block is in the list of `fsm_profile_dump()` */
+    fsm_profile_stats_t stats;        /*!< Time of the block */
+    struct fsm_profile_block *p_next; /*!< Next block of the list */
+} fsm_profile_block_t;
+
+/* Macros ----------------------------------------------------------------------*/
+#ifdef FSM_PROFILE
+#define FSM_PROFILE_DEFINE(name, profile_id) static fsm_profile_t name = {.id = (profile_id)}            /*!< Define the profile of an FSM type */
+#define FSM_PROFILE_DEFINE_BLOCK(name, profile_id) static fsm_profile_block_t name = {.id = (profile_id)} /*!< Define the profile of a block */
+#define FSM_PROFILE_FIRE(p_profile, p_fsm) fsm_profile_fire((p_profile), (p_fsm))                         /*!< Fire an FSM measuring its guards and actions */
+#define FSM_PROFILE_BLOCK(p_block, statement)                       \
+    do                                                              \
+    {                                                               \
+        uint32_t fsm_profile_start_ = fsm_profile_block_begin();    \
+        statement;                                                  \
+        fsm_profile_block_end((p_block), fsm_profile_start_);       \
+    } while (0) /*!< Run a statement measuring its time */
+#else
+#define FSM_PROFILE_DEFINE(name, profile_id) typedef int fsm_profile_disabled_##name##_t
+#define FSM_PROFILE_DEFINE_BLOCK(name, profile_id) typedef int fsm_profile_disabled_##name##_t
+#define FSM_PROFILE_FIRE(p_profile, p_fsm) fsm_fire(p_fsm)
+#define FSM_PROFILE_BLOCK(p_block, statement) \
+    do                                        \
+    {                                         \
+        statement;                            \
+    } while (0)
+#endif
+
+/* Function prototypes and explanation -------------------------------------------------*/
+/**
+ * @brief Fire an FSM as `fsm_fire()` does, measuring its guards and actions. Use `FSM_PROFILE_FIRE()` instead.
+ *
+ * @param p_profile Profile of the FSM type
+ * @param p_fsm Pointer to the FSM
+ * @return 1 if a transition has been taken, 0 otherwise
+ */
+int fsm_profile_fire(fsm_profile_t *p_profile, fsm_t *p_fsm);
+
+/**
+ * @brief Start the measurement of a block. Use `FSM_PROFILE_BLOCK()` instead.
+ *
+ * @return Start time
+ */
+uint32_t fsm_profile_block_begin(void);
+
+/**
+ * @brief Finish the measurement of a block. Use `FSM_PROFILE_BLOCK()` instead.
+ *
+ * @param p_block Profile of the block
+ * @param start Start time returned by `fsm_profile_block_begin()`
+ */
+void fsm_profile_block_end(fsm_profile_block_t *p_block, uint32_t start);
+
+/**
+ * @brief Send the statistics of all the profiles and blocks through the deferred logger and flush it.
+ *
+ * For each FSM type: the fire, the guard and the action of every row that has been called, and the transitions taken from every state. Each measurement is followed by a line with its minimum, maximum, average and total cycles. Nothing is sent if `FSM_PROFILE` is not defined, because no FSM has been profiled.
+ */
+void fsm_profile_dump(void);
+
+/**
+ * @brief Clear the statistics of all the profiles and blocks.
+ */
+void fsm_profile_reset(void);
+
+/**
+ * @brief Get the profile of an FSM type, e.g., for the unit tests or the debugger.
+ *
+ * @param id Identifier (`FSM_PROFILE_ID_xxx`)
+ * @return Pointer to the profile. NULL if no FSM of the type has been fired
+ */
+const fsm_profile_t *fsm_profile_get(uint32_t id);
+
+/**
+ * @brief Get the profile of a block.
+ *
+ * @param id Identifier (`FSM_PROFILE_ID_xxx`)
+ * @return Pointer to the profile. NULL if the block has not run
+ */
+const fsm_profile_block_t *fsm_profile_get_block(uint32_t id);
+
+#endif /* FSM_PROFILE_H_ */
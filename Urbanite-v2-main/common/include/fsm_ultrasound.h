@@ -14,11 +14,14 @@
  #include <stdint.h>
 #include <stdbool.h>
 /*Others includes*/
-#include "stm32f4xx.h"
 #include "fsm.h"
  /* Defines and enums ----------------------------------------------------------*/
  
  #define FSM_ULTRASOUND_NUM_MEASUREMENTS 5 //Number of measures
+#define FSM_ULTRASOUND_DEFAULT_CRITICAL_CM 25U  /*!< Default distance below which an obstacle is in the critical zone, in cm */
+#define FSM_ULTRASOUND_DEFAULT_NEAR_CM 50U      /*!< Default distance below which an obstacle is in the near zone, in cm */
+#define FSM_ULTRASOUND_DEFAULT_MEDIUM_CM 150U   /*!< Default distance below which an obstacle is in the medium zone, in cm */
+#define FSM_ULTRASOUND_DEFAULT_HYSTERESIS_CM 5U /*!< Default hysteresis band of the zones, in cm */
 
 enum FSM_ULTRASOUND{
     WAIT_START=0, /*!<Starting state*/
@@ -29,8 +32,44 @@ enum FSM_ULTRASOUND{
 
 };
 
+/**
+ * @brief Proximity zones of an obstacle, from the farthest to the closest
+ */
+typedef enum
+{
+    ULTRASOUND_ZONE_NONE = 0, /*!< No distance since the sensor was started */
+    ULTRASOUND_ZONE_FAR,      /*!< At `medium_cm` or farther */
+    ULTRASOUND_ZONE_MEDIUM,   /*!< Below `medium_cm` */
+    ULTRASOUND_ZONE_NEAR,     /*!< Below `near_cm` */
+    ULTRASOUND_ZONE_CRITICAL  /*!< Below `critical_cm` */
+} fsm_ultrasound_zone_t;
+
  /* Typedefs --------------------------------------------------------------------*/
  typedef struct fsm_ultrasound_t fsm_ultrasound_t;
+
+/**
+ * @brief Bank of ultrasound FSMs (see fsm_ultrasound_new()). `fsm_ultrasound_new()` uses a static bank; a user that runs FSMs from several threads creates a bank per thread (or per unit) with `fsm_ultrasound_bank_new()`, so the FSMs of different threads never share a bank
+ */
+typedef struct fsm_ultrasound_bank fsm_ultrasound_bank_t;
+
+/**
+ * @brief Thresholds of the proximity zones of a sensor, in cm. An obstacle enters a closer zone as soon as its distance is below the threshold, and goes back to the farther zone only when its distance is at least `hysteresis_cm` above it, so a distance that wobbles around a threshold does not change the zone
+ */
+typedef struct
+{
+    uint16_t critical_cm;   /*!< Distance below which the obstacle is in the critical zone */
+    uint16_t near_cm;       /*!< Distance below which the obstacle is in the near zone. Greater than `critical_cm` */
+    uint16_t medium_cm;     /*!< Distance below which the obstacle is in the medium zone. Greater than `near_cm` */
+    uint16_t hysteresis_cm; /*!< Hysteresis band above every threshold */
+} fsm_ultrasound_zone_config_t;
+
+/**
+ * @brief Function called by an ultrasound FSM when the proximity zone of its sensor changes (see fsm_ultrasound_set_zone_callback())
+ * @param p_fsm Pointer to the ultrasound FSM whose zone changed
+ * @param zone New zone
+ * @param p_arg Argument given to fsm_ultrasound_set_zone_callback()
+ */
+typedef void (*fsm_ultrasound_zone_callback_t)(fsm_ultrasound_t *p_fsm, fsm_ultrasound_zone_t zone, void *p_arg);
  /* Function prototypes and explanation -------------------------------------------------*/
  
  
@@ -55,7 +94,7 @@ enum FSM_ULTRASOUND{
  /**
   * @brief Destroy an ultrasound FSM
   *
-  * This function destroys an ultrasound transceiver FSM and frees the memory
+  * This function destroys an ultrasound transceiver FSM and frees its slot in the bank of sensors. A bank allocated from the heap is freed when all its slots are free
   *
   * 
   * 
@@ -82,7 +121,7 @@ enum FSM_ULTRASOUND{
   * @brief Return the distance of the last object detected by the ultrasound sensor.a64l
   *
   * This function also resets the field new_measurement to indicate that 
-  * the distance has been read
+  * the distance has been read. It is the last distance out of the distance pipeline (by default, the median of the last measurements; see distance_pipeline.h)
   *
   * 
   * 
@@ -91,6 +130,68 @@ enum FSM_ULTRASOUND{
   */
  uint32_t fsm_ultrasound_get_distance (fsm_ultrasound_t * fsm);
 
+/**
+  * @brief Return the confidence of the distance returned by `fsm_ultrasound_get_distance()`.
+  *
+  * It is attached by the stages of the distance pipeline (see distance_stages.h), so the application can skip the distances it does not trust. The median stage of the default pipeline lowers it when the window of the median is spread (noisy echoes or a change of obstacle); the optional outlier stage also lowers it when the distance is away from the recent ones. It is 0 before the first distance.
+  *
+  * @param p_fsm Pointer to an `fsm_ultrasound_t` struct.
+  * @returns Confidence from 0 (none) to 255 (full)
+  */
+ uint8_t fsm_ultrasound_get_confidence (fsm_ultrasound_t * p_fsm);
+
+/**
+  * @brief Return the proximity zone of the obstacle, and reset the zone changed flag
+  *
+  * The zone is updated with every distance out of the distance pipeline, with the thresholds of `fsm_ultrasound_set_zone_config()`.
+  *
+  * @param p_fsm Pointer to an `fsm_ultrasound_t` struct.
+  * @returns Current zone, `ULTRASOUND_ZONE_NONE` before the first distance since the start
+  */
+ fsm_ultrasound_zone_t fsm_ultrasound_get_zone (fsm_ultrasound_t * p_fsm);
+
+/**
+  * @brief Return the flag that indicates if the zone has changed since it was last read with `fsm_ultrasound_get_zone()`
+  *
+  * It is only raised when a distance moves the obstacle to another zone, so the consumers that only care about the zone (e.g., the display and the buzzer) can skip the distances that do not change it.
+  *
+  * @param p_fsm Pointer to an `fsm_ultrasound_t` struct.
+  * @returns true if the zone has changed
+  * @returns false otherwise
+  */
+ bool fsm_ultrasound_get_zone_changed (fsm_ultrasound_t * p_fsm);
+
+/**
+  * @brief Set the function called when the proximity zone of the sensor changes
+  *
+  * The callback is called once per change of zone, from `fsm_ultrasound_fire()` in the thread that fires the FSM, right after the zone is updated, so a consumer does not have to poll `fsm_ultrasound_get_zone_changed()` after every fire. It must be short: e.g., post a scheduler event (`scheduler_post_event()`) for the task of the display and the buzzer, or count the change. The zone changed flag is still raised, for the consumers that poll it. A new FSM has no callback.
+  *
+  * @param p_fsm Pointer to an `fsm_ultrasound_t` struct.
+  * @param callback Function to call, or NULL to call none
+  * @param p_arg Argument of the callback. It is only shared with other FSMs, or other threads, if the caller does so
+  */
+ void fsm_ultrasound_set_zone_callback (fsm_ultrasound_t * p_fsm, fsm_ultrasound_zone_callback_t callback, void * p_arg);
+
+/**
+  * @brief Set the thresholds of the proximity zones of the sensor
+  *
+  * The FSMs start with the `FSM_ULTRASOUND_DEFAULT_xxx` thresholds. The current zone is kept and the new thresholds apply from the next distance.
+  *
+  * @param p_fsm Pointer to an `fsm_ultrasound_t` struct.
+  * @param p_config Pointer to the thresholds. NULL selects the default thresholds
+  * @returns true if the thresholds are set
+  * @returns false if they are not increasing (critical, near, medium): the previous ones are kept
+  */
+ bool fsm_ultrasound_set_zone_config (fsm_ultrasound_t * p_fsm, const fsm_ultrasound_zone_config_t * p_config);
+
+/**
+  * @brief Return the last distance measured by the ultrasound sensor, before the distance pipeline
+  *
+  * @param p_fsm Pointer to an `fsm_ultrasound_t` struct.
+  * @returns Last raw distance in cm
+  */
+ uint32_t fsm_ultrasound_get_raw_distance (fsm_ultrasound_t * p_fsm);
+
 /**
   * @brief Get the inner FSM of the ultrasound
   *
@@ -145,11 +246,37 @@ bool fsm_ultrasound_get_status(fsm_ultrasound_t *p_fsm);
   * @brief Create a new ultrasound FSM
   * 
   * This function creates a new ultraosund transceiver FSM with the given ultrasound ID
-  * @param ultrasound_id Ultrasound ID must be unique
-  * @returns Pointer to the ultrasound FSM
+  *
+  * The FSMs are kept in banks of `DISTANCE_BATCH_MAX_SENSORS` sensors, with the state used in every measurement (stages of the pipeline, distances and flags) in packed arrays indexed by sensor and the distances in 16 bits (see distance_batch.h). The first bank is static; the next ones are allocated from the heap when all the slots are used. The FSMs must be created and destroyed from one thread, and the FSMs of a bank fired from one thread at a time (see fsm_ultrasound_new_in_bank() for FSMs in several threads).
+  * @param ultrasound_id Ultrasound ID must be unique (0 to 255)
+  * @returns Pointer to the ultrasound FSM, or NULL if there is no memory for a new bank
   */
 fsm_ultrasound_t* fsm_ultrasound_new(uint32_t ultrasound_id);
 
+/**
+  * @brief Create a new ultrasound FSM in a bank of the caller
+  *
+  * As fsm_ultrasound_new(), but the FSM takes a slot of the given bank, or of the next banks of its own chain. The FSMs of a bank must be created, destroyed and fired from one thread at a time.
+  * @param p_bank Pointer to the bank, from fsm_ultrasound_bank_new()
+  * @param ultrasound_id Ultrasound ID must be unique (0 to 255)
+  * @returns Pointer to the ultrasound FSM, or NULL if there is no memory for a new bank
+  */
+fsm_ultrasound_t* fsm_ultrasound_new_in_bank(fsm_ultrasound_bank_t *p_bank, uint32_t ultrasound_id);
+
+/**
+  * @brief Create an empty bank of ultrasound FSMs, allocated from the heap
+  *
+  * @returns Pointer to the bank, or NULL if there is no memory
+  */
+fsm_ultrasound_bank_t* fsm_ultrasound_bank_new(void);
+
+/**
+  * @brief Free a bank of fsm_ultrasound_bank_new() and the banks allocated after it. Its FSMs must have been destroyed
+  *
+  * @param p_bank Pointer to the bank
+  */
+void fsm_ultrasound_bank_destroy(fsm_ultrasound_bank_t *p_bank);
+
 
  /**
   * @brief Set the state of the ultrasound FSM
@@ -0,0 +1,116 @@
+/**
+ * @file scheduler.h
+ * @brief Header for scheduler.c file, a deadline-aware cooperative scheduler for the FSMs.
+ *
+ * Tasks are run-to-completion functions (typically a call to `fsm_xxx_fire()`) registered in a static table. A task is released periodically, by any of the events of its event mask, or both. Every released task has an absolute deadline, and the ready tasks run in Earliest Deadline First order. The scheduler records per-task deadline misses, release-to-start latency and jitter, and execution time, and computes the next wakeup time so the idle loop can sleep until then.
+ *
+ * @date 2025-01-01
+ */
+#ifndef SCHEDULER_H_
+#define SCHEDULER_H_
+
+/* Includes ------------------------------------------------------------------*/
+/* Standard C includes */
+#include <stdint.h>
+#include <stdbool.h>
+
+/* Defines and enums ----------------------------------------------------------*/
+#define SCHEDULER_MAX_TASKS 8U    /*!< Maximum number of tasks */
+#define SCHEDULER_INVALID_TASK -1 /*!< Returned when a task cannot be added */
+
+/* Typedefs --------------------------------------------------------------------*/
+/**
+ * @brief Function of a task. It must run to completion without blocking
+ */
+typedef void (*scheduler_task_func_t)(void *p_arg);
+
+/**
+ * @brief Configuration of a task
+ */
+typedef struct
+{
+    const char *p_name;         /*!< Name of the task, for the statistics */
+    scheduler_task_func_t func; /*!< Function of the task */
+    void *p_arg;                /*!< Argument of the function (e.g., the FSM to fire) */
+    uint32_t period_ms;         /*!< Release period. 0 for tasks released only by events */
+    uint32_t event_mask;        /*!< Events that release the task. 0 for purely periodic tasks */
+    uint32_t deadline_ms;       /*!< Relative deadline from the release. 0 selects the period. Mandatory for the tasks released only by events */
+} scheduler_task_config_t;
+
+/**
+ * @brief Run-time statistics of a task. The release jitter is `max_latency_ms - min_latency_ms`
+ */
+typedef struct
+{
+    uint32_t runs;            /*!< Number of times the task has run */
+    uint32_t deadline_misses; /*!< Releases that finished after their deadline or were skipped because of an overrun */
+    uint32_t min_latency_ms;  /*!< Minimum time from the release to the start of the task */
+    uint32_t max_latency_ms;  /*!< Maximum time from the release to the start of the task */
+    uint32_t max_exec_cycles; /*!< Maximum execution time in counts of `port_system_get_cycles()` */
+    uint64_t total_exec_cycles; /*!< Accumulated execution time in counts of `port_system_get_cycles()` */
+} scheduler_task_stats_t;
+
+/* Function prototypes and explanation -------------------------------------------------*/
+/**
+ * @brief Remove all the tasks and events
+ */
+void scheduler_init(void);
+
+/**
+ * @brief Add a task to the table. A periodic task is first released one period after it is added.
+ *
+ * @param p_config Pointer to the configuration of the task
+ * @return ID of the task, or `SCHEDULER_INVALID_TASK` if the table is full or the configuration is not valid
+ */
+int32_t scheduler_add_task(const scheduler_task_config_t *p_config);
+
+/**
+ * @brief Release the tasks waiting for any of the given events. It can be called from the ISRs masked by the critical sections.
+ *
+ * @param events Mask of events
+ */
+void scheduler_post_event(uint32_t events);
+
+/**
+ * @brief Run all the released tasks, in Earliest Deadline First order, until no task is ready.
+ *
+ * @return Number of tasks run
+ */
+uint32_t scheduler_dispatch(void);
+
+/**
+ * @brief Get the system time of the next periodic release
+ *
+ * @param p_wakeup_ms Pointer to store the time of the next release
+ * @return true if there is a periodic task, false if only events can release the tasks
+ */
+bool scheduler_get_next_wakeup_ms(uint32_t *p_wakeup_ms);
+
+/**
+ * @brief Run the scheduler forever. Between dispatches the CPU sleeps until the next release, programmed in a software timer of `port_timer.h`, or until an event.
+ */
+void scheduler_run(void);
+
+/**
+ * @brief Get the statistics of a task
+ *
+ * @param task_id ID of the task
+ * @param p_stats Pointer to store the statistics
+ * @return true if the task exists
+ */
+bool scheduler_get_stats(int32_t task_id, scheduler_task_stats_t *p_stats);
+
+/**
+ * @brief Get the name of a task
+ *
+ * @param task_id ID of the task
+ * @return Name of the task, or NULL if the task does not exist
+ */
+const char *scheduler_get_task_name(int32_t task_id);
+
+/**
+ * @brief Reset the statistics of all the tasks
+ */
+void scheduler_reset_stats(void);
+
+#endif /* SCHEDULER_H_ */
@@ -0,0 +1,186 @@
+/**
+ * @file distance_batch.c
+ * @brief Batch filter of the windows of distances of several ultrasound sensors main file.
+ * @date 2025-01-01
+ */
+
+/* Includes ------------------------------------------------------------------*/
+/* Standard C includes */
+#include <string.h>
+
+#if defined(__ARM_FEATURE_SIMD32)
+#include <arm_acle.h>
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+/* Project includes */
+#include "distance_batch.h"
+
+/* Private functions ----------------------------------------------------------*/
+/**
+ * @brief Sort a window with an odd-even transposition network, branchless: the same comparisons whatever the data, so the compiler unrolls it
+ * @param p_values Window to sort
+ */
+static inline void _distance_batch_sort_scalar(uint16_t *p_values)
+{
+    for (uint32_t round = 0; round < DISTANCE_BATCH_NUM_MEASUREMENTS; round++)
+    {
+        for (uint32_t i = round % 2U; i + 1U < DISTANCE_BATCH_NUM_MEASUREMENTS; i += 2U)
+        {
+            uint16_t a = p_values[i];
+            uint16_t b = p_values[i + 1U];
+            p_values[i] = (a < b) ? a : b;
+            p_values[i + 1U] = (a < b) ? b : a;
+        }
+    }
+}
+
+#if defined(__ARM_FEATURE_SIMD32)
+/**
+ * @brief Sort two lanes of the windows at once with the packed 16-bit instructions: `USUB16` sets the GE flags of the lanes where a >= b and `SEL` picks each lane from one operand or the other
+ * @param p_values Rows of the window, two lanes per word
+ */
+static inline void _distance_batch_sort_packed(uint32_t *p_values)
+{
+    for (uint32_t round = 0; round < DISTANCE_BATCH_NUM_MEASUREMENTS; round++)
+    {
+        for (uint32_t i = round % 2U; i + 1U < DISTANCE_BATCH_NUM_MEASUREMENTS; i += 2U)
+        {
+            uint32_t a = p_values[i];
+            uint32_t b = p_values[i + 1U];
+            (void)__usub16(a, b); /* GE of a lane: a >= b */
+            p_values[i] = __sel(b, a);
+            p_values[i + 1U] = __sel(a, b);
+        }
+    }
+}
+
+/**
+ * @brief Filter the lanes two at a time
+ * @param p_batch Pointer to the batch
+ * @param num_sensors Sensors to filter
+ * @param p_result Pointer to store the results
+ */
+static void _distance_batch_filter_simd(const distance_batch_t *p_batch, uint32_t num_sensors, distance_batch_result_t *p_result)
+{
+    for (uint32_t lane = 0; lane < num_sensors; lane += 2U)
+    {
+        uint32_t values_arr[DISTANCE_BATCH_NUM_MEASUREMENTS];
+        for (uint32_t k = 0; k < DISTANCE_BATCH_NUM_MEASUREMENTS; k++)
+        {
+            memcpy(&values_arr[k], &p_batch->window_arr[k][lane], sizeof(uint32_t)); /* One LDR: lanes `lane` and `lane + 1` */
+        }
+        _distance_batch_sort_packed(values_arr);
+        uint32_t median;
+        if (DISTANCE_BATCH_NUM_MEASUREMENTS % 2 == 1)
+        {
+            median = values_arr[DISTANCE_BATCH_NUM_MEASUREMENTS / 2];
+        }
+        else
+        {
+            median = __uhadd16(values_arr[DISTANCE_BATCH_NUM_MEASUREMENTS / 2 - 1], values_arr[DISTANCE_BATCH_NUM_MEASUREMENTS / 2]);
+        }
+        memcpy(&p_result->min_arr[lane], &values_arr[0], sizeof(uint32_t));
+        memcpy(&p_result->max_arr[lane], &values_arr[DISTANCE_BATCH_NUM_MEASUREMENTS - 1], sizeof(uint32_t));
+        memcpy(&p_result->median_arr[lane], &median, sizeof(uint32_t));
+    }
+}
+#elif defined(__SSE2__)
+/**
+ * @brief Filter the eight lanes at once. SSE2 only compares signed 16-bit lanes, so the distances are biased by 0x8000 to keep their order
+ * @param p_batch Pointer to the batch
+ * @param num_sensors Not used: all the lanes are filtered
+ * @param p_result Pointer to store the results
+ */
+static void _distance_batch_filter_simd(const distance_batch_t *p_batch, uint32_t num_sensors, distance_batch_result_t *p_result)
+{
+    const __m128i bias = _mm_set1_epi16((short)0x8000);
+    __m128i values_arr[DISTANCE_BATCH_NUM_MEASUREMENTS];
+    for (uint32_t k = 0; k < DISTANCE_BATCH_NUM_MEASUREMENTS; k++)
+    {
+        values_arr[k] = _mm_xor_si128(_mm_load_si128((const __m128i *)p_batch->window_arr[k]), bias);
+    }
+    for (uint32_t round = 0; round < DISTANCE_BATCH_NUM_MEASUREMENTS; round++)
+    {
+        for (uint32_t i = round % 2U; i + 1U < DISTANCE_BATCH_NUM_MEASUREMENTS; i += 2U)
+        {
+            __m128i a = values_arr[i];
+            values_arr[i] = _mm_min_epi16(a, values_arr[i + 1U]);
+            values_arr[i + 1U] = _mm_max_epi16(a, values_arr[i + 1U]);
+        }
+    }
+    __m128i median;
+    if (DISTANCE_BATCH_NUM_MEASUREMENTS % 2 == 1)
+    {
+        median = _mm_xor_si128(values_arr[DISTANCE_BATCH_NUM_MEASUREMENTS / 2], bias);
+    }
+    else
+    {
+        __m128i a = _mm_xor_si128(values_arr[DISTANCE_BATCH_NUM_MEASUREMENTS / 2 - 1], bias);
+        __m128i b = _mm_xor_si128(values_arr[DISTANCE_BATCH_NUM_MEASUREMENTS / 2], bias);
+        median = _mm_add_epi16(_mm_and_si128(a, b), _mm_srli_epi16(_mm_xor_si128(a, b), 1)); /* Floor of the mean without overflow (`_mm_avg_epu16()` rounds up) */
+    }
+    _mm_store_si128((__m128i *)p_result->min_arr, _mm_xor_si128(values_arr[0], bias));
+    _mm_store_si128((__m128i *)p_result->max_arr, _mm_xor_si128(values_arr[DISTANCE_BATCH_NUM_MEASUREMENTS - 1], bias));
+    _mm_store_si128((__m128i *)p_result->median_arr, median);
+}
+#endif
+
+/* Public functions -----------------------------------------------------------*/
+void distance_batch_set(distance_batch_t *p_batch, uint32_t sensor, uint32_t idx, uint32_t distance_cm)
+{
+    if ((sensor < DISTANCE_BATCH_MAX_SENSORS) && (idx < DISTANCE_BATCH_NUM_MEASUREMENTS))
+    {
+        p_batch->window_arr[idx][sensor] = (distance_cm > UINT16_MAX) ? UINT16_MAX : (uint16_t)distance_cm;
+    }
+}
+
+void distance_batch_filter(const distance_batch_t *p_batch, uint32_t num_sensors, distance_batch_result_t *p_result)
+{
+    if (num_sensors > DISTANCE_BATCH_MAX_SENSORS)
+    {
+        num_sensors = DISTANCE_BATCH_MAX_SENSORS;
+    }
+#if defined(__ARM_FEATURE_SIMD32) || defined(__SSE2__)
+    _distance_batch_filter_simd(p_batch, num_sensors, p_result);
+#else
+    distance_batch_filter_scalar(p_batch, num_sensors, p_result);
+#endif
+}
+
+void distance_batch_filter_scalar(const distance_batch_t *p_batch, uint32_t num_sensors, distance_batch_result_t *p_result)
+{
+    if (num_sensors > DISTANCE_BATCH_MAX_SENSORS)
+    {
+        num_sensors = DISTANCE_BATCH_MAX_SENSORS;
+    }
+    for (uint32_t lane = 0; lane < num_sensors; lane++)
+    {
+        distance_batch_filter_lane(p_batch, lane, p_result);
+    }
+}
+
+void distance_batch_filter_lane(const distance_batch_t *p_batch, uint32_t sensor, distance_batch_result_t *p_result)
+{
+    if (sensor >= DISTANCE_BATCH_MAX_SENSORS)
+    {
+        return;
+    }
+    uint16_t values_arr[DISTANCE_BATCH_NUM_MEASUREMENTS];
+    for (uint32_t k = 0; k < DISTANCE_BATCH_NUM_MEASUREMENTS; k++)
+    {
+        values_arr[k] = p_batch->window_arr[k][sensor];
+    }
+    _distance_batch_sort_scalar(values_arr);
+    p_result->min_arr[sensor] = values_arr[0];
+    p_result->max_arr[sensor] = values_arr[DISTANCE_BATCH_NUM_MEASUREMENTS - 1];
+    if (DISTANCE_BATCH_NUM_MEASUREMENTS % 2 == 1)
+    {
+        p_result->median_arr[sensor] = values_arr[DISTANCE_BATCH_NUM_MEASUREMENTS / 2];
+    }
+    else
+    {
+        p_result->median_arr[sensor] = (uint16_t)(((uint32_t)values_arr[DISTANCE_BATCH_NUM_MEASUREMENTS / 2 - 1] + values_arr[DISTANCE_BATCH_NUM_MEASUREMENTS / 2]) / 2U);
+    }
+}
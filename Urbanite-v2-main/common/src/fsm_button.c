@@ -14,8 +14,10 @@
 /* HW dependent includes */
 #include "port_button.h"
 #include "port_system.h"
+#include "port_timer.h"
 #include "fsm_button.h"
-#include "stm32f4xx.h"
+#include "fsm_profile.h"
+#include "port_trace.h"
 
 /* Project includes */
 /*Struct defines-------------------------------*/
@@ -23,7 +25,8 @@
 struct fsm_button_t {
     fsm_t f;/*!< Button FSM*/
     uint32_t debounce_time_ms;/*!< Button debounce time in ms*/
-    uint32_t next_timeout; /*!<Next timeout fo the anti-debounce in ms */
+    port_timer_t debounce_timer; /*!<Software timer of the anti-debounce time */
+    volatile bool timeout_expired; /*!<The anti-debounce time has passed. Set by the callback of the timer */
     uint32_t tick_pressed; /*!<Number of ticks when the button was pressed*/
     uint32_t duration; /*How much time the button has been pressed*/
     uint32_t button_id; /*Button ID. It is unique*/
@@ -31,6 +34,28 @@ struct fsm_button_t {
 
 
 /* Function prototypes and explanation -------------------------------------------------*/
+/**
+ * @brief Callback of the anti-debounce timer. It runs in the interrupt of the software timers
+ * @param p_arg Pointer to the button FSM
+ */
+static void _fsm_button_timeout_callback(void *p_arg)
+{
+    fsm_button_t *p_fsm = (fsm_button_t *)p_arg;
+    p_fsm->timeout_expired = true;
+}
+
+/**
+ * @brief Start the anti-debounce time
+ * @param p_fsm Pointer to the button FSM
+ */
+static void _fsm_button_start_timeout(fsm_button_t *p_fsm)
+{
+    port_system_enter_critical(); /* A previous timeout must not set the flag once it is cleared */
+    p_fsm->timeout_expired = false;
+    port_timer_start(&p_fsm->debounce_timer, p_fsm->debounce_time_ms * 1000U, 0);
+    port_system_exit_critical();
+}
+
 /**
  * @brief Check if the button has been released
  * @param p_this Pointer to an fsm_t struct than contains and fsm_button_t
@@ -80,8 +105,7 @@ static bool check_button_pressed (fsm_t * p_this){
 
  static bool check_timeout (fsm_t * p_this) {
     fsm_button_t *p_fsm= (fsm_button_t *)(p_this);
-    uint32_t now= port_system_get_millis();
-    return now > p_fsm ->next_timeout;
+    return p_fsm->timeout_expired;
  }
 
 
@@ -98,7 +122,7 @@ static bool check_button_pressed (fsm_t * p_this){
 static void do_store_tick_pressed (fsm_t *p_this){
     fsm_button_t *p_fsm= (fsm_button_t *)(p_this);
     p_fsm->tick_pressed=port_system_get_millis();
-    p_fsm->next_timeout= port_system_get_millis()+p_fsm->debounce_time_ms;
+    _fsm_button_start_timeout(p_fsm);
     
 
 }
@@ -116,10 +140,12 @@ static void do_store_tick_pressed (fsm_t *p_this){
 static void do_set_duration (fsm_t * p_this){
     fsm_button_t *p_fsm= (fsm_button_t *)(p_this);
     p_fsm->duration= port_system_get_millis()-p_fsm->tick_pressed; 
-    p_fsm->next_timeout= port_system_get_millis()+p_fsm->debounce_time_ms;
+    PORT_TRACE_RECORD(PORT_TRACE_PRESS, p_fsm->button_id, 0, p_fsm->duration);
+    _fsm_button_start_timeout(p_fsm);
 }
 /* Variables global statics*/
 static fsm_trans_t fsm_trans_button[] = {{BUTTON_RELEASED, check_button_pressed,BUTTON_PRESSED_WAIT,do_store_tick_pressed},{BUTTON_PRESSED_WAIT, check_timeout, BUTTON_PRESSED,NULL},{BUTTON_PRESSED, check_button_released, BUTTON_RELEASED_WAIT,do_set_duration},{BUTTON_RELEASED_WAIT, check_timeout, BUTTON_RELEASED, NULL},{-1,NULL,-1,NULL}}; /*!<Array representing the transitions table of the FSM button*/
+FSM_PROFILE_DEFINE(fsm_button_profile, FSM_PROFILE_ID_BUTTON); /*!<Execution time of the guards and actions of the FSM button (only with FSM_PROFILE)*/
 
 /* Function prototypes and explanation -------------------------------------------------*/
 /**
@@ -137,6 +163,8 @@ static void fsm_button_init (fsm_button_t * p_fsm_button, uint32_t debounce_time
     p_fsm_button->button_id=button_id;
     p_fsm_button->tick_pressed=0;
     p_fsm_button->duration=0;
+    p_fsm_button->timeout_expired=false;
+    port_timer_setup(&p_fsm_button->debounce_timer, _fsm_button_timeout_callback, p_fsm_button);
     port_button_init(p_fsm_button->button_id);
     
 
@@ -157,11 +185,12 @@ fsm_button_t *fsm_button_new(uint32_t debounce_time, uint32_t button_id)
 /* FSM-interface functions. These functions are used to interact with the FSM */
 void fsm_button_fire(fsm_button_t *p_fsm)
 {
-    fsm_fire(&p_fsm->f); // Is it also possible to it in this way: fsm_fire((fsm_t *)p_fsm);
+    FSM_PROFILE_FIRE(&fsm_button_profile, &p_fsm->f); // fsm_fire(&p_fsm->f) unless the profiler is enabled
 }
 
 void fsm_button_destroy(fsm_button_t *p_fsm)
 {
+    port_timer_cancel(&p_fsm->debounce_timer); /* The timer must not expire after the memory is freed */
     free(p_fsm);
 }
 
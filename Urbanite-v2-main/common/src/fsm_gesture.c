@@ -0,0 +1,366 @@
+/**
+ * @file fsm_gesture.c
+ * @brief Gesture FSM main file.
+ * @date 2025-01-01
+ */
+
+/* Includes ------------------------------------------------------------------*/
+/* Standard C includes */
+#include <stdlib.h>
+#include <stddef.h>
+
+/* HW dependent includes */
+#include "port_debounce.h"
+#include "port_system.h"
+
+/* Project includes */
+#include "fsm_gesture.h"
+#include "fsm_profile.h"
+
+/* Struct defines -------------------------------------------------------------*/
+struct fsm_gesture_t
+{
+    fsm_t f;                     /*!< Gesture FSM */
+    fsm_gesture_config_t config; /*!< Thresholds of the gestures */
+    uint32_t key_id;             /*!< Key ID of the debounce engine */
+    uint32_t tick_pressed;       /*!< Timestamp of the first press of the gesture */
+    uint32_t tick_released;      /*!< Timestamp of the release of the first press */
+    uint32_t next_repeat;        /*!< System time of the next repeat */
+    uint32_t now_ms;             /*!< System time of the last fire, used when there is no pending edge */
+    port_debounce_event_t edge;  /*!< Press or release of the key waiting to be processed */
+    bool edge_pending;           /*!< There is an edge waiting to be processed */
+    bool level;                  /*!< Debounced level of the key after the last edge */
+};
+
+/* Global variables -----------------------------------------------------------*/
+static fsm_gesture_event_t events_arr[FSM_GESTURE_QUEUE_SIZE]; /*!< Queue of gesture events of all the keys */
+static uint32_t events_head = 0;                               /*!< Index of the next event to write */
+static uint32_t events_tail = 0;                               /*!< Index of the next event to read */
+static uint32_t events_dropped = 0;                            /*!< Events lost because the queue was full */
+static bool debounce_started = false;                          /*!< The debounce engine has been started */
+static fsm_gesture_t *fsms_arr[PORT_DEBOUNCE_MAX_KEYS];        /*!< Gesture FSM of each key. The edges of the keys without FSM are discarded */
+
+/* Private functions ----------------------------------------------------------*/
+/**
+ * @brief Queue a gesture event
+ * @param p_fsm Pointer to the gesture FSM that recognized the gesture
+ * @param type Type of gesture
+ * @param timestamp_ms Time of the edge or of the deadline that completed the gesture
+ */
+static void _fsm_gesture_push_event(fsm_gesture_t *p_fsm, fsm_gesture_event_type_t type, uint32_t timestamp_ms)
+{
+    if ((events_head - events_tail) >= FSM_GESTURE_QUEUE_SIZE)
+    {
+        events_dropped++;
+        return;
+    }
+    fsm_gesture_event_t *p_event = &events_arr[events_head & (FSM_GESTURE_QUEUE_SIZE - 1U)];
+    p_event->timestamp_ms = timestamp_ms;
+    p_event->key_id = p_fsm->key_id;
+    p_event->type = type;
+    events_head++;
+}
+
+/**
+ * @brief Check if a deadline was reached before the pending edge, or before the last fire if there is no pending edge
+ * @param p_fsm Pointer to the gesture FSM
+ * @param deadline_ms Deadline
+ * @return true if the deadline was reached
+ */
+static bool _fsm_gesture_deadline_reached(fsm_gesture_t *p_fsm, uint32_t deadline_ms)
+{
+    uint32_t t = p_fsm->edge_pending ? p_fsm->edge.timestamp_ms : p_fsm->now_ms;
+    return (int32_t)(t - deadline_ms) >= 0;
+}
+
+/* State machine input or transition functions */
+/**
+ * @brief Check if the pending edge is a press
+ * @param p_this Pointer to an fsm_t struct than contains an fsm_gesture_t
+ * @return true if the key has been pressed
+ */
+static bool check_pressed(fsm_t *p_this)
+{
+    fsm_gesture_t *p_fsm = (fsm_gesture_t *)(p_this);
+    return p_fsm->edge_pending && p_fsm->edge.pressed;
+}
+
+/**
+ * @brief Check if the pending edge is a release
+ * @param p_this Pointer to an fsm_t struct than contains an fsm_gesture_t
+ * @return true if the key has been released
+ */
+static bool check_released(fsm_t *p_this)
+{
+    fsm_gesture_t *p_fsm = (fsm_gesture_t *)(p_this);
+    return p_fsm->edge_pending && !p_fsm->edge.pressed;
+}
+
+/**
+ * @brief Check if the key is released and double clicks are disabled, so the click can be fired right away
+ * @param p_this Pointer to an fsm_t struct than contains an fsm_gesture_t
+ * @return true if the key is released and double clicks are disabled
+ */
+static bool check_released_single(fsm_t *p_this)
+{
+    fsm_gesture_t *p_fsm = (fsm_gesture_t *)(p_this);
+    return (p_fsm->config.double_click_ms == 0U) && check_released(p_this);
+}
+
+/**
+ * @brief Check if the key has been held for the long press time
+ * @param p_this Pointer to an fsm_t struct than contains an fsm_gesture_t
+ * @return true if a long press must be fired
+ */
+static bool check_long_press(fsm_t *p_this)
+{
+    fsm_gesture_t *p_fsm = (fsm_gesture_t *)(p_this);
+    return (p_fsm->config.long_press_ms != 0U) && _fsm_gesture_deadline_reached(p_fsm, p_fsm->tick_pressed + p_fsm->config.long_press_ms);
+}
+
+/**
+ * @brief Check if the time to wait for a second press has expired
+ * @param p_this Pointer to an fsm_t struct than contains an fsm_gesture_t
+ * @return true if the click must be fired
+ */
+static bool check_double_click_timeout(fsm_t *p_this)
+{
+    fsm_gesture_t *p_fsm = (fsm_gesture_t *)(p_this);
+    return _fsm_gesture_deadline_reached(p_fsm, p_fsm->tick_released + p_fsm->config.double_click_ms);
+}
+
+/**
+ * @brief Check if a repeat is due while the key is held
+ * @param p_this Pointer to an fsm_t struct than contains an fsm_gesture_t
+ * @return true if a repeat must be fired
+ */
+static bool check_repeat(fsm_t *p_this)
+{
+    fsm_gesture_t *p_fsm = (fsm_gesture_t *)(p_this);
+    return (p_fsm->config.repeat_period_ms != 0U) && _fsm_gesture_deadline_reached(p_fsm, p_fsm->next_repeat);
+}
+
+/* State machine output or action functions */
+/**
+ * @brief Store the timestamp of the first press and consume the edge
+ * @param p_this Pointer to an fsm_t struct than contains an fsm_gesture_t
+ */
+static void do_store_tick_pressed(fsm_t *p_this)
+{
+    fsm_gesture_t *p_fsm = (fsm_gesture_t *)(p_this);
+    p_fsm->tick_pressed = p_fsm->edge.timestamp_ms;
+    p_fsm->edge_pending = false;
+}
+
+/**
+ * @brief Store the timestamp of the release of the first press and consume the edge
+ * @param p_this Pointer to an fsm_t struct than contains an fsm_gesture_t
+ */
+static void do_store_tick_released(fsm_t *p_this)
+{
+    fsm_gesture_t *p_fsm = (fsm_gesture_t *)(p_this);
+    p_fsm->tick_released = p_fsm->edge.timestamp_ms;
+    p_fsm->edge_pending = false;
+}
+
+/**
+ * @brief Consume the edge that ends a gesture
+ * @param p_this Pointer to an fsm_t struct than contains an fsm_gesture_t
+ */
+static void do_end_gesture(fsm_t *p_this)
+{
+    fsm_gesture_t *p_fsm = (fsm_gesture_t *)(p_this);
+    p_fsm->edge_pending = false;
+}
+
+/**
+ * @brief Fire a click on the release, when double clicks are disabled
+ * @param p_this Pointer to an fsm_t struct than contains an fsm_gesture_t
+ */
+static void do_click_on_release(fsm_t *p_this)
+{
+    fsm_gesture_t *p_fsm = (fsm_gesture_t *)(p_this);
+    p_fsm->edge_pending = false;
+    _fsm_gesture_push_event(p_fsm, GESTURE_EVENT_CLICK, p_fsm->edge.timestamp_ms);
+}
+
+/**
+ * @brief Fire a click when the time to wait for a second press expires
+ * @param p_this Pointer to an fsm_t struct than contains an fsm_gesture_t
+ */
+static void do_click(fsm_t *p_this)
+{
+    fsm_gesture_t *p_fsm = (fsm_gesture_t *)(p_this);
+    _fsm_gesture_push_event(p_fsm, GESTURE_EVENT_CLICK, p_fsm->tick_released + p_fsm->config.double_click_ms);
+}
+
+/**
+ * @brief Fire a double click on the second press and consume the edge
+ * @param p_this Pointer to an fsm_t struct than contains an fsm_gesture_t
+ */
+static void do_double_click(fsm_t *p_this)
+{
+    fsm_gesture_t *p_fsm = (fsm_gesture_t *)(p_this);
+    p_fsm->edge_pending = false;
+    _fsm_gesture_push_event(p_fsm, GESTURE_EVENT_DOUBLE_CLICK, p_fsm->edge.timestamp_ms);
+}
+
+/**
+ * @brief Fire a long press and schedule the first repeat
+ * @param p_this Pointer to an fsm_t struct than contains an fsm_gesture_t
+ */
+static void do_long_press(fsm_t *p_this)
+{
+    fsm_gesture_t *p_fsm = (fsm_gesture_t *)(p_this);
+    uint32_t timestamp_ms = p_fsm->tick_pressed + p_fsm->config.long_press_ms;
+    p_fsm->next_repeat = timestamp_ms + p_fsm->config.repeat_delay_ms;
+    _fsm_gesture_push_event(p_fsm, GESTURE_EVENT_LONG_PRESS, timestamp_ms);
+}
+
+/**
+ * @brief Fire a repeat and schedule the next one. The schedule does not drift if the FSM is fired late
+ * @param p_this Pointer to an fsm_t struct than contains an fsm_gesture_t
+ */
+static void do_repeat(fsm_t *p_this)
+{
+    fsm_gesture_t *p_fsm = (fsm_gesture_t *)(p_this);
+    uint32_t timestamp_ms = p_fsm->next_repeat;
+    p_fsm->next_repeat += p_fsm->config.repeat_period_ms;
+    _fsm_gesture_push_event(p_fsm, GESTURE_EVENT_REPEAT, timestamp_ms);
+}
+
+/* Variables global statics */
+static fsm_trans_t fsm_trans_gesture[] = {
+    {GESTURE_IDLE, check_pressed, GESTURE_PRESSED, do_store_tick_pressed},
+    {GESTURE_PRESSED, check_long_press, GESTURE_HELD, do_long_press},
+    {GESTURE_PRESSED, check_released_single, GESTURE_IDLE, do_click_on_release},
+    {GESTURE_PRESSED, check_released, GESTURE_WAIT_SECOND, do_store_tick_released},
+    {GESTURE_WAIT_SECOND, check_double_click_timeout, GESTURE_IDLE, do_click},
+    {GESTURE_WAIT_SECOND, check_pressed, GESTURE_SECOND_PRESSED, do_double_click},
+    {GESTURE_SECOND_PRESSED, check_released, GESTURE_IDLE, do_end_gesture},
+    {GESTURE_HELD, check_repeat, GESTURE_HELD, do_repeat},
+    {GESTURE_HELD, check_released, GESTURE_IDLE, do_end_gesture},
+    {-1, NULL, -1, NULL}}; /*!< Array representing the transitions table of the gesture FSM. The deadlines are checked before the edges, so the gestures are recognized in the order they happened */
+
+FSM_PROFILE_DEFINE(fsm_gesture_profile, FSM_PROFILE_ID_GESTURE); /*!< Execution time of the guards and actions of the gesture FSM (only with FSM_PROFILE) */
+
+/**
+ * @brief Process an edge of a key with its gesture FSM. The deadlines that expired before the edge are processed first
+ * @param p_fsm Pointer to the gesture FSM of the key
+ * @param p_event Pointer to the edge
+ */
+static void _fsm_gesture_process_edge(fsm_gesture_t *p_fsm, const port_debounce_event_t *p_event)
+{
+    if (p_event->pressed == p_fsm->level)
+    {
+        return; /* The opposite edge was lost because the queue was full */
+    }
+    p_fsm->level = p_event->pressed;
+    p_fsm->edge = *p_event;
+    p_fsm->edge_pending = true;
+    while (p_fsm->edge_pending && FSM_PROFILE_FIRE(&fsm_gesture_profile, &p_fsm->f))
+    {
+    }
+    p_fsm->edge_pending = false;
+}
+
+/**
+ * @brief Initialize a gesture FSM
+ * @param p_fsm_gesture Pointer to the gesture FSM
+ * @param p_config Pointer to the thresholds of the gestures. NULL selects the default thresholds
+ * @param key_id Key ID of the debounce engine
+ */
+static void fsm_gesture_init(fsm_gesture_t *p_fsm_gesture, const fsm_gesture_config_t *p_config, uint32_t key_id)
+{
+    fsm_init(&p_fsm_gesture->f, fsm_trans_gesture);
+    if (p_config != NULL)
+    {
+        p_fsm_gesture->config = *p_config;
+    }
+    else
+    {
+        p_fsm_gesture->config.long_press_ms = FSM_GESTURE_DEFAULT_LONG_PRESS_MS;
+        p_fsm_gesture->config.double_click_ms = FSM_GESTURE_DEFAULT_DOUBLE_CLICK_MS;
+        p_fsm_gesture->config.repeat_delay_ms = FSM_GESTURE_DEFAULT_REPEAT_DELAY_MS;
+        p_fsm_gesture->config.repeat_period_ms = FSM_GESTURE_DEFAULT_REPEAT_PERIOD_MS;
+    }
+    p_fsm_gesture->key_id = key_id;
+    p_fsm_gesture->tick_pressed = 0;
+    p_fsm_gesture->tick_released = 0;
+    p_fsm_gesture->next_repeat = 0;
+    p_fsm_gesture->now_ms = 0;
+    p_fsm_gesture->edge_pending = false;
+    p_fsm_gesture->level = false;
+    if (key_id < PORT_DEBOUNCE_MAX_KEYS)
+    {
+        fsms_arr[key_id] = p_fsm_gesture;
+    }
+    if (!debounce_started)
+    {
+        port_debounce_init();
+        debounce_started = true;
+    }
+}
+
+/* Public functions -----------------------------------------------------------*/
+fsm_gesture_t *fsm_gesture_new(const fsm_gesture_config_t *p_config, uint32_t key_id)
+{
+    fsm_gesture_t *p_fsm_gesture = malloc(sizeof(fsm_gesture_t)); /* Do malloc to reserve memory of all other FSM elements, although it is interpreted as fsm_t (the first element of the structure) */
+    fsm_gesture_init(p_fsm_gesture, p_config, key_id);             /* Initialize the FSM */
+    return p_fsm_gesture;                                          /* Composite pattern: return the fsm_t pointer as a fsm_gesture_t pointer */
+}
+
+void fsm_gesture_destroy(fsm_gesture_t *p_fsm)
+{
+    if ((p_fsm->key_id < PORT_DEBOUNCE_MAX_KEYS) && (fsms_arr[p_fsm->key_id] == p_fsm))
+    {
+        fsms_arr[p_fsm->key_id] = NULL;
+    }
+    free(p_fsm);
+}
+
+void fsm_gesture_fire(fsm_gesture_t *p_fsm)
+{
+    p_fsm->now_ms = port_system_get_millis(); /* Sampled before draining the queue: every edge until now is already queued */
+    port_debounce_event_t event;
+    while (port_debounce_get_event(&event))
+    {
+        fsm_gesture_t *p_owner = (event.key_id < PORT_DEBOUNCE_MAX_KEYS) ? fsms_arr[event.key_id] : NULL;
+        if (p_owner != NULL)
+        {
+            _fsm_gesture_process_edge(p_owner, &event);
+        }
+    }
+    FSM_PROFILE_FIRE(&fsm_gesture_profile, &p_fsm->f);
+}
+
+fsm_t *fsm_gesture_get_inner_fsm(fsm_gesture_t *p_fsm)
+{
+    return &p_fsm->f;
+}
+
+uint32_t fsm_gesture_get_state(fsm_gesture_t *p_fsm)
+{
+    return p_fsm->f.current_state;
+}
+
+bool fsm_gesture_check_activity(fsm_gesture_t *p_fsm)
+{
+    return fsm_gesture_get_state(p_fsm) != GESTURE_IDLE;
+}
+
+bool fsm_gesture_get_event(fsm_gesture_event_t *p_event)
+{
+    if (events_tail == events_head)
+    {
+        return false;
+    }
+    *p_event = events_arr[events_tail & (FSM_GESTURE_QUEUE_SIZE - 1U)];
+    events_tail++;
+    return true;
+}
+
+uint32_t fsm_gesture_get_dropped_events(void)
+{
+    return events_dropped;
+}
@@ -0,0 +1,265 @@
+/**
+ * @file fsm_profile.c
+ * @brief Profiler of the guards and actions of the FSMs.
+ *
+ * The cost of reading the counter is measured once and subtracted from every measurement, so the guards of a few instructions are not hidden by the instrumentation.
+ *
+ * @date 2025-01-01
+ */
+
+/* Includes ------------------------------------------------------------------*/
+/* Standard C includes */
+#include <stddef.h>
+#include <string.h>
+
+/* HW dependent includes */
+#include "port_system.h"
+#include "port_log.h"
+
+/* Project includes */
+#include "fsm_profile.h"
+
+/* Defines and enums ----------------------------------------------------------*/
+#define FSM_PROFILE_CALIBRATION_RUNS 8U /*!< Back-to-back reads of the counter to measure its cost */
+
+/* Global variables -----------------------------------------------------------*/
+static fsm_profile_t *p_profiles = NULL;      /*!< Profiles of the FSM types that have been fired */
+static fsm_profile_block_t *p_blocks = NULL;  /*!< Profiles of the blocks that have run */
+static uint32_t overhead_cycles = UINT32_MAX; /*!< Cost of a measurement without code. UINT32_MAX until it is calibrated */
+
+/* Private functions ----------------------------------------------------------*/
+/**
+ * @brief Measure the cost of reading the counter twice
+ */
+static void _fsm_profile_calibrate(void)
+{
+    for (uint32_t i = 0; i < FSM_PROFILE_CALIBRATION_RUNS; i++)
+    {
+        uint32_t start = port_system_get_cycles();
+        uint32_t cycles = port_system_get_cycles() - start;
+        if (cycles < overhead_cycles)
+        {
+            overhead_cycles = cycles;
+        }
+    }
+}
+
+/**
+ * @brief Clear a measurement
+ * @param p_stats Pointer to the measurement
+ */
+static void _fsm_profile_clear(fsm_profile_stats_t *p_stats)
+{
+    memset(p_stats, 0, sizeof(*p_stats));
+    p_stats->min_cycles = UINT32_MAX;
+}
+
+/**
+ * @brief Account a call
+ * @param p_stats Pointer to the measurement
+ * @param start Value of the counter before the call
+ */
+static void _fsm_profile_account(fsm_profile_stats_t *p_stats, uint32_t start)
+{
+    uint32_t cycles = port_system_get_cycles() - start;
+    cycles = (cycles > overhead_cycles) ? (cycles - overhead_cycles) : 0U;
+    p_stats->calls++;
+    p_stats->total_cycles += cycles;
+    if (cycles < p_stats->min_cycles)
+    {
+        p_stats->min_cycles = cycles;
+    }
+    if (cycles > p_stats->max_cycles)
+    {
+        p_stats->max_cycles = cycles;
+    }
+}
+
+/**
+ * @brief Clear the measurements of an FSM type
+ * @param p_profile Pointer to the profile
+ */
+static void _fsm_profile_reset(fsm_profile_t *p_profile)
+{
+    _fsm_profile_clear(&p_profile->fire);
+    for (uint32_t row = 0; row < FSM_PROFILE_MAX_ROWS; row++)
+    {
+        _fsm_profile_clear(&p_profile->guards_arr[row]);
+        _fsm_profile_clear(&p_profile->actions_arr[row]);
+    }
+    memset(p_profile->transitions_arr, 0, sizeof(p_profile->transitions_arr));
+}
+
+/**
+ * @brief Log the time of a measurement
+ * @param p_stats Pointer to the measurement
+ */
+static void _fsm_profile_log_cycles(const fsm_profile_stats_t *p_stats)
+{
+    uint32_t avg = (uint32_t)(p_stats->total_cycles / p_stats->calls);
+    uint32_t total = (p_stats->total_cycles > UINT32_MAX) ? UINT32_MAX : (uint32_t)p_stats->total_cycles;
+    PORT_LOG_INFO(PORT_LOG_MSG_PROFILE_CYCLES, p_stats->min_cycles, p_stats->max_cycles, avg, total);
+    port_log_flush(); /* The dump is longer than the buffer of the logger */
+}
+
+/* Public functions -----------------------------------------------------------*/
+int fsm_profile_fire(fsm_profile_t *p_profile, fsm_t *p_fsm)
+{
+    if (!p_profile->registered)
+    {
+        if (overhead_cycles == UINT32_MAX)
+        {
+            _fsm_profile_calibrate();
+        }
+        p_profile->num_rows = 0;
+        while (p_fsm->p_tt[p_profile->num_rows].orig_state >= 0)
+        {
+            p_profile->num_rows++;
+        }
+        _fsm_profile_reset(p_profile);
+        p_profile->p_next = p_profiles;
+        p_profiles = p_profile;
+        p_profile->registered = true;
+    }
+
+    uint32_t fire_start = port_system_get_cycles();
+    int taken = 0;
+    uint32_t row = 0;
+    for (fsm_trans_t *p_t = p_fsm->p_tt; p_t->orig_state >= 0; ++p_t, ++row)
+    {
+        if (p_fsm->current_state != p_t->orig_state)
+        {
+            continue;
+        }
+        uint32_t start = port_system_get_cycles();
+        bool in = p_t->in(p_fsm);
+        if (row < FSM_PROFILE_MAX_ROWS)
+        {
+            _fsm_profile_account(&p_profile->guards_arr[row], start);
+            p_profile->guards_arr[row].taken += in ? 1U : 0U;
+        }
+        if (in)
+        {
+            if ((uint32_t)p_t->orig_state < FSM_PROFILE_MAX_STATES)
+            {
+                p_profile->transitions_arr[p_t->orig_state]++;
+            }
+            p_fsm->current_state = p_t->dest_state;
+            if (p_t->out != NULL)
+            {
+                start = port_system_get_cycles();
+                p_t->out(p_fsm);
+                if (row < FSM_PROFILE_MAX_ROWS)
+                {
+                    _fsm_profile_account(&p_profile->actions_arr[row], start);
+                }
+            }
+            taken = 1;
+            break;
+        }
+    }
+    _fsm_profile_account(&p_profile->fire, fire_start);
+    return taken;
+}
+
+uint32_t fsm_profile_block_begin(void)
+{
+    if (overhead_cycles == UINT32_MAX)
+    {
+        _fsm_profile_calibrate();
+    }
+    return port_system_get_cycles();
+}
+
+void fsm_profile_block_end(fsm_profile_block_t *p_block, uint32_t start)
+{
+    if (!p_block->registered)
+    {
+        _fsm_profile_clear(&p_block->stats);
+        p_block->p_next = p_blocks;
+        p_blocks = p_block;
+        p_block->registered = true;
+    }
+    _fsm_profile_account(&p_block->stats, start);
+}
+
+void fsm_profile_dump(void)
+{
+    for (fsm_profile_t *p_profile = p_profiles; p_profile != NULL; p_profile = p_profile->p_next)
+    {
+        if (p_profile->fire.calls == 0U)
+        {
+            continue;
+        }
+        PORT_LOG_INFO(PORT_LOG_MSG_PROFILE_FIRE, p_profile->id, p_profile->fire.calls);
+        _fsm_profile_log_cycles(&p_profile->fire);
+        uint32_t rows = (p_profile->num_rows < FSM_PROFILE_MAX_ROWS) ? p_profile->num_rows : FSM_PROFILE_MAX_ROWS;
+        for (uint32_t row = 0; row < rows; row++)
+        {
+            const fsm_profile_stats_t *p_guard = &p_profile->guards_arr[row];
+            const fsm_profile_stats_t *p_action = &p_profile->actions_arr[row];
+            if (p_guard->calls > 0U)
+            {
+                PORT_LOG_INFO(PORT_LOG_MSG_PROFILE_GUARD, p_profile->id, row, p_guard->calls, p_guard->taken);
+                _fsm_profile_log_cycles(p_guard);
+            }
+            if (p_action->calls > 0U)
+            {
+                PORT_LOG_INFO(PORT_LOG_MSG_PROFILE_ACTION, p_profile->id, row, p_action->calls);
+                _fsm_profile_log_cycles(p_action);
+            }
+        }
+        for (uint32_t state = 0; state < FSM_PROFILE_MAX_STATES; state++)
+        {
+            if (p_profile->transitions_arr[state] > 0U)
+            {
+                PORT_LOG_INFO(PORT_LOG_MSG_PROFILE_STATE, p_profile->id, state, p_profile->transitions_arr[state]);
+            }
+        }
+    }
+    for (fsm_profile_block_t *p_block = p_blocks; p_block != NULL; p_block = p_block->p_next)
+    {
+        if (p_block->stats.calls > 0U)
+        {
+            PORT_LOG_INFO(PORT_LOG_MSG_PROFILE_BLOCK, p_block->id, p_block->stats.calls);
+            _fsm_profile_log_cycles(&p_block->stats);
+        }
+    }
+    port_log_flush();
+}
+
+void fsm_profile_reset(void)
+{
+    for (fsm_profile_t *p_profile = p_profiles; p_profile != NULL; p_profile = p_profile->p_next)
+    {
+        _fsm_profile_reset(p_profile);
+    }
+    for (fsm_profile_block_t *p_block = p_blocks; p_block != NULL; p_block = p_block->p_next)
+    {
+        _fsm_profile_clear(&p_block->stats);
+    }
+}
+
+const fsm_profile_t *fsm_profile_get(uint32_t id)
+{
+    for (fsm_profile_t *p_profile = p_profiles; p_profile != NULL; p_profile = p_profile->p_next)
+    {
+        if (p_profile->id == id)
+        {
+            return p_profile;
+        }
+    }
+    return NULL;
+}
+
+const fsm_profile_block_t *fsm_profile_get_block(uint32_t id)
+{
+    for (fsm_profile_block_t *p_block = p_blocks; p_block != NULL; p_block = p_block->p_next)
+    {
+        if (p_block->id == id)
+        {
+            return p_block;
+        }
+    }
+    return NULL;
+}
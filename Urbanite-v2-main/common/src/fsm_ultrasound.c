@@ -15,31 +15,133 @@
 
 /* Project includes */
 #include "fsm_ultrasound.h"
+#include "distance_pipeline.h"
 #include "port_ultrasound.h"
 #include "port_system.h"
 #include "fsm.h"
+#include "fsm_profile.h"
+#include "port_latency.h"
+#include "port_trace.h"
+
+/* Defines and enums ----------------------------------------------------------*/
+#define FSM_ULTRASOUND_BANK_SIZE DISTANCE_PIPELINE_LANES //Sensors of a bank: one lane of the distance pipeline each
+#define FSM_ULTRASOUND_FLAG_STATUS 0x01U //Flag of the sensor active, in the flags of a sensor
+#define FSM_ULTRASOUND_FLAG_NEW_MEASUREMENT 0x02U //Flag of a new median ready, in the flags of a sensor
+#define FSM_ULTRASOUND_FLAG_ZONE_CHANGED 0x04U //Flag of a change of the proximity zone not read yet, in the flags of a sensor
 
-/* Typedefs --------------------------------------------------------------------*/
-/*Global variables---------------------------------------------------------------------------------------*/
-static fsm_trans_t fsm_trans_ultrasound[] ={{WAIT_START, check_on, TRIGGER_START, do_start_measurement},{TRIGGER_START, check_trigger_end, WAIT_ECHO_START, check_echo_init}, {WAIT_ECHO_START, check_echo_init, WAIT_ECHO_END, NULL}, {WAIT_ECHO_END, check_echo_received, SET_DISTANCE, do_set_distance}, {SET_DISTANCE, check_new_measurement, TRIGGER_START, do_start_measurement}, {SET_DISTANCE, check_off, WAIT_START, do_stop_measurement}, {-1,NULL,-1,NULL}};
 /*Structs---------------------------------------------------------------------------------*/
-typedef struct
+struct fsm_ultrasound_t
 {
     fsm_t f; //Ultrasound FSM
-    uint32_t distance_cm; //How much time the ultrasound has been pressed
-    bool status; //Indicate if the ultrasound sensor is active or not
-    bool new_measurement; //Flag to indicate if a new measuremente has been completed
-    uint32_t ultrasound_id; //Ultrasound ID. Must be unique
-    uint32_t distance_arr [FSM_ULTRASOUND_NUM_MEASUREMENTS]; //Array to store the last distance measurements
-    uint32_t distance_idx;
-} fsm_ultrasound_t;
+    uint8_t slot; //Position of the sensor in its bank
+    uint8_t ultrasound_id; //Ultrasound ID. Must be unique
+    fsm_ultrasound_zone_callback_t zone_callback; //Function called when the zone changes, or NULL. Only read on a change, so it is not in the packed arrays of the bank
+    void *p_zone_callback_arg; //Argument of the zone callback
+};
+
+/* Typedefs --------------------------------------------------------------------*/
+/**
+ * @brief Bank of ultrasound sensors. The fields used in every measurement are in packed arrays indexed by the slot of the sensor (structure of arrays), with 16-bit distances, so the state of all the sensors is contiguous. Each measurement goes through the stages of the pipeline for its own slot only: the median stage filters the window of that sensor with distance_batch_filter_lane(), not the whole batch (see distance_pipeline.h)
+ */
+struct fsm_ultrasound_bank
+{
+    fsm_ultrasound_t fsm_arr[FSM_ULTRASOUND_BANK_SIZE]; //FSMs of the sensors. It must be the first field (see _fsm_ultrasound_get_bank())
+    distance_pipeline_t pipeline; //State of the stages of the pipeline of every sensor
+    uint16_t distance_cm_arr[FSM_ULTRASOUND_BANK_SIZE]; //Last distance of every sensor out of the pipeline, in cm
+    uint16_t raw_distance_cm_arr[FSM_ULTRASOUND_BANK_SIZE]; //Last distance of every sensor before the pipeline, in cm
+    uint8_t confidence_arr[FSM_ULTRASOUND_BANK_SIZE]; //Confidence of the last distance of every sensor out of the pipeline
+    uint8_t zone_arr[FSM_ULTRASOUND_BANK_SIZE]; //Proximity zone of every sensor (fsm_ultrasound_zone_t)
+    fsm_ultrasound_zone_config_t zone_config_arr[FSM_ULTRASOUND_BANK_SIZE]; //Thresholds of the zones of every sensor. Only read when there is a new distance
+    uint8_t flags_arr[FSM_ULTRASOUND_BANK_SIZE]; //Flags of every sensor (FSM_ULTRASOUND_FLAG_xxx)
+    uint32_t used_mask; //Bit i set if the slot i has an FSM
+    struct fsm_ultrasound_bank *p_next; //Next bank, allocated when all the slots of the previous ones are used
+    struct fsm_ultrasound_bank *p_first; //First bank of the chain of this bank, that is never freed with its FSMs
+};
+
+/*Global variables---------------------------------------------------------------------------------------*/
+FSM_PROFILE_DEFINE(fsm_ultrasound_profile, FSM_PROFILE_ID_ULTRASOUND); /*!< Execution time of the guards and actions of the ultrasound FSM (only with FSM_PROFILE) */
+FSM_PROFILE_DEFINE_BLOCK(fsm_ultrasound_pipeline_profile, FSM_PROFILE_ID_ULTRASOUND_PIPELINE); /*!< Execution time of the distance pipeline (only with FSM_PROFILE) */
+static fsm_ultrasound_bank_t first_bank = {.p_first = &first_bank}; /*!< Bank of the first sensors, without heap (all of them in the board) */
+static const fsm_ultrasound_zone_config_t default_zone_config = {FSM_ULTRASOUND_DEFAULT_CRITICAL_CM, FSM_ULTRASOUND_DEFAULT_NEAR_CM, FSM_ULTRASOUND_DEFAULT_MEDIUM_CM, FSM_ULTRASOUND_DEFAULT_HYSTERESIS_CM}; /*!< Thresholds of the zones of a new FSM */
 
 
 /* Private functions -----------------------------------------------------------*/
-// Comparison function for qsort
-int _compare(const void *a, const void *b)
+/**
+ * @brief Get the bank of an FSM
+ * @param p_fsm Pointer to the ultrasound FSM
+ * @return Pointer to the bank that holds the FSM
+ */
+static inline fsm_ultrasound_bank_t *_fsm_ultrasound_get_bank(fsm_ultrasound_t *p_fsm)
+{
+    return (fsm_ultrasound_bank_t *)(p_fsm - p_fsm->slot); //The FSMs are the first field of the bank
+}
+
+/**
+ * @brief Write a flag of a sensor
+ * @param p_fsm Pointer to the ultrasound FSM
+ * @param flag Flag (FSM_ULTRASOUND_FLAG_xxx)
+ * @param value New value of the flag
+ */
+static inline void _fsm_ultrasound_write_flag(fsm_ultrasound_t *p_fsm, uint8_t flag, bool value)
+{
+    uint8_t *p_flags = &_fsm_ultrasound_get_bank(p_fsm)->flags_arr[p_fsm->slot];
+    *p_flags = value ? (uint8_t)(*p_flags | flag) : (uint8_t)(*p_flags & ~flag);
+}
+
+/**
+ * @brief Read a flag of a sensor
+ * @param p_fsm Pointer to the ultrasound FSM
+ * @param flag Flag (FSM_ULTRASOUND_FLAG_xxx)
+ * @return Value of the flag
+ */
+static inline bool _fsm_ultrasound_read_flag(fsm_ultrasound_t *p_fsm, uint8_t flag)
+{
+    return (_fsm_ultrasound_get_bank(p_fsm)->flags_arr[p_fsm->slot] & flag) != 0;
+}
+
+/**
+ * @brief Zone of a distance, without hysteresis
+ * @param p_config Pointer to the thresholds of the zones
+ * @param distance_cm Distance in cm
+ * @return Zone of the distance
+ */
+static fsm_ultrasound_zone_t _fsm_ultrasound_classify(const fsm_ultrasound_zone_config_t *p_config, uint32_t distance_cm)
 {
-    return (*(uint32_t *)a - *(uint32_t *)b);
+    if (distance_cm < p_config->critical_cm)
+    {
+        return ULTRASOUND_ZONE_CRITICAL;
+    }
+    if (distance_cm < p_config->near_cm)
+    {
+        return ULTRASOUND_ZONE_NEAR;
+    }
+    if (distance_cm < p_config->medium_cm)
+    {
+        return ULTRASOUND_ZONE_MEDIUM;
+    }
+    return ULTRASOUND_ZONE_FAR;
+}
+
+/**
+ * @brief Zone of a new distance of a sensor, with hysteresis: a closer zone is entered below its threshold, but a zone is only left for a farther one when the distance is above the threshold plus the hysteresis band
+ * @param p_config Pointer to the thresholds of the zones
+ * @param zone Current zone of the sensor
+ * @param distance_cm New distance in cm
+ * @return New zone of the sensor
+ */
+static fsm_ultrasound_zone_t _fsm_ultrasound_next_zone(const fsm_ultrasound_zone_config_t *p_config, fsm_ultrasound_zone_t zone, uint32_t distance_cm)
+{
+    fsm_ultrasound_zone_t next_zone = _fsm_ultrasound_classify(p_config, distance_cm);
+    if ((zone != ULTRASOUND_ZONE_NONE) && (next_zone < zone))
+    {
+        uint32_t band_cm = (distance_cm > p_config->hysteresis_cm) ? (distance_cm - p_config->hysteresis_cm) : 0;
+        next_zone = _fsm_ultrasound_classify(p_config, band_cm); //Farther only past the band above the thresholds
+        if (next_zone > zone)
+        {
+            next_zone = zone;
+        }
+    }
+    return next_zone;
 }
 
 /* State machine input or transition functions */
@@ -52,7 +154,7 @@ int _compare(const void *a, const void *b)
 
 static bool check_on (fsm_t * p_this){
     fsm_ultrasound_t *p_fsm= (fsm_ultrasound_t *)(p_this);
-    bool status_trigger_signal=port_ultrasound_get_trigger_ready(p_fsm->status);
+    bool status_trigger_signal=_fsm_ultrasound_read_flag(p_fsm, FSM_ULTRASOUND_FLAG_STATUS) && port_ultrasound_get_trigger_ready(p_fsm->ultrasound_id);
     if (status_trigger_signal){
         return true;
     }
@@ -70,7 +172,7 @@ static bool check_on (fsm_t * p_this){
 
  static bool check_off (fsm_t * p_this){
     fsm_ultrasound_t *p_fsm= (fsm_ultrasound_t *)(p_this);
-    return p_fsm->status; 
+    return !_fsm_ultrasound_read_flag(p_fsm, FSM_ULTRASOUND_FLAG_STATUS); 
 }
 
 
@@ -86,13 +188,7 @@ static bool check_on (fsm_t * p_this){
 
  static bool check_trigger_end (fsm_t * p_this){
     fsm_ultrasound_t *p_fsm= (fsm_ultrasound_t *)(p_this);
-    bool status_trigger_signal=port_ultrasound_get_trigger_ready(p_fsm->status);
-    if (status_trigger_signal){
-        return false;
-    }
-    else {
-        return true;
-    }
+    return port_ultrasound_get_trigger_end(p_fsm->ultrasound_id); /*Set by the ISR of the trigger timer*/
 }
 
 
@@ -159,6 +255,7 @@ static bool check_on (fsm_t * p_this){
  static void do_start_measurement(fsm_t * p_this){
     fsm_ultrasound_t *p_fsm= (fsm_ultrasound_t *)(p_this);
     port_ultrasound_start_measurement(p_fsm->ultrasound_id);
+    PORT_LATENCY_MARK(p_fsm->ultrasound_id, PORT_LATENCY_TRIGGER_START); /* A new measurement is traced */
 }
 
 /**
@@ -175,7 +272,7 @@ static bool check_on (fsm_t * p_this){
 /**
  * @brief Set distance measured by the ultrasound sensor
  * @note This function is called when the ultrasound sensor has received the echo signal. 
- * It calculates the distance in cm and stores it in the array of distances
+ * It calculates the distance in cm and pushes it through the distance pipeline (by default, the median of the last measurements)
  * @param p_this Pointer to an fsm_t struct that contains an fsm_ultrasound_t
  
  */
@@ -183,37 +280,41 @@ static bool check_on (fsm_t * p_this){
 
  static void do_set_distance(fsm_t * p_this){
     fsm_ultrasound_t *p_fsm= (fsm_ultrasound_t *)(p_this);
+    PORT_LATENCY_MARK(p_fsm->ultrasound_id, PORT_LATENCY_SET_DISTANCE);
     uint32_t e_i_t= port_ultrasound_get_echo_init_tick(p_fsm->ultrasound_id); //Retrieve echo init tick
     uint32_t e_e_t= port_ultrasound_get_echo_end_tick(p_fsm->ultrasound_id);//Retrieve echo end tick
     uint32_t e_o= port_ultrasound_get_echo_overflows(p_fsm->ultrasound_id);//Retrieve echo overflows
-    uint32_t time_echo=port_ultrasound_get_echo_init_tick(p_fsm->ultrasound_id)-port_ultrasound_get_echo_end_tick(p_fsm->ultrasound_id);
-    uint32_t distance= (time_echo*SPEED_OF_SOUND_MS)/(2*10000); //Calculate the distance in cm taking into account in the position of the index
-    if (p_fsm->distance_idx >= FSM_ULTRASOUND_NUM_MEASUREMENTS){
-
-        qsort(p_fsm->distance_arr, FSM_ULTRASOUND_NUM_MEASUREMENTS, sizeof(uint32_t), _compare);
-        
-        uint32_t median; //Initialize the variable median
-
-        if (FSM_ULTRASOUND_NUM_MEASUREMENTS %2 ==1) //Odd
-        {
-            median = p_fsm->distance_arr[FSM_ULTRASOUND_NUM_MEASUREMENTS/2];
-
-        }
-
-        else  //Even
-        {
-            median = (p_fsm->distance_arr[FSM_ULTRASOUND_NUM_MEASUREMENTS/2 -1] + p_fsm->distance_arr[FSM_ULTRASOUND_NUM_MEASUREMENTS/2])/2;
-
+    uint32_t time_echo=(e_e_t + e_o*PORT_PARKING_SENSOR_ECHO_TIMER_TICKS) - e_i_t; //Duration of the echo in us, counting the overflows of the timer
+    uint32_t distance= (time_echo*SPEED_OF_SOUND_MS)/(2*10000); //Calculate the distance in cm
+    fsm_ultrasound_bank_t *p_bank = _fsm_ultrasound_get_bank(p_fsm);
+    uint32_t slot = p_fsm->slot;
+    distance_record_t record; //Record of the measurement for the stages of the pipeline
+    record.raw_distance_cm = (distance > UINT16_MAX) ? UINT16_MAX : (uint16_t)distance;
+    record.distance_cm = record.raw_distance_cm;
+    record.time_ms = port_system_get_millis();
+    record.confidence = DISTANCE_RECORD_CONFIDENCE_MAX; //Full confidence, unless a stage lowers it
+    bool accepted;
+    FSM_PROFILE_BLOCK(&fsm_ultrasound_pipeline_profile, accepted = distance_pipeline_push(&p_bank->pipeline, slot, &record));
+    if (accepted){
+
+    p_bank->distance_cm_arr[slot]=record.distance_cm; // Storing the distance out of the pipeline
+    p_bank->confidence_arr[slot]=record.confidence;
+
+    fsm_ultrasound_zone_t zone = _fsm_ultrasound_next_zone(&p_bank->zone_config_arr[slot], (fsm_ultrasound_zone_t)p_bank->zone_arr[slot], record.distance_cm);
+    if (zone != p_bank->zone_arr[slot]){
+        p_bank->zone_arr[slot]=(uint8_t)zone;
+        _fsm_ultrasound_write_flag(p_fsm, FSM_ULTRASOUND_FLAG_ZONE_CHANGED, true); // Only a change of zone is notified
+        if (p_fsm->zone_callback != NULL){
+            p_fsm->zone_callback(p_fsm, zone, p_fsm->p_zone_callback_arg);
         }
+    }
     
-    p_fsm->distance_cm=median; // Storing the value of the median in the field distance_cm
-    
-    p_fsm->new_measurement=true; // New measurement is ready
-    
-    p_fsm->distance_idx = (p_fsm->distance_idx ++) % FSM_ULTRASOUND_NUM_MEASUREMENTS; //Rset the index if is equal or higher than 5
+    _fsm_ultrasound_write_flag(p_fsm, FSM_ULTRASOUND_FLAG_NEW_MEASUREMENT, true); // New measurement is ready
+    PORT_LATENCY_MARK(p_fsm->ultrasound_id, PORT_LATENCY_MEDIAN_READY);
+    PORT_TRACE_RECORD(PORT_TRACE_DISTANCE, p_fsm->ultrasound_id, distance, record.distance_cm);
 
     }  
-    p_fsm->distance_arr[p_fsm->distance_idx]=distance; //Store the distance in the array
+    p_bank->raw_distance_cm_arr[slot]=record.raw_distance_cm; //Keep the last raw distance for the telemetry
 
 
 
@@ -256,6 +357,9 @@ static bool check_on (fsm_t * p_this){
 
 
 
+/* Variables global statics*/
+static fsm_trans_t fsm_trans_ultrasound[] ={{WAIT_START, check_on, TRIGGER_START, do_start_measurement},{TRIGGER_START, check_trigger_end, WAIT_ECHO_START, do_stop_trigger}, {WAIT_ECHO_START, check_echo_init, WAIT_ECHO_END, NULL}, {WAIT_ECHO_END, check_echo_received, SET_DISTANCE, do_set_distance}, {SET_DISTANCE, check_new_measurement, TRIGGER_START, do_start_new_measurement}, {SET_DISTANCE, check_off, WAIT_START, do_stop_measurement}, {-1,NULL,-1,NULL}}; /*!<Array representing the transitions table of the FSM ultrasound*/
+
 /* Other auxiliary functions */
 /**
  * @brief Initialize a ultrasound FSM
@@ -269,11 +373,18 @@ static void fsm_ultrasound_init(fsm_ultrasound_t *p_fsm_ultrasound, uint32_t ult
 {
     // Initialize the FSM
     fsm_init(&p_fsm_ultrasound->f, fsm_trans_ultrasound); 
-    p_fsm_ultrasound->distance_cm=0;
-    p_fsm_ultrasound->distance_idx=0;
-    for (int i=0; i<FSM_ULTRASOUND_NUM_MEASUREMENTS; i++){
-        p_fsm_ultrasound->distance_arr[i]=0;
-    }
+    p_fsm_ultrasound->ultrasound_id=(uint8_t)ultrasound_id;
+    p_fsm_ultrasound->zone_callback=NULL; //A reused slot must not call the callback of the previous FSM
+    p_fsm_ultrasound->p_zone_callback_arg=NULL;
+    fsm_ultrasound_bank_t *p_bank = _fsm_ultrasound_get_bank(p_fsm_ultrasound);
+    uint32_t slot = p_fsm_ultrasound->slot;
+    p_bank->flags_arr[slot]=0; //Not active and no new measurement
+    p_bank->distance_cm_arr[slot]=0;
+    p_bank->raw_distance_cm_arr[slot]=0;
+    p_bank->confidence_arr[slot]=0;
+    p_bank->zone_arr[slot]=ULTRASOUND_ZONE_NONE;
+    p_bank->zone_config_arr[slot]=default_zone_config;
+    distance_pipeline_reset(&p_bank->pipeline, slot); //No past measurements in the stages
     port_ultrasound_init(ultrasound_id);
  
 }
@@ -282,17 +393,72 @@ static void fsm_ultrasound_init(fsm_ultrasound_t *p_fsm_ultrasound, uint32_t ult
 /* Public functions -----------------------------------------------------------*/
 fsm_ultrasound_t *fsm_ultrasound_new(uint32_t ultrasound_id)
 {
-    fsm_ultrasound_t *p_fsm_ultrasound = malloc(sizeof(fsm_ultrasound_t)); /* Do malloc to reserve memory of all other FSM elements, although it is interpreted as fsm_t (the first element of the structure) */
-    fsm_ultrasound_init(p_fsm_ultrasound, ultrasound_id);                  /* Initialize the FSM */
+    return fsm_ultrasound_new_in_bank(&first_bank, ultrasound_id);
+}
+
+fsm_ultrasound_t *fsm_ultrasound_new_in_bank(fsm_ultrasound_bank_t *p_bank, uint32_t ultrasound_id)
+{
+    /* Take the first free slot of the banks. A new bank is only allocated when all the slots are used */
+    while (p_bank->used_mask == (1U << FSM_ULTRASOUND_BANK_SIZE) - 1U)
+    {
+        if (p_bank->p_next == NULL)
+        {
+            p_bank->p_next = calloc(1, sizeof(fsm_ultrasound_bank_t));
+            if (p_bank->p_next == NULL)
+            {
+                return NULL;
+            }
+            p_bank->p_next->p_first = p_bank->p_first;
+        }
+        p_bank = p_bank->p_next;
+    }
+    uint32_t slot = 0;
+    while (p_bank->used_mask & (1U << slot))
+    {
+        slot++;
+    }
+    p_bank->used_mask |= 1U << slot;
+    fsm_ultrasound_t *p_fsm_ultrasound = &p_bank->fsm_arr[slot];
+    p_fsm_ultrasound->slot = (uint8_t)slot;
+    fsm_ultrasound_init(p_fsm_ultrasound, ultrasound_id); /* Initialize the FSM */
     return p_fsm_ultrasound;
 }
+fsm_ultrasound_bank_t *fsm_ultrasound_bank_new(void)
+{
+    fsm_ultrasound_bank_t *p_bank = calloc(1, sizeof(fsm_ultrasound_bank_t));
+    if (p_bank != NULL)
+    {
+        p_bank->p_first = p_bank; // The bank starts its own chain
+    }
+    return p_bank;
+}
+void fsm_ultrasound_bank_destroy(fsm_ultrasound_bank_t *p_bank){
+
+    while (p_bank != NULL)
+    {
+        fsm_ultrasound_bank_t *p_next = p_bank->p_next;
+        free(p_bank);
+        p_bank = p_next;
+    }
+}
 void fsm_ultrasound_fire(fsm_ultrasound_t * p_fsm){
         
-        fsm_fire(p_fsm);
+        FSM_PROFILE_FIRE(&fsm_ultrasound_profile, &p_fsm->f);
 }
 void fsm_ultrasound_destroy(fsm_ultrasound_t * p_fsm){
         
-    free(p_fsm);// Destroy an ultrasound FSM
+    fsm_ultrasound_bank_t *p_bank = _fsm_ultrasound_get_bank(p_fsm);
+    p_bank->used_mask &= ~(1U << p_fsm->slot); // Destroy an ultrasound FSM: its slot is free
+    if ((p_bank->used_mask == 0) && (p_bank != p_bank->p_first))
+    {
+        fsm_ultrasound_bank_t *p_prev = p_bank->p_first; // An empty bank is freed, except the first one of its chain
+        while (p_prev->p_next != p_bank)
+        {
+            p_prev = p_prev->p_next;
+        }
+        p_prev->p_next = p_bank->p_next;
+        free(p_bank);
+    }
 }
 fsm_t* fsm_ultrasound_get_inner_fsm (fsm_ultrasound_t * p_fsm){
     return &p_fsm->f; //Get the inner FSM of the ultrasound
@@ -304,24 +470,80 @@ uint32_t fsm_ultrasound_get_state(fsm_ultrasound_t * p_fsm){
 
 uint32_t fsm_ultrasound_get_distance(fsm_ultrasound_t * p_fsm){
 
-    return p_fsm->distance_cm; //Return the field distance_cm
-    
-    p_fsm->new_measurement=false; //Reset the field new_measurement
+    if (_fsm_ultrasound_read_flag(p_fsm, FSM_ULTRASOUND_FLAG_NEW_MEASUREMENT))
+    {
+        PORT_LATENCY_MARK(p_fsm->ultrasound_id, PORT_LATENCY_CONSUMED); /* The application has the median */
+    }
+    _fsm_ultrasound_write_flag(p_fsm, FSM_ULTRASOUND_FLAG_NEW_MEASUREMENT, false); //Reset the flag new_measurement
+
+    return _fsm_ultrasound_get_bank(p_fsm)->distance_cm_arr[p_fsm->slot]; //Return the median
+}
+
+uint32_t fsm_ultrasound_get_raw_distance(fsm_ultrasound_t * p_fsm){
+
+    return _fsm_ultrasound_get_bank(p_fsm)->raw_distance_cm_arr[p_fsm->slot]; //Return the raw distance
+}
+
+uint8_t fsm_ultrasound_get_confidence(fsm_ultrasound_t * p_fsm){
+
+    return _fsm_ultrasound_get_bank(p_fsm)->confidence_arr[p_fsm->slot]; //Return the confidence of the distance
+}
+
+fsm_ultrasound_zone_t fsm_ultrasound_get_zone(fsm_ultrasound_t * p_fsm){
+
+    _fsm_ultrasound_write_flag(p_fsm, FSM_ULTRASOUND_FLAG_ZONE_CHANGED, false); //The change has been read
+
+    return (fsm_ultrasound_zone_t)_fsm_ultrasound_get_bank(p_fsm)->zone_arr[p_fsm->slot];
+}
+
+bool fsm_ultrasound_get_zone_changed(fsm_ultrasound_t * p_fsm){
+
+    return _fsm_ultrasound_read_flag(p_fsm, FSM_ULTRASOUND_FLAG_ZONE_CHANGED);
+}
+
+bool fsm_ultrasound_set_zone_config(fsm_ultrasound_t * p_fsm, const fsm_ultrasound_zone_config_t * p_config){
+
+    if (p_config == NULL){
+        p_config = &default_zone_config;
+    }
+    if ((p_config->critical_cm >= p_config->near_cm) || (p_config->near_cm >= p_config->medium_cm)){
+        return false; //The zones must be in order
+    }
+    _fsm_ultrasound_get_bank(p_fsm)->zone_config_arr[p_fsm->slot] = *p_config;
+    return true;
+}
+
+void fsm_ultrasound_set_zone_callback(fsm_ultrasound_t * p_fsm, fsm_ultrasound_zone_callback_t callback, void * p_arg){
+
+    p_fsm->zone_callback = callback;
+    p_fsm->p_zone_callback_arg = p_arg;
 }
 
 void fsm_ultrasound_stop(fsm_ultrasound_t * p_fsm){
-    p_fsm->status=false; //Reset the field status
+    _fsm_ultrasound_write_flag(p_fsm, FSM_ULTRASOUND_FLAG_STATUS, false); //Reset the flag status
+    PORT_TRACE_RECORD(PORT_TRACE_STOP, p_fsm->ultrasound_id, 0, 0);
 
     port_ultrasound_stop_ultrasound(p_fsm->ultrasound_id); //Stopping the ultrasound sensor
 }
 
 void fsm_ultrasound_start(fsm_ultrasound_t * p_fsm){
 
-    p_fsm->status=true; //Set the field status true
+    _fsm_ultrasound_write_flag(p_fsm, FSM_ULTRASOUND_FLAG_STATUS, true); //Set the flag status true
+    PORT_TRACE_RECORD(PORT_TRACE_START, p_fsm->ultrasound_id, 0, 0);
 
-    p_fsm->distance_idx=0;// Reset the field distance_idx
+    fsm_ultrasound_bank_t *p_bank = _fsm_ultrasound_get_bank(p_fsm);
 
-    p_fsm->distance_cm=0; //Reset the field distance_cm
+    distance_pipeline_reset(&p_bank->pipeline, p_fsm->slot);// Forget the measurements of the previous run
+
+    p_bank->distance_cm_arr[p_fsm->slot]=0; //Reset the median
+
+    p_bank->confidence_arr[p_fsm->slot]=0; //No distance yet
+
+    p_bank->zone_arr[p_fsm->slot]=ULTRASOUND_ZONE_NONE; //The first distance raises a change of zone
+
+    _fsm_ultrasound_write_flag(p_fsm, FSM_ULTRASOUND_FLAG_ZONE_CHANGED, false);
+
+    port_system_enter_critical(); //The measurement timer must not fire between the reset and the start
 
     port_ultrasound_reset_echo_ticks(p_fsm->ultrasound_id);
 
@@ -329,18 +551,21 @@ void fsm_ultrasound_start(fsm_ultrasound_t * p_fsm){
 
     port_ultrasound_start_new_measurement_timer(); //Forcing the new measurement timer to start to provoke the first interrupt
 
+    port_system_exit_critical();
+
 }
 
 bool fsm_ultrasound_get_status(fsm_ultrasound_t * p_fsm){
 
-    return p_fsm->status; //Return the field status
+    return _fsm_ultrasound_read_flag(p_fsm, FSM_ULTRASOUND_FLAG_STATUS); //Return the flag status
 
 
 }
 
 void fsm_ultrasound_set_status(fsm_ultrasound_t * p_fsm, bool status){
 
-    p_fsm->status=status; //Update the field status with the received value
+    _fsm_ultrasound_write_flag(p_fsm, FSM_ULTRASOUND_FLAG_STATUS, status); //Update the flag status with the received value
+    PORT_TRACE_RECORD(PORT_TRACE_STATUS, p_fsm->ultrasound_id, status, 0);
 
 
 }
@@ -356,7 +581,7 @@ bool fsm_ultrasound_get_ready(fsm_ultrasound_t * p_fsm)
 
 bool fsm_ultrasound_get_new_measurement_ready(fsm_ultrasound_t * p_fsm){
 
-    return p_fsm->new_measurement;
+    return _fsm_ultrasound_read_flag(p_fsm, FSM_ULTRASOUND_FLAG_NEW_MEASUREMENT);
 
 
 }
@@ -0,0 +1,323 @@
+/**
+ * @file scheduler.c
+ * @brief Deadline-aware cooperative scheduler main file.
+ * @date 2025-01-01
+ */
+
+/* Includes ------------------------------------------------------------------*/
+/* Standard C includes */
+#include <stddef.h>
+
+/* HW dependent includes */
+#include "port_system.h"
+#include "port_timer.h"
+#include "port_log.h"
+
+/* Project includes */
+#include "scheduler.h"
+
+/* Typedefs --------------------------------------------------------------------*/
+/**
+ * @brief Entry of the task table
+ */
+typedef struct
+{
+    scheduler_task_config_t config; /*!< Configuration of the task */
+    uint32_t release_ms;            /*!< System time of the pending release */
+    uint32_t deadline_ms;           /*!< Absolute deadline of the pending release */
+    uint32_t next_release_ms;       /*!< System time of the next periodic release */
+    scheduler_task_stats_t stats;   /*!< Run-time statistics */
+} scheduler_task_t;
+
+/* Global variables -----------------------------------------------------------*/
+static scheduler_task_t tasks_arr[SCHEDULER_MAX_TASKS]; /*!< Table of tasks */
+static uint32_t num_tasks = 0;                          /*!< Number of tasks in the table */
+static volatile uint32_t ready_mask = 0;                /*!< Bit i set if task i has a pending release. Modified by the ISRs that post events */
+static port_timer_t wakeup_timer;                       /*!< Software timer of the next periodic release while the CPU sleeps */
+static volatile bool wakeup_pending = false;            /*!< The wakeup timer has expired */
+
+/* Private functions ----------------------------------------------------------*/
+/**
+ * @brief Check if a system time is at or after another one, taking care of the wrap around
+ * @param t Time to check
+ * @param ref Reference time
+ * @return true if t is at or after ref
+ */
+static inline bool _scheduler_time_reached(uint32_t t, uint32_t ref)
+{
+    return (int32_t)(t - ref) >= 0;
+}
+
+/**
+ * @brief Callback of the wakeup timer. It runs in the interrupt of the software timers
+ * @param p_arg Not used
+ */
+static void _scheduler_wakeup_callback(void *p_arg)
+{
+    wakeup_pending = true;
+}
+
+/**
+ * @brief Reset the statistics of a task
+ * @param p_stats Pointer to the statistics
+ */
+static void _scheduler_reset_task_stats(scheduler_task_stats_t *p_stats)
+{
+    p_stats->runs = 0;
+    p_stats->deadline_misses = 0;
+    p_stats->min_latency_ms = UINT32_MAX;
+    p_stats->max_latency_ms = 0;
+    p_stats->max_exec_cycles = 0;
+    p_stats->total_exec_cycles = 0;
+}
+
+/**
+ * @brief Release a task
+ * @param task_id ID of the task
+ * @param release_ms System time of the release
+ */
+static void _scheduler_release(uint32_t task_id, uint32_t release_ms)
+{
+    scheduler_task_t *p_task = &tasks_arr[task_id];
+    if ((ready_mask & (1U << task_id)) == 0U)
+    {
+        p_task->release_ms = release_ms;
+        p_task->deadline_ms = release_ms + p_task->config.deadline_ms;
+        ready_mask |= (1U << task_id);
+    }
+}
+
+/**
+ * @brief Release the periodic tasks whose release time has been reached. Must be called inside a critical section
+ * @param now_ms Current system time
+ */
+static void _scheduler_release_periodic(uint32_t now_ms)
+{
+    for (uint32_t i = 0; i < num_tasks; i++)
+    {
+        scheduler_task_t *p_task = &tasks_arr[i];
+        uint32_t period = p_task->config.period_ms;
+        if ((period == 0U) || !_scheduler_time_reached(now_ms, p_task->next_release_ms))
+        {
+            continue;
+        }
+        if ((ready_mask & (1U << i)) != 0U)
+        {
+            p_task->stats.deadline_misses++; /* The previous release has not run yet */
+        }
+        _scheduler_release(i, p_task->next_release_ms);
+        p_task->next_release_ms += period;
+        if (_scheduler_time_reached(now_ms, p_task->next_release_ms))
+        {
+            /* Overrun: skip the releases that have already passed instead of running them back to back */
+            uint32_t skipped = (now_ms - p_task->next_release_ms) / period + 1U;
+            p_task->stats.deadline_misses += skipped;
+            p_task->next_release_ms += skipped * period;
+        }
+    }
+}
+
+/**
+ * @brief Take the ready task with the earliest deadline. Must be called inside a critical section
+ * @return ID of the task, or SCHEDULER_INVALID_TASK if no task is ready
+ */
+static int32_t _scheduler_take_earliest(void)
+{
+    int32_t best = SCHEDULER_INVALID_TASK;
+    uint32_t pending = ready_mask;
+    while (pending != 0U)
+    {
+        uint32_t i = 31U - (uint32_t)__builtin_clz(pending);
+        pending &= ~(1U << i);
+        if ((best == SCHEDULER_INVALID_TASK) || ((int32_t)(tasks_arr[i].deadline_ms - tasks_arr[best].deadline_ms) < 0))
+        {
+            best = (int32_t)i;
+        }
+    }
+    if (best != SCHEDULER_INVALID_TASK)
+    {
+        ready_mask &= ~(1U << best);
+    }
+    return best;
+}
+
+/* Public functions -----------------------------------------------------------*/
+void scheduler_init(void)
+{
+    port_timer_cancel(&wakeup_timer);
+    port_timer_setup(&wakeup_timer, _scheduler_wakeup_callback, NULL);
+    port_system_enter_critical();
+    num_tasks = 0;
+    ready_mask = 0;
+    port_system_exit_critical();
+}
+
+int32_t scheduler_add_task(const scheduler_task_config_t *p_config)
+{
+    if ((p_config == NULL) || (p_config->func == NULL) || (num_tasks >= SCHEDULER_MAX_TASKS) || ((p_config->period_ms == 0U) && ((p_config->event_mask == 0U) || (p_config->deadline_ms == 0U))))
+    {
+        return SCHEDULER_INVALID_TASK;
+    }
+    scheduler_task_t *p_task = &tasks_arr[num_tasks];
+    p_task->config = *p_config;
+    if (p_task->config.deadline_ms == 0U)
+    {
+        p_task->config.deadline_ms = p_config->period_ms;
+    }
+    p_task->release_ms = 0;
+    p_task->deadline_ms = 0;
+    p_task->next_release_ms = port_system_get_millis() + p_config->period_ms;
+    _scheduler_reset_task_stats(&p_task->stats);
+
+    port_system_enter_critical();
+    num_tasks++; /* Published once the task is complete, so the ISRs never see a half-initialized task */
+    port_system_exit_critical();
+
+    return (int32_t)(num_tasks - 1U);
+}
+
+void scheduler_post_event(uint32_t events)
+{
+    uint32_t now = port_system_get_millis();
+    port_system_enter_critical();
+    for (uint32_t i = 0; i < num_tasks; i++)
+    {
+        if ((tasks_arr[i].config.event_mask & events) != 0U)
+        {
+            _scheduler_release(i, now);
+        }
+    }
+    port_system_exit_critical();
+}
+
+uint32_t scheduler_dispatch(void)
+{
+    uint32_t count = 0;
+    while (true)
+    {
+        uint32_t now = port_system_get_millis();
+        port_system_enter_critical();
+        _scheduler_release_periodic(now);
+        int32_t task_id = _scheduler_take_earliest();
+        uint32_t start_ms = port_system_get_millis(); /* Sampled after the task is taken: an ISR may have released it after `now` */
+        port_system_exit_critical();
+        if (task_id == SCHEDULER_INVALID_TASK)
+        {
+            break;
+        }
+
+        scheduler_task_t *p_task = &tasks_arr[task_id];
+        scheduler_task_stats_t *p_stats = &p_task->stats;
+        uint32_t latency = _scheduler_time_reached(start_ms, p_task->release_ms) ? (start_ms - p_task->release_ms) : 0U; /* Clamped for ISRs that the critical section does not mask */
+        uint32_t deadline = p_task->deadline_ms;
+
+        uint32_t start = port_system_get_cycles();
+        p_task->config.func(p_task->config.p_arg);
+        uint32_t exec = port_system_get_cycles() - start;
+
+        if (!_scheduler_time_reached(deadline, port_system_get_millis()))
+        {
+            p_stats->deadline_misses++;
+        }
+        p_stats->runs++;
+        p_stats->total_exec_cycles += exec;
+        if (exec > p_stats->max_exec_cycles)
+        {
+            p_stats->max_exec_cycles = exec;
+        }
+        if (latency < p_stats->min_latency_ms)
+        {
+            p_stats->min_latency_ms = latency;
+        }
+        if (latency > p_stats->max_latency_ms)
+        {
+            p_stats->max_latency_ms = latency;
+        }
+        count++;
+    }
+    return count;
+}
+
+bool scheduler_get_next_wakeup_ms(uint32_t *p_wakeup_ms)
+{
+    bool found = false;
+    uint32_t now = port_system_get_millis();
+    for (uint32_t i = 0; i < num_tasks; i++)
+    {
+        scheduler_task_t *p_task = &tasks_arr[i];
+        if (p_task->config.period_ms == 0U)
+        {
+            continue;
+        }
+        if (!found || ((int32_t)((p_task->next_release_ms - now) - (*p_wakeup_ms - now)) < 0))
+        {
+            *p_wakeup_ms = p_task->next_release_ms;
+            found = true;
+        }
+    }
+    return found;
+}
+
+void scheduler_run(void)
+{
+    while (true)
+    {
+        scheduler_dispatch();
+        uint32_t wakeup = 0;
+        bool periodic = scheduler_get_next_wakeup_ms(&wakeup);
+        uint32_t now = port_system_get_millis();
+        if (periodic && _scheduler_time_reached(now, wakeup))
+        {
+            continue;
+        }
+        /* Send the log records while idle, then sleep until the next release or until an ISR posts an event */
+        port_log_flush();
+        port_system_enter_critical();
+        wakeup_pending = false;
+        if (periodic)
+        {
+            port_timer_start(&wakeup_timer, (wakeup - now) * 1000U, 0);
+        }
+        port_system_exit_critical();
+        /* The check and the sleep are done with the interrupts masked: an event posted after the check wakes up the CPU, and its ISR runs when they are unmasked */
+        bool idle = true;
+        while (idle)
+        {
+            port_system_disable_interrupts();
+            idle = (ready_mask == 0U) && !wakeup_pending;
+            if (idle)
+            {
+                port_system_sleep();
+            }
+            port_system_enable_interrupts();
+        }
+        port_timer_cancel(&wakeup_timer);
+    }
+}
+
+bool scheduler_get_stats(int32_t task_id, scheduler_task_stats_t *p_stats)
+{
+    if ((task_id < 0) || ((uint32_t)task_id >= num_tasks))
+    {
+        return false;
+    }
+    *p_stats = tasks_arr[task_id].stats;
+    return true;
+}
+
+const char *scheduler_get_task_name(int32_t task_id)
+{
+    if ((task_id < 0) || ((uint32_t)task_id >= num_tasks))
+    {
+        return NULL;
+    }
+    return tasks_arr[task_id].config.p_name;
+}
+
+void scheduler_reset_stats(void)
+{
+    for (uint32_t i = 0; i < num_tasks; i++)
+    {
+        _scheduler_reset_task_stats(&tasks_arr[i].stats);
+    }
+}
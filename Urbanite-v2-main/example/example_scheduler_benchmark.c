@@ -0,0 +1,75 @@
+/**
+ * @file example_scheduler_benchmark.c
+ * @brief Benchmark of the dispatch overhead of the cooperative scheduler.
+ *
+ * It releases 1 to SCHEDULER_MAX_TASKS empty tasks by events and measures the time of each dispatch, minus the time of calling the same functions directly. The counts of `port_system_get_cycles()` are CPU cycles in the STM32F4 and nanoseconds in the host. QEMU does not emulate the DWT cycle counter, so the time measured with the System tick over all the iterations is printed too.
+ *
+ * @date 2025-01-01
+ */
+#include <stdio.h>
+
+#include "port_system.h"
+#include "scheduler.h"
+
+/* Defines */
+#define BENCHMARK_ITERATIONS 10000U /*!< Number of dispatches measured for each number of tasks */
+#define BENCHMARK_EVENT (1U << 0)   /*!< Event that releases all the tasks */
+
+static volatile uint32_t task_runs = 0; /*!< Runs of the empty tasks, volatile so the calls are not optimized out */
+
+/**
+ * @brief Empty task
+ * @param p_arg Not used
+ */
+static void _benchmark_task(void *p_arg)
+{
+    task_runs++;
+}
+
+int main(void)
+{
+    port_system_init();
+    uint32_t cycles_per_us = port_system_get_cycles_per_us();
+    printf("Scheduler dispatch overhead (%u iterations, %lu counts/us)\n", BENCHMARK_ITERATIONS, (unsigned long)cycles_per_us);
+    printf("tasks;counts/task;ns/task;systick_ns/task\n");
+
+    for (uint32_t num_tasks = 1; num_tasks <= SCHEDULER_MAX_TASKS; num_tasks++)
+    {
+        scheduler_init();
+        scheduler_task_config_t config = {.p_name = "empty", .func = _benchmark_task, .p_arg = NULL, .event_mask = BENCHMARK_EVENT, .deadline_ms = 1000};
+        for (uint32_t i = 0; i < num_tasks; i++)
+        {
+            scheduler_add_task(&config);
+        }
+
+        /* Baseline: direct calls */
+        uint32_t start = port_system_get_cycles();
+        for (uint32_t it = 0; it < BENCHMARK_ITERATIONS; it++)
+        {
+            for (uint32_t i = 0; i < num_tasks; i++)
+            {
+                _benchmark_task(NULL);
+            }
+        }
+        uint32_t direct = port_system_get_cycles() - start;
+
+        /* Scheduler */
+        uint32_t start_ms = port_system_get_millis();
+        start = port_system_get_cycles();
+        for (uint32_t it = 0; it < BENCHMARK_ITERATIONS; it++)
+        {
+            scheduler_post_event(BENCHMARK_EVENT);
+            scheduler_dispatch();
+        }
+        uint32_t dispatched = port_system_get_cycles() - start;
+        uint32_t elapsed_ms = port_system_get_millis() - start_ms;
+
+        uint32_t total_runs = BENCHMARK_ITERATIONS * num_tasks;
+        uint32_t overhead = (dispatched > direct) ? (dispatched - direct) / total_runs : 0;
+        uint32_t overhead_ns = (cycles_per_us > 0) ? (overhead * 1000U) / cycles_per_us : 0;
+        uint32_t systick_ns = (uint32_t)(((uint64_t)elapsed_ms * 1000000U) / total_runs);
+        printf("%lu;%lu;%lu;%lu\n", (unsigned long)num_tasks, (unsigned long)overhead, (unsigned long)overhead_ns, (unsigned long)systick_ns);
+    }
+
+    return 0;
+}
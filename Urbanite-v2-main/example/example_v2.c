@@ -1,9 +1,8 @@
-#include <stdio.h>
-
 #include "fsm_ultrasound.h"
 #include "port_ultrasound.h"
 #include "port_system.h"
-#include "stm32f4_system.h"
+#include "port_log.h"
+#include "port_telemetry.h"
 
 /* Defines */
 #define PORT_REAR_PARKING_SENSOR_ID 0 /*!< Ultrasound sensor identifier @hideinitializer */
@@ -12,6 +11,7 @@ int main(void)
 {
     // Initialize the system
     port_system_init();
+    port_telemetry_init();
 
     // Reserve space memory in the heap for the FSM
     fsm_ultrasound_t *p_fsm_ultrasound_rear = fsm_ultrasound_new(PORT_REAR_PARKING_SENSOR_ID);
@@ -29,7 +29,9 @@ int main(void)
         }
 
         uint32_t distance = fsm_ultrasound_get_distance(p_fsm_ultrasound_rear);
-        printf("[%ld] Distance: %ld cm\n", port_system_get_millis(), distance);
+        PORT_LOG_INFO(PORT_LOG_MSG_DISTANCE, PORT_REAR_PARKING_SENSOR_ID, distance); // Deferred: the text is rebuilt by tools/log_decoder
+        port_telemetry_send(PORT_REAR_PARKING_SENSOR_ID, distance, fsm_ultrasound_get_raw_distance(p_fsm_ultrasound_rear), PORT_TELEMETRY_FLAG_VALID); // Batched and sent by DMA
+        port_log_flush();
     }
 
     return 0;
@@ -12,6 +12,9 @@
 /* HW libraries */
 #include "port_system.h"
 
+/* Project libraries */
+#include "scheduler.h"
+
 /* Defines ------------------------------------------------------------------*/
 
 /**
@@ -24,12 +27,10 @@ int main(void)
 
 
     port_system_init();
+    scheduler_init();
 
-    /* Infinite loop */
-    while (1)
-    {
-
-    } // End of while(1)
+    /* Infinite loop: run the tasks and sleep until the next release */
+    scheduler_run();
 
     return 0;
 }
@@ -0,0 +1,150 @@
+# Generate the fake port from the headers of the port:
+#   cmake -DFAKE_PORT_HEADERS="<header>|..." -DFAKE_PORT_BEHAVIOURS=<fake_port_behaviour.c> -DFAKE_PORT_OUTPUT_DIR=<dir> -P generate_fake_port.cmake
+# Every prototype of the headers (one per line, as in port/include) gets a fake that records the call, returns the next scripted value if there is one,
+# and otherwise runs its behaviour, if fake_port_behaviour.c defines fake_port_behaviour_<function>(), or returns the default value.
+# It writes fake_port_functions.h (identifiers and prototypes) and fake_port_generated.c (the fakes).
+SET(FAKE_PORT_MAX_ARGS 4)
+STRING(REPLACE "|" ";" FAKE_PORT_HEADERS "${FAKE_PORT_HEADERS}")
+
+FILE(READ ${FAKE_PORT_BEHAVIOURS} FAKE_PORT_BEHAVIOUR_SOURCE)
+SET(FAKE_PORT_IDS "")
+SET(FAKE_PORT_NAMES "")
+SET(FAKE_PORT_PROTOTYPES "")
+SET(FAKE_PORT_FAKES "")
+SET(FAKE_PORT_INCLUDES "")
+SET(FAKE_PORT_NUM_FUNCTIONS 0)
+
+FOREACH(HEADER ${FAKE_PORT_HEADERS})
+    GET_FILENAME_COMPONENT(HEADER_NAME ${HEADER} NAME)
+    STRING(APPEND FAKE_PORT_INCLUDES "#include \"${HEADER_NAME}\"\n")
+    FILE(STRINGS ${HEADER} LINES REGEX "^[A-Za-z_][A-Za-z_0-9 \t*]*\\(.*\\)[ \t]*;")
+    FOREACH(LINE ${LINES})
+        IF(NOT LINE MATCHES "^([A-Za-z_][A-Za-z_0-9 \t*]*[ \t*])([A-Za-z_][A-Za-z_0-9]*)[ \t]*\\((.*)\\)[ \t]*;")
+            MESSAGE(FATAL_ERROR "Cannot parse the prototype in ${HEADER_NAME}: ${LINE}")
+        ENDIF()
+        STRING(STRIP "${CMAKE_MATCH_1}" RETURN_TYPE)
+        SET(FUNCTION ${CMAKE_MATCH_2})
+        STRING(STRIP "${CMAKE_MATCH_3}" ARGS)
+        IF(NOT FUNCTION MATCHES "^port_")
+            CONTINUE()
+        ENDIF()
+        LIST(FIND FAKE_PORT_NAMES ${FUNCTION} ALREADY_FAKED)
+        IF(NOT ALREADY_FAKED EQUAL -1)
+            CONTINUE()
+        ENDIF()
+        LIST(APPEND FAKE_PORT_NAMES ${FUNCTION})
+
+        # Identifier: FAKE_PORT_FN_ and the name without port_, in capitals
+        STRING(REGEX REPLACE "^port_" "" SHORT_NAME ${FUNCTION})
+        STRING(TOUPPER ${SHORT_NAME} ID)
+        SET(ID FAKE_PORT_FN_${ID})
+        STRING(APPEND FAKE_PORT_IDS "    ${ID}, /*!< ${FUNCTION}() */\n")
+
+        # Arguments: the name is the last identifier of each one
+        SET(ARG_NAMES "")
+        IF(NOT ARGS STREQUAL "void" AND NOT ARGS STREQUAL "")
+            STRING(REPLACE "," ";" ARG_LIST "${ARGS}")
+            FOREACH(ARG ${ARG_LIST})
+                STRING(REGEX MATCH "[A-Za-z_][A-Za-z_0-9]*[ \t]*$" ARG_NAME "${ARG}")
+                STRING(STRIP "${ARG_NAME}" ARG_NAME)
+                LIST(APPEND ARG_NAMES ${ARG_NAME})
+            ENDFOREACH()
+        ELSE()
+            SET(ARGS "void")
+        ENDIF()
+        LIST(LENGTH ARG_NAMES NUM_ARGS)
+        IF(NUM_ARGS GREATER FAKE_PORT_MAX_ARGS)
+            MESSAGE(FATAL_ERROR "${FUNCTION}() has more than ${FAKE_PORT_MAX_ARGS} arguments")
+        ENDIF()
+        LIST(JOIN ARG_NAMES ", " ARG_CALL)
+        SET(ARGS_RECORD "")
+        FOREACH(ARG_NAME ${ARG_NAMES})
+            STRING(APPEND ARGS_RECORD "(uintptr_t)${ARG_NAME}, ")
+        ENDFOREACH()
+
+        # Behaviour, if fake_port_behaviour.c defines it
+        SET(BEHAVIOUR fake_port_behaviour_${FUNCTION})
+        STRING(FIND "${FAKE_PORT_BEHAVIOUR_SOURCE}" "${BEHAVIOUR}(" HAS_BEHAVIOUR)
+        IF(NOT HAS_BEHAVIOUR EQUAL -1)
+            STRING(APPEND FAKE_PORT_PROTOTYPES "${RETURN_TYPE} ${BEHAVIOUR}(${ARGS}); /*!< Behaviour of ${FUNCTION}() */\n")
+        ENDIF()
+
+        # Fake
+        STRING(APPEND FAKE_PORT_FAKES "${RETURN_TYPE} ${FUNCTION}(${ARGS})\n{\n")
+        IF(NUM_ARGS GREATER 0)
+            STRING(APPEND FAKE_PORT_FAKES "    const uintptr_t args_arr[] = {${ARGS_RECORD}};\n")
+            STRING(APPEND FAKE_PORT_FAKES "    fake_port_record_call(${ID}, args_arr, ${NUM_ARGS}U);\n")
+        ELSE()
+            STRING(APPEND FAKE_PORT_FAKES "    fake_port_record_call(${ID}, NULL, 0);\n")
+        ENDIF()
+        IF(RETURN_TYPE STREQUAL "void")
+            IF(NOT HAS_BEHAVIOUR EQUAL -1)
+                STRING(APPEND FAKE_PORT_FAKES "    ${BEHAVIOUR}(${ARG_CALL});\n")
+            ENDIF()
+        ELSE()
+            STRING(APPEND FAKE_PORT_FAKES "    uint32_t value;\n")
+            STRING(APPEND FAKE_PORT_FAKES "    if (fake_port_next_return(${ID}, &value))\n    {\n        return (${RETURN_TYPE})value;\n    }\n")
+            IF(NOT HAS_BEHAVIOUR EQUAL -1)
+                STRING(APPEND FAKE_PORT_FAKES "    return ${BEHAVIOUR}(${ARG_CALL});\n")
+            ELSE()
+                STRING(APPEND FAKE_PORT_FAKES "    return (${RETURN_TYPE})value;\n")
+            ENDIF()
+        ENDIF()
+        STRING(APPEND FAKE_PORT_FAKES "}\n\n")
+        MATH(EXPR FAKE_PORT_NUM_FUNCTIONS "${FAKE_PORT_NUM_FUNCTIONS} + 1")
+    ENDFOREACH()
+ENDFOREACH()
+
+SET(FAKE_PORT_NAME_STRINGS "")
+FOREACH(FUNCTION ${FAKE_PORT_NAMES})
+    STRING(APPEND FAKE_PORT_NAME_STRINGS "    \"${FUNCTION}\",\n")
+ENDFOREACH()
+
+FILE(WRITE ${FAKE_PORT_OUTPUT_DIR}/fake_port_functions.h.tmp
+"/**
+ * @file fake_port_functions.h
+ * @brief Functions of the fake port. Generated by generate_fake_port.cmake from the headers of the port: do not edit.
+ */
+#ifndef FAKE_PORT_FUNCTIONS_H_
+#define FAKE_PORT_FUNCTIONS_H_
+
+/* Includes ------------------------------------------------------------------*/
+#include <stdint.h>
+#include <stdbool.h>
+${FAKE_PORT_INCLUDES}
+/* Defines and enums ----------------------------------------------------------*/
+#define FAKE_PORT_MAX_ARGS ${FAKE_PORT_MAX_ARGS}U /*!< Arguments recorded for each call */
+
+/**
+ * @brief Identifiers of the faked functions
+ */
+enum FAKE_PORT_FN
+{
+${FAKE_PORT_IDS}    FAKE_PORT_NUM_FUNCTIONS /*!< Number of faked functions (${FAKE_PORT_NUM_FUNCTIONS}) */
+};
+
+/* Function prototypes and explanation -------------------------------------------------*/
+${FAKE_PORT_PROTOTYPES}
+#endif /* FAKE_PORT_FUNCTIONS_H_ */
+")
+
+FILE(WRITE ${FAKE_PORT_OUTPUT_DIR}/fake_port_generated.c.tmp
+"/**
+ * @file fake_port_generated.c
+ * @brief Fakes of the functions of the port. Generated by generate_fake_port.cmake from the headers of the port: do not edit.
+ */
+
+/* Includes ------------------------------------------------------------------*/
+#include <stddef.h>
+#include \"fake_port.h\"
+
+/* Global variables -----------------------------------------------------------*/
+const char *const fake_port_names_arr[FAKE_PORT_NUM_FUNCTIONS] = {
+${FAKE_PORT_NAME_STRINGS}}; /*!< Names of the faked functions */
+
+/* Public functions -----------------------------------------------------------*/
+${FAKE_PORT_FAKES}")
+
+# Only touch the outputs if they change, so that the fakes are not rebuilt
+CONFIGURE_FILE(${FAKE_PORT_OUTPUT_DIR}/fake_port_functions.h.tmp ${FAKE_PORT_OUTPUT_DIR}/fake_port_functions.h COPYONLY)
+CONFIGURE_FILE(${FAKE_PORT_OUTPUT_DIR}/fake_port_generated.c.tmp ${FAKE_PORT_OUTPUT_DIR}/fake_port_generated.c COPYONLY)
@@ -0,0 +1,191 @@
+/**
+ * @file fake_port.h
+ * @brief Header for the fake port: the functions of `port_button.h`, `port_ultrasound.h` and `port_system.h` generated from the headers, to run the FSM tests on the host without a board.
+ *
+ * Every function of those headers is generated by `generate_fake_port.cmake` (see fake_port_functions.h, in the build directory). A fake records the call and its arguments in the history, then returns the next value of its script (`fake_port_script_returns()`) or its fixed value (`fake_port_set_return()`) if there is one, and otherwise runs its behaviour in fake_port_behaviour.c: the flags and the ticks of the sensors are kept as the drivers do, so what the FSMs set is what they get.
+ *
+ * There is no hardware time: the fake clock only moves with `fake_port_advance_us()`, `fake_port_advance_ms()` and the delays of the port. The time base of the software timers (`port_timer_hw_xxx()`) follows the fake clock, so the timers of the FSMs expire in order while the clock is advanced, and the interrupts raised inside a critical section are served when it ends, as in the NVIC. The logger and the telemetry are drained without a UART.
+ *
+ * @date 2025-01-01
+ */
+#ifndef FAKE_PORT_H_
+#define FAKE_PORT_H_
+
+/* Includes ------------------------------------------------------------------*/
+/* Standard C includes */
+#include <stdint.h>
+#include <stdbool.h>
+
+/* Fake port includes */
+#include "fake_port_functions.h"
+
+/* Defines and enums ----------------------------------------------------------*/
+#define FAKE_PORT_HISTORY_SIZE 1024U /*!< Last calls kept in the history */
+#define FAKE_PORT_SCRIPT_SIZE 16U    /*!< Maximum number of scripted return values of a function */
+#define FAKE_PORT_NUM_IDS 4U         /*!< Buttons and sensors with their own state */
+#define FAKE_PORT_CYCLES_PER_US 16U  /*!< Cycle counter of the fake clock, as the 16 MHz HSI of the STM32F4 */
+
+/* Typedefs --------------------------------------------------------------------*/
+/**
+ * @brief Call recorded in the history
+ */
+typedef struct
+{
+    uint32_t fn;                              /*!< Function called (`FAKE_PORT_FN_xxx`) */
+    uint32_t num_args;                        /*!< Number of arguments */
+    uintptr_t args_arr[FAKE_PORT_MAX_ARGS];   /*!< Arguments, converted to integers */
+    uint64_t time_us;                         /*!< Fake clock at the call */
+} fake_port_call_t;
+
+/* Function prototypes and explanation -------------------------------------------------*/
+/**
+ * @brief Reset the fake port: empty the history, remove the scripts and the fixed values, set the fake clock to 0 and reset the state of the buttons and sensors. Call it in `setUp()`.
+ */
+void fake_port_reset(void);
+
+/**
+ * @brief Empty the history and the counters of calls, but keep the clock, the scripts and the state.
+ */
+void fake_port_clear_calls(void);
+
+/**
+ * @brief Get the number of calls kept in the history. When the history is full the oldest calls are overwritten.
+ *
+ * @return Number of calls in the history (at most `FAKE_PORT_HISTORY_SIZE`)
+ */
+uint32_t fake_port_get_num_calls(void);
+
+/**
+ * @brief Get a call of the history, the oldest first.
+ *
+ * @param idx Index of the call
+ * @return Pointer to the call, or NULL if there is no such call
+ */
+const fake_port_call_t *fake_port_get_call(uint32_t idx);
+
+/**
+ * @brief Get the last call of a function.
+ *
+ * @param fn Function (`FAKE_PORT_FN_xxx`)
+ * @return Pointer to the call, or NULL if the function has not been called since the history was emptied
+ */
+const fake_port_call_t *fake_port_get_last_call(uint32_t fn);
+
+/**
+ * @brief Count the calls of a function since the history was emptied. It is not limited by the size of the history.
+ *
+ * @param fn Function (`FAKE_PORT_FN_xxx`)
+ * @return Number of calls
+ */
+uint32_t fake_port_count_calls(uint32_t fn);
+
+/**
+ * @brief Get the name of a function.
+ *
+ * @param fn Function (`FAKE_PORT_FN_xxx`)
+ * @return Name of the function, or "?" if `fn` is not valid
+ */
+const char *fake_port_get_name(uint32_t fn);
+
+/**
+ * @brief Queue the values returned by the next calls of a function, one per call, before its fixed value and its behaviour. The values are cast to the return type.
+ *
+ * @param fn Function (`FAKE_PORT_FN_xxx`)
+ * @param p_values Values to return
+ * @param num_values Number of values. Only the first `FAKE_PORT_SCRIPT_SIZE` queued values are kept
+ */
+void fake_port_script_returns(uint32_t fn, const uint32_t *p_values, uint32_t num_values);
+
+/**
+ * @brief Return a fixed value from every call of a function, instead of its behaviour, until the fake port is reset.
+ *
+ * @param fn Function (`FAKE_PORT_FN_xxx`)
+ * @param value Value to return
+ */
+void fake_port_set_return(uint32_t fn, uint32_t value);
+
+/**
+ * @brief Record a call in the history. It is called by the generated fakes.
+ *
+ * @param fn Function (`FAKE_PORT_FN_xxx`)
+ * @param p_args Arguments, converted to integers
+ * @param num_args Number of arguments
+ */
+void fake_port_record_call(uint32_t fn, const uintptr_t *p_args, uint32_t num_args);
+
+/**
+ * @brief Get the value to return from a call: the next scripted value or the fixed value. It is called by the generated fakes.
+ *
+ * @param fn Function (`FAKE_PORT_FN_xxx`)
+ * @param p_value Pointer to store the value. It is set to 0 if there is none
+ * @return true if there is a value to return, false if the behaviour must run
+ */
+bool fake_port_next_return(uint32_t fn, uint32_t *p_value);
+
+/**
+ * @brief Advance the fake clock. The software timers that expire meanwhile are served in time order, and a telemetry frame in flight is sent.
+ *
+ * @param us Microseconds to advance
+ */
+void fake_port_advance_us(uint32_t us);
+
+/**
+ * @brief Advance the fake clock in milliseconds (see `fake_port_advance_us()`).
+ *
+ * @param ms Milliseconds to advance
+ */
+void fake_port_advance_ms(uint32_t ms);
+
+/**
+ * @brief Get the fake clock.
+ *
+ * @return Time in microseconds since the last reset
+ */
+uint64_t fake_port_get_time_us(void);
+
+/**
+ * @brief Set the fake clock, without serving the timers. Used by `port_system_set_millis()`.
+ *
+ * @param time_us New time in microseconds
+ */
+void fake_port_set_time_us(uint64_t time_us);
+
+/**
+ * @brief Enter a critical section of the fake port. Used by `port_system_enter_critical()`.
+ */
+void fake_port_enter_critical(void);
+
+/**
+ * @brief Exit a critical section of the fake port. The interrupts raised inside the outermost section are served when it ends. Used by `port_system_exit_critical()`.
+ */
+void fake_port_exit_critical(void);
+
+/**
+ * @brief Get the nesting of the critical sections.
+ *
+ * @return Number of critical sections entered and not exited
+ */
+uint32_t fake_port_get_critical_nesting(void);
+
+/**
+ * @brief Check if the trigger timer of a fake sensor is running, as the enable bit of the timer in the device.
+ *
+ * @param ultrasound_id Ultrasound ID
+ * @return true if the trigger timer is running
+ */
+bool fake_port_get_trigger_timer_running(uint32_t ultrasound_id);
+
+/**
+ * @brief Check if the echo timer of a fake sensor is running, as the enable bit of the timer in the device.
+ *
+ * @param ultrasound_id Ultrasound ID
+ * @return true if the echo timer is running
+ */
+bool fake_port_get_echo_timer_running(uint32_t ultrasound_id);
+
+/**
+ * @brief Reset the state of the buttons and sensors kept by the behaviours. It is called by `fake_port_reset()`.
+ */
+void fake_port_behaviour_reset(void);
+
+#endif /* FAKE_PORT_H_ */
@@ -0,0 +1,300 @@
+/**
+ * @file fake_port.c
+ * @brief History of calls, scripted returns and fake clock of the fake port, and the hardware of the software timers, the logger and the telemetry on the fake clock.
+ * @date 2025-01-01
+ */
+
+/* Standard C includes */
+#include <stddef.h>
+#include <string.h>
+
+/* HW dependent includes */
+#include "port_timer.h"
+#include "port_log.h"
+#include "port_telemetry.h"
+#include "fake_port.h"
+
+/* Typedefs --------------------------------------------------------------------*/
+/**
+ * @brief Scripted and fixed return values of a function
+ */
+typedef struct
+{
+    uint32_t values_arr[FAKE_PORT_SCRIPT_SIZE]; /*!< Queued values */
+    uint32_t head;                              /*!< Next queued value */
+    uint32_t count;                             /*!< Queued values left */
+    uint32_t fixed_value;                       /*!< Value returned when the queue is empty */
+    bool fixed;                                 /*!< There is a fixed value */
+} fake_port_script_t;
+
+/* Global variables */
+extern const char *const fake_port_names_arr[FAKE_PORT_NUM_FUNCTIONS]; /*!< Names of the faked functions (fake_port_generated.c) */
+
+static fake_port_call_t history_arr[FAKE_PORT_HISTORY_SIZE]; /*!< Last calls */
+static uint32_t num_recorded = 0;                            /*!< Calls recorded since the history was emptied */
+static uint32_t calls_arr[FAKE_PORT_NUM_FUNCTIONS];          /*!< Calls of each function */
+static uint32_t last_call_arr[FAKE_PORT_NUM_FUNCTIONS];      /*!< Index + 1 of the last call of each function in `num_recorded` terms (0: none) */
+static fake_port_script_t scripts_arr[FAKE_PORT_NUM_FUNCTIONS]; /*!< Return values of each function */
+
+static uint64_t clock_us = 0;         /*!< Fake clock */
+static uint32_t critical_nesting = 0; /*!< Nesting of the critical sections */
+static bool in_irq = false;           /*!< The interrupt of the software timers is being served */
+static bool timer_irq_pending = false; /*!< The interrupt of the software timers is raised and not served yet */
+static bool alarm_enabled = false;    /*!< The compare match of the software timers is enabled */
+static uint32_t alarm_us = 0;         /*!< Compare match of the software timers */
+static bool tx_in_flight = false;     /*!< A telemetry frame is being sent */
+static port_timer_wheel_t wheel;      /*!< Wheel of the software timers */
+
+/* Private functions ----------------------------------------------------------*/
+/**
+ * @brief Serve the pending interrupts, unless they are masked by a critical section or one is already being served
+ */
+static void _fake_port_serve_irqs(void)
+{
+    if ((critical_nesting > 0U) || in_irq)
+    {
+        return;
+    }
+    in_irq = true;
+    while (timer_irq_pending)
+    {
+        timer_irq_pending = false;
+        port_timer_irq_handler(); /* It may raise the interrupt again if the next timer is already due */
+    }
+    in_irq = false;
+}
+
+/**
+ * @brief Raise the interrupt of the software timers
+ */
+static void _fake_port_raise_timer_irq(void)
+{
+    timer_irq_pending = true;
+    _fake_port_serve_irqs();
+}
+
+/* Public functions -----------------------------------------------------------*/
+void fake_port_reset(void)
+{
+    memset(scripts_arr, 0, sizeof(scripts_arr));
+    fake_port_clear_calls();
+    clock_us = 0;
+    critical_nesting = 0;
+    in_irq = false;
+    timer_irq_pending = false;
+    alarm_enabled = false;
+    tx_in_flight = false;
+    fake_port_behaviour_reset();
+}
+
+void fake_port_clear_calls(void)
+{
+    num_recorded = 0;
+    memset(calls_arr, 0, sizeof(calls_arr));
+    memset(last_call_arr, 0, sizeof(last_call_arr));
+}
+
+uint32_t fake_port_get_num_calls(void)
+{
+    return (num_recorded < FAKE_PORT_HISTORY_SIZE) ? num_recorded : FAKE_PORT_HISTORY_SIZE;
+}
+
+const fake_port_call_t *fake_port_get_call(uint32_t idx)
+{
+    uint32_t num_calls = fake_port_get_num_calls();
+    if (idx >= num_calls)
+    {
+        return NULL;
+    }
+    return &history_arr[(num_recorded - num_calls + idx) % FAKE_PORT_HISTORY_SIZE];
+}
+
+const fake_port_call_t *fake_port_get_last_call(uint32_t fn)
+{
+    if ((fn >= FAKE_PORT_NUM_FUNCTIONS) || (last_call_arr[fn] == 0U) || (num_recorded - last_call_arr[fn] >= FAKE_PORT_HISTORY_SIZE))
+    {
+        return NULL; /* Never called, or overwritten in the history */
+    }
+    return &history_arr[(last_call_arr[fn] - 1U) % FAKE_PORT_HISTORY_SIZE];
+}
+
+uint32_t fake_port_count_calls(uint32_t fn)
+{
+    return (fn < FAKE_PORT_NUM_FUNCTIONS) ? calls_arr[fn] : 0U;
+}
+
+const char *fake_port_get_name(uint32_t fn)
+{
+    return (fn < FAKE_PORT_NUM_FUNCTIONS) ? fake_port_names_arr[fn] : "?";
+}
+
+void fake_port_script_returns(uint32_t fn, const uint32_t *p_values, uint32_t num_values)
+{
+    if (fn >= FAKE_PORT_NUM_FUNCTIONS)
+    {
+        return;
+    }
+    fake_port_script_t *p_script = &scripts_arr[fn];
+    for (uint32_t i = 0; (i < num_values) && (p_script->count < FAKE_PORT_SCRIPT_SIZE); i++)
+    {
+        p_script->values_arr[(p_script->head + p_script->count) % FAKE_PORT_SCRIPT_SIZE] = p_values[i];
+        p_script->count++;
+    }
+}
+
+void fake_port_set_return(uint32_t fn, uint32_t value)
+{
+    if (fn < FAKE_PORT_NUM_FUNCTIONS)
+    {
+        scripts_arr[fn].fixed_value = value;
+        scripts_arr[fn].fixed = true;
+    }
+}
+
+void fake_port_record_call(uint32_t fn, const uintptr_t *p_args, uint32_t num_args)
+{
+    fake_port_call_t *p_call = &history_arr[num_recorded % FAKE_PORT_HISTORY_SIZE];
+    p_call->fn = fn;
+    p_call->num_args = num_args;
+    memset(p_call->args_arr, 0, sizeof(p_call->args_arr));
+    if (num_args > 0U)
+    {
+        memcpy(p_call->args_arr, p_args, num_args * sizeof(uintptr_t));
+    }
+    p_call->time_us = clock_us;
+    num_recorded++;
+    calls_arr[fn]++;
+    last_call_arr[fn] = num_recorded;
+}
+
+bool fake_port_next_return(uint32_t fn, uint32_t *p_value)
+{
+    fake_port_script_t *p_script = &scripts_arr[fn];
+    if (p_script->count > 0U)
+    {
+        *p_value = p_script->values_arr[p_script->head];
+        p_script->head = (p_script->head + 1U) % FAKE_PORT_SCRIPT_SIZE;
+        p_script->count--;
+        return true;
+    }
+    *p_value = p_script->fixed_value;
+    return p_script->fixed;
+}
+
+void fake_port_advance_us(uint32_t us)
+{
+    uint64_t target_us = clock_us + us;
+    if (tx_in_flight && (us > 0U))
+    {
+        tx_in_flight = false;
+        port_telemetry_tx_complete_irq_handler(); /* The frame takes less than the step */
+    }
+    while (alarm_enabled)
+    {
+        int32_t ahead = (int32_t)(alarm_us - (uint32_t)clock_us); /* The compare match is 32-bit, as the counter of the time base */
+        if ((ahead > 0) && ((uint64_t)ahead > target_us - clock_us))
+        {
+            break;
+        }
+        if (ahead > 0)
+        {
+            clock_us += (uint32_t)ahead;
+        }
+        alarm_enabled = false;
+        _fake_port_raise_timer_irq();
+        if (timer_irq_pending)
+        {
+            break; /* Masked by a critical section: served when it ends */
+        }
+    }
+    clock_us = target_us;
+}
+
+void fake_port_advance_ms(uint32_t ms)
+{
+    fake_port_advance_us(ms * 1000U);
+}
+
+uint64_t fake_port_get_time_us(void)
+{
+    return clock_us;
+}
+
+void fake_port_set_time_us(uint64_t time_us)
+{
+    clock_us = time_us;
+}
+
+void fake_port_enter_critical(void)
+{
+    critical_nesting++;
+}
+
+void fake_port_exit_critical(void)
+{
+    if (critical_nesting > 0U)
+    {
+        critical_nesting--;
+        _fake_port_serve_irqs();
+    }
+}
+
+uint32_t fake_port_get_critical_nesting(void)
+{
+    return critical_nesting;
+}
+
+/* Hardware of the platform-independent modules on the fake clock */
+void port_timer_hw_init(void)
+{
+    alarm_enabled = false;
+    timer_irq_pending = false;
+}
+
+uint32_t port_timer_hw_get_micros(void)
+{
+    return (uint32_t)clock_us;
+}
+
+void port_timer_hw_set_alarm(uint32_t at_us)
+{
+    alarm_us = at_us;
+    alarm_enabled = true;
+}
+
+void port_timer_hw_disable_alarm(void)
+{
+    alarm_enabled = false;
+}
+
+void port_timer_hw_trigger(void)
+{
+    _fake_port_raise_timer_irq();
+}
+
+port_timer_wheel_t *port_timer_hw_get_wheel(void)
+{
+    return &wheel;
+}
+
+void port_log_hw_init(void)
+{
+}
+
+uint32_t port_log_hw_write(const uint32_t *p_words, uint32_t num_words)
+{
+    (void)p_words;
+    return num_words; /* There is no UART: the records are drained and discarded */
+}
+
+void port_telemetry_hw_init(void)
+{
+    tx_in_flight = false;
+}
+
+void port_telemetry_hw_start_tx(const uint8_t *p_data, uint32_t length)
+{
+    (void)p_data;
+    (void)length;
+    tx_in_flight = true;
+}
@@ -0,0 +1,374 @@
+/**
+ * @file fake_port_behaviour.c
+ * @brief Behaviour of the fakes of `port_system.h`, `port_button.h` and `port_ultrasound.h`, run when a call has no scripted or fixed return value.
+ *
+ * `generate_fake_port.cmake` calls `fake_port_behaviour_<function>()` from the fake of each function defined here. The state is the one the drivers keep: the flags and the ticks of each sensor and the pressed flag of each button, so the setters of the tests reach the getters of the FSMs. The time comes from the fake clock. The measurement timer is a periodic software timer, as in the native port, and the trigger signal ends `PORT_PARKING_SENSOR_TRIGGER_UP_US` after it starts. The echo is not emulated: the tests set its ticks.
+ *
+ * The behaviours call the fake port directly, so that a call of the FSMs is recorded only once in the history.
+ *
+ * @date 2025-01-01
+ */
+
+/* Standard C includes */
+#include <stddef.h>
+
+/* HW dependent includes */
+#include "port_timer.h"
+#include "port_log.h"
+#include "fake_port.h"
+
+/* Typedefs --------------------------------------------------------------------*/
+/**
+ * @brief State of a fake button
+ */
+typedef struct
+{
+    bool pressed;           /*!< Pressed flag */
+    bool value;             /*!< Level of the GPIO (active low: true when released) */
+    bool pending_interrupt; /*!< Pending external interrupt */
+    bool interrupts_enabled; /*!< The external interrupt is enabled */
+} fake_port_button_t;
+
+/**
+ * @brief State of a fake ultrasound sensor
+ */
+typedef struct
+{
+    uint32_t echo_init_tick;      /*!< Tick of the rising edge of the echo */
+    uint32_t echo_end_tick;       /*!< Tick of the falling edge of the echo */
+    uint32_t echo_overflows;      /*!< Overflows of the echo timer */
+    bool echo_received;           /*!< The echo has been received */
+    bool trigger_ready;           /*!< A new measurement can start */
+    bool trigger_end;             /*!< The trigger signal has ended */
+    bool trigger_timer_en;        /*!< The trigger timer is running */
+    bool echo_timer_en;           /*!< The echo timer is running */
+    port_timer_t measurement_timer; /*!< Period of the measurements */
+    port_timer_t trigger_timer;   /*!< End of the trigger signal */
+} fake_port_ultrasound_t;
+
+/* Global variables */
+static fake_port_button_t buttons_arr[FAKE_PORT_NUM_IDS];         /*!< Fake buttons */
+static fake_port_ultrasound_t ultrasounds_arr[FAKE_PORT_NUM_IDS]; /*!< Fake ultrasound sensors */
+
+/* Private functions ----------------------------------------------------------*/
+/**
+ * @brief Get a fake button
+ * @param button_id Button ID
+ * @return Pointer to the button. An invalid ID gets the last one, so that a wrong call is recorded instead of crashing the test
+ */
+static fake_port_button_t *_fake_port_button(uint32_t button_id)
+{
+    return &buttons_arr[(button_id < FAKE_PORT_NUM_IDS) ? button_id : (FAKE_PORT_NUM_IDS - 1U)];
+}
+
+/**
+ * @brief Get a fake ultrasound sensor
+ * @param ultrasound_id Ultrasound ID
+ * @return Pointer to the sensor. An invalid ID gets the last one, so that a wrong call is recorded instead of crashing the test
+ */
+static fake_port_ultrasound_t *_fake_port_ultrasound(uint32_t ultrasound_id)
+{
+    return &ultrasounds_arr[(ultrasound_id < FAKE_PORT_NUM_IDS) ? ultrasound_id : (FAKE_PORT_NUM_IDS - 1U)];
+}
+
+/**
+ * @brief Callback of the measurement timer: a new measurement can start
+ * @param p_arg Pointer to the sensor
+ */
+static void _fake_port_measurement_timeout(void *p_arg)
+{
+    ((fake_port_ultrasound_t *)p_arg)->trigger_ready = true;
+}
+
+/**
+ * @brief Callback of the trigger timer: the trigger signal has ended
+ * @param p_arg Pointer to the sensor
+ */
+static void _fake_port_trigger_timeout(void *p_arg)
+{
+    fake_port_ultrasound_t *p_ultrasound = (fake_port_ultrasound_t *)p_arg;
+    if (p_ultrasound->trigger_timer_en)
+    {
+        p_ultrasound->trigger_end = true;
+    }
+}
+
+/**
+ * @brief Reset the ticks of the echo and the received flag of a sensor
+ * @param p_ultrasound Pointer to the sensor
+ */
+static void _fake_port_reset_echo_ticks(fake_port_ultrasound_t *p_ultrasound)
+{
+    p_ultrasound->echo_init_tick = 0;
+    p_ultrasound->echo_end_tick = 0;
+    p_ultrasound->echo_overflows = 0;
+    p_ultrasound->echo_received = false;
+}
+
+/* Public functions -----------------------------------------------------------*/
+void fake_port_behaviour_reset(void)
+{
+    port_timer_init(); /* The timers of a previous test are not armed anymore */
+    for (uint32_t i = 0; i < FAKE_PORT_NUM_IDS; i++)
+    {
+        buttons_arr[i] = (fake_port_button_t){.value = true};
+        ultrasounds_arr[i] = (fake_port_ultrasound_t){.trigger_ready = true};
+        port_timer_setup(&ultrasounds_arr[i].measurement_timer, _fake_port_measurement_timeout, &ultrasounds_arr[i]);
+        port_timer_setup(&ultrasounds_arr[i].trigger_timer, _fake_port_trigger_timeout, &ultrasounds_arr[i]);
+    }
+}
+
+bool fake_port_get_trigger_timer_running(uint32_t ultrasound_id)
+{
+    return _fake_port_ultrasound(ultrasound_id)->trigger_timer_en;
+}
+
+bool fake_port_get_echo_timer_running(uint32_t ultrasound_id)
+{
+    return _fake_port_ultrasound(ultrasound_id)->echo_timer_en;
+}
+
+/* System */
+uint32_t fake_port_behaviour_port_system_init(void)
+{
+    port_timer_init();
+    port_log_init();
+    return 0;
+}
+
+uint32_t fake_port_behaviour_port_system_get_millis(void)
+{
+    return (uint32_t)(fake_port_get_time_us() / 1000U);
+}
+
+void fake_port_behaviour_port_system_set_millis(uint32_t ms)
+{
+    fake_port_set_time_us((uint64_t)ms * 1000U);
+}
+
+void fake_port_behaviour_port_system_delay_ms(uint32_t ms)
+{
+    fake_port_advance_ms(ms);
+}
+
+void fake_port_behaviour_port_system_delay_until_ms(uint32_t *p_t, uint32_t ms)
+{
+    uint32_t until = *p_t + ms;
+    uint32_t now = fake_port_behaviour_port_system_get_millis();
+    if (until > now)
+    {
+        fake_port_advance_ms(until - now);
+    }
+    *p_t = fake_port_behaviour_port_system_get_millis();
+}
+
+void fake_port_behaviour_port_system_sleep(void)
+{
+    fake_port_advance_ms(1); /* The next interrupt is the System tick at the latest */
+}
+
+uint32_t fake_port_behaviour_port_system_get_cycles(void)
+{
+    return (uint32_t)(fake_port_get_time_us() * FAKE_PORT_CYCLES_PER_US);
+}
+
+uint32_t fake_port_behaviour_port_system_get_cycles_per_us(void)
+{
+    return FAKE_PORT_CYCLES_PER_US;
+}
+
+void fake_port_behaviour_port_system_enter_critical(void)
+{
+    fake_port_enter_critical();
+}
+
+void fake_port_behaviour_port_system_exit_critical(void)
+{
+    fake_port_exit_critical();
+}
+
+void fake_port_behaviour_port_system_disable_interrupts(void)
+{
+    fake_port_enter_critical(); /* The critical sections of the fake port mask all the interrupts */
+}
+
+void fake_port_behaviour_port_system_enable_interrupts(void)
+{
+    fake_port_exit_critical();
+}
+
+/* Button */
+void fake_port_behaviour_port_button_init(uint32_t button_id)
+{
+    fake_port_button_t *p_button = _fake_port_button(button_id);
+    p_button->pressed = false;
+    p_button->pending_interrupt = false;
+    p_button->interrupts_enabled = true;
+}
+
+bool fake_port_behaviour_port_button_get_pressed(uint32_t button_id)
+{
+    return _fake_port_button(button_id)->pressed;
+}
+
+bool fake_port_behaviour_port_button_get_value(uint32_t button_id)
+{
+    return _fake_port_button(button_id)->value;
+}
+
+void fake_port_behaviour_port_button_set_pressed(uint32_t button_id, bool pressed)
+{
+    fake_port_button_t *p_button = _fake_port_button(button_id);
+    p_button->pressed = pressed;
+    p_button->value = !pressed; /* Active low */
+}
+
+bool fake_port_behaviour_port_button_get_pending_interrupt(uint32_t button_id)
+{
+    return _fake_port_button(button_id)->pending_interrupt;
+}
+
+void fake_port_behaviour_port_button_clear_pending_interrupt(uint32_t button_id)
+{
+    _fake_port_button(button_id)->pending_interrupt = false;
+}
+
+void fake_port_behaviour_port_button_disable_interrupts(uint32_t button_id)
+{
+    _fake_port_button(button_id)->interrupts_enabled = false;
+}
+
+/* Ultrasound */
+uint32_t fake_port_behaviour_port_ultrasound_get_echo_end_tick(uint32_t ultrasound_id)
+{
+    return _fake_port_ultrasound(ultrasound_id)->echo_end_tick;
+}
+
+uint32_t fake_port_behaviour_port_ultrasound_get_echo_init_tick(uint32_t ultrasound_id)
+{
+    return _fake_port_ultrasound(ultrasound_id)->echo_init_tick;
+}
+
+uint32_t fake_port_behaviour_port_ultrasound_get_echo_overflows(uint32_t ultrasound_id)
+{
+    return _fake_port_ultrasound(ultrasound_id)->echo_overflows;
+}
+
+void fake_port_behaviour_port_ultrasound_set_echo_overflows(uint32_t ultrasound_id, uint32_t echo_overflows)
+{
+    _fake_port_ultrasound(ultrasound_id)->echo_overflows = echo_overflows;
+}
+
+bool fake_port_behaviour_port_ultrasound_get_echo_received(uint32_t ultrasound_id)
+{
+    return _fake_port_ultrasound(ultrasound_id)->echo_received;
+}
+
+bool fake_port_behaviour_port_ultrasound_get_trigger_end(uint32_t ultrasound_id)
+{
+    return _fake_port_ultrasound(ultrasound_id)->trigger_end;
+}
+
+bool fake_port_behaviour_port_ultrasound_get_trigger_ready(uint32_t ultrasound_id)
+{
+    return _fake_port_ultrasound(ultrasound_id)->trigger_ready;
+}
+
+void fake_port_behaviour_port_ultrasound_init(uint32_t ultrasound_id)
+{
+    fake_port_ultrasound_t *p_ultrasound = _fake_port_ultrasound(ultrasound_id);
+    _fake_port_reset_echo_ticks(p_ultrasound);
+    p_ultrasound->trigger_ready = true;
+    p_ultrasound->trigger_end = false;
+    p_ultrasound->trigger_timer_en = false;
+    p_ultrasound->echo_timer_en = false;
+    port_timer_cancel(&p_ultrasound->measurement_timer);
+    port_timer_cancel(&p_ultrasound->trigger_timer);
+}
+
+void fake_port_behaviour_port_ultrasound_reset_echo_ticks(uint32_t ultrasound_id)
+{
+    _fake_port_reset_echo_ticks(_fake_port_ultrasound(ultrasound_id));
+}
+
+void fake_port_behaviour_port_ultrasound_set_echo_end_tick(uint32_t ultrasound_id, uint32_t echo_end_tick)
+{
+    _fake_port_ultrasound(ultrasound_id)->echo_end_tick = echo_end_tick;
+}
+
+void fake_port_behaviour_port_ultrasound_set_echo_init_tick(uint32_t ultrasound_id, uint32_t echo_init_tick)
+{
+    _fake_port_ultrasound(ultrasound_id)->echo_init_tick = echo_init_tick;
+}
+
+void fake_port_behaviour_port_ultrasound_set_echo_received(uint32_t ultrasound_id, bool echo_received)
+{
+    _fake_port_ultrasound(ultrasound_id)->echo_received = echo_received;
+}
+
+void fake_port_behaviour_port_ultrasound_set_trigger_end(uint32_t ultrasound_id, bool trigger_end)
+{
+    _fake_port_ultrasound(ultrasound_id)->trigger_end = trigger_end;
+}
+
+void fake_port_behaviour_port_ultrasound_set_trigger_ready(uint32_t ultrasound_id, bool trigger_ready)
+{
+    _fake_port_ultrasound(ultrasound_id)->trigger_ready = trigger_ready;
+}
+
+void fake_port_behaviour_port_ultrasound_start_measurement(uint32_t ultrasound_id)
+{
+    fake_port_ultrasound_t *p_ultrasound = _fake_port_ultrasound(ultrasound_id);
+    fake_port_enter_critical();
+    p_ultrasound->trigger_ready = false;
+    p_ultrasound->trigger_end = false;
+    p_ultrasound->trigger_timer_en = true;
+    p_ultrasound->echo_timer_en = true;
+    port_timer_start(&p_ultrasound->trigger_timer, (uint32_t)PORT_PARKING_SENSOR_TRIGGER_UP_US, 0);
+    port_timer_start(&p_ultrasound->measurement_timer, PORT_PARKING_SENSOR_TIMEOUT_US, PORT_PARKING_SENSOR_TIMEOUT_US);
+    fake_port_exit_critical();
+}
+
+uint32_t fake_port_behaviour_port_ultrasound_start_new_measurement_timer(void)
+{
+    for (uint32_t i = 0; i < FAKE_PORT_NUM_IDS; i++)
+    {
+        port_timer_start(&ultrasounds_arr[i].measurement_timer, PORT_PARKING_SENSOR_TIMEOUT_US, PORT_PARKING_SENSOR_TIMEOUT_US);
+    }
+    return 0;
+}
+
+bool fake_port_behaviour_port_ultrasound_get_measurement_timer_running(uint32_t ultrasound_id)
+{
+    return port_timer_is_armed(&_fake_port_ultrasound(ultrasound_id)->measurement_timer);
+}
+
+void fake_port_behaviour_port_ultrasound_stop_echo_timer(uint32_t ultrasound_id)
+{
+    _fake_port_ultrasound(ultrasound_id)->echo_timer_en = false;
+}
+
+void fake_port_behaviour_port_ultrasound_stop_new_measurement_timer(void)
+{
+    for (uint32_t i = 0; i < FAKE_PORT_NUM_IDS; i++)
+    {
+        port_timer_cancel(&ultrasounds_arr[i].measurement_timer);
+    }
+}
+
+void fake_port_behaviour_port_ultrasound_stop_trigger_timer(uint32_t ultrasound_id)
+{
+    fake_port_ultrasound_t *p_ultrasound = _fake_port_ultrasound(ultrasound_id);
+    p_ultrasound->trigger_timer_en = false;
+    port_timer_cancel(&p_ultrasound->trigger_timer);
+}
+
+void fake_port_behaviour_port_ultrasound_stop_ultrasound(uint32_t ultrasound_id)
+{
+    fake_port_enter_critical();
+    fake_port_behaviour_port_ultrasound_stop_trigger_timer(ultrasound_id);
+    fake_port_behaviour_port_ultrasound_stop_new_measurement_timer();
+    fake_port_behaviour_port_ultrasound_stop_echo_timer(ultrasound_id);
+    _fake_port_reset_echo_ticks(_fake_port_ultrasound(ultrasound_id));
+    fake_port_exit_critical();
+}
@@ -9,12 +9,11 @@
 /*Standard C includes*/
 #include <stdint.h>
 #include <stdbool.h>
-#include "stm32f4xx.h"
 
  /* Defines and enums*/
  /*Defines*/
 #define PORT_PARKING_BUTTON_ID 0
-#define PORT_PARKING_BUTTON_DEBOUNCE_TIME_MS
+#define PORT_PARKING_BUTTON_DEBOUNCE_TIME_MS 100
 
 /*Function prototypes ------------------------------*/
 
@@ -0,0 +1,93 @@
+/**
+ * @file port_debounce.h
+ * @brief Header for the portable functions of the multi-key debounce engine. The functions must be implemented in the platform-specific code.
+ *
+ * The engine samples whole GPIO input words every `PORT_DEBOUNCE_PERIOD_MS` from a single timer tick and debounces all the keys of a word in parallel with a 2-bit vertical counter: a key changes its debounced state after 4 consecutive samples with the new level. There are no per-key branches, so the cost per tick does not depend on the number of keys. Every change of the debounced state is queued as a press or release event with its timestamp.
+ *
+ * @date 2025-01-01
+ */
+#ifndef PORT_DEBOUNCE_H_
+#define PORT_DEBOUNCE_H_
+
+/* Includes ------------------------------------------------------------------*/
+/* Standard C includes */
+#include <stdint.h>
+#include <stdbool.h>
+
+/* Defines and enums ----------------------------------------------------------*/
+#define PORT_DEBOUNCE_MAX_KEYS 16U    /*!< Maximum number of keys handled by the engine */
+#define PORT_DEBOUNCE_PERIOD_MS 5U    /*!< Sampling period. The debounce time is 4 periods */
+#define PORT_DEBOUNCE_QUEUE_SIZE 32U  /*!< Number of events that can be queued. It must be a power of 2 */
+
+/* Typedefs --------------------------------------------------------------------*/
+/**
+ * @brief Press or release event of a debounced key
+ */
+typedef struct
+{
+    uint32_t timestamp_ms; /*!< System time when the debounced state changed */
+    uint8_t key_id;        /*!< Key ID */
+    bool pressed;          /*!< true for a press, false for a release */
+} port_debounce_event_t;
+
+/**
+ * @brief State of a 2-bit vertical counter for up to 32 inputs
+ */
+typedef struct
+{
+    uint32_t ct0;   /*!< Bit 0 of the counter of each input */
+    uint32_t ct1;   /*!< Bit 1 of the counter of each input */
+    uint32_t state; /*!< Debounced state of each input (1: pressed) */
+} port_debounce_vcnt_t;
+
+/* Function prototypes and explanation -------------------------------------------------*/
+/**
+ * @brief Debounce a sample of up to 32 inputs in parallel.
+ *
+ * Each input has a 2-bit counter spread over `ct0` and `ct1`. The counter of an input is reset to 3 while its sample equals its debounced state and counts down otherwise; when it rolls over, the debounced state toggles.
+ *
+ * @note The counters must start at 3: `ct0` and `ct1` initialized to all ones.
+ *
+ * @param p_vcnt Pointer to the vertical counter
+ * @param sample Sampled inputs (1: pressed)
+ * @return Mask of the inputs whose debounced state has toggled
+ */
+static inline uint32_t port_debounce_vcnt_step(port_debounce_vcnt_t *p_vcnt, uint32_t sample)
+{
+    uint32_t changed = p_vcnt->state ^ sample;
+    p_vcnt->ct0 = ~(p_vcnt->ct0 & changed);
+    p_vcnt->ct1 = p_vcnt->ct0 ^ (p_vcnt->ct1 & changed);
+    changed &= p_vcnt->ct0 & p_vcnt->ct1;
+    p_vcnt->state ^= changed;
+    return changed;
+}
+
+/**
+ * @brief Configure the GPIOs of all the keys and start the debounce engine
+ */
+void port_debounce_init(void);
+
+/**
+ * @brief Get the oldest press or release event and remove it from the queue
+ *
+ * @param p_event Pointer to store the event
+ * @return true if there was an event, false if the queue was empty
+ */
+bool port_debounce_get_event(port_debounce_event_t *p_event);
+
+/**
+ * @brief Get the debounced state of a key
+ *
+ * @param key_id Key ID. This index is used to select the element of the keys_arr[] array
+ * @return true if the key is pressed
+ */
+bool port_debounce_get_pressed(uint32_t key_id);
+
+/**
+ * @brief Get the number of events lost because the queue was full
+ *
+ * @return Number of events lost since the engine was started
+ */
+uint32_t port_debounce_get_dropped_events(void);
+
+#endif /* PORT_DEBOUNCE_H_ */
@@ -0,0 +1,112 @@
+/**
+ * @file port_isr_stats.h
+ * @brief Header for the latency and duration statistics of the interrupt service routines.
+ *
+ * When the project is configured with `-DISR_STATS=ON`, every ISR of interr.c calls `PORT_ISR_STATS_ENTER()` first and `PORT_ISR_STATS_EXIT()` last. The entry and the exit are timestamped with `port_system_get_cycles()` (DWT CYCCNT in the STM32F4). The latency from the hardware event to the first instruction of the handler is derived from the counter of the peripheral that raised it, read at the entry (the counter of TIM3 and TIM5, `SysTick->VAL`). A register that must be read only once, as the capture register of TIM2 (reading it clears its flag), is read where the handler uses it, and its latency is given afterwards with `PORT_ISR_STATS_LATENCY()`. The EXTI and DMA interrupts have no such counter, so only their duration is measured.
+ *
+ * For each ISR, the latency and the duration are bucketed into log2 histograms: the bucket `b` counts the values from 2^(b-1) to 2^b - 1 cycles, and the bucket 0 the values of 0 cycles. The duration excludes the time spent in other instrumented ISRs that preempted the handler. Those preemptions are counted, and the worst response time (latency plus duration with preemptions) is kept. The statistics are in the global `port_isr_stats_arr`, so they can be read with a debugger while the system runs, and `port_isr_stats_dump()` sends them through the deferred logger.
+ *
+ * Without `PORT_ISR_STATS` the macros expand to nothing and the ISRs are not instrumented.
+ *
+ * @date 2025-01-01
+ */
+#ifndef PORT_ISR_STATS_H_
+#define PORT_ISR_STATS_H_
+
+/* Includes ------------------------------------------------------------------*/
+/* Standard C includes */
+#include <stdint.h>
+
+/* Defines and enums ----------------------------------------------------------*/
+#define PORT_ISR_STATS_NUM_BUCKETS 32U         /*!< Buckets of the histograms. The last one also counts the longer values */
+#define PORT_ISR_STATS_NO_LATENCY UINT32_MAX /*!< Latency of an interrupt without a counter of its hardware event */
+
+/**
+ * @brief Identifiers of the instrumented ISRs
+ */
+enum PORT_ISR_ID
+{
+    PORT_ISR_ID_SYSTICK = 0, /*!< System tick */
+    PORT_ISR_ID_BUTTON,      /*!< External interrupt of the buttons */
+    PORT_ISR_ID_ECHO,        /*!< Echo capture timer (TIM2) */
+    PORT_ISR_ID_TRIGGER,     /*!< Trigger timer (TIM3) */
+    PORT_ISR_ID_TIMER,       /*!< Time base of the software timers (TIM5) */
+    PORT_ISR_ID_TELEMETRY,   /*!< End of the transmission of a telemetry frame (DMA1 stream 6) */
+    PORT_ISR_NUM_IDS         /*!< Number of instrumented ISRs */
+};
+
+/* Typedefs --------------------------------------------------------------------*/
+/**
+ * @brief Statistics of an ISR, in counts of `port_system_get_cycles()`
+ */
+typedef struct
+{
+    uint32_t calls;                                           /*!< Number of executions */
+    uint32_t preemptions;                                     /*!< Executions of other instrumented ISRs while this one was running */
+    uint32_t max_latency_cycles;                              /*!< Worst latency from the hardware event to the entry */
+    uint32_t max_duration_cycles;                             /*!< Worst execution time, without the preemptions */
+    uint32_t max_response_cycles;                             /*!< Worst latency plus execution time with the preemptions */
+    uint32_t latency_hist_arr[PORT_ISR_STATS_NUM_BUCKETS];  /*!< Histogram of the latency */
+    uint32_t duration_hist_arr[PORT_ISR_STATS_NUM_BUCKETS]; /*!< Histogram of the execution time */
+} port_isr_stats_t;
+
+extern volatile port_isr_stats_t port_isr_stats_arr[PORT_ISR_NUM_IDS]; /*!< Statistics of each ISR */
+
+/* Macros ----------------------------------------------------------------------*/
+#ifdef PORT_ISR_STATS
+#define PORT_ISR_STATS_ENTER(isr_id, latency_cycles) port_isr_stats_enter((isr_id), (latency_cycles)) /*!< Entry of an ISR. It must be the first statement of the handler */
+#define PORT_ISR_STATS_LATENCY(isr_id, latency_cycles) port_isr_stats_latency((isr_id), (latency_cycles)) /*!< Latency of an ISR known after its entry. It must be between the entry and the exit */
+#define PORT_ISR_STATS_EXIT(isr_id) port_isr_stats_exit(isr_id)                                        /*!< Exit of an ISR. It must be the last statement of the handler */
+#else
+#define PORT_ISR_STATS_ENTER(isr_id, latency_cycles) ((void)0)
+#define PORT_ISR_STATS_LATENCY(isr_id, latency_cycles) ((void)0)
+#define PORT_ISR_STATS_EXIT(isr_id) ((void)0)
+#endif
+
+/* Function prototypes and explanation -------------------------------------------------*/
+/**
+ * @brief Account the entry of an ISR. Use `PORT_ISR_STATS_ENTER()` instead.
+ *
+ * @param isr_id Identifier of the ISR (`PORT_ISR_ID_xxx`)
+ * @param latency_cycles Cycles from the hardware event to the entry, or `PORT_ISR_STATS_NO_LATENCY`
+ */
+void port_isr_stats_enter(uint32_t isr_id, uint32_t latency_cycles);
+
+/**
+ * @brief Give the latency of the ISR that is running, when its hardware event is only known after the entry. Use `PORT_ISR_STATS_LATENCY()` instead.
+ *
+ * The time since the entry is subtracted, so the latency is the one of the entry. If the ISR already has a latency, the worst one is kept: the interrupt was raised by its oldest event.
+ *
+ * @param isr_id Identifier of the ISR (`PORT_ISR_ID_xxx`). It must be the last one entered
+ * @param latency_cycles Cycles from the hardware event to now
+ */
+void port_isr_stats_latency(uint32_t isr_id, uint32_t latency_cycles);
+
+/**
+ * @brief Account the exit of an ISR. Use `PORT_ISR_STATS_EXIT()` instead.
+ *
+ * @param isr_id Identifier of the ISR (`PORT_ISR_ID_xxx`). It must be the last one entered
+ */
+void port_isr_stats_exit(uint32_t isr_id);
+
+/**
+ * @brief Get the bucket of the histograms of a value.
+ *
+ * @param cycles Value
+ * @return Bucket, from 0 to `PORT_ISR_STATS_NUM_BUCKETS - 1`
+ */
+uint32_t port_isr_stats_get_bucket(uint32_t cycles);
+
+/**
+ * @brief Send the statistics of the ISRs that have run through the deferred logger and flush it.
+ *
+ * For each ISR: the calls and preemptions, the worst latency, duration and response time, and the non-empty buckets of the histograms.
+ */
+void port_isr_stats_dump(void);
+
+/**
+ * @brief Clear the statistics of all the ISRs. An ISR that is running at the same time may leave a partial update.
+ */
+void port_isr_stats_reset(void);
+
+#endif /* PORT_ISR_STATS_H_ */
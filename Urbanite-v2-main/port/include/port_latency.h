@@ -0,0 +1,147 @@
+/**
+ * @file port_latency.h
+ * @brief Header for the end-to-end latency tracing of the measurements of the ultrasound sensors.
+ *
+ * When the project is configured with `-DLATENCY_TRACE=ON`, `PORT_LATENCY_MARK()` timestamps the life of each measurement with `port_timer_get_micros()`. The trace points are:
+ * the start of the trigger, the capture of the rising and the falling edges of the echo, the entry to `SET_DISTANCE` of the ultrasound FSM, the median ready, and the application reading the distance.
+ * The edges of the echo are timestamped at the capture, not at the ISR: the ISR subtracts the time elapsed since the capture, read from the echo timer.
+ *
+ * The trigger opens a record with a new sequence number. The following points of the same sensor are added to that record. The median ready hands the record over to the application, and the consumption closes it. Then the duration of each stage of the record is added to the statistics. A measurement that does not produce a median, or whose median is never read, is discarded by the next trigger or the next median. The records of the consumed measurements are available with `port_latency_get_last()`. The percentiles of each stage, over the last `PORT_LATENCY_WINDOW` measurements, are available with `port_latency_get_summary()`. With `PORT_LOG_LEVEL_DEBUG`, the trace points of every consumed measurement are also logged with its sequence number when the application reads the distance.
+ *
+ * Without `PORT_LATENCY_TRACE` the macros expand to nothing and their arguments are not evaluated.
+ *
+ * In the native port the time is virtual, so the stages show the delays of the emulated interrupts and of the polling of the FSMs with a resolution of 1 ms.
+ *
+ * @date 2025-01-01
+ */
+#ifndef PORT_LATENCY_H_
+#define PORT_LATENCY_H_
+
+/* Includes ------------------------------------------------------------------*/
+/* Standard C includes */
+#include <stdint.h>
+#include <stdbool.h>
+
+/* Defines and enums ----------------------------------------------------------*/
+#define PORT_LATENCY_MAX_SENSORS 4U /*!< Sensors that can be traced */
+#define PORT_LATENCY_WINDOW 64U     /*!< Measurements of each stage kept for the percentiles */
+
+/**
+ * @brief Trace points of a measurement, in chronological order
+ */
+enum PORT_LATENCY_POINT
+{
+    PORT_LATENCY_TRIGGER_START = 0, /*!< The trigger signal is raised */
+    PORT_LATENCY_ECHO_RISE,         /*!< Capture of the rising edge of the echo */
+    PORT_LATENCY_ECHO_FALL,         /*!< Capture of the falling edge of the echo: the physical echo has been received */
+    PORT_LATENCY_SET_DISTANCE,      /*!< The ultrasound FSM enters `SET_DISTANCE` */
+    PORT_LATENCY_MEDIAN_READY,      /*!< The median of the distances is available */
+    PORT_LATENCY_CONSUMED,          /*!< The application reads the distance */
+    PORT_LATENCY_NUM_POINTS         /*!< Number of trace points */
+};
+
+/**
+ * @brief Stages of the latency budget
+ */
+enum PORT_LATENCY_STAGE
+{
+    PORT_LATENCY_STAGE_TRIGGER_TO_ECHO = 0, /*!< From the trigger to the rising edge of the echo */
+    PORT_LATENCY_STAGE_FLIGHT,              /*!< Width of the echo: time of flight of the sound */
+    PORT_LATENCY_STAGE_CAPTURE_TO_FSM,      /*!< From the falling edge to the ultrasound FSM */
+    PORT_LATENCY_STAGE_FILTER,              /*!< Computation of the distance and the median */
+    PORT_LATENCY_STAGE_DELIVERY,            /*!< From the median to the application */
+    PORT_LATENCY_STAGE_ECHO_TO_RESULT,      /*!< End to end: from the physical echo to the application */
+    PORT_LATENCY_NUM_STAGES                 /*!< Number of stages */
+};
+
+/* Typedefs --------------------------------------------------------------------*/
+/**
+ * @brief Trace of a measurement
+ */
+typedef struct
+{
+    uint32_t seq;                            /*!< Sequence number of the measurement */
+    uint32_t marks;                          /*!< Bitmap of the trace points reached (bit `PORT_LATENCY_xxx`) */
+    uint32_t t_us_arr[PORT_LATENCY_NUM_POINTS]; /*!< Time of each trace point in microseconds */
+} port_latency_record_t;
+
+/**
+ * @brief Statistics of a stage, in microseconds
+ */
+typedef struct
+{
+    uint32_t count;  /*!< Measurements accounted since the last reset */
+    uint32_t min_us; /*!< Minimum of the window */
+    uint32_t p50_us; /*!< Median of the window */
+    uint32_t p90_us; /*!< 90th percentile of the window */
+    uint32_t p99_us; /*!< 99th percentile of the window */
+    uint32_t max_us; /*!< Maximum of the window */
+    uint32_t worst_us; /*!< Maximum since the last reset */
+} port_latency_summary_t;
+
+/* Macros ----------------------------------------------------------------------*/
+#ifdef PORT_LATENCY_TRACE
+#define PORT_LATENCY_MARK(sensor_id, point) port_latency_mark((sensor_id), (point))                  /*!< Timestamp a trace point now */
+#define PORT_LATENCY_MARK_AT(sensor_id, point, t_us) port_latency_mark_at((sensor_id), (point), (t_us)) /*!< Timestamp a trace point that happened at a given time */
+#else
+#define PORT_LATENCY_MARK(sensor_id, point) ((void)0)
+#define PORT_LATENCY_MARK_AT(sensor_id, point, t_us) ((void)0)
+#endif
+
+/* Function prototypes and explanation -------------------------------------------------*/
+/**
+ * @brief Timestamp a trace point of the current measurement of a sensor with the current time. Use `PORT_LATENCY_MARK()` instead.
+ *
+ * @param sensor_id Identifier of the sensor
+ * @param point Trace point (`PORT_LATENCY_xxx`)
+ */
+void port_latency_mark(uint32_t sensor_id, uint32_t point);
+
+/**
+ * @brief Timestamp a trace point of the current measurement of a sensor. Use `PORT_LATENCY_MARK_AT()` instead.
+ *
+ * @param sensor_id Identifier of the sensor
+ * @param point Trace point (`PORT_LATENCY_xxx`)
+ * @param t_us Time of the event in microseconds of `port_timer_get_micros()`
+ */
+void port_latency_mark_at(uint32_t sensor_id, uint32_t point, uint32_t t_us);
+
+/**
+ * @brief Get the trace of the last measurement of a sensor consumed by the application.
+ *
+ * @param sensor_id Identifier of the sensor
+ * @param p_record Pointer to copy the trace
+ * @return true if a measurement of the sensor has been consumed
+ */
+bool port_latency_get_last(uint32_t sensor_id, port_latency_record_t *p_record);
+
+/**
+ * @brief Get the duration of a stage of a measurement.
+ *
+ * @param p_record Pointer to the trace of the measurement
+ * @param stage Stage (`PORT_LATENCY_STAGE_xxx`)
+ * @param p_us Pointer to store the duration in microseconds
+ * @return true if the measurement reached both ends of the stage
+ */
+bool port_latency_get_stage(const port_latency_record_t *p_record, uint32_t stage, uint32_t *p_us);
+
+/**
+ * @brief Get the percentiles of a stage over the last `PORT_LATENCY_WINDOW` consumed measurements.
+ *
+ * @param stage Stage (`PORT_LATENCY_STAGE_xxx`)
+ * @param p_summary Pointer to store the statistics
+ * @return true if the stage has been measured at least once
+ */
+bool port_latency_get_summary(uint32_t stage, port_latency_summary_t *p_summary);
+
+/**
+ * @brief Send the statistics of every stage through the deferred logger and flush it.
+ */
+void port_latency_dump(void);
+
+/**
+ * @brief Discard the records and the statistics. The sequence numbers start again from 1.
+ */
+void port_latency_reset(void);
+
+#endif /* PORT_LATENCY_H_ */
@@ -0,0 +1,137 @@
+/**
+ * @file port_log.h
+ * @brief Header for the deferred binary logger of the port layer.
+ *
+ * A log call does not format any text: it copies the ID of the message, a timestamp and the raw arguments into a RAM ring buffer inside a short critical section, so it can be used from the FSMs and from the ISRs without disturbing their timing. The records are sent later, from the idle loop, by `port_log_flush()` through the platform-specific drain (ITM/SWO in the STM32F4, a file in the native port). The ring buffer `port_log_buffer` can also be dumped with a debugger. The host decoder (tools/log_decoder) rebuilds the text with the catalog of port_log_messages.h.
+ *
+ * The macros `PORT_LOG_ERROR()`, `PORT_LOG_WARN()`, `PORT_LOG_INFO()` and `PORT_LOG_DEBUG()` take the ID of a message followed by up to `PORT_LOG_MAX_ARGS` integer arguments. The messages above `PORT_LOG_LEVEL` are removed at compile time, and their arguments are not evaluated.
+ *
+ * Each record is made of 32-bit words: a header (`PORT_LOG_SYNC` in bits 31-24, number of arguments in bits 23-21, level in bits 20-18 and ID in bits 15-0), the timestamp in microseconds of `port_timer_get_micros()` and the arguments.
+ *
+ * @date 2025-01-01
+ */
+#ifndef PORT_LOG_H_
+#define PORT_LOG_H_
+
+/* Includes ------------------------------------------------------------------*/
+/* Standard C includes */
+#include <stdint.h>
+
+/* HW dependent includes */
+#include "port_log_messages.h"
+
+/* Defines and enums ----------------------------------------------------------*/
+#define PORT_LOG_LEVEL_NONE 0U  /*!< Logging disabled */
+#define PORT_LOG_LEVEL_ERROR 1U /*!< Errors */
+#define PORT_LOG_LEVEL_WARN 2U  /*!< Warnings */
+#define PORT_LOG_LEVEL_INFO 3U  /*!< Information */
+#define PORT_LOG_LEVEL_DEBUG 4U /*!< Debug traces */
+
+#ifndef PORT_LOG_LEVEL
+#define PORT_LOG_LEVEL PORT_LOG_LEVEL_INFO /*!< Maximum level compiled in. It can be overridden with -DLOG_LEVEL=<level> in CMake */
+#endif
+
+#define PORT_LOG_MAX_ARGS 4U                  /*!< Maximum number of arguments of a message */
+#define PORT_LOG_BUFFER_WORDS 256U            /*!< Size of the ring buffer in 32-bit words. It must be a power of 2 */
+#define PORT_LOG_MAGIC 0x474F4C55U            /*!< Marks the ring buffer in a memory dump ("ULOG") */
+#define PORT_LOG_SYNC 0xA5U                   /*!< First byte of the header of every record */
+#define PORT_LOG_HEADER_WORDS 2U              /*!< Header and timestamp */
+
+#define PORT_LOG_HEADER(level, id, nargs) (((uint32_t)PORT_LOG_SYNC << 24) | (((uint32_t)(nargs) & 0x7U) << 21) | (((uint32_t)(level) & 0x7U) << 18) | ((uint32_t)(id) & 0xFFFFU)) /*!< Build the header of a record */
+#define PORT_LOG_HEADER_IS_VALID(header) (((header) >> 24) == PORT_LOG_SYNC)                                                                                                 /*!< Check the sync byte of a header */
+#define PORT_LOG_HEADER_NARGS(header) (((header) >> 21) & 0x7U)                                                                                                               /*!< Number of arguments of a record */
+#define PORT_LOG_HEADER_LEVEL(header) (((header) >> 18) & 0x7U)                                                                                                               /*!< Level of a record */
+#define PORT_LOG_HEADER_ID(header) ((header) & 0xFFFFU)                                                                                                                       /*!< Message ID of a record */
+
+/**
+ * @brief IDs of the messages, generated from the catalog
+ */
+typedef enum
+{
+#define PORT_LOG_X_ENUM(id, format) id,
+    PORT_LOG_MESSAGES(PORT_LOG_X_ENUM)
+#undef PORT_LOG_X_ENUM
+    PORT_LOG_NUM_MESSAGES
+} port_log_msg_id_t;
+
+/* Typedefs --------------------------------------------------------------------*/
+/**
+ * @brief Ring buffer of the records. It is a global symbol so a debugger can find and dump it
+ */
+typedef struct
+{
+    uint32_t magic;                          /*!< `PORT_LOG_MAGIC` once the logger is initialized */
+    uint32_t size_words;                     /*!< Size of `words` */
+    volatile uint32_t head;                  /*!< Free-running index of the next word to write */
+    volatile uint32_t tail;                  /*!< Free-running index of the next word to send */
+    volatile uint32_t dropped;               /*!< Records lost because the buffer was full */
+    uint32_t words[PORT_LOG_BUFFER_WORDS];   /*!< Records */
+} port_log_buffer_t;
+
+extern port_log_buffer_t port_log_buffer; /*!< Ring buffer of the records */
+
+/* Macros ----------------------------------------------------------------------*/
+#define PORT_LOG_NARGS_(id, a1, a2, a3, a4, n, ...) n
+#define PORT_LOG_NARGS(...) PORT_LOG_NARGS_(__VA_ARGS__, 4, 3, 2, 1, 0, 0) /*!< Number of arguments after the ID */
+#define PORT_LOG_WRITE(level, ...) port_log_write((level), PORT_LOG_NARGS(__VA_ARGS__), (const uint32_t[]){__VA_ARGS__})
+
+#if PORT_LOG_LEVEL >= PORT_LOG_LEVEL_ERROR
+#define PORT_LOG_ERROR(...) PORT_LOG_WRITE(PORT_LOG_LEVEL_ERROR, __VA_ARGS__)
+#else
+#define PORT_LOG_ERROR(...) ((void)0)
+#endif
+
+#if PORT_LOG_LEVEL >= PORT_LOG_LEVEL_WARN
+#define PORT_LOG_WARN(...) PORT_LOG_WRITE(PORT_LOG_LEVEL_WARN, __VA_ARGS__)
+#else
+#define PORT_LOG_WARN(...) ((void)0)
+#endif
+
+#if PORT_LOG_LEVEL >= PORT_LOG_LEVEL_INFO
+#define PORT_LOG_INFO(...) PORT_LOG_WRITE(PORT_LOG_LEVEL_INFO, __VA_ARGS__)
+#else
+#define PORT_LOG_INFO(...) ((void)0)
+#endif
+
+#if PORT_LOG_LEVEL >= PORT_LOG_LEVEL_DEBUG
+#define PORT_LOG_DEBUG(...) PORT_LOG_WRITE(PORT_LOG_LEVEL_DEBUG, __VA_ARGS__)
+#else
+#define PORT_LOG_DEBUG(...) ((void)0)
+#endif
+
+/* Function prototypes and explanation -------------------------------------------------*/
+/**
+ * @brief Empty the ring buffer and initialize the drain. It is called by `port_system_init()`.
+ */
+void port_log_init(void);
+
+/**
+ * @brief Store a record in the ring buffer. Use the `PORT_LOG_xxx()` macros instead. It can be called from the ISRs masked by the critical sections.
+ *
+ * @param level Level of the message
+ * @param nargs Number of arguments (up to `PORT_LOG_MAX_ARGS`)
+ * @param p_id_args ID of the message followed by its arguments
+ */
+void port_log_write(uint32_t level, uint32_t nargs, const uint32_t *p_id_args);
+
+/**
+ * @brief Send the stored records through the drain of the platform. It must be called from the thread code, e.g., from the idle loop.
+ */
+void port_log_flush(void);
+
+/* Drain functions. They must be implemented in the platform-specific code */
+/**
+ * @brief Initialize the drain of the records
+ */
+void port_log_hw_init(void);
+
+/**
+ * @brief Send consecutive words of the ring buffer
+ *
+ * @param p_words Pointer to the first word
+ * @param num_words Number of words to send
+ * @return Number of words sent. 0 if the drain is not available, so the records stay in the ring buffer for the debugger
+ */
+uint32_t port_log_hw_write(const uint32_t *p_words, uint32_t num_words);
+
+#endif /* PORT_LOG_H_ */
@@ -0,0 +1,35 @@
+/**
+ * @file port_log_messages.h
+ * @brief Catalog of the messages of the deferred logger.
+ *
+ * Each entry of `PORT_LOG_MESSAGES` is `X(id, format)`. The firmware only stores the ID and the raw arguments of a message; the format strings are only compiled into the host decoder (tools/log_decoder), so they do not take flash. The formats are `printf` formats whose arguments are up to `PORT_LOG_MAX_ARGS` 32-bit integers (`%u`, `%d`, `%x`...).
+ *
+ * New messages must be added at the end, so the IDs of the logs already captured do not change.
+ *
+ * @date 2025-01-01
+ */
+#ifndef PORT_LOG_MESSAGES_H_
+#define PORT_LOG_MESSAGES_H_
+
+/* Defines and enums ----------------------------------------------------------*/
+#define PORT_LOG_MESSAGES(X)                                            \
+    X(PORT_LOG_MSG_DROPPED, "%u log records lost (buffer full)")        \
+    X(PORT_LOG_MSG_BOOT, "System started")                              \
+    X(PORT_LOG_MSG_DISTANCE, "Sensor %u distance: %u cm")               \
+    X(PORT_LOG_MSG_DEADLINE_MISS, "Task %u missed %u deadlines")        \
+    X(PORT_LOG_MSG_GESTURE, "Key %u gesture %u")                        \
+    X(PORT_LOG_MSG_PROFILE_FIRE, "FSM %u fire: %u calls")               \
+    X(PORT_LOG_MSG_PROFILE_GUARD, "FSM %u row %u guard: %u calls, %u true") \
+    X(PORT_LOG_MSG_PROFILE_ACTION, "FSM %u row %u action: %u calls")    \
+    X(PORT_LOG_MSG_PROFILE_STATE, "FSM %u state %u: %u transitions")    \
+    X(PORT_LOG_MSG_PROFILE_BLOCK, "Block %u: %u calls")                 \
+    X(PORT_LOG_MSG_PROFILE_CYCLES, "  cycles min %u max %u avg %u total %u") \
+    X(PORT_LOG_MSG_ISR_CALLS, "ISR %u: %u calls, %u preemptions")     \
+    X(PORT_LOG_MSG_ISR_MAX, "ISR %u max cycles: latency %u duration %u response %u") \
+    X(PORT_LOG_MSG_ISR_LATENCY, "ISR %u latency < %u cycles: %u")      \
+    X(PORT_LOG_MSG_ISR_DURATION, "ISR %u duration < %u cycles: %u")   \
+    X(PORT_LOG_MSG_LATENCY_MARK, "Measurement %u sensor %u point %u at %u us") \
+    X(PORT_LOG_MSG_LATENCY_STAGE, "Latency stage %u: %u samples, min %u us, worst %u us") \
+    X(PORT_LOG_MSG_LATENCY_PERCENTILES, "Latency stage %u: p50 %u us, p90 %u us, p99 %u us")
+
+#endif /* PORT_LOG_MESSAGES_H_ */
@@ -11,7 +11,6 @@
 /* Includes del sistema */
 #include <stdint.h>
 #include <stdbool.h>
-#include "stm32f4xx.h"
 
 /**
  * @brief Initializes the system.
@@ -51,32 +50,58 @@ void port_system_delay_ms(uint32_t ms);
 void port_system_delay_until_ms(uint32_t *t, uint32_t ms);
 
 /**
- * @brief Read the digital value of a GPIO
- * @param p_port Pointer to the port of the GPIO
- * @param pin  Pin of the GPIO
+ * @brief Put the CPU to sleep until the next interrupt.
  *
- * @note 
- * @note 
+ * @note The System tick wakes the CPU up every millisecond at the latest.
+ * @note To sleep only while there is nothing to do, check it and sleep between `port_system_disable_interrupts()` and `port_system_enable_interrupts()`. Otherwise an interrupt that posts work between the check and the sleep is not seen until the next one wakes the CPU up.
  */
-bool stm32f4_system_gpio_read(GPIO_TypeDef * p_port, uint8_t pin);
+void port_system_sleep(void);
 
 /**
- * @brief Write a digital value in a GPIO atomically
- * @param p_port Pointer to the port of the GPIO
- * @param pin  Pin of the GPIO
- *  @param value Boolean value to set the gpio to high
- * @note No return values
- * @note 
+ * @brief Mask all the interrupts, to check a condition set by the ISRs and go to sleep without a lost wakeup.
+ *
+ * @note An interrupt raised while they are masked still wakes the CPU up from `port_system_sleep()`, and its ISR runs at `port_system_enable_interrupts()`.
+ * @note The calls cannot be nested. Use the critical sections to protect data.
+ */
+void port_system_disable_interrupts(void);
+
+/**
+ * @brief Unmask the interrupts masked by `port_system_disable_interrupts()`. The ISRs raised meanwhile run now.
  */
-void stm32f4_system_gpio_write(GPIO_TypeDef * p_port, uint8_t pin, bool value);
+void port_system_enable_interrupts(void);
+
 /**
- * @brief Toggle the value of a GPIO
- * @param p_port Pointer to the port of the GPIO
- * @param pin  Pin of the GPIO
- *  
- * @note 
- * @note 
+ * @brief Returns the value of a free-running cycle counter. It is used to measure short execution times.
+ *
+ * @note The counter wraps around. Compute differences with unsigned arithmetic.
+ *
+ * @retval current value of the cycle counter.
+ */
+uint32_t port_system_get_cycles(void);
+
+/**
+ * @brief Returns the number of counts of `port_system_get_cycles()` per microsecond.
+ *
+ * @retval counts per microsecond.
  */
-void stm32f4_system_gpio_toggle(GPIO_TypeDef *p_port, uint8_t pin);
+uint32_t port_system_get_cycles_per_us(void);
+
+/**
+ * @brief Enter a critical section.
+ *
+ * Masks the interrupts whose priority is equal to or lower than the one configured by the platform (e.g., through BASEPRI in the STM32F4). Interrupts with a higher priority (e.g., the System tick and the echo capture) are not masked, so their latency is not affected.
+ *
+ * @note Critical sections can be nested. The interrupt mask in effect when the outermost critical section is entered is restored when it is left with `port_system_exit_critical()`.
+ * @note Keep critical sections short: they delay the masked interrupts.
+ */
+void port_system_enter_critical(void);
+
+/**
+ * @brief Exit a critical section.
+ *
+ * @note Every call to `port_system_enter_critical()` must be matched by a call to this function.
+ */
+void port_system_exit_critical(void);
+
 #endif /* PORT_SYSTEM_H_ */
 
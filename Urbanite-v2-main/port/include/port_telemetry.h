@@ -0,0 +1,104 @@
+/**
+ * @file port_telemetry.h
+ * @brief Header for the telemetry stream of the port layer.
+ *
+ * The measurements of the parking sensors are sent off the board as binary frames. Each call of `port_telemetry_send()` serializes one record into the frame being filled and updates its CRC and its COBS encoding on the fly, so the cost of a record is constant and does not depend on the speed of the link. When a frame is full (or `port_telemetry_flush()` is called) it is closed and handed to the DMA of the UART while the records keep going to the other frame (double buffering). If both frames are busy, the records are dropped and counted.
+ *
+ * Frame before encoding (little-endian):
+ * | Field   | Bytes | Description |
+ * |---------|-------|-------------|
+ * | version | 1     | `PORT_TELEMETRY_VERSION` |
+ * | seq     | 1     | Sequence number of the frame. A gap means lost frames |
+ * | records | 10·n  | n records of `PORT_TELEMETRY_RECORD_SIZE` bytes: sensor ID (1), flags (1), timestamp in us (4), median distance in cm (2), raw distance in cm (2) |
+ * | crc     | 2     | CRC-16/CCITT-FALSE of the previous bytes |
+ *
+ * The frame is encoded with COBS (Consistent Overhead Byte Stuffing), so it has no zero bytes, and a zero byte is appended as delimiter. A receiver can resynchronize at the next zero byte after a corrupted or truncated frame.
+ *
+ * The framing is platform-independent (port_telemetry.c). The functions of the UART (`port_telemetry_hw_xxx()`) must be implemented in the platform-specific code.
+ *
+ * @date 2025-01-01
+ */
+#ifndef PORT_TELEMETRY_H_
+#define PORT_TELEMETRY_H_
+
+/* Includes ------------------------------------------------------------------*/
+/* Standard C includes */
+#include <stdint.h>
+#include <stdbool.h>
+
+/* Defines and enums ----------------------------------------------------------*/
+#define PORT_TELEMETRY_VERSION 1U                                                                                                         /*!< Version of the frame format */
+#define PORT_TELEMETRY_RECORDS_PER_FRAME 8U                                                                                               /*!< Records sent in each frame */
+#define PORT_TELEMETRY_RECORD_SIZE 10U                                                                                                    /*!< Bytes of a serialized record */
+#define PORT_TELEMETRY_HEADER_SIZE 2U                                                                                                     /*!< Bytes of the header (version and sequence number) */
+#define PORT_TELEMETRY_CRC_SIZE 2U                                                                                                        /*!< Bytes of the CRC */
+#define PORT_TELEMETRY_PAYLOAD_MAX_SIZE (PORT_TELEMETRY_HEADER_SIZE + (PORT_TELEMETRY_RECORDS_PER_FRAME * PORT_TELEMETRY_RECORD_SIZE) + PORT_TELEMETRY_CRC_SIZE) /*!< Bytes of a full frame before encoding */
+#define PORT_TELEMETRY_FRAME_MAX_SIZE (PORT_TELEMETRY_PAYLOAD_MAX_SIZE + (PORT_TELEMETRY_PAYLOAD_MAX_SIZE / 254U) + 2U)                   /*!< Bytes of a full frame after encoding, with the COBS overhead and the delimiter */
+#define PORT_TELEMETRY_DELIMITER 0x00U                                                                                                    /*!< End of frame */
+#define PORT_TELEMETRY_CRC_INIT 0xFFFFU                                                                                                   /*!< Initial value of the CRC-16/CCITT-FALSE */
+
+/* Flags of a record */
+#define PORT_TELEMETRY_FLAG_VALID 0x01U        /*!< The median distance is valid (the buffer of measurements is full) */
+#define PORT_TELEMETRY_FLAG_OUT_OF_RANGE 0x02U /*!< The raw distance is out of the range of the sensor */
+#define PORT_TELEMETRY_FLAG_NO_ECHO 0x04U      /*!< The echo was not received */
+
+/* Function prototypes and explanation -------------------------------------------------*/
+/**
+ * @brief Empty the frames and configure the UART and its DMA.
+ */
+void port_telemetry_init(void);
+
+/**
+ * @brief Add a record to the frame being filled. The timestamp is taken from `port_timer_get_micros()`.
+ *
+ * The frame is handed to the DMA when it gets `PORT_TELEMETRY_RECORDS_PER_FRAME` records. It can be called from the thread code and from the ISRs masked by the critical sections.
+ *
+ * @param sensor_id Sensor identifier
+ * @param median_cm Median distance in cm. Saturated to 16 bits
+ * @param raw_cm Last raw distance in cm. Saturated to 16 bits
+ * @param flags Combination of `PORT_TELEMETRY_FLAG_xxx`
+ * @return true if the record has been stored. false if it has been dropped because both frames are busy
+ */
+bool port_telemetry_send(uint32_t sensor_id, uint32_t median_cm, uint32_t raw_cm, uint8_t flags);
+
+/**
+ * @brief Close the frame being filled, if it has any record, and send it as soon as the UART is free.
+ */
+void port_telemetry_flush(void);
+
+/**
+ * @brief Get the number of records dropped because both frames were busy.
+ *
+ * @return Number of records dropped since `port_telemetry_init()`
+ */
+uint32_t port_telemetry_get_dropped(void);
+
+/**
+ * @brief Update a CRC-16/CCITT-FALSE (polynomial 0x1021, initial value `PORT_TELEMETRY_CRC_INIT`, no reflection) with a byte. It is public so the receivers can check the frames with the same code.
+ *
+ * @param crc Current value of the CRC
+ * @param byte Next byte
+ * @return Updated CRC
+ */
+uint16_t port_telemetry_crc16(uint16_t crc, uint8_t byte);
+
+/**
+ * @brief Handle the end of the transmission of a frame. It must be called from the ISR of the DMA of the UART.
+ */
+void port_telemetry_tx_complete_irq_handler(void);
+
+/* UART functions. They must be implemented in the platform-specific code */
+/**
+ * @brief Configure the UART and its DMA.
+ */
+void port_telemetry_hw_init(void);
+
+/**
+ * @brief Start the transmission of a frame. The end of the transmission must be notified with `port_telemetry_tx_complete_irq_handler()`.
+ *
+ * @param p_data Pointer to the encoded frame. It is not modified until the end of the transmission
+ * @param length Number of bytes
+ */
+void port_telemetry_hw_start_tx(const uint8_t *p_data, uint32_t length);
+
+#endif /* PORT_TELEMETRY_H_ */
@@ -0,0 +1,149 @@
+/**
+ * @file port_timer.h
+ * @brief Header for the software timers of the port layer.
+ *
+ * All the software timers are multiplexed on a single hardware timer: a free-running 32-bit microsecond counter with one compare-match channel. The timers are kept in a hierarchical timer wheel of `PORT_TIMER_LEVELS` levels of `PORT_TIMER_SLOTS` slots; level `l` sorts the timers by the bits `6*l` to `6*l + 5` of their expiry time. Inserting and cancelling a timer is O(1), and the next expiry is found with a count-trailing-zeros of the occupancy bitmap of the lowest non-empty level. The compare channel is always programmed at the next expiry or at the next cascade of a level, so near deadlines keep the microsecond resolution of the counter and the CPU is only interrupted when something has to be done.
+ *
+ * The callbacks run in the interrupt of the hardware timer, whose priority is masked by the critical sections of `port_system.h`. Starting and cancelling timers is safe from the thread code and from the callbacks.
+ *
+ * The functions of the software timers are platform-independent (port_timer.c). The functions of the hardware timer (`port_timer_hw_xxx()`) must be implemented in the platform-specific code.
+ *
+ * @date 2025-01-01
+ */
+#ifndef PORT_TIMER_H_
+#define PORT_TIMER_H_
+
+/* Includes ------------------------------------------------------------------*/
+/* Standard C includes */
+#include <stdint.h>
+#include <stdbool.h>
+
+/* Defines and enums ----------------------------------------------------------*/
+#define PORT_TIMER_SLOT_BITS 6U                            /*!< Bits of the expiry time sorted by each level */
+#define PORT_TIMER_SLOTS (1U << PORT_TIMER_SLOT_BITS)      /*!< Number of slots of each level */
+#define PORT_TIMER_LEVELS 6U                               /*!< Number of levels. 6 levels of 6 bits cover the 32 bits of the expiry time */
+#define PORT_TIMER_MAX_DELAY_US (1UL << 30)                /*!< Maximum delay of a timer (about 17 minutes) */
+
+/* Typedefs --------------------------------------------------------------------*/
+/**
+ * @brief Function called when a timer expires. It runs in the interrupt of the hardware timer
+ */
+typedef void (*port_timer_callback_t)(void *p_arg);
+
+/**
+ * @brief Software timer. It is owned by the caller (e.g., a field of the struct of a peripheral) and must not be modified directly
+ */
+typedef struct port_timer
+{
+    struct port_timer *p_next;      /*!< Next timer in the same slot */
+    struct port_timer *p_prev;      /*!< Previous timer in the same slot. NULL for the first timer of a slot */
+    uint32_t expiry_us;             /*!< Absolute expiry time in microseconds */
+    uint32_t period_us;             /*!< Period of a periodic timer. 0 for a one-shot timer */
+    port_timer_callback_t callback; /*!< Function called when the timer expires */
+    void *p_arg;                    /*!< Argument of the callback */
+    uint8_t level;                  /*!< Level of the wheel where the timer is */
+    uint8_t slot;                   /*!< Slot of the level where the timer is */
+    bool armed;                     /*!< The timer is in the wheel */
+} port_timer_t;
+
+/**
+ * @brief State of the wheel. It is provided by the platform with `port_timer_hw_get_wheel()`, so the host simulator can keep one wheel per simulated unit
+ */
+typedef struct
+{
+    port_timer_t *slots_arr[PORT_TIMER_LEVELS][PORT_TIMER_SLOTS]; /*!< First timer of each slot of each level */
+    uint64_t occupied_arr[PORT_TIMER_LEVELS];                     /*!< Bit s of level l set if the slot s of level l is not empty */
+    port_timer_t *p_wrapped;                                      /*!< Timers whose expiry has wrapped around */
+    uint32_t now_us;                                              /*!< Reference time of the wheel in microseconds */
+    bool dispatching;                                             /*!< The interrupt is expiring the timers of a slot */
+} port_timer_wheel_t;
+
+/* Function prototypes and explanation -------------------------------------------------*/
+/**
+ * @brief Configure the hardware timer and empty the wheel. It is called by `port_system_init()`.
+ */
+void port_timer_init(void);
+
+/**
+ * @brief Set the callback of a timer. It must be called once before the timer is started.
+ *
+ * @param p_timer Pointer to the timer
+ * @param callback Function called when the timer expires
+ * @param p_arg Argument of the callback
+ */
+void port_timer_setup(port_timer_t *p_timer, port_timer_callback_t callback, void *p_arg);
+
+/**
+ * @brief Start a timer. If it was already started, it is restarted.
+ *
+ * @param p_timer Pointer to the timer
+ * @param delay_us Time until the first expiry, in microseconds. It is clamped to [1, `PORT_TIMER_MAX_DELAY_US`]
+ * @param period_us Period of the next expiries, in microseconds. 0 for a one-shot timer
+ */
+void port_timer_start(port_timer_t *p_timer, uint32_t delay_us, uint32_t period_us);
+
+/**
+ * @brief Stop a timer. Nothing is done if it was not started.
+ *
+ * @param p_timer Pointer to the timer
+ */
+void port_timer_cancel(port_timer_t *p_timer);
+
+/**
+ * @brief Check if a timer is started
+ *
+ * @param p_timer Pointer to the timer
+ * @return true if the timer will expire
+ */
+bool port_timer_is_armed(port_timer_t *p_timer);
+
+/**
+ * @brief Returns the number of microseconds counted by the hardware timer. It wraps around every 2^32 us.
+ *
+ * @retval current time in microseconds.
+ */
+uint32_t port_timer_get_micros(void);
+
+/**
+ * @brief Expire the due timers and program the next compare match. It must be called from the interrupt of the hardware timer.
+ */
+void port_timer_irq_handler(void);
+
+/* Hardware timer functions. They must be implemented in the platform-specific code */
+/**
+ * @brief Start the free-running microsecond counter with the compare-match interrupt disabled
+ */
+void port_timer_hw_init(void);
+
+/**
+ * @brief Returns the value of the free-running microsecond counter
+ *
+ * @retval current value of the counter.
+ */
+uint32_t port_timer_hw_get_micros(void);
+
+/**
+ * @brief Program the compare match and enable its interrupt
+ *
+ * @param at_us Value of the counter that raises the interrupt
+ */
+void port_timer_hw_set_alarm(uint32_t at_us);
+
+/**
+ * @brief Disable the compare-match interrupt
+ */
+void port_timer_hw_disable_alarm(void);
+
+/**
+ * @brief Raise the interrupt of the hardware timer by software. It is used when the next expiry has already passed
+ */
+void port_timer_hw_trigger(void);
+
+/**
+ * @brief Get the state of the wheel that runs on the hardware timer. It is zero-initialized before the first call of `port_timer_init()`
+ *
+ * @return Pointer to the wheel
+ */
+port_timer_wheel_t *port_timer_hw_get_wheel(void);
+
+#endif /* PORT_TIMER_H_ */
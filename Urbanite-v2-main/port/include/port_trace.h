@@ -0,0 +1,135 @@
+/**
+ * @file port_trace.h
+ * @brief Header for the trace of the raw captures of the sensors, to replay field sessions on the host.
+ *
+ * When the project is configured with `-DCAPTURE_TRACE=ON`, `PORT_TRACE_RECORD()` appends the inputs of the FSMs, as the ISRs see them, and the outputs of the FSMs to a binary trace in RAM:
+ * the start of each trigger, the captures of the echo timer at the falling edge (`echo_init_tick`, `echo_end_tick` and `echo_overflows`), the level of the button at each edge, the start, stop and status changes of the ultrasound FSM, and the medians and press durations computed by the device.
+ *
+ * The trace is a file image: a `port_trace_header_t` followed by `num_records` records of `port_trace_record_t`, little endian. It is saved with `port_trace_save()` (through semihosting in the STM32F4 port), or dumped from the debugger with `dump binary memory trace.bin &port_trace_image ((char *)&port_trace_image + sizeof(port_trace_image))`. When the buffer is full the new records are dropped and counted, so the beginning of the session is kept. The host replay engine (`sim/trace_replay.c`) feeds the inputs to the FSMs through the native port and checks that their outputs are the ones of the trace.
+ *
+ * Without `PORT_CAPTURE_TRACE` the macro expands to nothing and its arguments are not evaluated.
+ *
+ * @date 2025-01-01
+ */
+#ifndef PORT_TRACE_H_
+#define PORT_TRACE_H_
+
+/* Includes ------------------------------------------------------------------*/
+/* Standard C includes */
+#include <stdint.h>
+#include <stdbool.h>
+
+/* Defines and enums ----------------------------------------------------------*/
+#define PORT_TRACE_MAGIC 0x43525455UL /*!< "UTRC" at the beginning of a trace */
+#define PORT_TRACE_VERSION 1U         /*!< Format of the records */
+#ifndef PORT_TRACE_CAPACITY
+#define PORT_TRACE_CAPACITY 4096U     /*!< Records kept in RAM (48 KiB). A measurement takes 2 records every 100 ms, so this is about 3 minutes of one sensor */
+#endif
+
+/**
+ * @brief Types of the records. The meaning of `arg16` and `arg32` depends on the type
+ */
+enum PORT_TRACE_TYPE
+{
+    PORT_TRACE_TRIGGER = 0, /*!< The trigger signal of a sensor is raised. No arguments */
+    PORT_TRACE_ECHO,        /*!< Falling edge of the echo: `arg16` is `echo_overflows` (saturated) and `arg32` is `echo_init_tick | echo_end_tick << 16` */
+    PORT_TRACE_BUTTON,      /*!< Edge of a button: `arg16` is the new level of the GPIO */
+    PORT_TRACE_START,       /*!< The ultrasound FSM is started. No arguments */
+    PORT_TRACE_STOP,        /*!< The ultrasound FSM is stopped. No arguments */
+    PORT_TRACE_STATUS,      /*!< The status of the ultrasound FSM is set: `arg16` is the new status */
+    PORT_TRACE_DISTANCE,    /*!< Output: a median is ready. `arg16` is the raw distance (saturated) and `arg32` the median, in cm */
+    PORT_TRACE_PRESS,       /*!< Output: a press of a button has ended. `arg32` is its duration in ms */
+    PORT_TRACE_NUM_TYPES    /*!< Number of types of records */
+};
+
+/* Typedefs --------------------------------------------------------------------*/
+/**
+ * @brief Header of a trace
+ */
+typedef struct
+{
+    uint32_t magic;        /*!< `PORT_TRACE_MAGIC` */
+    uint16_t version;      /*!< `PORT_TRACE_VERSION` */
+    uint16_t record_size;  /*!< Size of a record in bytes */
+    uint32_t num_records;  /*!< Records that follow the header */
+    uint32_t dropped;      /*!< Records dropped because the buffer was full */
+} port_trace_header_t;
+
+/**
+ * @brief Record of a trace. 12 bytes, without padding
+ */
+typedef struct
+{
+    uint32_t time_ms; /*!< System time of the event */
+    uint8_t type;     /*!< Type of the record (`PORT_TRACE_xxx`) */
+    uint8_t id;       /*!< Identifier of the sensor or the button */
+    uint16_t arg16;   /*!< First argument */
+    uint32_t arg32;   /*!< Second argument */
+} port_trace_record_t;
+
+/**
+ * @brief Image of the trace in RAM. It is also the layout of a trace file
+ */
+typedef struct
+{
+    port_trace_header_t header;                           /*!< Header of the trace */
+    port_trace_record_t records_arr[PORT_TRACE_CAPACITY]; /*!< Records of the trace */
+} port_trace_image_t;
+
+/* Global variables -----------------------------------------------------------*/
+extern port_trace_image_t port_trace_image; /*!< Trace in RAM. Global so that the debugger can dump it */
+
+/* Macros ----------------------------------------------------------------------*/
+#ifdef PORT_CAPTURE_TRACE
+#define PORT_TRACE_RECORD(type, id, arg16, arg32) port_trace_record((type), (id), (arg16), (arg32)) /*!< Append a record to the trace */
+#else
+#define PORT_TRACE_RECORD(type, id, arg16, arg32) ((void)0)
+#endif
+
+/* Function prototypes and explanation -------------------------------------------------*/
+/**
+ * @brief Append a record to the trace, with the current system time. Use `PORT_TRACE_RECORD()` instead. It can be called from any ISR, including the ones that the critical sections do not mask.
+ *
+ * @param type Type of the record (`PORT_TRACE_xxx`)
+ * @param id Identifier of the sensor or the button
+ * @param arg16 First argument. Saturated to 16 bits
+ * @param arg32 Second argument
+ */
+void port_trace_record(uint32_t type, uint32_t id, uint32_t arg16, uint32_t arg32);
+
+/**
+ * @brief Empty the trace and reset the counter of dropped records.
+ */
+void port_trace_reset(void);
+
+/**
+ * @brief Get the number of records in the trace.
+ *
+ * @return Number of records
+ */
+uint32_t port_trace_get_num_records(void);
+
+/**
+ * @brief Get the number of records dropped because the buffer was full.
+ *
+ * @return Number of records dropped
+ */
+uint32_t port_trace_get_dropped(void);
+
+/**
+ * @brief Get the file image of the trace: the header and the records in use.
+ *
+ * @param p_size Pointer to store the size of the image in bytes
+ * @return Pointer to the image
+ */
+const void *port_trace_get_image(uint32_t *p_size);
+
+/**
+ * @brief Write the file image of the trace to a file. In the STM32F4 port the file is opened in the host through semihosting.
+ *
+ * @param p_path Path of the file
+ * @return true if the whole trace has been written
+ */
+bool port_trace_save(const char *p_path);
+
+#endif /* PORT_TRACE_H_ */
@@ -16,8 +16,10 @@
 #define PORT_REAR_PARKING_SENSOR_ID 0 //Rear parking sensor identifier
 #define PORT_PARKING_SENSOR_TRIGGER_UP_US 10.0 //Duration in microsecons of the trigger signal
 #define PORT_PARKING_SENSOR_TIMEOUT_MS 100.0 //Time in ms wait for the next measurement
+#define PORT_PARKING_SENSOR_TIMEOUT_US ((uint32_t)(PORT_PARKING_SENSOR_TIMEOUT_MS * 1000.0)) //Period of the software timer of the measurements
 #define PORT_PARKING_SENSOR_ECHO_US 1 //Duration in microsecons of echo time
 #define SPEED_OF_SOUND_MS 343 //Speed of sound in air in m/s
+#define PORT_PARKING_SENSOR_ECHO_TIMER_TICKS 65536U //Ticks (us) counted by the echo timer between two overflows
 /* Function prototypes and explanation -------------------------------------------------*/
 
 
@@ -158,6 +160,14 @@ void port_ultrasound_start_measurement(uint32_t ultrasound_id);
  */
 uint32_t port_ultrasound_start_new_measurement_timer(void);
 
+/**
+ * @brief Check if the timer that controls the new measurement of a sensor is running
+ *
+ * @param ultrasound_id Ultrasound ID. This index is used to select the element of the ultrasound_arr[] array
+ * @return true if the software timer of the measurements is armed
+ */
+bool port_ultrasound_get_measurement_timer_running(uint32_t ultrasound_id);
+
 /**
  * @brief Stop the timer that controls the echo signal
  *  @param ultrasound_id Ultrasound ID. This index is used to select the element of the ultrasound_arr[] array
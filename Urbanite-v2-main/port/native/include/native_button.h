@@ -0,0 +1,51 @@
+/**
+ * @file native_button.h
+ * @brief Header for native_button.c file.
+ * @date 2025-01-01
+ */
+#ifndef NATIVE_BUTTON_H_
+#define NATIVE_BUTTON_H_
+
+/* Includes ------------------------------------------------------------------*/
+/* Standard C includes */
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdatomic.h>
+
+/* HW dependent includes */
+#include "port_button.h"
+
+/* Defines and enums ----------------------------------------------------------*/
+/* Defines */
+#define NATIVE_BUTTON_IRQ_PRIO 6U                               /*!< Priority of the emulated button interrupt. Same value as in the STM32F4 port */
+#define NATIVE_BUTTON_NUM_BUTTONS (PORT_PARKING_BUTTON_ID + 1U) /*!< Number of emulated buttons of a simulated unit */
+
+/* Typedefs --------------------------------------------------------------------*/
+/**
+ * @brief Emulated button of a simulated unit (see native_instance.h)
+ */
+typedef struct
+{
+    _Atomic uint32_t flags; /*!< Flags shared with the ISR */
+    bool value;             /*!< Level of the emulated GPIO */
+    bool exti_enabled;      /*!< Interrupts of the button enabled */
+    bool exti_pending;      /*!< Emulated pending bit of the external interrupt line */
+} native_button_hw_t;
+
+/* Function prototypes and explanation -------------------------------------------------*/
+/**
+ * @brief Change the level of the emulated GPIO of a button.
+ *
+ * If the level changes and the interrupts of the button are enabled, the emulated external interrupt is raised. The buttons are active low, as the user button of the Nucleo board: `false` means pressed.
+ *
+ * @param button_id Button ID. This index is used to select the element of the buttons_arr[] array
+ * @param value New level of the GPIO
+ */
+void native_button_set_value(uint32_t button_id, bool value);
+
+/**
+ * @brief Emulated external interrupt service routine of the buttons. Defined in native_interr.c.
+ */
+void native_button_irq_handler(void);
+
+#endif /* NATIVE_BUTTON_H_ */
@@ -0,0 +1,23 @@
+/**
+ * @file native_debounce.h
+ * @brief Header for native_debounce.c file.
+ * @date 2025-01-01
+ */
+#ifndef NATIVE_DEBOUNCE_H_
+#define NATIVE_DEBOUNCE_H_
+
+/* Includes ------------------------------------------------------------------*/
+/* Standard C includes */
+#include <stdint.h>
+#include <stdbool.h>
+
+/* Function prototypes and explanation -------------------------------------------------*/
+/**
+ * @brief Change the raw (not debounced) level of an emulated key. Bounces are emulated by calling it several times between samples.
+ *
+ * @param key_id Key ID
+ * @param pressed true if the contact of the key is closed
+ */
+void native_debounce_set_raw(uint32_t key_id, bool pressed);
+
+#endif /* NATIVE_DEBOUNCE_H_ */
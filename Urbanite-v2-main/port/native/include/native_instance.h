@@ -0,0 +1,73 @@
+/**
+ * @file native_instance.h
+ * @brief Header for native_instance.c file.
+ *
+ * A simulated unit of the native port: the virtual time, the interrupt controller, the emulated peripherals and the wheel of software timers of one Urbanite. The functions of the port act on the unit selected in the calling thread, so a process can run many independent units, e.g., the fleet simulator of sim/. A unit may move between threads, but it must not be selected in two threads at the same time. The programs that never select a unit use a default one, so they are not aware of this.
+ *
+ * The logger, the telemetry, the debouncer and the opt-in diagnostics (ISR statistics, latency trace and FSM profiler) are shared by all the units of the process.
+ *
+ * @date 2025-01-01
+ */
+#ifndef NATIVE_INSTANCE_H_
+#define NATIVE_INSTANCE_H_
+
+/* Includes ------------------------------------------------------------------*/
+/* HW dependent includes */
+#include "port_timer.h"
+#include "native_system.h"
+#include "native_timer.h"
+#include "native_button.h"
+#include "native_ultrasound.h"
+
+/* Typedefs --------------------------------------------------------------------*/
+/**
+ * @brief State of a simulated unit
+ */
+typedef struct
+{
+    native_system_state_t system;                                         /*!< Virtual time and interrupt controller */
+    native_timer_hw_t timer;                                              /*!< Hardware timer of the software timers */
+    port_timer_wheel_t wheel;                                             /*!< Software timers */
+    native_button_hw_t buttons_arr[NATIVE_BUTTON_NUM_BUTTONS];            /*!< Emulated buttons */
+    native_ultrasound_hw_t ultrasound_arr[NATIVE_ULTRASOUND_NUM_SENSORS]; /*!< Emulated ultrasound sensors */
+} native_instance_t;
+
+/* Global variables -----------------------------------------------------------*/
+extern _Thread_local native_instance_t *native_instance_current; /*!< Unit selected in the calling thread. Use `native_instance_get()` and `native_instance_select()` */
+
+/* Function prototypes and explanation -------------------------------------------------*/
+/**
+ * @brief Create a simulated unit with the values of a reset. It is not selected.
+ *
+ * The port of the unit must be initialized once it is selected, with `port_system_init()` or, if the shared logger must not be reset, `native_system_reset()`.
+ *
+ * @return Pointer to the unit. NULL if there is no memory
+ */
+native_instance_t *native_instance_new(void);
+
+/**
+ * @brief Free a simulated unit. If it is selected in the calling thread, the default unit is selected.
+ *
+ * @param p_instance Pointer to the unit
+ */
+void native_instance_destroy(native_instance_t *p_instance);
+
+/**
+ * @brief Select the simulated unit of the calling thread.
+ *
+ * @param p_instance Pointer to the unit. NULL selects the default unit
+ * @return Pointer to the unit selected before
+ */
+native_instance_t *native_instance_select(native_instance_t *p_instance);
+
+/**
+ * @brief Get the simulated unit selected in the calling thread.
+ *
+ * @return Pointer to the unit
+ */
+static inline native_instance_t *native_instance_get(void)
+{
+    return native_instance_current;
+}
+
+#endif /* NATIVE_INSTANCE_H_ */
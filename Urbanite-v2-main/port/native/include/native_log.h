@@ -0,0 +1,24 @@
+/**
+ * @file native_log.h
+ * @brief Header for native_log.c file.
+ *
+ * The records of the deferred logger are written, in the same binary format as the SWO output of the STM32F4 port, to a file that can be decoded with tools/log_decoder.
+ *
+ * @date 2025-01-01
+ */
+#ifndef NATIVE_LOG_H_
+#define NATIVE_LOG_H_
+
+/* Includes ------------------------------------------------------------------*/
+/* Standard C includes */
+#include <stdio.h>
+
+/* Function prototypes and explanation -------------------------------------------------*/
+/**
+ * @brief Set the file where the records are written. By default, the file of the environment variable `URBANITE_LOG_FILE` is used, if it is defined.
+ *
+ * @param p_file Open binary file. NULL keeps the records in the ring buffer
+ */
+void native_log_set_sink(FILE *p_file);
+
+#endif /* NATIVE_LOG_H_ */
@@ -0,0 +1,180 @@
+/**
+ * @file native_system.h
+ * @brief Header for native_system.c file.
+ *
+ * The native port runs the platform-independent code on the host (Linux) as a simulator. There is no real hardware: the system time is virtual and the interrupts are emulated by a small interrupt controller that honours priorities and critical sections in the same way as the NVIC does. The virtual time and the interrupt controller belong to the simulated unit selected in the calling thread (see native_instance.h).
+ *
+ * @date 2025-01-01
+ */
+
+#ifndef NATIVE_SYSTEM_H_
+#define NATIVE_SYSTEM_H_
+
+/* Includes ------------------------------------------------------------------*/
+/* Standard C includes */
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdatomic.h>
+
+/* Defines and enums ----------------------------------------------------------*/
+/* Defines */
+#define NATIVE_SYSTEM_NUM_IRQS 16U         /*!< Number of emulated interrupt lines */
+#define NATIVE_SYSTEM_CRITICAL_PRIO 4U     /*!< Interrupts with this priority or lower (numerically greater or equal) are masked inside a critical section. Same value as in the STM32F4 port */
+#define NATIVE_SYSTEM_THREAD_PRIO 0xFFU    /*!< Execution priority of the thread (non-interrupt) context */
+#define NATIVE_SYSTEM_NUM_TICK_HOOKS 4U    /*!< Maximum number of emulated peripherals advanced by the virtual time */
+
+/* Enums */
+/**
+ * @brief Emulated interrupt lines. They mirror the interrupts used by the STM32F4 port.
+ */
+enum NATIVE_SYSTEM_IRQ
+{
+    NATIVE_SYSTEM_IRQ_SYSTICK = 0, /*!< System tick (1 ms) */
+    NATIVE_SYSTEM_IRQ_BUTTON,      /*!< External interrupt of the buttons */
+    NATIVE_SYSTEM_IRQ_ECHO,        /*!< Echo capture timer (TIM2 in the STM32F4) */
+    NATIVE_SYSTEM_IRQ_TRIGGER,     /*!< Trigger timer (TIM3 in the STM32F4) */
+    NATIVE_SYSTEM_IRQ_TIMER,       /*!< Time base of the software timers (TIM5 in the STM32F4) */
+    NATIVE_SYSTEM_IRQ_TELEMETRY    /*!< End of the transmission of a telemetry frame (DMA1 stream 6 in the STM32F4) */
+};
+
+/* Typedefs --------------------------------------------------------------------*/
+typedef void (*native_system_irq_handler_t)(void); /*!< Emulated interrupt service routine */
+typedef void (*native_system_tick_hook_t)(uint32_t now_ms); /*!< Emulated peripheral advanced once per millisecond of virtual time */
+typedef uint32_t (*native_system_next_event_hook_t)(uint32_t now_ms); /*!< Milliseconds of virtual time before the tick hook of an emulated peripheral does something: 0 if it does in the current millisecond, `UINT32_MAX` if it does not until its registers are written */
+
+/**
+ * @brief Virtual time and interrupt controller of a simulated unit (see native_instance.h)
+ */
+typedef struct
+{
+    volatile uint32_t msTicks;                                          /*!< Variable to store millisecond ticks */
+    uint32_t critical_nesting;                                          /*!< Nesting level of the critical sections */
+    bool irqs_disabled;                                                 /*!< All the interrupts are masked, as PRIMASK */
+    uint8_t active_prio;                                                /*!< Priority of the code currently running */
+    uint32_t pending_irqs;                                              /*!< Bitmap of the interrupts raised but not served */
+    uint8_t irq_prio[NATIVE_SYSTEM_NUM_IRQS];                           /*!< Priority of each interrupt line */
+    native_system_irq_handler_t irq_handlers[NATIVE_SYSTEM_NUM_IRQS];   /*!< Handler of each interrupt line */
+    uint32_t irq_raise_cycles[NATIVE_SYSTEM_NUM_IRQS];                  /*!< Time at which each pending interrupt was raised */
+    native_system_tick_hook_t tick_hooks[NATIVE_SYSTEM_NUM_TICK_HOOKS]; /*!< Emulated peripherals advanced by the virtual time */
+    native_system_next_event_hook_t next_event_hooks[NATIVE_SYSTEM_NUM_TICK_HOOKS]; /*!< Next event of each emulated peripheral, to skip the virtual time without events */
+} native_system_state_t;
+
+/* Function prototypes and explanation -------------------------------------------------*/
+/**
+ * @brief Reset the simulated unit selected in the calling thread: virtual time, interrupt controller and software timers.
+ *
+ * It is the part of `port_system_init()` that belongs to a unit. The rest (the logger) is shared by all the units of the process.
+ */
+void native_system_reset(void);
+
+/**
+ * @brief Configure an emulated interrupt line.
+ *
+ * @param irq Interrupt line (index from 0 to `NATIVE_SYSTEM_NUM_IRQS - 1`)
+ * @param priority Priority level (from highest priority: 0, to lowest priority: 15)
+ * @param handler Interrupt service routine. NULL disables the line.
+ */
+void native_system_irq_config(uint32_t irq, uint8_t priority, native_system_irq_handler_t handler);
+
+/**
+ * @brief Raise an emulated interrupt.
+ *
+ * The handler runs immediately if its priority is higher than the current execution priority and it is not masked by a critical section. Otherwise, it is left pending and it runs as soon as it becomes unmasked.
+ *
+ * @param irq Interrupt line (index from 0 to `NATIVE_SYSTEM_NUM_IRQS - 1`)
+ */
+void native_system_irq_raise(uint32_t irq);
+
+/**
+ * @brief Check if an emulated interrupt is pending.
+ *
+ * @param irq Interrupt line (index from 0 to `NATIVE_SYSTEM_NUM_IRQS - 1`)
+ * @return true if the interrupt has been raised but its handler has not run yet
+ */
+bool native_system_irq_get_pending(uint32_t irq);
+
+/**
+ * @brief Get the latency of an emulated interrupt: the time from the raise to the current time, in counts of `port_system_get_cycles()`. It is the equivalent of the hardware counters read at the entry of the ISRs of the STM32F4.
+ *
+ * @param irq Interrupt line (index from 0 to `NATIVE_SYSTEM_NUM_IRQS - 1`)
+ * @return Counts since the interrupt was raised
+ */
+uint32_t native_system_irq_get_latency(uint32_t irq);
+
+/**
+ * @brief Advance the virtual time raising one System tick interrupt per millisecond.
+ *
+ * @param ms Number of milliseconds to advance
+ */
+void native_system_advance_ms(uint32_t ms);
+
+/**
+ * @brief Register an emulated peripheral to be advanced by the virtual time.
+ *
+ * The hooks run once per millisecond, before the System tick interrupt, as the hardware would do. They raise the interrupts of the emulated peripherals.
+ *
+ * @param hook_id Slot of the hook (index from 0 to `NATIVE_SYSTEM_NUM_TICK_HOOKS - 1`)
+ * @param hook Function to call. NULL removes the hook.
+ */
+void native_system_set_tick_hook(uint32_t hook_id, native_system_tick_hook_t hook);
+
+/**
+ * @brief Register the next event of an emulated peripheral, so `native_system_skip_ms()` can skip the virtual time in which its tick hook does nothing. A tick hook without it is assumed to do something every millisecond.
+ *
+ * @param hook_id Slot of the tick hook of the peripheral
+ * @param hook Function to call. NULL removes the hook.
+ */
+void native_system_set_next_event_hook(uint32_t hook_id, native_system_next_event_hook_t hook);
+
+/**
+ * @brief Skip the virtual time in which no emulated peripheral has an event, at once.
+ *
+ * It advances the virtual time at most `ms` milliseconds, stopping before the first millisecond in which a tick hook or the compare match of the software timers (see native_timer.h) raises an interrupt, so the unit ends as after `native_system_advance_ms()` of the same time. The System tick interrupts of the skipped milliseconds are not run (nor counted by `PORT_ISR_STATS`). Nothing is skipped while an interrupt is pending or masked.
+ *
+ * @param ms Maximum number of milliseconds to skip
+ * @return Milliseconds skipped. The caller advances the next one with `native_system_advance_ms()`
+ */
+uint32_t native_system_skip_ms(uint32_t ms);
+
+/**
+ * @brief Emulated System tick interrupt service routine. Defined in native_interr.c.
+ */
+void native_system_systick_irq_handler(void);
+
+/**
+ * @brief Set a bit of a flag word shared between ISRs and thread code.
+ *
+ * Host equivalent of the bit-band store of the STM32F4 port: a C11 atomic OR.
+ *
+ * @param p_flags Pointer to the flag word
+ * @param bit Position of the flag in the word (from 0 to 31)
+ */
+static inline void native_system_flag_set(_Atomic uint32_t *p_flags, uint8_t bit)
+{
+    atomic_fetch_or_explicit(p_flags, 1U << bit, memory_order_release);
+}
+
+/**
+ * @brief Clear a bit of a flag word shared between ISRs and thread code with a C11 atomic AND.
+ *
+ * @param p_flags Pointer to the flag word
+ * @param bit Position of the flag in the word (from 0 to 31)
+ */
+static inline void native_system_flag_clear(_Atomic uint32_t *p_flags, uint8_t bit)
+{
+    atomic_fetch_and_explicit(p_flags, ~(1U << bit), memory_order_release);
+}
+
+/**
+ * @brief Test a bit of a flag word shared between ISRs and thread code.
+ *
+ * @param p_flags Pointer to the flag word
+ * @param bit Position of the flag in the word (from 0 to 31)
+ * @return true if the flag is set
+ */
+static inline bool native_system_flag_test(_Atomic uint32_t *p_flags, uint8_t bit)
+{
+    return (atomic_load_explicit(p_flags, memory_order_acquire) & (1U << bit)) != 0U;
+}
+
+#endif /* NATIVE_SYSTEM_H_ */
@@ -0,0 +1,35 @@
+/**
+ * @file native_telemetry.h
+ * @brief Header for native_telemetry.c file.
+ *
+ * The emulated UART of the telemetry writes the frames to a file descriptor: a pseudo-terminal, so the host tools open it as if it were the virtual COM port of the board, or a pipe/FIFO. The descriptor is selected with `native_telemetry_set_fd()` or with the environment variable `URBANITE_TELEMETRY`: `pty` creates a pseudo-terminal and prints the path of its slave side; any other value is the path of a file or FIFO. Without descriptor the frames are discarded.
+ *
+ * The frames are written at once, but the end of the transmission is notified after the time the bytes take at `NATIVE_TELEMETRY_BAUDRATE` in the virtual time, so the double buffering works as in the board.
+ *
+ * @date 2025-01-01
+ */
+#ifndef NATIVE_TELEMETRY_H_
+#define NATIVE_TELEMETRY_H_
+
+/* Includes ------------------------------------------------------------------*/
+/* Standard C includes */
+#include <stdint.h>
+
+/* Defines and enums ----------------------------------------------------------*/
+#define NATIVE_TELEMETRY_BAUDRATE 115200U /*!< Emulated baud rate (8N1: 10 bits per byte). Same value as in the STM32F4 port */
+#define NATIVE_TELEMETRY_IRQ_PRIO 7U      /*!< Priority of the emulated DMA interrupt. Same value as in the STM32F4 port */
+
+/* Function prototypes and explanation -------------------------------------------------*/
+/**
+ * @brief Select the file descriptor where the frames are written. It must be called before `port_telemetry_init()`.
+ *
+ * @param fd File descriptor. -1 discards the frames
+ */
+void native_telemetry_set_fd(int fd);
+
+/**
+ * @brief Emulated interrupt service routine of the DMA. Defined in native_interr.c.
+ */
+void native_telemetry_irq_handler(void);
+
+#endif /* NATIVE_TELEMETRY_H_ */
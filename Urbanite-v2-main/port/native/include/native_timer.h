@@ -0,0 +1,51 @@
+/**
+ * @file native_timer.h
+ * @brief Header for native_timer.c file.
+ *
+ * The emulated hardware timer of the software timers counts the microseconds of the virtual time. The virtual time advances in steps of 1 ms, so the compare match is checked by the System tick: the timers expire in order, but at the first millisecond at or after their expiry.
+ *
+ * @date 2025-01-01
+ */
+#ifndef NATIVE_TIMER_H_
+#define NATIVE_TIMER_H_
+
+/* Includes ------------------------------------------------------------------*/
+/* Standard C includes */
+#include <stdint.h>
+#include <stdbool.h>
+
+/* Defines and enums ----------------------------------------------------------*/
+#define NATIVE_TIMER_IRQ_PRIO 5U /*!< Priority of the emulated timer interrupt. Same value as in the STM32F4 port */
+
+/* Typedefs --------------------------------------------------------------------*/
+/**
+ * @brief Emulated compare channel of the timer of a simulated unit (see native_instance.h)
+ */
+typedef struct
+{
+    uint32_t alarm_us;  /*!< Emulated compare register */
+    bool alarm_enabled; /*!< Emulated compare interrupt enable */
+} native_timer_hw_t;
+
+/* Function prototypes and explanation -------------------------------------------------*/
+/**
+ * @brief Check the compare match of the emulated timer. It is called from the emulated System tick ISR every millisecond.
+ *
+ * @param now_ms Current virtual time
+ */
+void native_timer_tick(uint32_t now_ms);
+
+/**
+ * @brief Get the milliseconds of virtual time before the System tick raises the compare match of the emulated timer (see native_system_skip_ms()).
+ *
+ * @param now_ms Current virtual time
+ * @return 0 if the System tick of the current millisecond raises it, `UINT32_MAX` if the compare is disabled
+ */
+uint32_t native_timer_get_next_event_ms(uint32_t now_ms);
+
+/**
+ * @brief Emulated interrupt service routine of the timer. Defined in native_interr.c.
+ */
+void native_timer_irq_handler(void);
+
+#endif /* NATIVE_TIMER_H_ */
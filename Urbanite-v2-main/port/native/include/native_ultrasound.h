@@ -0,0 +1,124 @@
+/**
+ * @file native_ultrasound.h
+ * @brief Header for native_ultrasound.c file.
+ *
+ * The emulated echo timer counts at 1 MHz with a 16-bit auto-reload, as TIM2 in the STM32F4 port, so the FSM sees the same ticks and overflows. It starts counting from 0 when a measurement starts, and every edge of the echo and every overflow is delivered in the millisecond of virtual time in which it happens, with the counter value of its microsecond.
+ *
+ * The duration of the echo pulses is a constant (`native_ultrasound_set_echo_us()`) or is computed for each measurement by an echo source, e.g., the acoustic world model of native_world.h.
+ *
+ * @date 2025-01-01
+ */
+#ifndef NATIVE_ULTRASOUND_H_
+#define NATIVE_ULTRASOUND_H_
+
+/* Includes ------------------------------------------------------------------*/
+/* Standard C includes */
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdatomic.h>
+
+/* HW dependent includes */
+#include "port_ultrasound.h"
+#include "port_timer.h"
+
+/* Defines and enums ----------------------------------------------------------*/
+/* Defines */
+#define NATIVE_ULTRASOUND_ECHO_IRQ_PRIO 3U                                /*!< Priority of the emulated echo timer interrupt. Same value as in the STM32F4 port */
+#define NATIVE_ULTRASOUND_TRIGGER_IRQ_PRIO 4U                             /*!< Priority of the emulated trigger timer interrupt. Same value as in the STM32F4 port */
+#define NATIVE_ULTRASOUND_ECHO_TIMER_ARR 0xFFFFU                          /*!< Auto-reload of the emulated echo timer */
+#define NATIVE_ULTRASOUND_TRIGGER_US ((uint32_t)PORT_PARKING_SENSOR_TRIGGER_UP_US) /*!< Duration of the trigger pulse */
+#define NATIVE_ULTRASOUND_ECHO_START_US 200U                              /*!< Time from the end of the trigger to the rising edge of the echo, when the burst is sent */
+#define NATIVE_ULTRASOUND_NUM_SENSORS (PORT_REAR_PARKING_SENSOR_ID + 1U) /*!< Number of emulated sensors of a simulated unit */
+
+/* Typedefs --------------------------------------------------------------------*/
+/**
+ * @brief Source of the echo pulses of an emulated sensor. It is called once per measurement, when the burst is sent.
+ *
+ * @param p_arg Argument given with the source
+ * @param ultrasound_id Ultrasound ID
+ * @param burst_us Virtual time of the rising edge of the echo pin, in microseconds
+ * @return Duration of the echo pulse in microseconds. 0 means that the echo pin does not rise
+ */
+typedef uint32_t (*native_ultrasound_echo_source_t)(void *p_arg, uint32_t ultrasound_id, uint64_t burst_us);
+
+/**
+ * @brief Emulated ultrasound sensor and timers of a simulated unit (see native_instance.h)
+ */
+typedef struct
+{
+    _Atomic uint32_t flags;   /*!< Flags shared with the ISRs (trigger ready, trigger end and echo received)*/
+    uint32_t echo_init_tick;  /*!< Tick time when the echo signal was received*/
+    uint32_t echo_end_tick;   /*!< Tick time when the echo signal was received*/
+    uint32_t echo_overflows;  /*!< Number of overflows of the timer during the echo signal*/
+    bool trigger_timer_en;    /*!< Emulated trigger timer enabled*/
+    bool echo_timer_en;       /*!< Emulated echo timer enabled*/
+    bool echo_armed;          /*!< An echo is expected after the current trigger*/
+    bool trigger_fired;       /*!< The trigger timer expired during the current measurement*/
+    uint32_t echo_us;         /*!< Duration of the emulated echo pulses in microseconds, if there is no echo source*/
+    native_ultrasound_echo_source_t echo_source; /*!< Source of the duration of the echo pulses. NULL to use `echo_us`*/
+    void *p_echo_source_arg;  /*!< Argument of the echo source*/
+    uint64_t echo_timer_start_us; /*!< Virtual time at which the emulated echo timer started counting*/
+    uint64_t echo_next_overflow_us; /*!< Virtual time of the next overflow of the emulated echo timer*/
+    uint64_t echo_rise_us;    /*!< Virtual time of the rising edge of the current echo pulse*/
+    uint64_t echo_fall_us;    /*!< Virtual time of the falling edge of the current echo pulse*/
+    uint8_t echo_edges;       /*!< Edges of the current echo pulse not delivered yet (2: both, 1: falling, 0: none)*/
+    uint32_t capture;         /*!< Emulated capture register*/
+    bool capture_pending;     /*!< Emulated capture flag*/
+    bool overflow_pending;    /*!< Emulated update flag*/
+    port_timer_t measurement_timer; /*!< Software timer that controls the duration of the measurements*/
+} native_ultrasound_hw_t;
+
+/* Function prototypes and explanation -------------------------------------------------*/
+/**
+ * @brief Set the duration of the echo pulses that the emulated sensor returns.
+ *
+ * @param ultrasound_id Ultrasound ID. This index is used to select the element of the ultrasound_arr[] array
+ * @param echo_us Duration of the echo in microseconds. 0 means that no echo is received.
+ */
+void native_ultrasound_set_echo_us(uint32_t ultrasound_id, uint32_t echo_us);
+
+/**
+ * @brief Set the source of the echo pulses of the emulated sensor. It replaces the constant duration of `native_ultrasound_set_echo_us()`.
+ *
+ * @param ultrasound_id Ultrasound ID. This index is used to select the element of the ultrasound_arr[] array
+ * @param source Function that computes the duration of each echo pulse. NULL to use the constant duration again
+ * @param p_arg Argument given to the source
+ */
+void native_ultrasound_set_echo_source(uint32_t ultrasound_id, native_ultrasound_echo_source_t source, void *p_arg);
+
+/**
+ * @brief Set the value of the counter of the emulated echo timer at the rising edge of the current echo. It is called from an echo source, to reproduce the captures of a recorded echo (see port_trace.h).
+ *
+ * @param ultrasound_id Ultrasound ID. This index is used to select the element of the ultrasound_arr[] array
+ * @param counter Counter of the echo timer at the rising edge (`echo_init_tick`)
+ */
+void native_ultrasound_set_echo_counter(uint32_t ultrasound_id, uint32_t counter);
+
+/**
+ * @brief Read and clear the capture flag of the emulated echo timer (CC2IF in the STM32F4).
+ *
+ * @param ultrasound_id Ultrasound ID. This index is used to select the element of the ultrasound_arr[] array
+ * @param p_tick Pointer to store the captured counter value (CCR2 in the STM32F4)
+ * @return true if there was a capture pending
+ */
+bool native_ultrasound_get_echo_capture(uint32_t ultrasound_id, uint32_t *p_tick);
+
+/**
+ * @brief Read and clear the update flag of the emulated echo timer (UIF in the STM32F4).
+ *
+ * @param ultrasound_id Ultrasound ID. This index is used to select the element of the ultrasound_arr[] array
+ * @return true if the timer overflowed
+ */
+bool native_ultrasound_get_echo_overflow(uint32_t ultrasound_id);
+
+/**
+ * @brief Emulated interrupt service routine of the echo timer. Defined in native_interr.c.
+ */
+void native_ultrasound_echo_irq_handler(void);
+
+/**
+ * @brief Emulated interrupt service routine of the trigger timer. Defined in native_interr.c.
+ */
+void native_ultrasound_trigger_irq_handler(void);
+
+#endif /* NATIVE_ULTRASOUND_H_ */
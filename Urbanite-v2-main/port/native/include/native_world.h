@@ -0,0 +1,85 @@
+/**
+ * @file native_world.h
+ * @brief Header for native_world.c file.
+ *
+ * Acoustic world model of the native (host) platform. It computes the echo of every measurement of the emulated ultrasound sensors from the obstacles around the car: their trajectories, the beam of the sensors, the speed of sound at the current temperature, noise, missing echoes, multipath ghosts and the crosstalk of other sensors. It is an echo source of native_ultrasound.h, so the echo timer receives the edges at the microsecond in which they happen.
+ *
+ * The scenario is a text stream read line by line as the virtual time advances, so a drive of any length runs in constant memory. Distances are in cm, angles in degrees, times in ms; `#` starts a comment:
+ *
+ * - `sensor <id> <x> <y> <heading> <half_angle> <period>`: sensor mounted at (x, y) of the car, pointing at `heading`, with a beam of `half_angle` at each side. `period` is 0 for the sensors of the port, or the period of the bursts of a sensor of another car, which is only a source of crosstalk.
+ * - `noise <sigma_us> <outlier_prob> <outlier_scale_us> <miss_prob> <ghost_prob> <crosstalk_prob>`: Gaussian jitter of the echoes, probability and scale of heavy-tailed (Cauchy) outliers, and probabilities of a missing echo, of a multipath ghost (the echo that bounces twice between the car and the obstacle) and of taking the burst of another sensor as the echo.
+ * - `<t> temp <celsius>`: air temperature from time `t`.
+ * - `<t> obj <id> <x> <y> <vx> <vy>`: obstacle `id` is at (x, y) at time `t` and moves at (vx, vy) cm/s from then on.
+ * - `<t> gone <id>`: obstacle `id` disappears at time `t`.
+ *
+ * The timed lines must be in order of time. The sensor and noise lines may appear anywhere, and apply from the point of the stream where they are read.
+ *
+ * @date 2025-01-01
+ */
+#ifndef NATIVE_WORLD_H_
+#define NATIVE_WORLD_H_
+
+/* Includes ------------------------------------------------------------------*/
+/* Standard C includes */
+#include <stdio.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+/* Defines and enums ----------------------------------------------------------*/
+#define NATIVE_WORLD_MAX_SENSORS 8U         /*!< Sensors of the scenario: the ones of the port and the ones of other cars */
+#define NATIVE_WORLD_MAX_OBSTACLES 16U      /*!< Obstacles present at the same time */
+#define NATIVE_WORLD_MAX_RANGE_CM 400.0     /*!< Farthest obstacle that returns an echo */
+#define NATIVE_WORLD_NO_ECHO_US 38000U      /*!< Duration of the echo pulse when no echo is received (timeout of the HC-SR04) */
+#define NATIVE_WORLD_DEFAULT_TEMP_C 20.0    /*!< Air temperature until the scenario sets it */
+
+/* Typedefs --------------------------------------------------------------------*/
+typedef struct native_world_t native_world_t; /*!< Acoustic world model. Defined in native_world.c */
+
+/* Function prototypes and explanation -------------------------------------------------*/
+/**
+ * @brief Create a world model that reads its scenario from a stream.
+ *
+ * @param p_scenario Stream of the scenario. It must stay open until the world is destroyed, and it is not closed by the world
+ * @param seed Seed of the random noise. The same scenario and seed give the same echoes
+ * @return Pointer to the world. NULL if there is no memory
+ */
+native_world_t *native_world_new(FILE *p_scenario, uint64_t seed);
+
+/**
+ * @brief Free a world model. The sensors attached to it must be detached first.
+ *
+ * @param p_world Pointer to the world
+ */
+void native_world_destroy(native_world_t *p_world);
+
+/**
+ * @brief Make the world the echo source of an emulated sensor of the simulated unit selected in the calling thread.
+ *
+ * @param p_world Pointer to the world
+ * @param ultrasound_id Ultrasound ID. It is also the `id` of the sensor in the scenario
+ */
+void native_world_attach(native_world_t *p_world, uint32_t ultrasound_id);
+
+/**
+ * @brief Compute the echo of a burst of a sensor. It is the echo source given to native_ultrasound.h by `native_world_attach()`.
+ *
+ * The scenario is read up to the time of the burst, so the bursts of all the sensors must come in order of time.
+ *
+ * @param p_arg Pointer to the world
+ * @param ultrasound_id Sensor ID in the scenario
+ * @param burst_us Virtual time of the burst, in microseconds
+ * @return Duration of the echo pulse in microseconds. `NATIVE_WORLD_NO_ECHO_US` if no echo is received
+ */
+uint32_t native_world_get_echo_us(void *p_arg, uint32_t ultrasound_id, uint64_t burst_us);
+
+/**
+ * @brief Get the true distance from a sensor to the closest obstacle in its beam, at the time of its last burst.
+ *
+ * @param p_world Pointer to the world
+ * @param ultrasound_id Sensor ID in the scenario
+ * @param p_distance_cm Pointer to store the distance
+ * @return true if there was an obstacle in the beam
+ */
+bool native_world_get_true_distance(native_world_t *p_world, uint32_t ultrasound_id, double *p_distance_cm);
+
+#endif /* NATIVE_WORLD_H_ */
@@ -0,0 +1,108 @@
+/**
+ * @file native_button.c
+ * @brief Portable functions to interact with the button FSM library in the native (host) platform.
+ * @date 2025-01-01
+ */
+/*Includes-----------------------------*/
+/*Standard C includes*/
+#include <stddef.h>
+#include <stdatomic.h>
+
+/* HW dependent includes */
+#include "port_button.h"
+#include "port_system.h"
+#include "native_system.h"
+#include "native_button.h"
+#include "native_instance.h"
+
+/*Defines ------------------------------------------------------*/
+#define NATIVE_BUTTON_FLAG_PRESSED 0U /*!< Position of the pressed flag in the flag word of a button */
+
+/*Private functions--------------------------------*/
+/**
+ * @brief Get the button status struct with the given ID, in the simulated unit selected in the calling thread
+ * @param button_id Button ID.
+ * @return Pointer to the button state struct
+ * @return NULL if the button ID is not valid
+ */
+static native_button_hw_t *_native_button_get(uint32_t button_id)
+{
+    if (button_id < NATIVE_BUTTON_NUM_BUTTONS)
+    {
+        return &native_instance_get()->buttons_arr[button_id];
+    }
+    return NULL;
+}
+
+/*Public functions -------------------------*/
+void port_button_init(uint32_t button_id)
+{
+    native_button_hw_t *p_button = _native_button_get(button_id);
+    atomic_store(&p_button->flags, 0);
+    p_button->value = true;
+    p_button->exti_pending = false;
+    p_button->exti_enabled = true;
+    native_system_irq_config(NATIVE_SYSTEM_IRQ_BUTTON, NATIVE_BUTTON_IRQ_PRIO, native_button_irq_handler);
+}
+
+bool port_button_get_pressed(uint32_t button_id)
+{
+    native_button_hw_t *p_button = _native_button_get(button_id);
+    return native_system_flag_test(&p_button->flags, NATIVE_BUTTON_FLAG_PRESSED);
+}
+
+bool port_button_get_value(uint32_t button_id)
+{
+    native_button_hw_t *p_button = _native_button_get(button_id);
+    return p_button->value;
+}
+
+void port_button_set_pressed(uint32_t button_id, bool pressed)
+{
+    native_button_hw_t *p_button = _native_button_get(button_id);
+    if (pressed)
+    {
+        native_system_flag_set(&p_button->flags, NATIVE_BUTTON_FLAG_PRESSED);
+    }
+    else
+    {
+        native_system_flag_clear(&p_button->flags, NATIVE_BUTTON_FLAG_PRESSED);
+    }
+}
+
+bool port_button_get_pending_interrupt(uint32_t button_id)
+{
+    native_button_hw_t *p_button = _native_button_get(button_id);
+    if (p_button == NULL)
+    {
+        return false;
+    }
+    return p_button->exti_pending;
+}
+
+void port_button_clear_pending_interrupt(uint32_t button_id)
+{
+    native_button_hw_t *p_button = _native_button_get(button_id);
+    p_button->exti_pending = false;
+}
+
+void port_button_disable_interrupts(uint32_t button_id)
+{
+    native_button_hw_t *p_button = _native_button_get(button_id);
+    p_button->exti_enabled = false;
+}
+
+void native_button_set_value(uint32_t button_id, bool value)
+{
+    native_button_hw_t *p_button = _native_button_get(button_id);
+    if ((p_button == NULL) || (p_button->value == value))
+    {
+        return;
+    }
+    p_button->value = value;
+    if (p_button->exti_enabled)
+    {
+        p_button->exti_pending = true;
+        native_system_irq_raise(NATIVE_SYSTEM_IRQ_BUTTON);
+    }
+}
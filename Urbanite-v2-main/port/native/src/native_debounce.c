@@ -0,0 +1,117 @@
+/**
+ * @file native_debounce.c
+ * @brief Portable functions of the multi-key debounce engine for the native (host) platform.
+ *
+ * All the emulated keys are bits of a single input word, sampled by the virtual time every `PORT_DEBOUNCE_PERIOD_MS`.
+ *
+ * @date 2025-01-01
+ */
+/*Includes-----------------------------*/
+/* HW dependent includes */
+#include "port_debounce.h"
+#include "port_system.h"
+#include "native_system.h"
+#include "native_debounce.h"
+
+/*Defines ------------------------------------------------------*/
+#define NATIVE_DEBOUNCE_TICK_HOOK 1U /*!< Slot of the engine in the virtual time hooks */
+
+/*Global variables -------------------------------*/
+static uint32_t raw_input = 0;                                     /*!< Emulated input word (1: pressed) */
+static port_debounce_vcnt_t vcnt;                                  /*!< Vertical counter of the keys */
+static port_debounce_event_t events_arr[PORT_DEBOUNCE_QUEUE_SIZE]; /*!< Queue of events */
+static volatile uint32_t events_head = 0;                          /*!< Index of the next event to write */
+static volatile uint32_t events_tail = 0;                          /*!< Index of the next event to read */
+static volatile uint32_t events_dropped = 0;                       /*!< Events lost because the queue was full */
+
+/*Private functions--------------------------------*/
+/**
+ * @brief Queue an event
+ * @param key_id Key ID
+ * @param pressed New debounced state
+ * @param now_ms Timestamp
+ */
+static void _native_debounce_push_event(uint8_t key_id, bool pressed, uint32_t now_ms)
+{
+    uint32_t head = events_head;
+    if ((head - events_tail) >= PORT_DEBOUNCE_QUEUE_SIZE)
+    {
+        events_dropped++;
+        return;
+    }
+    port_debounce_event_t *p_event = &events_arr[head & (PORT_DEBOUNCE_QUEUE_SIZE - 1U)];
+    p_event->timestamp_ms = now_ms;
+    p_event->key_id = key_id;
+    p_event->pressed = pressed;
+    events_head = head + 1U;
+}
+
+/**
+ * @brief Sample the emulated keys every PORT_DEBOUNCE_PERIOD_MS
+ * @param now_ms Current virtual time
+ */
+static void _native_debounce_tick(uint32_t now_ms)
+{
+    uint32_t t = now_ms + 1U; /* The hook runs before the System tick increments the time */
+    if ((t % PORT_DEBOUNCE_PERIOD_MS) != 0U)
+    {
+        return;
+    }
+    uint32_t toggled = port_debounce_vcnt_step(&vcnt, raw_input);
+    while (toggled != 0U)
+    {
+        uint32_t key_id = 31U - (uint32_t)__builtin_clz(toggled);
+        toggled &= ~(1U << key_id);
+        _native_debounce_push_event((uint8_t)key_id, (vcnt.state & (1U << key_id)) != 0U, t);
+    }
+}
+
+/*Public functions -------------------------*/
+void port_debounce_init(void)
+{
+    vcnt.ct0 = 0xFFFFFFFFU;
+    vcnt.ct1 = 0xFFFFFFFFU;
+    vcnt.state = 0;
+    raw_input = 0;
+    events_tail = events_head;
+    events_dropped = 0;
+    native_system_set_tick_hook(NATIVE_DEBOUNCE_TICK_HOOK, _native_debounce_tick);
+}
+
+void native_debounce_set_raw(uint32_t key_id, bool pressed)
+{
+    if (key_id >= PORT_DEBOUNCE_MAX_KEYS)
+    {
+        return;
+    }
+    if (pressed)
+    {
+        raw_input |= (1U << key_id);
+    }
+    else
+    {
+        raw_input &= ~(1U << key_id);
+    }
+}
+
+bool port_debounce_get_event(port_debounce_event_t *p_event)
+{
+    uint32_t tail = events_tail;
+    if (tail == events_head)
+    {
+        return false;
+    }
+    *p_event = events_arr[tail & (PORT_DEBOUNCE_QUEUE_SIZE - 1U)];
+    events_tail = tail + 1U;
+    return true;
+}
+
+bool port_debounce_get_pressed(uint32_t key_id)
+{
+    return (key_id < PORT_DEBOUNCE_MAX_KEYS) && ((vcnt.state & (1U << key_id)) != 0U);
+}
+
+uint32_t port_debounce_get_dropped_events(void)
+{
+    return events_dropped;
+}
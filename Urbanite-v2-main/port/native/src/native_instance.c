@@ -0,0 +1,54 @@
+/**
+ * @file native_instance.c
+ * @brief Simulated units of the native (host) platform.
+ * @date 2025-01-01
+ */
+
+/* Standard C includes */
+#include <stdlib.h>
+#include <string.h>
+
+/* HW dependent includes */
+#include "native_instance.h"
+
+/* Defines ----------------------------------------------------------------------*/
+/**
+ * @brief Values of a unit at reset: the thread context runs at the lowest priority and the buttons are released (active low). The rest is 0
+ */
+#define NATIVE_INSTANCE_RESET_VALUE                                         \
+    {                                                                       \
+        .system = {.active_prio = NATIVE_SYSTEM_THREAD_PRIO},               \
+        .buttons_arr = {[PORT_PARKING_BUTTON_ID] = {.value = true}},        \
+    }
+
+/* Global variables -----------------------------------------------------------*/
+static native_instance_t default_instance = NATIVE_INSTANCE_RESET_VALUE; /*!< Unit of the threads that do not select one */
+_Thread_local native_instance_t *native_instance_current = &default_instance;
+
+/* Public functions -----------------------------------------------------------*/
+native_instance_t *native_instance_new(void)
+{
+    static const native_instance_t reset_value = NATIVE_INSTANCE_RESET_VALUE;
+    native_instance_t *p_instance = malloc(sizeof(native_instance_t));
+    if (p_instance != NULL)
+    {
+        memcpy(p_instance, &reset_value, sizeof(native_instance_t));
+    }
+    return p_instance;
+}
+
+void native_instance_destroy(native_instance_t *p_instance)
+{
+    if (native_instance_current == p_instance)
+    {
+        native_instance_current = &default_instance;
+    }
+    free(p_instance);
+}
+
+native_instance_t *native_instance_select(native_instance_t *p_instance)
+{
+    native_instance_t *p_previous = native_instance_current;
+    native_instance_current = (p_instance != NULL) ? p_instance : &default_instance;
+    return p_previous;
+}
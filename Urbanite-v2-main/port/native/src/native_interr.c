@@ -0,0 +1,117 @@
+/**
+ * @file native_interr.c
+ * @brief Emulated interrupt service routines for the native (host) platform.
+ *
+ * They mirror the ISRs of the STM32F4 port (interr.c), reading the emulated peripherals instead of the registers. The latency of the ISR statistics is the time since the interrupt was raised.
+ *
+ * @date 2025-01-01
+ */
+// Include HW dependencies:
+#include "port_system.h"
+#include "native_system.h"
+#include "port_button.h"
+#include "native_button.h"
+#include "port_ultrasound.h"
+#include "native_ultrasound.h"
+#include "port_timer.h"
+#include "native_timer.h"
+#include "port_telemetry.h"
+#include "native_telemetry.h"
+#include "port_isr_stats.h"
+#include "port_latency.h"
+#include "port_trace.h"
+
+//------------------------------------------------------
+// INTERRUPT SERVICE ROUTINES
+//------------------------------------------------------
+/**
+ * @brief Emulated System tick interrupt service routine. It increments the tick counter by one millisecond and checks the compare match of the emulated timer.
+ */
+void native_system_systick_irq_handler(void)
+{
+    PORT_ISR_STATS_ENTER(PORT_ISR_ID_SYSTICK, native_system_irq_get_latency(NATIVE_SYSTEM_IRQ_SYSTICK));
+    uint32_t msTicks_actual = port_system_get_millis();
+    port_system_set_millis(msTicks_actual + 1);
+    native_timer_tick(msTicks_actual + 1);
+    PORT_ISR_STATS_EXIT(PORT_ISR_ID_SYSTICK);
+}
+
+/**
+ * @brief Emulated external interrupt service routine of the buttons.
+ */
+void native_button_irq_handler(void)
+{
+    PORT_ISR_STATS_ENTER(PORT_ISR_ID_BUTTON, native_system_irq_get_latency(NATIVE_SYSTEM_IRQ_BUTTON));
+    if (port_button_get_pending_interrupt(PORT_PARKING_BUTTON_ID))
+    {
+        /* The button is active low */
+        port_button_set_pressed(PORT_PARKING_BUTTON_ID, !port_button_get_value(PORT_PARKING_BUTTON_ID));
+        PORT_TRACE_RECORD(PORT_TRACE_BUTTON, PORT_PARKING_BUTTON_ID, port_button_get_value(PORT_PARKING_BUTTON_ID), 0);
+        port_button_clear_pending_interrupt(PORT_PARKING_BUTTON_ID);
+    }
+    PORT_ISR_STATS_EXIT(PORT_ISR_ID_BUTTON);
+}
+
+/**
+ * @brief Emulated interrupt service routine of the echo timer.
+ *
+ * It counts the overflows of the timer during the echo and stores the ticks of the rising and falling edges.
+ */
+void native_ultrasound_echo_irq_handler(void)
+{
+    PORT_ISR_STATS_ENTER(PORT_ISR_ID_ECHO, native_system_irq_get_latency(NATIVE_SYSTEM_IRQ_ECHO));
+    uint32_t current_tick;
+
+    if (native_ultrasound_get_echo_overflow(PORT_REAR_PARKING_SENSOR_ID))
+    {
+        uint32_t current_overflows = port_ultrasound_get_echo_overflows(PORT_REAR_PARKING_SENSOR_ID) + 1;
+        port_ultrasound_set_echo_overflows(PORT_REAR_PARKING_SENSOR_ID, current_overflows);
+    }
+
+    if (native_ultrasound_get_echo_capture(PORT_REAR_PARKING_SENSOR_ID, &current_tick))
+    {
+        if ((port_ultrasound_get_echo_init_tick(PORT_REAR_PARKING_SENSOR_ID) == 0) && (port_ultrasound_get_echo_end_tick(PORT_REAR_PARKING_SENSOR_ID) == 0))
+        {
+            port_ultrasound_set_echo_init_tick(PORT_REAR_PARKING_SENSOR_ID, current_tick);
+            PORT_LATENCY_MARK(PORT_REAR_PARKING_SENSOR_ID, PORT_LATENCY_ECHO_RISE); /* The emulated ISR runs at the virtual time of the edge */
+        }
+        else
+        {
+            port_ultrasound_set_echo_end_tick(PORT_REAR_PARKING_SENSOR_ID, current_tick);
+            port_ultrasound_set_echo_received(PORT_REAR_PARKING_SENSOR_ID, true);
+            PORT_LATENCY_MARK(PORT_REAR_PARKING_SENSOR_ID, PORT_LATENCY_ECHO_FALL);
+            PORT_TRACE_RECORD(PORT_TRACE_ECHO, PORT_REAR_PARKING_SENSOR_ID, port_ultrasound_get_echo_overflows(PORT_REAR_PARKING_SENSOR_ID), port_ultrasound_get_echo_init_tick(PORT_REAR_PARKING_SENSOR_ID) | (current_tick << 16));
+        }
+    }
+    PORT_ISR_STATS_EXIT(PORT_ISR_ID_ECHO);
+}
+
+/**
+ * @brief Emulated interrupt service routine of the trigger timer. The trigger signal has to be lowered.
+ */
+void native_ultrasound_trigger_irq_handler(void)
+{
+    PORT_ISR_STATS_ENTER(PORT_ISR_ID_TRIGGER, native_system_irq_get_latency(NATIVE_SYSTEM_IRQ_TRIGGER));
+    port_ultrasound_set_trigger_end(PORT_REAR_PARKING_SENSOR_ID, true);
+    PORT_ISR_STATS_EXIT(PORT_ISR_ID_TRIGGER);
+}
+
+/**
+ * @brief Emulated interrupt service routine of the time base of the software timers.
+ */
+void native_timer_irq_handler(void)
+{
+    PORT_ISR_STATS_ENTER(PORT_ISR_ID_TIMER, native_system_irq_get_latency(NATIVE_SYSTEM_IRQ_TIMER));
+    port_timer_irq_handler();
+    PORT_ISR_STATS_EXIT(PORT_ISR_ID_TIMER);
+}
+
+/**
+ * @brief Emulated interrupt service routine of the DMA of the telemetry UART. The frame has been sent.
+ */
+void native_telemetry_irq_handler(void)
+{
+    PORT_ISR_STATS_ENTER(PORT_ISR_ID_TELEMETRY, native_system_irq_get_latency(NATIVE_SYSTEM_IRQ_TELEMETRY));
+    port_telemetry_tx_complete_irq_handler();
+    PORT_ISR_STATS_EXIT(PORT_ISR_ID_TELEMETRY);
+}
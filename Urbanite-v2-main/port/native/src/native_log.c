@@ -0,0 +1,48 @@
+/**
+ * @file native_log.c
+ * @brief Drain of the deferred logger for the native (host) platform.
+ * @date 2025-01-01
+ */
+
+/* Standard C includes */
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+
+/* HW dependent includes */
+#include "port_log.h"
+#include "native_log.h"
+
+/* Global variables */
+static FILE *p_sink = NULL;        /*!< File where the records are written */
+static bool sink_selected = false; /*!< The sink has been selected by `native_log_set_sink()` */
+
+/* Public functions -----------------------------------------------------------*/
+void native_log_set_sink(FILE *p_file)
+{
+    p_sink = p_file;
+    sink_selected = true;
+}
+
+void port_log_hw_init(void)
+{
+    if (!sink_selected)
+    {
+        const char *p_path = getenv("URBANITE_LOG_FILE");
+        if ((p_path != NULL) && (p_sink == NULL))
+        {
+            p_sink = fopen(p_path, "wb");
+        }
+    }
+}
+
+uint32_t port_log_hw_write(const uint32_t *p_words, uint32_t num_words)
+{
+    if (p_sink == NULL)
+    {
+        return 0;
+    }
+    uint32_t sent = (uint32_t)fwrite(p_words, sizeof(uint32_t), num_words, p_sink);
+    fflush(p_sink);
+    return sent;
+}
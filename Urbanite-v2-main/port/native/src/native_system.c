@@ -0,0 +1,286 @@
+/**
+ * @file native_system.c
+ * @brief This file implements port layer for the system functions in the native (host) platform.
+ *
+ * The interrupt controller emulation works as the NVIC with 4 bits of preemption priority: a handler only preempts code running at a lower priority, and the critical sections mask the handlers whose priority is equal to or lower than `NATIVE_SYSTEM_CRITICAL_PRIO`, as BASEPRI does in the STM32F4 port.
+ *
+ * @date 2025-01-01
+ */
+
+/* Standard C includes */
+#define _POSIX_C_SOURCE 199309L /* clock_gettime() */
+#include <stddef.h>
+#include <time.h>
+
+/* HW dependent includes */
+#include "port_system.h"
+#include "native_system.h"
+#include "native_instance.h"
+#include "native_timer.h"
+#include "port_timer.h"
+#include "port_log.h"
+
+//------------------------------------------------------
+// FILE-SPECIFIC DEFINITIONS
+//------------------------------------------------------
+#define SYSTICK_PRIO 0U /*!< Priority of the System tick. It must be the highest */
+
+//------------------------------------------------------
+// PRIVATE (STATIC) FUNCTIONS
+//------------------------------------------------------
+/**
+ * @brief Get the virtual time and the interrupt controller of the unit selected in the calling thread.
+ *
+ * @return Pointer to the state
+ */
+static inline native_system_state_t *_native_system_get(void)
+{
+  return &native_instance_get()->system;
+}
+
+/**
+ * @brief Check if an interrupt can preempt the code that is currently running.
+ *
+ * @param p_system Pointer to the state of the unit
+ * @param irq Interrupt line
+ * @return true if the handler can run now
+ */
+static bool _native_system_irq_can_run(native_system_state_t *p_system, uint32_t irq)
+{
+  uint8_t prio = p_system->irq_prio[irq];
+  if (p_system->irqs_disabled)
+  {
+    return false;
+  }
+  if ((p_system->critical_nesting > 0) && (prio >= NATIVE_SYSTEM_CRITICAL_PRIO))
+  {
+    return false;
+  }
+  return prio < p_system->active_prio;
+}
+
+/**
+ * @brief Serve the pending interrupts that are not masked, from the highest to the lowest priority.
+ *
+ * @param p_system Pointer to the state of the unit
+ */
+static void _native_system_irq_serve_pending(native_system_state_t *p_system)
+{
+  bool served = true;
+  while (served && (p_system->pending_irqs != 0))
+  {
+    served = false;
+    uint32_t best = NATIVE_SYSTEM_NUM_IRQS;
+    for (uint32_t irq = 0; irq < NATIVE_SYSTEM_NUM_IRQS; irq++)
+    {
+      if ((p_system->pending_irqs & (1U << irq)) && _native_system_irq_can_run(p_system, irq) && ((best == NATIVE_SYSTEM_NUM_IRQS) || (p_system->irq_prio[irq] < p_system->irq_prio[best])))
+      {
+        best = irq;
+      }
+    }
+    if (best < NATIVE_SYSTEM_NUM_IRQS)
+    {
+      uint8_t prev_prio = p_system->active_prio;
+      p_system->pending_irqs &= ~(1U << best);
+      p_system->active_prio = p_system->irq_prio[best];
+      p_system->irq_handlers[best]();
+      p_system->active_prio = prev_prio;
+      served = true;
+    }
+  }
+}
+
+//------------------------------------------------------
+// PUBLIC (GLOBAL) FUNCTIONS
+//------------------------------------------------------
+uint32_t port_system_init()
+{
+  native_system_reset();
+  port_log_init();
+  return 0;
+}
+
+void native_system_reset(void)
+{
+  native_system_state_t *p_system = _native_system_get();
+  p_system->msTicks = 0;
+  p_system->critical_nesting = 0;
+  p_system->irqs_disabled = false;
+  p_system->active_prio = NATIVE_SYSTEM_THREAD_PRIO;
+  p_system->pending_irqs = 0;
+  native_system_irq_config(NATIVE_SYSTEM_IRQ_SYSTICK, SYSTICK_PRIO, native_system_systick_irq_handler);
+  port_timer_init();
+}
+
+//------------------------------------------------------
+// TIMER RELATED FUNCTIONS
+//------------------------------------------------------
+void port_system_delay_ms(uint32_t ms)
+{
+  native_system_advance_ms(ms);
+}
+
+void port_system_delay_until_ms(uint32_t *p_t, uint32_t ms)
+{
+  uint32_t until = *p_t + ms;
+  uint32_t now = port_system_get_millis();
+  if (until > now)
+  {
+    port_system_delay_ms(until - now);
+  }
+  *p_t = port_system_get_millis();
+}
+
+uint32_t port_system_get_millis()
+{
+  return _native_system_get()->msTicks;
+}
+
+void port_system_set_millis(uint32_t ms)
+{
+  _native_system_get()->msTicks = ms;
+}
+
+void port_system_sleep(void)
+{
+  native_system_advance_ms(1); /* The next interrupt is the System tick at the latest */
+}
+
+void port_system_disable_interrupts(void)
+{
+  _native_system_get()->irqs_disabled = true;
+}
+
+void port_system_enable_interrupts(void)
+{
+  native_system_state_t *p_system = _native_system_get();
+  p_system->irqs_disabled = false;
+  _native_system_irq_serve_pending(p_system); /* Interrupts raised while they were masked run now */
+}
+
+uint32_t port_system_get_cycles(void)
+{
+  /* The host counts nanoseconds of real time, so the execution times of the host code can be measured even though the system time is virtual */
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (uint32_t)((uint64_t)ts.tv_sec * 1000000000U + (uint64_t)ts.tv_nsec);
+}
+
+uint32_t port_system_get_cycles_per_us(void)
+{
+  return 1000U;
+}
+
+//------------------------------------------------------
+// CRITICAL SECTIONS
+//------------------------------------------------------
+void port_system_enter_critical(void)
+{
+  _native_system_get()->critical_nesting++;
+}
+
+void port_system_exit_critical(void)
+{
+  native_system_state_t *p_system = _native_system_get();
+  if (p_system->critical_nesting > 0)
+  {
+    p_system->critical_nesting--;
+    if ((p_system->critical_nesting == 0) && (p_system->pending_irqs != 0))
+    {
+      _native_system_irq_serve_pending(p_system); /* Interrupts raised inside the critical section run now */
+    }
+  }
+}
+
+// ------------------------------------------------------
+// Implementation of the functions of the emulated interrupt controller. They are declared in the native_system.h file.
+// ------------------------------------------------------
+void native_system_irq_config(uint32_t irq, uint8_t priority, native_system_irq_handler_t handler)
+{
+  native_system_state_t *p_system = _native_system_get();
+  if (irq < NATIVE_SYSTEM_NUM_IRQS)
+  {
+    p_system->irq_prio[irq] = priority;
+    p_system->irq_handlers[irq] = handler;
+    p_system->pending_irqs &= ~(1U << irq);
+  }
+}
+
+void native_system_irq_raise(uint32_t irq)
+{
+  native_system_state_t *p_system = _native_system_get();
+  if ((irq >= NATIVE_SYSTEM_NUM_IRQS) || (p_system->irq_handlers[irq] == NULL))
+  {
+    return;
+  }
+  if ((p_system->pending_irqs & (1U << irq)) == 0)
+  {
+    p_system->irq_raise_cycles[irq] = port_system_get_cycles(); /* A raise of a pending interrupt is lost, as in the NVIC */
+  }
+  p_system->pending_irqs |= (1U << irq);
+  _native_system_irq_serve_pending(p_system);
+}
+
+bool native_system_irq_get_pending(uint32_t irq)
+{
+  return (irq < NATIVE_SYSTEM_NUM_IRQS) && ((_native_system_get()->pending_irqs & (1U << irq)) != 0);
+}
+
+uint32_t native_system_irq_get_latency(uint32_t irq)
+{
+  return (irq < NATIVE_SYSTEM_NUM_IRQS) ? (port_system_get_cycles() - _native_system_get()->irq_raise_cycles[irq]) : 0U;
+}
+
+void native_system_set_tick_hook(uint32_t hook_id, native_system_tick_hook_t hook)
+{
+  if (hook_id < NATIVE_SYSTEM_NUM_TICK_HOOKS)
+  {
+    _native_system_get()->tick_hooks[hook_id] = hook;
+  }
+}
+
+void native_system_set_next_event_hook(uint32_t hook_id, native_system_next_event_hook_t hook)
+{
+  if (hook_id < NATIVE_SYSTEM_NUM_TICK_HOOKS)
+  {
+    _native_system_get()->next_event_hooks[hook_id] = hook;
+  }
+}
+
+uint32_t native_system_skip_ms(uint32_t ms)
+{
+  native_system_state_t *p_system = _native_system_get();
+  if ((p_system->pending_irqs != 0) || (p_system->critical_nesting > 0) || p_system->irqs_disabled)
+  {
+    return 0;
+  }
+  uint32_t now_ms = p_system->msTicks;
+  uint32_t skip_ms = native_timer_get_next_event_ms(now_ms);
+  for (uint32_t h = 0; h < NATIVE_SYSTEM_NUM_TICK_HOOKS; h++)
+  {
+    if (p_system->tick_hooks[h] != NULL)
+    {
+      uint32_t hook_ms = (p_system->next_event_hooks[h] != NULL) ? p_system->next_event_hooks[h](now_ms) : 0U;
+      skip_ms = (hook_ms < skip_ms) ? hook_ms : skip_ms;
+    }
+  }
+  skip_ms = (ms < skip_ms) ? ms : skip_ms;
+  p_system->msTicks = now_ms + skip_ms;
+  return skip_ms;
+}
+
+void native_system_advance_ms(uint32_t ms)
+{
+  native_system_state_t *p_system = _native_system_get();
+  for (uint32_t i = 0; i < ms; i++)
+  {
+    for (uint32_t h = 0; h < NATIVE_SYSTEM_NUM_TICK_HOOKS; h++)
+    {
+      if (p_system->tick_hooks[h] != NULL)
+      {
+        p_system->tick_hooks[h](p_system->msTicks);
+      }
+    }
+    native_system_irq_raise(NATIVE_SYSTEM_IRQ_SYSTICK);
+  }
+}
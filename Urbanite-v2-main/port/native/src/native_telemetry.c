@@ -0,0 +1,121 @@
+/**
+ * @file native_telemetry.c
+ * @brief Emulated UART and DMA of the telemetry stream for the native (host) platform.
+ * @date 2025-01-01
+ */
+
+/* Standard C includes */
+#define _DEFAULT_SOURCE   /* cfmakeraw() */
+#define _XOPEN_SOURCE 600 /* posix_openpt(), grantpt(), unlockpt(), ptsname() */
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <termios.h>
+
+/* HW dependent includes */
+#include "port_telemetry.h"
+#include "native_system.h"
+#include "native_telemetry.h"
+
+/* Defines ----------------------------------------------------------------------*/
+#define NATIVE_TELEMETRY_TICK_HOOK 2U     /*!< Slot of the emulated DMA in the virtual time hooks */
+#define NATIVE_TELEMETRY_BITS_PER_BYTE 10U /*!< Start bit, 8 data bits and stop bit */
+
+/* Global variables */
+static int tx_fd = -1;             /*!< File descriptor of the emulated UART */
+static bool fd_selected = false;   /*!< The descriptor has been selected by `native_telemetry_set_fd()` */
+static int pty_slave_fd = -1;      /*!< Slave side of the pseudo-terminal, kept open so its raw mode is not reset */
+static uint32_t tx_remaining_ms = 0; /*!< Virtual time until the end of the transmission. 0 if the DMA is idle */
+
+/* Private functions ----------------------------------------------------------*/
+/**
+ * @brief Create a pseudo-terminal in raw mode, so the bytes of the frames are not translated
+ * @return File descriptor of the master side. -1 if it cannot be created
+ */
+static int _native_telemetry_open_pty(void)
+{
+    int fd = posix_openpt(O_RDWR | O_NOCTTY);
+    if ((fd < 0) || (grantpt(fd) != 0) || (unlockpt(fd) != 0))
+    {
+        return -1;
+    }
+    const char *p_name = ptsname(fd);
+    pty_slave_fd = open(p_name, O_RDWR | O_NOCTTY);
+    if (pty_slave_fd >= 0)
+    {
+        struct termios tio;
+        tcgetattr(pty_slave_fd, &tio);
+        cfmakeraw(&tio);
+        tcsetattr(pty_slave_fd, TCSANOW, &tio);
+    }
+    fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) | O_NONBLOCK); /* A UART does not wait for the receiver */
+    fprintf(stderr, "Telemetry on %s\n", p_name);
+    return fd;
+}
+
+/**
+ * @brief Emulated DMA: raise the interrupt when the frame has been sent
+ * @param now_ms Current virtual time
+ */
+static void _native_telemetry_tick(uint32_t now_ms)
+{
+    (void)now_ms;
+    if ((tx_remaining_ms > 0U) && (--tx_remaining_ms == 0U))
+    {
+        native_system_irq_raise(NATIVE_SYSTEM_IRQ_TELEMETRY);
+    }
+}
+
+/* Public functions -----------------------------------------------------------*/
+void native_telemetry_set_fd(int fd)
+{
+    tx_fd = fd;
+    fd_selected = true;
+}
+
+void port_telemetry_hw_init(void)
+{
+    if (!fd_selected && (tx_fd < 0))
+    {
+        const char *p_path = getenv("URBANITE_TELEMETRY");
+        if ((p_path != NULL) && (strcmp(p_path, "pty") == 0))
+        {
+            tx_fd = _native_telemetry_open_pty();
+        }
+        else if (p_path != NULL)
+        {
+            tx_fd = open(p_path, O_WRONLY | O_CREAT | O_TRUNC, 0644); /* A FIFO blocks here until the reader opens it */
+        }
+    }
+    tx_remaining_ms = 0;
+    native_system_irq_config(NATIVE_SYSTEM_IRQ_TELEMETRY, NATIVE_TELEMETRY_IRQ_PRIO, native_telemetry_irq_handler);
+    native_system_set_tick_hook(NATIVE_TELEMETRY_TICK_HOOK, _native_telemetry_tick);
+}
+
+void port_telemetry_hw_start_tx(const uint8_t *p_data, uint32_t length)
+{
+    uint32_t written = 0;
+    while ((tx_fd >= 0) && (written < length))
+    {
+        ssize_t n = write(tx_fd, p_data + written, length - written);
+        if ((n < 0) && (errno == EINTR))
+        {
+            continue;
+        }
+        if (n <= 0)
+        {
+            break; /* Nobody is reading the pseudo-terminal: the rest of the frame is lost, as in a real UART */
+        }
+        written += (uint32_t)n;
+    }
+    uint32_t bits = length * NATIVE_TELEMETRY_BITS_PER_BYTE;
+    tx_remaining_ms = ((bits * 1000U) + NATIVE_TELEMETRY_BAUDRATE - 1U) / NATIVE_TELEMETRY_BAUDRATE;
+    if (tx_remaining_ms == 0U)
+    {
+        tx_remaining_ms = 1;
+    }
+}
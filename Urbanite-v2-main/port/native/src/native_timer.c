@@ -0,0 +1,69 @@
+/**
+ * @file native_timer.c
+ * @brief Emulated hardware timer of the software timers for the native (host) platform.
+ * @date 2025-01-01
+ */
+
+/* Standard C includes */
+#include <stdbool.h>
+
+/* HW dependent includes */
+#include "port_system.h"
+#include "port_timer.h"
+#include "native_system.h"
+#include "native_timer.h"
+#include "native_instance.h"
+
+/* Public functions -----------------------------------------------------------*/
+void port_timer_hw_init(void)
+{
+    native_instance_get()->timer.alarm_enabled = false;
+    native_system_irq_config(NATIVE_SYSTEM_IRQ_TIMER, NATIVE_TIMER_IRQ_PRIO, native_timer_irq_handler);
+}
+
+uint32_t port_timer_hw_get_micros(void)
+{
+    return port_system_get_millis() * 1000U;
+}
+
+void port_timer_hw_set_alarm(uint32_t at_us)
+{
+    native_timer_hw_t *p_timer = &native_instance_get()->timer;
+    p_timer->alarm_us = at_us;
+    p_timer->alarm_enabled = true;
+}
+
+void port_timer_hw_disable_alarm(void)
+{
+    native_instance_get()->timer.alarm_enabled = false;
+}
+
+void port_timer_hw_trigger(void)
+{
+    native_system_irq_raise(NATIVE_SYSTEM_IRQ_TIMER);
+}
+
+port_timer_wheel_t *port_timer_hw_get_wheel(void)
+{
+    return &native_instance_get()->wheel;
+}
+
+void native_timer_tick(uint32_t now_ms)
+{
+    native_timer_hw_t *p_timer = &native_instance_get()->timer;
+    if (p_timer->alarm_enabled && ((int32_t)(now_ms * 1000U - p_timer->alarm_us) >= 0))
+    {
+        native_system_irq_raise(NATIVE_SYSTEM_IRQ_TIMER); /* Left pending until the System tick returns */
+    }
+}
+
+uint32_t native_timer_get_next_event_ms(uint32_t now_ms)
+{
+    native_timer_hw_t *p_timer = &native_instance_get()->timer;
+    if (!p_timer->alarm_enabled)
+    {
+        return UINT32_MAX;
+    }
+    int32_t until_us = (int32_t)(p_timer->alarm_us - (now_ms + 1U) * 1000U); /* The System tick checks the compare after it counts its millisecond */
+    return (until_us <= 0) ? 0U : ((uint32_t)until_us + 999U) / 1000U;
+}
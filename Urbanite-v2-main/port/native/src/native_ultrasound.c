@@ -0,0 +1,447 @@
+/**
+ * @file native_ultrasound.c
+ * @brief Portable functions to interact with the ultrasound FSM library in the native (host) platform.
+ *
+ * The trigger timer is emulated with a resolution of 1 ms of virtual time: every millisecond it raises its interrupt if enabled. The echo timer is emulated with a resolution of 1 us: once the trigger has ended, the edges of the echo pulse and the overflows of the timer are delivered in the millisecond in which they happen, in order, with the counter value of their microsecond. The FSM reads the captures before the next overflow, so no overflow is delivered after the falling edge. The period of the measurements is a software timer, as in the STM32F4 port.
+ *
+ * @date 2025-01-01
+ */
+
+/* Standard C includes */
+#include <stddef.h>
+#include <stdatomic.h>
+
+/* HW dependent includes */
+#include "port_system.h"
+#include "port_ultrasound.h"
+#include "port_timer.h"
+#include "native_system.h"
+#include "native_ultrasound.h"
+#include "native_instance.h"
+#include "port_trace.h"
+
+/*Defines ----------------------------------------------------------------*/
+#define NATIVE_ULTRASOUND_FLAG_TRIGGER_READY 0U /*!< Position of the trigger ready flag in the flag word of a sensor*/
+#define NATIVE_ULTRASOUND_FLAG_TRIGGER_END 1U   /*!< Position of the trigger end flag in the flag word of a sensor*/
+#define NATIVE_ULTRASOUND_FLAG_ECHO_RECEIVED 2U /*!< Position of the echo received flag in the flag word of a sensor*/
+#define NATIVE_ULTRASOUND_TICK_HOOK 0U          /*!< Slot of the emulated timers in the virtual time hooks*/
+
+/* Private functions ----------------------------------------------------------*/
+/**
+ * @brief Get the ultrasound sensor struct with the given ID, in the simulated unit selected in the calling thread
+ * @param ultrasound_id Ultrasound ID.
+ * @return Pointer to the ultrasound sensor struct
+ * @return NULL if the ID is not valid
+ */
+static native_ultrasound_hw_t *_native_ultrasound_get(uint32_t ultrasound_id)
+{
+    if (ultrasound_id < NATIVE_ULTRASOUND_NUM_SENSORS)
+    {
+        return &native_instance_get()->ultrasound_arr[ultrasound_id];
+    }
+    return NULL;
+}
+
+/**
+ * @brief Write a flag of an ultrasound sensor atomically
+ *
+ * @param p_ultrasound Pointer to the ultrasound sensor struct
+ * @param flag Position of the flag in the flag word
+ * @param value New value of the flag
+ */
+static inline void _native_ultrasound_write_flag(native_ultrasound_hw_t *p_ultrasound, uint8_t flag, bool value)
+{
+    if (value)
+    {
+        native_system_flag_set(&p_ultrasound->flags, flag);
+    }
+    else
+    {
+        native_system_flag_clear(&p_ultrasound->flags, flag);
+    }
+}
+
+/**
+ * @brief Virtual time in microseconds
+ *
+ * @param now_ms Virtual time in milliseconds
+ * @return Virtual time in microseconds
+ */
+static inline uint64_t _native_ultrasound_us(uint32_t now_ms)
+{
+    return (uint64_t)now_ms * 1000U;
+}
+
+/**
+ * @brief Raise a capture of the emulated echo timer
+ *
+ * @param p_ultrasound Pointer to the ultrasound sensor struct
+ * @param edge_us Virtual time of the edge
+ */
+static void _native_ultrasound_capture(native_ultrasound_hw_t *p_ultrasound, uint64_t edge_us)
+{
+    p_ultrasound->capture = (uint32_t)((edge_us - p_ultrasound->echo_timer_start_us) % (NATIVE_ULTRASOUND_ECHO_TIMER_ARR + 1U));
+    p_ultrasound->capture_pending = true;
+    native_system_irq_raise(NATIVE_SYSTEM_IRQ_ECHO);
+}
+
+/**
+ * @brief Deliver the edges of the emulated echo pulse and the overflows of the echo timer that happen before a given time
+ *
+ * @param p_ultrasound Pointer to the ultrasound sensor struct
+ * @param until_us Virtual time of the end of the current millisecond
+ */
+static void _native_ultrasound_deliver_echo(native_ultrasound_hw_t *p_ultrasound, uint64_t until_us)
+{
+    while (p_ultrasound->echo_edges > 0)
+    {
+        uint64_t edge_us = (p_ultrasound->echo_edges == 2U) ? p_ultrasound->echo_rise_us : p_ultrasound->echo_fall_us;
+        if (p_ultrasound->echo_next_overflow_us <= edge_us)
+        {
+            if (p_ultrasound->echo_next_overflow_us >= until_us)
+            {
+                return;
+            }
+            p_ultrasound->echo_next_overflow_us += NATIVE_ULTRASOUND_ECHO_TIMER_ARR + 1U;
+            p_ultrasound->overflow_pending = true;
+            native_system_irq_raise(NATIVE_SYSTEM_IRQ_ECHO);
+        }
+        else
+        {
+            if (edge_us >= until_us)
+            {
+                return;
+            }
+            p_ultrasound->echo_edges--;
+            _native_ultrasound_capture(p_ultrasound, edge_us);
+        }
+    }
+}
+
+/**
+ * @brief Get the duration of the echo pulse of the current measurement
+ *
+ * @param p_ultrasound Pointer to the ultrasound sensor struct
+ * @param ultrasound_id Ultrasound ID
+ * @param burst_us Virtual time of the rising edge of the echo pin
+ * @return Duration of the echo pulse in microseconds. 0 if the echo pin does not rise
+ */
+static uint32_t _native_ultrasound_get_echo_us(native_ultrasound_hw_t *p_ultrasound, uint32_t ultrasound_id, uint64_t burst_us)
+{
+    if (p_ultrasound->echo_source != NULL)
+    {
+        return p_ultrasound->echo_source(p_ultrasound->p_echo_source_arg, ultrasound_id, burst_us);
+    }
+    return p_ultrasound->echo_us;
+}
+
+/**
+ * @brief Advance the emulated timers of the ultrasound sensors one millisecond
+ *
+ * @param now_ms Current virtual time
+ */
+static void _native_ultrasound_tick(uint32_t now_ms)
+{
+    for (uint32_t i = 0; i < NATIVE_ULTRASOUND_NUM_SENSORS; i++)
+    {
+        native_ultrasound_hw_t *p_ultrasound = _native_ultrasound_get(i);
+        if (p_ultrasound->trigger_timer_en)
+        {
+            p_ultrasound->trigger_fired = true;
+            native_system_irq_raise(NATIVE_SYSTEM_IRQ_TRIGGER);
+        }
+        if (p_ultrasound->echo_timer_en && p_ultrasound->echo_armed && p_ultrasound->trigger_fired)
+        {
+            uint64_t burst_us = _native_ultrasound_us(now_ms) + NATIVE_ULTRASOUND_TRIGGER_US + NATIVE_ULTRASOUND_ECHO_START_US;
+            p_ultrasound->echo_rise_us = burst_us; /* The echo source may move the counter of the echo timer at the rising edge */
+            uint32_t echo_us = _native_ultrasound_get_echo_us(p_ultrasound, i, burst_us);
+            p_ultrasound->echo_armed = false;
+            if (echo_us > 0)
+            {
+                p_ultrasound->echo_fall_us = burst_us + echo_us;
+                p_ultrasound->echo_edges = 2U;
+            }
+        }
+        if (p_ultrasound->echo_timer_en)
+        {
+            _native_ultrasound_deliver_echo(p_ultrasound, _native_ultrasound_us(now_ms + 1U));
+        }
+    }
+}
+
+/**
+ * @brief Get the milliseconds of virtual time before the emulated timers of the ultrasound sensors raise an interrupt (see native_system_skip_ms())
+ *
+ * @param now_ms Current virtual time
+ * @return 0 if `_native_ultrasound_tick()` does something in the current millisecond, `UINT32_MAX` if it does not until a measurement starts or the end of the trigger is cleared
+ */
+static uint32_t _native_ultrasound_next_event_ms(uint32_t now_ms)
+{
+    uint64_t next_us = UINT64_MAX;
+    for (uint32_t i = 0; i < NATIVE_ULTRASOUND_NUM_SENSORS; i++)
+    {
+        native_ultrasound_hw_t *p_ultrasound = _native_ultrasound_get(i);
+        bool trigger_pending = p_ultrasound->trigger_timer_en && !(p_ultrasound->trigger_fired && native_system_flag_test(&p_ultrasound->flags, NATIVE_ULTRASOUND_FLAG_TRIGGER_END)); /* Once the end of the trigger is flagged, its interrupt changes nothing */
+        if (trigger_pending || (p_ultrasound->echo_timer_en && p_ultrasound->echo_armed && p_ultrasound->trigger_fired))
+        {
+            return 0;
+        }
+        if (p_ultrasound->echo_timer_en && (p_ultrasound->echo_edges > 0))
+        {
+            uint64_t edge_us = (p_ultrasound->echo_edges == 2U) ? p_ultrasound->echo_rise_us : p_ultrasound->echo_fall_us;
+            edge_us = (p_ultrasound->echo_next_overflow_us < edge_us) ? p_ultrasound->echo_next_overflow_us : edge_us; /* As _native_ultrasound_deliver_echo() */
+            next_us = (edge_us < next_us) ? edge_us : next_us;
+        }
+    }
+    if (next_us == UINT64_MAX)
+    {
+        return UINT32_MAX;
+    }
+    uint64_t next_ms = next_us / 1000U; /* Delivered in the millisecond in which it happens */
+    return (next_ms <= now_ms) ? 0U : (uint32_t)(next_ms - now_ms);
+}
+
+/**
+ * @brief Callback of the timer that controls the duration of the measurements. It runs in the interrupt of the software timers.
+ *
+ * @param p_arg Pointer to the ultrasound sensor struct
+ */
+static void _native_ultrasound_measurement_timeout(void *p_arg)
+{
+    native_ultrasound_hw_t *p_ultrasound = (native_ultrasound_hw_t *)p_arg;
+    native_system_flag_set(&p_ultrasound->flags, NATIVE_ULTRASOUND_FLAG_TRIGGER_READY);
+}
+
+/* Public functions -----------------------------------------------------------*/
+void port_ultrasound_init(uint32_t ultrasound_id)
+{
+    native_ultrasound_hw_t *p_ultrasound = _native_ultrasound_get(ultrasound_id);
+
+    p_ultrasound->echo_end_tick = 0;
+    p_ultrasound->echo_init_tick = 0;
+    p_ultrasound->echo_overflows = 0;
+    native_system_flag_clear(&p_ultrasound->flags, NATIVE_ULTRASOUND_FLAG_TRIGGER_END);
+    native_system_flag_clear(&p_ultrasound->flags, NATIVE_ULTRASOUND_FLAG_ECHO_RECEIVED);
+    native_system_flag_set(&p_ultrasound->flags, NATIVE_ULTRASOUND_FLAG_TRIGGER_READY);
+    p_ultrasound->trigger_timer_en = false;
+    p_ultrasound->echo_timer_en = false;
+    p_ultrasound->echo_armed = false;
+    p_ultrasound->capture_pending = false;
+    p_ultrasound->overflow_pending = false;
+    p_ultrasound->echo_edges = 0;
+    port_timer_setup(&p_ultrasound->measurement_timer, _native_ultrasound_measurement_timeout, p_ultrasound);
+
+    native_system_irq_config(NATIVE_SYSTEM_IRQ_ECHO, NATIVE_ULTRASOUND_ECHO_IRQ_PRIO, native_ultrasound_echo_irq_handler);
+    native_system_irq_config(NATIVE_SYSTEM_IRQ_TRIGGER, NATIVE_ULTRASOUND_TRIGGER_IRQ_PRIO, native_ultrasound_trigger_irq_handler);
+    native_system_set_tick_hook(NATIVE_ULTRASOUND_TICK_HOOK, _native_ultrasound_tick);
+    native_system_set_next_event_hook(NATIVE_ULTRASOUND_TICK_HOOK, _native_ultrasound_next_event_ms);
+}
+
+void native_ultrasound_set_echo_us(uint32_t ultrasound_id, uint32_t echo_us)
+{
+    native_ultrasound_hw_t *p_ultrasound = _native_ultrasound_get(ultrasound_id);
+    if (p_ultrasound != NULL)
+    {
+        p_ultrasound->echo_us = echo_us;
+    }
+}
+
+void native_ultrasound_set_echo_source(uint32_t ultrasound_id, native_ultrasound_echo_source_t source, void *p_arg)
+{
+    native_ultrasound_hw_t *p_ultrasound = _native_ultrasound_get(ultrasound_id);
+    if (p_ultrasound != NULL)
+    {
+        p_ultrasound->echo_source = source;
+        p_ultrasound->p_echo_source_arg = p_arg;
+    }
+}
+
+void native_ultrasound_set_echo_counter(uint32_t ultrasound_id, uint32_t counter)
+{
+    native_ultrasound_hw_t *p_ultrasound = _native_ultrasound_get(ultrasound_id);
+    if (p_ultrasound != NULL)
+    {
+        counter %= NATIVE_ULTRASOUND_ECHO_TIMER_ARR + 1U;
+        p_ultrasound->echo_timer_start_us = p_ultrasound->echo_rise_us - counter;
+        p_ultrasound->echo_next_overflow_us = p_ultrasound->echo_timer_start_us + NATIVE_ULTRASOUND_ECHO_TIMER_ARR + 1U;
+    }
+}
+
+bool native_ultrasound_get_echo_capture(uint32_t ultrasound_id, uint32_t *p_tick)
+{
+    native_ultrasound_hw_t *p_ultrasound = _native_ultrasound_get(ultrasound_id);
+    if ((p_ultrasound == NULL) || !p_ultrasound->capture_pending)
+    {
+        return false;
+    }
+    p_ultrasound->capture_pending = false;
+    *p_tick = p_ultrasound->capture;
+    return true;
+}
+
+bool native_ultrasound_get_echo_overflow(uint32_t ultrasound_id)
+{
+    native_ultrasound_hw_t *p_ultrasound = _native_ultrasound_get(ultrasound_id);
+    if ((p_ultrasound == NULL) || !p_ultrasound->overflow_pending)
+    {
+        return false;
+    }
+    p_ultrasound->overflow_pending = false;
+    return true;
+}
+
+void port_ultrasound_start_measurement(uint32_t ultrasound_id)
+{
+    native_ultrasound_hw_t *p_ultrasound = _native_ultrasound_get(ultrasound_id);
+    if (p_ultrasound != NULL)
+    {
+        port_system_enter_critical();
+        native_system_flag_clear(&p_ultrasound->flags, NATIVE_ULTRASOUND_FLAG_TRIGGER_READY);
+        p_ultrasound->trigger_fired = false;
+        p_ultrasound->echo_armed = true;
+        p_ultrasound->echo_edges = 0;
+        p_ultrasound->echo_timer_start_us = _native_ultrasound_us(port_system_get_millis());
+        p_ultrasound->echo_next_overflow_us = p_ultrasound->echo_timer_start_us + NATIVE_ULTRASOUND_ECHO_TIMER_ARR + 1U;
+        p_ultrasound->trigger_timer_en = true;
+        p_ultrasound->echo_timer_en = true;
+        port_timer_start(&p_ultrasound->measurement_timer, PORT_PARKING_SENSOR_TIMEOUT_US, PORT_PARKING_SENSOR_TIMEOUT_US);
+        port_system_exit_critical();
+        PORT_TRACE_RECORD(PORT_TRACE_TRIGGER, ultrasound_id, 0, 0);
+    }
+}
+
+uint32_t port_ultrasound_start_new_measurement_timer(void)
+{
+    for (uint32_t i = 0; i < NATIVE_ULTRASOUND_NUM_SENSORS; i++)
+    {
+        port_timer_start(&_native_ultrasound_get(i)->measurement_timer, PORT_PARKING_SENSOR_TIMEOUT_US, PORT_PARKING_SENSOR_TIMEOUT_US);
+    }
+    return 0;
+}
+
+void port_ultrasound_reset_echo_ticks(uint32_t ultrasound_id)
+{
+    native_ultrasound_hw_t *p_ultrasound = _native_ultrasound_get(ultrasound_id);
+    p_ultrasound->echo_init_tick = 0;
+    p_ultrasound->echo_end_tick = 0;
+    p_ultrasound->echo_overflows = 0;
+    native_system_flag_clear(&p_ultrasound->flags, NATIVE_ULTRASOUND_FLAG_ECHO_RECEIVED);
+}
+
+void port_ultrasound_stop_echo_timer(uint32_t ultrasound_id)
+{
+    native_ultrasound_hw_t *p_ultrasound = _native_ultrasound_get(ultrasound_id);
+    if (p_ultrasound != NULL)
+    {
+        p_ultrasound->echo_timer_en = false;
+    }
+}
+
+void port_ultrasound_stop_new_measurement_timer(void)
+{
+    for (uint32_t i = 0; i < NATIVE_ULTRASOUND_NUM_SENSORS; i++)
+    {
+        port_timer_cancel(&_native_ultrasound_get(i)->measurement_timer);
+    }
+}
+
+void port_ultrasound_stop_trigger_timer(uint32_t ultrasound_id)
+{
+    native_ultrasound_hw_t *p_ultrasound = _native_ultrasound_get(ultrasound_id);
+    if (p_ultrasound != NULL)
+    {
+        p_ultrasound->trigger_timer_en = false;
+    }
+}
+
+void port_ultrasound_stop_ultrasound(uint32_t ultrasound_id)
+{
+    if (_native_ultrasound_get(ultrasound_id) != NULL)
+    {
+        port_system_enter_critical();
+        port_ultrasound_stop_trigger_timer(ultrasound_id);
+        port_ultrasound_stop_new_measurement_timer();
+        port_ultrasound_stop_echo_timer(ultrasound_id);
+        port_ultrasound_reset_echo_ticks(ultrasound_id);
+        port_system_exit_critical();
+    }
+}
+
+/*Getters and setters functions-------------------------------------**/
+bool port_ultrasound_get_measurement_timer_running(uint32_t ultrasound_id)
+{
+    native_ultrasound_hw_t *p_ultrasound = _native_ultrasound_get(ultrasound_id);
+    return port_timer_is_armed(&p_ultrasound->measurement_timer);
+}
+
+bool port_ultrasound_get_trigger_ready(uint32_t ultrasound_id)
+{
+    native_ultrasound_hw_t *p_ultrasound = _native_ultrasound_get(ultrasound_id);
+    return native_system_flag_test(&p_ultrasound->flags, NATIVE_ULTRASOUND_FLAG_TRIGGER_READY);
+}
+
+bool port_ultrasound_get_trigger_end(uint32_t ultrasound_id)
+{
+    native_ultrasound_hw_t *p_ultrasound = _native_ultrasound_get(ultrasound_id);
+    return native_system_flag_test(&p_ultrasound->flags, NATIVE_ULTRASOUND_FLAG_TRIGGER_END);
+}
+
+bool port_ultrasound_get_echo_received(uint32_t ultrasound_id)
+{
+    native_ultrasound_hw_t *p_ultrasound = _native_ultrasound_get(ultrasound_id);
+    return native_system_flag_test(&p_ultrasound->flags, NATIVE_ULTRASOUND_FLAG_ECHO_RECEIVED);
+}
+
+uint32_t port_ultrasound_get_echo_overflows(uint32_t ultrasound_id)
+{
+    native_ultrasound_hw_t *p_ultrasound = _native_ultrasound_get(ultrasound_id);
+    return p_ultrasound->echo_overflows;
+}
+
+uint32_t port_ultrasound_get_echo_init_tick(uint32_t ultrasound_id)
+{
+    native_ultrasound_hw_t *p_ultrasound = _native_ultrasound_get(ultrasound_id);
+    return p_ultrasound->echo_init_tick;
+}
+
+uint32_t port_ultrasound_get_echo_end_tick(uint32_t ultrasound_id)
+{
+    native_ultrasound_hw_t *p_ultrasound = _native_ultrasound_get(ultrasound_id);
+    return p_ultrasound->echo_end_tick;
+}
+
+void port_ultrasound_set_echo_end_tick(uint32_t ultrasound_id, uint32_t echo_end_tick)
+{
+    native_ultrasound_hw_t *p_ultrasound = _native_ultrasound_get(ultrasound_id);
+    p_ultrasound->echo_end_tick = echo_end_tick;
+}
+
+void port_ultrasound_set_echo_init_tick(uint32_t ultrasound_id, uint32_t echo_init_tick)
+{
+    native_ultrasound_hw_t *p_ultrasound = _native_ultrasound_get(ultrasound_id);
+    p_ultrasound->echo_init_tick = echo_init_tick;
+}
+
+void port_ultrasound_set_echo_received(uint32_t ultrasound_id, bool echo_received)
+{
+    native_ultrasound_hw_t *p_ultrasound = _native_ultrasound_get(ultrasound_id);
+    _native_ultrasound_write_flag(p_ultrasound, NATIVE_ULTRASOUND_FLAG_ECHO_RECEIVED, echo_received);
+}
+
+void port_ultrasound_set_trigger_ready(uint32_t ultrasound_id, bool trigger_ready)
+{
+    native_ultrasound_hw_t *p_ultrasound = _native_ultrasound_get(ultrasound_id);
+    _native_ultrasound_write_flag(p_ultrasound, NATIVE_ULTRASOUND_FLAG_TRIGGER_READY, trigger_ready);
+}
+
+void port_ultrasound_set_trigger_end(uint32_t ultrasound_id, bool trigger_end)
+{
+    native_ultrasound_hw_t *p_ultrasound = _native_ultrasound_get(ultrasound_id);
+    _native_ultrasound_write_flag(p_ultrasound, NATIVE_ULTRASOUND_FLAG_TRIGGER_END, trigger_end);
+}
+
+void port_ultrasound_set_echo_overflows(uint32_t ultrasound_id, uint32_t echo_overflows)
+{
+    native_ultrasound_hw_t *p_ultrasound = _native_ultrasound_get(ultrasound_id);
+    p_ultrasound->echo_overflows = echo_overflows;
+}
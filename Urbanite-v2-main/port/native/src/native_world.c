@@ -0,0 +1,414 @@
+/**
+ * @file native_world.c
+ * @brief Acoustic world model of the native (host) platform.
+ *
+ * The echo of a burst is the round trip to the closest obstacle in the beam, at the speed of sound of the current temperature (331.3 + 0.606 T m/s). Obstacles off the axis of the beam return weaker echoes, so they are missed more often. Each echo is then disturbed, in this order: it may be missed, replaced by a multipath ghost (twice the round trip), cut short by the burst of another sensor that arrives first, and shifted by Gaussian jitter and, sometimes, a heavy-tailed outlier.
+ *
+ * @date 2025-01-01
+ */
+
+/* Standard C includes */
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+/* HW dependent includes */
+#include "native_ultrasound.h"
+#include "native_world.h"
+
+/* Defines ----------------------------------------------------------------------*/
+#define NATIVE_WORLD_LINE_LEN 160U                /*!< Longest line of a scenario */
+#define NATIVE_WORLD_PI 3.14159265358979323846    /*!< Pi */
+
+/* Typedefs --------------------------------------------------------------------*/
+/**
+ * @brief Sensor of the scenario
+ */
+typedef struct
+{
+    bool present;            /*!< The sensor is declared in the scenario */
+    double x_cm;             /*!< Position in the car */
+    double y_cm;             /*!< Position in the car */
+    double heading_rad;      /*!< Direction of the axis of the beam */
+    double half_angle_rad;   /*!< Half of the aperture of the beam */
+    double period_us;        /*!< Period of the bursts of a sensor of another car. 0 for a sensor of the port */
+    uint64_t last_burst_us;  /*!< Virtual time of the last burst */
+    bool burst_sent;         /*!< The sensor has sent a burst */
+    bool in_beam;            /*!< There was an obstacle in the beam at the last burst */
+    double distance_cm;      /*!< Distance to the closest obstacle in the beam at the last burst */
+} native_world_sensor_t;
+
+/**
+ * @brief Obstacle of the scenario, moving in a straight line from its last keyframe
+ */
+typedef struct
+{
+    bool present;      /*!< The obstacle exists */
+    uint32_t id;       /*!< Identifier in the scenario */
+    double t0_us;      /*!< Time of the last keyframe */
+    double x_cm;       /*!< Position at the last keyframe */
+    double y_cm;       /*!< Position at the last keyframe */
+    double vx_cm_us;   /*!< Velocity */
+    double vy_cm_us;   /*!< Velocity */
+} native_world_obstacle_t;
+
+/**
+ * @brief Acoustic world model
+ */
+struct native_world_t
+{
+    FILE *p_scenario;                                             /*!< Stream of the scenario */
+    char line[NATIVE_WORLD_LINE_LEN];                             /*!< Next timed line of the scenario, read but not applied yet */
+    bool line_pending;                                            /*!< There is a timed line in `line` */
+    double line_us;                                               /*!< Time of the pending line */
+    uint64_t rng;                                                 /*!< State of the generator of the noise */
+    double temp_c;                                                /*!< Air temperature */
+    double sigma_us;                                              /*!< Gaussian jitter */
+    double outlier_prob;                                          /*!< Probability of a heavy-tailed outlier */
+    double outlier_scale_us;                                      /*!< Scale of the outliers */
+    double miss_prob;                                             /*!< Probability of missing an echo on the axis of the beam */
+    double ghost_prob;                                            /*!< Probability of a multipath ghost */
+    double crosstalk_prob;                                        /*!< Probability of taking a burst of another sensor as the echo */
+    native_world_sensor_t sensors_arr[NATIVE_WORLD_MAX_SENSORS];        /*!< Sensors of the scenario */
+    native_world_obstacle_t obstacles_arr[NATIVE_WORLD_MAX_OBSTACLES];  /*!< Obstacles of the scenario */
+};
+
+/* Private functions ----------------------------------------------------------*/
+/**
+ * @brief Next number of a xorshift64* generator, in [0, 1)
+ *
+ * @param p_world Pointer to the world
+ * @return Pseudo-random number
+ */
+static double _native_world_rand(native_world_t *p_world)
+{
+    uint64_t x = p_world->rng;
+    x ^= x >> 12;
+    x ^= x << 25;
+    x ^= x >> 27;
+    p_world->rng = x;
+    return (double)((x * 0x2545F4914F6CDD1DULL) >> 11) / 9007199254740992.0;
+}
+
+/**
+ * @brief Standard normal number (Box-Muller)
+ *
+ * @param p_world Pointer to the world
+ * @return Pseudo-random number
+ */
+static double _native_world_rand_normal(native_world_t *p_world)
+{
+    double u1 = 1.0 - _native_world_rand(p_world); /* (0, 1] */
+    double u2 = _native_world_rand(p_world);
+    return sqrt(-2.0 * log(u1)) * cos(2.0 * NATIVE_WORLD_PI * u2);
+}
+
+/**
+ * @brief Speed of sound in air
+ *
+ * @param temp_c Air temperature
+ * @return Speed in cm/us
+ */
+static double _native_world_speed_cm_us(double temp_c)
+{
+    return (331.3 + 0.606 * temp_c) * 1e-4;
+}
+
+/**
+ * @brief Get the obstacle with an identifier, or a free one for it
+ *
+ * @param p_world Pointer to the world
+ * @param id Identifier in the scenario
+ * @return Pointer to the obstacle. NULL if it does not exist and there is no free one
+ */
+static native_world_obstacle_t *_native_world_get_obstacle(native_world_t *p_world, uint32_t id)
+{
+    native_world_obstacle_t *p_free = NULL;
+    for (uint32_t i = 0; i < NATIVE_WORLD_MAX_OBSTACLES; i++)
+    {
+        native_world_obstacle_t *p_obstacle = &p_world->obstacles_arr[i];
+        if (p_obstacle->present && (p_obstacle->id == id))
+        {
+            return p_obstacle;
+        }
+        if (!p_obstacle->present && (p_free == NULL))
+        {
+            p_free = p_obstacle;
+        }
+    }
+    return p_free;
+}
+
+/**
+ * @brief Apply a line of the scenario
+ *
+ * @param p_world Pointer to the world
+ * @param p_line Line without its time, if it had one
+ * @param t_us Time of the line
+ */
+static void _native_world_apply(native_world_t *p_world, const char *p_line, double t_us)
+{
+    char keyword[16];
+    int n;
+    if (sscanf(p_line, "%15s%n", keyword, &n) != 1)
+    {
+        return;
+    }
+    p_line += n;
+
+    unsigned id;
+    double a, b, c, d, e, f;
+    if ((strcmp(keyword, "sensor") == 0) && (sscanf(p_line, "%u %lf %lf %lf %lf %lf", &id, &a, &b, &c, &d, &e) == 6) && (id < NATIVE_WORLD_MAX_SENSORS))
+    {
+        native_world_sensor_t *p_sensor = &p_world->sensors_arr[id];
+        p_sensor->present = true;
+        p_sensor->x_cm = a;
+        p_sensor->y_cm = b;
+        p_sensor->heading_rad = c * NATIVE_WORLD_PI / 180.0;
+        p_sensor->half_angle_rad = d * NATIVE_WORLD_PI / 180.0;
+        p_sensor->period_us = e * 1000.0;
+        if (p_sensor->period_us > 0)
+        {
+            /* The bursts of another car are not synchronized with the ones of the port */
+            p_sensor->last_burst_us = (uint64_t)(_native_world_rand(p_world) * p_sensor->period_us);
+            p_sensor->burst_sent = true;
+        }
+    }
+    else if ((strcmp(keyword, "noise") == 0) && (sscanf(p_line, "%lf %lf %lf %lf %lf %lf", &a, &b, &c, &d, &e, &f) == 6))
+    {
+        p_world->sigma_us = a;
+        p_world->outlier_prob = b;
+        p_world->outlier_scale_us = c;
+        p_world->miss_prob = d;
+        p_world->ghost_prob = e;
+        p_world->crosstalk_prob = f;
+    }
+    else if ((strcmp(keyword, "temp") == 0) && (sscanf(p_line, "%lf", &a) == 1))
+    {
+        p_world->temp_c = a;
+    }
+    else if ((strcmp(keyword, "obj") == 0) && (sscanf(p_line, "%u %lf %lf %lf %lf", &id, &a, &b, &c, &d) == 5))
+    {
+        native_world_obstacle_t *p_obstacle = _native_world_get_obstacle(p_world, id);
+        if (p_obstacle != NULL)
+        {
+            p_obstacle->present = true;
+            p_obstacle->id = id;
+            p_obstacle->t0_us = t_us;
+            p_obstacle->x_cm = a;
+            p_obstacle->y_cm = b;
+            p_obstacle->vx_cm_us = c * 1e-6;
+            p_obstacle->vy_cm_us = d * 1e-6;
+        }
+    }
+    else if ((strcmp(keyword, "gone") == 0) && (sscanf(p_line, "%u", &id) == 1))
+    {
+        native_world_obstacle_t *p_obstacle = _native_world_get_obstacle(p_world, id);
+        if ((p_obstacle != NULL) && p_obstacle->present && (p_obstacle->id == id))
+        {
+            p_obstacle->present = false;
+        }
+    }
+}
+
+/**
+ * @brief Read and apply the scenario up to a time. The first timed line after it is kept for the next call
+ *
+ * @param p_world Pointer to the world
+ * @param now_us Virtual time
+ */
+static void _native_world_advance(native_world_t *p_world, double now_us)
+{
+    while (true)
+    {
+        if (!p_world->line_pending)
+        {
+            if (fgets(p_world->line, sizeof(p_world->line), p_world->p_scenario) == NULL)
+            {
+                return;
+            }
+            char *p_comment = strchr(p_world->line, '#');
+            if (p_comment != NULL)
+            {
+                *p_comment = '\0';
+            }
+            double t_ms;
+            int n;
+            if (sscanf(p_world->line, "%lf%n", &t_ms, &n) != 1)
+            {
+                _native_world_apply(p_world, p_world->line, now_us); /* Untimed line */
+                continue;
+            }
+            memmove(p_world->line, p_world->line + n, strlen(p_world->line + n) + 1U);
+            p_world->line_us = t_ms * 1000.0;
+            p_world->line_pending = true;
+        }
+        if (p_world->line_us > now_us)
+        {
+            return;
+        }
+        _native_world_apply(p_world, p_world->line, p_world->line_us);
+        p_world->line_pending = false;
+    }
+}
+
+/**
+ * @brief Find the closest obstacle in the beam of a sensor
+ *
+ * @param p_world Pointer to the world
+ * @param p_sensor Pointer to the sensor
+ * @param t_us Virtual time
+ * @param p_distance_cm Pointer to store the distance to the obstacle
+ * @param p_off_axis Pointer to store the angle from the axis of the beam to the obstacle, relative to the half aperture (0 on the axis, 1 at the edge)
+ * @return true if there is an obstacle in the beam
+ */
+static bool _native_world_find_obstacle(native_world_t *p_world, const native_world_sensor_t *p_sensor, double t_us, double *p_distance_cm, double *p_off_axis)
+{
+    bool found = false;
+    for (uint32_t i = 0; i < NATIVE_WORLD_MAX_OBSTACLES; i++)
+    {
+        const native_world_obstacle_t *p_obstacle = &p_world->obstacles_arr[i];
+        if (!p_obstacle->present)
+        {
+            continue;
+        }
+        double dt_us = t_us - p_obstacle->t0_us;
+        double dx = p_obstacle->x_cm + p_obstacle->vx_cm_us * dt_us - p_sensor->x_cm;
+        double dy = p_obstacle->y_cm + p_obstacle->vy_cm_us * dt_us - p_sensor->y_cm;
+        double distance_cm = sqrt(dx * dx + dy * dy);
+        double angle = remainder(atan2(dy, dx) - p_sensor->heading_rad, 2.0 * NATIVE_WORLD_PI);
+        if ((fabs(angle) <= p_sensor->half_angle_rad) && (distance_cm <= NATIVE_WORLD_MAX_RANGE_CM) && (!found || (distance_cm < *p_distance_cm)))
+        {
+            found = true;
+            *p_distance_cm = distance_cm;
+            *p_off_axis = (p_sensor->half_angle_rad > 0) ? fabs(angle) / p_sensor->half_angle_rad : 0.0;
+        }
+    }
+    return found;
+}
+
+/**
+ * @brief Earliest arrival of a burst of another sensor, reflected by the closest obstacle in its beam
+ *
+ * @param p_world Pointer to the world
+ * @param id Sensor that listens
+ * @param burst_us Time of the burst of the sensor that listens
+ * @param until_us End of the time it listens
+ * @param speed_cm_us Speed of sound
+ * @param p_arrival_us Pointer to store the time of the arrival
+ * @return true if a burst of another sensor arrives in the time it listens
+ */
+static bool _native_world_find_crosstalk(native_world_t *p_world, uint32_t id, double burst_us, double until_us, double speed_cm_us, double *p_arrival_us)
+{
+    bool found = false;
+    for (uint32_t j = 0; j < NATIVE_WORLD_MAX_SENSORS; j++)
+    {
+        native_world_sensor_t *p_other = &p_world->sensors_arr[j];
+        if ((j == id) || !p_other->present || !p_other->burst_sent)
+        {
+            continue;
+        }
+        double other_us = (double)p_other->last_burst_us;
+        double distance_cm = 0;
+        double off_axis = 0;
+        if (!_native_world_find_obstacle(p_world, p_other, (p_other->period_us > 0) ? burst_us : other_us, &distance_cm, &off_axis))
+        {
+            continue;
+        }
+        double travel_us = 2.0 * distance_cm / speed_cm_us; /* The sensors are close compared with the obstacles */
+        if (p_other->period_us > 0)
+        {
+            /* Last periodic burst that arrives before the end of the listening time */
+            other_us += floor((until_us - travel_us - other_us) / p_other->period_us) * p_other->period_us;
+        }
+        double arrival_us = other_us + travel_us;
+        if ((arrival_us > burst_us) && (arrival_us < until_us) && (!found || (arrival_us < *p_arrival_us)))
+        {
+            found = true;
+            *p_arrival_us = arrival_us;
+        }
+    }
+    return found;
+}
+
+/* Public functions -----------------------------------------------------------*/
+native_world_t *native_world_new(FILE *p_scenario, uint64_t seed)
+{
+    native_world_t *p_world = calloc(1, sizeof(native_world_t));
+    if (p_world != NULL)
+    {
+        p_world->p_scenario = p_scenario;
+        p_world->rng = (seed != 0) ? seed : 1U;
+        p_world->temp_c = NATIVE_WORLD_DEFAULT_TEMP_C;
+    }
+    return p_world;
+}
+
+void native_world_destroy(native_world_t *p_world)
+{
+    free(p_world);
+}
+
+void native_world_attach(native_world_t *p_world, uint32_t ultrasound_id)
+{
+    native_ultrasound_set_echo_source(ultrasound_id, native_world_get_echo_us, p_world);
+}
+
+uint32_t native_world_get_echo_us(void *p_arg, uint32_t ultrasound_id, uint64_t burst_us)
+{
+    native_world_t *p_world = (native_world_t *)p_arg;
+    if (ultrasound_id >= NATIVE_WORLD_MAX_SENSORS)
+    {
+        return NATIVE_WORLD_NO_ECHO_US;
+    }
+    native_world_sensor_t *p_sensor = &p_world->sensors_arr[ultrasound_id];
+    double t_us = (double)burst_us;
+    _native_world_advance(p_world, t_us);
+
+    p_sensor->last_burst_us = burst_us;
+    p_sensor->burst_sent = true;
+    double off_axis = 0;
+    p_sensor->in_beam = p_sensor->present && _native_world_find_obstacle(p_world, p_sensor, t_us, &p_sensor->distance_cm, &off_axis);
+
+    /* Echo of the closest obstacle, weaker off the axis of the beam */
+    double speed_cm_us = _native_world_speed_cm_us(p_world->temp_c);
+    double echo_us = NATIVE_WORLD_NO_ECHO_US;
+    double miss_prob = p_world->miss_prob + (1.0 - p_world->miss_prob) * pow(off_axis, 4.0);
+    if (p_sensor->in_beam && (_native_world_rand(p_world) >= miss_prob))
+    {
+        echo_us = 2.0 * p_sensor->distance_cm / speed_cm_us;
+        if (_native_world_rand(p_world) < p_world->ghost_prob)
+        {
+            echo_us *= 2.0;
+        }
+    }
+
+    /* Burst of another sensor heard before the echo */
+    double crosstalk_us = 0;
+    if ((p_world->crosstalk_prob > 0) && _native_world_find_crosstalk(p_world, ultrasound_id, t_us, t_us + echo_us, speed_cm_us, &crosstalk_us) && (_native_world_rand(p_world) < p_world->crosstalk_prob))
+    {
+        echo_us = crosstalk_us - t_us;
+    }
+
+    /* Jitter and outliers */
+    if (echo_us < NATIVE_WORLD_NO_ECHO_US)
+    {
+        echo_us += p_world->sigma_us * _native_world_rand_normal(p_world);
+        if (_native_world_rand(p_world) < p_world->outlier_prob)
+        {
+            echo_us += p_world->outlier_scale_us * tan(NATIVE_WORLD_PI * (_native_world_rand(p_world) - 0.5)); /* Cauchy */
+        }
+        echo_us = fmin(fmax(echo_us, 1.0), NATIVE_WORLD_NO_ECHO_US);
+    }
+    return (uint32_t)lround(echo_us);
+}
+
+bool native_world_get_true_distance(native_world_t *p_world, uint32_t ultrasound_id, double *p_distance_cm)
+{
+    if ((ultrasound_id >= NATIVE_WORLD_MAX_SENSORS) || !p_world->sensors_arr[ultrasound_id].in_beam)
+    {
+        return false;
+    }
+    *p_distance_cm = p_world->sensors_arr[ultrasound_id].distance_cm;
+    return true;
+}
@@ -0,0 +1,164 @@
+/**
+ * @file port_isr_stats.c
+ * @brief Latency and duration statistics of the interrupt service routines.
+ *
+ * The ISRs that are running form a stack, because an ISR can only be preempted by one of a higher priority, which finishes first. When an ISR finishes, its time is added to the one that it preempted, so the duration of each ISR only counts its own instructions.
+ *
+ * @date 2025-01-01
+ */
+
+/* Includes ------------------------------------------------------------------*/
+/* Standard C includes */
+#include <string.h>
+
+/* HW dependent includes */
+#include "port_system.h"
+#include "port_log.h"
+#include "port_isr_stats.h"
+
+/* Typedefs --------------------------------------------------------------------*/
+/**
+ * @brief ISR that is running
+ */
+typedef struct
+{
+    uint32_t isr_id;        /*!< Identifier of the ISR */
+    uint32_t entry_cycles;  /*!< Time of the entry */
+    uint32_t latency;       /*!< Latency of the entry, or `PORT_ISR_STATS_NO_LATENCY` */
+    uint32_t nested_cycles; /*!< Time spent in the ISRs that preempted it */
+} port_isr_stats_frame_t;
+
+/* Global variables -----------------------------------------------------------*/
+volatile port_isr_stats_t port_isr_stats_arr[PORT_ISR_NUM_IDS];                 /*!< Statistics of each ISR */
+static volatile port_isr_stats_frame_t frames_arr[PORT_ISR_NUM_IDS]; /*!< Stack of the ISRs that are running */
+static volatile uint32_t depth = 0;                                   /*!< Number of ISRs that are running */
+
+/* Private functions ----------------------------------------------------------*/
+/**
+ * @brief Log the non-empty buckets of a histogram
+ * @param isr_id Identifier of the ISR
+ * @param msg_id Message of each bucket
+ * @param p_hist Histogram
+ */
+static void _port_isr_stats_log_hist(uint32_t isr_id, uint32_t msg_id, const volatile uint32_t *p_hist)
+{
+    for (uint32_t bucket = 0; bucket < PORT_ISR_STATS_NUM_BUCKETS; bucket++)
+    {
+        if (p_hist[bucket] > 0U)
+        {
+            PORT_LOG_INFO(msg_id, isr_id, 1UL << bucket, p_hist[bucket]);
+            port_log_flush(); /* The dump is longer than the buffer of the logger */
+        }
+    }
+}
+
+/* Public functions -----------------------------------------------------------*/
+void port_isr_stats_enter(uint32_t isr_id, uint32_t latency_cycles)
+{
+    uint32_t now = port_system_get_cycles();
+    uint32_t level = depth;
+    if ((isr_id >= PORT_ISR_NUM_IDS) || (level >= PORT_ISR_NUM_IDS))
+    {
+        return;
+    }
+    if (level > 0U)
+    {
+        port_isr_stats_arr[frames_arr[level - 1U].isr_id].preemptions++;
+    }
+    frames_arr[level].isr_id = isr_id;
+    frames_arr[level].entry_cycles = now;
+    frames_arr[level].latency = latency_cycles;
+    frames_arr[level].nested_cycles = 0;
+    depth = level + 1U;
+}
+
+void port_isr_stats_latency(uint32_t isr_id, uint32_t latency_cycles)
+{
+    uint32_t now = port_system_get_cycles();
+    uint32_t level = depth;
+    if ((level == 0U) || (frames_arr[level - 1U].isr_id != isr_id))
+    {
+        return; /* The entry was not accounted */
+    }
+    volatile port_isr_stats_frame_t *p_frame = &frames_arr[level - 1U];
+    uint32_t since_entry = now - p_frame->entry_cycles;
+    uint32_t latency = (latency_cycles > since_entry) ? (latency_cycles - since_entry) : 0U;
+    if ((p_frame->latency == PORT_ISR_STATS_NO_LATENCY) || (latency > p_frame->latency))
+    {
+        p_frame->latency = latency;
+    }
+}
+
+void port_isr_stats_exit(uint32_t isr_id)
+{
+    uint32_t now = port_system_get_cycles();
+    uint32_t level = depth;
+    if ((level == 0U) || (frames_arr[level - 1U].isr_id != isr_id))
+    {
+        return; /* The entry was not accounted */
+    }
+    volatile port_isr_stats_frame_t *p_frame = &frames_arr[level - 1U];
+    volatile port_isr_stats_t *p_stats = &port_isr_stats_arr[isr_id];
+    uint32_t elapsed = now - p_frame->entry_cycles;
+    uint32_t duration = (elapsed > p_frame->nested_cycles) ? (elapsed - p_frame->nested_cycles) : 0U;
+    uint32_t response = elapsed;
+
+    p_stats->calls++;
+    p_stats->duration_hist_arr[port_isr_stats_get_bucket(duration)]++;
+    if (duration > p_stats->max_duration_cycles)
+    {
+        p_stats->max_duration_cycles = duration;
+    }
+    if (p_frame->latency != PORT_ISR_STATS_NO_LATENCY)
+    {
+        p_stats->latency_hist_arr[port_isr_stats_get_bucket(p_frame->latency)]++;
+        if (p_frame->latency > p_stats->max_latency_cycles)
+        {
+            p_stats->max_latency_cycles = p_frame->latency;
+        }
+        response += p_frame->latency;
+    }
+    if (response > p_stats->max_response_cycles)
+    {
+        p_stats->max_response_cycles = response;
+    }
+
+    depth = level - 1U;
+    if (level > 1U)
+    {
+        frames_arr[level - 2U].nested_cycles += elapsed;
+    }
+}
+
+uint32_t port_isr_stats_get_bucket(uint32_t cycles)
+{
+    if (cycles == 0U)
+    {
+        return 0U;
+    }
+    uint32_t bucket = 32U - (uint32_t)__builtin_clz(cycles); /* CLZ instruction in the Cortex-M4 */
+    return (bucket < PORT_ISR_STATS_NUM_BUCKETS) ? bucket : (PORT_ISR_STATS_NUM_BUCKETS - 1U);
+}
+
+void port_isr_stats_dump(void)
+{
+    for (uint32_t isr_id = 0; isr_id < PORT_ISR_NUM_IDS; isr_id++)
+    {
+        volatile port_isr_stats_t *p_stats = &port_isr_stats_arr[isr_id];
+        if (p_stats->calls == 0U)
+        {
+            continue;
+        }
+        PORT_LOG_INFO(PORT_LOG_MSG_ISR_CALLS, isr_id, p_stats->calls, p_stats->preemptions);
+        PORT_LOG_INFO(PORT_LOG_MSG_ISR_MAX, isr_id, p_stats->max_latency_cycles, p_stats->max_duration_cycles, p_stats->max_response_cycles);
+        port_log_flush();
+        _port_isr_stats_log_hist(isr_id, PORT_LOG_MSG_ISR_LATENCY, p_stats->latency_hist_arr);
+        _port_isr_stats_log_hist(isr_id, PORT_LOG_MSG_ISR_DURATION, p_stats->duration_hist_arr);
+    }
+    port_log_flush();
+}
+
+void port_isr_stats_reset(void)
+{
+    memset((void *)port_isr_stats_arr, 0, sizeof(port_isr_stats_arr));
+}
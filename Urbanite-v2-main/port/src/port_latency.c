@@ -0,0 +1,228 @@
+/**
+ * @file port_latency.c
+ * @brief End-to-end latency tracing of the measurements of the ultrasound sensors.
+ *
+ * The edges of the echo are marked from the ISR and the other points from the thread code. The marks do not log anything: the trace points are logged when the measurement is consumed, from the thread code. A record is only handed over by the thread code, when the edges of the echo of the measurement have already been captured, so the records are not protected with critical sections.
+ *
+ * @date 2025-01-01
+ */
+
+/* Includes ------------------------------------------------------------------*/
+/* Standard C includes */
+#include <string.h>
+
+/* HW dependent includes */
+#include "port_timer.h"
+#include "port_log.h"
+#include "port_latency.h"
+
+/* Defines and enums ----------------------------------------------------------*/
+#define PORT_LATENCY_MARK_BIT(point) (1UL << (point)) /*!< Bit of a trace point in the marks of a record */
+
+/* Typedefs --------------------------------------------------------------------*/
+/**
+ * @brief Records of a sensor
+ */
+typedef struct
+{
+    port_latency_record_t current; /*!< Measurement in progress */
+    port_latency_record_t ready;   /*!< Measurement whose median waits for the application */
+    port_latency_record_t last;    /*!< Last measurement consumed by the application */
+} port_latency_sensor_t;
+
+/**
+ * @brief Samples of a stage
+ */
+typedef struct
+{
+    uint32_t count;                           /*!< Samples accounted since the last reset */
+    uint32_t worst_us;                        /*!< Maximum since the last reset */
+    uint32_t samples_arr[PORT_LATENCY_WINDOW]; /*!< Last samples. The oldest one is overwritten */
+} port_latency_stage_t;
+
+/* Global variables -----------------------------------------------------------*/
+static const uint8_t stage_ends_arr[PORT_LATENCY_NUM_STAGES][2] = {
+    [PORT_LATENCY_STAGE_TRIGGER_TO_ECHO] = {PORT_LATENCY_TRIGGER_START, PORT_LATENCY_ECHO_RISE},
+    [PORT_LATENCY_STAGE_FLIGHT] = {PORT_LATENCY_ECHO_RISE, PORT_LATENCY_ECHO_FALL},
+    [PORT_LATENCY_STAGE_CAPTURE_TO_FSM] = {PORT_LATENCY_ECHO_FALL, PORT_LATENCY_SET_DISTANCE},
+    [PORT_LATENCY_STAGE_FILTER] = {PORT_LATENCY_SET_DISTANCE, PORT_LATENCY_MEDIAN_READY},
+    [PORT_LATENCY_STAGE_DELIVERY] = {PORT_LATENCY_MEDIAN_READY, PORT_LATENCY_CONSUMED},
+    [PORT_LATENCY_STAGE_ECHO_TO_RESULT] = {PORT_LATENCY_ECHO_FALL, PORT_LATENCY_CONSUMED},
+}; /*!< First and last trace points of each stage */
+
+static port_latency_sensor_t sensors_arr[PORT_LATENCY_MAX_SENSORS]; /*!< Records of each sensor */
+static port_latency_stage_t stages_arr[PORT_LATENCY_NUM_STAGES];    /*!< Samples of each stage */
+static uint32_t next_seq = 0;                                       /*!< Sequence number of the last measurement */
+
+/* Private functions ----------------------------------------------------------*/
+/**
+ * @brief Account the stages of a consumed measurement
+ * @param p_record Pointer to the trace of the measurement
+ */
+static void _port_latency_account(const port_latency_record_t *p_record)
+{
+    for (uint32_t stage = 0; stage < PORT_LATENCY_NUM_STAGES; stage++)
+    {
+        uint32_t us;
+        if (port_latency_get_stage(p_record, stage, &us))
+        {
+            port_latency_stage_t *p_stage = &stages_arr[stage];
+            p_stage->samples_arr[p_stage->count % PORT_LATENCY_WINDOW] = us;
+            p_stage->count++;
+            if (us > p_stage->worst_us)
+            {
+                p_stage->worst_us = us;
+            }
+        }
+    }
+}
+
+/**
+ * @brief Log the trace points of a consumed measurement. It is called from the thread code: the logger must not be called from the echo ISR, which the critical sections do not mask
+ * @param sensor_id Identifier of the sensor
+ * @param p_record Pointer to the trace of the measurement
+ */
+static void _port_latency_log(uint32_t sensor_id, const port_latency_record_t *p_record)
+{
+    for (uint32_t point = 0; point < PORT_LATENCY_NUM_POINTS; point++)
+    {
+        if (p_record->marks & PORT_LATENCY_MARK_BIT(point))
+        {
+            PORT_LOG_DEBUG(PORT_LOG_MSG_LATENCY_MARK, p_record->seq, sensor_id, point, p_record->t_us_arr[point]);
+        }
+    }
+}
+
+/**
+ * @brief Get a percentile of sorted samples with the nearest-rank method
+ * @param p_sorted Samples in ascending order
+ * @param n Number of samples
+ * @param percentile Percentile from 1 to 100
+ * @return Value of the percentile
+ */
+static uint32_t _port_latency_percentile(const uint32_t *p_sorted, uint32_t n, uint32_t percentile)
+{
+    uint32_t rank = (percentile * n + 99U) / 100U;
+    return p_sorted[(rank > 0U) ? (rank - 1U) : 0U];
+}
+
+/* Public functions -----------------------------------------------------------*/
+void port_latency_mark(uint32_t sensor_id, uint32_t point)
+{
+    port_latency_mark_at(sensor_id, point, port_timer_get_micros());
+}
+
+void port_latency_mark_at(uint32_t sensor_id, uint32_t point, uint32_t t_us)
+{
+    if ((sensor_id >= PORT_LATENCY_MAX_SENSORS) || (point >= PORT_LATENCY_NUM_POINTS))
+    {
+        return;
+    }
+    port_latency_sensor_t *p_sensor = &sensors_arr[sensor_id];
+    port_latency_record_t *p_record = (point == PORT_LATENCY_CONSUMED) ? &p_sensor->ready : &p_sensor->current;
+
+    if (point == PORT_LATENCY_TRIGGER_START)
+    {
+        memset(p_record, 0, sizeof(*p_record));
+        p_record->seq = ++next_seq;
+    }
+    else if (!(p_record->marks & PORT_LATENCY_MARK_BIT(PORT_LATENCY_TRIGGER_START)))
+    {
+        return; /* No measurement in progress, or its median has already been consumed */
+    }
+    p_record->t_us_arr[point] = t_us;
+    p_record->marks |= PORT_LATENCY_MARK_BIT(point);
+
+    if (point == PORT_LATENCY_MEDIAN_READY)
+    {
+        p_sensor->ready = *p_record; /* A median that has not been read is replaced */
+        p_record->marks = 0;
+    }
+    else if (point == PORT_LATENCY_CONSUMED)
+    {
+        _port_latency_account(p_record);
+        _port_latency_log(sensor_id, p_record);
+        p_sensor->last = *p_record;
+        p_record->marks = 0;
+    }
+}
+
+bool port_latency_get_last(uint32_t sensor_id, port_latency_record_t *p_record)
+{
+    if ((sensor_id >= PORT_LATENCY_MAX_SENSORS) || (sensors_arr[sensor_id].last.seq == 0U))
+    {
+        return false;
+    }
+    *p_record = sensors_arr[sensor_id].last;
+    return true;
+}
+
+bool port_latency_get_stage(const port_latency_record_t *p_record, uint32_t stage, uint32_t *p_us)
+{
+    if (stage >= PORT_LATENCY_NUM_STAGES)
+    {
+        return false;
+    }
+    uint32_t from = stage_ends_arr[stage][0];
+    uint32_t to = stage_ends_arr[stage][1];
+    uint32_t both = PORT_LATENCY_MARK_BIT(from) | PORT_LATENCY_MARK_BIT(to);
+    if ((p_record->marks & both) != both)
+    {
+        return false;
+    }
+    *p_us = p_record->t_us_arr[to] - p_record->t_us_arr[from];
+    return true;
+}
+
+bool port_latency_get_summary(uint32_t stage, port_latency_summary_t *p_summary)
+{
+    if ((stage >= PORT_LATENCY_NUM_STAGES) || (stages_arr[stage].count == 0U))
+    {
+        return false;
+    }
+    const port_latency_stage_t *p_stage = &stages_arr[stage];
+    uint32_t n = (p_stage->count < PORT_LATENCY_WINDOW) ? p_stage->count : PORT_LATENCY_WINDOW;
+    uint32_t sorted_arr[PORT_LATENCY_WINDOW];
+
+    /* Insertion sort: the window is short and the function is called from the thread code */
+    for (uint32_t i = 0; i < n; i++)
+    {
+        uint32_t value = p_stage->samples_arr[i];
+        uint32_t j = i;
+        while ((j > 0U) && (sorted_arr[j - 1U] > value))
+        {
+            sorted_arr[j] = sorted_arr[j - 1U];
+            j--;
+        }
+        sorted_arr[j] = value;
+    }
+    p_summary->count = p_stage->count;
+    p_summary->min_us = sorted_arr[0];
+    p_summary->p50_us = _port_latency_percentile(sorted_arr, n, 50U);
+    p_summary->p90_us = _port_latency_percentile(sorted_arr, n, 90U);
+    p_summary->p99_us = _port_latency_percentile(sorted_arr, n, 99U);
+    p_summary->max_us = sorted_arr[n - 1U];
+    p_summary->worst_us = p_stage->worst_us;
+    return true;
+}
+
+void port_latency_dump(void)
+{
+    for (uint32_t stage = 0; stage < PORT_LATENCY_NUM_STAGES; stage++)
+    {
+        port_latency_summary_t summary;
+        if (port_latency_get_summary(stage, &summary))
+        {
+            PORT_LOG_INFO(PORT_LOG_MSG_LATENCY_STAGE, stage, summary.count, summary.min_us, summary.worst_us);
+            PORT_LOG_INFO(PORT_LOG_MSG_LATENCY_PERCENTILES, stage, summary.p50_us, summary.p90_us, summary.p99_us);
+            port_log_flush();
+        }
+    }
+}
+
+void port_latency_reset(void)
+{
+    memset(sensors_arr, 0, sizeof(sensors_arr));
+    memset(stages_arr, 0, sizeof(stages_arr));
+    next_seq = 0;
+}
@@ -0,0 +1,99 @@
+/**
+ * @file port_log.c
+ * @brief Deferred binary logger main file.
+ *
+ * The ring buffer has many producers (thread code and ISRs), serialized by the critical sections, and a single consumer, `port_log_flush()`. A record is only published, by advancing `head`, once all its words are written, so the drain never sends half a record.
+ *
+ * @date 2025-01-01
+ */
+
+/* Includes ------------------------------------------------------------------*/
+/* HW dependent includes */
+#include "port_system.h"
+#include "port_timer.h"
+#include "port_log.h"
+
+/* Global variables -----------------------------------------------------------*/
+port_log_buffer_t port_log_buffer = {.magic = 0, .size_words = PORT_LOG_BUFFER_WORDS}; /*!< Ring buffer of the records */
+static uint32_t dropped_reported = 0;                                                  /*!< Lost records already reported with `PORT_LOG_MSG_DROPPED` */
+
+/* Private functions ----------------------------------------------------------*/
+/**
+ * @brief Send the published records through the drain until it is empty or the drain is not available
+ */
+static void _port_log_drain(void)
+{
+    uint32_t tail = port_log_buffer.tail;
+    uint32_t head = port_log_buffer.head;
+    while (tail != head)
+    {
+        uint32_t index = tail & (PORT_LOG_BUFFER_WORDS - 1U);
+        uint32_t contiguous = PORT_LOG_BUFFER_WORDS - index;
+        if (contiguous > (head - tail))
+        {
+            contiguous = head - tail;
+        }
+        uint32_t sent = port_log_hw_write(&port_log_buffer.words[index], contiguous);
+        if (sent == 0U)
+        {
+            break; /* No drain: the records stay in the buffer */
+        }
+        tail += sent;
+        port_log_buffer.tail = tail; /* Free the space as soon as it is sent */
+    }
+}
+
+/* Public functions -----------------------------------------------------------*/
+void port_log_init(void)
+{
+    port_log_buffer.size_words = PORT_LOG_BUFFER_WORDS;
+    port_log_buffer.head = 0;
+    port_log_buffer.tail = 0;
+    port_log_buffer.dropped = 0;
+    dropped_reported = 0;
+    port_log_buffer.magic = PORT_LOG_MAGIC;
+    port_log_hw_init();
+}
+
+void port_log_write(uint32_t level, uint32_t nargs, const uint32_t *p_id_args)
+{
+    if (nargs > PORT_LOG_MAX_ARGS)
+    {
+        nargs = PORT_LOG_MAX_ARGS;
+    }
+    uint32_t num_words = PORT_LOG_HEADER_WORDS + nargs;
+    uint32_t timestamp = port_timer_get_micros();
+
+    port_system_enter_critical();
+    uint32_t head = port_log_buffer.head;
+    if ((PORT_LOG_BUFFER_WORDS - (head - port_log_buffer.tail)) < num_words)
+    {
+        port_log_buffer.dropped++;
+        port_system_exit_critical();
+        return;
+    }
+    port_log_buffer.words[head & (PORT_LOG_BUFFER_WORDS - 1U)] = PORT_LOG_HEADER(level, p_id_args[0], nargs);
+    port_log_buffer.words[(head + 1U) & (PORT_LOG_BUFFER_WORDS - 1U)] = timestamp;
+    for (uint32_t i = 0; i < nargs; i++)
+    {
+        port_log_buffer.words[(head + PORT_LOG_HEADER_WORDS + i) & (PORT_LOG_BUFFER_WORDS - 1U)] = p_id_args[1U + i];
+    }
+    port_log_buffer.head = head + num_words;
+    port_system_exit_critical();
+}
+
+void port_log_flush(void)
+{
+    _port_log_drain();
+
+    /* Report the lost records once there is space for the report, so the report is not lost too */
+    uint32_t dropped = port_log_buffer.dropped;
+    uint32_t free_words = PORT_LOG_BUFFER_WORDS - (port_log_buffer.head - port_log_buffer.tail);
+    if ((dropped != dropped_reported) && (free_words >= (PORT_LOG_HEADER_WORDS + 1U)))
+    {
+        uint32_t lost = dropped - dropped_reported;
+        dropped_reported = dropped;
+        PORT_LOG_WRITE(PORT_LOG_LEVEL_WARN, PORT_LOG_MSG_DROPPED, lost);
+        _port_log_drain();
+    }
+}
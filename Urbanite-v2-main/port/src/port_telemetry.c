@@ -0,0 +1,200 @@
+/**
+ * @file port_telemetry.c
+ * @brief Telemetry stream main file.
+ *
+ * There are two frames: one is filled by `port_telemetry_send()` while the other one is sent by the DMA. The COBS encoding is done byte by byte as the records are added: each non-zero byte is copied and counted in the code byte of its block, and a zero byte (or a block of 254 bytes) writes the code byte and opens a new block. So closing a frame only writes the CRC, the last code byte and the delimiter.
+ *
+ * @date 2025-01-01
+ */
+
+/* Includes ------------------------------------------------------------------*/
+/* HW dependent includes */
+#include "port_system.h"
+#include "port_timer.h"
+#include "port_telemetry.h"
+
+/* Defines and enums ----------------------------------------------------------*/
+#define PORT_TELEMETRY_COBS_MAX_CODE 0xFFU /*!< Code of a block of 254 non-zero bytes */
+
+/* Typedefs --------------------------------------------------------------------*/
+/**
+ * @brief Frame being encoded or sent
+ */
+typedef struct
+{
+    uint8_t bytes[PORT_TELEMETRY_FRAME_MAX_SIZE]; /*!< Encoded bytes */
+    uint32_t length;                              /*!< Number of encoded bytes */
+    uint32_t code_idx;                            /*!< Position of the code byte of the current COBS block */
+    uint8_t code;                                 /*!< Code of the current COBS block: 1 + number of bytes in the block */
+    uint16_t crc;                                 /*!< CRC of the bytes before encoding */
+    uint32_t records;                             /*!< Number of records */
+} port_telemetry_frame_t;
+
+/* Global variables -----------------------------------------------------------*/
+static port_telemetry_frame_t frames_arr[2]; /*!< Double buffer of frames */
+static uint32_t fill_idx = 0;                /*!< Frame being filled */
+static uint8_t seq = 0;                      /*!< Sequence number of the frame being filled */
+static volatile bool tx_busy = false;        /*!< The other frame is being sent by the DMA */
+static volatile bool fill_closed = false;    /*!< The frame being filled is closed and waits for the DMA */
+static volatile uint32_t dropped = 0;        /*!< Records dropped */
+
+static const uint16_t crc16_nibble_arr[16] = {
+    0x0000, 0x1021, 0x2042, 0x3063, 0x4084, 0x50A5, 0x60C6, 0x70E7,
+    0x8108, 0x9129, 0xA14A, 0xB16B, 0xC18C, 0xD1AD, 0xE1CE, 0xF1EF}; /*!< CRC of each nibble: two lookups per byte and only 32 bytes of flash */
+
+/* Private functions ----------------------------------------------------------*/
+/**
+ * @brief Encode a byte with COBS and add it to the CRC
+ * @param p_frame Pointer to the frame
+ * @param byte Byte before encoding
+ */
+static void _port_telemetry_put(port_telemetry_frame_t *p_frame, uint8_t byte)
+{
+    p_frame->crc = port_telemetry_crc16(p_frame->crc, byte);
+    if (byte != 0U)
+    {
+        p_frame->bytes[p_frame->length++] = byte;
+        p_frame->code++;
+    }
+    if ((byte == 0U) || (p_frame->code == PORT_TELEMETRY_COBS_MAX_CODE))
+    {
+        p_frame->bytes[p_frame->code_idx] = p_frame->code;
+        p_frame->code_idx = p_frame->length++;
+        p_frame->code = 1;
+    }
+}
+
+/**
+ * @brief Encode a little-endian field
+ * @param p_frame Pointer to the frame
+ * @param value Value of the field
+ * @param size Bytes of the field
+ */
+static void _port_telemetry_put_le(port_telemetry_frame_t *p_frame, uint32_t value, uint32_t size)
+{
+    for (uint32_t i = 0; i < size; i++)
+    {
+        _port_telemetry_put(p_frame, (uint8_t)(value >> (8U * i)));
+    }
+}
+
+/**
+ * @brief Empty a frame and encode its header
+ * @param p_frame Pointer to the frame
+ */
+static void _port_telemetry_open(port_telemetry_frame_t *p_frame)
+{
+    p_frame->length = 1; /* The first byte is the code of the first block */
+    p_frame->code_idx = 0;
+    p_frame->code = 1;
+    p_frame->crc = PORT_TELEMETRY_CRC_INIT;
+    p_frame->records = 0;
+    _port_telemetry_put(p_frame, PORT_TELEMETRY_VERSION);
+    _port_telemetry_put(p_frame, seq);
+}
+
+/**
+ * @brief Encode the CRC, finish the last COBS block and append the delimiter
+ * @param p_frame Pointer to the frame
+ */
+static void _port_telemetry_close(port_telemetry_frame_t *p_frame)
+{
+    _port_telemetry_put_le(p_frame, p_frame->crc, PORT_TELEMETRY_CRC_SIZE);
+    p_frame->bytes[p_frame->code_idx] = p_frame->code;
+    p_frame->bytes[p_frame->length++] = PORT_TELEMETRY_DELIMITER;
+    fill_closed = true;
+}
+
+/**
+ * @brief Hand the closed frame to the DMA and start filling the other one. It must be called inside a critical section with the DMA free.
+ */
+static void _port_telemetry_start_tx(void)
+{
+    port_telemetry_frame_t *p_frame = &frames_arr[fill_idx];
+    tx_busy = true;
+    fill_closed = false;
+    fill_idx ^= 1U;
+    seq++;
+    _port_telemetry_open(&frames_arr[fill_idx]);
+    port_telemetry_hw_start_tx(p_frame->bytes, p_frame->length);
+}
+
+/* Public functions -----------------------------------------------------------*/
+void port_telemetry_init(void)
+{
+    port_system_enter_critical();
+    fill_idx = 0;
+    seq = 0;
+    tx_busy = false;
+    fill_closed = false;
+    dropped = 0;
+    _port_telemetry_open(&frames_arr[fill_idx]);
+    port_system_exit_critical();
+    port_telemetry_hw_init();
+}
+
+bool port_telemetry_send(uint32_t sensor_id, uint32_t median_cm, uint32_t raw_cm, uint8_t flags)
+{
+    uint32_t timestamp = port_timer_get_micros();
+    median_cm = (median_cm > UINT16_MAX) ? UINT16_MAX : median_cm;
+    raw_cm = (raw_cm > UINT16_MAX) ? UINT16_MAX : raw_cm;
+
+    port_system_enter_critical();
+    if (fill_closed)
+    {
+        dropped++; /* Both frames are busy */
+        port_system_exit_critical();
+        return false;
+    }
+    port_telemetry_frame_t *p_frame = &frames_arr[fill_idx];
+    _port_telemetry_put(p_frame, (uint8_t)sensor_id);
+    _port_telemetry_put(p_frame, flags);
+    _port_telemetry_put_le(p_frame, timestamp, 4U);
+    _port_telemetry_put_le(p_frame, median_cm, 2U);
+    _port_telemetry_put_le(p_frame, raw_cm, 2U);
+    if (++p_frame->records == PORT_TELEMETRY_RECORDS_PER_FRAME)
+    {
+        _port_telemetry_close(p_frame);
+        if (!tx_busy)
+        {
+            _port_telemetry_start_tx();
+        }
+    }
+    port_system_exit_critical();
+    return true;
+}
+
+void port_telemetry_flush(void)
+{
+    port_system_enter_critical();
+    if (!fill_closed && (frames_arr[fill_idx].records > 0U))
+    {
+        _port_telemetry_close(&frames_arr[fill_idx]);
+    }
+    if (fill_closed && !tx_busy)
+    {
+        _port_telemetry_start_tx();
+    }
+    port_system_exit_critical();
+}
+
+uint32_t port_telemetry_get_dropped(void)
+{
+    return dropped;
+}
+
+uint16_t port_telemetry_crc16(uint16_t crc, uint8_t byte)
+{
+    crc = (uint16_t)((crc << 4) ^ crc16_nibble_arr[(crc >> 12) ^ (byte >> 4)]);
+    crc = (uint16_t)((crc << 4) ^ crc16_nibble_arr[(crc >> 12) ^ (byte & 0x0FU)]);
+    return crc;
+}
+
+void port_telemetry_tx_complete_irq_handler(void)
+{
+    tx_busy = false;
+    if (fill_closed)
+    {
+        _port_telemetry_start_tx(); /* The ISR is masked by the critical sections, so it cannot interrupt a record */
+    }
+}
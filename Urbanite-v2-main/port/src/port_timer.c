@@ -0,0 +1,320 @@
+/**
+ * @file port_timer.c
+ * @brief Hierarchical timer wheel multiplexed on a single hardware timer.
+ *
+ * The wheel keeps a reference time `now_us`, that never goes beyond the time of the hardware counter nor beyond the next event of the wheel. A timer is stored in the level of the most significant bit in which its expiry differs from `now_us`, in the slot given by the bits of its expiry at that level. The next event of the wheel is the first occupied slot of the lowest non-empty level: at level 0 the timers of the slot expire, and at higher levels they cascade to lower levels. Expiries that have wrapped around the 32-bit counter wait in a separate list until `now_us` wraps too.
+ *
+ * @date 2025-01-01
+ */
+
+/* Includes ------------------------------------------------------------------*/
+/* Standard C includes */
+#include <stddef.h>
+
+/* HW dependent includes */
+#include "port_system.h"
+#include "port_timer.h"
+
+/* Defines ----------------------------------------------------------------------*/
+#define PORT_TIMER_WRAPPED_LEVEL PORT_TIMER_LEVELS /*!< Level of the timers whose expiry has wrapped around with respect to `now_us` */
+
+/* Private functions ----------------------------------------------------------*/
+/**
+ * @brief Get the head of the list of a slot
+ * @param p_wheel Pointer to the wheel
+ * @param level Level of the wheel, or `PORT_TIMER_WRAPPED_LEVEL`
+ * @param slot Slot of the level
+ * @return Pointer to the head of the list
+ */
+static inline port_timer_t **_port_timer_head(port_timer_wheel_t *p_wheel, uint32_t level, uint32_t slot)
+{
+    return (level == PORT_TIMER_WRAPPED_LEVEL) ? &p_wheel->p_wrapped : &p_wheel->slots_arr[level][slot];
+}
+
+/**
+ * @brief Insert a timer in the wheel according to its expiry. Must be called inside a critical section or from the timer interrupt
+ * @param p_wheel Pointer to the wheel
+ * @param p_timer Pointer to the timer
+ */
+static void _port_timer_insert(port_timer_wheel_t *p_wheel, port_timer_t *p_timer)
+{
+    uint32_t level;
+    uint32_t slot;
+    uint32_t diff = p_timer->expiry_us ^ p_wheel->now_us;
+    if (p_timer->expiry_us < p_wheel->now_us)
+    {
+        level = PORT_TIMER_WRAPPED_LEVEL;
+        slot = 0;
+    }
+    else if (diff == 0U)
+    {
+        level = 0; /* Due now: it expires in the next event, the current slot of level 0 */
+        slot = p_wheel->now_us & (PORT_TIMER_SLOTS - 1U);
+    }
+    else
+    {
+        level = (31U - (uint32_t)__builtin_clz(diff)) / PORT_TIMER_SLOT_BITS;
+        slot = (p_timer->expiry_us >> (level * PORT_TIMER_SLOT_BITS)) & (PORT_TIMER_SLOTS - 1U);
+    }
+
+    port_timer_t **p_head = _port_timer_head(p_wheel, level, slot);
+    p_timer->level = (uint8_t)level;
+    p_timer->slot = (uint8_t)slot;
+    p_timer->p_prev = NULL;
+    p_timer->p_next = *p_head;
+    if (*p_head != NULL)
+    {
+        (*p_head)->p_prev = p_timer;
+    }
+    *p_head = p_timer;
+    if (level < PORT_TIMER_LEVELS)
+    {
+        p_wheel->occupied_arr[level] |= (1ULL << slot);
+    }
+    p_timer->armed = true;
+}
+
+/**
+ * @brief Remove a timer from its slot. Must be called inside a critical section or from the timer interrupt
+ * @param p_wheel Pointer to the wheel
+ * @param p_timer Pointer to the timer
+ */
+static void _port_timer_unlink(port_timer_wheel_t *p_wheel, port_timer_t *p_timer)
+{
+    port_timer_t **p_head = _port_timer_head(p_wheel, p_timer->level, p_timer->slot);
+    if (p_timer->p_prev != NULL)
+    {
+        p_timer->p_prev->p_next = p_timer->p_next;
+    }
+    else
+    {
+        *p_head = p_timer->p_next;
+    }
+    if (p_timer->p_next != NULL)
+    {
+        p_timer->p_next->p_prev = p_timer->p_prev;
+    }
+    if ((*p_head == NULL) && (p_timer->level < PORT_TIMER_LEVELS))
+    {
+        p_wheel->occupied_arr[p_timer->level] &= ~(1ULL << p_timer->slot);
+    }
+    p_timer->p_next = NULL;
+    p_timer->p_prev = NULL;
+    p_timer->armed = false;
+}
+
+/**
+ * @brief Find the next event of the wheel: an expiry, a cascade or the wrap around of `now_us`
+ * @param p_wheel Pointer to the wheel
+ * @param p_event_us Pointer to store the time of the event
+ * @param p_level Pointer to store the level of the event, or `PORT_TIMER_WRAPPED_LEVEL` for the wrap around
+ * @param p_slot Pointer to store the slot of the event
+ * @return true if the wheel is not empty
+ */
+static bool _port_timer_next_event(port_timer_wheel_t *p_wheel, uint32_t *p_event_us, uint32_t *p_level, uint32_t *p_slot)
+{
+    for (uint32_t level = 0; level < PORT_TIMER_LEVELS; level++)
+    {
+        if (p_wheel->occupied_arr[level] != 0U)
+        {
+            uint32_t slot = (uint32_t)__builtin_ctzll(p_wheel->occupied_arr[level]);
+            uint32_t shift = level * PORT_TIMER_SLOT_BITS;
+            uint32_t upper_shift = shift + PORT_TIMER_SLOT_BITS;
+            uint32_t upper = (upper_shift >= 32U) ? 0U : (p_wheel->now_us & ~((1UL << upper_shift) - 1U));
+            *p_event_us = upper | (slot << shift);
+            *p_level = level;
+            *p_slot = slot;
+            return true;
+        }
+    }
+    if (p_wheel->p_wrapped != NULL)
+    {
+        *p_event_us = 0;
+        *p_level = PORT_TIMER_WRAPPED_LEVEL;
+        *p_slot = 0;
+        return true;
+    }
+    return false;
+}
+
+/**
+ * @brief Check if a time of the hardware counter is at or after another one, taking care of the wrap around
+ * @param t Time to check
+ * @param ref Reference time
+ * @return true if t is at or after ref
+ */
+static inline bool _port_timer_time_reached(uint32_t t, uint32_t ref)
+{
+    return (int32_t)(t - ref) >= 0;
+}
+
+/**
+ * @brief Program the compare match at the next event. If it has already passed, the interrupt is raised by software. Must be called inside a critical section or from the timer interrupt
+ * @param p_wheel Pointer to the wheel
+ */
+static void _port_timer_program(port_timer_wheel_t *p_wheel)
+{
+    uint32_t event_us;
+    uint32_t level;
+    uint32_t slot;
+    if (!_port_timer_next_event(p_wheel, &event_us, &level, &slot))
+    {
+        port_timer_hw_disable_alarm();
+        return;
+    }
+    port_timer_hw_set_alarm(event_us);
+    if (_port_timer_time_reached(port_timer_hw_get_micros(), event_us))
+    {
+        port_timer_hw_trigger(); /* The counter may have passed the compare value before it was written */
+    }
+}
+
+/**
+ * @brief Expire a timer: reinsert it if it is periodic and call its callback
+ * @param p_wheel Pointer to the wheel
+ * @param p_timer Pointer to the timer, already removed from the wheel
+ */
+static void _port_timer_expire(port_timer_wheel_t *p_wheel, port_timer_t *p_timer)
+{
+    if (p_timer->period_us != 0U)
+    {
+        uint32_t now = port_timer_hw_get_micros();
+        p_timer->expiry_us += p_timer->period_us;
+        if (_port_timer_time_reached(now, p_timer->expiry_us))
+        {
+            p_timer->expiry_us = now + p_timer->period_us; /* Served more than one period late: skip the missed expiries */
+        }
+        _port_timer_insert(p_wheel, p_timer);
+    }
+    p_timer->callback(p_timer->p_arg);
+}
+
+/* Public functions -----------------------------------------------------------*/
+void port_timer_init(void)
+{
+    port_timer_wheel_t *p_wheel = port_timer_hw_get_wheel();
+    for (uint32_t level = 0; level < PORT_TIMER_LEVELS; level++)
+    {
+        while (p_wheel->occupied_arr[level] != 0)
+        {
+            uint32_t slot = (uint32_t)__builtin_ctzll(p_wheel->occupied_arr[level]); /* Only the slots with timers are visited */
+            _port_timer_unlink(p_wheel, p_wheel->slots_arr[level][slot]); /* Timers of a previous run are not armed anymore */
+        }
+    }
+    while (p_wheel->p_wrapped != NULL)
+    {
+        _port_timer_unlink(p_wheel, p_wheel->p_wrapped);
+    }
+    port_timer_hw_init();
+    p_wheel->now_us = port_timer_hw_get_micros();
+}
+
+void port_timer_setup(port_timer_t *p_timer, port_timer_callback_t callback, void *p_arg)
+{
+    p_timer->p_next = NULL;
+    p_timer->p_prev = NULL;
+    p_timer->expiry_us = 0;
+    p_timer->period_us = 0;
+    p_timer->callback = callback;
+    p_timer->p_arg = p_arg;
+    p_timer->level = 0;
+    p_timer->slot = 0;
+    p_timer->armed = false;
+}
+
+void port_timer_start(port_timer_t *p_timer, uint32_t delay_us, uint32_t period_us)
+{
+    if (delay_us == 0U)
+    {
+        delay_us = 1;
+    }
+    else if (delay_us > PORT_TIMER_MAX_DELAY_US)
+    {
+        delay_us = PORT_TIMER_MAX_DELAY_US;
+    }
+    if (period_us > PORT_TIMER_MAX_DELAY_US)
+    {
+        period_us = PORT_TIMER_MAX_DELAY_US;
+    }
+
+    port_timer_wheel_t *p_wheel = port_timer_hw_get_wheel();
+    port_system_enter_critical();
+    if (p_timer->armed)
+    {
+        _port_timer_unlink(p_wheel, p_timer);
+    }
+    uint32_t now = port_timer_hw_get_micros();
+    uint32_t event_us;
+    uint32_t level;
+    uint32_t slot;
+    if (!p_wheel->dispatching && (!_port_timer_next_event(p_wheel, &event_us, &level, &slot) || !_port_timer_time_reached(now, event_us)))
+    {
+        p_wheel->now_us = now; /* No event is due, so the timers keep their level and slot. Inside the callbacks it stays at the slot being expired */
+    }
+    p_timer->expiry_us = now + delay_us;
+    p_timer->period_us = period_us;
+    _port_timer_insert(p_wheel, p_timer);
+    _port_timer_program(p_wheel);
+    port_system_exit_critical();
+}
+
+void port_timer_cancel(port_timer_t *p_timer)
+{
+    port_timer_wheel_t *p_wheel = port_timer_hw_get_wheel();
+    port_system_enter_critical();
+    if (p_timer->armed)
+    {
+        _port_timer_unlink(p_wheel, p_timer);
+        _port_timer_program(p_wheel);
+    }
+    port_system_exit_critical();
+}
+
+bool port_timer_is_armed(port_timer_t *p_timer)
+{
+    return p_timer->armed;
+}
+
+uint32_t port_timer_get_micros(void)
+{
+    return port_timer_hw_get_micros();
+}
+
+void port_timer_irq_handler(void)
+{
+    port_timer_wheel_t *p_wheel = port_timer_hw_get_wheel();
+    uint32_t event_us;
+    uint32_t level;
+    uint32_t slot;
+    while (_port_timer_next_event(p_wheel, &event_us, &level, &slot))
+    {
+        if (!_port_timer_time_reached(port_timer_hw_get_micros(), event_us))
+        {
+            port_timer_hw_set_alarm(event_us);
+            if (!_port_timer_time_reached(port_timer_hw_get_micros(), event_us))
+            {
+                return;
+            }
+            continue; /* The counter passed the compare value while it was written */
+        }
+
+        p_wheel->now_us = event_us;
+        p_wheel->dispatching = true;
+        port_timer_t **p_head = _port_timer_head(p_wheel, level, slot);
+        while (*p_head != NULL)
+        {
+            port_timer_t *p_timer = *p_head; /* Pop from the head, so the callbacks can cancel any other timer */
+            _port_timer_unlink(p_wheel, p_timer);
+            if (level == 0U)
+            {
+                _port_timer_expire(p_wheel, p_timer);
+            }
+            else
+            {
+                _port_timer_insert(p_wheel, p_timer); /* Cascade to a lower level, or to the current slot of level 0 if it is due now */
+            }
+        }
+        p_wheel->dispatching = false;
+    }
+    port_timer_hw_disable_alarm();
+}
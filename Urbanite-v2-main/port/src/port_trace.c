@@ -0,0 +1,89 @@
+/**
+ * @file port_trace.c
+ * @brief Trace of the raw captures of the sensors.
+ *
+ * The records are appended from the thread code and from ISRs of any priority, including the echo timer ISR that the critical sections do not mask. So the slot of each record is reserved with an atomic compare-and-swap of `num_records` (LDREX/STREX in the STM32F4) instead of a critical section: a record that preempts another one takes the next slot. The header is kept up to date, so the image in RAM is always a valid trace file; only the record being written when the image is dumped may be incomplete.
+ *
+ * @date 2025-01-01
+ */
+
+/* Includes ------------------------------------------------------------------*/
+/* Standard C includes */
+#include <stdio.h>
+
+/* HW dependent includes */
+#include "port_system.h"
+#include "port_trace.h"
+
+/* Defines and enums ----------------------------------------------------------*/
+#define PORT_TRACE_ARG16_MAX 0xFFFFU /*!< Saturation of the first argument of a record */
+
+/* Global variables -----------------------------------------------------------*/
+port_trace_image_t port_trace_image = {
+    .header = {
+        .magic = PORT_TRACE_MAGIC,
+        .version = PORT_TRACE_VERSION,
+        .record_size = sizeof(port_trace_record_t),
+    },
+};
+
+/* Public functions -----------------------------------------------------------*/
+void port_trace_record(uint32_t type, uint32_t id, uint32_t arg16, uint32_t arg32)
+{
+    port_trace_header_t *p_header = &port_trace_image.header;
+    uint32_t time_ms = port_system_get_millis();
+
+    uint32_t slot = __atomic_load_n(&p_header->num_records, __ATOMIC_RELAXED);
+    do
+    {
+        if (slot >= PORT_TRACE_CAPACITY)
+        {
+            __atomic_fetch_add(&p_header->dropped, 1U, __ATOMIC_RELAXED);
+            return;
+        }
+    } while (!__atomic_compare_exchange_n(&p_header->num_records, &slot, slot + 1U, true, __ATOMIC_RELAXED, __ATOMIC_RELAXED));
+
+    port_trace_record_t *p_record = &port_trace_image.records_arr[slot];
+    p_record->time_ms = time_ms;
+    p_record->type = (uint8_t)type;
+    p_record->id = (uint8_t)id;
+    p_record->arg16 = (uint16_t)((arg16 > PORT_TRACE_ARG16_MAX) ? PORT_TRACE_ARG16_MAX : arg16);
+    p_record->arg32 = arg32;
+}
+
+void port_trace_reset(void)
+{
+    port_system_enter_critical();
+    port_trace_image.header.num_records = 0;
+    port_trace_image.header.dropped = 0;
+    port_system_exit_critical();
+}
+
+uint32_t port_trace_get_num_records(void)
+{
+    return port_trace_image.header.num_records;
+}
+
+uint32_t port_trace_get_dropped(void)
+{
+    return port_trace_image.header.dropped;
+}
+
+const void *port_trace_get_image(uint32_t *p_size)
+{
+    *p_size = sizeof(port_trace_header_t) + port_trace_image.header.num_records * sizeof(port_trace_record_t);
+    return &port_trace_image;
+}
+
+bool port_trace_save(const char *p_path)
+{
+    uint32_t size;
+    const void *p_image = port_trace_get_image(&size);
+    FILE *p_file = fopen(p_path, "wb");
+    if (p_file == NULL)
+    {
+        return false;
+    }
+    bool ok = (fwrite(p_image, 1, size, p_file) == size);
+    return (fclose(p_file) == 0) && ok;
+}
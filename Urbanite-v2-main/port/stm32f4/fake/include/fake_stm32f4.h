@@ -0,0 +1,93 @@
+/**
+ * @file fake_stm32f4.h
+ * @brief Header for the register model of the STM32F4 that runs the STM32F4 port on the host.
+ *
+ * The drivers of `port/stm32f4/src` are compiled unchanged against `stm32f4xx.h` of this directory, whose peripherals are plain structs. The model keeps a virtual clock of HCLK cycles and, at each synchronization point, it computes what the hardware would have done since the previous one:
+ * - GPIO: `BSRR` is applied to `ODR`, and `IDR` is computed from the outputs, the levels driven with `fake_stm32f4_gpio_set_input()` and the pulls. The edges reach the EXTI lines selected in SYSCFG and the input captures of TIM2, TIM3 and TIM5.
+ * - TIM2, TIM3, TIM5: prescaler (loaded at the update event), counter up to `ARR`, update flag, compare flags of the output channels, input capture of the channels 1 and 2, from their pins or from `EGR_CCxG`.
+ * - SysTick and the DWT cycle counter.
+ * - DMA1 streams: a transfer to the data register of USART2 lasts the time of its frames at the programmed baud rate. The data is not read.
+ * - NVIC: the interrupts are level-sensitive, pended from the flags and the enables of the peripherals, and served by priority, with the grouping of AIRCR, BASEPRI and PRIMASK. The handlers of `interr.c` are called from the vector table of the model, so they preempt each other as in the device.
+ *
+ * The synchronization points are the core functions of `stm32f4xx.h` (NVIC, BASEPRI, `__NOP()`, `__WFI()`) and the functions of this header. Between them the code runs in zero virtual time, and the ISRs do not run. `__NOP()` advances one cycle and `__WFI()` advances to the next event of the peripherals. With PRIMASK set, `__WFI()` returns when an interrupt that would preempt is pending, and the interrupt is served by `__enable_irq()`, as in the device.
+ *
+ * Limitations, because a register write cannot be observed by the model:
+ * - Registers with clear-on-write semantics (`TIM_SR` and `USART_SR` rc_w0, `EXTI_PR` rc_w1, `DMA_xIFCR`) are compared with the value left by the model at the previous synchronization point. Writing 1 to an `EXTI_PR` bit that the model has just set is only seen when the EXTI handler returns, where the lines pending at its entry are cleared.
+ * - Reading `CCRx` clears `CCxIF` in the device. `TIMx->CCRx` is a call to the model (see `ccr_access` in `stm32f4xx.h`) that clears the flag of a channel in input capture at once, so a read before the flag is tested is seen as on the device. A write to CCRx of a channel in input capture, which the device ignores, is taken as a read and is stored.
+ * - `EGR_UG` reinitializes the counter and loads the prescaler, but it does not set `UIF`: the drivers clear `UIF` before the next synchronization point, so the net effect is the same.
+ * - The cycles of the host code are not counted: `DWT->CYCCNT` only advances with the virtual clock.
+ *
+ * @date 2025-01-01
+ */
+#ifndef FAKE_STM32F4_H_
+#define FAKE_STM32F4_H_
+
+/* Includes ------------------------------------------------------------------*/
+/* Standard C includes */
+#include <stdint.h>
+#include <stdbool.h>
+
+/* HW dependent includes */
+#include "stm32f4xx.h"
+
+/* Defines and enums ----------------------------------------------------------*/
+#define FAKE_STM32F4_HCLK_HZ 16000000U /*!< Frequency of the virtual clock: HSI, without PLL, as configured by `port_system_init()` */
+
+/* Function prototypes and explanation -------------------------------------------------*/
+/**
+ * @brief Restore the reset values of every register and the state of the model. The virtual clock is not reset.
+ */
+void fake_stm32f4_reset(void);
+
+/**
+ * @brief Synchronization point: apply the register writes done since the previous one and serve the pending interrupts.
+ */
+void fake_stm32f4_sync(void);
+
+/**
+ * @brief Advance the virtual clock, serving the interrupts at the cycle they are raised.
+ *
+ * @param cycles Cycles of HCLK
+ */
+void fake_stm32f4_advance_cycles(uint64_t cycles);
+
+/**
+ * @brief Advance the virtual clock, serving the interrupts at the cycle they are raised.
+ *
+ * @param us Microseconds
+ */
+void fake_stm32f4_advance_us(uint32_t us);
+
+/**
+ * @brief Get the virtual clock.
+ *
+ * @return Cycles of HCLK since the start of the program
+ */
+uint64_t fake_stm32f4_get_cycles(void);
+
+/**
+ * @brief Drive the level of a pin from outside the device (e.g., the echo of an ultrasound sensor or a button). The edge is processed at once, at the current cycle.
+ *
+ * @param p_port Port of the pin (`GPIOA`, `GPIOB` or `GPIOC`)
+ * @param pin Pin (from 0 to 15)
+ * @param level Level of the pin
+ */
+void fake_stm32f4_gpio_set_input(GPIO_TypeDef *p_port, uint8_t pin, bool level);
+
+/**
+ * @brief Stop driving a pin. It reads its pull-up or pull-down again.
+ *
+ * @param p_port Port of the pin (`GPIOA`, `GPIOB` or `GPIOC`)
+ * @param pin Pin (from 0 to 15)
+ */
+void fake_stm32f4_gpio_release_input(GPIO_TypeDef *p_port, uint8_t pin);
+
+/**
+ * @brief Get the number of times the handler of an interrupt has been called since the last reset of the model.
+ *
+ * @param irqn Interrupt number, or `SysTick_IRQn`
+ * @return Number of calls
+ */
+uint32_t fake_stm32f4_get_irq_count(IRQn_Type irqn);
+
+#endif /* FAKE_STM32F4_H_ */
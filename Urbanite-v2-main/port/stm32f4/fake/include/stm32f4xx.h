@@ -0,0 +1,582 @@
+/**
+ * @file stm32f4xx.h
+ * @brief Register model of the STM32F446RE for the host build of the STM32F4 port.
+ *
+ * This header replaces the CMSIS device header when the STM32F4 port is compiled for the host (`-DFAKE_STM32F4=true`). It declares the same types, instances, bit definitions and core functions that the port and its tests use, so the drivers compile unchanged. The peripherals are plain structs in memory and the behaviour of the hardware (counters, captures, flags and interrupts) is computed by `fake_stm32f4.c` at the synchronization points of the model. See `fake_stm32f4.h`.
+ *
+ * Only the subset of the device used by the project is declared. The field names and the bit positions are the ones of the reference manual (RM0390) and of the CMSIS headers.
+ *
+ * @date 2025-01-01
+ */
+#ifndef STM32F4XX_H_
+#define STM32F4XX_H_
+
+/* Includes ------------------------------------------------------------------*/
+/* Standard C includes */
+#include <stdint.h>
+
+/* Defines and enums ----------------------------------------------------------*/
+/* Core */
+#define __NVIC_PRIO_BITS 4U /*!< Bits of priority implemented in the NVIC */
+#define __FPU_PRESENT 1U    /*!< The device has FPU */
+#define __FPU_USED 0U       /*!< The host does not use the FPU of the model */
+
+#define __IO volatile       /*!< Read/write register */
+#define __I volatile        /*!< Read-only register. Not enforced, so the model can update it */
+#define __O volatile        /*!< Write-only register */
+
+/**
+ * @brief Interrupt numbers of the STM32F446RE used by the project
+ */
+typedef enum
+{
+    SysTick_IRQn = -1,         /*!< Cortex-M4 System tick */
+    EXTI0_IRQn = 6,            /*!< EXTI line 0 */
+    EXTI1_IRQn = 7,            /*!< EXTI line 1 */
+    EXTI2_IRQn = 8,            /*!< EXTI line 2 */
+    EXTI3_IRQn = 9,            /*!< EXTI line 3 */
+    EXTI4_IRQn = 10,           /*!< EXTI line 4 */
+    DMA1_Stream6_IRQn = 17,    /*!< DMA1 stream 6 */
+    EXTI9_5_IRQn = 23,         /*!< EXTI lines 5 to 9 */
+    TIM2_IRQn = 28,            /*!< TIM2 */
+    TIM3_IRQn = 29,            /*!< TIM3 */
+    EXTI15_10_IRQn = 40,       /*!< EXTI lines 10 to 15 */
+    TIM5_IRQn = 50,            /*!< TIM5 */
+    FAKE_STM32F4_NUM_IRQS = 97 /*!< Number of device interrupts */
+} IRQn_Type;
+
+/* Typedefs --------------------------------------------------------------------*/
+/**
+ * @brief General-purpose I/O
+ */
+typedef struct
+{
+    __IO uint32_t MODER;   /*!< Port mode register */
+    __IO uint32_t OTYPER;  /*!< Port output type register */
+    __IO uint32_t OSPEEDR; /*!< Port output speed register */
+    __IO uint32_t PUPDR;   /*!< Port pull-up/pull-down register */
+    __IO uint32_t IDR;     /*!< Port input data register. Computed by the model */
+    __IO uint32_t ODR;     /*!< Port output data register */
+    __IO uint32_t BSRR;    /*!< Port bit set/reset register. Write-only: applied and cleared by the model */
+    __IO uint32_t LCKR;    /*!< Port configuration lock register */
+    __IO uint32_t AFR[2];  /*!< Alternate function registers (AFRL and AFRH) */
+} GPIO_TypeDef;
+
+/**
+ * @brief General-purpose timers (TIM2 to TIM5)
+ */
+typedef struct
+{
+    __IO uint32_t CR1;   /*!< Control register 1 */
+    __IO uint32_t CR2;   /*!< Control register 2 */
+    __IO uint32_t SMCR;  /*!< Slave mode control register */
+    __IO uint32_t DIER;  /*!< DMA/interrupt enable register */
+    __IO uint32_t SR;    /*!< Status register. rc_w0 */
+    __IO uint32_t EGR;   /*!< Event generation register. Write-only */
+    __IO uint32_t CCMR1; /*!< Capture/compare mode register 1 */
+    __IO uint32_t CCMR2; /*!< Capture/compare mode register 2 */
+    __IO uint32_t CCER;  /*!< Capture/compare enable register */
+    __IO uint32_t CNT;   /*!< Counter */
+    __IO uint32_t PSC;   /*!< Prescaler */
+    __IO uint32_t ARR;   /*!< Auto-reload register */
+    __IO uint32_t RCR;   /*!< Repetition counter register */
+    __IO uint32_t ccr_arr[4]; /*!< Capture/compare registers 1 to 4, as seen by the model. The software accesses them as `CCRx` */
+    __IO uint32_t BDTR;  /*!< Break and dead-time register */
+    __IO uint32_t DCR;   /*!< DMA control register */
+    __IO uint32_t DMAR;  /*!< DMA address for full transfer */
+    __IO uint32_t OR;    /*!< Option register */
+    volatile uint32_t *(*ccr_access)(uint32_t channel); /*!< Access of the software to CCRx: in input capture, it clears CCxIF as a read of the device */
+} TIM_TypeDef;
+
+/* Reading CCRx clears CCxIF in the device, so `TIMx->CCRx` is a call to the model that returns the register */
+#define CCR1 ccr_access(1U)[0] /*!< Capture/compare register 1 */
+#define CCR2 ccr_access(2U)[0] /*!< Capture/compare register 2 */
+#define CCR3 ccr_access(3U)[0] /*!< Capture/compare register 3 */
+#define CCR4 ccr_access(4U)[0] /*!< Capture/compare register 4 */
+
+/**
+ * @brief External interrupt/event controller
+ */
+typedef struct
+{
+    __IO uint32_t IMR;   /*!< Interrupt mask register */
+    __IO uint32_t EMR;   /*!< Event mask register */
+    __IO uint32_t RTSR;  /*!< Rising trigger selection register */
+    __IO uint32_t FTSR;  /*!< Falling trigger selection register */
+    __IO uint32_t SWIER; /*!< Software interrupt event register */
+    __IO uint32_t PR;    /*!< Pending register. rc_w1 */
+} EXTI_TypeDef;
+
+/**
+ * @brief System configuration controller
+ */
+typedef struct
+{
+    __IO uint32_t MEMRMP;    /*!< Memory remap register */
+    __IO uint32_t PMC;       /*!< Peripheral mode configuration register */
+    __IO uint32_t EXTICR[4]; /*!< External interrupt configuration registers */
+    uint32_t RESERVED[2];    /*!< Reserved */
+    __IO uint32_t CMPCR;     /*!< Compensation cell control register */
+} SYSCFG_TypeDef;
+
+/**
+ * @brief Reset and clock control
+ */
+typedef struct
+{
+    __IO uint32_t CR;         /*!< Clock control register */
+    __IO uint32_t PLLCFGR;    /*!< PLL configuration register */
+    __IO uint32_t CFGR;       /*!< Clock configuration register */
+    __IO uint32_t CIR;        /*!< Clock interrupt register */
+    __IO uint32_t AHB1RSTR;   /*!< AHB1 peripheral reset register */
+    __IO uint32_t AHB2RSTR;   /*!< AHB2 peripheral reset register */
+    __IO uint32_t AHB3RSTR;   /*!< AHB3 peripheral reset register */
+    uint32_t RESERVED0;       /*!< Reserved */
+    __IO uint32_t APB1RSTR;   /*!< APB1 peripheral reset register */
+    __IO uint32_t APB2RSTR;   /*!< APB2 peripheral reset register */
+    uint32_t RESERVED1[2];    /*!< Reserved */
+    __IO uint32_t AHB1ENR;    /*!< AHB1 peripheral clock enable register */
+    __IO uint32_t AHB2ENR;    /*!< AHB2 peripheral clock enable register */
+    __IO uint32_t AHB3ENR;    /*!< AHB3 peripheral clock enable register */
+    uint32_t RESERVED2;       /*!< Reserved */
+    __IO uint32_t APB1ENR;    /*!< APB1 peripheral clock enable register */
+    __IO uint32_t APB2ENR;    /*!< APB2 peripheral clock enable register */
+} RCC_TypeDef;
+
+/**
+ * @brief Power control
+ */
+typedef struct
+{
+    __IO uint32_t CR;  /*!< Power control register */
+    __IO uint32_t CSR; /*!< Power control/status register */
+} PWR_TypeDef;
+
+/**
+ * @brief Flash interface
+ */
+typedef struct
+{
+    __IO uint32_t ACR;     /*!< Access control register */
+    __IO uint32_t KEYR;    /*!< Key register */
+    __IO uint32_t OPTKEYR; /*!< Option key register */
+    __IO uint32_t SR;      /*!< Status register */
+    __IO uint32_t CR;      /*!< Control register */
+    __IO uint32_t OPTCR;   /*!< Option control register */
+} FLASH_TypeDef;
+
+/**
+ * @brief DMA stream
+ */
+typedef struct
+{
+    __IO uint32_t CR;   /*!< Configuration register */
+    __IO uint32_t NDTR; /*!< Number of data register */
+    __IO uint32_t PAR;  /*!< Peripheral address register */
+    __IO uint32_t M0AR; /*!< Memory 0 address register */
+    __IO uint32_t M1AR; /*!< Memory 1 address register */
+    __IO uint32_t FCR;  /*!< FIFO control register */
+} DMA_Stream_TypeDef;
+
+/**
+ * @brief DMA controller
+ */
+typedef struct
+{
+    __IO uint32_t LISR;  /*!< Low interrupt status register (streams 0 to 3) */
+    __IO uint32_t HISR;  /*!< High interrupt status register (streams 4 to 7) */
+    __IO uint32_t LIFCR; /*!< Low interrupt flag clear register. Write-only */
+    __IO uint32_t HIFCR; /*!< High interrupt flag clear register. Write-only */
+} DMA_TypeDef;
+
+/**
+ * @brief Universal synchronous asynchronous receiver transmitter
+ */
+typedef struct
+{
+    __IO uint32_t SR;   /*!< Status register */
+    __IO uint32_t DR;   /*!< Data register */
+    __IO uint32_t BRR;  /*!< Baud rate register */
+    __IO uint32_t CR1;  /*!< Control register 1 */
+    __IO uint32_t CR2;  /*!< Control register 2 */
+    __IO uint32_t CR3;  /*!< Control register 3 */
+    __IO uint32_t GTPR; /*!< Guard time and prescaler register */
+} USART_TypeDef;
+
+/**
+ * @brief Nested vectored interrupt controller
+ */
+typedef struct
+{
+    __IO uint32_t ISER[8];  /*!< Interrupt set-enable registers */
+    uint32_t RESERVED0[24]; /*!< Reserved */
+    __IO uint32_t ICER[8];  /*!< Interrupt clear-enable registers */
+    uint32_t RESERVED1[24]; /*!< Reserved */
+    __IO uint32_t ISPR[8];  /*!< Interrupt set-pending registers */
+    uint32_t RESERVED2[24]; /*!< Reserved */
+    __IO uint32_t ICPR[8];  /*!< Interrupt clear-pending registers */
+    uint32_t RESERVED3[24]; /*!< Reserved */
+    __IO uint32_t IABR[8];  /*!< Interrupt active bit registers */
+    uint32_t RESERVED4[56]; /*!< Reserved */
+    __IO uint8_t IP[240];   /*!< Interrupt priority registers (8 bits wide) */
+    uint32_t RESERVED5[644]; /*!< Reserved */
+    __O uint32_t STIR;      /*!< Software trigger interrupt register */
+} NVIC_Type;
+
+/**
+ * @brief System control block
+ */
+typedef struct
+{
+    __I uint32_t CPUID;  /*!< CPUID base register */
+    __IO uint32_t ICSR;  /*!< Interrupt control and state register */
+    __IO uint32_t VTOR;  /*!< Vector table offset register */
+    __IO uint32_t AIRCR; /*!< Application interrupt and reset control register */
+    __IO uint32_t SCR;   /*!< System control register */
+    __IO uint32_t CCR;   /*!< Configuration control register */
+    __IO uint8_t SHP[12]; /*!< System handlers priority registers (4-7, 8-11, 12-15) */
+    __IO uint32_t SHCSR; /*!< System handler control and state register */
+    __IO uint32_t CFSR;  /*!< Configurable fault status register */
+    __IO uint32_t HFSR;  /*!< HardFault status register */
+    __IO uint32_t DFSR;  /*!< Debug fault status register */
+    __IO uint32_t MMFAR; /*!< MemManage fault address register */
+    __IO uint32_t BFAR;  /*!< BusFault address register */
+    __IO uint32_t AFSR;  /*!< Auxiliary fault status register */
+    __I uint32_t PFR[2]; /*!< Processor feature register */
+    __I uint32_t DFR;    /*!< Debug feature register */
+    __I uint32_t ADR;    /*!< Auxiliary feature register */
+    __I uint32_t MMFR[4]; /*!< Memory model feature register */
+    __I uint32_t ISAR[5]; /*!< Instruction set attributes register */
+    uint32_t RESERVED0[5]; /*!< Reserved */
+    __IO uint32_t CPACR; /*!< Coprocessor access control register */
+} SCB_Type;
+
+/**
+ * @brief System tick timer
+ */
+typedef struct
+{
+    __IO uint32_t CTRL;  /*!< Control and status register */
+    __IO uint32_t LOAD;  /*!< Reload value register */
+    __IO uint32_t VAL;   /*!< Current value register */
+    __I uint32_t CALIB;  /*!< Calibration register */
+} SysTick_Type;
+
+/**
+ * @brief Data watchpoint and trace unit
+ */
+typedef struct
+{
+    __IO uint32_t CTRL;   /*!< Control register */
+    __IO uint32_t CYCCNT; /*!< Cycle count register */
+} DWT_Type;
+
+/**
+ * @brief Instrumentation trace macrocell
+ */
+typedef struct
+{
+    __O union
+    {
+        __O uint8_t u8;   /*!< Stimulus port, 8-bit */
+        __O uint16_t u16; /*!< Stimulus port, 16-bit */
+        __O uint32_t u32; /*!< Stimulus port, 32-bit */
+    } PORT[32];            /*!< Stimulus port registers */
+    uint32_t RESERVED0[864]; /*!< Reserved */
+    __IO uint32_t TER;     /*!< Trace enable register */
+    uint32_t RESERVED1[15]; /*!< Reserved */
+    __IO uint32_t TPR;     /*!< Trace privilege register */
+    uint32_t RESERVED2[15]; /*!< Reserved */
+    __IO uint32_t TCR;     /*!< Trace control register */
+} ITM_Type;
+
+/**
+ * @brief Core debug registers
+ */
+typedef struct
+{
+    __IO uint32_t DHCSR; /*!< Debug halting control and status register */
+    __O uint32_t DCRSR;  /*!< Debug core register selector register */
+    __IO uint32_t DCRDR; /*!< Debug core register data register */
+    __IO uint32_t DEMCR; /*!< Debug exception and monitor control register */
+} CoreDebug_Type;
+
+/* System variables (system_stm32f4xx.h), defined by stm32f4_system.c -------*/
+extern uint32_t SystemCoreClock;         /*!< Frequency of the System clock */
+extern const uint8_t AHBPrescTable[16]; /*!< Prescaler values for AHB bus */
+extern const uint8_t APBPrescTable[8];  /*!< Prescaler values for APB bus */
+
+/* Peripheral instances ------------------------------------------------------*/
+extern GPIO_TypeDef fake_stm32f4_gpioa;         /*!< Model of GPIOA */
+extern GPIO_TypeDef fake_stm32f4_gpiob;         /*!< Model of GPIOB */
+extern GPIO_TypeDef fake_stm32f4_gpioc;         /*!< Model of GPIOC */
+extern TIM_TypeDef fake_stm32f4_tim2;           /*!< Model of TIM2 */
+extern TIM_TypeDef fake_stm32f4_tim3;           /*!< Model of TIM3 */
+extern TIM_TypeDef fake_stm32f4_tim5;           /*!< Model of TIM5 */
+extern EXTI_TypeDef fake_stm32f4_exti;          /*!< Model of EXTI */
+extern SYSCFG_TypeDef fake_stm32f4_syscfg;      /*!< Model of SYSCFG */
+extern RCC_TypeDef fake_stm32f4_rcc;            /*!< Model of RCC */
+extern PWR_TypeDef fake_stm32f4_pwr;            /*!< Model of PWR */
+extern FLASH_TypeDef fake_stm32f4_flash;        /*!< Model of the flash interface */
+extern DMA_TypeDef fake_stm32f4_dma1;           /*!< Model of DMA1 */
+extern DMA_Stream_TypeDef fake_stm32f4_dma1_stream_arr[8]; /*!< Model of the streams of DMA1 */
+extern USART_TypeDef fake_stm32f4_usart2;       /*!< Model of USART2 */
+extern NVIC_Type fake_stm32f4_nvic;             /*!< Model of the NVIC */
+extern SCB_Type fake_stm32f4_scb;               /*!< Model of the SCB */
+extern SysTick_Type fake_stm32f4_systick;       /*!< Model of the System tick */
+extern DWT_Type fake_stm32f4_dwt;               /*!< Model of the DWT */
+extern ITM_Type fake_stm32f4_itm;               /*!< Model of the ITM */
+extern CoreDebug_Type fake_stm32f4_core_debug;  /*!< Model of the core debug registers */
+
+#define GPIOA (&fake_stm32f4_gpioa)                      /*!< GPIOA */
+#define GPIOB (&fake_stm32f4_gpiob)                      /*!< GPIOB */
+#define GPIOC (&fake_stm32f4_gpioc)                      /*!< GPIOC */
+#define TIM2 (&fake_stm32f4_tim2)                        /*!< TIM2 */
+#define TIM3 (&fake_stm32f4_tim3)                        /*!< TIM3 */
+#define TIM5 (&fake_stm32f4_tim5)                        /*!< TIM5 */
+#define EXTI (&fake_stm32f4_exti)                        /*!< EXTI */
+#define SYSCFG (&fake_stm32f4_syscfg)                    /*!< SYSCFG */
+#define RCC (&fake_stm32f4_rcc)                          /*!< RCC */
+#define PWR (&fake_stm32f4_pwr)                          /*!< PWR */
+#define FLASH (&fake_stm32f4_flash)                      /*!< Flash interface */
+#define DMA1 (&fake_stm32f4_dma1)                        /*!< DMA1 */
+#define DMA1_Stream6 (&fake_stm32f4_dma1_stream_arr[6])  /*!< DMA1 stream 6 */
+#define USART2 (&fake_stm32f4_usart2)                    /*!< USART2 */
+#define NVIC (&fake_stm32f4_nvic)                        /*!< NVIC */
+#define SCB (&fake_stm32f4_scb)                          /*!< SCB */
+#define SysTick (&fake_stm32f4_systick)                  /*!< System tick */
+#define DWT (&fake_stm32f4_dwt)                          /*!< DWT */
+#define ITM (&fake_stm32f4_itm)                          /*!< ITM */
+#define CoreDebug (&fake_stm32f4_core_debug)             /*!< Core debug registers */
+
+/* Bit definitions -------------------------------------------------------------*/
+/* GPIO */
+#define GPIO_MODER_MODER0_Pos (0U)
+#define GPIO_MODER_MODER0_Msk (0x3U << GPIO_MODER_MODER0_Pos)
+#define GPIO_MODER_MODER0 GPIO_MODER_MODER0_Msk
+#define GPIO_PUPDR_PUPD0_Pos (0U)
+#define GPIO_PUPDR_PUPD0_Msk (0x3U << GPIO_PUPDR_PUPD0_Pos)
+#define GPIO_PUPDR_PUPD0 GPIO_PUPDR_PUPD0_Msk
+
+/* TIM */
+#define TIM_CR1_CEN_Pos (0U)
+#define TIM_CR1_CEN_Msk (0x1U << TIM_CR1_CEN_Pos)
+#define TIM_CR1_CEN TIM_CR1_CEN_Msk
+#define TIM_CR1_ARPE_Pos (7U)
+#define TIM_CR1_ARPE_Msk (0x1U << TIM_CR1_ARPE_Pos)
+#define TIM_CR1_ARPE TIM_CR1_ARPE_Msk
+#define TIM_DIER_UIE_Pos (0U)
+#define TIM_DIER_UIE_Msk (0x1U << TIM_DIER_UIE_Pos)
+#define TIM_DIER_UIE TIM_DIER_UIE_Msk
+#define TIM_DIER_CC1IE_Pos (1U)
+#define TIM_DIER_CC1IE_Msk (0x1U << TIM_DIER_CC1IE_Pos)
+#define TIM_DIER_CC1IE TIM_DIER_CC1IE_Msk
+#define TIM_DIER_CC2IE_Pos (2U)
+#define TIM_DIER_CC2IE_Msk (0x1U << TIM_DIER_CC2IE_Pos)
+#define TIM_DIER_CC2IE TIM_DIER_CC2IE_Msk
+#define TIM_SR_UIF_Pos (0U)
+#define TIM_SR_UIF_Msk (0x1U << TIM_SR_UIF_Pos)
+#define TIM_SR_UIF TIM_SR_UIF_Msk
+#define TIM_SR_CC1IF_Pos (1U)
+#define TIM_SR_CC1IF_Msk (0x1U << TIM_SR_CC1IF_Pos)
+#define TIM_SR_CC1IF TIM_SR_CC1IF_Msk
+#define TIM_SR_CC2IF_Pos (2U)
+#define TIM_SR_CC2IF_Msk (0x1U << TIM_SR_CC2IF_Pos)
+#define TIM_SR_CC2IF TIM_SR_CC2IF_Msk
+#define TIM_SR_CC1OF_Pos (9U)
+#define TIM_SR_CC1OF_Msk (0x1U << TIM_SR_CC1OF_Pos)
+#define TIM_SR_CC1OF TIM_SR_CC1OF_Msk
+#define TIM_SR_CC2OF_Pos (10U)
+#define TIM_SR_CC2OF_Msk (0x1U << TIM_SR_CC2OF_Pos)
+#define TIM_SR_CC2OF TIM_SR_CC2OF_Msk
+#define TIM_EGR_UG_Pos (0U)
+#define TIM_EGR_UG_Msk (0x1U << TIM_EGR_UG_Pos)
+#define TIM_EGR_UG TIM_EGR_UG_Msk
+#define TIM_EGR_CC1G_Pos (1U)
+#define TIM_EGR_CC1G_Msk (0x1U << TIM_EGR_CC1G_Pos)
+#define TIM_EGR_CC1G TIM_EGR_CC1G_Msk
+#define TIM_EGR_CC2G_Pos (2U)
+#define TIM_EGR_CC2G_Msk (0x1U << TIM_EGR_CC2G_Pos)
+#define TIM_EGR_CC2G TIM_EGR_CC2G_Msk
+#define TIM_CCMR1_CC1S_Pos (0U)
+#define TIM_CCMR1_CC1S_Msk (0x3U << TIM_CCMR1_CC1S_Pos)
+#define TIM_CCMR1_CC1S TIM_CCMR1_CC1S_Msk
+#define TIM_CCMR1_IC1PSC_Pos (2U)
+#define TIM_CCMR1_IC1PSC_Msk (0x3U << TIM_CCMR1_IC1PSC_Pos)
+#define TIM_CCMR1_IC1PSC TIM_CCMR1_IC1PSC_Msk
+#define TIM_CCMR1_OC1M_Pos (4U)
+#define TIM_CCMR1_OC1M_Msk (0x7U << TIM_CCMR1_OC1M_Pos)
+#define TIM_CCMR1_OC1M TIM_CCMR1_OC1M_Msk
+#define TIM_CCMR1_IC1F_Pos (4U)
+#define TIM_CCMR1_IC1F_Msk (0xFU << TIM_CCMR1_IC1F_Pos)
+#define TIM_CCMR1_IC1F TIM_CCMR1_IC1F_Msk
+#define TIM_CCMR1_CC2S_Pos (8U)
+#define TIM_CCMR1_CC2S_Msk (0x3U << TIM_CCMR1_CC2S_Pos)
+#define TIM_CCMR1_CC2S TIM_CCMR1_CC2S_Msk
+#define TIM_CCMR1_IC2PSC_Pos (10U)
+#define TIM_CCMR1_IC2PSC_Msk (0x3U << TIM_CCMR1_IC2PSC_Pos)
+#define TIM_CCMR1_IC2PSC TIM_CCMR1_IC2PSC_Msk
+#define TIM_CCMR1_IC2F_Pos (12U)
+#define TIM_CCMR1_IC2F_Msk (0xFU << TIM_CCMR1_IC2F_Pos)
+#define TIM_CCMR1_IC2F TIM_CCMR1_IC2F_Msk
+#define TIM_CCER_CC1E_Pos (0U)
+#define TIM_CCER_CC1E_Msk (0x1U << TIM_CCER_CC1E_Pos)
+#define TIM_CCER_CC1E TIM_CCER_CC1E_Msk
+#define TIM_CCER_CC1P_Pos (1U)
+#define TIM_CCER_CC1P_Msk (0x1U << TIM_CCER_CC1P_Pos)
+#define TIM_CCER_CC1P TIM_CCER_CC1P_Msk
+#define TIM_CCER_CC1NP_Pos (3U)
+#define TIM_CCER_CC1NP_Msk (0x1U << TIM_CCER_CC1NP_Pos)
+#define TIM_CCER_CC1NP TIM_CCER_CC1NP_Msk
+#define TIM_CCER_CC2E_Pos (4U)
+#define TIM_CCER_CC2E_Msk (0x1U << TIM_CCER_CC2E_Pos)
+#define TIM_CCER_CC2E TIM_CCER_CC2E_Msk
+#define TIM_CCER_CC2P_Pos (5U)
+#define TIM_CCER_CC2P_Msk (0x1U << TIM_CCER_CC2P_Pos)
+#define TIM_CCER_CC2P TIM_CCER_CC2P_Msk
+#define TIM_CCER_CC2NP_Pos (7U)
+#define TIM_CCER_CC2NP_Msk (0x1U << TIM_CCER_CC2NP_Pos)
+#define TIM_CCER_CC2NP TIM_CCER_CC2NP_Msk
+
+/* RCC */
+#define RCC_CR_HSITRIM_Pos (3U)
+#define RCC_CR_HSITRIM_Msk (0x1FU << RCC_CR_HSITRIM_Pos)
+#define RCC_CR_HSITRIM RCC_CR_HSITRIM_Msk
+#define RCC_CFGR_SW_Pos (0U)
+#define RCC_CFGR_SW_Msk (0x3U << RCC_CFGR_SW_Pos)
+#define RCC_CFGR_SW RCC_CFGR_SW_Msk
+#define RCC_CFGR_SW_HSI 0x00000000U
+#define RCC_CFGR_HPRE_Pos (4U)
+#define RCC_CFGR_HPRE_Msk (0xFU << RCC_CFGR_HPRE_Pos)
+#define RCC_CFGR_HPRE RCC_CFGR_HPRE_Msk
+#define RCC_CFGR_PPRE1_Pos (10U)
+#define RCC_CFGR_PPRE1_Msk (0x7U << RCC_CFGR_PPRE1_Pos)
+#define RCC_CFGR_PPRE1 RCC_CFGR_PPRE1_Msk
+#define RCC_AHB1ENR_GPIOAEN (0x1U << 0U)
+#define RCC_AHB1ENR_GPIOBEN (0x1U << 1U)
+#define RCC_AHB1ENR_GPIOCEN (0x1U << 2U)
+#define RCC_AHB1ENR_DMA1EN (0x1U << 21U)
+#define RCC_APB1ENR_TIM2EN (0x1U << 0U)
+#define RCC_APB1ENR_TIM3EN (0x1U << 1U)
+#define RCC_APB1ENR_TIM5EN (0x1U << 3U)
+#define RCC_APB1ENR_USART2EN (0x1U << 17U)
+#define RCC_APB1ENR_PWREN (0x1U << 28U)
+#define RCC_APB2ENR_SYSCFGEN (0x1U << 14U)
+
+/* PWR */
+#define PWR_CR_VOS_Pos (14U)
+#define PWR_CR_VOS_Msk (0x3U << PWR_CR_VOS_Pos)
+#define PWR_CR_VOS PWR_CR_VOS_Msk
+
+/* FLASH */
+#define FLASH_ACR_LATENCY_2WS 0x00000002U
+#define FLASH_ACR_PRFTEN (0x1U << 8U)
+#define FLASH_ACR_ICEN (0x1U << 9U)
+#define FLASH_ACR_DCEN (0x1U << 10U)
+
+/* DMA */
+#define DMA_SxCR_EN (0x1U << 0U)
+#define DMA_SxCR_TEIE (0x1U << 2U)
+#define DMA_SxCR_TCIE (0x1U << 4U)
+#define DMA_SxCR_DIR_0 (0x1U << 6U)
+#define DMA_SxCR_MINC (0x1U << 10U)
+#define DMA_SxCR_CHSEL_Pos (25U)
+#define DMA_HISR_FEIF6 (0x1U << 16U)
+#define DMA_HISR_DMEIF6 (0x1U << 18U)
+#define DMA_HISR_TEIF6 (0x1U << 19U)
+#define DMA_HISR_HTIF6 (0x1U << 20U)
+#define DMA_HISR_TCIF6 (0x1U << 21U)
+#define DMA_HIFCR_CFEIF6 (0x1U << 16U)
+#define DMA_HIFCR_CDMEIF6 (0x1U << 18U)
+#define DMA_HIFCR_CTEIF6 (0x1U << 19U)
+#define DMA_HIFCR_CHTIF6 (0x1U << 20U)
+#define DMA_HIFCR_CTCIF6 (0x1U << 21U)
+
+/* USART */
+#define USART_SR_TC (0x1U << 6U)
+#define USART_SR_TXE (0x1U << 7U)
+#define USART_CR1_TE (0x1U << 3U)
+#define USART_CR1_UE (0x1U << 13U)
+#define USART_CR3_DMAT (0x1U << 7U)
+
+/* Core */
+#define SysTick_CTRL_ENABLE_Msk (0x1U << 0U)
+#define SysTick_CTRL_TICKINT_Msk (0x1U << 1U)
+#define SysTick_CTRL_CLKSOURCE_Msk (0x1U << 2U)
+#define SysTick_CTRL_COUNTFLAG_Msk (0x1U << 16U)
+#define SysTick_LOAD_RELOAD_Msk (0xFFFFFFU)
+#define SCB_ICSR_PENDSTSET_Msk (0x1U << 26U)
+#define SCB_AIRCR_PRIGROUP_Pos (8U)
+#define SCB_AIRCR_PRIGROUP_Msk (0x7U << SCB_AIRCR_PRIGROUP_Pos)
+#define DWT_CTRL_CYCCNTENA_Msk (0x1U << 0U)
+#define ITM_TCR_ITMENA_Msk (0x1U << 0U)
+#define CoreDebug_DEMCR_TRCENA_Msk (0x1U << 24U)
+
+/* Function prototypes and explanation -------------------------------------------------*/
+/* Core functions of CMSIS. They are the synchronization points of the model: they apply the register writes and serve the pending interrupts */
+void NVIC_SetPriorityGrouping(uint32_t priority_group);        /*!< Set the priority grouping field of AIRCR */
+uint32_t NVIC_GetPriorityGrouping(void);                       /*!< Get the priority grouping field of AIRCR */
+void NVIC_EnableIRQ(IRQn_Type irqn);                           /*!< Enable a device interrupt */
+void NVIC_DisableIRQ(IRQn_Type irqn);                          /*!< Disable a device interrupt */
+uint32_t NVIC_GetEnableIRQ(IRQn_Type irqn);                    /*!< Get the enable state of a device interrupt */
+void NVIC_SetPendingIRQ(IRQn_Type irqn);                       /*!< Pend a device interrupt */
+void NVIC_ClearPendingIRQ(IRQn_Type irqn);                     /*!< Clear the pending state of a device interrupt */
+uint32_t NVIC_GetPendingIRQ(IRQn_Type irqn);                   /*!< Get the pending state of a device interrupt */
+void NVIC_SetPriority(IRQn_Type irqn, uint32_t priority);      /*!< Set the priority of an interrupt or of the System tick */
+uint32_t NVIC_GetPriority(IRQn_Type irqn);                     /*!< Get the priority of an interrupt or of the System tick */
+uint32_t SysTick_Config(uint32_t ticks);                       /*!< Start the System tick with its interrupt at the lowest priority */
+void __set_BASEPRI(uint32_t basepri);                          /*!< Set BASEPRI */
+void __set_BASEPRI_MAX(uint32_t basepri);                      /*!< Raise BASEPRI, only if the new value masks more */
+uint32_t __get_BASEPRI(void);                                  /*!< Get BASEPRI */
+void __disable_irq(void);                                      /*!< Set PRIMASK */
+void __enable_irq(void);                                       /*!< Clear PRIMASK */
+void __WFI(void);                                              /*!< Advance the model to the next interrupt */
+void __NOP(void);                                              /*!< Advance the model one cycle */
+
+/**
+ * @brief Count the leading zeros of a word, as the CLZ instruction.
+ *
+ * @param value Word
+ * @return Number of leading zeros (32 if the word is 0)
+ */
+static inline uint8_t __CLZ(uint32_t value)
+{
+    return (value == 0U) ? 32U : (uint8_t)__builtin_clz(value);
+}
+
+/**
+ * @brief Encode the preemption priority and the subpriority of an interrupt, as CMSIS.
+ *
+ * @param priority_group Priority grouping field of AIRCR
+ * @param preempt_priority Preemption priority
+ * @param sub_priority Subpriority
+ * @return Priority for `NVIC_SetPriority()`
+ */
+static inline uint32_t NVIC_EncodePriority(uint32_t priority_group, uint32_t preempt_priority, uint32_t sub_priority)
+{
+    uint32_t group = priority_group & 0x07UL;
+    uint32_t preempt_bits = ((7UL - group) > __NVIC_PRIO_BITS) ? __NVIC_PRIO_BITS : (7UL - group);
+    uint32_t sub_bits = ((group + __NVIC_PRIO_BITS) < 7UL) ? 0UL : ((group - 7UL) + __NVIC_PRIO_BITS);
+
+    return (((preempt_priority & ((1UL << preempt_bits) - 1UL)) << sub_bits) | (sub_priority & ((1UL << sub_bits) - 1UL)));
+}
+
+/**
+ * @brief Decode the priority of an interrupt into its preemption priority and its subpriority, as CMSIS.
+ *
+ * @param priority Priority returned by `NVIC_GetPriority()`
+ * @param priority_group Priority grouping field of AIRCR
+ * @param p_preempt_priority Pointer to store the preemption priority
+ * @param p_sub_priority Pointer to store the subpriority
+ */
+static inline void NVIC_DecodePriority(uint32_t priority, uint32_t priority_group, uint32_t *const p_preempt_priority, uint32_t *const p_sub_priority)
+{
+    uint32_t group = priority_group & 0x07UL;
+    uint32_t preempt_bits = ((7UL - group) > __NVIC_PRIO_BITS) ? __NVIC_PRIO_BITS : (7UL - group);
+    uint32_t sub_bits = ((group + __NVIC_PRIO_BITS) < 7UL) ? 0UL : ((group - 7UL) + __NVIC_PRIO_BITS);
+
+    *p_preempt_priority = (priority >> sub_bits) & ((1UL << preempt_bits) - 1UL);
+    *p_sub_priority = priority & ((1UL << sub_bits) - 1UL);
+}
+
+#endif /* STM32F4XX_H_ */
@@ -0,0 +1,1168 @@
+/**
+ * @file fake_stm32f4.c
+ * @brief Register model of the STM32F4 that runs the STM32F4 port on the host.
+ *
+ * The state of the peripherals is kept in their registers, plus a few private fields for what the software cannot see: the prescaler counters, the levels driven from outside, and the values left in the clear-on-write registers at the last synchronization point. The virtual clock advances in steps that end at the next event of any peripheral, so an interrupt is served at the cycle the device would raise it, and a long delay costs one step per event instead of one per cycle.
+ *
+ * @date 2025-01-01
+ */
+
+/* Includes ------------------------------------------------------------------*/
+/* Standard C includes */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/* HW dependent includes */
+#include "fake_stm32f4.h"
+
+/* Defines and enums ----------------------------------------------------------*/
+#define FAKE_STM32F4_NUM_PORTS 3U                                   /*!< Modelled GPIO ports: GPIOA, GPIOB and GPIOC */
+#define FAKE_STM32F4_NUM_TIMERS 3U                                  /*!< Modelled timers: TIM2, TIM3 and TIM5 */
+#define FAKE_STM32F4_NUM_STREAMS 8U                                 /*!< Streams of DMA1 */
+#define FAKE_STM32F4_NUM_CHANNELS 4U                                /*!< Capture/compare channels of a general-purpose timer */
+#define FAKE_STM32F4_IRQ_WORDS ((FAKE_STM32F4_NUM_IRQS + 31U) / 32U) /*!< Words of the NVIC registers in use */
+#define FAKE_STM32F4_NO_EVENT UINT64_MAX                            /*!< No event is scheduled */
+#define FAKE_STM32F4_THREAD_PRIO 0x100U                             /*!< Running priority of the thread mode: lower than any exception */
+#define FAKE_STM32F4_ENTRY_CYCLES 12U                               /*!< Cycles of the exception entry of the Cortex-M4 (stacking) */
+#define FAKE_STM32F4_USART_FRAME_BITS 10U                           /*!< Start bit, 8 data bits and stop bit */
+#define FAKE_STM32F4_SYSTICK_SHP 11U                                /*!< Index of the priority of SysTick in `SCB->SHP` */
+
+#define FAKE_STM32F4_TIM_CCS_INPUT 0x1U                    /*!< CCxS: the channel is an input mapped on its own TIx */
+#define FAKE_STM32F4_TIM_IRQ_FLAGS 0x5FU                   /*!< Flags of TIMx_SR with an interrupt enable at the same position of TIMx_DIER */
+#define FAKE_STM32F4_DMA_FLAGS_TCIF 0x20U                  /*!< Transfer complete flag of a stream, at the position of its flags in xISR */
+#define FAKE_STM32F4_DMA_FLAGS_HTIF 0x10U                  /*!< Half transfer flag of a stream */
+#define FAKE_STM32F4_DMA_FLAGS_TEIF 0x08U                  /*!< Transfer error flag of a stream */
+#define FAKE_STM32F4_DMA_FLAGS_ALL 0x3DU                   /*!< Flags of a stream */
+#define FAKE_STM32F4_DMA_SxCR_HTIE (0x1UL << 3U)           /*!< Half transfer interrupt enable */
+#define FAKE_STM32F4_EXTI_LINES_4_0 0x001FU                /*!< EXTI lines with their own interrupt */
+#define FAKE_STM32F4_EXTI_LINES_9_5 0x03E0U                /*!< EXTI lines of EXTI9_5 */
+#define FAKE_STM32F4_EXTI_LINES_15_10 0xFC00U              /*!< EXTI lines of EXTI15_10 */
+
+/* Reset values of the registers (RM0390 and Cortex-M4 TRM). The ones not listed are 0 */
+#define FAKE_STM32F4_GPIOA_RESET {.MODER = 0xA8000000U, .OSPEEDR = 0x0C000000U, .PUPDR = 0x64000000U} /*!< GPIOA: SWD pins in alternate function */
+#define FAKE_STM32F4_GPIOB_RESET {.MODER = 0x00000280U, .OSPEEDR = 0x000000C0U, .PUPDR = 0x00000100U} /*!< GPIOB: SWO pin in alternate function */
+#define FAKE_STM32F4_GPIOC_RESET {.MODER = 0U}
+#define FAKE_STM32F4_TIM_16_RESET(access) {.ARR = 0xFFFFU, .ccr_access = (access)}     /*!< 16-bit timers */
+#define FAKE_STM32F4_TIM_32_RESET(access) {.ARR = 0xFFFFFFFFU, .ccr_access = (access)} /*!< 32-bit timers */
+#define FAKE_STM32F4_RCC_RESET {.CR = 0x00000083U, .PLLCFGR = 0x24003010U, .AHB1ENR = 0x00100000U}
+#define FAKE_STM32F4_USART_RESET {.SR = USART_SR_TXE | USART_SR_TC}
+#define FAKE_STM32F4_SCB_RESET {.CPUID = 0x410FC241U, .AIRCR = 0xFA050000U}
+
+/* Typedefs --------------------------------------------------------------------*/
+/**
+ * @brief Hidden state of a GPIO port
+ */
+typedef struct
+{
+    GPIO_TypeDef *p_port; /*!< Registers of the port */
+    uint32_t driven;      /*!< Pins driven from outside */
+    uint32_t levels;      /*!< Levels of the pins driven from outside */
+    uint32_t idr;         /*!< Levels of the pins at the last synchronization point */
+} fake_stm32f4_port_t;
+
+/**
+ * @brief Hidden state of a timer
+ */
+typedef struct
+{
+    TIM_TypeDef *p_tim;   /*!< Registers of the timer */
+    IRQn_Type irqn;       /*!< Interrupt of the timer */
+    uint32_t counter_max; /*!< Maximum value of the counter: 16 or 32 bits */
+    uint32_t psc_count;   /*!< Prescaler counter: cycles since the last tick of the counter */
+    uint32_t psc_active;  /*!< Prescaler in use. `PSC` is loaded at the update event */
+    uint32_t sr;          /*!< Value of `SR` at the last synchronization point */
+} fake_stm32f4_timer_t;
+
+/**
+ * @brief Pin that can be routed to a capture channel of a timer
+ */
+typedef struct
+{
+    GPIO_TypeDef *p_port; /*!< Port of the pin */
+    uint8_t pin;          /*!< Pin */
+    uint8_t af;           /*!< Alternate function that connects the pin to the timer */
+    uint8_t timer;        /*!< Index of the timer in `timers_arr` */
+    uint8_t channel;      /*!< Channel of the timer (from 1 to 2) */
+} fake_stm32f4_capture_t;
+
+/**
+ * @brief Hidden state of a DMA stream
+ */
+typedef struct
+{
+    bool busy;          /*!< A transfer is in progress */
+    uint64_t end_cycle; /*!< Cycle of the end of the transfer */
+} fake_stm32f4_stream_t;
+
+/* Vector table ----------------------------------------------------------------*/
+/**
+ * @brief Handler of the interrupts without handler, like `Default_Handler` of the startup file. The device would hang in it, so the host aborts.
+ */
+static void _fake_stm32f4_default_handler(void)
+{
+    fprintf(stderr, "fake_stm32f4: unexpected interrupt without handler\n");
+    abort();
+}
+
+void SysTick_Handler(void) __attribute__((weak, alias("_fake_stm32f4_default_handler")));          /*!< Handler of SysTick */
+void EXTI0_IRQHandler(void) __attribute__((weak, alias("_fake_stm32f4_default_handler")));         /*!< Handler of EXTI line 0 */
+void EXTI1_IRQHandler(void) __attribute__((weak, alias("_fake_stm32f4_default_handler")));         /*!< Handler of EXTI line 1 */
+void EXTI2_IRQHandler(void) __attribute__((weak, alias("_fake_stm32f4_default_handler")));         /*!< Handler of EXTI line 2 */
+void EXTI3_IRQHandler(void) __attribute__((weak, alias("_fake_stm32f4_default_handler")));         /*!< Handler of EXTI line 3 */
+void EXTI4_IRQHandler(void) __attribute__((weak, alias("_fake_stm32f4_default_handler")));         /*!< Handler of EXTI line 4 */
+void DMA1_Stream6_IRQHandler(void) __attribute__((weak, alias("_fake_stm32f4_default_handler")));  /*!< Handler of DMA1 stream 6 */
+void EXTI9_5_IRQHandler(void) __attribute__((weak, alias("_fake_stm32f4_default_handler")));       /*!< Handler of EXTI lines 5 to 9 */
+void TIM2_IRQHandler(void) __attribute__((weak, alias("_fake_stm32f4_default_handler")));          /*!< Handler of TIM2 */
+void TIM3_IRQHandler(void) __attribute__((weak, alias("_fake_stm32f4_default_handler")));          /*!< Handler of TIM3 */
+void EXTI15_10_IRQHandler(void) __attribute__((weak, alias("_fake_stm32f4_default_handler")));     /*!< Handler of EXTI lines 10 to 15 */
+void TIM5_IRQHandler(void) __attribute__((weak, alias("_fake_stm32f4_default_handler")));          /*!< Handler of TIM5 */
+
+static void (*const vectors_arr[FAKE_STM32F4_NUM_IRQS])(void) = {
+    [EXTI0_IRQn] = EXTI0_IRQHandler,
+    [EXTI1_IRQn] = EXTI1_IRQHandler,
+    [EXTI2_IRQn] = EXTI2_IRQHandler,
+    [EXTI3_IRQn] = EXTI3_IRQHandler,
+    [EXTI4_IRQn] = EXTI4_IRQHandler,
+    [DMA1_Stream6_IRQn] = DMA1_Stream6_IRQHandler,
+    [EXTI9_5_IRQn] = EXTI9_5_IRQHandler,
+    [TIM2_IRQn] = TIM2_IRQHandler,
+    [TIM3_IRQn] = TIM3_IRQHandler,
+    [EXTI15_10_IRQn] = EXTI15_10_IRQHandler,
+    [TIM5_IRQn] = TIM5_IRQHandler,
+}; /*!< Handlers of the device interrupts. The interrupts not listed use the default handler */
+
+/* Access of the software to the capture/compare registers of each timer (see `ccr_access`) */
+static volatile uint32_t *_fake_stm32f4_tim2_ccr_access(uint32_t channel);
+static volatile uint32_t *_fake_stm32f4_tim3_ccr_access(uint32_t channel);
+static volatile uint32_t *_fake_stm32f4_tim5_ccr_access(uint32_t channel);
+
+/* Global variables -----------------------------------------------------------*/
+/* Registers of the peripherals, with their reset values */
+GPIO_TypeDef fake_stm32f4_gpioa = FAKE_STM32F4_GPIOA_RESET;
+GPIO_TypeDef fake_stm32f4_gpiob = FAKE_STM32F4_GPIOB_RESET;
+GPIO_TypeDef fake_stm32f4_gpioc = FAKE_STM32F4_GPIOC_RESET;
+TIM_TypeDef fake_stm32f4_tim2 = FAKE_STM32F4_TIM_32_RESET(_fake_stm32f4_tim2_ccr_access);
+TIM_TypeDef fake_stm32f4_tim3 = FAKE_STM32F4_TIM_16_RESET(_fake_stm32f4_tim3_ccr_access);
+TIM_TypeDef fake_stm32f4_tim5 = FAKE_STM32F4_TIM_32_RESET(_fake_stm32f4_tim5_ccr_access);
+EXTI_TypeDef fake_stm32f4_exti;
+SYSCFG_TypeDef fake_stm32f4_syscfg;
+RCC_TypeDef fake_stm32f4_rcc = FAKE_STM32F4_RCC_RESET;
+PWR_TypeDef fake_stm32f4_pwr;
+FLASH_TypeDef fake_stm32f4_flash;
+DMA_TypeDef fake_stm32f4_dma1;
+DMA_Stream_TypeDef fake_stm32f4_dma1_stream_arr[8];
+USART_TypeDef fake_stm32f4_usart2 = FAKE_STM32F4_USART_RESET;
+NVIC_Type fake_stm32f4_nvic;
+SCB_Type fake_stm32f4_scb = FAKE_STM32F4_SCB_RESET;
+SysTick_Type fake_stm32f4_systick;
+DWT_Type fake_stm32f4_dwt;
+ITM_Type fake_stm32f4_itm; /* Never enabled: the deferred logger drops its records, as without a debugger */
+CoreDebug_Type fake_stm32f4_core_debug;
+
+static const fake_stm32f4_capture_t captures_arr[] = {
+    {.p_port = GPIOA, .pin = 0, .af = 1, .timer = 0, .channel = 1},
+    {.p_port = GPIOA, .pin = 5, .af = 1, .timer = 0, .channel = 1},
+    {.p_port = GPIOA, .pin = 15, .af = 1, .timer = 0, .channel = 1},
+    {.p_port = GPIOA, .pin = 1, .af = 1, .timer = 0, .channel = 2},
+    {.p_port = GPIOB, .pin = 3, .af = 1, .timer = 0, .channel = 2},
+    {.p_port = GPIOA, .pin = 6, .af = 2, .timer = 1, .channel = 1},
+    {.p_port = GPIOB, .pin = 4, .af = 2, .timer = 1, .channel = 1},
+    {.p_port = GPIOC, .pin = 6, .af = 2, .timer = 1, .channel = 1},
+    {.p_port = GPIOA, .pin = 7, .af = 2, .timer = 1, .channel = 2},
+    {.p_port = GPIOB, .pin = 5, .af = 2, .timer = 1, .channel = 2},
+    {.p_port = GPIOC, .pin = 7, .af = 2, .timer = 1, .channel = 2},
+    {.p_port = GPIOA, .pin = 0, .af = 2, .timer = 2, .channel = 1},
+    {.p_port = GPIOA, .pin = 1, .af = 2, .timer = 2, .channel = 2},
+}; /*!< Pins of the channels 1 and 2 of TIM2 (AF1), TIM3 and TIM5 (AF2) in the STM32F446RE */
+
+static const IRQn_Type stream_irqs_arr[FAKE_STM32F4_NUM_STREAMS] = {(IRQn_Type)11, (IRQn_Type)12, (IRQn_Type)13, (IRQn_Type)14, (IRQn_Type)15, (IRQn_Type)16, DMA1_Stream6_IRQn, (IRQn_Type)47}; /*!< Interrupt of each stream of DMA1 */
+static const uint8_t stream_flags_pos_arr[4] = {0U, 6U, 16U, 22U};                                                                                                                /*!< Position of the flags of a stream in LISR or HISR */
+
+static fake_stm32f4_port_t ports_arr[FAKE_STM32F4_NUM_PORTS] = {{.p_port = GPIOA}, {.p_port = GPIOB}, {.p_port = GPIOC}}; /*!< Hidden state of the GPIO ports */
+static fake_stm32f4_timer_t timers_arr[FAKE_STM32F4_NUM_TIMERS] = {
+    {.p_tim = TIM2, .irqn = TIM2_IRQn, .counter_max = 0xFFFFFFFFU},
+    {.p_tim = TIM3, .irqn = TIM3_IRQn, .counter_max = 0xFFFFU},
+    {.p_tim = TIM5, .irqn = TIM5_IRQn, .counter_max = 0xFFFFFFFFU},
+}; /*!< Hidden state of the timers */
+static fake_stm32f4_stream_t streams_arr[FAKE_STM32F4_NUM_STREAMS]; /*!< Hidden state of the DMA streams */
+
+static uint64_t cycles = 0;                                /*!< Virtual clock in cycles of HCLK */
+static uint32_t exti_pr = 0;                               /*!< Value of `EXTI->PR` at the last synchronization point */
+static uint32_t usart_sr = USART_SR_TXE | USART_SR_TC;     /*!< Value of `USART2->SR` at the last synchronization point */
+static uint32_t basepri = 0;                               /*!< BASEPRI register */
+static bool primask = false;                               /*!< PRIMASK register */
+static uint32_t running_prio = FAKE_STM32F4_THREAD_PRIO;   /*!< Group priority of the active exception with the highest priority */
+static bool systick_pending = false;                       /*!< SysTick exception pending */
+static bool systick_active = false;                        /*!< SysTick handler running */
+static uint32_t systick_count = 0;                         /*!< Calls of the SysTick handler */
+static uint32_t irq_counts_arr[FAKE_STM32F4_NUM_IRQS];     /*!< Calls of the handler of each interrupt */
+static uint32_t served_count = 0;                          /*!< Calls of any handler, to wake up `__WFI()` */
+
+/* Private functions ----------------------------------------------------------*/
+static void _fake_stm32f4_serve(void);
+
+/**
+ * @brief Get the mask of the group (preemption) priority bits of a priority, from the priority grouping of AIRCR
+ * @return Mask over the 8 bits of a priority
+ */
+static inline uint32_t _fake_stm32f4_group_mask(void)
+{
+    return (0xFFU << (NVIC_GetPriorityGrouping() + 1U)) & 0xFFU;
+}
+
+/**
+ * @brief Set a device interrupt pending, unless its handler is running: the interrupts of the peripherals are level-sensitive
+ * @param irqn Interrupt number
+ */
+static void _fake_stm32f4_pend(IRQn_Type irqn)
+{
+    uint32_t word = (uint32_t)irqn >> 5U;
+    uint32_t bit = 1UL << ((uint32_t)irqn & 0x1FU);
+    if ((NVIC->IABR[word] & bit) == 0U)
+    {
+        NVIC->ISPR[word] |= bit;
+    }
+}
+
+/**
+ * @brief Get the EXTI lines served by an interrupt
+ * @param irqn Interrupt number
+ * @return Mask of EXTI lines
+ */
+static uint32_t _fake_stm32f4_exti_lines_of(IRQn_Type irqn)
+{
+    if ((irqn >= EXTI0_IRQn) && (irqn <= EXTI4_IRQn))
+    {
+        return 1UL << (irqn - EXTI0_IRQn);
+    }
+    if (irqn == EXTI9_5_IRQn)
+    {
+        return FAKE_STM32F4_EXTI_LINES_9_5;
+    }
+    if (irqn == EXTI15_10_IRQn)
+    {
+        return FAKE_STM32F4_EXTI_LINES_15_10;
+    }
+    return 0;
+}
+
+/**
+ * @brief Get the CCMRx field of a channel of a timer
+ * @param p_tim Registers of the timer
+ * @param channel Channel (from 1 to 4)
+ * @return 8 bits of the channel in CCMR1 or CCMR2
+ */
+static inline uint32_t _fake_stm32f4_timer_ccmr(TIM_TypeDef *p_tim, uint32_t channel)
+{
+    uint32_t ccmr = (channel <= 2U) ? p_tim->CCMR1 : p_tim->CCMR2;
+    return (ccmr >> (((channel - 1U) & 1U) * 8U)) & 0xFFU;
+}
+
+/**
+ * @brief Get the capture/compare register of a channel of a timer
+ * @param p_tim Registers of the timer
+ * @param channel Channel (from 1 to 4)
+ * @return Pointer to CCRx
+ */
+static inline volatile uint32_t *_fake_stm32f4_timer_ccr(TIM_TypeDef *p_tim, uint32_t channel)
+{
+    return &p_tim->ccr_arr[channel - 1U];
+}
+
+/**
+ * @brief Access of the software to a capture/compare register of a timer. In input capture the register is read-only, and reading it clears the flag of the channel
+ * @param p_timer Hidden state of the timer
+ * @param channel Channel (from 1 to 4)
+ * @return Pointer to CCRx
+ */
+static volatile uint32_t *_fake_stm32f4_timer_ccr_access(fake_stm32f4_timer_t *p_timer, uint32_t channel)
+{
+    TIM_TypeDef *p_tim = p_timer->p_tim;
+    if ((_fake_stm32f4_timer_ccmr(p_tim, channel) & TIM_CCMR1_CC1S) != 0U)
+    {
+        uint32_t flag = TIM_SR_CC1IF << (channel - 1U);
+        p_timer->sr &= ~flag;
+        p_tim->SR &= ~flag; /* The other bits keep the value written by the software until the next synchronization point */
+    }
+    return _fake_stm32f4_timer_ccr(p_tim, channel);
+}
+
+/**
+ * @brief Access of the software to CCRx of TIM2
+ * @param channel Channel (from 1 to 4)
+ * @return Pointer to CCRx
+ */
+static volatile uint32_t *_fake_stm32f4_tim2_ccr_access(uint32_t channel)
+{
+    return _fake_stm32f4_timer_ccr_access(&timers_arr[0], channel);
+}
+
+/**
+ * @brief Access of the software to CCRx of TIM3
+ * @param channel Channel (from 1 to 4)
+ * @return Pointer to CCRx
+ */
+static volatile uint32_t *_fake_stm32f4_tim3_ccr_access(uint32_t channel)
+{
+    return _fake_stm32f4_timer_ccr_access(&timers_arr[1], channel);
+}
+
+/**
+ * @brief Access of the software to CCRx of TIM5
+ * @param channel Channel (from 1 to 4)
+ * @return Pointer to CCRx
+ */
+static volatile uint32_t *_fake_stm32f4_tim5_ccr_access(uint32_t channel)
+{
+    return _fake_stm32f4_timer_ccr_access(&timers_arr[2], channel);
+}
+
+/**
+ * @brief Get the ticks of the counter until it reaches a value
+ * @param p_timer Hidden state of the timer
+ * @param cnt Current value of the counter
+ * @param value Value to reach
+ * @return Ticks, from 1 to a full period, or `FAKE_STM32F4_NO_EVENT` if the counter never reaches the value
+ */
+static uint64_t _fake_stm32f4_timer_ticks_to(const fake_stm32f4_timer_t *p_timer, uint32_t cnt, uint32_t value)
+{
+    uint32_t arr = p_timer->p_tim->ARR & p_timer->counter_max;
+    uint64_t to_wrap = (cnt <= arr) ? ((uint64_t)arr - cnt + 1U) : ((uint64_t)p_timer->counter_max - cnt + 1U); /* Ticks until the counter restarts at 0 */
+
+    if ((value > cnt) && ((value <= arr) || (cnt > arr)))
+    {
+        return value - cnt;
+    }
+    if (value <= arr)
+    {
+        return to_wrap + value;
+    }
+    return FAKE_STM32F4_NO_EVENT;
+}
+
+/**
+ * @brief Capture/compare event of a channel of a timer: a channel configured as input captures the counter in CCRx. The flag of the channel is set in both modes
+ * @param p_timer Hidden state of the timer
+ * @param channel Channel (from 1 to 4)
+ */
+static void _fake_stm32f4_timer_cc_event(fake_stm32f4_timer_t *p_timer, uint32_t channel)
+{
+    TIM_TypeDef *p_tim = p_timer->p_tim;
+    uint32_t flag = TIM_SR_CC1IF << (channel - 1U);
+    if ((_fake_stm32f4_timer_ccmr(p_tim, channel) & TIM_CCMR1_CC1S) != 0U)
+    {
+        if ((p_timer->sr & flag) != 0U)
+        {
+            p_timer->sr |= TIM_SR_CC1OF << (channel - 1U); /* The previous capture has not been read */
+        }
+        *_fake_stm32f4_timer_ccr(p_tim, channel) = p_tim->CNT & p_timer->counter_max;
+    }
+    p_timer->sr |= flag;
+    p_tim->SR = p_timer->sr;
+}
+
+/**
+ * @brief Capture the counter of a timer in a channel configured as input, on an edge of its pin
+ * @param p_timer Hidden state of the timer
+ * @param channel Channel (1 or 2)
+ * @param rising The edge is rising
+ */
+static void _fake_stm32f4_timer_capture(fake_stm32f4_timer_t *p_timer, uint32_t channel, bool rising)
+{
+    TIM_TypeDef *p_tim = p_timer->p_tim;
+    uint32_t ccer = (p_tim->CCER >> ((channel - 1U) * 4U)) & (TIM_CCER_CC1E | TIM_CCER_CC1P | TIM_CCER_CC1NP);
+    if (((_fake_stm32f4_timer_ccmr(p_tim, channel) & TIM_CCMR1_CC1S) != FAKE_STM32F4_TIM_CCS_INPUT) || ((ccer & TIM_CCER_CC1E) == 0U))
+    {
+        return;
+    }
+    uint32_t polarity = ccer & (TIM_CCER_CC1P | TIM_CCER_CC1NP);
+    bool captured = ((polarity == 0U) && rising) || ((polarity == TIM_CCER_CC1P) && !rising) || (polarity == (TIM_CCER_CC1P | TIM_CCER_CC1NP));
+    if (captured)
+    {
+        _fake_stm32f4_timer_cc_event(p_timer, channel);
+    }
+}
+
+/**
+ * @brief Get the cycles until the next event of a timer: update or compare match of a channel in output mode
+ * @param p_timer Hidden state of the timer
+ * @return Cycles, or `FAKE_STM32F4_NO_EVENT`
+ */
+static uint64_t _fake_stm32f4_timer_next_event(const fake_stm32f4_timer_t *p_timer)
+{
+    TIM_TypeDef *p_tim = p_timer->p_tim;
+    if ((p_tim->CR1 & TIM_CR1_CEN) == 0U)
+    {
+        return FAKE_STM32F4_NO_EVENT;
+    }
+    uint32_t cnt = p_tim->CNT & p_timer->counter_max;
+    uint64_t ticks = _fake_stm32f4_timer_ticks_to(p_timer, cnt, 0U);
+    for (uint32_t channel = 1; channel <= FAKE_STM32F4_NUM_CHANNELS; channel++)
+    {
+        if ((_fake_stm32f4_timer_ccmr(p_tim, channel) & TIM_CCMR1_CC1S) == 0U) /* Output compare */
+        {
+            uint64_t to_match = _fake_stm32f4_timer_ticks_to(p_timer, cnt, *_fake_stm32f4_timer_ccr(p_tim, channel));
+            ticks = (to_match < ticks) ? to_match : ticks;
+        }
+    }
+    uint64_t div = (uint64_t)p_timer->psc_active + 1U;
+    return (div - p_timer->psc_count) + ((ticks - 1U) * div);
+}
+
+/**
+ * @brief Advance the prescaler and the counter of a timer, and set its flags
+ * @param p_timer Hidden state of the timer
+ * @param n Cycles
+ */
+static void _fake_stm32f4_timer_advance(fake_stm32f4_timer_t *p_timer, uint64_t n)
+{
+    TIM_TypeDef *p_tim = p_timer->p_tim;
+    if ((p_tim->CR1 & TIM_CR1_CEN) == 0U)
+    {
+        return;
+    }
+    uint64_t div = (uint64_t)p_timer->psc_active + 1U;
+    uint64_t total = p_timer->psc_count + n;
+    uint64_t ticks = total / div;
+    p_timer->psc_count = (uint32_t)(total % div);
+    if (ticks == 0U)
+    {
+        return;
+    }
+
+    uint32_t cnt = p_tim->CNT & p_timer->counter_max;
+    for (uint32_t channel = 1; channel <= FAKE_STM32F4_NUM_CHANNELS; channel++)
+    {
+        if (((_fake_stm32f4_timer_ccmr(p_tim, channel) & TIM_CCMR1_CC1S) == 0U) && (_fake_stm32f4_timer_ticks_to(p_timer, cnt, *_fake_stm32f4_timer_ccr(p_tim, channel)) <= ticks))
+        {
+            p_timer->sr |= TIM_SR_CC1IF << (channel - 1U);
+        }
+    }
+    uint64_t to_update = _fake_stm32f4_timer_ticks_to(p_timer, cnt, 0U);
+    if (ticks >= to_update)
+    {
+        uint64_t period = (uint64_t)(p_tim->ARR & p_timer->counter_max) + 1U;
+        cnt = (uint32_t)((ticks - to_update) % period);
+        p_timer->sr |= TIM_SR_UIF;
+        p_timer->psc_active = p_tim->PSC; /* Update event: the preloaded prescaler is loaded */
+    }
+    else
+    {
+        cnt += (uint32_t)ticks;
+    }
+    p_tim->CNT = cnt;
+    p_tim->SR = p_timer->sr;
+}
+
+/**
+ * @brief Advance SysTick, and pend its exception when it counts from 1 to 0
+ * @param n Cycles
+ */
+static void _fake_stm32f4_systick_advance(uint64_t n)
+{
+    if ((SysTick->CTRL & SysTick_CTRL_ENABLE_Msk) == 0U)
+    {
+        return;
+    }
+    uint32_t load = SysTick->LOAD & SysTick_LOAD_RELOAD_Msk;
+    uint32_t val = SysTick->VAL & SysTick_LOAD_RELOAD_Msk;
+    while (n > 0U)
+    {
+        if (val == 0U)
+        {
+            if (load == 0U)
+            {
+                break; /* Stopped until LOAD is written */
+            }
+            val = load; /* Reload at the cycle after reaching 0 */
+            n--;
+            continue;
+        }
+        uint32_t step = (n < val) ? (uint32_t)n : val;
+        val -= step;
+        n -= step;
+        if (val == 0U)
+        {
+            SysTick->CTRL |= SysTick_CTRL_COUNTFLAG_Msk;
+            if ((SysTick->CTRL & SysTick_CTRL_TICKINT_Msk) != 0U)
+            {
+                systick_pending = true;
+            }
+        }
+    }
+    SysTick->VAL = val;
+}
+
+/**
+ * @brief Get the cycles until the next event of SysTick
+ * @return Cycles, or `FAKE_STM32F4_NO_EVENT`
+ */
+static uint64_t _fake_stm32f4_systick_next_event(void)
+{
+    uint32_t load = SysTick->LOAD & SysTick_LOAD_RELOAD_Msk;
+    uint32_t val = SysTick->VAL & SysTick_LOAD_RELOAD_Msk;
+    if (((SysTick->CTRL & SysTick_CTRL_ENABLE_Msk) == 0U) || ((load == 0U) && (val == 0U)))
+    {
+        return FAKE_STM32F4_NO_EVENT;
+    }
+    return (val == 0U) ? ((uint64_t)load + 1U) : val;
+}
+
+/**
+ * @brief Get the pointer to the interrupt status register of a DMA stream and the position of its flags
+ * @param stream Stream of DMA1
+ * @param p_pos Pointer to store the position of the flags
+ * @return Pointer to LISR or HISR
+ */
+static volatile uint32_t *_fake_stm32f4_dma_isr(uint32_t stream, uint32_t *p_pos)
+{
+    *p_pos = stream_flags_pos_arr[stream & 3U];
+    return (stream < 4U) ? &DMA1->LISR : &DMA1->HISR;
+}
+
+/**
+ * @brief Complete the transfers of the DMA streams that have reached their end
+ */
+static void _fake_stm32f4_dma_advance(void)
+{
+    for (uint32_t stream = 0; stream < FAKE_STM32F4_NUM_STREAMS; stream++)
+    {
+        if (streams_arr[stream].busy && (cycles >= streams_arr[stream].end_cycle))
+        {
+            DMA_Stream_TypeDef *p_stream = &fake_stm32f4_dma1_stream_arr[stream];
+            uint32_t pos;
+            volatile uint32_t *p_isr = _fake_stm32f4_dma_isr(stream, &pos);
+            streams_arr[stream].busy = false;
+            p_stream->NDTR = 0;
+            p_stream->CR &= ~DMA_SxCR_EN;
+            *p_isr |= FAKE_STM32F4_DMA_FLAGS_TCIF << pos;
+            if (p_stream->PAR == (uint32_t)(uintptr_t)&USART2->DR)
+            {
+                usart_sr |= USART_SR_TC; /* The last frame has left the shift register */
+                USART2->SR = usart_sr;
+            }
+        }
+    }
+}
+
+/**
+ * @brief Get the cycles until the next end of a DMA transfer
+ * @return Cycles, or `FAKE_STM32F4_NO_EVENT`
+ */
+static uint64_t _fake_stm32f4_dma_next_event(void)
+{
+    uint64_t next = FAKE_STM32F4_NO_EVENT;
+    for (uint32_t stream = 0; stream < FAKE_STM32F4_NUM_STREAMS; stream++)
+    {
+        if (streams_arr[stream].busy)
+        {
+            uint64_t to_end = (streams_arr[stream].end_cycle > cycles) ? (streams_arr[stream].end_cycle - cycles) : 1U;
+            next = (to_end < next) ? to_end : next;
+        }
+    }
+    return next;
+}
+
+/**
+ * @brief Start the transfers of the DMA streams enabled since the last synchronization point. A transfer to USART2 lasts the frames of its bytes; any other one, a cycle per item
+ */
+static void _fake_stm32f4_dma_start(void)
+{
+    for (uint32_t stream = 0; stream < FAKE_STM32F4_NUM_STREAMS; stream++)
+    {
+        DMA_Stream_TypeDef *p_stream = &fake_stm32f4_dma1_stream_arr[stream];
+        bool enabled = (p_stream->CR & DMA_SxCR_EN) != 0U;
+        if (enabled && !streams_arr[stream].busy)
+        {
+            uint64_t duration = p_stream->NDTR;
+            if ((p_stream->PAR == (uint32_t)(uintptr_t)&USART2->DR) && ((USART2->CR1 & (USART_CR1_UE | USART_CR1_TE)) == (USART_CR1_UE | USART_CR1_TE)) && ((USART2->CR3 & USART_CR3_DMAT) != 0U))
+            {
+                duration *= (uint64_t)FAKE_STM32F4_USART_FRAME_BITS * USART2->BRR; /* BRR is the number of cycles of a bit with oversampling by 16 */
+            }
+            streams_arr[stream].busy = true;
+            streams_arr[stream].end_cycle = cycles + ((duration > 0U) ? duration : 1U);
+        }
+        else if (!enabled)
+        {
+            streams_arr[stream].busy = false; /* Disabled by the software: the transfer is aborted */
+        }
+    }
+}
+
+/**
+ * @brief Get the pins whose 2-bit field of a GPIO register (MODER, PUPDR) has a value
+ * @param reg Value of the register
+ * @param value Value of the field: 0x1 or 0x2
+ * @return Mask of pins
+ */
+static inline uint32_t _fake_stm32f4_gpio_pins_in(uint32_t reg, uint32_t value)
+{
+    uint32_t x = ((value == 0x1U) ? (reg & ~(reg >> 1U)) : ((reg >> 1U) & ~reg)) & 0x55555555U; /* Bit 2n set if the field of pin n matches */
+    x = (x | (x >> 1U)) & 0x33333333U;                                                          /* Compress the even bits into 16 bits */
+    x = (x | (x >> 2U)) & 0x0F0F0F0FU;
+    x = (x | (x >> 4U)) & 0x00FF00FFU;
+    return (x | (x >> 8U)) & 0x0000FFFFU;
+}
+
+/**
+ * @brief Compute the input data register of a port and process the edges of its pins: EXTI lines and input captures
+ * @param p_port_state Hidden state of the port
+ * @param port_index Index of the port in SYSCFG_EXTICR (0 for GPIOA)
+ */
+static void _fake_stm32f4_gpio_update(fake_stm32f4_port_t *p_port_state, uint32_t port_index)
+{
+    GPIO_TypeDef *p_port = p_port_state->p_port;
+    uint32_t bsrr = p_port->BSRR;
+    if (bsrr != 0U)
+    {
+        p_port->ODR = ((p_port->ODR & ~(bsrr >> 16U)) | bsrr) & 0xFFFFU; /* Set has priority over reset */
+        p_port->BSRR = 0;
+    }
+
+    uint32_t moder = p_port->MODER;
+    uint32_t pupdr = p_port->PUPDR;
+    uint32_t outputs = _fake_stm32f4_gpio_pins_in(moder, 0x1U);
+    uint32_t pull_ups = _fake_stm32f4_gpio_pins_in(pupdr, 0x1U);
+    uint32_t inputs = (p_port_state->levels & p_port_state->driven) | (pull_ups & ~p_port_state->driven);
+    uint32_t idr = ((p_port->ODR & outputs) | (inputs & ~outputs)) & 0xFFFFU;
+    p_port->IDR = idr;
+
+    uint32_t changed = idr ^ p_port_state->idr;
+    p_port_state->idr = idr;
+    if (changed == 0U)
+    {
+        return;
+    }
+    for (uint32_t line = 0; line < 16U; line++)
+    {
+        uint32_t bit = 1UL << line;
+        if (((changed & bit) != 0U) && (((SYSCFG->EXTICR[line / 4U] >> ((line % 4U) * 4U)) & 0xFU) == port_index))
+        {
+            if ((((idr & bit) != 0U) && ((EXTI->RTSR & bit) != 0U)) || (((idr & bit) == 0U) && ((EXTI->FTSR & bit) != 0U)))
+            {
+                exti_pr |= bit;
+            }
+        }
+    }
+    EXTI->PR = exti_pr;
+    uint32_t alternates = _fake_stm32f4_gpio_pins_in(moder, 0x2U);
+    for (uint32_t i = 0; i < sizeof(captures_arr) / sizeof(captures_arr[0]); i++)
+    {
+        const fake_stm32f4_capture_t *p_capture = &captures_arr[i];
+        uint32_t pin = p_capture->pin;
+        if ((p_capture->p_port == p_port) && ((changed & alternates & (1UL << pin)) != 0U) && (((p_port->AFR[pin / 8U] >> ((pin % 8U) * 4U)) & 0xFU) == p_capture->af))
+        {
+            _fake_stm32f4_timer_capture(&timers_arr[p_capture->timer], p_capture->channel, (idr & (1UL << pin)) != 0U);
+        }
+    }
+}
+
+/**
+ * @brief Apply the register writes of the software since the last synchronization point
+ */
+static void _fake_stm32f4_apply_writes(void)
+{
+    /* EXTI_PR is rc_w1: the bits written to 1 are cleared */
+    uint32_t pr = EXTI->PR;
+    if (pr != exti_pr)
+    {
+        exti_pr &= ~pr;
+    }
+    EXTI->PR = exti_pr;
+
+    /* TIMx_SR is rc_w0, and EGR is write-only */
+    for (uint32_t i = 0; i < FAKE_STM32F4_NUM_TIMERS; i++)
+    {
+        fake_stm32f4_timer_t *p_timer = &timers_arr[i];
+        TIM_TypeDef *p_tim = p_timer->p_tim;
+        p_timer->sr &= p_tim->SR;
+        if ((p_tim->EGR & TIM_EGR_UG) != 0U)
+        {
+            p_tim->CNT = 0;
+            p_timer->psc_count = 0;
+            p_timer->psc_active = p_tim->PSC;
+        }
+        for (uint32_t channel = 1; channel <= FAKE_STM32F4_NUM_CHANNELS; channel++)
+        {
+            if ((p_tim->EGR & (TIM_EGR_CC1G << (channel - 1U))) != 0U)
+            {
+                _fake_stm32f4_timer_cc_event(p_timer, channel); /* Capture/compare generated by software */
+            }
+        }
+        p_tim->EGR = 0;
+        p_tim->SR = p_timer->sr;
+    }
+
+    /* USART_SR is rc_w0. The model has no receiver and the data register is always ready */
+    usart_sr = (usart_sr & USART2->SR) | USART_SR_TXE;
+    USART2->SR = usart_sr;
+
+    /* DMA_xIFCR are write-only */
+    DMA1->LISR &= ~DMA1->LIFCR;
+    DMA1->HISR &= ~DMA1->HIFCR;
+    DMA1->LIFCR = 0;
+    DMA1->HIFCR = 0;
+
+    for (uint32_t i = 0; i < FAKE_STM32F4_NUM_PORTS; i++)
+    {
+        _fake_stm32f4_gpio_update(&ports_arr[i], i);
+    }
+    _fake_stm32f4_dma_start();
+}
+
+/**
+ * @brief Pend the device interrupts whose peripheral requests them
+ */
+static void _fake_stm32f4_update_irqs(void)
+{
+    for (uint32_t i = 0; i < FAKE_STM32F4_NUM_TIMERS; i++)
+    {
+        if ((timers_arr[i].sr & timers_arr[i].p_tim->DIER & FAKE_STM32F4_TIM_IRQ_FLAGS) != 0U)
+        {
+            _fake_stm32f4_pend(timers_arr[i].irqn);
+        }
+    }
+
+    uint32_t exti = exti_pr & EXTI->IMR;
+    for (uint32_t line = 0; line < 5U; line++)
+    {
+        if ((exti & (1UL << line)) != 0U)
+        {
+            _fake_stm32f4_pend((IRQn_Type)(EXTI0_IRQn + line));
+        }
+    }
+    if ((exti & FAKE_STM32F4_EXTI_LINES_9_5) != 0U)
+    {
+        _fake_stm32f4_pend(EXTI9_5_IRQn);
+    }
+    if ((exti & FAKE_STM32F4_EXTI_LINES_15_10) != 0U)
+    {
+        _fake_stm32f4_pend(EXTI15_10_IRQn);
+    }
+
+    for (uint32_t stream = 0; stream < FAKE_STM32F4_NUM_STREAMS; stream++)
+    {
+        uint32_t pos;
+        uint32_t flags = (*_fake_stm32f4_dma_isr(stream, &pos) >> pos) & FAKE_STM32F4_DMA_FLAGS_ALL;
+        uint32_t cr = fake_stm32f4_dma1_stream_arr[stream].CR;
+        if ((((flags & FAKE_STM32F4_DMA_FLAGS_TCIF) != 0U) && ((cr & DMA_SxCR_TCIE) != 0U)) ||
+            (((flags & FAKE_STM32F4_DMA_FLAGS_HTIF) != 0U) && ((cr & FAKE_STM32F4_DMA_SxCR_HTIE) != 0U)) ||
+            (((flags & FAKE_STM32F4_DMA_FLAGS_TEIF) != 0U) && ((cr & DMA_SxCR_TEIE) != 0U)))
+        {
+            _fake_stm32f4_pend(stream_irqs_arr[stream]);
+        }
+    }
+}
+
+/**
+ * @brief Advance the peripherals, without serving the interrupts. The writes of the software must have been applied
+ * @param n Cycles
+ */
+static void _fake_stm32f4_tick(uint64_t n)
+{
+    cycles += n;
+    if (((CoreDebug->DEMCR & CoreDebug_DEMCR_TRCENA_Msk) != 0U) && ((DWT->CTRL & DWT_CTRL_CYCCNTENA_Msk) != 0U))
+    {
+        DWT->CYCCNT += (uint32_t)n;
+    }
+    _fake_stm32f4_systick_advance(n);
+    for (uint32_t i = 0; i < FAKE_STM32F4_NUM_TIMERS; i++)
+    {
+        _fake_stm32f4_timer_advance(&timers_arr[i], n);
+    }
+    _fake_stm32f4_dma_advance();
+}
+
+/**
+ * @brief Get the cycles until the next event of any peripheral
+ * @return Cycles (at least 1), or `FAKE_STM32F4_NO_EVENT`
+ */
+static uint64_t _fake_stm32f4_next_event(void)
+{
+    uint64_t next = _fake_stm32f4_systick_next_event();
+    for (uint32_t i = 0; i < FAKE_STM32F4_NUM_TIMERS; i++)
+    {
+        uint64_t to_event = _fake_stm32f4_timer_next_event(&timers_arr[i]);
+        next = (to_event < next) ? to_event : next;
+    }
+    uint64_t to_dma = _fake_stm32f4_dma_next_event();
+    return (to_dma < next) ? to_dma : next;
+}
+
+/**
+ * @brief Call the handler of an exception, as the exception entry and return of the Cortex-M4
+ * @param irqn Interrupt number, or `SysTick_IRQn`
+ * @param group_prio Group priority of the exception
+ */
+static void _fake_stm32f4_call(IRQn_Type irqn, uint32_t group_prio)
+{
+    uint32_t previous_prio = running_prio;
+    void (*handler)(void) = SysTick_Handler;
+    uint32_t exti_lines = 0;
+    uint32_t word = 0;
+    uint32_t bit = 0;
+
+    if (irqn == SysTick_IRQn)
+    {
+        systick_pending = false;
+        systick_active = true;
+        systick_count++;
+    }
+    else
+    {
+        word = (uint32_t)irqn >> 5U;
+        bit = 1UL << ((uint32_t)irqn & 0x1FU);
+        NVIC->ISPR[word] &= ~bit;
+        NVIC->IABR[word] |= bit;
+        irq_counts_arr[irqn]++;
+        handler = (vectors_arr[irqn] != NULL) ? vectors_arr[irqn] : _fake_stm32f4_default_handler;
+        exti_lines = exti_pr & _fake_stm32f4_exti_lines_of(irqn);
+    }
+    served_count++;
+    running_prio = group_prio;
+    _fake_stm32f4_tick(FAKE_STM32F4_ENTRY_CYCLES);
+
+    handler();
+
+    /* Exception return */
+    _fake_stm32f4_apply_writes();
+    exti_pr &= ~exti_lines; /* The handler has cleared the lines pending at its entry */
+    EXTI->PR = exti_pr;
+    running_prio = previous_prio;
+    if (irqn == SysTick_IRQn)
+    {
+        systick_active = false;
+    }
+    else
+    {
+        NVIC->IABR[word] &= ~bit;
+    }
+    _fake_stm32f4_update_irqs();
+}
+
+/**
+ * @brief Get the pending exception with the highest priority, if it can preempt the running priority and BASEPRI. PRIMASK is not considered
+ * @param p_irqn Pointer to store the interrupt number, or `SysTick_IRQn`
+ * @param p_group_prio Pointer to store the group priority of the exception
+ * @return true if there is such an exception
+ */
+static bool _fake_stm32f4_preempting(IRQn_Type *p_irqn, uint32_t *p_group_prio)
+{
+    uint32_t group_mask = _fake_stm32f4_group_mask();
+    uint32_t threshold = running_prio;
+    if ((basepri != 0U) && ((basepri & group_mask) < threshold))
+    {
+        threshold = basepri & group_mask;
+    }
+
+    bool found = false;
+    IRQn_Type best = SysTick_IRQn;
+    uint32_t best_prio = FAKE_STM32F4_THREAD_PRIO;
+    if (systick_pending && !systick_active)
+    {
+        found = true;
+        best_prio = SCB->SHP[FAKE_STM32F4_SYSTICK_SHP];
+    }
+    for (uint32_t word = 0; word < FAKE_STM32F4_IRQ_WORDS; word++)
+    {
+        uint32_t ready = NVIC->ISPR[word] & NVIC->ISER[word] & ~NVIC->IABR[word];
+        while (ready != 0U)
+        {
+            uint32_t irq = (word * 32U) + (uint32_t)__builtin_ctz(ready);
+            ready &= ready - 1U;
+            if (NVIC->IP[irq] < best_prio) /* Ties are won by the lowest exception number */
+            {
+                found = true;
+                best = (IRQn_Type)irq;
+                best_prio = NVIC->IP[irq];
+            }
+        }
+    }
+    if (!found || ((best_prio & group_mask) >= threshold))
+    {
+        return false;
+    }
+    *p_irqn = best;
+    *p_group_prio = best_prio & group_mask;
+    return true;
+}
+
+/**
+ * @brief Serve the pending exceptions that can preempt the running priority, from the highest priority
+ */
+static void _fake_stm32f4_serve(void)
+{
+    IRQn_Type irqn;
+    uint32_t group_prio;
+    while (!primask && _fake_stm32f4_preempting(&irqn, &group_prio))
+    {
+        _fake_stm32f4_call(irqn, group_prio);
+    }
+}
+
+/* Public functions -----------------------------------------------------------*/
+void fake_stm32f4_reset(void)
+{
+    static const GPIO_TypeDef gpio_reset_arr[FAKE_STM32F4_NUM_PORTS] = {FAKE_STM32F4_GPIOA_RESET, FAKE_STM32F4_GPIOB_RESET, FAKE_STM32F4_GPIOC_RESET};
+    static const TIM_TypeDef tim_reset_arr[FAKE_STM32F4_NUM_TIMERS] = {FAKE_STM32F4_TIM_32_RESET(_fake_stm32f4_tim2_ccr_access), FAKE_STM32F4_TIM_16_RESET(_fake_stm32f4_tim3_ccr_access), FAKE_STM32F4_TIM_32_RESET(_fake_stm32f4_tim5_ccr_access)};
+    static const RCC_TypeDef rcc_reset = FAKE_STM32F4_RCC_RESET;
+    static const USART_TypeDef usart_reset = FAKE_STM32F4_USART_RESET;
+    static const SCB_Type scb_reset = FAKE_STM32F4_SCB_RESET;
+
+    for (uint32_t i = 0; i < FAKE_STM32F4_NUM_PORTS; i++)
+    {
+        memcpy((void *)ports_arr[i].p_port, &gpio_reset_arr[i], sizeof(GPIO_TypeDef));
+        ports_arr[i].driven = 0;
+        ports_arr[i].levels = 0;
+        ports_arr[i].idr = 0;
+    }
+    for (uint32_t i = 0; i < FAKE_STM32F4_NUM_TIMERS; i++)
+    {
+        memcpy((void *)timers_arr[i].p_tim, &tim_reset_arr[i], sizeof(TIM_TypeDef));
+        timers_arr[i].psc_count = 0;
+        timers_arr[i].psc_active = 0;
+        timers_arr[i].sr = 0;
+    }
+    memcpy((void *)RCC, &rcc_reset, sizeof(RCC_TypeDef));
+    memcpy((void *)USART2, &usart_reset, sizeof(USART_TypeDef));
+    memcpy((void *)SCB, &scb_reset, sizeof(SCB_Type));
+    memset((void *)EXTI, 0, sizeof(EXTI_TypeDef));
+    memset((void *)SYSCFG, 0, sizeof(SYSCFG_TypeDef));
+    memset((void *)PWR, 0, sizeof(PWR_TypeDef));
+    memset((void *)FLASH, 0, sizeof(FLASH_TypeDef));
+    memset((void *)DMA1, 0, sizeof(DMA_TypeDef));
+    memset((void *)fake_stm32f4_dma1_stream_arr, 0, sizeof(fake_stm32f4_dma1_stream_arr));
+    memset((void *)NVIC, 0, sizeof(NVIC_Type));
+    memset((void *)SysTick, 0, sizeof(SysTick_Type));
+    memset((void *)DWT, 0, sizeof(DWT_Type));
+    memset((void *)ITM, 0, sizeof(ITM_Type));
+    memset((void *)CoreDebug, 0, sizeof(CoreDebug_Type));
+    memset(streams_arr, 0, sizeof(streams_arr));
+    memset(irq_counts_arr, 0, sizeof(irq_counts_arr));
+
+    exti_pr = 0;
+    usart_sr = usart_reset.SR;
+    basepri = 0;
+    primask = false;
+    running_prio = FAKE_STM32F4_THREAD_PRIO;
+    systick_pending = false;
+    systick_active = false;
+    systick_count = 0;
+}
+
+void fake_stm32f4_sync(void)
+{
+    _fake_stm32f4_apply_writes();
+    _fake_stm32f4_update_irqs();
+    _fake_stm32f4_serve();
+}
+
+void fake_stm32f4_advance_cycles(uint64_t n)
+{
+    fake_stm32f4_sync();
+    while (n > 0U)
+    {
+        uint64_t step = _fake_stm32f4_next_event();
+        step = (step < n) ? step : n;
+        _fake_stm32f4_tick(step);
+        n -= step;
+        _fake_stm32f4_update_irqs();
+        _fake_stm32f4_serve(); /* The handlers apply their writes when they return */
+    }
+}
+
+void fake_stm32f4_advance_us(uint32_t us)
+{
+    fake_stm32f4_advance_cycles((uint64_t)us * (FAKE_STM32F4_HCLK_HZ / 1000000U));
+}
+
+uint64_t fake_stm32f4_get_cycles(void)
+{
+    return cycles;
+}
+
+void fake_stm32f4_gpio_set_input(GPIO_TypeDef *p_port, uint8_t pin, bool level)
+{
+    for (uint32_t i = 0; i < FAKE_STM32F4_NUM_PORTS; i++)
+    {
+        if (ports_arr[i].p_port == p_port)
+        {
+            ports_arr[i].driven |= 1UL << pin;
+            ports_arr[i].levels = level ? (ports_arr[i].levels | (1UL << pin)) : (ports_arr[i].levels & ~(1UL << pin));
+        }
+    }
+    fake_stm32f4_sync();
+}
+
+void fake_stm32f4_gpio_release_input(GPIO_TypeDef *p_port, uint8_t pin)
+{
+    for (uint32_t i = 0; i < FAKE_STM32F4_NUM_PORTS; i++)
+    {
+        if (ports_arr[i].p_port == p_port)
+        {
+            ports_arr[i].driven &= ~(1UL << pin);
+        }
+    }
+    fake_stm32f4_sync();
+}
+
+uint32_t fake_stm32f4_get_irq_count(IRQn_Type irqn)
+{
+    if (irqn == SysTick_IRQn)
+    {
+        return systick_count;
+    }
+    return ((irqn >= 0) && (irqn < FAKE_STM32F4_NUM_IRQS)) ? irq_counts_arr[irqn] : 0U;
+}
+
+/* Core functions of stm32f4xx.h ------------------------------------------------*/
+void NVIC_SetPriorityGrouping(uint32_t priority_group)
+{
+    SCB->AIRCR = (0xFA05UL << 16U) | ((priority_group & 0x7UL) << SCB_AIRCR_PRIGROUP_Pos);
+    fake_stm32f4_sync();
+}
+
+uint32_t NVIC_GetPriorityGrouping(void)
+{
+    return (SCB->AIRCR & SCB_AIRCR_PRIGROUP_Msk) >> SCB_AIRCR_PRIGROUP_Pos;
+}
+
+void NVIC_EnableIRQ(IRQn_Type irqn)
+{
+    if (irqn >= 0)
+    {
+        NVIC->ISER[(uint32_t)irqn >> 5U] |= 1UL << ((uint32_t)irqn & 0x1FU);
+    }
+    fake_stm32f4_sync();
+}
+
+void NVIC_DisableIRQ(IRQn_Type irqn)
+{
+    if (irqn >= 0)
+    {
+        NVIC->ISER[(uint32_t)irqn >> 5U] &= ~(1UL << ((uint32_t)irqn & 0x1FU));
+    }
+    fake_stm32f4_sync();
+}
+
+uint32_t NVIC_GetEnableIRQ(IRQn_Type irqn)
+{
+    return (irqn >= 0) ? ((NVIC->ISER[(uint32_t)irqn >> 5U] >> ((uint32_t)irqn & 0x1FU)) & 1UL) : 0U;
+}
+
+void NVIC_SetPendingIRQ(IRQn_Type irqn)
+{
+    if (irqn >= 0)
+    {
+        NVIC->ISPR[(uint32_t)irqn >> 5U] |= 1UL << ((uint32_t)irqn & 0x1FU);
+    }
+    fake_stm32f4_sync();
+}
+
+void NVIC_ClearPendingIRQ(IRQn_Type irqn)
+{
+    if (irqn >= 0)
+    {
+        NVIC->ISPR[(uint32_t)irqn >> 5U] &= ~(1UL << ((uint32_t)irqn & 0x1FU));
+    }
+    fake_stm32f4_sync(); /* A level still asserted pends the interrupt again */
+}
+
+uint32_t NVIC_GetPendingIRQ(IRQn_Type irqn)
+{
+    return (irqn >= 0) ? ((NVIC->ISPR[(uint32_t)irqn >> 5U] >> ((uint32_t)irqn & 0x1FU)) & 1UL) : 0U;
+}
+
+void NVIC_SetPriority(IRQn_Type irqn, uint32_t priority)
+{
+    uint8_t value = (uint8_t)((priority << (8U - __NVIC_PRIO_BITS)) & 0xFFUL);
+    if (irqn >= 0)
+    {
+        NVIC->IP[irqn] = value;
+    }
+    else
+    {
+        SCB->SHP[((uint32_t)irqn & 0xFUL) - 4U] = value;
+    }
+    fake_stm32f4_sync();
+}
+
+uint32_t NVIC_GetPriority(IRQn_Type irqn)
+{
+    uint8_t value = (irqn >= 0) ? NVIC->IP[irqn] : SCB->SHP[((uint32_t)irqn & 0xFUL) - 4U];
+    return (uint32_t)value >> (8U - __NVIC_PRIO_BITS);
+}
+
+uint32_t SysTick_Config(uint32_t ticks)
+{
+    if ((ticks - 1UL) > SysTick_LOAD_RELOAD_Msk)
+    {
+        return 1UL;
+    }
+    SysTick->LOAD = ticks - 1UL;
+    NVIC_SetPriority(SysTick_IRQn, (1UL << __NVIC_PRIO_BITS) - 1UL);
+    SysTick->VAL = 0UL;
+    SysTick->CTRL = SysTick_CTRL_CLKSOURCE_Msk | SysTick_CTRL_TICKINT_Msk | SysTick_CTRL_ENABLE_Msk;
+    fake_stm32f4_sync();
+    return 0UL;
+}
+
+void __set_BASEPRI(uint32_t value)
+{
+    basepri = value & 0xFFU;
+    fake_stm32f4_sync();
+}
+
+void __set_BASEPRI_MAX(uint32_t value)
+{
+    value &= 0xFFU;
+    if ((value != 0U) && ((basepri == 0U) || (value < basepri)))
+    {
+        basepri = value;
+    }
+    fake_stm32f4_sync();
+}
+
+uint32_t __get_BASEPRI(void)
+{
+    return basepri;
+}
+
+void __disable_irq(void)
+{
+    primask = true;
+}
+
+void __enable_irq(void)
+{
+    primask = false;
+    fake_stm32f4_sync();
+}
+
+void __WFI(void)
+{
+    IRQn_Type irqn;
+    uint32_t group_prio;
+    uint32_t served = served_count;
+    fake_stm32f4_sync();
+    while ((served == served_count) && !(primask && _fake_stm32f4_preempting(&irqn, &group_prio))) /* With PRIMASK set, the interrupt that would preempt wakes up the core but is not served */
+    {
+        uint64_t step = _fake_stm32f4_next_event();
+        if (step == FAKE_STM32F4_NO_EVENT)
+        {
+            return; /* Nothing can wake up the core */
+        }
+        fake_stm32f4_advance_cycles(step);
+    }
+}
+
+void __NOP(void)
+{
+    fake_stm32f4_advance_cycles(1U);
+}
+
+void initialise_monitor_handles(void)
+{
+    /* The standard output of the host is used instead of semihosting */
+}
@@ -19,6 +19,7 @@
 
 #define STM32F4_PARKING_BUTTON_GPIO GPIOC /**  GPIO to which the user button on the board is connected*/
 #define STM32F4_PARKING_BUTTON_PIN 13 /**Button GPIO pin*/
+#define STM32F4_BUTTON_IRQ_PRIO 6 /**Priority of the button EXTI lines. It must be at or below STM32F4_SYSTEM_CRITICAL_PRIO so that the critical sections mask it*/
 
 
 /* Functions prototypes and explanation -------------------*/
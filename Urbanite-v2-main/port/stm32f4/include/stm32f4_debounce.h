@@ -0,0 +1,34 @@
+/**
+ * @file stm32f4_debounce.h
+ * @brief Header for stm32f4_debounce.c file.
+ * @date 2025-01-01
+ */
+#ifndef STM32F4_DEBOUNCE_H_
+#define STM32F4_DEBOUNCE_H_
+
+/* Includes ------------------------------------------------------------------*/
+/* Standard C includes */
+#include <stdint.h>
+
+/* HW dependent includes */
+#include "stm32f4xx.h"
+
+/* Function prototypes and explanation -------------------------------------------------*/
+/**
+ * @brief Auxiliary function to change the GPIO and pin of a key. It must be called before `port_debounce_init()`.
+ *
+ * @param key_id ID of the key to change
+ * @param p_port New GPIO port for the key. NULL removes the key
+ * @param pin New GPIO pin for the key
+ * @param pupd Pull-up, pull-down, or no-pull. Keys are active low
+ */
+void stm32f4_debounce_set_key_gpio(uint32_t key_id, GPIO_TypeDef *p_port, uint8_t pin, uint8_t pupd);
+
+/**
+ * @brief Advance the debounce engine. It is called from the System tick ISR every millisecond and samples the keys every `PORT_DEBOUNCE_PERIOD_MS`.
+ *
+ * @param now_ms Current system time
+ */
+void stm32f4_debounce_tick(uint32_t now_ms);
+
+#endif /* STM32F4_DEBOUNCE_H_ */
@@ -37,10 +37,31 @@
  #define STM32F4_TRIGGER_BOTH_EDGE (STM32F4_TRIGGER_RISING_EDGE | STM32F4_TRIGGER_FALLING_EDGE) /*!< Interrupt mask for detecting both rising and falling edges */
  #define STM32F4_TRIGGER_ENABLE_EVENT_REQ 0x04                                                  /*!< Interrupt mask for enabling event request */
  #define STM32F4_TRIGGER_ENABLE_INTERR_REQ 0x08U                                                /*!< Interrupt mask for enabling interrupt request */
+ #define STM32F4_EXTI_NUM_LINES 16U                                                             /*!< Number of EXTI lines connected to the GPIOs */
+ #define STM32F4_EXTI_LINES_9_5 0x03E0U                                                         /*!< Mask of the EXTI lines served by EXTI9_5_IRQHandler */
+ #define STM32F4_EXTI_LINES_15_10 0xFC00U                                                       /*!< Mask of the EXTI lines served by EXTI15_10_IRQHandler */
  
  /* Alternate functions */
  #define STM32F4_AF1 0x01U /*!< Alternate function 1 */
  #define STM32F4_AF2 0x02U /*!< Alternate function 2 */
+ #define STM32F4_AF7 0x07U /*!< Alternate function 7 */
+ 
+ /* Critical sections */
+ #define STM32F4_SYSTEM_CRITICAL_PRIO 4U                                                            /*!< Interrupts with this preemption priority or lower (numerically greater or equal) are masked inside a critical section */
+ #define STM32F4_SYSTEM_CRITICAL_BASEPRI ((STM32F4_SYSTEM_CRITICAL_PRIO) << (8U - __NVIC_PRIO_BITS)) /*!< Value written to BASEPRI to enter a critical section */
+ 
+ /* Bit-band */
+ #if defined(SRAM1_BB_BASE)
+ #define STM32F4_SYSTEM_BITBAND_SRAM(p_word, bit) ((volatile uint32_t *)(SRAM1_BB_BASE + (((uint32_t)(p_word) - SRAM1_BASE) << 5U) + ((uint32_t)(bit) << 2U))) /*!< Address of the bit-band alias of a bit of a word placed in SRAM */
+ #endif
+ 
+ /* Typedefs --------------------------------------------------------------------*/
+ /**
+  * @brief Callback of an EXTI line. It is called from the ISR, after the pending bit of the line has been cleared.
+  *
+  * @param id Identifier given when the callback was registered (e.g., the button ID)
+  */
+ typedef void (*stm32f4_system_exti_callback_t)(uint32_t id);
  
  /** @verbatim
        ==============================================================================
@@ -133,6 +154,8 @@
   * > 4. **Select the interrupt and/or event request**: depending on the  value of the given `mode`.  \n
   * > &nbsp;&nbsp;&nbsp;&nbsp;💡 If *event request* enable: activate the corresponding bit on the EXTI_EMR register (element `EMR`) of the `EXTI` structure. \n
   * > &nbsp;&nbsp;&nbsp;&nbsp;💡 If *interrupt request* enable: activate the corresponding bit on the EXTI_IMR register (element `IMR`) of the `EXTI` structure. \n
+  * > \n
+  * > 5. **Register the callback of the line.** The EXTI ISRs call it through `stm32f4_system_exti_dispatch()`. \n
   * \n
   * > 💡 **You can define your own masks for each pin value (not recommended), or you can use the `BIT_POS_TO_MASK(pin)` macro to get the mask of a pin.**
   *
@@ -141,9 +164,22 @@
   * @param p_port Port of the GPIO (CMSIS struct like)
   * @param pin Pin/line of the GPIO (index from 0 to 15)
   * @param mode Trigger mode can be a combination (OR) of: (i) direction: rising edge (0x01), falling edge (0x02), (ii)  event request (0x04), or (iii) interrupt request (0x08).
+  * @param callback Function called when the interrupt of the line is served. NULL if the line has no handler (the pending bit is cleared anyway).
+  * @param id Identifier passed to the callback
+  * @retval None
+  */
+ void stm32f4_system_gpio_config_exti(GPIO_TypeDef *p_port, uint8_t pin, uint32_t mode, stm32f4_system_exti_callback_t callback, uint32_t id);
+ 
+ /**
+  * @brief Serve the pending EXTI lines of an interrupt.
+  *
+  * Reads EXTI_PR once, clears the pending bits of the given lines and calls the registered callbacks from the highest line to the lowest. Each line is found with a CLZ instruction, so the cost only depends on the number of pending lines, not on the number of configured inputs.
+  *
+  * @param lines Mask of the EXTI lines served by the calling ISR (e.g., `STM32F4_EXTI_LINES_15_10`)
+  *
   * @retval None
   */
- void stm32f4_system_gpio_config_exti(GPIO_TypeDef *p_port, uint8_t pin, uint32_t mode);
+ void stm32f4_system_exti_dispatch(uint32_t lines);
  
  /**
   * @brief Enable interrupts of a GPIO line (pin)
@@ -165,4 +201,88 @@
   */
  void stm32f4_system_gpio_exti_disable(uint8_t pin);
  
+ /**
+  * @brief Read the digital value of a GPIO
+  *
+  * @param p_port Port of the GPIO (CMSIS struct like)
+  * @param pin Pin/line of the GPIO (index from 0 to 15)
+  *
+  * @return true if the GPIO is high, false otherwise
+  */
+ bool stm32f4_system_gpio_read(GPIO_TypeDef *p_port, uint8_t pin);
+ 
+ /**
+  * @brief Write a digital value in a GPIO atomically
+  *
+  * @param p_port Port of the GPIO (CMSIS struct like)
+  * @param pin Pin/line of the GPIO (index from 0 to 15)
+  * @param value Boolean value to set the GPIO to high (true) or low (false)
+  *
+  * @retval None
+  */
+ void stm32f4_system_gpio_write(GPIO_TypeDef *p_port, uint8_t pin, bool value);
+ 
+ /**
+  * @brief Toggle the value of a GPIO
+  *
+  * @param p_port Port of the GPIO (CMSIS struct like)
+  * @param pin Pin/line of the GPIO (index from 0 to 15)
+  *
+  * @retval None
+  */
+ void stm32f4_system_gpio_toggle(GPIO_TypeDef *p_port, uint8_t pin);
+ 
+ /**
+  * @brief Set a bit of a flag word shared between ISRs and thread code.
+  *
+  * The write goes through the SRAM bit-band alias, so it is a single atomic store: no read-modify-write sequence that an interrupt could break.
+  *
+  * @param p_flags Pointer to the flag word. It must be placed in SRAM (e.g., a static variable)
+  * @param bit Position of the flag in the word (from 0 to 31)
+  *
+  * @retval None
+  */
+ static inline void stm32f4_system_flag_set(volatile uint32_t *p_flags, uint8_t bit)
+ {
+ #if defined(SRAM1_BB_BASE)
+   *STM32F4_SYSTEM_BITBAND_SRAM(p_flags, bit) = 1U;
+ #else
+   *p_flags |= BIT_POS_TO_MASK(bit); /* Register model of the host: the ISRs only run at its synchronization points, never inside this statement */
+ #endif
+ }
+ 
+ /**
+  * @brief Clear a bit of a flag word shared between ISRs and thread code with a single atomic store.
+  *
+  * @param p_flags Pointer to the flag word. It must be placed in SRAM (e.g., a static variable)
+  * @param bit Position of the flag in the word (from 0 to 31)
+  *
+  * @retval None
+  */
+ static inline void stm32f4_system_flag_clear(volatile uint32_t *p_flags, uint8_t bit)
+ {
+ #if defined(SRAM1_BB_BASE)
+   *STM32F4_SYSTEM_BITBAND_SRAM(p_flags, bit) = 0U;
+ #else
+   *p_flags &= ~BIT_POS_TO_MASK(bit);
+ #endif
+ }
+ 
+ /**
+  * @brief Test a bit of a flag word shared between ISRs and thread code.
+  *
+  * @param p_flags Pointer to the flag word. It must be placed in SRAM (e.g., a static variable)
+  * @param bit Position of the flag in the word (from 0 to 31)
+  *
+  * @return true if the flag is set
+  */
+ static inline bool stm32f4_system_flag_test(volatile uint32_t *p_flags, uint8_t bit)
+ {
+ #if defined(SRAM1_BB_BASE)
+   return *STM32F4_SYSTEM_BITBAND_SRAM(p_flags, bit) != 0U;
+ #else
+   return (*p_flags & BIT_POS_TO_MASK(bit)) != 0U;
+ #endif
+ }
+ 
  #endif /* STM32F4_SYSTEM_H_ */
\ No newline at end of file
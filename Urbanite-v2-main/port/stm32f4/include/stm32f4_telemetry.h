@@ -0,0 +1,29 @@
+/**
+ * @file stm32f4_telemetry.h
+ * @brief Header for stm32f4_telemetry.c file.
+ *
+ * The telemetry frames are sent through USART2, whose TX pin (PA2) is connected to the virtual COM port of the ST-LINK of the Nucleo board. The bytes are moved by the DMA1 stream 6 (channel 4), so the CPU only starts the transfer and serves one interrupt per frame.
+ *
+ * @date 2025-01-01
+ */
+#ifndef STM32F4_TELEMETRY_H_
+#define STM32F4_TELEMETRY_H_
+
+/* Includes ------------------------------------------------------------------*/
+/* Standard C includes */
+#include <stdint.h>
+
+/* HW dependent includes */
+#include "stm32f4xx.h"
+
+/* Defines and enums ----------------------------------------------------------*/
+#define STM32F4_TELEMETRY_USART USART2             /*!< UART of the telemetry */
+#define STM32F4_TELEMETRY_TX_GPIO GPIOA            /*!< GPIO port of the TX pin */
+#define STM32F4_TELEMETRY_TX_PIN 2U                /*!< GPIO pin of the TX pin */
+#define STM32F4_TELEMETRY_BAUDRATE 115200U         /*!< Baud rate of the UART (8N1) */
+#define STM32F4_TELEMETRY_DMA_STREAM DMA1_Stream6  /*!< DMA stream of the TX of USART2 */
+#define STM32F4_TELEMETRY_DMA_CHANNEL 4U           /*!< DMA channel of the TX of USART2 */
+#define STM32F4_TELEMETRY_IRQ DMA1_Stream6_IRQn    /*!< Interrupt of the DMA stream */
+#define STM32F4_TELEMETRY_IRQ_PRIO 7U              /*!< Priority of the interrupt. It is masked by the critical sections */
+
+#endif /* STM32F4_TELEMETRY_H_ */
@@ -0,0 +1,25 @@
+/**
+ * @file stm32f4_timer.h
+ * @brief Header for stm32f4_timer.c file.
+ *
+ * TIM5 is the hardware timer of the software timers of `port_timer.h`: a 32-bit counter that runs freely at 1 MHz, with the compare-match channel 1 programmed at the next event of the timer wheel.
+ *
+ * @date 2025-01-01
+ */
+#ifndef STM32F4_TIMER_H_
+#define STM32F4_TIMER_H_
+
+/* Includes ------------------------------------------------------------------*/
+/* Standard C includes */
+#include <stdint.h>
+
+/* HW dependent includes */
+#include "stm32f4xx.h"
+
+/* Defines and enums ----------------------------------------------------------*/
+#define STM32F4_TIMER_TIM TIM5              /*!< Hardware timer of the software timers. It must have a 32-bit counter */
+#define STM32F4_TIMER_IRQ TIM5_IRQn         /*!< Interrupt of the hardware timer */
+#define STM32F4_TIMER_IRQ_PRIO 5U           /*!< Priority of the interrupt. It is masked by the critical sections */
+#define STM32F4_TIMER_FREQ_HZ 1000000U      /*!< Counting frequency: one tick per microsecond */
+
+#endif /* STM32F4_TIMER_H_ */
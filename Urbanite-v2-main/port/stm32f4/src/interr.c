@@ -9,12 +9,64 @@
 #include "stm32f4_system.h"
 #include "port_button.h"
 #include "stm32f4_button.h"
+#include "stm32f4_debounce.h"
 #include "port_ultrasound.h"
 #include "stm32f4_ultrasound.h"
+#include "port_timer.h"
+#include "port_telemetry.h"
+#include "port_isr_stats.h"
+#include "port_latency.h"
+#include "port_trace.h"
 
 
 // Include headers of different port elements:
 
+#if defined(PORT_ISR_STATS) || defined(PORT_LATENCY_TRACE)
+//------------------------------------------------------
+// LATENCY OF THE INTERRUPTS
+//------------------------------------------------------
+/**
+ * @brief Cycles from an event of a timer to the current value of its counter. The timers run at HCLK, because the APB prescalers are 1.
+ *
+ * @param p_tim Timer
+ * @param event_tick Value of the counter at the event
+ * @return Latency in cycles
+ */
+static uint32_t _interr_timer_latency(TIM_TypeDef *p_tim, uint32_t event_tick)
+{
+    uint32_t cnt = p_tim->CNT;
+    uint32_t ticks = (cnt >= event_tick) ? (cnt - event_tick) : (cnt + p_tim->ARR + 1U - event_tick);
+    return ticks * (p_tim->PSC + 1U);
+}
+#endif
+
+#ifdef PORT_ISR_STATS
+/**
+ * @brief Latency of the echo timer from the overflow (the counter restarts at 0), if it is pending.
+ *
+ * @note CCR2 is not read here: reading it clears CC2IF, so the latency of a capture is given by the handler with the value that it reads.
+ *
+ * @return Latency in cycles, or `PORT_ISR_STATS_NO_LATENCY`
+ */
+static uint32_t _interr_echo_latency(void)
+{
+    return (TIM2->SR & TIM_SR_UIF) ? _interr_timer_latency(TIM2, 0U) : PORT_ISR_STATS_NO_LATENCY;
+}
+#endif
+
+#ifdef PORT_LATENCY_TRACE
+/**
+ * @brief Time of a capture of the echo timer, for the latency trace.
+ *
+ * @param capture_tick Value of the capture register
+ * @return Time of the capture in microseconds of `port_timer_get_micros()`
+ */
+static uint32_t _interr_capture_micros(uint32_t capture_tick)
+{
+    return port_timer_get_micros() - (_interr_timer_latency(TIM2, capture_tick) / port_system_get_cycles_per_us());
+}
+#endif
+
 //------------------------------------------------------
 // INTERRUPT SERVICE ROUTINES
 //------------------------------------------------------
@@ -33,25 +85,67 @@
  */
 void SysTick_Handler(void)
 {
+    PORT_ISR_STATS_ENTER(PORT_ISR_ID_SYSTICK, SysTick->LOAD - SysTick->VAL); /* The counter runs down from LOAD since the event */
     uint32_t msTicks_actual= port_system_get_millis();
     port_system_set_millis(msTicks_actual+1);
+    stm32f4_debounce_tick(msTicks_actual+1); /* Samples the keys every PORT_DEBOUNCE_PERIOD_MS */
+    PORT_ISR_STATS_EXIT(PORT_ISR_ID_SYSTICK);
+}
+/**
+ * @brief Interrupt service routines for the EXTI lines 0 to 4, 5 to 9 and 10 to 15.
+ *
+ * @note The lines are served by `stm32f4_system_exti_dispatch()`, which calls the callback registered for each pending line with `stm32f4_system_gpio_config_exti()`. New inputs do not require changes here.
+ * The EXTI has no counter of the edge, so only the duration of these ISRs is measured.
+ */
+void EXTI0_IRQHandler(void)
+{
+    PORT_ISR_STATS_ENTER(PORT_ISR_ID_BUTTON, PORT_ISR_STATS_NO_LATENCY);
+    stm32f4_system_exti_dispatch(BIT_POS_TO_MASK(0));
+    PORT_ISR_STATS_EXIT(PORT_ISR_ID_BUTTON);
+}
+
+void EXTI1_IRQHandler(void)
+{
+    PORT_ISR_STATS_ENTER(PORT_ISR_ID_BUTTON, PORT_ISR_STATS_NO_LATENCY);
+    stm32f4_system_exti_dispatch(BIT_POS_TO_MASK(1));
+    PORT_ISR_STATS_EXIT(PORT_ISR_ID_BUTTON);
+}
 
+void EXTI2_IRQHandler(void)
+{
+    PORT_ISR_STATS_ENTER(PORT_ISR_ID_BUTTON, PORT_ISR_STATS_NO_LATENCY);
+    stm32f4_system_exti_dispatch(BIT_POS_TO_MASK(2));
+    PORT_ISR_STATS_EXIT(PORT_ISR_ID_BUTTON);
 }
-void EXTI15_10_IRQHandler(void) {
 
-    if (port_button_get_pending_interrupt(PORT_PARKING_BUTTON_ID)) {
+void EXTI3_IRQHandler(void)
+{
+    PORT_ISR_STATS_ENTER(PORT_ISR_ID_BUTTON, PORT_ISR_STATS_NO_LATENCY);
+    stm32f4_system_exti_dispatch(BIT_POS_TO_MASK(3));
+    PORT_ISR_STATS_EXIT(PORT_ISR_ID_BUTTON);
+}
 
-        if (port_button_get_value(PORT_PARKING_BUTTON_ID)==true){
+void EXTI4_IRQHandler(void)
+{
+    PORT_ISR_STATS_ENTER(PORT_ISR_ID_BUTTON, PORT_ISR_STATS_NO_LATENCY);
+    stm32f4_system_exti_dispatch(BIT_POS_TO_MASK(4));
+    PORT_ISR_STATS_EXIT(PORT_ISR_ID_BUTTON);
+}
 
-            port_button_set_pressed(PORT_PARKING_BUTTON_ID, false);
-        }
-        else {
-            port_button_set_pressed(PORT_PARKING_BUTTON_ID, true);
-        }
+void EXTI9_5_IRQHandler(void)
+{
+    PORT_ISR_STATS_ENTER(PORT_ISR_ID_BUTTON, PORT_ISR_STATS_NO_LATENCY);
+    stm32f4_system_exti_dispatch(STM32F4_EXTI_LINES_9_5);
+    PORT_ISR_STATS_EXIT(PORT_ISR_ID_BUTTON);
+}
 
-    }
-    port_button_clear_pending_interrupt(PORT_PARKING_BUTTON_ID);
+void EXTI15_10_IRQHandler(void)
+{
+    PORT_ISR_STATS_ENTER(PORT_ISR_ID_BUTTON, PORT_ISR_STATS_NO_LATENCY);
+    stm32f4_system_exti_dispatch(STM32F4_EXTI_LINES_15_10);
+    PORT_ISR_STATS_EXIT(PORT_ISR_ID_BUTTON);
 }
+
 /** @brief Interrupt service routine for the TIM5 timer
 *
 * This timer controls the duration of the measurements of the ultrasound
@@ -60,8 +154,8 @@ void EXTI15_10_IRQHandler(void) {
 *
 */
 void TIM2_IRQHandler(void){
-    
-    
+    PORT_ISR_STATS_ENTER(PORT_ISR_ID_ECHO, _interr_echo_latency());
+
 
     if (TIM2->SR & TIM_SR_UIF) /*!< Checking if the UIF flag is set*/
     {
@@ -71,18 +165,22 @@ void TIM2_IRQHandler(void){
         TIM2-> SR &= ~TIM_SR_UIF;
     }
 
-    if ((TIM2->SR & TIM_SR_CC2IF) !=0) /*!< Checking if the UIF flag is set*/
+    if ((TIM2->SR & TIM_SR_CC2IF) !=0) /*!< Checking if the CC2IF flag is set (an edge of the echo has been captured)*/
     {
-        uint32_t current_tick= TIM2->CCR2;
+        uint32_t current_tick= TIM2->CCR2; /*!< Reading CCR2 clears CC2IF, so it is only read here*/
+        PORT_ISR_STATS_LATENCY(PORT_ISR_ID_ECHO, _interr_timer_latency(TIM2, current_tick)); /*!<Latency from the capture*/
         if(((port_ultrasound_get_echo_init_tick(PORT_REAR_PARKING_SENSOR_ID))==0) && ((port_ultrasound_get_echo_end_tick(PORT_REAR_PARKING_SENSOR_ID))==0)){
             port_ultrasound_set_echo_init_tick(PORT_REAR_PARKING_SENSOR_ID, current_tick);
-            port_ultrasound_get_echo_end_tick (PORT_REAR_PARKING_SENSOR_ID);
-            port_ultrasound_set_echo_received(PORT_REAR_PARKING_SENSOR_ID,true);
+            PORT_LATENCY_MARK_AT(PORT_REAR_PARKING_SENSOR_ID, PORT_LATENCY_ECHO_RISE, _interr_capture_micros(current_tick));
         }
+        else{ /*!< The falling edge ends the echo, as in the native port*/
+            port_ultrasound_set_echo_end_tick(PORT_REAR_PARKING_SENSOR_ID, current_tick);
+            port_ultrasound_set_echo_received(PORT_REAR_PARKING_SENSOR_ID,true);
+            PORT_LATENCY_MARK_AT(PORT_REAR_PARKING_SENSOR_ID, PORT_LATENCY_ECHO_FALL, _interr_capture_micros(current_tick));
+            PORT_TRACE_RECORD(PORT_TRACE_ECHO, PORT_REAR_PARKING_SENSOR_ID, port_ultrasound_get_echo_overflows(PORT_REAR_PARKING_SENSOR_ID), port_ultrasound_get_echo_init_tick(PORT_REAR_PARKING_SENSOR_ID) | (current_tick << 16));
         }
-    
-        //
-
+    }
+    PORT_ISR_STATS_EXIT(PORT_ISR_ID_ECHO);
     }
     
     
@@ -101,22 +199,39 @@ void TIM2_IRQHandler(void){
 *
 */
 void TIM3_IRQHandler(void){
+    PORT_ISR_STATS_ENTER(PORT_ISR_ID_TRIGGER, _interr_timer_latency(TIM3, 0U)); /*!<The counter restarts at 0 with the update event*/
     TIM3->SR &= ~TIM_SR_UIF;/*!<Clearing the interrupt flag UIF in the status register SR*/
     port_ultrasound_set_trigger_end(PORT_REAR_PARKING_SENSOR_ID,true); /*!<Calling the function to set the flag
     that indicates that the time of the trigger signal has expired*/
+    PORT_ISR_STATS_EXIT(PORT_ISR_ID_TRIGGER);
 
 }
 
 /** @brief Interrupt service routine for the TIM5 timer
 *
-* This timer controls the duration of the measurements of the ultrasound
-* sensor. When the interrupt occurs it means that the time of the 
-* the measurement has expired and a new mesasurement can be started
+* This timer is the time base of the software timers. The interrupt occurs
+* when the counter reaches the next event of the timer wheel.
 *
 */
 void TIM5_IRQHandler(void){
-    TIM5->SR &= ~TIM_SR_UIF; /*!Clear the interrupt flag UIF in the status register SR*/
-    port_ultrasound_set_trigger_ready(PORT_PARKING_BUTTON_ID,true);/*!<Calling the function to set the 
-    flag that indicates that a new measurement can be started*/
+    PORT_ISR_STATS_ENTER(PORT_ISR_ID_TIMER, _interr_timer_latency(TIM5, TIM5->CCR1)); /*!<Latency from the compare match*/
+    TIM5->SR = ~TIM_SR_CC1IF; /*!<Clear the compare flag CC1IF in the status register SR*/
+    port_timer_irq_handler(); /*!<Expire the due timers and program the next event*/
+    PORT_ISR_STATS_EXIT(PORT_ISR_ID_TIMER);
+}
 
-}
\ No newline at end of file
+/** @brief Interrupt service routine for the DMA1 stream 6
+*
+* This stream moves the telemetry frames to the TX of USART2. The interrupt
+* occurs when a frame has been sent, so the next frame can be started
+*
+*/
+void DMA1_Stream6_IRQHandler(void){
+    PORT_ISR_STATS_ENTER(PORT_ISR_ID_TELEMETRY, PORT_ISR_STATS_NO_LATENCY); /*!<The DMA has no counter of the event*/
+    if (DMA1->HISR & (DMA_HISR_TCIF6 | DMA_HISR_TEIF6)) /*!<Checking if the transfer is complete or has failed*/
+    {
+        DMA1->HIFCR = DMA_HIFCR_CTCIF6 | DMA_HIFCR_CTEIF6; /*!<Clearing the flags. A failed frame is discarded*/
+        port_telemetry_tx_complete_irq_handler(); /*!<Start the next frame, if any*/
+    }
+    PORT_ISR_STATS_EXIT(PORT_ISR_ID_TELEMETRY);
+}
@@ -14,6 +14,7 @@
 #include "port_system.h"
 #include "stm32f4_button.h"
 #include "stm32f4_system.h"
+#include "port_trace.h"
 
 /* HW dependent includes */
 
@@ -23,6 +24,9 @@
 
 
 
+/*Defines ------------------------------------------------------*/
+#define STM32F4_BUTTON_FLAG_PRESSED 0U /*!< Position of the pressed flag in the flag word of a button */
+
 /*Typedefs ------------------------------------------------------*/
 typedef struct 
 {
@@ -30,7 +34,7 @@ typedef struct
     GPIO_TypeDef *p_port; //Puede ser que 
     uint8_t pin;
     uint8_t pupd_mode;
-    bool flag_pressed;
+    volatile uint32_t flags; /*!< Flags shared with the ISR. Accessed through the bit-band alias */
 }stm32f4_button_hw_t;
 
 /*Global variables -------------------------------*/
@@ -59,20 +63,38 @@ stm32f4_button_hw_t* _stm32f4_button_get(uint32_t button_id){
 }
 
 
+/**
+ * @brief Callback of the EXTI line of a button. It updates the pressed flag with the level of the GPIO.
+ * @param button_id Button ID.
+ */
+static void _stm32f4_button_exti_callback(uint32_t button_id)
+{
+    bool value = port_button_get_value(button_id);
+    if (value == true) /** The button is active low */
+    {
+        port_button_set_pressed(button_id, false);
+    }
+    else
+    {
+        port_button_set_pressed(button_id, true);
+    }
+    PORT_TRACE_RECORD(PORT_TRACE_BUTTON, button_id, value, 0);
+}
+
 /*Public functions -------------------------*/
 
 void port_button_init(uint32_t button_id){
     //Retrieve the button structu using the private function and the button id
     stm32f4_button_hw_t *p_button= _stm32f4_button_get(button_id);/** Retrieve the button config struct */
     stm32f4_system_gpio_config(p_button->p_port, p_button->pin, STM32F4_GPIO_MODE_IN, p_button->pupd_mode ); /*Configure the button as input and no pull up neither pull down connection*/
-    stm32f4_system_gpio_config_exti(p_button->p_port, p_button->pin,STM32F4_TRIGGER_RISING_EDGE | STM32F4_TRIGGER_FALLING_EDGE | STM32F4_TRIGGER_ENABLE_INTERR_REQ ); /**To configure interruption mode in both rising and falling edges, and enable the interrupt request */
-    stm32f4_system_gpio_exti_enable(p_button->pin, 1,0); /*To enable the interrupt line and set the priority level to 1 and sub. level to 0*/
+    stm32f4_system_gpio_config_exti(p_button->p_port, p_button->pin,STM32F4_TRIGGER_RISING_EDGE | STM32F4_TRIGGER_FALLING_EDGE | STM32F4_TRIGGER_ENABLE_INTERR_REQ, _stm32f4_button_exti_callback, button_id); /**To configure interruption mode in both rising and falling edges, enable the interrupt request and register the callback of the line */
+    stm32f4_system_gpio_exti_enable(p_button->pin, STM32F4_BUTTON_IRQ_PRIO, 0); /*To enable the interrupt line and set the priority level and sub. level to 0. The level is below the critical section threshold so that the pressed flag is protected*/
 }
 
 bool port_button_get_pressed (uint32_t button_id){
     stm32f4_button_hw_t *p_button= _stm32f4_button_get(button_id);
 
-    return p_button->flag_pressed; /** Return the status of the button */
+    return stm32f4_system_flag_test(&p_button->flags, STM32F4_BUTTON_FLAG_PRESSED); /** Return the status of the button */
 
 } 
 
@@ -91,7 +113,14 @@ void port_button_set_pressed (uint32_t button_id, bool pressed){
 
     stm32f4_button_hw_t *p_button= _stm32f4_button_get(button_id);/** Retrieve the button config struct */
 
-    p_button->flag_pressed=pressed; /**Set the value of the field flag_pressed */
+    if (pressed) /**Set the pressed flag with a single atomic store */
+    {
+        stm32f4_system_flag_set(&p_button->flags, STM32F4_BUTTON_FLAG_PRESSED);
+    }
+    else
+    {
+        stm32f4_system_flag_clear(&p_button->flags, STM32F4_BUTTON_FLAG_PRESSED);
+    }
 }
 
 bool port_button_get_pending_interrupt (uint32_t button_id){
@@ -114,7 +143,7 @@ void port_button_clear_pending_interrupt(uint32_t button_id) {
     stm32f4_button_hw_t *p_button= _stm32f4_button_get(button_id); /** Retrieve the button config struct */
     uint8_t pin_GPIO= p_button->pin;
     
-    EXTI->PR |= (1<<pin_GPIO);  /**Clearing PR register associated with the button pin (1) */
+    EXTI->PR = (1<<pin_GPIO);  /**Clearing PR register associated with the button pin (1). PR is rc_w1: writing only this bit does not clear other pending lines */
     
 }
 
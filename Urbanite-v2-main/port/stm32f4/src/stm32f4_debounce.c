@@ -0,0 +1,204 @@
+/**
+ * @file stm32f4_debounce.c
+ * @brief Portable functions of the multi-key debounce engine for the STM32F4 platform.
+ *
+ * The keys are grouped by GPIO port. Every sampling period the IDR register of each port is read once and all its keys are debounced in parallel with a vertical counter. Only the keys whose debounced state changes cost extra work, to queue their events.
+ *
+ * @date 2025-01-01
+ */
+/*Includes-----------------------------*/
+/*Standard C includes*/
+#include <stddef.h>
+
+/* HW dependent includes */
+#include "port_button.h"
+#include "port_debounce.h"
+#include "port_system.h"
+#include "stm32f4_button.h"
+#include "stm32f4_debounce.h"
+#include "stm32f4_system.h"
+
+/*Defines ------------------------------------------------------*/
+#define STM32F4_DEBOUNCE_NUM_PORTS 3U     /*!< Number of GPIO ports that can have keys (GPIOA, GPIOB and GPIOC) */
+#define STM32F4_DEBOUNCE_NO_KEY 0xFFU     /*!< Marks a pin of a port without key */
+
+/*Typedefs ------------------------------------------------------*/
+/**
+ * @brief Configuration of a key
+ */
+typedef struct
+{
+    GPIO_TypeDef *p_port; /*!< GPIO of the key. NULL if the key is not used */
+    uint8_t pin;          /*!< Pin of the key */
+    uint8_t pupd_mode;    /*!< Pull-up/pull-down of the key */
+} stm32f4_debounce_key_hw_t;
+
+/**
+ * @brief Debounce state of the keys of a GPIO port
+ */
+typedef struct
+{
+    GPIO_TypeDef *p_port;                           /*!< GPIO port */
+    uint32_t mask;                                  /*!< Pins of the port with a key */
+    port_debounce_vcnt_t vcnt;                      /*!< Vertical counter of the pins */
+    uint8_t key_of_pin[STM32F4_EXTI_NUM_LINES];     /*!< Key ID of each pin */
+} stm32f4_debounce_port_t;
+
+/*Global variables -------------------------------*/
+static stm32f4_debounce_key_hw_t keys_arr[PORT_DEBOUNCE_MAX_KEYS] = {
+    [PORT_PARKING_BUTTON_ID] = {.p_port = STM32F4_PARKING_BUTTON_GPIO, .pin = STM32F4_PARKING_BUTTON_PIN, .pupd_mode = STM32F4_GPIO_PUPDR_NOPULL}};
+
+static stm32f4_debounce_port_t ports_arr[STM32F4_DEBOUNCE_NUM_PORTS];  /*!< Keys grouped by GPIO port */
+static port_debounce_event_t events_arr[PORT_DEBOUNCE_QUEUE_SIZE];     /*!< Queue of events. Written by the System tick ISR, read by the FSMs */
+static volatile uint32_t events_head = 0;                              /*!< Index of the next event to write. Only modified by the ISR */
+static volatile uint32_t events_tail = 0;                              /*!< Index of the next event to read. Only modified by the reader */
+static volatile uint32_t events_dropped = 0;                           /*!< Events lost because the queue was full */
+static volatile bool engine_enabled = false;                           /*!< The engine is configured and samples the keys */
+
+/*Private functions--------------------------------*/
+/**
+ * @brief Get the index of the group of a GPIO port
+ * @param p_port GPIO port
+ * @return Index of the group, or STM32F4_DEBOUNCE_NUM_PORTS if the port is not supported
+ */
+static uint32_t _stm32f4_debounce_port_index(GPIO_TypeDef *p_port)
+{
+    if (p_port == GPIOA)
+    {
+        return 0;
+    }
+    else if (p_port == GPIOB)
+    {
+        return 1;
+    }
+    else if (p_port == GPIOC)
+    {
+        return 2;
+    }
+    return STM32F4_DEBOUNCE_NUM_PORTS;
+}
+
+/**
+ * @brief Queue an event. Called from the ISR only.
+ * @param key_id Key ID
+ * @param pressed New debounced state
+ * @param now_ms Timestamp
+ */
+static void _stm32f4_debounce_push_event(uint8_t key_id, bool pressed, uint32_t now_ms)
+{
+    uint32_t head = events_head;
+    if ((head - events_tail) >= PORT_DEBOUNCE_QUEUE_SIZE)
+    {
+        events_dropped++;
+        return;
+    }
+    port_debounce_event_t *p_event = &events_arr[head & (PORT_DEBOUNCE_QUEUE_SIZE - 1U)];
+    p_event->timestamp_ms = now_ms;
+    p_event->key_id = key_id;
+    p_event->pressed = pressed;
+    events_head = head + 1U; /* Published after the event is complete */
+}
+
+/*Public functions -------------------------*/
+void stm32f4_debounce_set_key_gpio(uint32_t key_id, GPIO_TypeDef *p_port, uint8_t pin, uint8_t pupd)
+{
+    if (key_id < PORT_DEBOUNCE_MAX_KEYS)
+    {
+        keys_arr[key_id].p_port = p_port;
+        keys_arr[key_id].pin = pin;
+        keys_arr[key_id].pupd_mode = pupd;
+    }
+}
+
+void port_debounce_init(void)
+{
+    engine_enabled = false;
+
+    for (uint32_t p = 0; p < STM32F4_DEBOUNCE_NUM_PORTS; p++)
+    {
+        stm32f4_debounce_port_t *p_group = &ports_arr[p];
+        p_group->p_port = NULL;
+        p_group->mask = 0;
+        p_group->vcnt.ct0 = 0xFFFFFFFFU; /* Counters start at 3 */
+        p_group->vcnt.ct1 = 0xFFFFFFFFU;
+        p_group->vcnt.state = 0;
+        for (uint32_t pin = 0; pin < STM32F4_EXTI_NUM_LINES; pin++)
+        {
+            p_group->key_of_pin[pin] = STM32F4_DEBOUNCE_NO_KEY;
+        }
+    }
+
+    for (uint32_t key_id = 0; key_id < PORT_DEBOUNCE_MAX_KEYS; key_id++)
+    {
+        stm32f4_debounce_key_hw_t *p_key = &keys_arr[key_id];
+        uint32_t p = _stm32f4_debounce_port_index(p_key->p_port);
+        if (p < STM32F4_DEBOUNCE_NUM_PORTS)
+        {
+            stm32f4_system_gpio_config(p_key->p_port, p_key->pin, STM32F4_GPIO_MODE_IN, p_key->pupd_mode);
+            ports_arr[p].p_port = p_key->p_port;
+            ports_arr[p].mask |= BIT_POS_TO_MASK(p_key->pin);
+            ports_arr[p].key_of_pin[p_key->pin] = (uint8_t)key_id;
+        }
+    }
+
+    events_tail = events_head;
+    events_dropped = 0;
+    engine_enabled = true;
+}
+
+void stm32f4_debounce_tick(uint32_t now_ms)
+{
+    if (!engine_enabled || ((now_ms % PORT_DEBOUNCE_PERIOD_MS) != 0U))
+    {
+        return;
+    }
+
+    for (uint32_t p = 0; p < STM32F4_DEBOUNCE_NUM_PORTS; p++)
+    {
+        stm32f4_debounce_port_t *p_group = &ports_arr[p];
+        if (p_group->mask == 0U)
+        {
+            continue;
+        }
+        uint32_t sample = ~(p_group->p_port->IDR) & p_group->mask; /* Keys are active low */
+        uint32_t toggled = port_debounce_vcnt_step(&p_group->vcnt, sample);
+        while (toggled != 0U)
+        {
+            uint32_t pin = 31U - __CLZ(toggled);
+            toggled &= ~BIT_POS_TO_MASK(pin);
+            _stm32f4_debounce_push_event(p_group->key_of_pin[pin], (p_group->vcnt.state & BIT_POS_TO_MASK(pin)) != 0U, now_ms);
+        }
+    }
+}
+
+bool port_debounce_get_event(port_debounce_event_t *p_event)
+{
+    uint32_t tail = events_tail;
+    if (tail == events_head)
+    {
+        return false;
+    }
+    *p_event = events_arr[tail & (PORT_DEBOUNCE_QUEUE_SIZE - 1U)];
+    events_tail = tail + 1U; /* Released after the event is copied */
+    return true;
+}
+
+bool port_debounce_get_pressed(uint32_t key_id)
+{
+    if (key_id >= PORT_DEBOUNCE_MAX_KEYS)
+    {
+        return false;
+    }
+    stm32f4_debounce_key_hw_t *p_key = &keys_arr[key_id];
+    uint32_t p = _stm32f4_debounce_port_index(p_key->p_port);
+    if (p >= STM32F4_DEBOUNCE_NUM_PORTS)
+    {
+        return false;
+    }
+    return (ports_arr[p].vcnt.state & BIT_POS_TO_MASK(p_key->pin)) != 0U;
+}
+
+uint32_t port_debounce_get_dropped_events(void)
+{
+    return events_dropped;
+}
@@ -0,0 +1,38 @@
+/**
+ * @file stm32f4_log.c
+ * @brief Drain of the deferred logger for the STM32F4 platform.
+ *
+ * The records are sent through the stimulus port 0 of the ITM, so they come out of the SWO pin at the speed configured by the debugger (e.g., OpenOCD `itm port 0 on` and `tpiu config`). If no debugger has enabled the ITM, the records stay in `port_log_buffer`, that can be dumped with the debugger and decoded offline.
+ *
+ * @date 2025-01-01
+ */
+
+/* HW dependent includes */
+#include "port_log.h"
+#include "stm32f4_system.h"
+
+/* Defines ----------------------------------------------------------------------*/
+#define STM32F4_LOG_ITM_PORT 0U /*!< ITM stimulus port of the records */
+
+/* Public functions -----------------------------------------------------------*/
+void port_log_hw_init(void)
+{
+    /* The trace unit is enabled by `port_system_init()` (TRCENA). The ITM and the SWO pin are configured by the debugger */
+}
+
+uint32_t port_log_hw_write(const uint32_t *p_words, uint32_t num_words)
+{
+    if (((ITM->TCR & ITM_TCR_ITMENA_Msk) == 0U) || ((ITM->TER & (1UL << STM32F4_LOG_ITM_PORT)) == 0U))
+    {
+        return 0;
+    }
+    for (uint32_t i = 0; i < num_words; i++)
+    {
+        while (ITM->PORT[STM32F4_LOG_ITM_PORT].u32 == 0U)
+        {
+            /* Wait until the stimulus FIFO accepts a new word */
+        }
+        ITM->PORT[STM32F4_LOG_ITM_PORT].u32 = p_words[i];
+    }
+    return num_words;
+}
@@ -5,9 +5,14 @@
  * @date 2025-01-01
  */
 
+/* Standard C includes */
+#include <stddef.h>
+
 /* HW dependent includes */
 #include "port_system.h"
 #include "stm32f4_system.h"
+#include "port_timer.h"
+#include "port_log.h"
 
 #ifdef USE_SEMIHOSTING
 extern void initialise_monitor_handles(void);
@@ -31,6 +36,10 @@ extern void initialise_monitor_handles(void);
 // PRIVATE (STATIC) VARIABLES
 //------------------------------------------------------
 static volatile uint32_t msTicks = 0; /*!< Variable to store millisecond ticks. @warning **It must be declared volatile!** Just because it is modified in an ISR. **Add it to the definition** after *static*. */
+static volatile uint32_t critical_nesting = 0; /*!< Nesting level of the critical sections. BASEPRI is only restored when it gets back to 0 */
+static volatile uint32_t critical_basepri = 0; /*!< BASEPRI in effect when the outermost critical section was entered */
+static stm32f4_system_exti_callback_t exti_callbacks[STM32F4_EXTI_NUM_LINES]; /*!< Callback of each EXTI line */
+static uint32_t exti_ids[STM32F4_EXTI_NUM_LINES];                              /*!< Identifier passed to the callback of each EXTI line */
 
 //------------------------------------------------------
 // PUBLIC (GLOBAL) VARIABLES
@@ -152,6 +161,17 @@ uint32_t port_system_init()
   /* Configure the system clock */
   system_clock_config();
 
+  /* Start the cycle counter of the Data Watchpoint and Trace unit */
+  CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+  DWT->CYCCNT = 0;
+  DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+
+  /* Start the hardware timer of the software timers */
+  port_timer_init();
+
+  /* Empty the buffer of the deferred logger */
+  port_log_init();
+
   return 0;
 }
 
@@ -165,6 +185,7 @@ void port_system_delay_ms(uint32_t ms)
   while ((port_system_get_millis() - tickstart) < ms) //No hace nada durante
   //un tiempo determinado
   {
+    __WFI(); /* Only the SysTick ISR advances the tick, so sleep until the next interrupt. In the register model of the host build, this also advances the virtual time to the next event */
   }
 }
 
@@ -189,6 +210,57 @@ void port_system_set_millis(uint32_t ms)
   msTicks=ms;
 }
 
+void port_system_sleep(void)
+{
+  __WFI();
+}
+
+void port_system_disable_interrupts(void)
+{
+  __disable_irq(); /* PRIMASK: a pending interrupt still wakes up __WFI() */
+}
+
+void port_system_enable_interrupts(void)
+{
+  __enable_irq();
+}
+
+uint32_t port_system_get_cycles(void)
+{
+  return DWT->CYCCNT;
+}
+
+uint32_t port_system_get_cycles_per_us(void)
+{
+  return SystemCoreClock / 1000000U;
+}
+
+//------------------------------------------------------
+// CRITICAL SECTIONS
+//------------------------------------------------------
+void port_system_enter_critical(void)
+{
+  uint32_t basepri = __get_BASEPRI();
+  /* BASEPRI_MAX only raises the masking level, so entering from an ISR that already runs above the threshold is harmless */
+  __set_BASEPRI_MAX(STM32F4_SYSTEM_CRITICAL_BASEPRI);
+  if (critical_nesting++ == 0)
+  {
+    critical_basepri = basepri; /* Saved after the count, so an ISR that preempts the entry restores its own value */
+  }
+}
+
+void port_system_exit_critical(void)
+{
+  if (critical_nesting > 0)
+  {
+    critical_nesting--;
+    if (critical_nesting == 0)
+    {
+      __set_BASEPRI(critical_basepri); /* Restore the masking level in effect at the outermost entry */
+    }
+  }
+}
+
 // ------------------------------------------------------
 // Implementation of PORT system functions that are called from the platform-dependent code.
 // i.e., the following functions do depend on the platform and are declared in the
@@ -220,7 +292,7 @@ void stm32f4_system_gpio_config(GPIO_TypeDef *p_port, uint8_t pin, uint8_t mode,
   p_port->PUPDR |= (pupd<< (pin * 2U));
 }
 
-void stm32f4_system_gpio_config_exti(GPIO_TypeDef *p_port, uint8_t pin, uint32_t mode)
+void stm32f4_system_gpio_config_exti(GPIO_TypeDef *p_port, uint8_t pin, uint32_t mode, stm32f4_system_exti_callback_t callback, uint32_t id)
 {
   uint32_t port_selector = 0;
 
@@ -270,6 +342,10 @@ void stm32f4_system_gpio_config_exti(GPIO_TypeDef *p_port, uint8_t pin, uint32_t
   /* Clear EXTI line configuration */
   EXTI->IMR &= ~BIT_POS_TO_MASK(pin);
 
+  /* Callback of the line. Registered before unmasking it */
+  exti_callbacks[pin] = callback;
+  exti_ids[pin] = id;
+
   /* Interrupt mask register (EXTI_IMR) */
   if (mode & STM32F4_TRIGGER_ENABLE_INTERR_REQ)
   {
@@ -277,6 +353,22 @@ void stm32f4_system_gpio_config_exti(GPIO_TypeDef *p_port, uint8_t pin, uint32_t
   }
 }
 
+void stm32f4_system_exti_dispatch(uint32_t lines)
+{
+  uint32_t pending = EXTI->PR & lines;
+  EXTI->PR = pending; /* rc_w1: only the lines being served are cleared. An edge arriving during a callback pends the line again */
+
+  while (pending != 0U)
+  {
+    uint32_t line = 31U - __CLZ(pending);
+    pending &= ~BIT_POS_TO_MASK(line);
+    if (exti_callbacks[line] != NULL)
+    {
+      exti_callbacks[line](exti_ids[line]);
+    }
+  }
+}
+
 void stm32f4_system_gpio_exti_enable(uint8_t pin, uint8_t priority, uint8_t subpriority)
 {
   NVIC_SetPriority(GET_PIN_IRQN(pin), NVIC_EncodePriority(NVIC_GetPriorityGrouping(), priority, subpriority));
@@ -0,0 +1,52 @@
+/**
+ * @file stm32f4_telemetry.c
+ * @brief UART and DMA of the telemetry stream for the STM32F4 platform.
+ * @date 2025-01-01
+ */
+
+/* HW dependent includes */
+#include "port_telemetry.h"
+#include "stm32f4_system.h"
+#include "stm32f4_telemetry.h"
+
+/* Public functions -----------------------------------------------------------*/
+void port_telemetry_hw_init(void)
+{
+    RCC->AHB1ENR |= RCC_AHB1ENR_GPIOAEN | RCC_AHB1ENR_DMA1EN;
+    RCC->APB1ENR |= RCC_APB1ENR_USART2EN;
+
+    stm32f4_system_gpio_config(STM32F4_TELEMETRY_TX_GPIO, STM32F4_TELEMETRY_TX_PIN, STM32F4_GPIO_MODE_AF, STM32F4_GPIO_PUPDR_NOPULL);
+    stm32f4_system_gpio_config_alternate(STM32F4_TELEMETRY_TX_GPIO, STM32F4_TELEMETRY_TX_PIN, STM32F4_AF7);
+
+    /* UART: 8 data bits, no parity, 1 stop bit, oversampling by 16. Only the transmitter is enabled */
+    uint32_t pclk1 = SystemCoreClock >> APBPrescTable[(RCC->CFGR & RCC_CFGR_PPRE1) >> RCC_CFGR_PPRE1_Pos];
+    STM32F4_TELEMETRY_USART->CR1 = 0;
+    STM32F4_TELEMETRY_USART->CR2 = 0;
+    STM32F4_TELEMETRY_USART->BRR = (pclk1 + (STM32F4_TELEMETRY_BAUDRATE / 2U)) / STM32F4_TELEMETRY_BAUDRATE; /* USARTDIV in 12.4 fixed point, rounded */
+    STM32F4_TELEMETRY_USART->CR3 = USART_CR3_DMAT;
+    STM32F4_TELEMETRY_USART->CR1 = USART_CR1_TE | USART_CR1_UE;
+
+    /* DMA: memory to peripheral, bytes, memory increment, interrupt at the end of the transfer */
+    STM32F4_TELEMETRY_DMA_STREAM->CR &= ~DMA_SxCR_EN;
+    while ((STM32F4_TELEMETRY_DMA_STREAM->CR & DMA_SxCR_EN) != 0U)
+    {
+        /* Wait until the stream is disabled */
+    }
+    STM32F4_TELEMETRY_DMA_STREAM->PAR = (uint32_t)(uintptr_t)&STM32F4_TELEMETRY_USART->DR;
+    STM32F4_TELEMETRY_DMA_STREAM->CR = (STM32F4_TELEMETRY_DMA_CHANNEL << DMA_SxCR_CHSEL_Pos) | DMA_SxCR_MINC | DMA_SxCR_DIR_0 | DMA_SxCR_TCIE | DMA_SxCR_TEIE;
+    STM32F4_TELEMETRY_DMA_STREAM->FCR = 0; /* Direct mode */
+    DMA1->HIFCR = DMA_HIFCR_CTCIF6 | DMA_HIFCR_CHTIF6 | DMA_HIFCR_CTEIF6 | DMA_HIFCR_CDMEIF6 | DMA_HIFCR_CFEIF6;
+
+    NVIC_SetPriority(STM32F4_TELEMETRY_IRQ, NVIC_EncodePriority(NVIC_GetPriorityGrouping(), STM32F4_TELEMETRY_IRQ_PRIO, 0));
+    NVIC_ClearPendingIRQ(STM32F4_TELEMETRY_IRQ);
+    NVIC_EnableIRQ(STM32F4_TELEMETRY_IRQ);
+}
+
+void port_telemetry_hw_start_tx(const uint8_t *p_data, uint32_t length)
+{
+    DMA1->HIFCR = DMA_HIFCR_CTCIF6 | DMA_HIFCR_CHTIF6 | DMA_HIFCR_CTEIF6 | DMA_HIFCR_CDMEIF6 | DMA_HIFCR_CFEIF6;
+    STM32F4_TELEMETRY_DMA_STREAM->M0AR = (uint32_t)(uintptr_t)p_data;
+    STM32F4_TELEMETRY_DMA_STREAM->NDTR = length;
+    STM32F4_TELEMETRY_USART->SR &= ~USART_SR_TC;
+    STM32F4_TELEMETRY_DMA_STREAM->CR |= DMA_SxCR_EN;
+}
@@ -0,0 +1,61 @@
+/**
+ * @file stm32f4_timer.c
+ * @brief Hardware timer of the software timers for the STM32F4 platform.
+ * @date 2025-01-01
+ */
+
+/* HW dependent includes */
+#include "port_timer.h"
+#include "stm32f4_system.h"
+#include "stm32f4_timer.h"
+
+/* Global variables -----------------------------------------------------------*/
+static port_timer_wheel_t wheel; /*!< Software timers multiplexed on the timer */
+
+/* Public functions -----------------------------------------------------------*/
+void port_timer_hw_init(void)
+{
+    RCC->APB1ENR |= RCC_APB1ENR_TIM5EN; /* Enable the clock of the timer */
+
+    STM32F4_TIMER_TIM->CR1 &= ~TIM_CR1_CEN;
+    STM32F4_TIMER_TIM->DIER &= ~TIM_DIER_CC1IE;
+    STM32F4_TIMER_TIM->PSC = (SystemCoreClock / STM32F4_TIMER_FREQ_HZ) - 1U; /* 1 us per tick */
+    STM32F4_TIMER_TIM->ARR = 0xFFFFFFFFU;                                    /* Free-running over the 32 bits of the counter */
+    STM32F4_TIMER_TIM->CCMR1 &= ~(TIM_CCMR1_CC1S | TIM_CCMR1_OC1M);          /* Channel 1 as output compare, frozen output: it only raises the interrupt */
+    STM32F4_TIMER_TIM->CNT = 0;
+    STM32F4_TIMER_TIM->EGR = TIM_EGR_UG; /* Load the prescaler */
+    STM32F4_TIMER_TIM->SR = 0;
+
+    NVIC_SetPriority(STM32F4_TIMER_IRQ, NVIC_EncodePriority(NVIC_GetPriorityGrouping(), STM32F4_TIMER_IRQ_PRIO, 0));
+    NVIC_ClearPendingIRQ(STM32F4_TIMER_IRQ);
+    NVIC_EnableIRQ(STM32F4_TIMER_IRQ);
+
+    STM32F4_TIMER_TIM->CR1 |= TIM_CR1_CEN;
+}
+
+uint32_t port_timer_hw_get_micros(void)
+{
+    return STM32F4_TIMER_TIM->CNT;
+}
+
+void port_timer_hw_set_alarm(uint32_t at_us)
+{
+    STM32F4_TIMER_TIM->CCR1 = at_us;
+    STM32F4_TIMER_TIM->SR = ~TIM_SR_CC1IF; /* rc_w0: only the compare flag is cleared */
+    STM32F4_TIMER_TIM->DIER |= TIM_DIER_CC1IE;
+}
+
+void port_timer_hw_disable_alarm(void)
+{
+    STM32F4_TIMER_TIM->DIER &= ~TIM_DIER_CC1IE;
+}
+
+void port_timer_hw_trigger(void)
+{
+    NVIC_SetPendingIRQ(STM32F4_TIMER_IRQ);
+}
+
+port_timer_wheel_t *port_timer_hw_get_wheel(void)
+{
+    return &wheel;
+}
@@ -13,8 +13,10 @@
 /* HW dependent includes */
 #include "port_system.h"
 #include "port_ultrasound.h"
+#include "port_timer.h"
 #include "stm32f4_system.h"
 #include "stm32f4_ultrasound.h"
+#include "port_trace.h"
 
 /* Microcontroller dependent includes */
 /*Defines ----------------------------------------------------------------*/
@@ -23,7 +25,14 @@
 #define Arrmax 65535.0
 
 #define tick 1.0e+6
+
+#define STM32F4_ULTRASOUND_FLAG_TRIGGER_READY 0U /*!< Position of the trigger ready flag in the flag word of a sensor*/
+#define STM32F4_ULTRASOUND_FLAG_TRIGGER_END 1U   /*!< Position of the trigger end flag in the flag word of a sensor*/
+#define STM32F4_ULTRASOUND_FLAG_ECHO_RECEIVED 2U /*!< Position of the echo received flag in the flag word of a sensor*/
 /* Typedefs --------------------------------------------------------------------*/
+/**
+ * @brief Wiring of an ultrasound sensor. It is only used to configure the sensor: the state used in every measurement is in the packed arrays of `ultrasound_state`
+ */
 typedef struct
 {
     GPIO_TypeDef *p_trigger_port; /*!<GPIO where the trigger signal is connected*/
@@ -31,18 +40,25 @@ typedef struct
     uint8_t trigger_pin;          /*!<Pin/line where the trigger signal is connected*/
     uint8_t echo_pin;             /*!<Pin/line where the echo signal is connected*/
     uint8_t echo_alt_fun;         /*!< Alternate function for the echo signal*/
-    bool trigger_ready;           /*!< Flag to indicate that a new measurement can be started*/
-    bool trigger_end;             /*!<Flag to indicate that the trigger signal has been sent*/
-    bool echo_received;           /*!<Flag to indicate that the echo signal has been received*/
-    uint32_t echo_init_tick;      /*!<Tick time when the echo signal was received*/
-    uint32_t echo_end_tick;       /*!<Tick time  when the echo signal was received*/
-    uint32_t echo_overflows;      /*!<Number of overflows of the timer during the echo signal*/
-
 } stm32f4_ultrasound_hw_t;
 
 // Error porque hace falta asociar los pines y gpios
 /* Global variables */
-static stm32f4_ultrasound_hw_t ultrasound_arr[] = {[PORT_REAR_PARKING_SENSOR_ID] = {.p_echo_port = STM32F4_REAR_PARKING_SENSOR_ECHO_GPIO, .echo_pin = STM32F4_REAR_PARKING_SENSOR_ECHO_PIN, .p_trigger_port = STM32F4_REAR_PARKING_SENSOR_TRIGGER_GPIO, .trigger_pin = STM32F4_REAR_PARKING_SENSOR_TRIGGER_PIN,  .trigger_ready = false, .trigger_end = false, .echo_received = false, .echo_init_tick = 0, .echo_end_tick = 0, .echo_overflows = 0}};
+static stm32f4_ultrasound_hw_t ultrasound_arr[] = {[PORT_REAR_PARKING_SENSOR_ID] = {.p_echo_port = STM32F4_REAR_PARKING_SENSOR_ECHO_GPIO, .echo_pin = STM32F4_REAR_PARKING_SENSOR_ECHO_PIN, .p_trigger_port = STM32F4_REAR_PARKING_SENSOR_TRIGGER_GPIO, .trigger_pin = STM32F4_REAR_PARKING_SENSOR_TRIGGER_PIN}};
+
+#define STM32F4_ULTRASOUND_NUM_SENSORS (sizeof(ultrasound_arr) / sizeof(ultrasound_arr[0])) /*!< Number of ultrasound sensors*/
+
+/**
+ * @brief State of the ultrasound sensors used in every measurement, in packed arrays indexed by sensor (structure of arrays). The echo timer counts up to `PORT_PARKING_SENSOR_ECHO_TIMER_TICKS`, so its captures fit in 16 bits
+ */
+static struct
+{
+    volatile uint32_t flags_arr[STM32F4_ULTRASOUND_NUM_SENSORS];          /*!< Flags shared with the ISRs (trigger ready, trigger end and echo received). Accessed through the bit-band alias*/
+    uint16_t echo_init_tick_arr[STM32F4_ULTRASOUND_NUM_SENSORS];          /*!<Tick time when the echo signal was received*/
+    uint16_t echo_end_tick_arr[STM32F4_ULTRASOUND_NUM_SENSORS];           /*!<Tick time  when the echo signal was received*/
+    uint16_t echo_overflows_arr[STM32F4_ULTRASOUND_NUM_SENSORS];          /*!<Number of overflows of the timer during the echo signal (saturated)*/
+    port_timer_t measurement_timer_arr[STM32F4_ULTRASOUND_NUM_SENSORS];   /*!< Software timers that control the duration of the measurements*/
+} ultrasound_state;
 /* Private functions ----------------------------------------------------------*/
 
 /**
@@ -70,6 +86,25 @@ static stm32f4_ultrasound_hw_t ultrasound_arr[] = {[PORT_REAR_PARKING_SENSOR_ID]
      }
  }
 
+/**
+ * @brief Write a flag of an ultrasound sensor with a single atomic store
+ *
+ * @param ultrasound_id Ultrasound ID
+ * @param flag Position of the flag in the flag word
+ * @param value New value of the flag
+ */
+static inline void _stm32f4_ultrasound_write_flag(uint32_t ultrasound_id, uint8_t flag, bool value)
+{
+    if (value)
+    {
+        stm32f4_system_flag_set(&ultrasound_state.flags_arr[ultrasound_id], flag);
+    }
+    else
+    {
+        stm32f4_system_flag_clear(&ultrasound_state.flags_arr[ultrasound_id], flag);
+    }
+}
+
 static void _timer_trigger_setup()
 {
     // Importante no poner los valores de registro a mano.
@@ -173,52 +208,14 @@ static void _timer_trigger_setup()
      }
  }
 /**
- * @brief COnfigure the timer that controls the duration of the new measurement
- *
- * This function configures the timer to generate an internal
- * interrupt to control the duration of measurement
- *
+ * @brief Callback of the timer that controls the duration of the measurements. It runs in the interrupt of the software timers.
  *
+ * @param p_arg Pointer to the flag word of the ultrasound sensor
  */
-
- void _timer_new_measurement_setup()
- {
-     // Se siguen los mismos pasos que en el timer trigger setup
-     // pero para el timer que controla la duración de la nueva
-     // medida TIM5
- 
-     RCC->APB1ENR |= RCC_APB1ENR_TIM5EN;          /*<!Enable the clock of the timer
-             that controls the trigger signal*/
-     TIM5->CR1 &= ~TIM_CR1_CEN;                   /*<! Disable the counter of the timer*/
-     TIM5->CR1 |= TIM_CR1_ARPE;                   /*<!Enable the autoreload preload to
-                        enable the autoreload register*/
-     TIM5->CNT = 0;                       /*<! Counter of the timer to 0*/
-     
-    double psc_value = 0.0; /*<! Initial PSC value*/
-
-    double arr_value = round(((16.0 * 100.0* 1.0e3) / (psc_value + 1.0)) - 1.0); /*!< Re-computing the value of ARR register with the new PSC value */
-    
-    while (arr_value > 65535.0) {
-    psc_value += 1.0; /*<! Update the PSC value by a smaller increment */
-    arr_value = round(((16.0 * 100.0 * 1.0e3) / (psc_value + 1.0)) - 1.0); /*<! Re-computing the value of ARR register with the new PSC value */
-    }
-    
- 
-    TIM5->PSC = round(psc_value); /*!<value of PSC*/
-
-    TIM5->ARR = arr_value; /*!< value of PSC*/
-    TIM5->EGR = TIM_EGR_UG;/*!<Update event*/
-    TIM5->SR &= ~TIM_SR_UIF;    /*!<Clearing the update interrupt flag*/
-    
-
-
-    TIM5->DIER |= TIM_DIER_UIE; /*!<Enable tthe interrupts of the timer
-     by setting the UIE bit of the DIER register*/
-
-    NVIC_SetPriority(TIM5_IRQn, NVIC_EncodePriority(NVIC_GetPriorityGrouping(), 5, 0)); /*!<
-      Setting the priority of the time interrupt in the NVIC*/
+static void _stm32f4_ultrasound_measurement_timeout(void *p_arg)
+{
+    stm32f4_system_flag_set((volatile uint32_t *)p_arg, STM32F4_ULTRASOUND_FLAG_TRIGGER_READY); /*!< A new measurement can be started*/
 }
- 
 
 /* Public functions -----------------------------------------------------------*/
 void port_ultrasound_init(uint32_t ultrasound_id)
@@ -226,18 +223,18 @@ void port_ultrasound_init(uint32_t ultrasound_id)
     /* Get the ultrasound sensor */
     stm32f4_ultrasound_hw_t *p_ultrasound = _stm32f4_ultrasound_get(ultrasound_id);
     
-    p_ultrasound->echo_end_tick = 0;     /*!< Tick to 0 */
-    p_ultrasound->echo_init_tick = 0;    /*!< Tick to 0 */
-    p_ultrasound->trigger_end = false;   /*!< Flag to false */
-    p_ultrasound->echo_received = false; /*!< Flag to false*/
-    p_ultrasound->trigger_ready = true;  /*!< Flag to true*/
+    ultrasound_state.echo_end_tick_arr[ultrasound_id] = 0;     /*!< Tick to 0 */
+    ultrasound_state.echo_init_tick_arr[ultrasound_id] = 0;    /*!< Tick to 0 */
+    _stm32f4_ultrasound_write_flag(ultrasound_id, STM32F4_ULTRASOUND_FLAG_TRIGGER_END, false);   /*!< Flag to false */
+    _stm32f4_ultrasound_write_flag(ultrasound_id, STM32F4_ULTRASOUND_FLAG_ECHO_RECEIVED, false); /*!< Flag to false*/
+    _stm32f4_ultrasound_write_flag(ultrasound_id, STM32F4_ULTRASOUND_FLAG_TRIGGER_READY, true);  /*!< Flag to true*/
     stm32f4_system_gpio_config(p_ultrasound->p_trigger_port,p_ultrasound->trigger_pin,STM32F4_GPIO_MODE_OUT, STM32F4_GPIO_PUPDR_NOPULL);
     stm32f4_system_gpio_config(p_ultrasound->p_echo_port,p_ultrasound->echo_pin,STM32F4_GPIO_MODE_AF, STM32F4_GPIO_PUPDR_NOPULL);
     stm32f4_system_gpio_config_alternate(p_ultrasound->p_echo_port, p_ultrasound->echo_pin,1);
     _timer_trigger_setup();
     _timer_echo_setup(ultrasound_id);
-    _timer_new_measurement_setup();
-    p_ultrasound ->echo_overflows=0; 
+    port_timer_setup(&ultrasound_state.measurement_timer_arr[ultrasound_id], _stm32f4_ultrasound_measurement_timeout, (void *)&ultrasound_state.flags_arr[ultrasound_id]);
+    ultrasound_state.echo_overflows_arr[ultrasound_id] = 0; 
     
 }
 
@@ -267,32 +264,31 @@ void port_ultrasound_start_measurement(uint32_t ultrasound_id)
     if (_stm32f4_ultrasound_get(ultrasound_id) != NULL)
     {
 
-        stm32f4_ultrasound_hw_t *p_ultrasound = _stm32f4_ultrasound_get(ultrasound_id);
-        p_ultrasound->trigger_ready = false;
+        port_system_enter_critical(); /*!< The measurement timer must not set trigger_ready while the timers are being restarted*/
+        _stm32f4_ultrasound_write_flag(ultrasound_id, STM32F4_ULTRASOUND_FLAG_TRIGGER_READY, false);
         TIM3->CNT = 0;  /*!<Reset the counter CNT of the trigger timer*/
         TIM2->CNT = 0;  /*!<Reset the counter CNT of the echo timer*/
-        TIM5->CNT = 0;  /*!<Reset the counter CNT of the new measurement time*/
         GPIOB->BSRR = (1 << 0); /*!< Set the trigger pin to high*/
         /*!< Enable the timers interrupts*/
         NVIC_EnableIRQ(TIM2_IRQn);
         NVIC_EnableIRQ(TIM3_IRQn);
-        NVIC_EnableIRQ(TIM5_IRQn);
         /*!<Enable the timers*/
         // MIRAR...
 
         TIM3->CR1 |= (1 << 0);
         TIM2->CR1 |= (1 << 0);
-        TIM5->CR1 |= (1 << 0);
+        port_timer_start(&ultrasound_state.measurement_timer_arr[ultrasound_id], PORT_PARKING_SENSOR_TIMEOUT_US, PORT_PARKING_SENSOR_TIMEOUT_US); /*!< Restart the period of the measurements*/
+        port_system_exit_critical();
+        PORT_TRACE_RECORD(PORT_TRACE_TRIGGER, ultrasound_id, 0, 0);
     }
 }
 
 void port_ultrasound_reset_echo_ticks(uint32_t ultrasound_id)
 {
-    stm32f4_ultrasound_hw_t *p_ultrasound = _stm32f4_ultrasound_get(ultrasound_id);
-    p_ultrasound->echo_init_tick = 0;
-    p_ultrasound->echo_end_tick = 0;
-    p_ultrasound->echo_overflows=0;
-    p_ultrasound->echo_received = false;
+    ultrasound_state.echo_init_tick_arr[ultrasound_id] = 0;
+    ultrasound_state.echo_end_tick_arr[ultrasound_id] = 0;
+    ultrasound_state.echo_overflows_arr[ultrasound_id] = 0;
+    _stm32f4_ultrasound_write_flag(ultrasound_id, STM32F4_ULTRASOUND_FLAG_ECHO_RECEIVED, false);
 }
 
 void port_ultrasound_stop_echo_timer(uint32_t ultrasound_id)
@@ -303,11 +299,21 @@ void port_ultrasound_stop_echo_timer(uint32_t ultrasound_id)
     }
 }
 
-void port_ultrasound_stop_new_measurement_timer()
+uint32_t port_ultrasound_start_new_measurement_timer(void)
 {
+    for (uint32_t i = 0; i < STM32F4_ULTRASOUND_NUM_SENSORS; i++)
+    {
+        port_timer_start(&ultrasound_state.measurement_timer_arr[i], PORT_PARKING_SENSOR_TIMEOUT_US, PORT_PARKING_SENSOR_TIMEOUT_US);
+    }
+    return 0;
+}
 
-        TIM5->CR1 = (0 << 1);
-    
+void port_ultrasound_stop_new_measurement_timer()
+{
+    for (uint32_t i = 0; i < STM32F4_ULTRASOUND_NUM_SENSORS; i++)
+    {
+        port_timer_cancel(&ultrasound_state.measurement_timer_arr[i]);
+    }
 }
 
 void port_ultrasound_stop_trigger_timer(uint32_t ultrasound_id)
@@ -321,20 +327,26 @@ void port_ultrasound_stop_ultrasound(uint32_t ultrasound_id)
 {
     if (_stm32f4_ultrasound_get(ultrasound_id) != NULL)
     {
+        port_system_enter_critical();
         port_ultrasound_stop_trigger_timer(ultrasound_id);
         port_ultrasound_stop_new_measurement_timer();
         port_ultrasound_stop_echo_timer(ultrasound_id);
         port_ultrasound_reset_echo_ticks(ultrasound_id);
+        port_system_exit_critical();
     }
 }
 
 /*Getters and setters functions-------------------------------------**/
 
+bool port_ultrasound_get_measurement_timer_running(uint32_t ultrasound_id)
+{
+    return port_timer_is_armed(&ultrasound_state.measurement_timer_arr[ultrasound_id]);
+}
+
 bool port_ultrasound_get_trigger_ready(uint32_t ultrasound_id)
 {
     
-        stm32f4_ultrasound_hw_t *p_ultrasound = _stm32f4_ultrasound_get(ultrasound_id);
-        return p_ultrasound->trigger_ready;
+        return stm32f4_system_flag_test(&ultrasound_state.flags_arr[ultrasound_id], STM32F4_ULTRASOUND_FLAG_TRIGGER_READY);
    
 
     
@@ -343,81 +355,70 @@ bool port_ultrasound_get_trigger_ready(uint32_t ultrasound_id)
 bool port_ultrasound_get_trigger_end(uint32_t ultrasound_id)
 {
     
-        stm32f4_ultrasound_hw_t *p_ultrasound = _stm32f4_ultrasound_get(ultrasound_id);
-        return p_ultrasound->trigger_end;
+        return stm32f4_system_flag_test(&ultrasound_state.flags_arr[ultrasound_id], STM32F4_ULTRASOUND_FLAG_TRIGGER_END);
     
 }
 bool port_ultrasound_get_echo_received(uint32_t ultrasound_id)
 {
    
-        stm32f4_ultrasound_hw_t *p_ultrasound = _stm32f4_ultrasound_get(ultrasound_id);
-        return p_ultrasound->echo_received;
+        return stm32f4_system_flag_test(&ultrasound_state.flags_arr[ultrasound_id], STM32F4_ULTRASOUND_FLAG_ECHO_RECEIVED);
     
 }
 uint32_t port_ultrasound_get_echo_overflows(uint32_t ultrasound_id)
 {
     
-        stm32f4_ultrasound_hw_t *p_ultrasound = _stm32f4_ultrasound_get(ultrasound_id);
-        return p_ultrasound->echo_overflows;
+        return ultrasound_state.echo_overflows_arr[ultrasound_id];
    
 }
 uint32_t port_ultrasound_get_echo_init_tick(uint32_t ultrasound_id)
 {
     
-        stm32f4_ultrasound_hw_t *p_ultrasound = _stm32f4_ultrasound_get(ultrasound_id);
-        return p_ultrasound->echo_init_tick;
+        return ultrasound_state.echo_init_tick_arr[ultrasound_id];
     
 }
 
 uint32_t port_ultrasound_get_echo_end_tick(uint32_t ultrasound_id)
 {
     
-        stm32f4_ultrasound_hw_t *p_ultrasound = _stm32f4_ultrasound_get(ultrasound_id);
-        return p_ultrasound->echo_end_tick;
+        return ultrasound_state.echo_end_tick_arr[ultrasound_id];
     
 }
 
 void port_ultrasound_set_echo_end_tick(uint32_t ultrasound_id, uint32_t echo_end_tick)
 {
     
-        stm32f4_ultrasound_hw_t *p_ultrasound = _stm32f4_ultrasound_get(ultrasound_id);
-        p_ultrasound->echo_end_tick = echo_end_tick;
+        ultrasound_state.echo_end_tick_arr[ultrasound_id] = (uint16_t)echo_end_tick; /*!< A capture of the echo timer (16 bits)*/
     
 }
 void port_ultrasound_set_echo_init_tick(uint32_t ultrasound_id, uint32_t echo_init_tick)
 {
-        stm32f4_ultrasound_hw_t *p_ultrasound = _stm32f4_ultrasound_get(ultrasound_id);
-        p_ultrasound->echo_init_tick = echo_init_tick;
+        ultrasound_state.echo_init_tick_arr[ultrasound_id] = (uint16_t)echo_init_tick; /*!< A capture of the echo timer (16 bits)*/
     
 }
 void port_ultrasound_set_echo_received(uint32_t ultrasound_id, bool echo_received)
 {
     
-        stm32f4_ultrasound_hw_t *p_ultrasound = _stm32f4_ultrasound_get(ultrasound_id);
-        p_ultrasound->echo_received = echo_received;
+        _stm32f4_ultrasound_write_flag(ultrasound_id, STM32F4_ULTRASOUND_FLAG_ECHO_RECEIVED, echo_received);
     
 }
 
 void port_ultrasound_set_trigger_ready(uint32_t ultrasound_id, bool trigger_ready)
 {
     
-        stm32f4_ultrasound_hw_t *p_ultrasound = _stm32f4_ultrasound_get(ultrasound_id);
-        p_ultrasound->trigger_ready = trigger_ready;
+        _stm32f4_ultrasound_write_flag(ultrasound_id, STM32F4_ULTRASOUND_FLAG_TRIGGER_READY, trigger_ready);
     
 }
 
 void port_ultrasound_set_trigger_end(uint32_t ultrasound_id, bool trigger_end)
 {
     
-        stm32f4_ultrasound_hw_t *p_ultrasound = _stm32f4_ultrasound_get(ultrasound_id);
-        p_ultrasound->trigger_end = trigger_end;
+        _stm32f4_ultrasound_write_flag(ultrasound_id, STM32F4_ULTRASOUND_FLAG_TRIGGER_END, trigger_end);
     
 }
 
 void port_ultrasound_set_echo_overflows(uint32_t ultrasound_id, uint32_t echo_overflows)
 {
     
-        stm32f4_ultrasound_hw_t *p_ultrasound = _stm32f4_ultrasound_get(ultrasound_id);
-        p_ultrasound->echo_overflows = echo_overflows;
+        ultrasound_state.echo_overflows_arr[ultrasound_id] = (echo_overflows > UINT16_MAX) ? UINT16_MAX : (uint16_t)echo_overflows;
     
 }
\ No newline at end of file
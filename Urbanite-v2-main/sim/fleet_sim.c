@@ -0,0 +1,588 @@
+/**
+ * @file fleet_sim.c
+ * @brief Simulator of a fleet of Urbanite units in the native (host) platform.
+ *
+ * Every unit is a simulated unit of the native port (see native_instance.h) with its own button and ultrasound FSMs (the ultrasound ones in a bank of the unit, see fsm_ultrasound_new_in_bank()), driven by a pseudo-random scenario: the distance to the obstacle changes every few seconds and the driver presses the button from time to time. The units run in slices of virtual time on a pool of threads with work stealing: each thread keeps its units in a Chase-Lev deque, runs them from the bottom and pushes them back after each slice, and an idle thread steals units from the top of the deque of another thread. The virtual time does not depend on the thread that runs a slice, so the results of a seed are the same with any number of threads.
+ *
+ * `fleet_sim [-u units] [-d seconds] [-t threads] [-s seed] [-j]`
+ *
+ * At the end it prints the statistics of the fleet (as JSON with `-j`) and the throughput of the simulator in unit-hours of virtual time per second of real time.
+ *
+ * The logger, the telemetry and the opt-in diagnostics of the port are shared by all the units, so they must not be enabled in the fleet.
+ *
+ * @date 2025-01-01
+ */
+
+/* Includes ------------------------------------------------------------------*/
+#define _POSIX_C_SOURCE 200809L /* clock_gettime(), getopt() and sysconf() */
+
+/* Standard C includes */
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdatomic.h>
+#include <inttypes.h>
+#include <pthread.h>
+#include <sched.h>
+#include <time.h>
+#include <unistd.h>
+
+/* HW dependent includes */
+#include "port_button.h"
+#include "port_ultrasound.h"
+#include "native_system.h"
+#include "native_button.h"
+#include "native_ultrasound.h"
+#include "native_instance.h"
+
+/* Project includes */
+#include "fsm_button.h"
+#include "fsm_ultrasound.h"
+
+/* Defines and enums ----------------------------------------------------------*/
+#define FLEET_SIM_DEFAULT_UNITS 1000U        /*!< Units of the fleet by default */
+#define FLEET_SIM_DEFAULT_DURATION_S 3600U   /*!< Virtual time simulated per unit by default */
+#define FLEET_SIM_DEFAULT_SEED 1U            /*!< Seed of the scenarios by default */
+#define FLEET_SIM_SLICE_MS 60000U            /*!< Virtual time of a unit run in a row before it goes back to the deque */
+#define FLEET_SIM_MIN_DISTANCE_CM 5U         /*!< Closest obstacle of the scenarios */
+#define FLEET_SIM_MAX_DISTANCE_CM 300U       /*!< Farthest obstacle of the scenarios */
+#define FLEET_SIM_MIN_SEGMENT_MS 1000U       /*!< Shortest time with the same obstacle */
+#define FLEET_SIM_MAX_SEGMENT_MS 10000U      /*!< Longest time with the same obstacle */
+#define FLEET_SIM_MIN_PRESS_GAP_MS 5000U     /*!< Shortest time between two presses of the button */
+#define FLEET_SIM_MAX_PRESS_GAP_MS 60000U    /*!< Longest time between two presses of the button */
+#define FLEET_SIM_MIN_PRESS_MS 200U          /*!< Shortest press of the button. Longer than the anti-debounce time */
+#define FLEET_SIM_MAX_PRESS_MS 3000U         /*!< Longest press of the button */
+#define FLEET_SIM_STEAL_ATTEMPTS 4U          /*!< Victims tried by an idle thread before it yields */
+
+/* Typedefs --------------------------------------------------------------------*/
+/**
+ * @brief Statistics of a part of the fleet. Each thread keeps its own ones, which are added at the end
+ */
+typedef struct
+{
+    uint64_t measurements;   /*!< Medians read from the ultrasound FSMs */
+    uint64_t exact;          /*!< Medians equal to the distance of the scenario */
+    uint64_t abs_error_cm;   /*!< Sum of the absolute errors of the medians, in cm */
+    uint64_t zone_changes;   /*!< Changes of the proximity zone notified by the ultrasound FSMs */
+    uint64_t presses;        /*!< Presses of the button in the scenarios */
+    uint64_t presses_seen;   /*!< Presses reported by the button FSMs */
+    uint64_t slices;         /*!< Slices of virtual time run */
+    uint64_t steals;         /*!< Units stolen from another thread */
+} fleet_sim_stats_t;
+
+/**
+ * @brief Virtual Urbanite
+ */
+typedef struct
+{
+    native_instance_t *p_instance;    /*!< Simulated unit of the native port */
+    fsm_ultrasound_bank_t *p_bank;    /*!< Bank of the ultrasound FSMs of the unit, so units run by different threads do not share one */
+    fsm_button_t *p_fsm_button;       /*!< Button FSM of the unit */
+    fsm_ultrasound_t *p_fsm_rear;     /*!< Rear ultrasound FSM of the unit */
+    uint64_t rng;                     /*!< State of the generator of the scenario */
+    uint32_t now_ms;                  /*!< Virtual time simulated */
+    uint32_t distance_cm;             /*!< Distance to the obstacle in the scenario */
+    uint32_t next_distance_ms;        /*!< Virtual time of the next change of the obstacle */
+    uint32_t next_press_ms;           /*!< Virtual time of the next press of the button */
+    uint32_t release_ms;              /*!< Virtual time of the release of the button */
+    uint32_t zone_changes;            /*!< Changes of the proximity zone notified in the current slice */
+    bool pressed;                     /*!< The button is pressed in the scenario */
+} fleet_sim_unit_t;
+
+/**
+ * @brief Chase-Lev work-stealing deque of units, with a fixed capacity. Only its owner pushes and pops at the bottom; any thread steals from the top
+ */
+typedef struct
+{
+    _Atomic int64_t top;                     /*!< Index of the oldest unit. Advanced by the steals */
+    _Atomic int64_t bottom;                  /*!< Index of the next free slot. Written only by the owner */
+    _Atomic(fleet_sim_unit_t *) *p_slots;    /*!< Circular buffer of units */
+    int64_t mask;                            /*!< Capacity of the buffer minus one (the capacity is a power of 2) */
+} fleet_sim_deque_t;
+
+/**
+ * @brief Worker thread of the pool
+ */
+typedef struct
+{
+    pthread_t thread;          /*!< Thread of the worker */
+    uint32_t id;               /*!< Index of the worker in the pool */
+    uint64_t rng;              /*!< State of the generator of the victims */
+    fleet_sim_deque_t deque;   /*!< Units of the worker */
+    fleet_sim_stats_t stats;   /*!< Statistics of the slices run by the worker */
+} fleet_sim_worker_t;
+
+/* Global variables -----------------------------------------------------------*/
+static fleet_sim_worker_t *workers_arr;    /*!< Pool of workers */
+static uint32_t num_workers;               /*!< Workers of the pool */
+static uint32_t duration_ms;               /*!< Virtual time simulated per unit */
+static _Atomic uint32_t units_left;        /*!< Units that have not finished their scenario */
+
+/* Private functions ----------------------------------------------------------*/
+/**
+ * @brief Next number of a xorshift64* generator
+ *
+ * @param p_state Pointer to the state of the generator. It must not be 0
+ * @return Pseudo-random number
+ */
+static uint64_t _fleet_sim_rand(uint64_t *p_state)
+{
+    uint64_t x = *p_state;
+    x ^= x >> 12;
+    x ^= x << 25;
+    x ^= x >> 27;
+    *p_state = x;
+    return x * 0x2545F4914F6CDD1DULL;
+}
+
+/**
+ * @brief Pseudo-random number in a range
+ *
+ * @param p_state Pointer to the state of the generator
+ * @param min Lowest value
+ * @param max Highest value
+ * @return Number in [min, max]
+ */
+static uint32_t _fleet_sim_rand_range(uint64_t *p_state, uint32_t min, uint32_t max)
+{
+    return min + (uint32_t)(_fleet_sim_rand(p_state) % (uint64_t)(max - min + 1U));
+}
+
+/**
+ * @brief Initialize an empty deque
+ *
+ * @param p_deque Pointer to the deque
+ * @param capacity Units that fit in the deque. Rounded up to a power of 2
+ * @return true if there is memory for the deque
+ */
+static bool _fleet_sim_deque_init(fleet_sim_deque_t *p_deque, uint32_t capacity)
+{
+    int64_t size = 1;
+    while (size < (int64_t)capacity)
+    {
+        size <<= 1;
+    }
+    p_deque->p_slots = calloc((size_t)size, sizeof(*p_deque->p_slots));
+    p_deque->mask = size - 1;
+    atomic_init(&p_deque->top, 0);
+    atomic_init(&p_deque->bottom, 0);
+    return p_deque->p_slots != NULL;
+}
+
+/**
+ * @brief Push a unit at the bottom of the deque. Only the owner of the deque calls it. The capacity is the size of the fleet, so it never overflows
+ *
+ * @param p_deque Pointer to the deque
+ * @param p_unit Pointer to the unit
+ */
+static void _fleet_sim_deque_push(fleet_sim_deque_t *p_deque, fleet_sim_unit_t *p_unit)
+{
+    int64_t b = atomic_load_explicit(&p_deque->bottom, memory_order_relaxed);
+    atomic_store_explicit(&p_deque->p_slots[b & p_deque->mask], p_unit, memory_order_relaxed);
+    atomic_thread_fence(memory_order_release);
+    atomic_store_explicit(&p_deque->bottom, b + 1, memory_order_relaxed);
+}
+
+/**
+ * @brief Pop the unit at the bottom of the deque. Only the owner of the deque calls it
+ *
+ * @param p_deque Pointer to the deque
+ * @return Pointer to the unit. NULL if the deque is empty or a thief took its last unit
+ */
+static fleet_sim_unit_t *_fleet_sim_deque_pop(fleet_sim_deque_t *p_deque)
+{
+    int64_t b = atomic_load_explicit(&p_deque->bottom, memory_order_relaxed) - 1;
+    atomic_store_explicit(&p_deque->bottom, b, memory_order_relaxed);
+    atomic_thread_fence(memory_order_seq_cst);
+    int64_t t = atomic_load_explicit(&p_deque->top, memory_order_relaxed);
+    fleet_sim_unit_t *p_unit = NULL;
+
+    if (t <= b)
+    {
+        p_unit = atomic_load_explicit(&p_deque->p_slots[b & p_deque->mask], memory_order_relaxed);
+        if (t == b)
+        {
+            /* Last unit: race with the thieves for it */
+            if (!atomic_compare_exchange_strong_explicit(&p_deque->top, &t, t + 1, memory_order_seq_cst, memory_order_relaxed))
+            {
+                p_unit = NULL;
+            }
+            atomic_store_explicit(&p_deque->bottom, b + 1, memory_order_relaxed);
+        }
+    }
+    else
+    {
+        atomic_store_explicit(&p_deque->bottom, b + 1, memory_order_relaxed);
+    }
+    return p_unit;
+}
+
+/**
+ * @brief Steal the unit at the top of the deque of another thread
+ *
+ * @param p_deque Pointer to the deque
+ * @return Pointer to the unit. NULL if the deque is empty or another thread took the unit first
+ */
+static fleet_sim_unit_t *_fleet_sim_deque_steal(fleet_sim_deque_t *p_deque)
+{
+    int64_t t = atomic_load_explicit(&p_deque->top, memory_order_acquire);
+    atomic_thread_fence(memory_order_seq_cst);
+    int64_t b = atomic_load_explicit(&p_deque->bottom, memory_order_acquire);
+
+    if (t < b)
+    {
+        fleet_sim_unit_t *p_unit = atomic_load_explicit(&p_deque->p_slots[t & p_deque->mask], memory_order_relaxed);
+        if (atomic_compare_exchange_strong_explicit(&p_deque->top, &t, t + 1, memory_order_seq_cst, memory_order_relaxed))
+        {
+            return p_unit;
+        }
+    }
+    return NULL;
+}
+
+/**
+ * @brief Duration of the echo of an obstacle, rounded up so that the ultrasound FSM measures the distance exactly
+ *
+ * @param distance_cm Distance to the obstacle
+ * @return Duration of the echo in microseconds
+ */
+static uint32_t _fleet_sim_echo_us(uint32_t distance_cm)
+{
+    return (distance_cm * 2U * 10000U + SPEED_OF_SOUND_MS - 1U) / SPEED_OF_SOUND_MS;
+}
+
+/**
+ * @brief Count a change of the proximity zone of the rear sensor of a unit. Called by its ultrasound FSM, in the thread that runs the unit
+ *
+ * @param p_fsm Pointer to the ultrasound FSM
+ * @param zone New zone
+ * @param p_arg Pointer to the unit
+ */
+static void _fleet_sim_zone_changed(fsm_ultrasound_t *p_fsm, fsm_ultrasound_zone_t zone, void *p_arg)
+{
+    ((fleet_sim_unit_t *)p_arg)->zone_changes++;
+}
+
+/**
+ * @brief Create a unit and start its FSMs. The unit is selected in the calling thread
+ *
+ * @param p_unit Pointer to the unit
+ * @param seed Seed of the scenario of the unit
+ * @return true if there is memory for the unit
+ */
+static bool _fleet_sim_unit_init(fleet_sim_unit_t *p_unit, uint64_t seed)
+{
+    p_unit->p_instance = native_instance_new();
+    p_unit->p_bank = fsm_ultrasound_bank_new();
+    if ((p_unit->p_instance == NULL) || (p_unit->p_bank == NULL))
+    {
+        native_instance_destroy(p_unit->p_instance);
+        fsm_ultrasound_bank_destroy(p_unit->p_bank);
+        p_unit->p_instance = NULL;
+        return false;
+    }
+    native_instance_select(p_unit->p_instance);
+    native_system_reset(); /* The logger is shared: port_system_init() would reset it for every unit */
+
+    p_unit->rng = (seed != 0) ? seed : 1U;
+    p_unit->now_ms = 0;
+    p_unit->distance_cm = _fleet_sim_rand_range(&p_unit->rng, FLEET_SIM_MIN_DISTANCE_CM, FLEET_SIM_MAX_DISTANCE_CM);
+    p_unit->next_distance_ms = _fleet_sim_rand_range(&p_unit->rng, FLEET_SIM_MIN_SEGMENT_MS, FLEET_SIM_MAX_SEGMENT_MS);
+    p_unit->next_press_ms = _fleet_sim_rand_range(&p_unit->rng, FLEET_SIM_MIN_PRESS_GAP_MS, FLEET_SIM_MAX_PRESS_GAP_MS);
+    p_unit->release_ms = 0;
+    p_unit->pressed = false;
+    p_unit->zone_changes = 0;
+
+    p_unit->p_fsm_button = fsm_button_new(PORT_PARKING_BUTTON_DEBOUNCE_TIME_MS, PORT_PARKING_BUTTON_ID);
+    p_unit->p_fsm_rear = fsm_ultrasound_new_in_bank(p_unit->p_bank, PORT_REAR_PARKING_SENSOR_ID);
+    native_ultrasound_set_echo_us(PORT_REAR_PARKING_SENSOR_ID, _fleet_sim_echo_us(p_unit->distance_cm));
+    fsm_ultrasound_set_zone_callback(p_unit->p_fsm_rear, _fleet_sim_zone_changed, p_unit);
+    fsm_ultrasound_start(p_unit->p_fsm_rear);
+
+    native_instance_select(NULL);
+    return true;
+}
+
+/**
+ * @brief Free a unit and its FSMs
+ *
+ * @param p_unit Pointer to the unit
+ */
+static void _fleet_sim_unit_destroy(fleet_sim_unit_t *p_unit)
+{
+    if (p_unit->p_instance != NULL)
+    {
+        fsm_button_destroy(p_unit->p_fsm_button);
+        fsm_ultrasound_destroy(p_unit->p_fsm_rear);
+        fsm_ultrasound_bank_destroy(p_unit->p_bank);
+        native_instance_destroy(p_unit->p_instance);
+    }
+}
+
+/**
+ * @brief Run a slice of the scenario of a unit, one millisecond of virtual time at a time, as the main loop of the Urbanite
+ *
+ * @param p_unit Pointer to the unit
+ * @param p_stats Pointer to the statistics of the calling thread
+ */
+static void _fleet_sim_unit_run_slice(fleet_sim_unit_t *p_unit, fleet_sim_stats_t *p_stats)
+{
+    uint32_t end_ms = p_unit->now_ms + FLEET_SIM_SLICE_MS;
+    if (end_ms > duration_ms)
+    {
+        end_ms = duration_ms;
+    }
+
+    native_instance_select(p_unit->p_instance);
+    for (; p_unit->now_ms < end_ms; p_unit->now_ms++)
+    {
+        /* Scenario */
+        if (p_unit->now_ms == p_unit->next_distance_ms)
+        {
+            p_unit->distance_cm = _fleet_sim_rand_range(&p_unit->rng, FLEET_SIM_MIN_DISTANCE_CM, FLEET_SIM_MAX_DISTANCE_CM);
+            p_unit->next_distance_ms += _fleet_sim_rand_range(&p_unit->rng, FLEET_SIM_MIN_SEGMENT_MS, FLEET_SIM_MAX_SEGMENT_MS);
+            native_ultrasound_set_echo_us(PORT_REAR_PARKING_SENSOR_ID, _fleet_sim_echo_us(p_unit->distance_cm));
+        }
+        if (!p_unit->pressed && (p_unit->now_ms == p_unit->next_press_ms))
+        {
+            p_unit->pressed = true;
+            p_unit->release_ms = p_unit->now_ms + _fleet_sim_rand_range(&p_unit->rng, FLEET_SIM_MIN_PRESS_MS, FLEET_SIM_MAX_PRESS_MS);
+            native_button_set_value(PORT_PARKING_BUTTON_ID, false); /* Active low */
+            p_stats->presses++;
+        }
+        else if (p_unit->pressed && (p_unit->now_ms == p_unit->release_ms))
+        {
+            p_unit->pressed = false;
+            p_unit->next_press_ms = p_unit->now_ms + _fleet_sim_rand_range(&p_unit->rng, FLEET_SIM_MIN_PRESS_GAP_MS, FLEET_SIM_MAX_PRESS_GAP_MS);
+            native_button_set_value(PORT_PARKING_BUTTON_ID, true);
+        }
+
+        /* Urbanite */
+        native_system_advance_ms(1);
+        fsm_button_fire(p_unit->p_fsm_button);
+        fsm_ultrasound_fire(p_unit->p_fsm_rear);
+
+        if (fsm_button_get_duration(p_unit->p_fsm_button) > 0)
+        {
+            p_stats->presses_seen++;
+            fsm_button_reset_duration(p_unit->p_fsm_button);
+        }
+        if (fsm_ultrasound_get_new_measurement_ready(p_unit->p_fsm_rear))
+        {
+            uint32_t distance_cm = fsm_ultrasound_get_distance(p_unit->p_fsm_rear);
+            uint32_t error_cm = (distance_cm > p_unit->distance_cm) ? (distance_cm - p_unit->distance_cm) : (p_unit->distance_cm - distance_cm);
+            p_stats->measurements++;
+            p_stats->exact += (error_cm == 0) ? 1U : 0U;
+            p_stats->abs_error_cm += error_cm;
+        }
+    }
+    native_instance_select(NULL);
+    p_stats->zone_changes += p_unit->zone_changes;
+    p_unit->zone_changes = 0;
+    p_stats->slices++;
+}
+
+/**
+ * @brief Get a unit to run: from the bottom of the own deque or, if it is empty, from the top of the deque of another worker
+ *
+ * @param p_worker Pointer to the calling worker
+ * @return Pointer to the unit. NULL if no unit was found
+ */
+static fleet_sim_unit_t *_fleet_sim_worker_get_unit(fleet_sim_worker_t *p_worker)
+{
+    fleet_sim_unit_t *p_unit = _fleet_sim_deque_pop(&p_worker->deque);
+    for (uint32_t i = 0; (p_unit == NULL) && (num_workers > 1) && (i < FLEET_SIM_STEAL_ATTEMPTS); i++)
+    {
+        uint32_t victim = _fleet_sim_rand_range(&p_worker->rng, 0, num_workers - 2U);
+        victim += (victim >= p_worker->id) ? 1U : 0U; /* Any worker but the caller */
+        p_unit = _fleet_sim_deque_steal(&workers_arr[victim].deque);
+        p_worker->stats.steals += (p_unit != NULL) ? 1U : 0U;
+    }
+    return p_unit;
+}
+
+/**
+ * @brief Main function of a worker: run slices of units until all the scenarios are finished
+ *
+ * @param p_arg Pointer to the worker
+ * @return NULL
+ */
+static void *_fleet_sim_worker_main(void *p_arg)
+{
+    fleet_sim_worker_t *p_worker = (fleet_sim_worker_t *)p_arg;
+
+    while (atomic_load_explicit(&units_left, memory_order_acquire) > 0)
+    {
+        fleet_sim_unit_t *p_unit = _fleet_sim_worker_get_unit(p_worker);
+        if (p_unit == NULL)
+        {
+            sched_yield();
+            continue;
+        }
+        _fleet_sim_unit_run_slice(p_unit, &p_worker->stats);
+        if (p_unit->now_ms < duration_ms)
+        {
+            _fleet_sim_deque_push(&p_worker->deque, p_unit);
+        }
+        else
+        {
+            atomic_fetch_sub_explicit(&units_left, 1U, memory_order_release);
+        }
+    }
+    return NULL;
+}
+
+/**
+ * @brief Real time elapsed since an arbitrary point
+ *
+ * @return Time in seconds
+ */
+static double _fleet_sim_wall_s(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec / 1e9;
+}
+
+/**
+ * @brief Print the usage of the simulator
+ *
+ * @param p_name Name of the executable
+ */
+static void _fleet_sim_usage(const char *p_name)
+{
+    fprintf(stderr, "Usage: %s [-u units] [-d seconds] [-t threads] [-s seed] [-j]\n", p_name);
+    fprintf(stderr, "  -u  Units of the fleet (default %u)\n", FLEET_SIM_DEFAULT_UNITS);
+    fprintf(stderr, "  -d  Virtual time simulated per unit, in seconds (default %u)\n", FLEET_SIM_DEFAULT_DURATION_S);
+    fprintf(stderr, "  -t  Threads of the pool (default: one per online CPU)\n");
+    fprintf(stderr, "  -s  Seed of the scenarios (default %u)\n", FLEET_SIM_DEFAULT_SEED);
+    fprintf(stderr, "  -j  Print the results as JSON\n");
+}
+
+int main(int argc, char *argv[])
+{
+    uint32_t num_units = FLEET_SIM_DEFAULT_UNITS;
+    uint32_t duration_s = FLEET_SIM_DEFAULT_DURATION_S;
+    uint64_t seed = FLEET_SIM_DEFAULT_SEED;
+    bool json = false;
+    long online_cpus = sysconf(_SC_NPROCESSORS_ONLN);
+    num_workers = (online_cpus > 0) ? (uint32_t)online_cpus : 1U;
+
+    int opt;
+    while ((opt = getopt(argc, argv, "u:d:t:s:jh")) != -1)
+    {
+        switch (opt)
+        {
+        case 'u':
+            num_units = (uint32_t)strtoul(optarg, NULL, 0);
+            break;
+        case 'd':
+            duration_s = (uint32_t)strtoul(optarg, NULL, 0);
+            break;
+        case 't':
+            num_workers = (uint32_t)strtoul(optarg, NULL, 0);
+            break;
+        case 's':
+            seed = strtoull(optarg, NULL, 0);
+            break;
+        case 'j':
+            json = true;
+            break;
+        default:
+            _fleet_sim_usage(argv[0]);
+            return EXIT_FAILURE;
+        }
+    }
+    if ((num_units == 0) || (duration_s == 0) || (num_workers == 0) || (duration_s > UINT32_MAX / 1000U))
+    {
+        _fleet_sim_usage(argv[0]);
+        return EXIT_FAILURE;
+    }
+    duration_ms = duration_s * 1000U;
+
+    /* Fleet: the units are dealt to the workers in turn */
+    fleet_sim_unit_t *units_arr = calloc(num_units, sizeof(fleet_sim_unit_t));
+    workers_arr = calloc(num_workers, sizeof(fleet_sim_worker_t));
+    bool ok = (units_arr != NULL) && (workers_arr != NULL);
+    for (uint32_t i = 0; ok && (i < num_workers); i++)
+    {
+        workers_arr[i].id = i;
+        workers_arr[i].rng = seed ^ (0x9E3779B97F4A7C15ULL * (i + 1U));
+        ok = _fleet_sim_deque_init(&workers_arr[i].deque, num_units);
+    }
+    for (uint32_t i = 0; ok && (i < num_units); i++)
+    {
+        uint64_t unit_seed = seed * 0x100000001B3ULL + i;
+        ok = _fleet_sim_unit_init(&units_arr[i], _fleet_sim_rand(&unit_seed));
+        if (ok)
+        {
+            _fleet_sim_deque_push(&workers_arr[i % num_workers].deque, &units_arr[i]);
+        }
+    }
+    if (!ok)
+    {
+        fprintf(stderr, "fleet_sim: not enough memory for %u units\n", num_units);
+        return EXIT_FAILURE;
+    }
+    atomic_store(&units_left, num_units);
+
+    /* Simulation */
+    double start_s = _fleet_sim_wall_s();
+    for (uint32_t i = 0; i < num_workers; i++)
+    {
+        if (pthread_create(&workers_arr[i].thread, NULL, _fleet_sim_worker_main, &workers_arr[i]) != 0)
+        {
+            fprintf(stderr, "fleet_sim: cannot create thread %u\n", i);
+            return EXIT_FAILURE;
+        }
+    }
+    fleet_sim_stats_t stats = {0};
+    for (uint32_t i = 0; i < num_workers; i++)
+    {
+        pthread_join(workers_arr[i].thread, NULL);
+        stats.measurements += workers_arr[i].stats.measurements;
+        stats.exact += workers_arr[i].stats.exact;
+        stats.abs_error_cm += workers_arr[i].stats.abs_error_cm;
+        stats.zone_changes += workers_arr[i].stats.zone_changes;
+        stats.presses += workers_arr[i].stats.presses;
+        stats.presses_seen += workers_arr[i].stats.presses_seen;
+        stats.slices += workers_arr[i].stats.slices;
+        stats.steals += workers_arr[i].stats.steals;
+    }
+    double wall_s = _fleet_sim_wall_s() - start_s;
+
+    /* Results */
+    double unit_hours = (double)num_units * (double)duration_s / 3600.0;
+    double mean_error_cm = (stats.measurements > 0) ? (double)stats.abs_error_cm / (double)stats.measurements : 0.0;
+    if (json)
+    {
+        printf("{\"units\": %u, \"duration_s\": %u, \"threads\": %u, \"seed\": %" PRIu64 ", "
+               "\"measurements\": %" PRIu64 ", \"exact_measurements\": %" PRIu64 ", \"mean_abs_error_cm\": %.3f, \"zone_changes\": %" PRIu64 ", "
+               "\"presses\": %" PRIu64 ", \"presses_seen\": %" PRIu64 ", \"slices\": %" PRIu64 ", \"steals\": %" PRIu64 ", "
+               "\"wall_s\": %.3f, \"unit_hours_per_s\": %.3f}\n",
+               num_units, duration_s, num_workers, seed, stats.measurements, stats.exact, mean_error_cm, stats.zone_changes,
+               stats.presses, stats.presses_seen, stats.slices, stats.steals, wall_s, unit_hours / wall_s);
+    }
+    else
+    {
+        printf("Fleet of %u units, %u s of virtual time each, %u threads, seed %" PRIu64 "\n", num_units, duration_s, num_workers, seed);
+        printf("  Measurements: %" PRIu64 " (%" PRIu64 " exact), mean absolute error %.3f cm\n", stats.measurements, stats.exact, mean_error_cm);
+        printf("  Zone changes: %" PRIu64 "\n", stats.zone_changes);
+        printf("  Button presses: %" PRIu64 " in the scenarios, %" PRIu64 " seen by the FSMs\n", stats.presses, stats.presses_seen);
+        printf("  Slices: %" PRIu64 ", steals: %" PRIu64 "\n", stats.slices, stats.steals);
+        printf("  %.1f unit-hours in %.3f s: %.1f unit-hours/s\n", unit_hours, wall_s, unit_hours / wall_s);
+    }
+
+    for (uint32_t i = 0; i < num_units; i++)
+    {
+        _fleet_sim_unit_destroy(&units_arr[i]);
+    }
+    for (uint32_t i = 0; i < num_workers; i++)
+    {
+        free(workers_arr[i].deque.p_slots);
+    }
+    free(workers_arr);
+    free(units_arr);
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,655 @@
+/**
+ * @file fsm_fuzz.c
+ * @brief Fuzzing harness of the interleavings of the ISRs and the ultrasound FSM in the native (host) platform.
+ *
+ * Each input is decoded, one byte per operation, into a sequence of events of the rear sensor against the native port: fires of the FSM, complete measurements (trigger, echo and distance), virtual time (in which the emulated timers raise the trigger, echo and software timer interrupts), `fsm_ultrasound_start()`, `fsm_ultrasound_stop()` and `fsm_ultrasound_set_status()`, changes of the echo, critical sections of the thread that mask the ISRs, and spurious raises of the interrupts that check their own flags. The invariants are checked after every operation:
+ * - State progress: a fire only takes the transitions of the table, and the state does not change outside a fire.
+ * - No lost wake-up: a fire leaves the state if, and only if, the input of one of its transitions is set.
+ * - No stale distance: every raw distance is the one of the echo of the current measurement, and every median is the one of the last `FSM_ULTRASOUND_NUM_MEASUREMENTS` raw distances since the FSM was started.
+ * - Bounded latency: outside the critical sections the echo ISR reports the falling edge within 1 ms, and the measurement timer sets `trigger_ready` within one period (plus 1 ms) of the start of the last measurement.
+ *
+ * The critical sections of the harness do not span more than 1 ms of virtual time, as the ones of the firmware, so that the captures of the echo timer are not lost by the harness itself.
+ *
+ * The virtual time in which nothing can happen is skipped at once (see `native_system_skip_ms()`): the milliseconds without an event of the emulated peripherals, in which a fire of the FSM does nothing because the input of its transitions is not set. So a long advance costs as many steps as it has events, and the standalone driver runs more than a hundred thousand inputs per second in an optimized build. The standalone driver also seeds its corpus with a complete window of measurements, so the mutations start from inputs that reach the distances and the medians.
+ *
+ * It exports `LLVMFuzzerTestOneInput()`, so it is a libFuzzer target when it is built with `-DFSM_FUZZ_LIBFUZZER -fsanitize=fuzzer` (clang). Otherwise it has its own driver, coverage-guided by the transitions of the FSM: `fsm_fuzz [-n runs] [-s seed] [file...]` mutates a corpus of the inputs that reach new (state, operation, state) features or new flags of the ISRs in a state, or replays the given files (crash reproducers of both drivers). A violation prints the operation and aborts, and the standalone driver writes the input to `fsm_fuzz_crash.bin`.
+ *
+ * @date 2025-01-01
+ */
+
+/* Includes ------------------------------------------------------------------*/
+#define _POSIX_C_SOURCE 200809L /* clock_gettime(), getopt() */
+
+/* Standard C includes */
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <string.h>
+#include <inttypes.h>
+#include <time.h>
+#include <unistd.h>
+
+/* HW dependent includes */
+#include "port_system.h"
+#include "port_ultrasound.h"
+#include "native_system.h"
+#include "native_ultrasound.h"
+
+/* Project includes */
+#include "fsm_ultrasound.h"
+
+/* Defines and enums ----------------------------------------------------------*/
+#define FSM_FUZZ_MAX_LEN 64U             /*!< Longest input of the standalone driver */
+#define FSM_FUZZ_MAX_NESTING 4U          /*!< Deepest critical section of the harness */
+#define FSM_FUZZ_RUN_STEP_MS 4U          /*!< Milliseconds per unit of the argument of a run (fire every millisecond) */
+#define FSM_FUZZ_IDLE_STEP_MS 16U        /*!< Milliseconds per unit of the argument of a long advance (no fires) */
+#define FSM_FUZZ_MEASURE_MAX_MS 400U     /*!< Longest run of a measurement: two periods of the measurements and the longest echo */
+#define FSM_FUZZ_MAP_BITS 16384U         /*!< Features of the coverage map of the standalone driver */
+#define FSM_FUZZ_CORPUS_SIZE 512U        /*!< Inputs kept by the standalone driver */
+#define FSM_FUZZ_DEFAULT_RUNS 200000U    /*!< Inputs run by the standalone driver by default */
+#define FSM_FUZZ_DEFAULT_SEED 1U         /*!< Seed of the mutations by default */
+#define FSM_FUZZ_CRASH_FILE "fsm_fuzz_crash.bin" /*!< Input written by the standalone driver when an invariant is violated */
+
+/**
+ * @brief Operations of the input. The high nibble of a byte is the operation and the low nibble its argument
+ */
+enum FSM_FUZZ_OP
+{
+    FSM_FUZZ_OP_FIRE = 0,            /*!< Fire the FSM (0 to 2) */
+    FSM_FUZZ_OP_MEASURE = 3,         /*!< Set the echo as `FSM_FUZZ_OP_ECHO` and run as `FSM_FUZZ_OP_RUN` until the FSM computes a distance, at most `FSM_FUZZ_MEASURE_MAX_MS` ms */
+    FSM_FUZZ_OP_RUN = 4,             /*!< Advance `(arg + 1) * FSM_FUZZ_RUN_STEP_MS` ms firing the FSM every millisecond (4, 5 and 14) */
+    FSM_FUZZ_OP_ADVANCE = 6,         /*!< Advance `arg + 1` ms without firing the FSM */
+    FSM_FUZZ_OP_START = 7,           /*!< `fsm_ultrasound_start()` */
+    FSM_FUZZ_OP_STOP = 8,            /*!< `fsm_ultrasound_stop()` */
+    FSM_FUZZ_OP_STATUS = 9,          /*!< `fsm_ultrasound_set_status()` with the bit 0 of the argument */
+    FSM_FUZZ_OP_ECHO = 10,           /*!< Duration of the next echoes (see `echo_us_arr`) */
+    FSM_FUZZ_OP_ENTER_CRITICAL = 11, /*!< Enter a critical section */
+    FSM_FUZZ_OP_EXIT_CRITICAL = 12,  /*!< Exit a critical section */
+    FSM_FUZZ_OP_RAISE = 13,          /*!< Raise the echo or the software timer interrupt without an event */
+    FSM_FUZZ_OP_IDLE = 15            /*!< Advance `(arg + 1) * FSM_FUZZ_IDLE_STEP_MS` ms without firing the FSM: the FSM falls behind the ISRs */
+};
+
+/* Typedefs --------------------------------------------------------------------*/
+/**
+ * @brief Model of the rear sensor kept by the harness to check the invariants
+ */
+typedef struct
+{
+    fsm_ultrasound_t *p_fsm;                          /*!< FSM under test */
+    uint32_t op_idx;                                  /*!< Operation being run */
+    uint32_t echo_us;                                 /*!< Duration of the next echoes. 0: the echo pin does not rise */
+    bool echo_valid;                                  /*!< The current measurement has produced an echo */
+    uint32_t meas_echo_us;                            /*!< Duration of the echo of the current measurement */
+    bool echo_pending;                                /*!< The echo of the current measurement has not been read by the FSM */
+    uint64_t echo_fall_us;                            /*!< Virtual time of the falling edge of that echo */
+    uint32_t last_start_ms;                           /*!< Virtual time of the start of the last measurement or of the FSM */
+    uint32_t window_arr[FSM_ULTRASOUND_NUM_MEASUREMENTS]; /*!< Raw distances of the current median */
+    uint32_t window_count;                            /*!< Raw distances in the window */
+    uint32_t nesting;                                 /*!< Critical sections entered by the harness */
+    uint32_t masked_ms;                               /*!< Virtual time spent in the current critical section */
+    uint32_t distances;                               /*!< Raw distances checked */
+    uint32_t medians;                                 /*!< Medians checked */
+} fsm_fuzz_model_t;
+
+/* Global variables */
+static fsm_fuzz_model_t model;                       /*!< Model of the input being run */
+static const uint8_t *p_fuzz_input = NULL;           /*!< Input being run */
+static size_t fuzz_input_size = 0;                   /*!< Size of the input being run */
+static uint8_t coverage_arr[FSM_FUZZ_MAP_BITS / 8U]; /*!< Features reached by the input being run */
+
+/*!< Durations of the echoes, in us: no echo, the usual range, and around the overflows of the echo timer */
+static const uint32_t echo_us_arr[16] = {0, 58, 583, 1166, 2915, 5830, 11660, 23000, 30000, 65535, 65536, 65537, 70000, 131072, 150000, 200000};
+
+/* Private functions ----------------------------------------------------------*/
+/**
+ * @brief Report a violated invariant and abort, so that the fuzzer keeps the input
+ * @param p_msg Invariant violated
+ */
+static void _fsm_fuzz_fail(const char *p_msg)
+{
+    fprintf(stderr, "fsm_fuzz: %s (operation %" PRIu32 " of %zu: 0x%02X, t = %" PRIu32 " ms, state %" PRIu32 ")\n", p_msg, model.op_idx, fuzz_input_size,
+            (model.op_idx < fuzz_input_size) ? p_fuzz_input[model.op_idx] : 0U, port_system_get_millis(), fsm_ultrasound_get_state(model.p_fsm));
+#ifndef FSM_FUZZ_LIBFUZZER
+    FILE *p_file = fopen(FSM_FUZZ_CRASH_FILE, "wb");
+    if (p_file != NULL)
+    {
+        fwrite(p_fuzz_input, 1, fuzz_input_size, p_file);
+        fclose(p_file);
+        fprintf(stderr, "fsm_fuzz: input written to %s\n", FSM_FUZZ_CRASH_FILE);
+    }
+#endif
+    abort();
+}
+
+/**
+ * @brief Mark a feature as reached
+ * @param feature Feature (any value; it is hashed into the map)
+ */
+static inline void _fsm_fuzz_cover(uint32_t feature)
+{
+    feature = (feature * 2654435761U) >> 18; /* 14 bits */
+    coverage_arr[feature >> 3] |= (uint8_t)(1U << (feature & 7U));
+}
+
+/**
+ * @brief Echo source of the rear sensor: the duration set by the input
+ * @param p_arg Not used
+ * @param ultrasound_id Not used
+ * @param burst_us Virtual time of the rising edge of the echo
+ * @return Duration of the echo
+ */
+static uint32_t _fsm_fuzz_echo_us(void *p_arg, uint32_t ultrasound_id, uint64_t burst_us)
+{
+    if (model.echo_us > 0)
+    {
+        model.echo_valid = true;
+        model.meas_echo_us = model.echo_us;
+        model.echo_pending = true;
+        model.echo_fall_us = burst_us + model.echo_us;
+    }
+    return model.echo_us;
+}
+
+/**
+ * @brief Check if the input of a transition from the current state is set, as the guards of the FSM read it
+ * @return true if a fire must leave the current state
+ */
+static bool _fsm_fuzz_input_set(void)
+{
+    switch (fsm_ultrasound_get_state(model.p_fsm))
+    {
+    case WAIT_START:
+        return fsm_ultrasound_get_status(model.p_fsm) && port_ultrasound_get_trigger_ready(PORT_REAR_PARKING_SENSOR_ID);
+    case TRIGGER_START:
+        return port_ultrasound_get_trigger_end(PORT_REAR_PARKING_SENSOR_ID);
+    case WAIT_ECHO_START:
+        return port_ultrasound_get_echo_init_tick(PORT_REAR_PARKING_SENSOR_ID) > 0;
+    case WAIT_ECHO_END:
+        return port_ultrasound_get_echo_received(PORT_REAR_PARKING_SENSOR_ID);
+    case SET_DISTANCE:
+        return port_ultrasound_get_trigger_ready(PORT_REAR_PARKING_SENSOR_ID) || !fsm_ultrasound_get_status(model.p_fsm);
+    default:
+        return false;
+    }
+}
+
+/**
+ * @brief Check if a transition is in the table of the FSM
+ * @param from Origin state
+ * @param to Destination state
+ * @return true if the FSM can take the transition
+ */
+static bool _fsm_fuzz_transition_allowed(uint32_t from, uint32_t to)
+{
+    return ((from == WAIT_START) && (to == TRIGGER_START)) || ((from == TRIGGER_START) && (to == WAIT_ECHO_START)) || ((from == WAIT_ECHO_START) && (to == WAIT_ECHO_END)) ||
+           ((from == WAIT_ECHO_END) && (to == SET_DISTANCE)) || ((from == SET_DISTANCE) && ((to == TRIGGER_START) || (to == WAIT_START)));
+}
+
+/**
+ * @brief Compute the median of the window of the model
+ * @return Median, as the FSM computes it
+ */
+static uint32_t _fsm_fuzz_model_median(void)
+{
+    uint32_t sorted_arr[FSM_ULTRASOUND_NUM_MEASUREMENTS];
+    memcpy(sorted_arr, model.window_arr, sizeof(sorted_arr));
+    for (uint32_t i = 1; i < FSM_ULTRASOUND_NUM_MEASUREMENTS; i++)
+    {
+        uint32_t value = sorted_arr[i];
+        uint32_t j = i;
+        for (; (j > 0) && (sorted_arr[j - 1U] > value); j--)
+        {
+            sorted_arr[j] = sorted_arr[j - 1U];
+        }
+        sorted_arr[j] = value;
+    }
+    if (FSM_ULTRASOUND_NUM_MEASUREMENTS % 2 == 1)
+    {
+        return sorted_arr[FSM_ULTRASOUND_NUM_MEASUREMENTS / 2];
+    }
+    return (sorted_arr[FSM_ULTRASOUND_NUM_MEASUREMENTS / 2 - 1] + sorted_arr[FSM_ULTRASOUND_NUM_MEASUREMENTS / 2]) / 2;
+}
+
+/**
+ * @brief Fire the FSM and check the progress of the state and the distances
+ */
+static void _fsm_fuzz_fire(void)
+{
+    uint32_t from = fsm_ultrasound_get_state(model.p_fsm);
+    bool input_set = _fsm_fuzz_input_set();
+    uint32_t flags = (port_ultrasound_get_trigger_ready(PORT_REAR_PARKING_SENSOR_ID) ? 1U : 0U) | (port_ultrasound_get_trigger_end(PORT_REAR_PARKING_SENSOR_ID) ? 2U : 0U) |
+                     ((port_ultrasound_get_echo_init_tick(PORT_REAR_PARKING_SENSOR_ID) > 0) ? 4U : 0U) | (port_ultrasound_get_echo_received(PORT_REAR_PARKING_SENSOR_ID) ? 8U : 0U) |
+                     ((port_ultrasound_get_echo_overflows(PORT_REAR_PARKING_SENSOR_ID) > 0) ? 16U : 0U);
+    _fsm_fuzz_cover(0x4000U | (from << 8) | flags); /* The flags the ISRs have set when the FSM runs: their interleaving with the state */
+    fsm_ultrasound_fire(model.p_fsm);
+    uint32_t to = fsm_ultrasound_get_state(model.p_fsm);
+    _fsm_fuzz_cover((from << 8) | (to << 4) | (model.nesting > 0 ? 1U : 0U) | (input_set ? 2U : 0U));
+
+    if ((to != from) != input_set)
+    {
+        _fsm_fuzz_fail(input_set ? "lost wake-up: the input of a transition is set and the FSM does not leave its state" : "the FSM leaves its state without input");
+    }
+    if ((to != from) && !_fsm_fuzz_transition_allowed(from, to))
+    {
+        _fsm_fuzz_fail("the FSM takes a transition that is not in its table");
+    }
+    if ((to == TRIGGER_START) && (from != TRIGGER_START))
+    {
+        model.echo_valid = false; /* A new measurement: the previous echo must not be used */
+        model.echo_pending = false;
+        model.last_start_ms = port_system_get_millis();
+    }
+    if ((to == SET_DISTANCE) && (from == WAIT_ECHO_END))
+    {
+        if (!model.echo_valid)
+        {
+            _fsm_fuzz_fail("stale distance: a distance is computed without an echo of the current measurement");
+        }
+        uint32_t expected_cm = (model.meas_echo_us * SPEED_OF_SOUND_MS) / (2 * 10000);
+        if (fsm_ultrasound_get_raw_distance(model.p_fsm) != expected_cm)
+        {
+            _fsm_fuzz_fail("stale distance: the raw distance is not the one of the echo of the current measurement");
+        }
+        model.echo_valid = false;
+        model.echo_pending = false;
+        model.distances++;
+        model.window_arr[model.window_count++] = expected_cm;
+        _fsm_fuzz_cover(0x1000U | model.window_count);
+        if (model.window_count == FSM_ULTRASOUND_NUM_MEASUREMENTS)
+        {
+            model.window_count = 0;
+            if (!fsm_ultrasound_get_new_measurement_ready(model.p_fsm))
+            {
+                _fsm_fuzz_fail("a full window does not report a median");
+            }
+            if (fsm_ultrasound_get_distance(model.p_fsm) != _fsm_fuzz_model_median())
+            {
+                _fsm_fuzz_fail("stale distance: the median is not the one of the last raw distances since the start");
+            }
+            model.medians++;
+            _fsm_fuzz_cover(0x2000U | (model.medians & 0xFU));
+        }
+    }
+    if (fsm_ultrasound_get_new_measurement_ready(model.p_fsm))
+    {
+        _fsm_fuzz_fail("a median is reported before its window is full");
+    }
+}
+
+/**
+ * @brief Advance the virtual time one millisecond and check the latency of the ISRs
+ */
+static void _fsm_fuzz_tick(void)
+{
+    if (model.nesting > 0)
+    {
+        if (model.masked_ms >= 1U)
+        {
+            return; /* The critical sections of the firmware are shorter than a tick */
+        }
+        model.masked_ms++;
+    }
+    native_system_advance_ms(1);
+    if (model.nesting > 0)
+    {
+        return; /* The ISRs are masked */
+    }
+
+    uint32_t now_ms = port_system_get_millis();
+    if (model.echo_pending && ((uint64_t)now_ms * 1000U >= model.echo_fall_us + 1000U) && !port_ultrasound_get_echo_received(PORT_REAR_PARKING_SENSOR_ID))
+    {
+        _fsm_fuzz_fail("latency: the echo ISR has not reported the falling edge 1 ms after it");
+    }
+    if (port_ultrasound_get_measurement_timer_running(PORT_REAR_PARKING_SENSOR_ID) && (now_ms - model.last_start_ms > (uint32_t)PORT_PARKING_SENSOR_TIMEOUT_MS + 1U) &&
+        !port_ultrasound_get_trigger_ready(PORT_REAR_PARKING_SENSOR_ID))
+    {
+        _fsm_fuzz_fail("latency: the measurement timer has not set trigger_ready one period after the start of the measurement");
+    }
+}
+
+/**
+ * @brief Advance the virtual time, firing the FSM every millisecond if asked, and skip at once the milliseconds in which nothing can happen
+ *
+ * A millisecond without an event of the emulated peripherals only counts the System tick, and a fire without the input of a transition does not change anything, so they are skipped with `native_system_skip_ms()`. The last millisecond is always run, so the invariants are checked at the end, and nothing is skipped in a critical section. In a critical section that has already spanned its millisecond the time does not advance, so the advance ends when a fire does not change the state.
+ *
+ * @param ms Milliseconds to advance
+ * @param fire Fire the FSM every millisecond
+ * @param until_distance Stop when the FSM computes a distance
+ */
+static void _fsm_fuzz_advance(uint32_t ms, bool fire, bool until_distance)
+{
+    uint32_t distances = model.distances;
+    while ((ms > 0) && (!until_distance || (model.distances == distances)))
+    {
+        if ((model.nesting == 0) && (!fire || !_fsm_fuzz_input_set()))
+        {
+            ms -= native_system_skip_ms(ms - 1U);
+        }
+        bool frozen = (model.nesting > 0) && (model.masked_ms >= 1U); /* The harness does not advance the time in a long critical section */
+        uint32_t state = fsm_ultrasound_get_state(model.p_fsm);
+        _fsm_fuzz_tick();
+        if (fire)
+        {
+            _fsm_fuzz_fire();
+        }
+        if (frozen && (fsm_ultrasound_get_state(model.p_fsm) == state))
+        {
+            break; /* Neither the time nor the state change: the next milliseconds would be the same */
+        }
+        ms--;
+    }
+}
+
+/**
+ * @brief Check that an operation other than a fire does not change the state
+ * @param state State before the operation
+ */
+static void _fsm_fuzz_check_same_state(uint32_t state)
+{
+    if (fsm_ultrasound_get_state(model.p_fsm) != state)
+    {
+        _fsm_fuzz_fail("the state changes outside a fire of the FSM");
+    }
+}
+
+/* Public functions -----------------------------------------------------------*/
+/**
+ * @brief Run an input. Entry point of libFuzzer
+ * @param p_data Input
+ * @param size Size of the input
+ * @return 0
+ */
+int LLVMFuzzerTestOneInput(const uint8_t *p_data, size_t size)
+{
+    p_fuzz_input = p_data;
+    fuzz_input_size = size;
+    port_system_init();
+    memset(&model, 0, sizeof(model));
+    model.echo_us = echo_us_arr[2];
+    model.p_fsm = fsm_ultrasound_new(PORT_REAR_PARKING_SENSOR_ID);
+    native_ultrasound_set_echo_source(PORT_REAR_PARKING_SENSOR_ID, _fsm_fuzz_echo_us, NULL);
+
+    for (model.op_idx = 0; model.op_idx < size; model.op_idx++)
+    {
+        uint32_t op = p_data[model.op_idx] >> 4;
+        uint32_t arg = p_data[model.op_idx] & 0x0FU;
+        uint32_t state = fsm_ultrasound_get_state(model.p_fsm);
+        switch (op)
+        {
+        case FSM_FUZZ_OP_RUN:
+        case FSM_FUZZ_OP_RUN + 1:
+        case FSM_FUZZ_OP_IDLE - 1:
+            _fsm_fuzz_advance((arg + 1U) * FSM_FUZZ_RUN_STEP_MS, true, false);
+            break;
+        case FSM_FUZZ_OP_MEASURE:
+            model.echo_us = echo_us_arr[arg];
+            _fsm_fuzz_advance(FSM_FUZZ_MEASURE_MAX_MS, true, true);
+            break;
+        case FSM_FUZZ_OP_ADVANCE:
+        case FSM_FUZZ_OP_IDLE:
+            _fsm_fuzz_advance((op == FSM_FUZZ_OP_IDLE) ? (arg + 1U) * FSM_FUZZ_IDLE_STEP_MS : arg + 1U, false, false);
+            _fsm_fuzz_check_same_state(state);
+            break;
+        case FSM_FUZZ_OP_START:
+            fsm_ultrasound_start(model.p_fsm);
+            model.window_count = 0; /* The FSM starts a new window */
+            model.echo_pending = false;
+            model.last_start_ms = port_system_get_millis();
+            _fsm_fuzz_check_same_state(state);
+            break;
+        case FSM_FUZZ_OP_STOP:
+            fsm_ultrasound_stop(model.p_fsm);
+            model.echo_valid = false; /* The ticks are reset */
+            model.echo_pending = false;
+            _fsm_fuzz_check_same_state(state);
+            break;
+        case FSM_FUZZ_OP_STATUS:
+            fsm_ultrasound_set_status(model.p_fsm, (arg & 1U) != 0U);
+            _fsm_fuzz_check_same_state(state);
+            break;
+        case FSM_FUZZ_OP_ECHO:
+            model.echo_us = echo_us_arr[arg];
+            break;
+        case FSM_FUZZ_OP_ENTER_CRITICAL:
+            if (model.nesting < FSM_FUZZ_MAX_NESTING)
+            {
+                port_system_enter_critical();
+                model.nesting++;
+            }
+            break;
+        case FSM_FUZZ_OP_EXIT_CRITICAL:
+            if (model.nesting > 0)
+            {
+                port_system_exit_critical();
+                if (--model.nesting == 0)
+                {
+                    model.masked_ms = 0;
+                }
+            }
+            _fsm_fuzz_check_same_state(state);
+            break;
+        case FSM_FUZZ_OP_RAISE:
+            native_system_irq_raise(((arg & 1U) != 0U) ? NATIVE_SYSTEM_IRQ_ECHO : NATIVE_SYSTEM_IRQ_TIMER); /* Their ISRs check the flags of the peripheral */
+            _fsm_fuzz_check_same_state(state);
+            break;
+        default:
+            _fsm_fuzz_fire();
+            break;
+        }
+        _fsm_fuzz_cover((state << 8) | (op << 4) | fsm_ultrasound_get_state(model.p_fsm));
+    }
+
+    while (model.nesting > 0)
+    {
+        port_system_exit_critical();
+        model.nesting--;
+    }
+    fsm_ultrasound_stop(model.p_fsm);
+    native_ultrasound_set_echo_source(PORT_REAR_PARKING_SENSOR_ID, NULL, NULL);
+    fsm_ultrasound_destroy(model.p_fsm);
+    return 0;
+}
+
+#ifndef FSM_FUZZ_LIBFUZZER
+/**
+ * @brief Input of the corpus of the standalone driver
+ */
+typedef struct
+{
+    uint8_t data_arr[FSM_FUZZ_MAX_LEN]; /*!< Input */
+    size_t size;                        /*!< Size of the input */
+} fsm_fuzz_input_t;
+
+static fsm_fuzz_input_t corpus_arr[FSM_FUZZ_CORPUS_SIZE]; /*!< Inputs that reached new features */
+static uint8_t total_coverage_arr[FSM_FUZZ_MAP_BITS / 8U]; /*!< Features reached by the corpus */
+
+/**
+ * @brief Next pseudo-random number of a xorshift64* generator
+ * @param p_state Pointer to the state of the generator
+ * @return Pseudo-random number
+ */
+static uint64_t _fsm_fuzz_rand(uint64_t *p_state)
+{
+    *p_state ^= *p_state >> 12;
+    *p_state ^= *p_state << 25;
+    *p_state ^= *p_state >> 27;
+    return *p_state * 0x2545F4914F6CDD1DULL;
+}
+
+/**
+ * @brief Mutate an input of the corpus: flip, replace, insert or delete bytes, or splice another input
+ * @param p_input Pointer to the input to mutate
+ * @param num_corpus Inputs in the corpus
+ * @param p_rng Pointer to the state of the generator
+ */
+static void _fsm_fuzz_mutate(fsm_fuzz_input_t *p_input, uint32_t num_corpus, uint64_t *p_rng)
+{
+    uint32_t num_mutations = 1U + (uint32_t)(_fsm_fuzz_rand(p_rng) % 4U);
+    for (uint32_t m = 0; m < num_mutations; m++)
+    {
+        uint64_t r = _fsm_fuzz_rand(p_rng);
+        size_t pos = (p_input->size > 0) ? (size_t)((r >> 8) % p_input->size) : 0;
+        switch (r % 5U)
+        {
+        case 0: /* Flip a bit */
+            if (p_input->size > 0)
+            {
+                p_input->data_arr[pos] ^= (uint8_t)(1U << ((r >> 40) & 7U));
+            }
+            break;
+        case 1: /* Replace a byte */
+            if (p_input->size > 0)
+            {
+                p_input->data_arr[pos] = (uint8_t)(r >> 32);
+            }
+            break;
+        case 2: /* Insert a byte */
+            if (p_input->size < FSM_FUZZ_MAX_LEN)
+            {
+                memmove(&p_input->data_arr[pos + 1U], &p_input->data_arr[pos], p_input->size - pos);
+                p_input->data_arr[pos] = (uint8_t)(r >> 32);
+                p_input->size++;
+            }
+            break;
+        case 3: /* Delete a byte */
+            if (p_input->size > 0)
+            {
+                memmove(&p_input->data_arr[pos], &p_input->data_arr[pos + 1U], p_input->size - pos - 1U);
+                p_input->size--;
+            }
+            break;
+        default: /* Splice the tail of another input */
+        {
+            const fsm_fuzz_input_t *p_other = &corpus_arr[(r >> 32) % num_corpus];
+            size_t from = (p_other->size > 0) ? (size_t)((r >> 16) % p_other->size) : 0;
+            size_t length = p_other->size - from;
+            if (pos + length > FSM_FUZZ_MAX_LEN)
+            {
+                length = FSM_FUZZ_MAX_LEN - pos;
+            }
+            memcpy(&p_input->data_arr[pos], &p_other->data_arr[from], length);
+            p_input->size = pos + length;
+            break;
+        }
+        }
+    }
+}
+
+/**
+ * @brief Run an input and add it to the corpus if it reached new features
+ * @param p_input Pointer to the input
+ * @param p_num_corpus Pointer to the number of inputs in the corpus
+ * @return true if the input reached new features
+ */
+static bool _fsm_fuzz_run_guided(const fsm_fuzz_input_t *p_input, uint32_t *p_num_corpus)
+{
+    memset(coverage_arr, 0, sizeof(coverage_arr));
+    LLVMFuzzerTestOneInput(p_input->data_arr, p_input->size);
+    bool new_features = false;
+    for (uint32_t i = 0; i < sizeof(coverage_arr); i++)
+    {
+        if ((coverage_arr[i] & ~total_coverage_arr[i]) != 0)
+        {
+            total_coverage_arr[i] |= coverage_arr[i];
+            new_features = true;
+        }
+    }
+    if (new_features && (*p_num_corpus < FSM_FUZZ_CORPUS_SIZE))
+    {
+        corpus_arr[(*p_num_corpus)++] = *p_input;
+    }
+    return new_features;
+}
+
+/**
+ * @brief Run the inputs of a set of files
+ * @param num_files Number of files
+ * @param p_paths Paths of the files
+ * @return EXIT_SUCCESS, or EXIT_FAILURE if a file cannot be read (a violation aborts)
+ */
+static int _fsm_fuzz_replay(int num_files, char *p_paths[])
+{
+    static uint8_t data_arr[1U << 16];
+    for (int i = 0; i < num_files; i++)
+    {
+        FILE *p_file = fopen(p_paths[i], "rb");
+        if (p_file == NULL)
+        {
+            fprintf(stderr, "fsm_fuzz: cannot open %s\n", p_paths[i]);
+            return EXIT_FAILURE;
+        }
+        size_t size = fread(data_arr, 1, sizeof(data_arr), p_file);
+        fclose(p_file);
+        LLVMFuzzerTestOneInput(data_arr, size);
+        printf("%s: %zu operations, %" PRIu32 " medians, no violation\n", p_paths[i], size, model.medians);
+    }
+    return EXIT_SUCCESS;
+}
+
+int main(int argc, char *argv[])
+{
+    uint32_t runs = FSM_FUZZ_DEFAULT_RUNS;
+    uint64_t seed = FSM_FUZZ_DEFAULT_SEED;
+
+    int opt;
+    while ((opt = getopt(argc, argv, "n:s:h")) != -1)
+    {
+        switch (opt)
+        {
+        case 'n':
+            runs = (uint32_t)strtoul(optarg, NULL, 0);
+            break;
+        case 's':
+            seed = strtoull(optarg, NULL, 0);
+            break;
+        default:
+            fprintf(stderr, "Usage: %s [-n runs] [-s seed] [file...]\n"
+                            "  -n  inputs to run (default %u)\n"
+                            "  -s  seed of the mutations (default %u)\n"
+                            "  file  inputs to replay instead of fuzzing\n",
+                    argv[0], FSM_FUZZ_DEFAULT_RUNS, FSM_FUZZ_DEFAULT_SEED);
+            return EXIT_FAILURE;
+        }
+    }
+    if (optind < argc)
+    {
+        return _fsm_fuzz_replay(argc - optind, &argv[optind]);
+    }
+
+    struct timespec start;
+    struct timespec end;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+
+    uint64_t rng = (seed << 1) | 1U; /* Odd and different for every seed */
+    uint32_t num_corpus = 0;
+    uint64_t medians = 0;
+    fsm_fuzz_input_t input = {.size = 0};
+    corpus_arr[num_corpus++] = input; /* The empty input and a start with a window of measurements of the usual echo are the seeds of the corpus */
+    input.data_arr[input.size++] = (uint8_t)(FSM_FUZZ_OP_START << 4);
+    for (uint32_t k = 0; k < FSM_ULTRASOUND_NUM_MEASUREMENTS; k++)
+    {
+        input.data_arr[input.size++] = (uint8_t)((FSM_FUZZ_OP_MEASURE << 4) | 2U);
+    }
+    _fsm_fuzz_run_guided(&input, &num_corpus);
+    for (uint32_t run = 1; run < runs; run++)
+    {
+        input = corpus_arr[_fsm_fuzz_rand(&rng) % num_corpus];
+        _fsm_fuzz_mutate(&input, num_corpus, &rng);
+        _fsm_fuzz_run_guided(&input, &num_corpus);
+        medians += model.medians;
+    }
+
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    double seconds = (double)(end.tv_sec - start.tv_sec) + (double)(end.tv_nsec - start.tv_nsec) * 1e-9;
+    uint32_t features = 0;
+    for (uint32_t i = 0; i < sizeof(total_coverage_arr); i++)
+    {
+        features += (uint32_t)__builtin_popcount(total_coverage_arr[i]);
+    }
+    printf("%" PRIu32 " inputs in %.2f s (%.0f inputs/s), %" PRIu32 " features, %" PRIu32 " inputs in the corpus, %" PRIu64 " medians checked, no violation\n", runs, seconds,
+           (double)runs / seconds, features, num_corpus, medians);
+    return EXIT_SUCCESS;
+}
+#endif /* FSM_FUZZ_LIBFUZZER */
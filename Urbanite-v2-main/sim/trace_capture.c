@@ -0,0 +1,187 @@
+/**
+ * @file trace_capture.c
+ * @brief Capture trace of a drive in the native (host) platform.
+ *
+ * It runs the Urbanite in the native port, compiled with `PORT_CAPTURE_TRACE`, as a device in the field: the echoes come from the acoustic world model (see native_world.h) and the driver presses the button from time to time, and a long press switches the rear sensor off and on. The trace is written as a device does with `port_trace_save()`, so it can be replayed with `trace_replay` to check the replay engine and to keep traces of regression scenarios.
+ *
+ * `trace_capture [-d seconds] [-s seed] <scenario> <trace>`
+ *
+ * @date 2025-01-01
+ */
+
+/* Includes ------------------------------------------------------------------*/
+#define _POSIX_C_SOURCE 200809L /* getopt() */
+
+/* Standard C includes */
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <inttypes.h>
+#include <unistd.h>
+
+/* HW dependent includes */
+#include "port_button.h"
+#include "port_ultrasound.h"
+#include "port_system.h"
+#include "port_trace.h"
+#include "native_system.h"
+#include "native_button.h"
+#include "native_ultrasound.h"
+#include "native_world.h"
+
+/* Project includes */
+#include "fsm_button.h"
+#include "fsm_ultrasound.h"
+
+/* Defines and enums ----------------------------------------------------------*/
+#define TRACE_CAPTURE_DEFAULT_DURATION_S 60U /*!< Virtual time of the drive by default */
+#define TRACE_CAPTURE_DEFAULT_SEED 1U        /*!< Seed of the noise and of the presses by default */
+#define TRACE_CAPTURE_MIN_PRESS_GAP_MS 2000U /*!< Shortest time between two presses of the button */
+#define TRACE_CAPTURE_MAX_PRESS_GAP_MS 8000U /*!< Longest time between two presses of the button */
+#define TRACE_CAPTURE_MIN_PRESS_MS 50U       /*!< Shortest press of the button. Shorter than the anti-debounce time, so that some presses bounce */
+#define TRACE_CAPTURE_MAX_PRESS_MS 2000U     /*!< Longest press of the button */
+#define TRACE_CAPTURE_LONG_PRESS_MS 1000U    /*!< Press that switches the rear sensor off and on */
+
+/* Private functions ----------------------------------------------------------*/
+/**
+ * @brief Next pseudo-random number of a xorshift64* generator
+ * @param p_state Pointer to the state of the generator
+ * @return Pseudo-random number
+ */
+static uint64_t _trace_capture_rand(uint64_t *p_state)
+{
+    *p_state ^= *p_state >> 12;
+    *p_state ^= *p_state << 25;
+    *p_state ^= *p_state >> 27;
+    return *p_state * 0x2545F4914F6CDD1DULL;
+}
+
+/**
+ * @brief Pseudo-random number in a range
+ * @param p_state Pointer to the state of the generator
+ * @param min Minimum
+ * @param max Maximum
+ * @return Pseudo-random number in [min, max]
+ */
+static uint32_t _trace_capture_rand_range(uint64_t *p_state, uint32_t min, uint32_t max)
+{
+    return min + (uint32_t)(_trace_capture_rand(p_state) % (max - min + 1U));
+}
+
+/**
+ * @brief Print the usage of the capture
+ * @param p_name Name of the program
+ */
+static void _trace_capture_usage(const char *p_name)
+{
+    fprintf(stderr, "Usage: %s [-d seconds] [-s seed] <scenario> <trace>\n"
+                    "  -d  virtual time of the drive (default %u s)\n"
+                    "  -s  seed of the noise and of the presses (default %u)\n",
+            p_name, TRACE_CAPTURE_DEFAULT_DURATION_S, TRACE_CAPTURE_DEFAULT_SEED);
+}
+
+int main(int argc, char *argv[])
+{
+    uint32_t duration_s = TRACE_CAPTURE_DEFAULT_DURATION_S;
+    uint64_t seed = TRACE_CAPTURE_DEFAULT_SEED;
+
+    int opt;
+    while ((opt = getopt(argc, argv, "d:s:h")) != -1)
+    {
+        switch (opt)
+        {
+        case 'd':
+            duration_s = (uint32_t)strtoul(optarg, NULL, 0);
+            break;
+        case 's':
+            seed = strtoull(optarg, NULL, 0);
+            break;
+        default:
+            _trace_capture_usage(argv[0]);
+            return EXIT_FAILURE;
+        }
+    }
+    if ((optind != argc - 2) || (duration_s == 0) || (duration_s > UINT32_MAX / 1000U))
+    {
+        _trace_capture_usage(argv[0]);
+        return EXIT_FAILURE;
+    }
+    FILE *p_scenario = fopen(argv[optind], "r");
+    if (p_scenario == NULL)
+    {
+        fprintf(stderr, "trace_capture: cannot open %s\n", argv[optind]);
+        return EXIT_FAILURE;
+    }
+
+    /* Urbanite */
+    port_system_init();
+    port_trace_reset();
+    native_world_t *p_world = native_world_new(p_scenario, seed);
+    fsm_button_t *p_fsm_button = fsm_button_new(PORT_PARKING_BUTTON_DEBOUNCE_TIME_MS, PORT_PARKING_BUTTON_ID);
+    fsm_ultrasound_t *p_fsm_rear = fsm_ultrasound_new(PORT_REAR_PARKING_SENSOR_ID);
+    native_world_attach(p_world, PORT_REAR_PARKING_SENSOR_ID);
+    fsm_ultrasound_start(p_fsm_rear);
+
+    /* Drive */
+    uint64_t rng = seed | 1U;
+    uint32_t next_press_ms = _trace_capture_rand_range(&rng, TRACE_CAPTURE_MIN_PRESS_GAP_MS, TRACE_CAPTURE_MAX_PRESS_GAP_MS);
+    uint32_t release_ms = 0;
+    bool pressed = false;
+    uint32_t medians = 0;
+    for (uint32_t now_ms = 0; now_ms < duration_s * 1000U; now_ms++)
+    {
+        if (!pressed && (now_ms == next_press_ms))
+        {
+            pressed = true;
+            release_ms = now_ms + _trace_capture_rand_range(&rng, TRACE_CAPTURE_MIN_PRESS_MS, TRACE_CAPTURE_MAX_PRESS_MS);
+            native_button_set_value(PORT_PARKING_BUTTON_ID, false); /* Active low */
+        }
+        else if (pressed && (now_ms == release_ms))
+        {
+            pressed = false;
+            next_press_ms = now_ms + _trace_capture_rand_range(&rng, TRACE_CAPTURE_MIN_PRESS_GAP_MS, TRACE_CAPTURE_MAX_PRESS_GAP_MS);
+            native_button_set_value(PORT_PARKING_BUTTON_ID, true);
+        }
+
+        native_system_advance_ms(1);
+        fsm_button_fire(p_fsm_button);
+        fsm_ultrasound_fire(p_fsm_rear);
+
+        uint32_t duration_ms = fsm_button_get_duration(p_fsm_button);
+        if (duration_ms >= TRACE_CAPTURE_LONG_PRESS_MS)
+        {
+            if (fsm_ultrasound_get_status(p_fsm_rear))
+            {
+                fsm_ultrasound_stop(p_fsm_rear);
+            }
+            else
+            {
+                fsm_ultrasound_start(p_fsm_rear);
+            }
+        }
+        if (duration_ms > 0)
+        {
+            fsm_button_reset_duration(p_fsm_button);
+        }
+        if (fsm_ultrasound_get_new_measurement_ready(p_fsm_rear))
+        {
+            fsm_ultrasound_get_distance(p_fsm_rear);
+            medians++;
+        }
+    }
+
+    bool ok = port_trace_save(argv[optind + 1]);
+    printf("Drive of %" PRIu32 " s: %" PRIu32 " medians, %" PRIu32 " records in the trace, %" PRIu32 " dropped\n", duration_s, medians, port_trace_get_num_records(), port_trace_get_dropped());
+    if (!ok)
+    {
+        fprintf(stderr, "trace_capture: cannot write %s\n", argv[optind + 1]);
+    }
+
+    native_ultrasound_set_echo_source(PORT_REAR_PARKING_SENSOR_ID, NULL, NULL);
+    fsm_button_destroy(p_fsm_button);
+    fsm_ultrasound_destroy(p_fsm_rear);
+    native_world_destroy(p_world);
+    fclose(p_scenario);
+    return ok ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,401 @@
+/**
+ * @file trace_replay.c
+ * @brief Replay of a capture trace of a device in the native (host) platform.
+ *
+ * The trace (see port_trace.h) is mapped in memory and its inputs are fed, at the millisecond of the device in which they happened, through the native port into the unchanged button and ultrasound FSMs: the levels of the button go to the emulated GPIO, the start, stop and status changes go to the ultrasound FSM, and each echo of the trace is the echo of the emulated sensor for the trigger that produced it in the device, with the counter of the echo timer of the device at its rising edge. So the ISRs of the native port store the same `echo_init_tick`, `echo_end_tick` and `echo_overflows` as the device, and the FSMs compute the same medians and press durations, which are checked against the outputs recorded in the trace. The FSMs are fired every millisecond, as the main loop of the Urbanite does.
+ *
+ * `trace_replay [-v] <trace>`
+ *
+ * It prints the outputs that differ (all of them with `-v`, the first ones by default), a summary and the speed of the replay, and fails if any output differs. A trigger of the replay in a different millisecond than in the device is reported, but it is not an error: the outputs only depend on the captures.
+ *
+ * @date 2025-01-01
+ */
+
+/* Includes ------------------------------------------------------------------*/
+#define _POSIX_C_SOURCE 200809L /* clock_gettime(), getopt() and mmap() */
+
+/* Standard C includes */
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <inttypes.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
+
+/* HW dependent includes */
+#include "port_button.h"
+#include "port_ultrasound.h"
+#include "port_system.h"
+#include "port_trace.h"
+#include "native_system.h"
+#include "native_button.h"
+#include "native_ultrasound.h"
+
+/* Project includes */
+#include "fsm_button.h"
+#include "fsm_ultrasound.h"
+
+/* Defines and enums ----------------------------------------------------------*/
+#define TRACE_REPLAY_TAIL_MS 1000U     /*!< Virtual time replayed after the last record, so that the FSMs finish the last outputs */
+#define TRACE_REPLAY_MAX_REPORTS 10U   /*!< Differences printed without `-v` */
+#define TRACE_REPLAY_ARG16_MAX 0xFFFFU /*!< Saturation of the first argument of a record */
+
+/* Typedefs --------------------------------------------------------------------*/
+/**
+ * @brief Replay of a trace
+ */
+typedef struct
+{
+    const port_trace_record_t *p_records; /*!< Records of the trace */
+    uint32_t num_records;                 /*!< Number of records */
+    uint32_t input_idx;                   /*!< Next record to feed to the FSMs */
+    uint32_t trigger_idx;                 /*!< Next trigger of the device to match with a trigger of the replay */
+    uint32_t distance_idx;                /*!< Next median of the device to compare */
+    uint32_t press_idx;                   /*!< Next press of the device to compare */
+    uint64_t triggers;                    /*!< Triggers of the replay matched with the device */
+    uint64_t triggers_moved;              /*!< Triggers of the replay in another millisecond than in the device */
+    uint64_t triggers_extra;              /*!< Triggers of the replay that the device did not do */
+    uint64_t echoes;                      /*!< Echoes of the device replayed */
+    uint64_t distances;                   /*!< Medians compared */
+    uint64_t presses;                     /*!< Press durations compared */
+    uint64_t differences;                 /*!< Outputs that differ, are missing or are extra */
+    uint64_t ignored;                     /*!< Records of other sensors or buttons, or of unknown types */
+    bool verbose;                         /*!< Print all the differences */
+} trace_replay_t;
+
+/* Private functions ----------------------------------------------------------*/
+/**
+ * @brief Wall-clock time
+ * @return Seconds of a monotonic clock
+ */
+static double _trace_replay_wall_s(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec * 1e-9;
+}
+
+/**
+ * @brief Print the usage of the replay engine
+ * @param p_name Name of the program
+ */
+static void _trace_replay_usage(const char *p_name)
+{
+    fprintf(stderr, "Usage: %s [-v] <trace>\n"
+                    "  -v  print all the outputs that differ from the device\n",
+            p_name);
+}
+
+/**
+ * @brief Report a difference between the replay and the device
+ * @param p_replay Pointer to the replay
+ * @param p_what Output that differs
+ * @param time_ms Time of the output in the device, or of the replay if the device did not compute it
+ * @param device Value computed by the device
+ * @param replay Value computed by the replay
+ */
+static void _trace_replay_report(trace_replay_t *p_replay, const char *p_what, uint32_t time_ms, int64_t device, int64_t replay)
+{
+    p_replay->differences++;
+    if (p_replay->verbose || (p_replay->differences <= TRACE_REPLAY_MAX_REPORTS))
+    {
+        printf("  %10" PRIu32 " ms: %s: device %" PRId64 ", replay %" PRId64 "\n", time_ms, p_what, device, replay);
+    }
+}
+
+/**
+ * @brief Find the next record of a type and an ID
+ * @param p_replay Pointer to the replay
+ * @param from_idx First record to look at
+ * @param type Type of the record
+ * @param id ID of the sensor or the button
+ * @return Index of the record. `num_records` if there is none
+ */
+static uint32_t _trace_replay_find(const trace_replay_t *p_replay, uint32_t from_idx, uint32_t type, uint32_t id)
+{
+    uint32_t idx = from_idx;
+    while ((idx < p_replay->num_records) && ((p_replay->p_records[idx].type != type) || (p_replay->p_records[idx].id != id)))
+    {
+        idx++;
+    }
+    return idx;
+}
+
+/**
+ * @brief Echo source of the emulated sensor: the echo of the device for the same trigger
+ *
+ * @param p_arg Pointer to the replay
+ * @param ultrasound_id Ultrasound ID
+ * @param burst_us Virtual time of the rising edge of the echo
+ * @return Duration of the echo of the device. 0 if the device did not receive the falling edge
+ */
+static uint32_t _trace_replay_echo_us(void *p_arg, uint32_t ultrasound_id, uint64_t burst_us)
+{
+    trace_replay_t *p_replay = (trace_replay_t *)p_arg;
+    uint32_t now_ms = (uint32_t)(burst_us / 1000U);
+    uint32_t trigger_idx = _trace_replay_find(p_replay, p_replay->trigger_idx, PORT_TRACE_TRIGGER, ultrasound_id);
+    if (trigger_idx >= p_replay->num_records)
+    {
+        p_replay->triggers_extra++;
+        return 0;
+    }
+    p_replay->trigger_idx = trigger_idx + 1U;
+    p_replay->triggers++;
+    if (p_replay->p_records[trigger_idx].time_ms != now_ms)
+    {
+        p_replay->triggers_moved++;
+    }
+
+    uint32_t next_trigger_idx = _trace_replay_find(p_replay, trigger_idx + 1U, PORT_TRACE_TRIGGER, ultrasound_id);
+    uint32_t echo_idx = _trace_replay_find(p_replay, trigger_idx + 1U, PORT_TRACE_ECHO, ultrasound_id);
+    if (echo_idx >= next_trigger_idx) /* No falling edge in the device before its next trigger, or the trace ends */
+    {
+        return 0;
+    }
+    const port_trace_record_t *p_echo = &p_replay->p_records[echo_idx];
+    uint32_t init_tick = p_echo->arg32 & 0xFFFFU;
+    uint32_t end_tick = p_echo->arg32 >> 16;
+    p_replay->echoes++;
+    native_ultrasound_set_echo_counter(ultrasound_id, init_tick);
+    return (end_tick + (uint32_t)p_echo->arg16 * PORT_PARKING_SENSOR_ECHO_TIMER_TICKS) - init_tick;
+}
+
+/**
+ * @brief Feed the inputs of the device of the current millisecond to the FSMs
+ * @param p_replay Pointer to the replay
+ * @param p_fsm_rear Pointer to the ultrasound FSM
+ * @param now_ms Current virtual time
+ */
+static void _trace_replay_inputs(trace_replay_t *p_replay, fsm_ultrasound_t *p_fsm_rear, uint32_t now_ms)
+{
+    while ((p_replay->input_idx < p_replay->num_records) && (p_replay->p_records[p_replay->input_idx].time_ms <= now_ms))
+    {
+        const port_trace_record_t *p_record = &p_replay->p_records[p_replay->input_idx++];
+        switch (p_record->type)
+        {
+        case PORT_TRACE_BUTTON:
+            if (p_record->id == PORT_PARKING_BUTTON_ID)
+            {
+                native_button_set_value(PORT_PARKING_BUTTON_ID, p_record->arg16 != 0);
+            }
+            else
+            {
+                p_replay->ignored++;
+            }
+            break;
+        case PORT_TRACE_START:
+        case PORT_TRACE_STOP:
+        case PORT_TRACE_STATUS:
+            if (p_record->id != PORT_REAR_PARKING_SENSOR_ID)
+            {
+                p_replay->ignored++;
+            }
+            else if (p_record->type == PORT_TRACE_START)
+            {
+                fsm_ultrasound_start(p_fsm_rear);
+            }
+            else if (p_record->type == PORT_TRACE_STOP)
+            {
+                fsm_ultrasound_stop(p_fsm_rear);
+            }
+            else
+            {
+                fsm_ultrasound_set_status(p_fsm_rear, p_record->arg16 != 0);
+            }
+            break;
+        case PORT_TRACE_TRIGGER:
+        case PORT_TRACE_ECHO:
+        case PORT_TRACE_DISTANCE:
+        case PORT_TRACE_PRESS:
+            break; /* Read by the echo source and by the checks of the outputs */
+        default:
+            p_replay->ignored++;
+            break;
+        }
+    }
+}
+
+/**
+ * @brief Compare the outputs of the FSMs in the current millisecond with the ones of the device
+ * @param p_replay Pointer to the replay
+ * @param p_fsm_button Pointer to the button FSM
+ * @param p_fsm_rear Pointer to the ultrasound FSM
+ * @param now_ms Current virtual time
+ */
+static void _trace_replay_outputs(trace_replay_t *p_replay, fsm_button_t *p_fsm_button, fsm_ultrasound_t *p_fsm_rear, uint32_t now_ms)
+{
+    if (fsm_button_get_duration(p_fsm_button) > 0)
+    {
+        uint32_t duration_ms = fsm_button_get_duration(p_fsm_button);
+        fsm_button_reset_duration(p_fsm_button);
+        p_replay->press_idx = _trace_replay_find(p_replay, p_replay->press_idx, PORT_TRACE_PRESS, PORT_PARKING_BUTTON_ID);
+        if (p_replay->press_idx >= p_replay->num_records)
+        {
+            _trace_replay_report(p_replay, "extra press (ms)", now_ms, -1, duration_ms);
+        }
+        else
+        {
+            const port_trace_record_t *p_press = &p_replay->p_records[p_replay->press_idx++];
+            p_replay->presses++;
+            if (p_press->arg32 != duration_ms)
+            {
+                _trace_replay_report(p_replay, "press (ms)", p_press->time_ms, p_press->arg32, duration_ms);
+            }
+        }
+    }
+    if (fsm_ultrasound_get_new_measurement_ready(p_fsm_rear))
+    {
+        uint32_t raw_cm = fsm_ultrasound_get_raw_distance(p_fsm_rear);
+        uint32_t median_cm = fsm_ultrasound_get_distance(p_fsm_rear);
+        raw_cm = (raw_cm > TRACE_REPLAY_ARG16_MAX) ? TRACE_REPLAY_ARG16_MAX : raw_cm;
+        p_replay->distance_idx = _trace_replay_find(p_replay, p_replay->distance_idx, PORT_TRACE_DISTANCE, PORT_REAR_PARKING_SENSOR_ID);
+        if (p_replay->distance_idx >= p_replay->num_records)
+        {
+            _trace_replay_report(p_replay, "extra median (cm)", now_ms, -1, median_cm);
+            return;
+        }
+        const port_trace_record_t *p_distance = &p_replay->p_records[p_replay->distance_idx++];
+        p_replay->distances++;
+        if (p_distance->arg32 != median_cm)
+        {
+            _trace_replay_report(p_replay, "median (cm)", p_distance->time_ms, p_distance->arg32, median_cm);
+        }
+        if (p_distance->arg16 != raw_cm)
+        {
+            _trace_replay_report(p_replay, "raw distance (cm)", p_distance->time_ms, p_distance->arg16, raw_cm);
+        }
+    }
+}
+
+/**
+ * @brief Report the outputs of the device that the replay did not compute
+ * @param p_replay Pointer to the replay
+ * @param from_idx First record not compared
+ * @param type Type of the outputs
+ * @param id ID of the sensor or the button
+ * @param p_what Output
+ */
+static void _trace_replay_missing(trace_replay_t *p_replay, uint32_t from_idx, uint32_t type, uint32_t id, const char *p_what)
+{
+    for (uint32_t idx = _trace_replay_find(p_replay, from_idx, type, id); idx < p_replay->num_records; idx = _trace_replay_find(p_replay, idx + 1U, type, id))
+    {
+        _trace_replay_report(p_replay, p_what, p_replay->p_records[idx].time_ms, p_replay->p_records[idx].arg32, -1);
+    }
+}
+
+/**
+ * @brief Map a trace in memory and check its header
+ * @param p_path Path of the trace
+ * @param p_size Pointer to store the size of the mapping
+ * @return Pointer to the header of the trace. NULL if it cannot be read or it is not a valid trace
+ */
+static const port_trace_header_t *_trace_replay_map(const char *p_path, size_t *p_size)
+{
+    int fd = open(p_path, O_RDONLY);
+    if (fd < 0)
+    {
+        fprintf(stderr, "trace_replay: cannot open %s\n", p_path);
+        return NULL;
+    }
+    struct stat st;
+    void *p_map = MAP_FAILED;
+    if ((fstat(fd, &st) == 0) && ((size_t)st.st_size >= sizeof(port_trace_header_t)))
+    {
+        p_map = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    }
+    close(fd);
+    if (p_map == MAP_FAILED)
+    {
+        fprintf(stderr, "trace_replay: cannot map %s\n", p_path);
+        return NULL;
+    }
+
+    const port_trace_header_t *p_header = (const port_trace_header_t *)p_map;
+    *p_size = (size_t)st.st_size;
+    if ((p_header->magic != PORT_TRACE_MAGIC) || (p_header->version != PORT_TRACE_VERSION) || (p_header->record_size != sizeof(port_trace_record_t)) ||
+        ((*p_size - sizeof(port_trace_header_t)) / sizeof(port_trace_record_t) < p_header->num_records))
+    {
+        fprintf(stderr, "trace_replay: %s is not a trace of version %u, or it is truncated\n", p_path, PORT_TRACE_VERSION);
+        munmap(p_map, *p_size);
+        return NULL;
+    }
+    return p_header;
+}
+
+int main(int argc, char *argv[])
+{
+    trace_replay_t replay = {0};
+
+    int opt;
+    while ((opt = getopt(argc, argv, "vh")) != -1)
+    {
+        switch (opt)
+        {
+        case 'v':
+            replay.verbose = true;
+            break;
+        default:
+            _trace_replay_usage(argv[0]);
+            return EXIT_FAILURE;
+        }
+    }
+    if (optind != argc - 1)
+    {
+        _trace_replay_usage(argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    size_t map_size;
+    const port_trace_header_t *p_header = _trace_replay_map(argv[optind], &map_size);
+    if (p_header == NULL)
+    {
+        return EXIT_FAILURE;
+    }
+    replay.p_records = (const port_trace_record_t *)(p_header + 1);
+    replay.num_records = p_header->num_records;
+    if (p_header->dropped > 0)
+    {
+        printf("The trace is full: %" PRIu32 " records were dropped by the device, the replay stops at the last record\n", p_header->dropped);
+    }
+
+    /* Urbanite */
+    port_system_init();
+    fsm_button_t *p_fsm_button = fsm_button_new(PORT_PARKING_BUTTON_DEBOUNCE_TIME_MS, PORT_PARKING_BUTTON_ID);
+    fsm_ultrasound_t *p_fsm_rear = fsm_ultrasound_new(PORT_REAR_PARKING_SENSOR_ID);
+    native_ultrasound_set_echo_source(PORT_REAR_PARKING_SENSOR_ID, _trace_replay_echo_us, &replay);
+
+    /* Replay, one millisecond of virtual time at a time */
+    uint32_t end_ms = (replay.num_records > 0) ? replay.p_records[replay.num_records - 1U].time_ms + TRACE_REPLAY_TAIL_MS : 0;
+    double start_s = _trace_replay_wall_s();
+    for (uint32_t now_ms = port_system_get_millis(); now_ms < end_ms; now_ms++)
+    {
+        _trace_replay_inputs(&replay, p_fsm_rear, now_ms);
+        native_system_advance_ms(1);
+        fsm_button_fire(p_fsm_button);
+        fsm_ultrasound_fire(p_fsm_rear);
+        _trace_replay_outputs(&replay, p_fsm_button, p_fsm_rear, now_ms + 1U);
+    }
+    double wall_s = _trace_replay_wall_s() - start_s;
+    _trace_replay_missing(&replay, replay.distance_idx, PORT_TRACE_DISTANCE, PORT_REAR_PARKING_SENSOR_ID, "missing median (cm)");
+    _trace_replay_missing(&replay, replay.press_idx, PORT_TRACE_PRESS, PORT_PARKING_BUTTON_ID, "missing press (ms)");
+
+    /* Results */
+    printf("Replay of %" PRIu32 " records, %.1f s of the device\n", replay.num_records, end_ms / 1000.0);
+    printf("  Triggers: %" PRIu64 " (%" PRIu64 " in another millisecond, %" PRIu64 " not done by the device), echoes: %" PRIu64 "\n", replay.triggers, replay.triggers_moved, replay.triggers_extra, replay.echoes);
+    printf("  Outputs compared: %" PRIu64 " medians, %" PRIu64 " presses. Differences: %" PRIu64 "\n", replay.distances, replay.presses, replay.differences);
+    if (replay.ignored > 0)
+    {
+        printf("  Records ignored (other sensors or buttons): %" PRIu64 "\n", replay.ignored);
+    }
+    printf("  %.3f s of real time: %.0fx real time\n", wall_s, (wall_s > 0) ? end_ms / 1000.0 / wall_s : 0.0);
+
+    native_ultrasound_set_echo_source(PORT_REAR_PARKING_SENSOR_ID, NULL, NULL);
+    fsm_button_destroy(p_fsm_button);
+    fsm_ultrasound_destroy(p_fsm_rear);
+    munmap((void *)p_header, map_size);
+    return (replay.differences == 0) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
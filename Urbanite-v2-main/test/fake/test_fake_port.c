@@ -0,0 +1,157 @@
+/**
+ * @file test_fake_port.c
+ * @brief Unit test of the fake port used by the common FSM tests on the host.
+ *
+ * It checks the history of calls, the scripted and fixed return values, the state kept by the behaviours, and the software timers on the fake clock.
+ *
+ * @date 2025-01-01
+ */
+/* System dependent libraries */
+#include <stdlib.h>
+#include <string.h>
+#include <unity.h>
+
+/* HW dependent libraries */
+#include "port_button.h"
+#include "port_system.h"
+#include "port_timer.h"
+#include "port_ultrasound.h"
+#include "fake_port.h"
+
+/* Defines and enums ----------------------------------------------------------*/
+#define TEST_SENSOR_ID 0U /*!< Sensor of the tests @hideinitializer */
+
+/* Private variables ---------------------------------------------------------*/
+static uint32_t timer_calls = 0;     /*!< Expiries of the timer under test */
+static uint64_t timer_last_us = 0;   /*!< Fake clock at the last expiry */
+
+/* Private functions ---------------------------------------------------------*/
+/**
+ * @brief Callback of the timer under test
+ * @param p_arg Not used
+ */
+static void _test_timer_callback(void *p_arg)
+{
+    timer_calls++;
+    timer_last_us = fake_port_get_time_us();
+}
+
+void setUp(void)
+{
+    fake_port_reset();
+    port_system_init();
+    timer_calls = 0;
+    timer_last_us = 0;
+}
+
+void tearDown(void)
+{
+}
+
+/* Tests ---------------------------------------------------------------------*/
+void test_history(void)
+{
+    fake_port_clear_calls();
+    fake_port_advance_us(250U);
+    port_ultrasound_set_echo_init_tick(TEST_SENSOR_ID, 1234U);
+    port_button_set_pressed(PORT_PARKING_BUTTON_ID, true);
+
+    UNITY_TEST_ASSERT_EQUAL_UINT32(2, fake_port_get_num_calls(), __LINE__, "ERROR: Every call must be recorded");
+    const fake_port_call_t *p_call = fake_port_get_call(0);
+    UNITY_TEST_ASSERT_EQUAL_UINT32(FAKE_PORT_FN_ULTRASOUND_SET_ECHO_INIT_TICK, p_call->fn, __LINE__, "ERROR: The history must keep the oldest call first");
+    UNITY_TEST_ASSERT_EQUAL_UINT32(2, p_call->num_args, __LINE__, "ERROR: The call must keep its number of arguments");
+    UNITY_TEST_ASSERT_EQUAL_UINT32(1234U, p_call->args_arr[1], __LINE__, "ERROR: The call must keep its arguments");
+    UNITY_TEST_ASSERT_EQUAL_UINT32(250U, p_call->time_us, __LINE__, "ERROR: The call must keep the fake clock");
+    UNITY_TEST_ASSERT(fake_port_get_call(2) == NULL, __LINE__, "ERROR: There must be no call beyond the history");
+    UNITY_TEST_ASSERT(strcmp("port_button_set_pressed", fake_port_get_name(fake_port_get_call(1)->fn)) == 0, __LINE__, "ERROR: The functions must keep their names");
+
+    for (uint32_t i = 0; i < FAKE_PORT_HISTORY_SIZE; i++)
+    {
+        port_system_get_millis();
+    }
+    UNITY_TEST_ASSERT_EQUAL_UINT32(FAKE_PORT_HISTORY_SIZE, fake_port_get_num_calls(), __LINE__, "ERROR: The history must not grow beyond its size");
+    UNITY_TEST_ASSERT_EQUAL_UINT32(FAKE_PORT_HISTORY_SIZE, fake_port_count_calls(FAKE_PORT_FN_SYSTEM_GET_MILLIS), __LINE__, "ERROR: The calls must be counted");
+    UNITY_TEST_ASSERT(fake_port_get_last_call(FAKE_PORT_FN_BUTTON_SET_PRESSED) == NULL, __LINE__, "ERROR: A call overwritten in the history must not be returned");
+}
+
+void test_scripted_returns(void)
+{
+    port_ultrasound_set_echo_end_tick(TEST_SENSOR_ID, 10U);
+
+    const uint32_t ticks_arr[] = {7U, 8U};
+    fake_port_script_returns(FAKE_PORT_FN_ULTRASOUND_GET_ECHO_END_TICK, ticks_arr, 2U);
+    UNITY_TEST_ASSERT_EQUAL_UINT32(7U, port_ultrasound_get_echo_end_tick(TEST_SENSOR_ID), __LINE__, "ERROR: The first scripted value must be returned first");
+    UNITY_TEST_ASSERT_EQUAL_UINT32(8U, port_ultrasound_get_echo_end_tick(TEST_SENSOR_ID), __LINE__, "ERROR: The scripted values must be returned in order");
+    UNITY_TEST_ASSERT_EQUAL_UINT32(10U, port_ultrasound_get_echo_end_tick(TEST_SENSOR_ID), __LINE__, "ERROR: The behaviour must run when the script is over");
+
+    fake_port_set_return(FAKE_PORT_FN_ULTRASOUND_GET_ECHO_END_TICK, 99U);
+    UNITY_TEST_ASSERT_EQUAL_UINT32(99U, port_ultrasound_get_echo_end_tick(TEST_SENSOR_ID), __LINE__, "ERROR: The fixed value must replace the behaviour");
+    fake_port_script_returns(FAKE_PORT_FN_ULTRASOUND_GET_ECHO_END_TICK, ticks_arr, 1U);
+    UNITY_TEST_ASSERT_EQUAL_UINT32(7U, port_ultrasound_get_echo_end_tick(TEST_SENSOR_ID), __LINE__, "ERROR: The script must come before the fixed value");
+    UNITY_TEST_ASSERT_EQUAL_UINT32(99U, port_ultrasound_get_echo_end_tick(TEST_SENSOR_ID), __LINE__, "ERROR: The fixed value must be kept");
+}
+
+void test_fake_clock(void)
+{
+    port_system_delay_ms(5U);
+    UNITY_TEST_ASSERT_EQUAL_UINT32(5U, port_system_get_millis(), __LINE__, "ERROR: The delays must advance the fake clock");
+    UNITY_TEST_ASSERT_EQUAL_UINT32(5000U * FAKE_PORT_CYCLES_PER_US, port_system_get_cycles(), __LINE__, "ERROR: The cycles must follow the fake clock");
+
+    uint32_t t = port_system_get_millis();
+    port_system_delay_until_ms(&t, 20U);
+    UNITY_TEST_ASSERT_EQUAL_UINT32(25U, t, __LINE__, "ERROR: The delay must end at the requested time");
+
+    port_system_set_millis(1000U);
+    UNITY_TEST_ASSERT_EQUAL_UINT32(1000U, port_system_get_millis(), __LINE__, "ERROR: The fake clock must be settable");
+}
+
+void test_timers_on_the_fake_clock(void)
+{
+    port_timer_t timer;
+    port_timer_setup(&timer, _test_timer_callback, NULL);
+    port_timer_start(&timer, 1500U, 1000U);
+
+    fake_port_advance_us(1499U);
+    UNITY_TEST_ASSERT_EQUAL_UINT32(0, timer_calls, __LINE__, "ERROR: The timer must not expire early");
+    fake_port_advance_us(3001U);
+    UNITY_TEST_ASSERT_EQUAL_UINT32(4, timer_calls, __LINE__, "ERROR: Every period must expire while the clock is advanced");
+    UNITY_TEST_ASSERT_EQUAL_UINT32(4500U, timer_last_us, __LINE__, "ERROR: The timers must expire at their time");
+
+    port_system_enter_critical();
+    fake_port_advance_us(1000U);
+    UNITY_TEST_ASSERT_EQUAL_UINT32(4, timer_calls, __LINE__, "ERROR: A critical section must mask the timers");
+    port_system_exit_critical();
+    UNITY_TEST_ASSERT_EQUAL_UINT32(5, timer_calls, __LINE__, "ERROR: A masked timer must expire when the critical section ends");
+    port_timer_cancel(&timer);
+}
+
+void test_ultrasound_behaviour(void)
+{
+    port_ultrasound_init(TEST_SENSOR_ID);
+    port_ultrasound_start_measurement(TEST_SENSOR_ID);
+    UNITY_TEST_ASSERT(!port_ultrasound_get_trigger_ready(TEST_SENSOR_ID), __LINE__, "ERROR: A measurement must clear the trigger ready flag");
+    UNITY_TEST_ASSERT(fake_port_get_trigger_timer_running(TEST_SENSOR_ID), __LINE__, "ERROR: A measurement must start the trigger timer");
+
+    fake_port_advance_us((uint32_t)PORT_PARKING_SENSOR_TRIGGER_UP_US);
+    UNITY_TEST_ASSERT(port_ultrasound_get_trigger_end(TEST_SENSOR_ID), __LINE__, "ERROR: The trigger signal must end on the fake clock");
+    fake_port_advance_us(PORT_PARKING_SENSOR_TIMEOUT_US);
+    UNITY_TEST_ASSERT(port_ultrasound_get_trigger_ready(TEST_SENSOR_ID), __LINE__, "ERROR: The measurement timer must set the trigger ready flag");
+
+    port_ultrasound_set_echo_overflows(TEST_SENSOR_ID, 2U);
+    port_ultrasound_stop_ultrasound(TEST_SENSOR_ID);
+    UNITY_TEST_ASSERT_EQUAL_UINT32(0, port_ultrasound_get_echo_overflows(TEST_SENSOR_ID), __LINE__, "ERROR: Stopping the sensor must reset its ticks");
+    UNITY_TEST_ASSERT(!port_ultrasound_get_measurement_timer_running(TEST_SENSOR_ID), __LINE__, "ERROR: Stopping the sensor must stop the measurement timer");
+    UNITY_TEST_ASSERT_EQUAL_UINT32(1, fake_port_count_calls(FAKE_PORT_FN_ULTRASOUND_STOP_ULTRASOUND), __LINE__, "ERROR: The calls of the behaviours must not be recorded");
+    UNITY_TEST_ASSERT_EQUAL_UINT32(0, fake_port_count_calls(FAKE_PORT_FN_ULTRASOUND_STOP_TRIGGER_TIMER), __LINE__, "ERROR: The calls of the behaviours must not be recorded");
+}
+
+int main(void)
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_history);
+    RUN_TEST(test_scripted_returns);
+    RUN_TEST(test_fake_clock);
+    RUN_TEST(test_timers_on_the_fake_clock);
+    RUN_TEST(test_ultrasound_behaviour);
+    exit(UNITY_END());
+}
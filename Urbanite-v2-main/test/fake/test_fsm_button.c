@@ -0,0 +1,118 @@
+/**
+ * @file test_fsm_button.c
+ * @brief Unit test for the button FSM on the host, against the fake port.
+ *
+ * The button is pressed and released with `port_button_set_pressed()` and the anti-debounce time elapses on the fake clock, so the test checks the durations measured by the FSM to the millisecond without a board.
+ *
+ * @date 2025-01-01
+ */
+/* System dependent libraries */
+#include <stdlib.h>
+#include <unity.h>
+
+/* HW dependent libraries */
+#include "port_button.h"
+#include "port_system.h"
+#include "fake_port.h"
+
+/* Include FSM libraries */
+#include "fsm.h"
+#include "fsm_button.h"
+
+/* Defines and enums ----------------------------------------------------------*/
+#define TEST_DEBOUNCE_TIME_MS 100U /*!< Anti-debounce time of the FSM under test @hideinitializer */
+
+/* Global variables ----------------------------------------------------------*/
+static fsm_button_t *p_fsm_button; /*!< Pointer to the button FSM */
+
+/* Private functions ---------------------------------------------------------*/
+/**
+ * @brief Advance the fake clock one millisecond at a time, firing the FSM after each one
+ * @param ms Milliseconds to advance
+ */
+static void _test_run_ms(uint32_t ms)
+{
+    for (uint32_t i = 0; i < ms; i++)
+    {
+        fake_port_advance_ms(1);
+        fsm_button_fire(p_fsm_button);
+    }
+}
+
+void setUp(void)
+{
+    fake_port_reset();
+    port_system_init();
+    p_fsm_button = fsm_button_new(TEST_DEBOUNCE_TIME_MS, PORT_PARKING_BUTTON_ID);
+}
+
+void tearDown(void)
+{
+    fsm_button_destroy(p_fsm_button);
+}
+
+/* Tests ---------------------------------------------------------------------*/
+void test_press_duration(void)
+{
+    UNITY_TEST_ASSERT_EQUAL_UINT32(1, fake_port_count_calls(FAKE_PORT_FN_BUTTON_INIT), __LINE__, "ERROR: The FSM must initialize its button");
+
+    port_button_set_pressed(PORT_PARKING_BUTTON_ID, true);
+    _test_run_ms(1);
+    UNITY_TEST_ASSERT_EQUAL_INT(BUTTON_PRESSED_WAIT, fsm_button_get_state(p_fsm_button), __LINE__, "ERROR: The FSM must wait for the anti-debounce time after a press");
+
+    _test_run_ms(TEST_DEBOUNCE_TIME_MS);
+    UNITY_TEST_ASSERT_EQUAL_INT(BUTTON_PRESSED, fsm_button_get_state(p_fsm_button), __LINE__, "ERROR: The anti-debounce time must expire on the fake clock");
+
+    _test_run_ms(400U);
+    port_button_set_pressed(PORT_PARKING_BUTTON_ID, false);
+    _test_run_ms(1);
+    UNITY_TEST_ASSERT_EQUAL_INT(BUTTON_RELEASED_WAIT, fsm_button_get_state(p_fsm_button), __LINE__, "ERROR: The FSM must wait for the anti-debounce time after a release");
+    UNITY_TEST_ASSERT_EQUAL_UINT32(TEST_DEBOUNCE_TIME_MS + 401U, fsm_button_get_duration(p_fsm_button), __LINE__, "ERROR: The duration must be measured on the fake clock");
+
+    _test_run_ms(TEST_DEBOUNCE_TIME_MS);
+    UNITY_TEST_ASSERT_EQUAL_INT(BUTTON_RELEASED, fsm_button_get_state(p_fsm_button), __LINE__, "ERROR: The FSM must return to BUTTON_RELEASED");
+    UNITY_TEST_ASSERT_EQUAL_UINT32(0, fake_port_get_critical_nesting(), __LINE__, "ERROR: The FSM must leave every critical section it enters");
+}
+
+void test_debounce_masks_the_button(void)
+{
+    port_button_set_pressed(PORT_PARKING_BUTTON_ID, true);
+    _test_run_ms(1);
+
+    fake_port_clear_calls();
+    _test_run_ms(TEST_DEBOUNCE_TIME_MS - 1U);
+    UNITY_TEST_ASSERT_EQUAL_UINT32(0, fake_port_count_calls(FAKE_PORT_FN_BUTTON_GET_PRESSED), __LINE__, "ERROR: The button must not be read during the anti-debounce time");
+    _test_run_ms(1);
+    UNITY_TEST_ASSERT_EQUAL_INT(BUTTON_PRESSED, fsm_button_get_state(p_fsm_button), __LINE__, "ERROR: The press must be accepted after the anti-debounce time");
+
+    /* The button is released on the third read */
+    const uint32_t pressed_arr[] = {true, true, false};
+    fake_port_script_returns(FAKE_PORT_FN_BUTTON_GET_PRESSED, pressed_arr, sizeof(pressed_arr) / sizeof(pressed_arr[0]));
+    _test_run_ms(2);
+    UNITY_TEST_ASSERT_EQUAL_INT(BUTTON_PRESSED, fsm_button_get_state(p_fsm_button), __LINE__, "ERROR: The FSM must stay in BUTTON_PRESSED while the button is pressed");
+    _test_run_ms(1);
+    UNITY_TEST_ASSERT_EQUAL_INT(BUTTON_RELEASED_WAIT, fsm_button_get_state(p_fsm_button), __LINE__, "ERROR: The FSM must detect the scripted release");
+    UNITY_TEST_ASSERT_EQUAL_UINT32(TEST_DEBOUNCE_TIME_MS + 3U, fsm_button_get_duration(p_fsm_button), __LINE__, "ERROR: The duration must end at the scripted release");
+
+    const fake_port_call_t *p_call = fake_port_get_last_call(FAKE_PORT_FN_BUTTON_GET_PRESSED);
+    UNITY_TEST_ASSERT(p_call != NULL, __LINE__, "ERROR: The reads of the button must be recorded");
+    UNITY_TEST_ASSERT_EQUAL_UINT32(PORT_PARKING_BUTTON_ID, p_call->args_arr[0], __LINE__, "ERROR: The FSM must read its own button");
+}
+
+void test_check_activity(void)
+{
+    UNITY_TEST_ASSERT(!fsm_button_check_activity(p_fsm_button), __LINE__, "ERROR: A released button must not report activity");
+
+    port_button_set_pressed(PORT_PARKING_BUTTON_ID, true);
+    _test_run_ms(1);
+    UNITY_TEST_ASSERT(fsm_button_check_activity(p_fsm_button), __LINE__, "ERROR: A pressed button must report activity");
+}
+
+int main(void)
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_press_duration);
+    RUN_TEST(test_debounce_masks_the_button);
+    RUN_TEST(test_check_activity);
+    exit(UNITY_END());
+}
@@ -0,0 +1,175 @@
+/**
+ * @file test_fsm_ultrasound_bank.c
+ * @brief Unit test for the bank of ultrasound FSMs on the host, against the fake port.
+ *
+ * More FSMs than the slots of a bank are created, so the sensors share the packed arrays of the banks. Every FSM is taken through its measurements with different echoes, and each one must keep its own window, median, raw distance and flags, also against the FSMs of a bank of the caller.
+ *
+ * @date 2025-01-01
+ */
+/* System dependent libraries */
+#include <stdlib.h>
+#include <unity.h>
+
+/* HW dependent libraries */
+#include "port_ultrasound.h"
+#include "port_system.h"
+#include "fake_port.h"
+
+/* Include FSM libraries */
+#include "fsm.h"
+#include "fsm_ultrasound.h"
+#include "distance_pipeline.h"
+
+/* Defines and enums ----------------------------------------------------------*/
+#define TEST_NUM_FSMS (DISTANCE_BATCH_MAX_SENSORS + 2U) /*!< FSMs under test: the first bank and part of a second one @hideinitializer */
+#define TEST_SENSOR_ID 0U                               /*!< Sensor of the fake port behind all the FSMs @hideinitializer */
+
+/* Global variables ----------------------------------------------------------*/
+static fsm_ultrasound_t *fsm_arr[TEST_NUM_FSMS]; /*!< FSMs under test */
+
+/* Private functions ---------------------------------------------------------*/
+/**
+ * @brief Complete a measurement of an FSM with an echo of the given distance
+ * @param p_fsm Pointer to the FSM
+ * @param distance_cm Distance of the echo, in cm
+ */
+static void _test_measure(fsm_ultrasound_t *p_fsm, uint32_t distance_cm)
+{
+    fsm_ultrasound_set_state(p_fsm, WAIT_ECHO_END);
+    port_ultrasound_set_echo_init_tick(TEST_SENSOR_ID, 1);
+    port_ultrasound_set_echo_end_tick(TEST_SENSOR_ID, 1U + (distance_cm * 20000U + SPEED_OF_SOUND_MS - 1U) / SPEED_OF_SOUND_MS); /* Rounded up, so the distance is not truncated below */
+    port_ultrasound_set_echo_overflows(TEST_SENSOR_ID, 0);
+    port_ultrasound_set_echo_received(TEST_SENSOR_ID, true);
+    fsm_ultrasound_fire(p_fsm);
+}
+
+void setUp(void)
+{
+    fake_port_reset();
+    port_system_init();
+    for (uint32_t i = 0; i < TEST_NUM_FSMS; i++)
+    {
+        fsm_arr[i] = fsm_ultrasound_new(TEST_SENSOR_ID);
+    }
+}
+
+void tearDown(void)
+{
+    for (uint32_t i = 0; i < TEST_NUM_FSMS; i++)
+    {
+        fsm_ultrasound_destroy(fsm_arr[i]);
+    }
+}
+
+/* Tests ---------------------------------------------------------------------*/
+void test_independent_windows(void)
+{
+    /* The measurements of the FSMs are interleaved, so every sensor fills its own lane of the window */
+    for (uint32_t k = 0; k < FSM_ULTRASOUND_NUM_MEASUREMENTS; k++)
+    {
+        for (uint32_t i = 0; i < TEST_NUM_FSMS; i++)
+        {
+            _test_measure(fsm_arr[i], 10U * (i + 1U) + k);
+            UNITY_TEST_ASSERT_EQUAL_UINT32(10U * (i + 1U) + k, fsm_ultrasound_get_raw_distance(fsm_arr[i]), __LINE__, "ERROR: The raw distance of an FSM is not the one of its last echo");
+        }
+    }
+
+    for (uint32_t i = 0; i < TEST_NUM_FSMS; i++)
+    {
+        UNITY_TEST_ASSERT(fsm_ultrasound_get_new_measurement_ready(fsm_arr[i]), __LINE__, "ERROR: Every FSM must have a median after its window is full");
+        UNITY_TEST_ASSERT_EQUAL_UINT32(DISTANCE_RECORD_CONFIDENCE_MAX, fsm_ultrasound_get_confidence(fsm_arr[i]), __LINE__, "ERROR: Without a stage that lowers it, the confidence of a median must be the maximum");
+        UNITY_TEST_ASSERT_EQUAL_UINT32(10U * (i + 1U) + FSM_ULTRASOUND_NUM_MEASUREMENTS / 2U, fsm_ultrasound_get_distance(fsm_arr[i]), __LINE__, "ERROR: The median of an FSM is not the one of its own window");
+        UNITY_TEST_ASSERT(!fsm_ultrasound_get_new_measurement_ready(fsm_arr[i]), __LINE__, "ERROR: Reading the median must clear the new measurement of the FSM");
+    }
+}
+
+void test_noisy_confidence(void)
+{
+    static const uint32_t noisy_arr[FSM_ULTRASOUND_NUM_MEASUREMENTS] = {100, 60, 150, 95, 40}; /* Echoes of rain or of a kerb */
+    for (uint32_t k = 0; k < FSM_ULTRASOUND_NUM_MEASUREMENTS; k++)
+    {
+        _test_measure(fsm_arr[0], 100);
+        _test_measure(fsm_arr[1], noisy_arr[k]);
+    }
+    UNITY_TEST_ASSERT_EQUAL_UINT32(DISTANCE_RECORD_CONFIDENCE_MAX, fsm_ultrasound_get_confidence(fsm_arr[0]), __LINE__, "ERROR: A steady window must have full confidence");
+    UNITY_TEST_ASSERT(fsm_ultrasound_get_confidence(fsm_arr[1]) < DISTANCE_RECORD_CONFIDENCE_MAX / 2U, __LINE__, "ERROR: The default pipeline must lower the confidence of a noisy window");
+    UNITY_TEST_ASSERT(fsm_ultrasound_get_new_measurement_ready(fsm_arr[1]), __LINE__, "ERROR: A noisy median must still be reported, not held back");
+}
+
+void test_independent_flags(void)
+{
+    fsm_ultrasound_set_status(fsm_arr[1], true);
+    fsm_ultrasound_set_status(fsm_arr[TEST_NUM_FSMS - 1U], true);
+
+    for (uint32_t i = 0; i < TEST_NUM_FSMS; i++)
+    {
+        bool expected = (i == 1U) || (i == TEST_NUM_FSMS - 1U);
+        UNITY_TEST_ASSERT_EQUAL_UINT32(expected, fsm_ultrasound_get_status(fsm_arr[i]), __LINE__, "ERROR: The status of an FSM is changed by another FSM");
+    }
+}
+
+void test_reuse_slot(void)
+{
+    for (uint32_t k = 0; k < FSM_ULTRASOUND_NUM_MEASUREMENTS; k++)
+    {
+        _test_measure(fsm_arr[2], 300);
+    }
+    fsm_ultrasound_destroy(fsm_arr[2]);
+    fsm_arr[2] = fsm_ultrasound_new(TEST_SENSOR_ID);
+
+    UNITY_TEST_ASSERT(fsm_arr[2] != NULL, __LINE__, "ERROR: A freed slot must be reused");
+    UNITY_TEST_ASSERT_EQUAL_INT(WAIT_START, fsm_ultrasound_get_state(fsm_arr[2]), __LINE__, "ERROR: A new FSM must start in WAIT_START");
+    UNITY_TEST_ASSERT(!fsm_ultrasound_get_new_measurement_ready(fsm_arr[2]), __LINE__, "ERROR: A new FSM must not have a median of the previous one");
+    UNITY_TEST_ASSERT_EQUAL_UINT32(0, fsm_ultrasound_get_distance(fsm_arr[2]), __LINE__, "ERROR: A new FSM must not keep the median of the previous one");
+    UNITY_TEST_ASSERT_EQUAL_UINT32(0, fsm_ultrasound_get_raw_distance(fsm_arr[2]), __LINE__, "ERROR: A new FSM must not keep the raw distance of the previous one");
+    UNITY_TEST_ASSERT_EQUAL_UINT32(0, fsm_ultrasound_get_confidence(fsm_arr[2]), __LINE__, "ERROR: A new FSM must not keep the confidence of the previous one");
+}
+
+void test_own_bank(void)
+{
+    fsm_ultrasound_bank_t *p_bank = fsm_ultrasound_bank_new();
+    fsm_ultrasound_t *own_fsm_arr[TEST_NUM_FSMS];
+    UNITY_TEST_ASSERT(p_bank != NULL, __LINE__, "ERROR: A new bank must be allocated");
+    for (uint32_t i = 0; i < TEST_NUM_FSMS; i++)
+    {
+        own_fsm_arr[i] = fsm_ultrasound_new_in_bank(p_bank, TEST_SENSOR_ID);
+        UNITY_TEST_ASSERT(own_fsm_arr[i] != NULL, __LINE__, "ERROR: A bank must take more FSMs than its slots");
+        UNITY_TEST_ASSERT(own_fsm_arr[i] != fsm_arr[i], __LINE__, "ERROR: The FSMs of a bank must not take the slots of the static bank");
+    }
+
+    /* The FSMs of the own bank and of the static one have their own windows */
+    for (uint32_t k = 0; k < FSM_ULTRASOUND_NUM_MEASUREMENTS; k++)
+    {
+        for (uint32_t i = 0; i < TEST_NUM_FSMS; i++)
+        {
+            _test_measure(fsm_arr[i], 20U);
+            _test_measure(own_fsm_arr[i], 100U + i);
+        }
+    }
+    for (uint32_t i = 0; i < TEST_NUM_FSMS; i++)
+    {
+        UNITY_TEST_ASSERT_EQUAL_UINT32(20U, fsm_ultrasound_get_distance(fsm_arr[i]), __LINE__, "ERROR: The median of an FSM of the static bank is changed by another bank");
+        UNITY_TEST_ASSERT_EQUAL_UINT32(100U + i, fsm_ultrasound_get_distance(own_fsm_arr[i]), __LINE__, "ERROR: The median of an FSM of a bank is not the one of its own window");
+    }
+
+    /* Destroying the FSMs frees the banks of the chain allocated after the own bank, but not the own bank */
+    for (uint32_t i = 0; i < TEST_NUM_FSMS; i++)
+    {
+        fsm_ultrasound_destroy(own_fsm_arr[i]);
+    }
+    own_fsm_arr[0] = fsm_ultrasound_new_in_bank(p_bank, TEST_SENSOR_ID);
+    UNITY_TEST_ASSERT(own_fsm_arr[0] != NULL, __LINE__, "ERROR: The own bank must be kept when all its FSMs are destroyed");
+    fsm_ultrasound_destroy(own_fsm_arr[0]);
+    fsm_ultrasound_bank_destroy(p_bank);
+}
+
+int main(void)
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_independent_windows);
+    RUN_TEST(test_noisy_confidence);
+    RUN_TEST(test_independent_flags);
+    RUN_TEST(test_reuse_slot);
+    RUN_TEST(test_own_bank);
+    exit(UNITY_END());
+}
@@ -0,0 +1,185 @@
+/**
+ * @file test_fsm_ultrasound_zone.c
+ * @brief Unit test for the proximity zones of the ultrasound FSM on the host, against the fake port.
+ *
+ * The distances are fed to the FSM as full windows of equal echoes, so every window gives one distance out of the pipeline. The zone must follow the thresholds with their hysteresis band, and the zone changed flag must only be raised, and the zone callback only called, when the zone changes.
+ *
+ * @date 2025-01-01
+ */
+/* System dependent libraries */
+#include <stdlib.h>
+#include <unity.h>
+
+/* HW dependent libraries */
+#include "port_ultrasound.h"
+#include "port_system.h"
+#include "fake_port.h"
+
+/* Include FSM libraries */
+#include "fsm.h"
+#include "fsm_ultrasound.h"
+
+/* Defines and enums ----------------------------------------------------------*/
+#define TEST_SENSOR_ID 0U /*!< Sensor of the fake port behind the FSMs @hideinitializer */
+
+/* Global variables ----------------------------------------------------------*/
+static fsm_ultrasound_t *p_fsm_a; /*!< FSM under test */
+static fsm_ultrasound_t *p_fsm_b; /*!< Second FSM, to check that the zones of the sensors are independent */
+static uint32_t callback_calls;    /*!< Calls to the zone callback */
+static fsm_ultrasound_t *p_callback_fsm; /*!< FSM given to the last call of the zone callback */
+static fsm_ultrasound_zone_t callback_zone; /*!< Zone given to the last call of the zone callback */
+
+/* Private functions ---------------------------------------------------------*/
+/**
+ * @brief Complete a window of measurements of an FSM with echoes of the given distance
+ * @param p_fsm Pointer to the FSM
+ * @param distance_cm Distance of the echoes, in cm
+ */
+static void _test_distance(fsm_ultrasound_t *p_fsm, uint32_t distance_cm)
+{
+    for (uint32_t k = 0; k < FSM_ULTRASOUND_NUM_MEASUREMENTS; k++)
+    {
+        fsm_ultrasound_set_state(p_fsm, WAIT_ECHO_END);
+        port_ultrasound_set_echo_init_tick(TEST_SENSOR_ID, 1);
+        port_ultrasound_set_echo_end_tick(TEST_SENSOR_ID, 1U + (distance_cm * 20000U + SPEED_OF_SOUND_MS - 1U) / SPEED_OF_SOUND_MS); /* Rounded up, so the distance is not truncated below */
+        port_ultrasound_set_echo_overflows(TEST_SENSOR_ID, 0);
+        port_ultrasound_set_echo_received(TEST_SENSOR_ID, true);
+        fsm_ultrasound_fire(p_fsm);
+    }
+    UNITY_TEST_ASSERT_EQUAL_UINT32(distance_cm, fsm_ultrasound_get_distance(p_fsm), __LINE__, "ERROR: The window does not give the distance of its echoes");
+}
+
+/**
+ * @brief Check the zone of the FSM under test after a distance
+ * @param distance_cm Distance of the echoes, in cm
+ * @param changed Whether the zone must change
+ * @param zone Zone expected
+ * @param line Line of the test, for the messages
+ */
+static void _test_zone(uint32_t distance_cm, bool changed, fsm_ultrasound_zone_t zone, uint32_t line)
+{
+    _test_distance(p_fsm_a, distance_cm);
+    UNITY_TEST_ASSERT_EQUAL_UINT32(changed, fsm_ultrasound_get_zone_changed(p_fsm_a), line, "ERROR: The zone changed flag must only be raised when the zone changes");
+    UNITY_TEST_ASSERT_EQUAL_INT(zone, fsm_ultrasound_get_zone(p_fsm_a), line, "ERROR: The zone of the distance is not correct");
+    UNITY_TEST_ASSERT(!fsm_ultrasound_get_zone_changed(p_fsm_a), line, "ERROR: Reading the zone must reset the zone changed flag");
+}
+
+/**
+ * @brief Zone callback of the tests: keep the arguments of the call
+ * @param p_fsm Pointer to the FSM whose zone changed
+ * @param zone New zone
+ * @param p_arg Argument of the callback: the counter of calls
+ */
+static void _test_zone_callback(fsm_ultrasound_t *p_fsm, fsm_ultrasound_zone_t zone, void *p_arg)
+{
+    (*(uint32_t *)p_arg)++;
+    p_callback_fsm = p_fsm;
+    callback_zone = zone;
+}
+
+void setUp(void)
+{
+    fake_port_reset();
+    port_system_init();
+    p_fsm_a = fsm_ultrasound_new(TEST_SENSOR_ID);
+    p_fsm_b = fsm_ultrasound_new(TEST_SENSOR_ID);
+    callback_calls = 0;
+    p_callback_fsm = NULL;
+    fsm_ultrasound_start(p_fsm_a);
+    fsm_ultrasound_start(p_fsm_b);
+}
+
+void tearDown(void)
+{
+    fsm_ultrasound_destroy(p_fsm_a);
+    fsm_ultrasound_destroy(p_fsm_b);
+}
+
+/* Tests ---------------------------------------------------------------------*/
+void test_change_only(void)
+{
+    UNITY_TEST_ASSERT_EQUAL_INT(ULTRASOUND_ZONE_NONE, fsm_ultrasound_get_zone(p_fsm_a), __LINE__, "ERROR: There must be no zone before the first distance");
+    _test_zone(200, true, ULTRASOUND_ZONE_FAR, __LINE__);
+    _test_zone(200, false, ULTRASOUND_ZONE_FAR, __LINE__);
+    _test_zone(170, false, ULTRASOUND_ZONE_FAR, __LINE__);
+    _test_zone(10, true, ULTRASOUND_ZONE_CRITICAL, __LINE__);
+    _test_zone(12, false, ULTRASOUND_ZONE_CRITICAL, __LINE__);
+
+    fsm_ultrasound_stop(p_fsm_a);
+    fsm_ultrasound_start(p_fsm_a);
+    UNITY_TEST_ASSERT_EQUAL_INT(ULTRASOUND_ZONE_NONE, fsm_ultrasound_get_zone(p_fsm_a), __LINE__, "ERROR: A start must forget the zone");
+    _test_zone(12, true, ULTRASOUND_ZONE_CRITICAL, __LINE__);
+}
+
+void test_hysteresis(void)
+{
+    _test_zone(200, true, ULTRASOUND_ZONE_FAR, __LINE__);
+    _test_zone(FSM_ULTRASOUND_DEFAULT_MEDIUM_CM - 1U, true, ULTRASOUND_ZONE_MEDIUM, __LINE__);
+    _test_zone(FSM_ULTRASOUND_DEFAULT_MEDIUM_CM, false, ULTRASOUND_ZONE_MEDIUM, __LINE__);
+    _test_zone(FSM_ULTRASOUND_DEFAULT_MEDIUM_CM + FSM_ULTRASOUND_DEFAULT_HYSTERESIS_CM - 1U, false, ULTRASOUND_ZONE_MEDIUM, __LINE__);
+    _test_zone(FSM_ULTRASOUND_DEFAULT_MEDIUM_CM - 1U, false, ULTRASOUND_ZONE_MEDIUM, __LINE__);
+    _test_zone(FSM_ULTRASOUND_DEFAULT_MEDIUM_CM + FSM_ULTRASOUND_DEFAULT_HYSTERESIS_CM, true, ULTRASOUND_ZONE_FAR, __LINE__);
+
+    /* Back from the critical zone: a farther zone is only reached past the band above its threshold */
+    _test_zone(FSM_ULTRASOUND_DEFAULT_CRITICAL_CM - 1U, true, ULTRASOUND_ZONE_CRITICAL, __LINE__);
+    _test_zone(FSM_ULTRASOUND_DEFAULT_NEAR_CM + 1U, true, ULTRASOUND_ZONE_NEAR, __LINE__);
+    _test_zone(FSM_ULTRASOUND_DEFAULT_NEAR_CM + FSM_ULTRASOUND_DEFAULT_HYSTERESIS_CM, true, ULTRASOUND_ZONE_MEDIUM, __LINE__);
+}
+
+void test_config(void)
+{
+    fsm_ultrasound_zone_config_t config = {.critical_cm = 10, .near_cm = 100, .medium_cm = 300, .hysteresis_cm = 0};
+    fsm_ultrasound_zone_config_t wrong_config = {.critical_cm = 100, .near_cm = 100, .medium_cm = 300, .hysteresis_cm = 0};
+    UNITY_TEST_ASSERT(fsm_ultrasound_set_zone_config(p_fsm_b, &config), __LINE__, "ERROR: Increasing thresholds must be accepted");
+    UNITY_TEST_ASSERT(!fsm_ultrasound_set_zone_config(p_fsm_a, &wrong_config), __LINE__, "ERROR: Thresholds that are not increasing must be rejected");
+
+    _test_zone(60, true, ULTRASOUND_ZONE_MEDIUM, __LINE__); /* Default thresholds: a rejected configuration is not used */
+    _test_distance(p_fsm_b, 60);
+    UNITY_TEST_ASSERT_EQUAL_INT(ULTRASOUND_ZONE_NEAR, fsm_ultrasound_get_zone(p_fsm_b), __LINE__, "ERROR: Every sensor must use its own thresholds");
+
+    _test_distance(p_fsm_b, 100);
+    UNITY_TEST_ASSERT_EQUAL_INT(ULTRASOUND_ZONE_MEDIUM, fsm_ultrasound_get_zone(p_fsm_b), __LINE__, "ERROR: Without hysteresis the zone must change at the threshold");
+
+    UNITY_TEST_ASSERT(fsm_ultrasound_set_zone_config(p_fsm_b, NULL), __LINE__, "ERROR: NULL must select the default thresholds");
+    _test_distance(p_fsm_b, 20);
+    UNITY_TEST_ASSERT_EQUAL_INT(ULTRASOUND_ZONE_CRITICAL, fsm_ultrasound_get_zone(p_fsm_b), __LINE__, "ERROR: The default thresholds are not restored");
+}
+
+void test_callback(void)
+{
+    fsm_ultrasound_set_zone_callback(p_fsm_a, _test_zone_callback, &callback_calls);
+    _test_distance(p_fsm_a, 200);
+    UNITY_TEST_ASSERT_EQUAL_UINT32(1, callback_calls, __LINE__, "ERROR: The callback must be called when the first distance gives a zone");
+    UNITY_TEST_ASSERT(p_callback_fsm == p_fsm_a, __LINE__, "ERROR: The callback must be given the FSM whose zone changed");
+    UNITY_TEST_ASSERT_EQUAL_INT(ULTRASOUND_ZONE_FAR, callback_zone, __LINE__, "ERROR: The callback must be given the new zone");
+
+    _test_distance(p_fsm_a, 170);
+    UNITY_TEST_ASSERT_EQUAL_UINT32(1, callback_calls, __LINE__, "ERROR: The callback must not be called when the zone does not change");
+    _test_distance(p_fsm_b, 10);
+    UNITY_TEST_ASSERT_EQUAL_UINT32(1, callback_calls, __LINE__, "ERROR: The callback must only be called for the changes of its own FSM");
+    _test_distance(p_fsm_a, 10);
+    UNITY_TEST_ASSERT_EQUAL_UINT32(2, callback_calls, __LINE__, "ERROR: The callback must be called once per change of zone");
+    UNITY_TEST_ASSERT_EQUAL_INT(ULTRASOUND_ZONE_CRITICAL, callback_zone, __LINE__, "ERROR: The callback must be given the new zone");
+    UNITY_TEST_ASSERT(fsm_ultrasound_get_zone_changed(p_fsm_a), __LINE__, "ERROR: The zone changed flag must still be raised with a callback");
+
+    fsm_ultrasound_set_zone_callback(p_fsm_a, NULL, NULL);
+    _test_distance(p_fsm_a, 200);
+    UNITY_TEST_ASSERT_EQUAL_UINT32(2, callback_calls, __LINE__, "ERROR: A NULL callback must not be called");
+
+    fsm_ultrasound_set_zone_callback(p_fsm_a, _test_zone_callback, &callback_calls);
+    fsm_ultrasound_destroy(p_fsm_a);
+    p_fsm_a = fsm_ultrasound_new(TEST_SENSOR_ID);
+    fsm_ultrasound_start(p_fsm_a);
+    _test_distance(p_fsm_a, 10);
+    UNITY_TEST_ASSERT_EQUAL_UINT32(2, callback_calls, __LINE__, "ERROR: A new FSM must not have the callback of the previous FSM of its slot");
+}
+
+int main(void)
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_change_only);
+    RUN_TEST(test_hysteresis);
+    RUN_TEST(test_config);
+    RUN_TEST(test_callback);
+    exit(UNITY_END());
+}
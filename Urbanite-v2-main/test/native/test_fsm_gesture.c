@@ -0,0 +1,253 @@
+/**
+ * @file test_fsm_gesture.c
+ * @brief Unit test for the gesture FSM.
+ *
+ * The keys are driven with the emulated inputs of the native debounce engine and the virtual time of the native platform.
+ *
+ * @date 2025-01-01
+ */
+/* System dependent libraries */
+#include <stdlib.h>
+#include <unity.h>
+
+/* HW dependent libraries */
+#include "port_system.h"
+#include "port_debounce.h"
+#include "native_debounce.h"
+
+/* Include FSM libraries */
+#include "fsm.h"
+#include "fsm_gesture.h"
+
+/* Defines and enums ----------------------------------------------------------*/
+#define TEST_KEY_ID 0          /*!< Key used by the tests @hideinitializer */
+#define TEST_LONG_PRESS_MS 500 /*!< Long press time of the tests @hideinitializer */
+#define TEST_DOUBLE_MS 200     /*!< Double click time of the tests @hideinitializer */
+#define TEST_REPEAT_DELAY_MS 300 /*!< Delay of the first repeat of the tests @hideinitializer */
+#define TEST_REPEAT_PERIOD_MS 100 /*!< Repeat period of the tests @hideinitializer */
+#define TEST_DEBOUNCE_MS (4 * PORT_DEBOUNCE_PERIOD_MS) /*!< Maximum time for a change to pass the debounce engine @hideinitializer */
+
+/* Global variables ----------------------------------------------------------*/
+static fsm_gesture_t *p_fsm_gesture; /*!< Pointer to the gesture FSM */
+static const fsm_gesture_config_t test_config = {
+    .long_press_ms = TEST_LONG_PRESS_MS,
+    .double_click_ms = TEST_DOUBLE_MS,
+    .repeat_delay_ms = TEST_REPEAT_DELAY_MS,
+    .repeat_period_ms = TEST_REPEAT_PERIOD_MS}; /*!< Thresholds of the tests */
+
+/* Private functions ---------------------------------------------------------*/
+/**
+ * @brief Advance the virtual time firing the FSM every millisecond, as the main loop does
+ * @param ms Time to run
+ */
+static void _run_ms(uint32_t ms)
+{
+    for (uint32_t i = 0; i < ms; i++)
+    {
+        port_system_delay_ms(1);
+        fsm_gesture_fire(p_fsm_gesture);
+    }
+}
+
+/**
+ * @brief Count the queued events of a type and empty the queue
+ * @param type Type of event to count
+ * @return Number of events of the type
+ */
+static uint32_t _count_events(fsm_gesture_event_type_t type)
+{
+    fsm_gesture_event_t event;
+    uint32_t count = 0;
+    while (fsm_gesture_get_event(&event))
+    {
+        if (event.type == type)
+        {
+            count++;
+        }
+    }
+    return count;
+}
+
+void setUp(void)
+{
+    p_fsm_gesture = fsm_gesture_new(&test_config, TEST_KEY_ID);
+    native_debounce_set_raw(TEST_KEY_ID, false);
+    _run_ms(TEST_DEBOUNCE_MS + TEST_DOUBLE_MS);
+    fsm_gesture_event_t event;
+    while (fsm_gesture_get_event(&event))
+    {
+    }
+}
+
+void tearDown(void)
+{
+    fsm_gesture_destroy(p_fsm_gesture);
+}
+
+void test_initial_config(void)
+{
+    fsm_t *p_inner_fsm = fsm_gesture_get_inner_fsm(p_fsm_gesture);
+    UNITY_TEST_ASSERT_EQUAL_PTR(p_fsm_gesture, p_inner_fsm, __LINE__, "The inner FSM of fsm_gesture_t is not the first field of the struct");
+    UNITY_TEST_ASSERT_EQUAL_INT(GESTURE_IDLE, fsm_gesture_get_state(p_fsm_gesture), __LINE__, "The initial state of the FSM is not GESTURE_IDLE");
+    UNITY_TEST_ASSERT_EQUAL_INT(false, fsm_gesture_check_activity(p_fsm_gesture), __LINE__, "The FSM must not be active with the key released");
+}
+
+void test_bounces_filtered(void)
+{
+    for (uint32_t i = 0; i < 10; i++)
+    {
+        native_debounce_set_raw(TEST_KEY_ID, (i % 2) == 0);
+        _run_ms(PORT_DEBOUNCE_PERIOD_MS);
+    }
+    native_debounce_set_raw(TEST_KEY_ID, false);
+    _run_ms(TEST_DEBOUNCE_MS + TEST_DOUBLE_MS);
+    UNITY_TEST_ASSERT_EQUAL_INT(GESTURE_IDLE, fsm_gesture_get_state(p_fsm_gesture), __LINE__, "Bounces shorter than the debounce time must not start a gesture");
+    fsm_gesture_event_t event;
+    UNITY_TEST_ASSERT_EQUAL_INT(false, fsm_gesture_get_event(&event), __LINE__, "Bounces shorter than the debounce time must not fire events");
+}
+
+void test_click(void)
+{
+    native_debounce_set_raw(TEST_KEY_ID, true);
+    _run_ms(TEST_DEBOUNCE_MS + 50);
+    UNITY_TEST_ASSERT_EQUAL_INT(GESTURE_PRESSED, fsm_gesture_get_state(p_fsm_gesture), __LINE__, "The FSM must be in GESTURE_PRESSED after a press");
+    native_debounce_set_raw(TEST_KEY_ID, false);
+    _run_ms(TEST_DEBOUNCE_MS);
+    UNITY_TEST_ASSERT_EQUAL_INT(GESTURE_WAIT_SECOND, fsm_gesture_get_state(p_fsm_gesture), __LINE__, "The FSM must wait for a second press after a short press");
+    fsm_gesture_event_t event;
+    UNITY_TEST_ASSERT_EQUAL_INT(false, fsm_gesture_get_event(&event), __LINE__, "The click must not be fired before the double click time");
+
+    _run_ms(TEST_DOUBLE_MS);
+    UNITY_TEST_ASSERT_EQUAL_INT(true, fsm_gesture_get_event(&event), __LINE__, "A click must be fired after the double click time");
+    UNITY_TEST_ASSERT_EQUAL_INT(GESTURE_EVENT_CLICK, event.type, __LINE__, "The event must be a click");
+    UNITY_TEST_ASSERT_EQUAL_UINT32(TEST_KEY_ID, event.key_id, __LINE__, "The key ID of the event is wrong");
+    UNITY_TEST_ASSERT_EQUAL_INT(GESTURE_IDLE, fsm_gesture_get_state(p_fsm_gesture), __LINE__, "The FSM must return to GESTURE_IDLE after a click");
+}
+
+void test_double_click(void)
+{
+    native_debounce_set_raw(TEST_KEY_ID, true);
+    _run_ms(TEST_DEBOUNCE_MS + 50);
+    native_debounce_set_raw(TEST_KEY_ID, false);
+    _run_ms(TEST_DEBOUNCE_MS + 50);
+    native_debounce_set_raw(TEST_KEY_ID, true);
+    _run_ms(TEST_DEBOUNCE_MS);
+    fsm_gesture_event_t event;
+    UNITY_TEST_ASSERT_EQUAL_INT(true, fsm_gesture_get_event(&event), __LINE__, "A double click must be fired on the second press");
+    UNITY_TEST_ASSERT_EQUAL_INT(GESTURE_EVENT_DOUBLE_CLICK, event.type, __LINE__, "The event must be a double click");
+    native_debounce_set_raw(TEST_KEY_ID, false);
+    _run_ms(TEST_DEBOUNCE_MS + TEST_DOUBLE_MS);
+    UNITY_TEST_ASSERT_EQUAL_INT(false, fsm_gesture_get_event(&event), __LINE__, "A double click must not fire a click");
+    UNITY_TEST_ASSERT_EQUAL_INT(GESTURE_IDLE, fsm_gesture_get_state(p_fsm_gesture), __LINE__, "The FSM must return to GESTURE_IDLE after a double click");
+}
+
+void test_long_press_while_held(void)
+{
+    native_debounce_set_raw(TEST_KEY_ID, true);
+    _run_ms(TEST_DEBOUNCE_MS + TEST_LONG_PRESS_MS);
+    fsm_gesture_event_t event;
+    UNITY_TEST_ASSERT_EQUAL_INT(true, fsm_gesture_get_event(&event), __LINE__, "A long press must be fired while the key is held");
+    UNITY_TEST_ASSERT_EQUAL_INT(GESTURE_EVENT_LONG_PRESS, event.type, __LINE__, "The event must be a long press");
+    UNITY_TEST_ASSERT_EQUAL_INT(GESTURE_HELD, fsm_gesture_get_state(p_fsm_gesture), __LINE__, "The FSM must be in GESTURE_HELD after a long press");
+
+    native_debounce_set_raw(TEST_KEY_ID, false);
+    _run_ms(TEST_DEBOUNCE_MS + TEST_DOUBLE_MS);
+    UNITY_TEST_ASSERT_EQUAL_INT(false, fsm_gesture_get_event(&event), __LINE__, "The release of a long press must not fire a click");
+}
+
+void test_repeat(void)
+{
+    native_debounce_set_raw(TEST_KEY_ID, true);
+    _run_ms(TEST_DEBOUNCE_MS + TEST_LONG_PRESS_MS);
+    UNITY_TEST_ASSERT_EQUAL_UINT32(1, _count_events(GESTURE_EVENT_LONG_PRESS), __LINE__, "Only one long press must be fired");
+    _run_ms(TEST_REPEAT_DELAY_MS + 3 * TEST_REPEAT_PERIOD_MS);
+    UNITY_TEST_ASSERT_EQUAL_UINT32(4, _count_events(GESTURE_EVENT_REPEAT), __LINE__, "The repeats must start after the repeat delay and follow the repeat period");
+    native_debounce_set_raw(TEST_KEY_ID, false);
+    _run_ms(TEST_DEBOUNCE_MS + TEST_REPEAT_PERIOD_MS);
+    UNITY_TEST_ASSERT_EQUAL_UINT32(0, _count_events(GESTURE_EVENT_REPEAT), __LINE__, "The repeats must stop when the key is released");
+}
+
+void test_short_press_between_fires(void)
+{
+    uint32_t press_ms = port_system_get_millis();
+    native_debounce_set_raw(TEST_KEY_ID, true);
+    port_system_delay_ms(TEST_DEBOUNCE_MS + 30);
+    uint32_t release_ms = port_system_get_millis();
+    native_debounce_set_raw(TEST_KEY_ID, false);
+    port_system_delay_ms(TEST_DEBOUNCE_MS + 10);
+
+    fsm_gesture_fire(p_fsm_gesture);
+    UNITY_TEST_ASSERT_EQUAL_INT(GESTURE_WAIT_SECOND, fsm_gesture_get_state(p_fsm_gesture), __LINE__, "A press and release between two fires must not be lost");
+    fsm_gesture_event_t event;
+    UNITY_TEST_ASSERT_EQUAL_INT(false, fsm_gesture_get_event(&event), __LINE__, "The click must not be fired before the double click time");
+
+    port_system_delay_ms(TEST_DOUBLE_MS);
+    fsm_gesture_fire(p_fsm_gesture);
+    UNITY_TEST_ASSERT_EQUAL_INT(true, fsm_gesture_get_event(&event), __LINE__, "A click must be fired after the double click time");
+    UNITY_TEST_ASSERT_EQUAL_INT(GESTURE_EVENT_CLICK, event.type, __LINE__, "The event must be a click");
+    uint32_t expected_ms = ((release_ms / PORT_DEBOUNCE_PERIOD_MS) + 4) * PORT_DEBOUNCE_PERIOD_MS + TEST_DOUBLE_MS;
+    UNITY_TEST_ASSERT_EQUAL_UINT32(expected_ms, event.timestamp_ms, __LINE__, "The click must have the time of the debounced release plus the double click time, not the time of the fire");
+    UNITY_TEST_ASSERT_EQUAL_INT(true, (int32_t)(release_ms - press_ms) < TEST_LONG_PRESS_MS, __LINE__, "The press of the test must be short");
+}
+
+void test_gestures_between_fires(void)
+{
+    native_debounce_set_raw(TEST_KEY_ID, true);
+    port_system_delay_ms(TEST_DEBOUNCE_MS + 30);
+    native_debounce_set_raw(TEST_KEY_ID, false);
+    port_system_delay_ms(TEST_DEBOUNCE_MS + 30);
+    native_debounce_set_raw(TEST_KEY_ID, true);
+    port_system_delay_ms(TEST_DEBOUNCE_MS + 30);
+    native_debounce_set_raw(TEST_KEY_ID, false);
+    port_system_delay_ms(TEST_DEBOUNCE_MS + 30);
+    native_debounce_set_raw(TEST_KEY_ID, true);
+    port_system_delay_ms(TEST_DEBOUNCE_MS + TEST_LONG_PRESS_MS + TEST_REPEAT_DELAY_MS);
+    native_debounce_set_raw(TEST_KEY_ID, false);
+    port_system_delay_ms(TEST_DEBOUNCE_MS + TEST_DOUBLE_MS);
+
+    fsm_gesture_fire(p_fsm_gesture);
+    fsm_gesture_event_type_t expected[] = {GESTURE_EVENT_DOUBLE_CLICK, GESTURE_EVENT_LONG_PRESS, GESTURE_EVENT_REPEAT};
+    fsm_gesture_event_t event;
+    uint32_t last_ms = 0;
+    for (uint32_t i = 0; i < (sizeof(expected) / sizeof(expected[0])); i++)
+    {
+        UNITY_TEST_ASSERT_EQUAL_INT(true, fsm_gesture_get_event(&event), __LINE__, "All the gestures between two fires must be recognized in a single fire");
+        UNITY_TEST_ASSERT_EQUAL_INT(expected[i], event.type, __LINE__, "The gestures must be recognized in the order they happened");
+        UNITY_TEST_ASSERT_EQUAL_INT(true, event.timestamp_ms > last_ms, __LINE__, "The timestamps of the gestures must increase");
+        last_ms = event.timestamp_ms;
+    }
+    UNITY_TEST_ASSERT_EQUAL_INT(false, fsm_gesture_get_event(&event), __LINE__, "There must be no more gestures");
+    UNITY_TEST_ASSERT_EQUAL_INT(GESTURE_IDLE, fsm_gesture_get_state(p_fsm_gesture), __LINE__, "The FSM must return to GESTURE_IDLE");
+}
+
+void test_click_without_double_click(void)
+{
+    fsm_gesture_config_t config = test_config;
+    config.double_click_ms = 0;
+    fsm_gesture_destroy(p_fsm_gesture);
+    p_fsm_gesture = fsm_gesture_new(&config, TEST_KEY_ID);
+
+    native_debounce_set_raw(TEST_KEY_ID, true);
+    _run_ms(TEST_DEBOUNCE_MS + 50);
+    native_debounce_set_raw(TEST_KEY_ID, false);
+    _run_ms(TEST_DEBOUNCE_MS);
+    UNITY_TEST_ASSERT_EQUAL_UINT32(1, _count_events(GESTURE_EVENT_CLICK), __LINE__, "Without double clicks the click must be fired on release");
+}
+
+int main(void)
+{
+    port_system_init();
+    UNITY_BEGIN();
+
+    RUN_TEST(test_initial_config);
+    RUN_TEST(test_bounces_filtered);
+    RUN_TEST(test_click);
+    RUN_TEST(test_double_click);
+    RUN_TEST(test_long_press_while_held);
+    RUN_TEST(test_repeat);
+    RUN_TEST(test_short_press_between_fires);
+    RUN_TEST(test_gestures_between_fires);
+    RUN_TEST(test_click_without_double_click);
+
+    exit(UNITY_END());
+}
@@ -0,0 +1,160 @@
+/**
+ * @file test_fsm_profile.c
+ * @brief Unit test for the profiler of the guards and actions of the FSMs.
+ *
+ * A small FSM of two states is fired through `fsm_profile_fire()` directly, so the test does not depend on `FSM_PROFILE` being defined.
+ *
+ * @date 2025-01-01
+ */
+/* System dependent libraries */
+#include <stdlib.h>
+#include <stdio.h>
+#include <unity.h>
+
+/* HW dependent libraries */
+#include "port_system.h"
+#include "port_log.h"
+#include "native_log.h"
+
+/* Project libraries */
+#include "fsm_profile.h"
+
+/* Defines and enums ----------------------------------------------------------*/
+#define TEST_PROFILE_ID 100U       /*!< Identifier of the profile of the test FSM */
+#define TEST_PROFILE_BLOCK_ID 101U /*!< Identifier of the profiled block */
+
+enum
+{
+    TEST_IDLE = 0, /*!< Waiting for the flag */
+    TEST_BUSY,     /*!< The flag has been seen */
+};
+
+/* Global variables ----------------------------------------------------------*/
+static bool flag;           /*!< Input of the test FSM */
+static uint32_t num_starts; /*!< Calls of the action */
+
+static bool check_flag(fsm_t *p_this)
+{
+    return flag;
+}
+
+static bool check_no_flag(fsm_t *p_this)
+{
+    return !flag;
+}
+
+static void do_start(fsm_t *p_this)
+{
+    num_starts++;
+}
+
+static fsm_trans_t test_tt[] = {
+    {TEST_IDLE, check_flag, TEST_BUSY, do_start},
+    {TEST_BUSY, check_no_flag, TEST_IDLE, NULL},
+    {-1, NULL, -1, NULL}}; /*!< Transition table of the test FSM */
+
+static fsm_profile_t test_profile = {.id = TEST_PROFILE_ID};             /*!< Profile of the test FSM */
+static fsm_profile_block_t test_block = {.id = TEST_PROFILE_BLOCK_ID}; /*!< Profile of a block */
+static fsm_t test_fsm;                                                  /*!< Test FSM */
+
+void setUp(void)
+{
+    native_log_set_sink(NULL);
+    port_system_init();
+    fsm_init(&test_fsm, test_tt);
+    fsm_profile_reset();
+    flag = false;
+    num_starts = 0;
+}
+
+void tearDown(void)
+{
+    native_log_set_sink(NULL);
+}
+
+/* Tests ---------------------------------------------------------------------*/
+void test_fire_semantics(void)
+{
+    UNITY_TEST_ASSERT_EQUAL_INT(0, fsm_profile_fire(&test_profile, &test_fsm), __LINE__, "No transition must be taken if the guard is false");
+    UNITY_TEST_ASSERT_EQUAL_INT(TEST_IDLE, test_fsm.current_state, __LINE__, "The state must not change if the guard is false");
+
+    flag = true;
+    UNITY_TEST_ASSERT_EQUAL_INT(1, fsm_profile_fire(&test_profile, &test_fsm), __LINE__, "The transition must be taken if the guard is true");
+    UNITY_TEST_ASSERT_EQUAL_INT(TEST_BUSY, test_fsm.current_state, __LINE__, "The state must change as with fsm_fire()");
+    UNITY_TEST_ASSERT_EQUAL_UINT32(1, num_starts, __LINE__, "The action must run once");
+}
+
+void test_guard_and_action_statistics(void)
+{
+    for (uint32_t i = 0; i < 3U; i++)
+    {
+        fsm_profile_fire(&test_profile, &test_fsm);
+    }
+    flag = true;
+    fsm_profile_fire(&test_profile, &test_fsm);
+    flag = false;
+    fsm_profile_fire(&test_profile, &test_fsm);
+
+    const fsm_profile_t *p_profile = fsm_profile_get(TEST_PROFILE_ID);
+    UNITY_TEST_ASSERT_EQUAL_PTR(&test_profile, p_profile, __LINE__, "The profile must be registered when the FSM is fired");
+    UNITY_TEST_ASSERT_EQUAL_UINT32(2, p_profile->num_rows, __LINE__, "Wrong number of rows of the transition table");
+    UNITY_TEST_ASSERT_EQUAL_UINT32(5, p_profile->fire.calls, __LINE__, "Every fire must be measured");
+    UNITY_TEST_ASSERT_EQUAL_UINT32(4, p_profile->guards_arr[0].calls, __LINE__, "The guard of the first row runs while the FSM is idle");
+    UNITY_TEST_ASSERT_EQUAL_UINT32(1, p_profile->guards_arr[0].taken, __LINE__, "The guard of the first row is true once");
+    UNITY_TEST_ASSERT_EQUAL_UINT32(1, p_profile->guards_arr[1].calls, __LINE__, "The guard of the second row runs once");
+    UNITY_TEST_ASSERT_EQUAL_UINT32(1, p_profile->actions_arr[0].calls, __LINE__, "The action of the first row runs once");
+    UNITY_TEST_ASSERT_EQUAL_UINT32(0, p_profile->actions_arr[1].calls, __LINE__, "A row without action must not be measured");
+    UNITY_TEST_ASSERT_EQUAL_UINT32(1, p_profile->transitions_arr[TEST_IDLE], __LINE__, "Wrong transitions from the idle state");
+    UNITY_TEST_ASSERT_EQUAL_UINT32(1, p_profile->transitions_arr[TEST_BUSY], __LINE__, "Wrong transitions from the busy state");
+    UNITY_TEST_ASSERT(p_profile->fire.min_cycles <= p_profile->fire.max_cycles, __LINE__, "The minimum time must not exceed the maximum");
+    UNITY_TEST_ASSERT(p_profile->fire.total_cycles >= (uint64_t)p_profile->fire.max_cycles, __LINE__, "The total time must include the maximum");
+}
+
+void test_block_statistics(void)
+{
+    UNITY_TEST_ASSERT_EQUAL_PTR(NULL, fsm_profile_get_block(TEST_PROFILE_BLOCK_ID), __LINE__, "A block must not be registered before it runs");
+    for (uint32_t i = 0; i < 2U; i++)
+    {
+        uint32_t start = fsm_profile_block_begin();
+        port_system_delay_ms(1);
+        fsm_profile_block_end(&test_block, start);
+    }
+    const fsm_profile_block_t *p_block = fsm_profile_get_block(TEST_PROFILE_BLOCK_ID);
+    UNITY_TEST_ASSERT_EQUAL_PTR(&test_block, p_block, __LINE__, "The block must be registered when it runs");
+    UNITY_TEST_ASSERT_EQUAL_UINT32(2, p_block->stats.calls, __LINE__, "Every run of the block must be measured");
+
+    fsm_profile_reset();
+    UNITY_TEST_ASSERT_EQUAL_UINT32(0, p_block->stats.calls, __LINE__, "The reset must clear the blocks");
+}
+
+void test_dump_through_logger(void)
+{
+    flag = true;
+    fsm_profile_fire(&test_profile, &test_fsm);
+
+    FILE *p_sink = tmpfile();
+    native_log_set_sink(p_sink);
+    fsm_profile_dump();
+    native_log_set_sink(NULL);
+
+    uint32_t words[64];
+    rewind(p_sink);
+    uint32_t n = (uint32_t)fread(words, sizeof(uint32_t), 64, p_sink);
+    fclose(p_sink);
+    UNITY_TEST_ASSERT(n >= 4U, __LINE__, "The dump must write records");
+    UNITY_TEST_ASSERT_EQUAL_UINT32(PORT_LOG_HEADER(PORT_LOG_LEVEL_INFO, PORT_LOG_MSG_PROFILE_FIRE, 2), words[0], __LINE__, "The dump must start with the fire of the FSM");
+    UNITY_TEST_ASSERT_EQUAL_UINT32(TEST_PROFILE_ID, words[2], __LINE__, "The records must carry the identifier of the profile");
+    UNITY_TEST_ASSERT_EQUAL_UINT32(1, words[3], __LINE__, "Wrong number of fires in the dump");
+}
+
+int main(void)
+{
+    UNITY_BEGIN();
+
+    RUN_TEST(test_fire_semantics);
+    RUN_TEST(test_guard_and_action_statistics);
+    RUN_TEST(test_block_statistics);
+    RUN_TEST(test_dump_through_logger);
+
+    exit(UNITY_END());
+}
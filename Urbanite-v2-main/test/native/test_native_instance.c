@@ -0,0 +1,164 @@
+/**
+ * @file test_native_instance.c
+ * @brief Unit test for the simulated units of the native platform.
+ *
+ * Two units are driven in turns from the same thread, as a worker of the fleet simulator does, and each one must keep its own virtual time, peripherals and software timers.
+ *
+ * @date 2025-01-01
+ */
+/* System dependent libraries */
+#include <stdlib.h>
+#include <unity.h>
+
+/* HW dependent libraries */
+#include "port_system.h"
+#include "port_timer.h"
+#include "port_button.h"
+#include "port_ultrasound.h"
+#include "native_system.h"
+#include "native_button.h"
+#include "native_instance.h"
+
+/* Global variables ----------------------------------------------------------*/
+static native_instance_t *p_unit_a; /*!< First test unit */
+static native_instance_t *p_unit_b; /*!< Second test unit */
+static uint32_t fired_count;        /*!< Expiries of the test timers, in any unit */
+
+/* Private functions ---------------------------------------------------------*/
+/**
+ * @brief Callback that counts the expiries of a test timer
+ * @param p_arg Not used
+ */
+static void _timer_count(void *p_arg)
+{
+    fired_count++;
+}
+
+void setUp(void)
+{
+    p_unit_a = native_instance_new();
+    p_unit_b = native_instance_new();
+    native_instance_select(p_unit_a);
+    native_system_reset();
+    native_instance_select(p_unit_b);
+    native_system_reset();
+    native_instance_select(NULL);
+    fired_count = 0;
+}
+
+void tearDown(void)
+{
+    native_instance_destroy(p_unit_a);
+    native_instance_destroy(p_unit_b);
+}
+
+void test_instance_select(void)
+{
+    native_instance_t *p_default = native_instance_get();
+
+    UNITY_TEST_ASSERT_EQUAL_PTR(p_default, native_instance_select(p_unit_a), __LINE__, "ERROR: Selecting a unit must return the unit selected before");
+    UNITY_TEST_ASSERT_EQUAL_PTR(p_unit_a, native_instance_get(), __LINE__, "ERROR: The selected unit must be the current one");
+    UNITY_TEST_ASSERT_EQUAL_PTR(p_unit_a, native_instance_select(NULL), __LINE__, "ERROR: Selecting the default unit must return the unit selected before");
+    UNITY_TEST_ASSERT_EQUAL_PTR(p_default, native_instance_get(), __LINE__, "ERROR: NULL must select the default unit");
+}
+
+void test_instance_destroy_selects_default(void)
+{
+    native_instance_t *p_default = native_instance_get();
+    native_instance_t *p_unit = native_instance_new();
+
+    native_instance_select(p_unit);
+    native_instance_destroy(p_unit);
+    UNITY_TEST_ASSERT_EQUAL_PTR(p_default, native_instance_get(), __LINE__, "ERROR: Destroying the selected unit must select the default unit");
+}
+
+void test_instance_virtual_time(void)
+{
+    uint32_t default_millis = port_system_get_millis();
+
+    native_instance_select(p_unit_a);
+    native_system_advance_ms(10);
+    native_instance_select(p_unit_b);
+    native_system_advance_ms(3);
+
+    UNITY_TEST_ASSERT_EQUAL_UINT32(3, port_system_get_millis(), __LINE__, "ERROR: A unit must only advance with its own virtual time");
+    native_instance_select(p_unit_a);
+    UNITY_TEST_ASSERT_EQUAL_UINT32(10, port_system_get_millis(), __LINE__, "ERROR: A unit must keep its virtual time while another one runs");
+    native_instance_select(NULL);
+    UNITY_TEST_ASSERT_EQUAL_UINT32(default_millis, port_system_get_millis(), __LINE__, "ERROR: The default unit must not advance with the other units");
+}
+
+void test_instance_button(void)
+{
+    native_instance_select(p_unit_a);
+    port_button_init(PORT_PARKING_BUTTON_ID);
+    native_instance_select(p_unit_b);
+    port_button_init(PORT_PARKING_BUTTON_ID);
+
+    native_instance_select(p_unit_a);
+    native_button_set_value(PORT_PARKING_BUTTON_ID, false);
+    UNITY_TEST_ASSERT(port_button_get_pressed(PORT_PARKING_BUTTON_ID), __LINE__, "ERROR: The ISR of the unit must detect the press of its button");
+
+    native_instance_select(p_unit_b);
+    UNITY_TEST_ASSERT(port_button_get_value(PORT_PARKING_BUTTON_ID), __LINE__, "ERROR: The button of a unit must not change with the button of another unit");
+    UNITY_TEST_ASSERT(!port_button_get_pressed(PORT_PARKING_BUTTON_ID), __LINE__, "ERROR: The ISR of a unit must not run for the button of another unit");
+    native_instance_select(NULL);
+}
+
+void test_instance_ultrasound(void)
+{
+    native_instance_select(p_unit_a);
+    port_ultrasound_init(PORT_REAR_PARKING_SENSOR_ID);
+    native_instance_select(p_unit_b);
+    port_ultrasound_init(PORT_REAR_PARKING_SENSOR_ID);
+
+    native_instance_select(p_unit_a);
+    port_ultrasound_start_measurement(PORT_REAR_PARKING_SENSOR_ID);
+    UNITY_TEST_ASSERT(!port_ultrasound_get_trigger_ready(PORT_REAR_PARKING_SENSOR_ID), __LINE__, "ERROR: Starting a measurement must clear the trigger ready flag of the unit");
+
+    native_instance_select(p_unit_b);
+    UNITY_TEST_ASSERT(port_ultrasound_get_trigger_ready(PORT_REAR_PARKING_SENSOR_ID), __LINE__, "ERROR: The sensor of a unit must not change with the sensor of another unit");
+    UNITY_TEST_ASSERT(!port_ultrasound_get_measurement_timer_running(PORT_REAR_PARKING_SENSOR_ID), __LINE__, "ERROR: The measurement timer of a unit must not be armed by another unit");
+
+    native_instance_select(p_unit_a);
+    port_ultrasound_stop_ultrasound(PORT_REAR_PARKING_SENSOR_ID);
+    native_instance_select(NULL);
+}
+
+void test_instance_timers(void)
+{
+    port_timer_t timer_a;
+    port_timer_t timer_b;
+
+    native_instance_select(p_unit_a);
+    port_timer_setup(&timer_a, _timer_count, NULL);
+    port_timer_start(&timer_a, 5000U, 0);
+    native_instance_select(p_unit_b);
+    port_timer_setup(&timer_b, _timer_count, NULL);
+    port_timer_start(&timer_b, 20000U, 0);
+
+    native_system_advance_ms(10);
+    UNITY_TEST_ASSERT_EQUAL_UINT32(0, fired_count, __LINE__, "ERROR: The timers of a unit must only run with the virtual time of their unit");
+
+    native_instance_select(p_unit_a);
+    native_system_advance_ms(5);
+    UNITY_TEST_ASSERT_EQUAL_UINT32(1, fired_count, __LINE__, "ERROR: A timer must expire with the virtual time of its unit");
+    UNITY_TEST_ASSERT(port_timer_is_armed(&timer_b), __LINE__, "ERROR: The expiry of a timer must not change the timers of another unit");
+
+    native_instance_select(p_unit_b);
+    port_timer_cancel(&timer_b);
+    native_instance_select(NULL);
+}
+
+int main(void)
+{
+    port_system_init();
+    UNITY_BEGIN();
+    RUN_TEST(test_instance_select);
+    RUN_TEST(test_instance_destroy_selects_default);
+    RUN_TEST(test_instance_virtual_time);
+    RUN_TEST(test_instance_button);
+    RUN_TEST(test_instance_ultrasound);
+    RUN_TEST(test_instance_timers);
+    exit(UNITY_END());
+}
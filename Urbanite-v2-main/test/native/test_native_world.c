@@ -0,0 +1,204 @@
+/**
+ * @file test_native_world.c
+ * @brief Unit test for the acoustic world model of the native platform.
+ *
+ * The scenarios are written to a temporary stream. The first tests use the world alone; the last one measures through the emulated echo timer, as the ultrasound FSM does.
+ *
+ * @date 2025-01-01
+ */
+/* System dependent libraries */
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+#include <unity.h>
+
+/* HW dependent libraries */
+#include "port_system.h"
+#include "port_ultrasound.h"
+#include "native_system.h"
+#include "native_ultrasound.h"
+#include "native_world.h"
+
+/* Defines and enums ----------------------------------------------------------*/
+#define TEST_SENSOR_ID 0U   /*!< Sensor of the port in the scenarios @hideinitializer */
+#define TEST_SEED 1234U     /*!< Seed of the noise @hideinitializer */
+
+/* Global variables ----------------------------------------------------------*/
+static FILE *p_scenario;         /*!< Stream of the scenario of the test */
+static native_world_t *p_world;  /*!< World of the test */
+
+/* Private functions ---------------------------------------------------------*/
+/**
+ * @brief Create the world of a test from the text of its scenario
+ * @param p_text Scenario
+ */
+static void _world_load(const char *p_text)
+{
+    p_scenario = tmpfile();
+    fputs(p_text, p_scenario);
+    rewind(p_scenario);
+    p_world = native_world_new(p_scenario, TEST_SEED);
+}
+
+/**
+ * @brief Round trip of the sound
+ * @param distance_cm Distance to the obstacle
+ * @param temp_c Air temperature
+ * @return Time in microseconds
+ */
+static int32_t _round_trip_us(double distance_cm, double temp_c)
+{
+    return (int32_t)lround(2.0 * distance_cm / ((331.3 + 0.606 * temp_c) * 1e-4));
+}
+
+void setUp(void)
+{
+    port_system_init();
+    p_scenario = NULL;
+    p_world = NULL;
+}
+
+void tearDown(void)
+{
+    native_ultrasound_set_echo_source(TEST_SENSOR_ID, NULL, NULL);
+    native_world_destroy(p_world);
+    if (p_scenario != NULL)
+    {
+        fclose(p_scenario);
+    }
+}
+
+void test_world_static_obstacle(void)
+{
+    _world_load("sensor 0 0 0 0 15 0\n"
+                "0 obj 1 100 0 0 0\n");
+    double distance_cm = 0;
+
+    uint32_t echo_us = native_world_get_echo_us(p_world, TEST_SENSOR_ID, 1000U);
+    UNITY_TEST_ASSERT_INT_WITHIN(1, _round_trip_us(100.0, NATIVE_WORLD_DEFAULT_TEMP_C), (int32_t)echo_us, __LINE__, "ERROR: The echo must be the round trip to the obstacle");
+    UNITY_TEST_ASSERT(native_world_get_true_distance(p_world, TEST_SENSOR_ID, &distance_cm), __LINE__, "ERROR: The obstacle must be in the beam");
+    UNITY_TEST_ASSERT_INT_WITHIN(0, 100, (int32_t)lround(distance_cm), __LINE__, "ERROR: The true distance must be the distance to the obstacle");
+}
+
+void test_world_temperature(void)
+{
+    _world_load("sensor 0 0 0 0 15 0\n"
+                "0 obj 1 200 0 0 0\n"
+                "1000 temp -10\n"
+                "2000 temp 40\n");
+
+    uint32_t cold_us = native_world_get_echo_us(p_world, TEST_SENSOR_ID, 1500000U);
+    uint32_t hot_us = native_world_get_echo_us(p_world, TEST_SENSOR_ID, 2500000U);
+    UNITY_TEST_ASSERT_INT_WITHIN(1, _round_trip_us(200.0, -10.0), (int32_t)cold_us, __LINE__, "ERROR: The speed of sound must follow the temperature");
+    UNITY_TEST_ASSERT_INT_WITHIN(1, _round_trip_us(200.0, 40.0), (int32_t)hot_us, __LINE__, "ERROR: The speed of sound must follow the temperature");
+}
+
+void test_world_trajectory_streamed(void)
+{
+    _world_load("sensor 0 0 0 0 15 0\n"
+                "0 obj 1 300 0 -100 0\n"
+                "1000 gone 1\n"
+                "5000 obj 2 50 0 0 0\n");
+    double distance_cm = 0;
+
+    native_world_get_echo_us(p_world, TEST_SENSOR_ID, 500000U);
+    native_world_get_true_distance(p_world, TEST_SENSOR_ID, &distance_cm);
+    UNITY_TEST_ASSERT_INT_WITHIN(0, 250, (int32_t)lround(distance_cm), __LINE__, "ERROR: The obstacle must move with its velocity");
+
+    UNITY_TEST_ASSERT_EQUAL_UINT32(NATIVE_WORLD_NO_ECHO_US, native_world_get_echo_us(p_world, TEST_SENSOR_ID, 2000000U), __LINE__, "ERROR: A gone obstacle must not return echoes, and a future one must not be read yet");
+
+    uint32_t echo_us = native_world_get_echo_us(p_world, TEST_SENSOR_ID, 5000000U);
+    UNITY_TEST_ASSERT_INT_WITHIN(1, _round_trip_us(50.0, NATIVE_WORLD_DEFAULT_TEMP_C), (int32_t)echo_us, __LINE__, "ERROR: The obstacle must appear at the time of its line");
+}
+
+void test_world_beam(void)
+{
+    _world_load("sensor 0 0 0 0 15 0\n"
+                "0 obj 1 100 100 0 0\n");
+
+    UNITY_TEST_ASSERT_EQUAL_UINT32(NATIVE_WORLD_NO_ECHO_US, native_world_get_echo_us(p_world, TEST_SENSOR_ID, 1000U), __LINE__, "ERROR: An obstacle out of the beam must not return echoes");
+}
+
+void test_world_missing_and_ghost(void)
+{
+    _world_load("sensor 0 0 0 0 15 0\n"
+                "noise 0 0 0 1 0 0\n"
+                "0 obj 1 100 0 0 0\n"
+                "1000 noise 0 0 0 0 1 0\n");
+
+    UNITY_TEST_ASSERT_EQUAL_UINT32(NATIVE_WORLD_NO_ECHO_US, native_world_get_echo_us(p_world, TEST_SENSOR_ID, 1000U), __LINE__, "ERROR: A missed echo must last the timeout of the sensor");
+    uint32_t echo_us = native_world_get_echo_us(p_world, TEST_SENSOR_ID, 2000000U);
+    UNITY_TEST_ASSERT_INT_WITHIN(2, 2 * _round_trip_us(100.0, NATIVE_WORLD_DEFAULT_TEMP_C), (int32_t)echo_us, __LINE__, "ERROR: A ghost must be the echo of two round trips");
+}
+
+void test_world_crosstalk(void)
+{
+    _world_load("sensor 0 0 0 0 15 0\n"
+                "sensor 1 0 0 0 15 0.5\n" /* Another car, bursts every 500 us */
+                "noise 0 0 0 0 0 1\n"
+                "0 obj 1 300 0 0 0\n");
+
+    uint32_t echo_us = native_world_get_echo_us(p_world, TEST_SENSOR_ID, 1000000U);
+    UNITY_TEST_ASSERT(echo_us < (uint32_t)_round_trip_us(300.0, NATIVE_WORLD_DEFAULT_TEMP_C), __LINE__, "ERROR: A burst of another sensor must end the echo before the true one");
+}
+
+void test_world_noise_is_reproducible(void)
+{
+    const char *p_text = "sensor 0 0 0 0 15 0\n"
+                         "noise 20 0.1 200 0.1 0.05 0\n"
+                         "0 obj 1 150 0 0 0\n";
+    uint32_t echoes_arr[32];
+    _world_load(p_text);
+    for (uint32_t i = 0; i < 32U; i++)
+    {
+        echoes_arr[i] = native_world_get_echo_us(p_world, TEST_SENSOR_ID, (uint64_t)i * 100000U);
+    }
+    native_world_destroy(p_world);
+    fclose(p_scenario);
+
+    _world_load(p_text);
+    for (uint32_t i = 0; i < 32U; i++)
+    {
+        UNITY_TEST_ASSERT_EQUAL_UINT32(echoes_arr[i], native_world_get_echo_us(p_world, TEST_SENSOR_ID, (uint64_t)i * 100000U), __LINE__, "ERROR: The same scenario and seed must give the same echoes");
+    }
+}
+
+void test_world_echo_timer_edges(void)
+{
+    _world_load("sensor 0 0 0 0 15 0\n"
+                "0 obj 1 300 0 0 0\n");
+    port_ultrasound_init(TEST_SENSOR_ID);
+    native_world_attach(p_world, TEST_SENSOR_ID);
+    native_system_advance_ms(3);
+
+    port_ultrasound_start_measurement(TEST_SENSOR_ID);
+    native_system_advance_ms(1);
+    UNITY_TEST_ASSERT(port_ultrasound_get_trigger_end(TEST_SENSOR_ID), __LINE__, "ERROR: The trigger must end in the first millisecond");
+    port_ultrasound_stop_trigger_timer(TEST_SENSOR_ID);
+
+    uint32_t echo_us = (uint32_t)_round_trip_us(300.0, NATIVE_WORLD_DEFAULT_TEMP_C);
+    uint32_t rise_us = NATIVE_ULTRASOUND_TRIGGER_US + NATIVE_ULTRASOUND_ECHO_START_US;
+    native_system_advance_ms((rise_us + echo_us) / 1000U - 1U);
+    UNITY_TEST_ASSERT(!port_ultrasound_get_echo_received(TEST_SENSOR_ID), __LINE__, "ERROR: The falling edge must not arrive before its millisecond");
+    UNITY_TEST_ASSERT_EQUAL_UINT32(rise_us, port_ultrasound_get_echo_init_tick(TEST_SENSOR_ID), __LINE__, "ERROR: The rising edge must be captured at its microsecond of the echo timer");
+
+    native_system_advance_ms(1);
+    UNITY_TEST_ASSERT(port_ultrasound_get_echo_received(TEST_SENSOR_ID), __LINE__, "ERROR: The falling edge must arrive in its millisecond");
+    UNITY_TEST_ASSERT_EQUAL_UINT32(rise_us + echo_us, port_ultrasound_get_echo_end_tick(TEST_SENSOR_ID) + port_ultrasound_get_echo_overflows(TEST_SENSOR_ID) * PORT_PARKING_SENSOR_ECHO_TIMER_TICKS, __LINE__, "ERROR: The falling edge must be captured at its microsecond of the echo timer");
+
+    port_ultrasound_stop_ultrasound(TEST_SENSOR_ID);
+}
+
+int main(void)
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_world_static_obstacle);
+    RUN_TEST(test_world_temperature);
+    RUN_TEST(test_world_trajectory_streamed);
+    RUN_TEST(test_world_beam);
+    RUN_TEST(test_world_missing_and_ghost);
+    RUN_TEST(test_world_crosstalk);
+    RUN_TEST(test_world_noise_is_reproducible);
+    RUN_TEST(test_world_echo_timer_edges);
+    exit(UNITY_END());
+}
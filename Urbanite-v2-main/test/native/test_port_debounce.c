@@ -0,0 +1,176 @@
+/**
+ * @file test_port_debounce.c
+ * @brief Unit test for the multi-key debounce engine.
+ *
+ * The vertical counter is checked step by step. The queue of events is checked with the emulated inputs of the native port and its virtual time.
+ *
+ * @date 2025-01-01
+ */
+/* System dependent libraries */
+#include <stdlib.h>
+#include <unity.h>
+
+/* HW dependent libraries */
+#include "port_system.h"
+#include "port_debounce.h"
+#include "native_debounce.h"
+
+/* Defines and enums ----------------------------------------------------------*/
+#define TEST_STABLE_SAMPLES 4U                                        /*!< Samples with the new level needed to toggle a key @hideinitializer */
+#define TEST_DEBOUNCE_MS (TEST_STABLE_SAMPLES * PORT_DEBOUNCE_PERIOD_MS) /*!< Maximum time for a change to pass the engine @hideinitializer */
+
+/* Private functions ---------------------------------------------------------*/
+/**
+ * @brief Initialize a vertical counter as the engine does
+ * @param p_vcnt Pointer to the vertical counter
+ */
+static void _vcnt_init(port_debounce_vcnt_t *p_vcnt)
+{
+    p_vcnt->ct0 = 0xFFFFFFFFU;
+    p_vcnt->ct1 = 0xFFFFFFFFU;
+    p_vcnt->state = 0;
+}
+
+/**
+ * @brief Set the raw level of all the keys
+ * @param mask Keys pressed
+ */
+static void _set_raw_mask(uint32_t mask)
+{
+    for (uint32_t key_id = 0; key_id < PORT_DEBOUNCE_MAX_KEYS; key_id++)
+    {
+        native_debounce_set_raw(key_id, (mask & (1U << key_id)) != 0U);
+    }
+}
+
+void setUp(void)
+{
+    port_debounce_init();
+}
+
+void tearDown(void)
+{
+}
+
+/* Tests ---------------------------------------------------------------------*/
+void test_vcnt_bounce_rejected(void)
+{
+    port_debounce_vcnt_t vcnt;
+    _vcnt_init(&vcnt);
+    for (uint32_t i = 0; i < (TEST_STABLE_SAMPLES - 1U); i++)
+    {
+        UNITY_TEST_ASSERT_EQUAL_UINT32(0, port_debounce_vcnt_step(&vcnt, 0x1U), __LINE__, "A key must not toggle with fewer than 4 stable samples");
+    }
+    UNITY_TEST_ASSERT_EQUAL_UINT32(0, port_debounce_vcnt_step(&vcnt, 0x0U), __LINE__, "A bounce back to the old level must not toggle the key");
+    for (uint32_t i = 0; i < (TEST_STABLE_SAMPLES - 1U); i++)
+    {
+        UNITY_TEST_ASSERT_EQUAL_UINT32(0, port_debounce_vcnt_step(&vcnt, 0x1U), __LINE__, "A bounce must restart the count of stable samples");
+    }
+    UNITY_TEST_ASSERT_EQUAL_UINT32(0x1U, port_debounce_vcnt_step(&vcnt, 0x1U), __LINE__, "A key must toggle on the 4th stable sample");
+    UNITY_TEST_ASSERT_EQUAL_UINT32(0x1U, vcnt.state, __LINE__, "The debounced state must follow the toggle");
+    UNITY_TEST_ASSERT_EQUAL_UINT32(0, port_debounce_vcnt_step(&vcnt, 0x1U), __LINE__, "A stable key must not toggle again");
+}
+
+void test_vcnt_parallel_keys(void)
+{
+    port_debounce_vcnt_t vcnt;
+    _vcnt_init(&vcnt);
+    uint32_t stable = 0x80000009U;
+    uint32_t bouncing = 0x20U;
+    for (uint32_t i = 0; i < (TEST_STABLE_SAMPLES - 1U); i++)
+    {
+        uint32_t sample = stable | (((i % 2U) == 0U) ? bouncing : 0U);
+        UNITY_TEST_ASSERT_EQUAL_UINT32(0, port_debounce_vcnt_step(&vcnt, sample), __LINE__, "No key must toggle before 4 stable samples");
+    }
+    UNITY_TEST_ASSERT_EQUAL_UINT32(stable, port_debounce_vcnt_step(&vcnt, stable), __LINE__, "All the stable keys must toggle in the same step, the bouncing one must not");
+    UNITY_TEST_ASSERT_EQUAL_UINT32(stable, vcnt.state, __LINE__, "The debounced state must only have the stable keys");
+
+    for (uint32_t i = 0; i < (TEST_STABLE_SAMPLES - 1U); i++)
+    {
+        UNITY_TEST_ASSERT_EQUAL_UINT32(0, port_debounce_vcnt_step(&vcnt, 0x8U), __LINE__, "The released keys must not toggle before 4 stable samples");
+    }
+    UNITY_TEST_ASSERT_EQUAL_UINT32(0x80000001U, port_debounce_vcnt_step(&vcnt, 0x8U), __LINE__, "Only the released keys must toggle");
+    UNITY_TEST_ASSERT_EQUAL_UINT32(0x8U, vcnt.state, __LINE__, "The held key must stay pressed");
+}
+
+void test_event_timestamps(void)
+{
+    uint32_t start_ms = port_system_get_millis();
+    native_debounce_set_raw(2, true);
+    port_system_delay_ms(TEST_DEBOUNCE_MS + PORT_DEBOUNCE_PERIOD_MS);
+    uint32_t expected_ms = ((start_ms / PORT_DEBOUNCE_PERIOD_MS) + TEST_STABLE_SAMPLES) * PORT_DEBOUNCE_PERIOD_MS;
+
+    port_debounce_event_t event;
+    UNITY_TEST_ASSERT_EQUAL_INT(true, port_debounce_get_event(&event), __LINE__, "A press must be queued");
+    UNITY_TEST_ASSERT_EQUAL_UINT32(2, event.key_id, __LINE__, "The key ID of the event is wrong");
+    UNITY_TEST_ASSERT_EQUAL_INT(true, event.pressed, __LINE__, "The event must be a press");
+    UNITY_TEST_ASSERT_EQUAL_UINT32(expected_ms, event.timestamp_ms, __LINE__, "The timestamp must be the time of the 4th stable sample");
+    UNITY_TEST_ASSERT_EQUAL_INT(true, port_debounce_get_pressed(2), __LINE__, "The debounced state must be pressed");
+
+    start_ms = port_system_get_millis();
+    native_debounce_set_raw(2, false);
+    port_system_delay_ms(TEST_DEBOUNCE_MS + PORT_DEBOUNCE_PERIOD_MS);
+    expected_ms = ((start_ms / PORT_DEBOUNCE_PERIOD_MS) + TEST_STABLE_SAMPLES) * PORT_DEBOUNCE_PERIOD_MS;
+    UNITY_TEST_ASSERT_EQUAL_INT(true, port_debounce_get_event(&event), __LINE__, "A release must be queued");
+    UNITY_TEST_ASSERT_EQUAL_INT(false, event.pressed, __LINE__, "The event must be a release");
+    UNITY_TEST_ASSERT_EQUAL_UINT32(expected_ms, event.timestamp_ms, __LINE__, "The timestamp must be the time of the 4th stable sample");
+    UNITY_TEST_ASSERT_EQUAL_INT(false, port_debounce_get_event(&event), __LINE__, "There must be no more events");
+}
+
+void test_several_keys_one_tick(void)
+{
+    _set_raw_mask((1U << 1) | (1U << 4) | (1U << 15));
+    port_system_delay_ms(TEST_DEBOUNCE_MS + PORT_DEBOUNCE_PERIOD_MS);
+
+    port_debounce_event_t events[3];
+    uint32_t keys = 0;
+    for (uint32_t i = 0; i < 3U; i++)
+    {
+        UNITY_TEST_ASSERT_EQUAL_INT(true, port_debounce_get_event(&events[i]), __LINE__, "A press must be queued for every key");
+        UNITY_TEST_ASSERT_EQUAL_INT(true, events[i].pressed, __LINE__, "The events must be presses");
+        UNITY_TEST_ASSERT_EQUAL_UINT32(events[0].timestamp_ms, events[i].timestamp_ms, __LINE__, "The keys toggled in the same tick must have the same timestamp");
+        keys |= (1U << events[i].key_id);
+    }
+    UNITY_TEST_ASSERT_EQUAL_UINT32((1U << 1) | (1U << 4) | (1U << 15), keys, __LINE__, "The events must be of the pressed keys");
+    UNITY_TEST_ASSERT_EQUAL_INT(false, port_debounce_get_event(&events[0]), __LINE__, "There must be one event per key");
+    _set_raw_mask(0);
+}
+
+void test_queue_overflow(void)
+{
+    uint32_t all_keys = (1U << PORT_DEBOUNCE_MAX_KEYS) - 1U;
+    uint32_t cycles = 2U;
+    for (uint32_t i = 0; i < cycles; i++)
+    {
+        _set_raw_mask(all_keys);
+        port_system_delay_ms(TEST_DEBOUNCE_MS + PORT_DEBOUNCE_PERIOD_MS);
+        _set_raw_mask(0);
+        port_system_delay_ms(TEST_DEBOUNCE_MS + PORT_DEBOUNCE_PERIOD_MS);
+    }
+    uint32_t total = cycles * 2U * PORT_DEBOUNCE_MAX_KEYS;
+    UNITY_TEST_ASSERT_EQUAL_UINT32(total - PORT_DEBOUNCE_QUEUE_SIZE, port_debounce_get_dropped_events(), __LINE__, "The events that do not fit in the queue must be counted as dropped");
+
+    port_debounce_event_t event;
+    uint32_t count = 0;
+    while (port_debounce_get_event(&event))
+    {
+        bool first_half = count < PORT_DEBOUNCE_MAX_KEYS;
+        UNITY_TEST_ASSERT_EQUAL_INT(first_half, event.pressed, __LINE__, "The oldest events must be kept: the presses and then the releases of the first cycle");
+        count++;
+    }
+    UNITY_TEST_ASSERT_EQUAL_UINT32(PORT_DEBOUNCE_QUEUE_SIZE, count, __LINE__, "The queue must keep as many events as it fits");
+}
+
+int main(void)
+{
+    port_system_init();
+    UNITY_BEGIN();
+
+    RUN_TEST(test_vcnt_bounce_rejected);
+    RUN_TEST(test_vcnt_parallel_keys);
+    RUN_TEST(test_event_timestamps);
+    RUN_TEST(test_several_keys_one_tick);
+    RUN_TEST(test_queue_overflow);
+
+    exit(UNITY_END());
+}
@@ -0,0 +1,134 @@
+/**
+ * @file test_port_isr_stats.c
+ * @brief Unit test for the latency and duration statistics of the ISRs.
+ *
+ * The ISRs are emulated with handlers of the test, which call `port_isr_stats_enter()` and `port_isr_stats_exit()` directly, so the test does not depend on `PORT_ISR_STATS` being defined. The native cycles are nanoseconds of real time.
+ *
+ * @date 2025-01-01
+ */
+/* System dependent libraries */
+#define _POSIX_C_SOURCE 200809L
+#include <stdlib.h>
+#include <time.h>
+#include <unity.h>
+
+/* HW dependent libraries */
+#include "port_system.h"
+#include "port_isr_stats.h"
+#include "native_system.h"
+
+/* Defines and enums ----------------------------------------------------------*/
+#define TEST_SLEEP_NS 2000000L /*!< Real time spent inside the emulated ISRs */
+#define TEST_IRQ_PRIO 7U        /*!< Priority of the emulated interrupt. It is masked by the critical sections */
+
+/* Private functions ---------------------------------------------------------*/
+/**
+ * @brief Spend real time
+ */
+static void _test_sleep(void)
+{
+    struct timespec ts = {.tv_sec = 0, .tv_nsec = TEST_SLEEP_NS};
+    nanosleep(&ts, NULL);
+}
+
+/**
+ * @brief Emulated ISR that spends real time
+ */
+static void _test_irq_handler(void)
+{
+    port_isr_stats_enter(PORT_ISR_ID_TELEMETRY, native_system_irq_get_latency(NATIVE_SYSTEM_IRQ_TELEMETRY));
+    _test_sleep();
+    port_isr_stats_exit(PORT_ISR_ID_TELEMETRY);
+}
+
+void setUp(void)
+{
+    port_system_init();
+    port_isr_stats_reset();
+}
+
+void tearDown(void)
+{
+    native_system_irq_config(NATIVE_SYSTEM_IRQ_TELEMETRY, TEST_IRQ_PRIO, NULL);
+}
+
+/* Tests ---------------------------------------------------------------------*/
+void test_buckets(void)
+{
+    UNITY_TEST_ASSERT_EQUAL_UINT32(0, port_isr_stats_get_bucket(0), __LINE__, "0 cycles must go to the first bucket");
+    UNITY_TEST_ASSERT_EQUAL_UINT32(1, port_isr_stats_get_bucket(1), __LINE__, "1 cycle must go to the bucket 1");
+    UNITY_TEST_ASSERT_EQUAL_UINT32(2, port_isr_stats_get_bucket(3), __LINE__, "2 and 3 cycles must go to the bucket 2");
+    UNITY_TEST_ASSERT_EQUAL_UINT32(3, port_isr_stats_get_bucket(4), __LINE__, "4 to 7 cycles must go to the bucket 3");
+    UNITY_TEST_ASSERT_EQUAL_UINT32(PORT_ISR_STATS_NUM_BUCKETS - 1U, port_isr_stats_get_bucket(UINT32_MAX), __LINE__, "The longest values must go to the last bucket");
+}
+
+void test_preemption_excluded_from_duration(void)
+{
+    port_isr_stats_enter(PORT_ISR_ID_ECHO, 10U);
+    port_isr_stats_enter(PORT_ISR_ID_SYSTICK, PORT_ISR_STATS_NO_LATENCY); /* The System tick preempts the echo ISR */
+    _test_sleep();
+    port_isr_stats_exit(PORT_ISR_ID_SYSTICK);
+    port_isr_stats_exit(PORT_ISR_ID_ECHO);
+
+    volatile port_isr_stats_t *p_echo = &port_isr_stats_arr[PORT_ISR_ID_ECHO];
+    volatile port_isr_stats_t *p_systick = &port_isr_stats_arr[PORT_ISR_ID_SYSTICK];
+    UNITY_TEST_ASSERT_EQUAL_UINT32(1, p_echo->calls, __LINE__, "The echo ISR must be accounted");
+    UNITY_TEST_ASSERT_EQUAL_UINT32(1, p_echo->preemptions, __LINE__, "The preemption of the echo ISR must be counted");
+    UNITY_TEST_ASSERT_EQUAL_UINT32(0, p_systick->preemptions, __LINE__, "The System tick has not been preempted");
+    UNITY_TEST_ASSERT(p_systick->max_duration_cycles >= (uint32_t)TEST_SLEEP_NS, __LINE__, "The duration of the nested ISR must include its time");
+    UNITY_TEST_ASSERT(p_echo->max_duration_cycles < (uint32_t)TEST_SLEEP_NS, __LINE__, "The duration must exclude the time of the preemption");
+    UNITY_TEST_ASSERT(p_echo->max_response_cycles >= (uint32_t)TEST_SLEEP_NS + 10U, __LINE__, "The response time must include the latency and the preemption");
+    UNITY_TEST_ASSERT_EQUAL_UINT32(10, p_echo->max_latency_cycles, __LINE__, "Wrong latency");
+    UNITY_TEST_ASSERT_EQUAL_UINT32(1, p_echo->latency_hist_arr[port_isr_stats_get_bucket(10)], __LINE__, "The latency must be in its bucket");
+    UNITY_TEST_ASSERT_EQUAL_UINT32(0, p_systick->max_latency_cycles, __LINE__, "An ISR without latency must not fill the latency histogram");
+}
+
+void test_latency_of_masked_interrupt(void)
+{
+    native_system_irq_config(NATIVE_SYSTEM_IRQ_TELEMETRY, TEST_IRQ_PRIO, _test_irq_handler);
+
+    port_system_enter_critical();
+    native_system_irq_raise(NATIVE_SYSTEM_IRQ_TELEMETRY);
+    _test_sleep();
+    UNITY_TEST_ASSERT_EQUAL_UINT32(0, port_isr_stats_arr[PORT_ISR_ID_TELEMETRY].calls, __LINE__, "The interrupt must be masked by the critical section");
+    port_system_exit_critical();
+
+    volatile port_isr_stats_t *p_stats = &port_isr_stats_arr[PORT_ISR_ID_TELEMETRY];
+    UNITY_TEST_ASSERT_EQUAL_UINT32(1, p_stats->calls, __LINE__, "The interrupt must run when the critical section is left");
+    UNITY_TEST_ASSERT(p_stats->max_latency_cycles >= (uint32_t)TEST_SLEEP_NS, __LINE__, "The latency must include the time in the critical section");
+    UNITY_TEST_ASSERT(p_stats->max_response_cycles >= 2U * (uint32_t)TEST_SLEEP_NS, __LINE__, "The response time must include the latency and the duration");
+}
+
+void test_latency_after_entry(void)
+{
+    port_isr_stats_enter(PORT_ISR_ID_ECHO, PORT_ISR_STATS_NO_LATENCY);
+    _test_sleep();
+    port_isr_stats_latency(PORT_ISR_ID_ECHO, 10U * (uint32_t)TEST_SLEEP_NS); /* The event was 10 sleeps ago, 9 before the entry */
+    port_isr_stats_latency(PORT_ISR_ID_ECHO, 0U);
+    port_isr_stats_latency(PORT_ISR_ID_BUTTON, UINT32_MAX - 1U);
+    port_isr_stats_exit(PORT_ISR_ID_ECHO);
+
+    volatile port_isr_stats_t *p_echo = &port_isr_stats_arr[PORT_ISR_ID_ECHO];
+    UNITY_TEST_ASSERT(p_echo->max_latency_cycles <= 9U * (uint32_t)TEST_SLEEP_NS, __LINE__, "The time since the entry must be subtracted from the latency");
+    UNITY_TEST_ASSERT(p_echo->max_latency_cycles >= 5U * (uint32_t)TEST_SLEEP_NS, __LINE__, "The worst latency given to the ISR must be kept");
+    UNITY_TEST_ASSERT_EQUAL_UINT32(0, port_isr_stats_arr[PORT_ISR_ID_BUTTON].max_latency_cycles, __LINE__, "The latency of an ISR that is not running must be ignored");
+}
+
+void test_unbalanced_exit_ignored(void)
+{
+    port_isr_stats_exit(PORT_ISR_ID_BUTTON);
+    UNITY_TEST_ASSERT_EQUAL_UINT32(0, port_isr_stats_arr[PORT_ISR_ID_BUTTON].calls, __LINE__, "An exit without entry must not be accounted");
+}
+
+int main(void)
+{
+    UNITY_BEGIN();
+
+    RUN_TEST(test_buckets);
+    RUN_TEST(test_preemption_excluded_from_duration);
+    RUN_TEST(test_latency_of_masked_interrupt);
+    RUN_TEST(test_latency_after_entry);
+    RUN_TEST(test_unbalanced_exit_ignored);
+
+    exit(UNITY_END());
+}
@@ -0,0 +1,120 @@
+/**
+ * @file test_port_latency.c
+ * @brief Unit test for the end-to-end latency tracing of the measurements.
+ *
+ * The trace points are marked directly with `port_latency_mark()` and `port_latency_mark_at()`, so the test does not depend on `PORT_LATENCY_TRACE` being defined. The time is the virtual time of the native port.
+ *
+ * @date 2025-01-01
+ */
+/* System dependent libraries */
+#include <stdlib.h>
+#include <unity.h>
+
+/* HW dependent libraries */
+#include "port_system.h"
+#include "port_latency.h"
+
+/* Defines and enums ----------------------------------------------------------*/
+#define TEST_SENSOR_ID 0U /*!< Traced sensor */
+
+/* Private functions ---------------------------------------------------------*/
+/**
+ * @brief Trace a whole measurement at given times
+ * @param p_t_us Time of each trace point
+ */
+static void _test_measurement(const uint32_t *p_t_us)
+{
+    for (uint32_t point = 0; point < PORT_LATENCY_NUM_POINTS; point++)
+    {
+        port_latency_mark_at(TEST_SENSOR_ID, point, p_t_us[point]);
+    }
+}
+
+void setUp(void)
+{
+    port_system_init();
+    port_latency_reset();
+}
+
+void tearDown(void)
+{
+}
+
+/* Tests ---------------------------------------------------------------------*/
+void test_breakdown_of_a_measurement(void)
+{
+    port_latency_mark(TEST_SENSOR_ID, PORT_LATENCY_TRIGGER_START);
+    port_system_delay_ms(1);
+    port_latency_mark(TEST_SENSOR_ID, PORT_LATENCY_ECHO_RISE);
+    port_system_delay_ms(2);
+    port_latency_mark(TEST_SENSOR_ID, PORT_LATENCY_ECHO_FALL);
+    port_system_delay_ms(1);
+    port_latency_mark(TEST_SENSOR_ID, PORT_LATENCY_SET_DISTANCE);
+    port_latency_mark(TEST_SENSOR_ID, PORT_LATENCY_MEDIAN_READY);
+    port_system_delay_ms(3);
+    port_latency_mark(TEST_SENSOR_ID, PORT_LATENCY_CONSUMED);
+
+    port_latency_record_t record;
+    UNITY_TEST_ASSERT(port_latency_get_last(TEST_SENSOR_ID, &record), __LINE__, "The consumed measurement must be available");
+    UNITY_TEST_ASSERT_EQUAL_UINT32(1, record.seq, __LINE__, "The first measurement must have the sequence number 1");
+
+    const uint32_t expected_us_arr[PORT_LATENCY_NUM_STAGES] = {1000, 2000, 1000, 0, 3000, 4000};
+    for (uint32_t stage = 0; stage < PORT_LATENCY_NUM_STAGES; stage++)
+    {
+        uint32_t us = 0;
+        UNITY_TEST_ASSERT(port_latency_get_stage(&record, stage, &us), __LINE__, "Every stage must have been reached");
+        UNITY_TEST_ASSERT_EQUAL_UINT32(expected_us_arr[stage], us, __LINE__, "Wrong duration of a stage");
+    }
+}
+
+void test_measurement_without_median_discarded(void)
+{
+    const uint32_t t_us_arr[PORT_LATENCY_NUM_POINTS] = {0, 100, 600, 700, 800, 1000};
+
+    port_latency_mark_at(TEST_SENSOR_ID, PORT_LATENCY_TRIGGER_START, 0);
+    port_latency_mark_at(TEST_SENSOR_ID, PORT_LATENCY_ECHO_RISE, 100);
+    port_latency_mark_at(TEST_SENSOR_ID, PORT_LATENCY_CONSUMED, 200); /* There is no median to consume */
+    port_latency_summary_t summary;
+    UNITY_TEST_ASSERT(!port_latency_get_summary(PORT_LATENCY_STAGE_ECHO_TO_RESULT, &summary), __LINE__, "A consumption without median must be ignored");
+
+    _test_measurement(t_us_arr); /* The next trigger discards the measurement */
+    port_latency_mark_at(TEST_SENSOR_ID, PORT_LATENCY_CONSUMED, 5000); /* A second read of the same median */
+
+    port_latency_record_t record;
+    port_latency_get_last(TEST_SENSOR_ID, &record);
+    UNITY_TEST_ASSERT_EQUAL_UINT32(2, record.seq, __LINE__, "The consumed measurement must be the second one");
+    UNITY_TEST_ASSERT(port_latency_get_summary(PORT_LATENCY_STAGE_ECHO_TO_RESULT, &summary), __LINE__, "The measurement must be accounted");
+    UNITY_TEST_ASSERT_EQUAL_UINT32(1, summary.count, __LINE__, "A median must only be accounted once");
+    UNITY_TEST_ASSERT_EQUAL_UINT32(400, summary.max_us, __LINE__, "Wrong end-to-end latency");
+}
+
+void test_percentiles(void)
+{
+    for (uint32_t i = 1; i <= PORT_LATENCY_WINDOW + 10U; i++)
+    {
+        uint32_t delivery_us = (i <= 10U) ? 100000U : (i - 10U) * 10U; /* The first ones leave the window */
+        const uint32_t t_us_arr[PORT_LATENCY_NUM_POINTS] = {0, 100, 600, 700, 800, 800 + delivery_us};
+        _test_measurement(t_us_arr);
+    }
+
+    port_latency_summary_t summary;
+    UNITY_TEST_ASSERT(port_latency_get_summary(PORT_LATENCY_STAGE_DELIVERY, &summary), __LINE__, "The stage must have been measured");
+    UNITY_TEST_ASSERT_EQUAL_UINT32(PORT_LATENCY_WINDOW + 10U, summary.count, __LINE__, "Every measurement must be counted");
+    UNITY_TEST_ASSERT_EQUAL_UINT32(10, summary.min_us, __LINE__, "Wrong minimum of the window");
+    UNITY_TEST_ASSERT_EQUAL_UINT32(320, summary.p50_us, __LINE__, "Wrong median");
+    UNITY_TEST_ASSERT_EQUAL_UINT32(580, summary.p90_us, __LINE__, "Wrong 90th percentile");
+    UNITY_TEST_ASSERT_EQUAL_UINT32(640, summary.p99_us, __LINE__, "Wrong 99th percentile");
+    UNITY_TEST_ASSERT_EQUAL_UINT32(640, summary.max_us, __LINE__, "Wrong maximum of the window");
+    UNITY_TEST_ASSERT_EQUAL_UINT32(100000, summary.worst_us, __LINE__, "The worst case must be kept after it leaves the window");
+}
+
+int main(void)
+{
+    UNITY_BEGIN();
+
+    RUN_TEST(test_breakdown_of_a_measurement);
+    RUN_TEST(test_measurement_without_median_discarded);
+    RUN_TEST(test_percentiles);
+
+    exit(UNITY_END());
+}
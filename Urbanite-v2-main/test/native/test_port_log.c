@@ -0,0 +1,142 @@
+/**
+ * @file test_port_log.c
+ * @brief Unit test for the deferred binary logger.
+ *
+ * The records are drained to a temporary file and checked word by word.
+ *
+ * @date 2025-01-01
+ */
+/* System dependent libraries */
+#include <stdlib.h>
+#include <stdio.h>
+#include <unity.h>
+
+/* HW dependent libraries */
+#include "port_system.h"
+#include "port_log.h"
+#include "native_log.h"
+
+/* Global variables ----------------------------------------------------------*/
+static FILE *p_sink; /*!< Temporary file of the records */
+
+/* Private functions ---------------------------------------------------------*/
+/**
+ * @brief Read the words drained to the temporary file
+ * @param p_words Buffer for the words
+ * @param max_words Size of the buffer
+ * @return Number of words read
+ */
+static uint32_t _read_sink(uint32_t *p_words, uint32_t max_words)
+{
+    rewind(p_sink);
+    return (uint32_t)fread(p_words, sizeof(uint32_t), max_words, p_sink);
+}
+
+void setUp(void)
+{
+    p_sink = tmpfile();
+    native_log_set_sink(NULL);
+    port_system_init();
+}
+
+void tearDown(void)
+{
+    native_log_set_sink(NULL);
+    fclose(p_sink);
+}
+
+/* Tests ---------------------------------------------------------------------*/
+void test_record_format(void)
+{
+    port_system_delay_ms(3);
+    PORT_LOG_INFO(PORT_LOG_MSG_DISTANCE, 0, 42);
+    PORT_LOG_ERROR(PORT_LOG_MSG_BOOT);
+
+    native_log_set_sink(p_sink);
+    port_log_flush();
+
+    uint32_t words[16];
+    uint32_t n = _read_sink(words, 16);
+    UNITY_TEST_ASSERT_EQUAL_UINT32(6, n, __LINE__, "Two records of 4 and 2 words must be drained");
+    UNITY_TEST_ASSERT_EQUAL_UINT32(PORT_LOG_HEADER(PORT_LOG_LEVEL_INFO, PORT_LOG_MSG_DISTANCE, 2), words[0], __LINE__, "Wrong header of the first record");
+    UNITY_TEST_ASSERT_EQUAL_UINT32(3000, words[1], __LINE__, "The timestamp must be the time in microseconds");
+    UNITY_TEST_ASSERT_EQUAL_UINT32(0, words[2], __LINE__, "Wrong first argument");
+    UNITY_TEST_ASSERT_EQUAL_UINT32(42, words[3], __LINE__, "Wrong second argument");
+    UNITY_TEST_ASSERT_EQUAL_UINT32(PORT_LOG_HEADER(PORT_LOG_LEVEL_ERROR, PORT_LOG_MSG_BOOT, 0), words[4], __LINE__, "Wrong header of a record without arguments");
+    UNITY_TEST_ASSERT_EQUAL_UINT32(port_log_buffer.head, port_log_buffer.tail, __LINE__, "The buffer must be empty after the flush");
+}
+
+void test_records_kept_without_drain(void)
+{
+    PORT_LOG_WARN(PORT_LOG_MSG_GESTURE, 1, 2);
+    port_log_flush();
+
+    UNITY_TEST_ASSERT_EQUAL_UINT32(PORT_LOG_MAGIC, port_log_buffer.magic, __LINE__, "The buffer must be marked for the debugger");
+    UNITY_TEST_ASSERT_EQUAL_UINT32(4, port_log_buffer.head - port_log_buffer.tail, __LINE__, "The records must stay in the buffer if there is no drain");
+}
+
+void test_debug_level_compiled_out(void)
+{
+    uint32_t evaluations = 0;
+    PORT_LOG_DEBUG(PORT_LOG_MSG_GESTURE, evaluations++, 0);
+#if PORT_LOG_LEVEL >= PORT_LOG_LEVEL_DEBUG
+    UNITY_TEST_ASSERT_EQUAL_UINT32(1, evaluations, __LINE__, "The arguments of an enabled level must be evaluated");
+#else
+    UNITY_TEST_ASSERT_EQUAL_UINT32(0, evaluations, __LINE__, "The arguments of a disabled level must not be evaluated");
+    UNITY_TEST_ASSERT_EQUAL_UINT32(0, port_log_buffer.head, __LINE__, "A disabled level must not write records");
+#endif
+}
+
+void test_overflow_reported(void)
+{
+    uint32_t records = PORT_LOG_BUFFER_WORDS / 2U;
+    for (uint32_t i = 0; i < records + 5U; i++)
+    {
+        PORT_LOG_ERROR(PORT_LOG_MSG_BOOT);
+    }
+    UNITY_TEST_ASSERT_EQUAL_UINT32(5, port_log_buffer.dropped, __LINE__, "The records that do not fit must be dropped");
+
+    native_log_set_sink(p_sink);
+    port_log_flush();
+
+    static uint32_t words[PORT_LOG_BUFFER_WORDS + 8U];
+    uint32_t n = _read_sink(words, PORT_LOG_BUFFER_WORDS + 8U);
+    UNITY_TEST_ASSERT_EQUAL_UINT32(PORT_LOG_BUFFER_WORDS + 3U, n, __LINE__, "The full buffer and the record of the lost ones must be drained");
+    UNITY_TEST_ASSERT_EQUAL_UINT32(PORT_LOG_HEADER(PORT_LOG_LEVEL_WARN, PORT_LOG_MSG_DROPPED, 1), words[PORT_LOG_BUFFER_WORDS], __LINE__, "The lost records must be reported");
+    UNITY_TEST_ASSERT_EQUAL_UINT32(5, words[PORT_LOG_BUFFER_WORDS + 2U], __LINE__, "Wrong number of lost records");
+}
+
+void test_overflow_not_reported_while_full(void)
+{
+    uint32_t records = PORT_LOG_BUFFER_WORDS / 2U;
+    for (uint32_t i = 0; i < records + 5U; i++)
+    {
+        PORT_LOG_ERROR(PORT_LOG_MSG_BOOT);
+    }
+    for (uint32_t i = 0; i < 5U; i++)
+    {
+        port_log_flush();
+    }
+    UNITY_TEST_ASSERT_EQUAL_UINT32(5, port_log_buffer.dropped, __LINE__, "The flushes of a full buffer without drain must not drop their reports");
+
+    native_log_set_sink(p_sink);
+    port_log_flush();
+
+    static uint32_t words[PORT_LOG_BUFFER_WORDS + 8U];
+    uint32_t n = _read_sink(words, PORT_LOG_BUFFER_WORDS + 8U);
+    UNITY_TEST_ASSERT_EQUAL_UINT32(PORT_LOG_BUFFER_WORDS + 3U, n, __LINE__, "A single report must be drained once there is space");
+    UNITY_TEST_ASSERT_EQUAL_UINT32(5, words[PORT_LOG_BUFFER_WORDS + 2U], __LINE__, "Wrong number of lost records");
+}
+
+int main(void)
+{
+    UNITY_BEGIN();
+
+    RUN_TEST(test_record_format);
+    RUN_TEST(test_records_kept_without_drain);
+    RUN_TEST(test_debug_level_compiled_out);
+    RUN_TEST(test_overflow_reported);
+    RUN_TEST(test_overflow_not_reported_while_full);
+
+    exit(UNITY_END());
+}
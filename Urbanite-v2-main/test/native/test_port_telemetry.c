@@ -0,0 +1,180 @@
+/**
+ * @file test_port_telemetry.c
+ * @brief Unit test for the telemetry stream.
+ *
+ * The emulated UART writes the frames to a pipe, where they are decoded and checked byte by byte.
+ *
+ * @date 2025-01-01
+ */
+/* System dependent libraries */
+#define _POSIX_C_SOURCE 200809L /* pipe(), fcntl() */
+#include <stdlib.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <unity.h>
+
+/* HW dependent libraries */
+#include "port_system.h"
+#include "port_telemetry.h"
+#include "native_telemetry.h"
+
+/* Global variables ----------------------------------------------------------*/
+static int pipe_fds[2]; /*!< Read and write ends of the emulated UART */
+
+/* Private functions ---------------------------------------------------------*/
+/**
+ * @brief Read the next frame of the pipe and decode it
+ * @param p_payload Buffer for the decoded frame
+ * @return Number of decoded bytes. 0 if there is no complete frame
+ */
+static uint32_t _read_frame(uint8_t *p_payload)
+{
+    uint8_t encoded[PORT_TELEMETRY_FRAME_MAX_SIZE];
+    uint32_t length = 0;
+    while ((length < PORT_TELEMETRY_FRAME_MAX_SIZE) && (read(pipe_fds[0], &encoded[length], 1) == 1))
+    {
+        if (encoded[length++] == PORT_TELEMETRY_DELIMITER)
+        {
+            break;
+        }
+    }
+    if ((length == 0U) || (encoded[length - 1U] != PORT_TELEMETRY_DELIMITER))
+    {
+        return 0;
+    }
+    /* COBS decoding */
+    uint32_t out = 0;
+    uint32_t idx = 0;
+    while (idx < (length - 1U))
+    {
+        uint8_t code = encoded[idx++];
+        for (uint8_t i = 1; i < code; i++)
+        {
+            p_payload[out++] = encoded[idx++];
+        }
+        if ((code != 0xFFU) && (idx < (length - 1U)))
+        {
+            p_payload[out++] = 0;
+        }
+    }
+    return out;
+}
+
+/**
+ * @brief Check the CRC of a decoded frame
+ * @param p_payload Decoded frame
+ * @param length Number of bytes
+ * @return true if the CRC is correct
+ */
+static bool _check_crc(const uint8_t *p_payload, uint32_t length)
+{
+    uint16_t crc = PORT_TELEMETRY_CRC_INIT;
+    for (uint32_t i = 0; i < (length - PORT_TELEMETRY_CRC_SIZE); i++)
+    {
+        crc = port_telemetry_crc16(crc, p_payload[i]);
+    }
+    return crc == (uint16_t)(p_payload[length - 2U] | (p_payload[length - 1U] << 8));
+}
+
+void setUp(void)
+{
+    TEST_ASSERT_EQUAL(0, pipe(pipe_fds));
+    fcntl(pipe_fds[0], F_SETFL, O_NONBLOCK); /* A missing frame must not block the test */
+    port_system_init();
+    native_telemetry_set_fd(pipe_fds[1]);
+    port_telemetry_init();
+}
+
+void tearDown(void)
+{
+    native_telemetry_set_fd(-1);
+    close(pipe_fds[0]);
+    close(pipe_fds[1]);
+}
+
+/* Tests ---------------------------------------------------------------------*/
+void test_crc(void)
+{
+    const char *p_check = "123456789";
+    uint16_t crc = PORT_TELEMETRY_CRC_INIT;
+    for (uint32_t i = 0; p_check[i] != '\0'; i++)
+    {
+        crc = port_telemetry_crc16(crc, (uint8_t)p_check[i]);
+    }
+    UNITY_TEST_ASSERT_EQUAL_UINT32(0x29B1, crc, __LINE__, "Wrong check value of the CRC-16/CCITT-FALSE");
+}
+
+void test_full_frame(void)
+{
+    uint8_t payload[PORT_TELEMETRY_FRAME_MAX_SIZE];
+    port_system_delay_ms(2);
+    for (uint32_t i = 0; i < PORT_TELEMETRY_RECORDS_PER_FRAME - 1U; i++)
+    {
+        port_telemetry_send(0, 100 + i, 256, PORT_TELEMETRY_FLAG_VALID);
+    }
+    UNITY_TEST_ASSERT_EQUAL_UINT32(0, _read_frame(payload), __LINE__, "The frame must not be sent before it is full");
+
+    port_telemetry_send(0, 70000, 0, 0);
+    uint32_t length = _read_frame(payload);
+    UNITY_TEST_ASSERT_EQUAL_UINT32(PORT_TELEMETRY_PAYLOAD_MAX_SIZE, length, __LINE__, "Wrong length of a full frame");
+    UNITY_TEST_ASSERT(_check_crc(payload, length), __LINE__, "Wrong CRC");
+    UNITY_TEST_ASSERT_EQUAL_UINT32(PORT_TELEMETRY_VERSION, payload[0], __LINE__, "Wrong version");
+    UNITY_TEST_ASSERT_EQUAL_UINT32(0, payload[1], __LINE__, "Wrong sequence number of the first frame");
+
+    const uint8_t *p_record = &payload[PORT_TELEMETRY_HEADER_SIZE + PORT_TELEMETRY_RECORD_SIZE];
+    UNITY_TEST_ASSERT_EQUAL_UINT32(0, p_record[0], __LINE__, "Wrong sensor ID");
+    UNITY_TEST_ASSERT_EQUAL_UINT32(PORT_TELEMETRY_FLAG_VALID, p_record[1], __LINE__, "Wrong flags");
+    UNITY_TEST_ASSERT_EQUAL_UINT32(2000, p_record[2] | (p_record[3] << 8) | (p_record[4] << 16) | ((uint32_t)p_record[5] << 24), __LINE__, "Wrong timestamp");
+    UNITY_TEST_ASSERT_EQUAL_UINT32(101, p_record[6] | (p_record[7] << 8), __LINE__, "Wrong median distance");
+    UNITY_TEST_ASSERT_EQUAL_UINT32(256, p_record[8] | (p_record[9] << 8), __LINE__, "Wrong raw distance");
+
+    p_record = &payload[PORT_TELEMETRY_HEADER_SIZE + (PORT_TELEMETRY_RECORDS_PER_FRAME - 1U) * PORT_TELEMETRY_RECORD_SIZE];
+    UNITY_TEST_ASSERT_EQUAL_UINT32(UINT16_MAX, p_record[6] | (p_record[7] << 8), __LINE__, "The distances must be saturated to 16 bits");
+}
+
+void test_flush_partial_frame(void)
+{
+    uint8_t payload[PORT_TELEMETRY_FRAME_MAX_SIZE];
+    port_telemetry_flush();
+    UNITY_TEST_ASSERT_EQUAL_UINT32(0, _read_frame(payload), __LINE__, "An empty frame must not be sent");
+
+    port_telemetry_send(1, 30, 31, PORT_TELEMETRY_FLAG_NO_ECHO);
+    port_telemetry_send(1, 30, 29, 0);
+    port_telemetry_flush();
+    uint32_t length = _read_frame(payload);
+    UNITY_TEST_ASSERT_EQUAL_UINT32(PORT_TELEMETRY_HEADER_SIZE + 2U * PORT_TELEMETRY_RECORD_SIZE + PORT_TELEMETRY_CRC_SIZE, length, __LINE__, "Wrong length of a frame with 2 records");
+    UNITY_TEST_ASSERT(_check_crc(payload, length), __LINE__, "Wrong CRC");
+}
+
+void test_double_buffering(void)
+{
+    uint8_t payload[PORT_TELEMETRY_FRAME_MAX_SIZE];
+    for (uint32_t i = 0; i < 2U * PORT_TELEMETRY_RECORDS_PER_FRAME; i++)
+    {
+        UNITY_TEST_ASSERT(port_telemetry_send(0, i, i, 0), __LINE__, "The records must be stored while a frame is free");
+    }
+    UNITY_TEST_ASSERT(!port_telemetry_send(0, 0, 0, 0), __LINE__, "The record must be dropped while both frames are busy");
+    UNITY_TEST_ASSERT_EQUAL_UINT32(1, port_telemetry_get_dropped(), __LINE__, "The dropped record must be counted");
+
+    UNITY_TEST_ASSERT(_read_frame(payload) != 0U, __LINE__, "The first frame must be sent");
+    UNITY_TEST_ASSERT_EQUAL_UINT32(0, _read_frame(payload), __LINE__, "The second frame must wait for the end of the first one");
+
+    port_system_delay_ms(8); /* 87 bytes at 115200 bauds */
+    uint32_t length = _read_frame(payload);
+    UNITY_TEST_ASSERT_EQUAL_UINT32(PORT_TELEMETRY_PAYLOAD_MAX_SIZE, length, __LINE__, "The second frame must be sent after the first one");
+    UNITY_TEST_ASSERT_EQUAL_UINT32(1, payload[1], __LINE__, "Wrong sequence number of the second frame");
+    UNITY_TEST_ASSERT_EQUAL_UINT32(PORT_TELEMETRY_RECORDS_PER_FRAME, payload[PORT_TELEMETRY_HEADER_SIZE + 6U], __LINE__, "The second frame must start with the ninth record");
+    UNITY_TEST_ASSERT(port_telemetry_send(0, 0, 0, 0), __LINE__, "The records must be stored again when a frame is free");
+}
+
+int main(void)
+{
+    UNITY_BEGIN();
+
+    RUN_TEST(test_crc);
+    RUN_TEST(test_full_frame);
+    RUN_TEST(test_flush_partial_frame);
+    RUN_TEST(test_double_buffering);
+
+    exit(UNITY_END());
+}
@@ -0,0 +1,246 @@
+/**
+ * @file test_port_timer.c
+ * @brief Unit test for the software timers of the port layer.
+ *
+ * The timers are driven with the virtual time of the native platform, so they expire at the first millisecond at or after their expiry.
+ *
+ * @date 2025-01-01
+ */
+/* System dependent libraries */
+#include <stdlib.h>
+#include <unity.h>
+
+/* HW dependent libraries */
+#include "port_system.h"
+#include "port_timer.h"
+#include "native_system.h"
+
+/* Defines and enums ----------------------------------------------------------*/
+#define TEST_NUM_TIMERS 4U /*!< Number of test timers @hideinitializer */
+
+/* Global variables ----------------------------------------------------------*/
+static port_timer_t timers_arr[TEST_NUM_TIMERS];  /*!< Test timers */
+static uint32_t fired_ms_arr[TEST_NUM_TIMERS];    /*!< System time of the last expiry of each timer */
+static uint32_t fired_count_arr[TEST_NUM_TIMERS]; /*!< Number of expiries of each timer */
+static uint32_t order_arr[TEST_NUM_TIMERS];       /*!< Order of the expiries */
+static uint32_t order_idx;                        /*!< Number of entries of order_arr */
+
+/* Private functions ---------------------------------------------------------*/
+/**
+ * @brief Callback that records the expiry of a test timer
+ * @param p_arg Index of the timer in timers_arr, cast to a pointer
+ */
+static void _timer_record(void *p_arg)
+{
+    uint32_t idx = (uint32_t)(uintptr_t)p_arg;
+    fired_ms_arr[idx] = port_system_get_millis();
+    fired_count_arr[idx]++;
+    if (order_idx < TEST_NUM_TIMERS)
+    {
+        order_arr[order_idx++] = idx;
+    }
+}
+
+/**
+ * @brief Callback that records the expiry and cancels the next test timer
+ * @param p_arg Index of the timer in timers_arr, cast to a pointer
+ */
+static void _timer_cancel_next(void *p_arg)
+{
+    uint32_t idx = (uint32_t)(uintptr_t)p_arg;
+    _timer_record(p_arg);
+    port_timer_cancel(&timers_arr[idx + 1U]);
+}
+
+void setUp(void)
+{
+    port_system_init();
+    for (uint32_t i = 0; i < TEST_NUM_TIMERS; i++)
+    {
+        port_timer_setup(&timers_arr[i], _timer_record, (void *)(uintptr_t)i);
+        fired_ms_arr[i] = 0;
+        fired_count_arr[i] = 0;
+        order_arr[i] = 0;
+    }
+    order_idx = 0;
+}
+
+void tearDown(void)
+{
+}
+
+/* Tests ---------------------------------------------------------------------*/
+void test_timer_order(void)
+{
+    port_timer_start(&timers_arr[0], 5000, 0);
+    port_timer_start(&timers_arr[1], 2000, 0);
+    port_timer_start(&timers_arr[2], 9000, 0);
+
+    port_system_delay_ms(10);
+
+    UNITY_TEST_ASSERT_EQUAL_UINT32(3, order_idx, __LINE__, "All the timers must have expired");
+    UNITY_TEST_ASSERT_EQUAL_UINT32(1, order_arr[0], __LINE__, "The timer of 2 ms must expire first");
+    UNITY_TEST_ASSERT_EQUAL_UINT32(0, order_arr[1], __LINE__, "The timer of 5 ms must expire second");
+    UNITY_TEST_ASSERT_EQUAL_UINT32(2, order_arr[2], __LINE__, "The timer of 9 ms must expire last");
+    UNITY_TEST_ASSERT_EQUAL_UINT32(2, fired_ms_arr[1], __LINE__, "The timer of 2 ms expired at a wrong time");
+    UNITY_TEST_ASSERT_EQUAL_UINT32(5, fired_ms_arr[0], __LINE__, "The timer of 5 ms expired at a wrong time");
+    UNITY_TEST_ASSERT_EQUAL_UINT32(9, fired_ms_arr[2], __LINE__, "The timer of 9 ms expired at a wrong time");
+    UNITY_TEST_ASSERT(!port_timer_is_armed(&timers_arr[0]), __LINE__, "A one-shot timer must not be armed after it expires");
+}
+
+void test_timer_microsecond_order(void)
+{
+    port_timer_start(&timers_arr[0], 300, 0);
+    port_timer_start(&timers_arr[1], 100, 0);
+
+    port_system_delay_ms(1);
+
+    UNITY_TEST_ASSERT_EQUAL_UINT32(2, order_idx, __LINE__, "Both timers must have expired in the first millisecond");
+    UNITY_TEST_ASSERT_EQUAL_UINT32(1, order_arr[0], __LINE__, "The timer of 100 us must expire before the timer of 300 us");
+}
+
+void test_timer_cancel(void)
+{
+    port_timer_start(&timers_arr[0], 3000, 0);
+    port_timer_start(&timers_arr[1], 3000, 0);
+    port_timer_cancel(&timers_arr[0]);
+    port_timer_cancel(&timers_arr[2]); /* Not started: nothing to do */
+
+    port_system_delay_ms(5);
+
+    UNITY_TEST_ASSERT_EQUAL_UINT32(0, fired_count_arr[0], __LINE__, "A cancelled timer must not expire");
+    UNITY_TEST_ASSERT_EQUAL_UINT32(1, fired_count_arr[1], __LINE__, "The other timer of the slot must expire");
+    UNITY_TEST_ASSERT(!port_timer_is_armed(&timers_arr[0]), __LINE__, "A cancelled timer must not be armed");
+}
+
+void test_timer_restart(void)
+{
+    port_timer_start(&timers_arr[0], 3000, 0);
+    port_system_delay_ms(2);
+    port_timer_start(&timers_arr[0], 3000, 0);
+
+    port_system_delay_ms(2);
+    UNITY_TEST_ASSERT_EQUAL_UINT32(0, fired_count_arr[0], __LINE__, "A restarted timer must not expire at its previous expiry");
+
+    port_system_delay_ms(2);
+    UNITY_TEST_ASSERT_EQUAL_UINT32(1, fired_count_arr[0], __LINE__, "A restarted timer must expire once");
+    UNITY_TEST_ASSERT_EQUAL_UINT32(5, fired_ms_arr[0], __LINE__, "A restarted timer expired at a wrong time");
+}
+
+void test_timer_periodic(void)
+{
+    port_timer_start(&timers_arr[0], 3000, 3000);
+
+    port_system_delay_ms(10);
+
+    UNITY_TEST_ASSERT_EQUAL_UINT32(3, fired_count_arr[0], __LINE__, "A periodic timer of 3 ms must expire 3 times in 10 ms");
+    UNITY_TEST_ASSERT_EQUAL_UINT32(9, fired_ms_arr[0], __LINE__, "A periodic timer must not drift");
+    UNITY_TEST_ASSERT(port_timer_is_armed(&timers_arr[0]), __LINE__, "A periodic timer must stay armed");
+
+    port_timer_cancel(&timers_arr[0]);
+    port_system_delay_ms(10);
+    UNITY_TEST_ASSERT_EQUAL_UINT32(3, fired_count_arr[0], __LINE__, "A cancelled periodic timer must not expire again");
+}
+
+void test_timer_long_delay(void)
+{
+    port_timer_start(&timers_arr[0], 5000000, 0);  /* 5 s: cascades through the levels */
+    port_timer_start(&timers_arr[1], 70000000, 0); /* 70 s */
+    port_timer_start(&timers_arr[2], 1000, 0);
+
+    port_system_delay_ms(4999);
+    UNITY_TEST_ASSERT_EQUAL_UINT32(1, fired_count_arr[2], __LINE__, "The short timer must expire while the long ones are waiting");
+    UNITY_TEST_ASSERT_EQUAL_UINT32(0, fired_count_arr[0], __LINE__, "The timer of 5 s expired too early");
+
+    port_system_delay_ms(1);
+    UNITY_TEST_ASSERT_EQUAL_UINT32(1, fired_count_arr[0], __LINE__, "The timer of 5 s must expire at 5 s");
+
+    port_system_delay_ms(70000 - 5000 - 1);
+    UNITY_TEST_ASSERT_EQUAL_UINT32(0, fired_count_arr[1], __LINE__, "The timer of 70 s expired too early");
+
+    port_system_delay_ms(1);
+    UNITY_TEST_ASSERT_EQUAL_UINT32(1, fired_count_arr[1], __LINE__, "The timer of 70 s must expire at 70 s");
+}
+
+void test_timer_wrap_around(void)
+{
+    /* The counter of microseconds wraps around 4294967.296 ms after the start */
+    port_system_set_millis(4294960);
+    port_timer_start(&timers_arr[0], 10000, 0);
+    port_timer_start(&timers_arr[1], 5000, 0);
+
+    port_system_delay_ms(9);
+    UNITY_TEST_ASSERT_EQUAL_UINT32(1, fired_count_arr[1], __LINE__, "The timer before the wrap around must expire");
+    UNITY_TEST_ASSERT_EQUAL_UINT32(0, fired_count_arr[0], __LINE__, "The timer after the wrap around expired too early");
+
+    port_system_delay_ms(1);
+    UNITY_TEST_ASSERT_EQUAL_UINT32(1, fired_count_arr[0], __LINE__, "The timer after the wrap around must expire");
+}
+
+void test_timer_callback_cancels_other(void)
+{
+    port_timer_setup(&timers_arr[0], _timer_cancel_next, (void *)(uintptr_t)0);
+    port_timer_start(&timers_arr[0], 3000, 0);
+    port_timer_start(&timers_arr[1], 4000, 0);
+    port_timer_start(&timers_arr[2], 4000, 0);
+
+    port_system_delay_ms(5);
+
+    UNITY_TEST_ASSERT_EQUAL_UINT32(1, fired_count_arr[0], __LINE__, "The first timer must expire");
+    UNITY_TEST_ASSERT_EQUAL_UINT32(0, fired_count_arr[1], __LINE__, "A timer cancelled from a callback must not expire");
+    UNITY_TEST_ASSERT_EQUAL_UINT32(1, fired_count_arr[2], __LINE__, "The other timer of the slot must expire");
+}
+
+void test_timer_critical_section(void)
+{
+    port_timer_start(&timers_arr[0], 1000, 0);
+
+    port_system_enter_critical();
+    port_system_delay_ms(2);
+    UNITY_TEST_ASSERT_EQUAL_UINT32(0, fired_count_arr[0], __LINE__, "The callbacks must not run inside a critical section");
+    port_system_exit_critical();
+
+    UNITY_TEST_ASSERT_EQUAL_UINT32(1, fired_count_arr[0], __LINE__, "The callback must run when the critical section ends");
+}
+
+void test_timer_skip(void)
+{
+    port_timer_start(&timers_arr[0], 5000, 0);
+    port_timer_start(&timers_arr[1], 70000000, 0); /* 70 s: cascades through the levels */
+
+    uint32_t steps = 0;
+    while (port_system_get_millis() < 80000U)
+    {
+        native_system_skip_ms(80000U - port_system_get_millis() - 1U);
+        port_system_delay_ms(1);
+        steps++;
+    }
+    UNITY_TEST_ASSERT_EQUAL_UINT32(5, fired_ms_arr[0], __LINE__, "A skip must stop before the expiry of a timer");
+    UNITY_TEST_ASSERT_EQUAL_UINT32(70000, fired_ms_arr[1], __LINE__, "A skip must stop before the cascades and the expiry of a long timer");
+    UNITY_TEST_ASSERT(steps < 100U, __LINE__, "The virtual time without events must be skipped at once");
+
+    port_timer_start(&timers_arr[0], 1000, 0);
+    port_system_enter_critical();
+    UNITY_TEST_ASSERT_EQUAL_UINT32(0, native_system_skip_ms(10), __LINE__, "Nothing must be skipped inside a critical section");
+    port_system_exit_critical();
+    port_timer_cancel(&timers_arr[0]);
+    UNITY_TEST_ASSERT_EQUAL_UINT32(10, native_system_skip_ms(10), __LINE__, "Without armed timers the whole time must be skipped");
+}
+
+int main(void)
+{
+    UNITY_BEGIN();
+
+    RUN_TEST(test_timer_order);
+    RUN_TEST(test_timer_microsecond_order);
+    RUN_TEST(test_timer_cancel);
+    RUN_TEST(test_timer_restart);
+    RUN_TEST(test_timer_periodic);
+    RUN_TEST(test_timer_long_delay);
+    RUN_TEST(test_timer_wrap_around);
+    RUN_TEST(test_timer_callback_cancels_other);
+    RUN_TEST(test_timer_critical_section);
+    RUN_TEST(test_timer_skip);
+
+    exit(UNITY_END());
+}
@@ -0,0 +1,137 @@
+/**
+ * @file test_port_trace.c
+ * @brief Unit test for the capture trace and for the replay of a recorded echo in the native port.
+ *
+ * The records are appended directly with `port_trace_record()`, so the test does not depend on `PORT_CAPTURE_TRACE` being defined. The last test replays the captures of an echo through the emulated echo timer, as `trace_replay` does.
+ *
+ * @date 2025-01-01
+ */
+/* System dependent libraries */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unity.h>
+
+/* HW dependent libraries */
+#include "port_system.h"
+#include "port_button.h"
+#include "port_ultrasound.h"
+#include "port_trace.h"
+#include "native_system.h"
+#include "native_ultrasound.h"
+
+/* Defines and enums ----------------------------------------------------------*/
+#define TEST_SENSOR_ID 0U          /*!< Sensor of the records */
+#define TEST_INIT_TICK 60000U      /*!< Counter of the echo timer of the device at the rising edge */
+#define TEST_END_TICK 1234U        /*!< Counter of the echo timer of the device at the falling edge */
+#define TEST_OVERFLOWS 1U          /*!< Overflows of the echo timer of the device during the echo */
+
+/* Private functions ---------------------------------------------------------*/
+/**
+ * @brief Echo source that replays the recorded captures of `TEST_INIT_TICK`, `TEST_END_TICK` and `TEST_OVERFLOWS`
+ * @param p_arg Not used
+ * @param ultrasound_id Ultrasound ID
+ * @param burst_us Not used
+ * @return Duration of the recorded echo
+ */
+static uint32_t _test_recorded_echo_us(void *p_arg, uint32_t ultrasound_id, uint64_t burst_us)
+{
+    native_ultrasound_set_echo_counter(ultrasound_id, TEST_INIT_TICK);
+    return (TEST_END_TICK + TEST_OVERFLOWS * PORT_PARKING_SENSOR_ECHO_TIMER_TICKS) - TEST_INIT_TICK;
+}
+
+void setUp(void)
+{
+    port_system_init();
+    port_trace_reset();
+}
+
+void tearDown(void)
+{
+    native_ultrasound_set_echo_source(TEST_SENSOR_ID, NULL, NULL);
+}
+
+/* Tests ---------------------------------------------------------------------*/
+void test_trace_record(void)
+{
+    native_system_advance_ms(7);
+    port_trace_record(PORT_TRACE_ECHO, TEST_SENSOR_ID, 70000U, 0xABCD1234UL);
+
+    uint32_t size;
+    const port_trace_image_t *p_image = port_trace_get_image(&size);
+    UNITY_TEST_ASSERT_EQUAL_UINT32(PORT_TRACE_MAGIC, p_image->header.magic, __LINE__, "ERROR: The trace must begin with its magic number");
+    UNITY_TEST_ASSERT_EQUAL_UINT32(12, p_image->header.record_size, __LINE__, "ERROR: The records must have 12 bytes");
+    UNITY_TEST_ASSERT_EQUAL_UINT32(1, p_image->header.num_records, __LINE__, "ERROR: The header must count the records");
+    UNITY_TEST_ASSERT_EQUAL_UINT32(sizeof(port_trace_header_t) + sizeof(port_trace_record_t), size, __LINE__, "ERROR: The image must only have the records in use");
+
+    const port_trace_record_t *p_record = &p_image->records_arr[0];
+    UNITY_TEST_ASSERT_EQUAL_UINT32(7, p_record->time_ms, __LINE__, "ERROR: The record must have the system time");
+    UNITY_TEST_ASSERT_EQUAL_UINT32(PORT_TRACE_ECHO, p_record->type, __LINE__, "ERROR: The record must have its type");
+    UNITY_TEST_ASSERT_EQUAL_UINT32(0xFFFF, p_record->arg16, __LINE__, "ERROR: The first argument must saturate to 16 bits");
+    UNITY_TEST_ASSERT_EQUAL_UINT32(0xABCD1234UL, p_record->arg32, __LINE__, "ERROR: The second argument must be kept");
+}
+
+void test_trace_full_drops_new_records(void)
+{
+    for (uint32_t i = 0; i < PORT_TRACE_CAPACITY + 3U; i++)
+    {
+        port_trace_record(PORT_TRACE_TRIGGER, TEST_SENSOR_ID, 0, i);
+    }
+    UNITY_TEST_ASSERT_EQUAL_UINT32(PORT_TRACE_CAPACITY, port_trace_get_num_records(), __LINE__, "ERROR: The trace must not grow beyond its capacity");
+    UNITY_TEST_ASSERT_EQUAL_UINT32(3, port_trace_get_dropped(), __LINE__, "ERROR: The records of a full trace must be counted as dropped");
+    UNITY_TEST_ASSERT_EQUAL_UINT32(PORT_TRACE_CAPACITY - 1U, port_trace_image.records_arr[PORT_TRACE_CAPACITY - 1U].arg32, __LINE__, "ERROR: A full trace must keep the beginning of the session");
+
+    port_trace_reset();
+    UNITY_TEST_ASSERT_EQUAL_UINT32(0, port_trace_get_num_records(), __LINE__, "ERROR: The reset must empty the trace");
+    UNITY_TEST_ASSERT_EQUAL_UINT32(0, port_trace_get_dropped(), __LINE__, "ERROR: The reset must clear the dropped records");
+}
+
+void test_trace_save(void)
+{
+    port_trace_record(PORT_TRACE_BUTTON, PORT_PARKING_BUTTON_ID, 1, 0);
+    port_trace_record(PORT_TRACE_PRESS, PORT_PARKING_BUTTON_ID, 0, 250);
+
+    const char *p_path = "test_port_trace.bin";
+    UNITY_TEST_ASSERT(port_trace_save(p_path), __LINE__, "ERROR: The trace must be saved");
+    uint8_t file_arr[sizeof(port_trace_header_t) + 4U * sizeof(port_trace_record_t)];
+    FILE *p_file = fopen(p_path, "rb");
+    UNITY_TEST_ASSERT(p_file != NULL, __LINE__, "ERROR: The trace file must exist");
+    size_t size = fread(file_arr, 1, sizeof(file_arr), p_file);
+    fclose(p_file);
+    remove(p_path);
+
+    uint32_t image_size;
+    const void *p_image = port_trace_get_image(&image_size);
+    UNITY_TEST_ASSERT_EQUAL_UINT32(image_size, size, __LINE__, "ERROR: The file must have the header and the records in use");
+    UNITY_TEST_ASSERT(memcmp(p_image, file_arr, image_size) == 0, __LINE__, "ERROR: The file must be the image of the trace");
+}
+
+void test_replay_of_recorded_captures(void)
+{
+    port_ultrasound_init(TEST_SENSOR_ID);
+    native_ultrasound_set_echo_source(TEST_SENSOR_ID, _test_recorded_echo_us, NULL);
+    port_ultrasound_start_measurement(TEST_SENSOR_ID);
+    native_system_advance_ms(1);
+    port_ultrasound_stop_trigger_timer(TEST_SENSOR_ID);
+
+    for (uint32_t i = 0; (i < 100U) && !port_ultrasound_get_echo_received(TEST_SENSOR_ID); i++)
+    {
+        native_system_advance_ms(1);
+    }
+    UNITY_TEST_ASSERT(port_ultrasound_get_echo_received(TEST_SENSOR_ID), __LINE__, "ERROR: The recorded echo must end");
+    UNITY_TEST_ASSERT_EQUAL_UINT32(TEST_INIT_TICK, port_ultrasound_get_echo_init_tick(TEST_SENSOR_ID), __LINE__, "ERROR: The rising edge must be captured with the counter of the device");
+    UNITY_TEST_ASSERT_EQUAL_UINT32(TEST_END_TICK, port_ultrasound_get_echo_end_tick(TEST_SENSOR_ID), __LINE__, "ERROR: The falling edge must be captured with the counter of the device");
+    UNITY_TEST_ASSERT_EQUAL_UINT32(TEST_OVERFLOWS, port_ultrasound_get_echo_overflows(TEST_SENSOR_ID), __LINE__, "ERROR: The echo timer must overflow as in the device");
+
+    port_ultrasound_stop_ultrasound(TEST_SENSOR_ID);
+}
+
+int main(void)
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_trace_record);
+    RUN_TEST(test_trace_full_drops_new_records);
+    RUN_TEST(test_trace_save);
+    RUN_TEST(test_replay_of_recorded_captures);
+    exit(UNITY_END());
+}
@@ -0,0 +1,191 @@
+/**
+ * @file test_scheduler.c
+ * @brief Unit test for the cooperative scheduler.
+ *
+ * The tasks are driven with the virtual time of the native platform.
+ *
+ * @date 2025-01-01
+ */
+/* System dependent libraries */
+#include <stdlib.h>
+#include <unity.h>
+
+/* HW dependent libraries */
+#include "port_system.h"
+#include "native_system.h"
+
+/* Project libraries */
+#include "scheduler.h"
+
+/* Defines and enums ----------------------------------------------------------*/
+#define TEST_EVENT_BUTTON (1U << 0) /*!< Event of the tests @hideinitializer */
+#define TEST_EVENT_OTHER (1U << 1)  /*!< Event that no task waits for @hideinitializer */
+
+/* Global variables ----------------------------------------------------------*/
+static uint32_t runs_arr[SCHEDULER_MAX_TASKS]; /*!< Number of runs of each test task */
+static uint32_t order_arr[SCHEDULER_MAX_TASKS]; /*!< Order of execution of the test tasks */
+static uint32_t order_idx;                      /*!< Number of entries of order_arr */
+static uint32_t busy_ms;                        /*!< Execution time of the next run of the slow task */
+
+/* Private functions ---------------------------------------------------------*/
+/**
+ * @brief Test task that records its runs
+ * @param p_arg Index of the task in runs_arr, cast to a pointer
+ */
+static void _task_count(void *p_arg)
+{
+    uint32_t idx = (uint32_t)(uintptr_t)p_arg;
+    runs_arr[idx]++;
+    if (order_idx < SCHEDULER_MAX_TASKS)
+    {
+        order_arr[order_idx++] = idx;
+    }
+}
+
+/**
+ * @brief Test task whose next run takes busy_ms to complete. The following runs are immediate
+ * @param p_arg Index of the task in runs_arr, cast to a pointer
+ */
+static void _task_slow(void *p_arg)
+{
+    uint32_t ms = busy_ms;
+    busy_ms = 0;
+    _task_count(p_arg);
+    port_system_delay_ms(ms);
+}
+
+/**
+ * @brief Advance the virtual time dispatching every millisecond
+ * @param ms Time to run
+ */
+static void _run_ms(uint32_t ms)
+{
+    for (uint32_t i = 0; i < ms; i++)
+    {
+        port_system_delay_ms(1);
+        scheduler_dispatch();
+    }
+}
+
+void setUp(void)
+{
+    port_system_init();
+    scheduler_init();
+    for (uint32_t i = 0; i < SCHEDULER_MAX_TASKS; i++)
+    {
+        runs_arr[i] = 0;
+        order_arr[i] = 0;
+    }
+    order_idx = 0;
+    busy_ms = 0;
+}
+
+void tearDown(void)
+{
+    // Nothing to do
+}
+
+void test_add_task(void)
+{
+    scheduler_task_config_t config = {.p_name = "periodic", .func = _task_count, .p_arg = (void *)0, .period_ms = 10};
+    UNITY_TEST_ASSERT_EQUAL_INT(0, scheduler_add_task(&config), __LINE__, "The first task must have ID 0");
+    UNITY_TEST_ASSERT_EQUAL_INT(1, scheduler_add_task(&config), __LINE__, "The second task must have ID 1");
+
+    scheduler_task_config_t no_release = {.p_name = "never", .func = _task_count};
+    UNITY_TEST_ASSERT_EQUAL_INT(SCHEDULER_INVALID_TASK, scheduler_add_task(&no_release), __LINE__, "A task without period nor events must be rejected");
+    scheduler_task_config_t no_deadline = {.p_name = "event", .func = _task_count, .event_mask = TEST_EVENT_BUTTON};
+    UNITY_TEST_ASSERT_EQUAL_INT(SCHEDULER_INVALID_TASK, scheduler_add_task(&no_deadline), __LINE__, "An event task without deadline must be rejected");
+
+    for (uint32_t i = 2; i < SCHEDULER_MAX_TASKS; i++)
+    {
+        scheduler_add_task(&config);
+    }
+    UNITY_TEST_ASSERT_EQUAL_INT(SCHEDULER_INVALID_TASK, scheduler_add_task(&config), __LINE__, "The table must not accept more than SCHEDULER_MAX_TASKS tasks");
+    UNITY_TEST_ASSERT(scheduler_get_task_name(0) != NULL, __LINE__, "The name of a task must be kept");
+    UNITY_TEST_ASSERT(scheduler_get_task_name(SCHEDULER_MAX_TASKS) == NULL, __LINE__, "A task that does not exist must not have a name");
+}
+
+void test_periodic_release(void)
+{
+    scheduler_task_config_t fast = {.p_name = "fast", .func = _task_count, .p_arg = (void *)0, .period_ms = 5};
+    scheduler_task_config_t slow = {.p_name = "slow", .func = _task_count, .p_arg = (void *)1, .period_ms = 20};
+    int32_t fast_id = scheduler_add_task(&fast);
+    scheduler_add_task(&slow);
+
+    uint32_t wakeup;
+    UNITY_TEST_ASSERT(scheduler_get_next_wakeup_ms(&wakeup), __LINE__, "There must be a next wakeup with periodic tasks");
+    UNITY_TEST_ASSERT_EQUAL_UINT32(port_system_get_millis() + 5, wakeup, __LINE__, "The next wakeup must be the earliest release");
+
+    _run_ms(100);
+    UNITY_TEST_ASSERT_EQUAL_UINT32(20, runs_arr[0], __LINE__, "The 5 ms task must run 20 times in 100 ms");
+    UNITY_TEST_ASSERT_EQUAL_UINT32(5, runs_arr[1], __LINE__, "The 20 ms task must run 5 times in 100 ms");
+
+    scheduler_task_stats_t stats;
+    UNITY_TEST_ASSERT(scheduler_get_stats(fast_id, &stats), __LINE__, "The statistics of an existing task must be available");
+    UNITY_TEST_ASSERT_EQUAL_UINT32(20, stats.runs, __LINE__, "The runs of the statistics are wrong");
+    UNITY_TEST_ASSERT_EQUAL_UINT32(0, stats.deadline_misses, __LINE__, "There must not be deadline misses");
+    UNITY_TEST_ASSERT_EQUAL_UINT32(0, stats.max_latency_ms - stats.min_latency_ms, __LINE__, "There must not be jitter dispatching every millisecond");
+}
+
+void test_event_release(void)
+{
+    scheduler_task_config_t config = {.p_name = "button", .func = _task_count, .p_arg = (void *)0, .event_mask = TEST_EVENT_BUTTON, .deadline_ms = 5};
+    scheduler_add_task(&config);
+
+    uint32_t wakeup;
+    UNITY_TEST_ASSERT(!scheduler_get_next_wakeup_ms(&wakeup), __LINE__, "There must not be a next wakeup without periodic tasks");
+
+    scheduler_post_event(TEST_EVENT_OTHER);
+    UNITY_TEST_ASSERT_EQUAL_UINT32(0, scheduler_dispatch(), __LINE__, "An event that the task does not wait for must not release it");
+    scheduler_post_event(TEST_EVENT_BUTTON);
+    scheduler_post_event(TEST_EVENT_BUTTON);
+    UNITY_TEST_ASSERT_EQUAL_UINT32(1, scheduler_dispatch(), __LINE__, "Events posted before the task runs must release it once");
+    UNITY_TEST_ASSERT_EQUAL_UINT32(1, runs_arr[0], __LINE__, "The event task must run once");
+}
+
+void test_earliest_deadline_first(void)
+{
+    scheduler_task_config_t lax = {.p_name = "lax", .func = _task_count, .p_arg = (void *)0, .event_mask = TEST_EVENT_BUTTON, .deadline_ms = 50};
+    scheduler_task_config_t urgent = {.p_name = "urgent", .func = _task_count, .p_arg = (void *)1, .event_mask = TEST_EVENT_BUTTON, .deadline_ms = 2};
+    scheduler_add_task(&lax);
+    scheduler_add_task(&urgent);
+
+    scheduler_post_event(TEST_EVENT_BUTTON);
+    scheduler_dispatch();
+    UNITY_TEST_ASSERT_EQUAL_UINT32(2, order_idx, __LINE__, "Both tasks must run");
+    UNITY_TEST_ASSERT_EQUAL_UINT32(1, order_arr[0], __LINE__, "The task with the earliest deadline must run first");
+    UNITY_TEST_ASSERT_EQUAL_UINT32(0, order_arr[1], __LINE__, "The task with the latest deadline must run last");
+}
+
+void test_deadline_miss_and_overrun(void)
+{
+    scheduler_task_config_t config = {.p_name = "slow", .func = _task_slow, .p_arg = (void *)0, .period_ms = 10, .deadline_ms = 5};
+    int32_t task_id = scheduler_add_task(&config);
+
+    busy_ms = 8; /* Finishes after its deadline but before its next release */
+    _run_ms(10);
+    scheduler_task_stats_t stats;
+    scheduler_get_stats(task_id, &stats);
+    UNITY_TEST_ASSERT_EQUAL_UINT32(1, stats.runs, __LINE__, "The task must have run once");
+    UNITY_TEST_ASSERT_EQUAL_UINT32(1, stats.deadline_misses, __LINE__, "Finishing after the deadline must be a deadline miss");
+
+    scheduler_reset_stats();
+    busy_ms = 25; /* Overrun: the run misses its deadline, the next release starts late and the following one is skipped */
+    _run_ms(10);
+    scheduler_get_stats(task_id, &stats);
+    UNITY_TEST_ASSERT_EQUAL_UINT32(3, stats.deadline_misses, __LINE__, "The overrun, the late release and the skipped release must be deadline misses");
+    UNITY_TEST_ASSERT(stats.max_latency_ms > stats.min_latency_ms, __LINE__, "A release delayed by an overrun must show as jitter");
+}
+
+int main(void)
+{
+    UNITY_BEGIN();
+
+    RUN_TEST(test_add_task);
+    RUN_TEST(test_periodic_release);
+    RUN_TEST(test_event_release);
+    RUN_TEST(test_earliest_deadline_first);
+    RUN_TEST(test_deadline_miss_and_overrun);
+
+    exit(UNITY_END());
+}
@@ -0,0 +1,201 @@
+/**
+ * @file test_fake_stm32f4.c
+ * @brief Unit test of the register model of the STM32F4 used by the host build of the STM32F4 port.
+ *
+ * It drives the pins of the model and checks that the ISRs of `interr.c` run as in the device: the SysTick time base, the capture of the echo of the ultrasound sensor, the EXTI lines and the masking of the critical sections. It also checks the flags of the timers: `TIMx_SR` is rc_w0 and reading `CCRx` clears `CCxIF`.
+ *
+ * @date 2025-01-01
+ */
+
+/* Includes ------------------------------------------------------------------*/
+/* HW independent libraries */
+#include <stdlib.h>
+#include <unity.h>
+
+/* HW dependent libraries */
+#include "port_system.h"
+#include "port_ultrasound.h"
+#include "stm32f4_system.h"
+#include "stm32f4_ultrasound.h"
+#include "fake_stm32f4.h"
+
+/* Defines and enums ----------------------------------------------------------*/
+#define TEST_PORT_REAR_PARKING_SENSOR_ID 0 /*!< Ultrasound identifier @hideinitializer */
+#define TEST_ECHO_START_US 100U            /*!< Time from the trigger to the rising edge of the echo @hideinitializer */
+#define TEST_ECHO_WIDTH_US 580U            /*!< Width of the echo: 10 cm @hideinitializer */
+#define TEST_EXTI_PORT GPIOC               /*!< Port of the EXTI line under test @hideinitializer */
+#define TEST_EXTI_PIN 13U                  /*!< Pin of the EXTI line under test @hideinitializer */
+#define TEST_EXTI_ID 7U                    /*!< Identifier given to the callback of the EXTI line @hideinitializer */
+
+/* Private variables ---------------------------------------------------------*/
+static uint32_t exti_calls = 0;   /*!< Calls of the EXTI callback */
+static uint32_t exti_last_id = 0; /*!< Identifier received by the EXTI callback */
+
+/* Private functions ----------------------------------------------------------*/
+/**
+ * @brief Callback of the EXTI line under test
+ * @param id Identifier given when the callback was registered
+ */
+static void _test_exti_callback(uint32_t id)
+{
+    exti_calls++;
+    exti_last_id = id;
+}
+
+void setUp(void)
+{
+}
+
+void tearDown(void)
+{
+}
+
+void test_systick_time_base(void)
+{
+    uint32_t millis = port_system_get_millis();
+    uint32_t calls = fake_stm32f4_get_irq_count(SysTick_IRQn);
+
+    fake_stm32f4_advance_us(5000U);
+
+    UNITY_TEST_ASSERT_EQUAL_UINT32(millis + 5U, port_system_get_millis(), __LINE__, "ERROR: The SysTick ISR must run once per millisecond");
+    UNITY_TEST_ASSERT_EQUAL_UINT32(calls + 5U, fake_stm32f4_get_irq_count(SysTick_IRQn), __LINE__, "ERROR: The SysTick handler must be called once per millisecond");
+}
+
+void test_delay_sleeps_until_the_tick(void)
+{
+    uint64_t start = fake_stm32f4_get_cycles();
+    uint32_t millis = port_system_get_millis();
+
+    port_system_delay_ms(10U);
+
+    uint64_t elapsed_us = (fake_stm32f4_get_cycles() - start) / (FAKE_STM32F4_HCLK_HZ / 1000000U);
+    UNITY_TEST_ASSERT_EQUAL_UINT32(millis + 10U, port_system_get_millis(), __LINE__, "ERROR: The delay must return at the requested tick");
+    UNITY_TEST_ASSERT_INT_WITHIN(1000, 10000, (int32_t)elapsed_us, __LINE__, "ERROR: The delay must last the requested time of the virtual clock");
+}
+
+void test_sleep_with_interrupts_disabled(void)
+{
+    uint32_t millis = port_system_get_millis();
+    uint64_t start = fake_stm32f4_get_cycles();
+
+    port_system_disable_interrupts();
+    port_system_sleep();
+    uint64_t slept_us = (fake_stm32f4_get_cycles() - start) / (FAKE_STM32F4_HCLK_HZ / 1000000U);
+    UNITY_TEST_ASSERT_EQUAL_UINT32(millis, port_system_get_millis(), __LINE__, "ERROR: The SysTick ISR must not run while the interrupts are disabled");
+    UNITY_TEST_ASSERT(slept_us <= 1000U, __LINE__, "ERROR: A pending interrupt must wake up the CPU even if the interrupts are disabled");
+    port_system_enable_interrupts();
+
+    UNITY_TEST_ASSERT_EQUAL_UINT32(millis + 1U, port_system_get_millis(), __LINE__, "ERROR: The interrupt that woke up the CPU must run when the interrupts are enabled");
+}
+
+void test_echo_capture(void)
+{
+    port_ultrasound_init(TEST_PORT_REAR_PARKING_SENSOR_ID);
+    port_ultrasound_start_measurement(TEST_PORT_REAR_PARKING_SENSOR_ID);
+
+    fake_stm32f4_advance_us(TEST_ECHO_START_US);
+    UNITY_TEST_ASSERT(port_ultrasound_get_trigger_end(TEST_PORT_REAR_PARKING_SENSOR_ID), __LINE__, "ERROR: The TIM3 ISR must end the trigger signal after 10 us");
+    port_ultrasound_stop_trigger_timer(TEST_PORT_REAR_PARKING_SENSOR_ID);
+
+    fake_stm32f4_gpio_set_input(STM32F4_REAR_PARKING_SENSOR_ECHO_GPIO, STM32F4_REAR_PARKING_SENSOR_ECHO_PIN, true);
+    UNITY_TEST_ASSERT(!port_ultrasound_get_echo_received(TEST_PORT_REAR_PARKING_SENSOR_ID), __LINE__, "ERROR: The rising edge must not end the echo");
+    fake_stm32f4_advance_us(TEST_ECHO_WIDTH_US);
+    fake_stm32f4_gpio_set_input(STM32F4_REAR_PARKING_SENSOR_ECHO_GPIO, STM32F4_REAR_PARKING_SENSOR_ECHO_PIN, false);
+
+    uint32_t init_tick = port_ultrasound_get_echo_init_tick(TEST_PORT_REAR_PARKING_SENSOR_ID);
+    uint32_t end_tick = port_ultrasound_get_echo_end_tick(TEST_PORT_REAR_PARKING_SENSOR_ID);
+    UNITY_TEST_ASSERT(port_ultrasound_get_echo_received(TEST_PORT_REAR_PARKING_SENSOR_ID), __LINE__, "ERROR: The TIM2 ISR must receive the echo at the falling edge");
+    UNITY_TEST_ASSERT_INT_WITHIN(1, TEST_ECHO_WIDTH_US, (int32_t)(end_tick - init_tick), __LINE__, "ERROR: The captures of TIM2 must measure the width of the echo in microseconds");
+    UNITY_TEST_ASSERT_EQUAL_UINT32(0, TIM2->SR & TIM_SR_CC2IF, __LINE__, "ERROR: Reading the capture in the ISR must clear its flag");
+
+    port_ultrasound_stop_ultrasound(TEST_PORT_REAR_PARKING_SENSOR_ID);
+}
+
+void test_capture_flags(void)
+{
+    port_ultrasound_init(TEST_PORT_REAR_PARKING_SENSOR_ID); /* TIM2 channel 2 in input capture */
+    NVIC_DisableIRQ(TIM2_IRQn);                            /* The test plays the ISR */
+
+    TIM2->EGR = TIM_EGR_CC2G;
+    fake_stm32f4_sync();
+    UNITY_TEST_ASSERT_EQUAL_UINT32(TIM_SR_CC2IF, TIM2->SR & TIM_SR_CC2IF, __LINE__, "ERROR: A capture must set its flag");
+    TIM2->SR = TIM_SR_UIF | TIM_SR_CC2IF;
+    fake_stm32f4_sync();
+    UNITY_TEST_ASSERT_EQUAL_UINT32(TIM_SR_CC2IF, TIM2->SR & (TIM_SR_UIF | TIM_SR_CC2IF), __LINE__, "ERROR: Writing 1 to a bit of TIMx_SR must not change it");
+    TIM2->SR = ~TIM_SR_CC2IF;
+    fake_stm32f4_sync();
+    UNITY_TEST_ASSERT_EQUAL_UINT32(0, TIM2->SR & TIM_SR_CC2IF, __LINE__, "ERROR: Writing 0 to a bit of TIMx_SR must clear it");
+
+    TIM2->EGR = TIM_EGR_CC2G;
+    fake_stm32f4_sync();
+    uint32_t capture = TIM2->CCR2;
+    UNITY_TEST_ASSERT_EQUAL_UINT32(0, TIM2->SR & TIM_SR_CC2IF, __LINE__, "ERROR: Reading CCR2 must clear CC2IF at once, before the next synchronization point");
+    TIM2->EGR = TIM_EGR_CC2G;
+    fake_stm32f4_sync();
+    UNITY_TEST_ASSERT_EQUAL_UINT32(0, TIM2->SR & TIM_SR_CC2OF, __LINE__, "ERROR: A capture after reading the previous one must not be an overcapture");
+    UNITY_TEST_ASSERT_EQUAL_UINT32(capture, TIM2->CCR2, __LINE__, "ERROR: A stopped counter must be captured with the same value");
+
+    TIM2->SR = 0;
+    port_ultrasound_stop_ultrasound(TEST_PORT_REAR_PARKING_SENSOR_ID);
+}
+
+void test_exti_line(void)
+{
+    stm32f4_system_gpio_config(TEST_EXTI_PORT, TEST_EXTI_PIN, STM32F4_GPIO_MODE_IN, STM32F4_GPIO_PUPDR_NOPULL);
+    stm32f4_system_gpio_config_exti(TEST_EXTI_PORT, TEST_EXTI_PIN, STM32F4_TRIGGER_FALLING_EDGE | STM32F4_TRIGGER_ENABLE_INTERR_REQ, _test_exti_callback, TEST_EXTI_ID);
+    stm32f4_system_gpio_exti_enable(TEST_EXTI_PIN, 1, 0);
+    fake_stm32f4_gpio_set_input(TEST_EXTI_PORT, TEST_EXTI_PIN, true);
+    UNITY_TEST_ASSERT_EQUAL_UINT32(0, exti_calls, __LINE__, "ERROR: A rising edge must not raise a line configured for falling edges");
+
+    fake_stm32f4_gpio_set_input(TEST_EXTI_PORT, TEST_EXTI_PIN, false);
+    UNITY_TEST_ASSERT_EQUAL_UINT32(1, exti_calls, __LINE__, "ERROR: The falling edge must call the callback of the line once");
+    UNITY_TEST_ASSERT_EQUAL_UINT32(TEST_EXTI_ID, exti_last_id, __LINE__, "ERROR: The callback must receive the identifier of the line");
+    UNITY_TEST_ASSERT_EQUAL_UINT32(0, EXTI->PR & BIT_POS_TO_MASK(TEST_EXTI_PIN), __LINE__, "ERROR: The ISR must clear the pending bit of the line");
+
+    fake_stm32f4_advance_us(1000U);
+    UNITY_TEST_ASSERT_EQUAL_UINT32(1, exti_calls, __LINE__, "ERROR: A served line must not be served again");
+    stm32f4_system_gpio_exti_disable(TEST_EXTI_PIN);
+}
+
+void test_critical_section_masks_the_tick(void)
+{
+    uint32_t millis = port_system_get_millis();
+
+    port_system_enter_critical();
+    fake_stm32f4_advance_us(3000U);
+    UNITY_TEST_ASSERT_EQUAL_UINT32(millis, port_system_get_millis(), __LINE__, "ERROR: The critical section must mask the SysTick ISR");
+    port_system_exit_critical();
+
+    UNITY_TEST_ASSERT_EQUAL_UINT32(millis + 1U, port_system_get_millis(), __LINE__, "ERROR: The ticks masked by a critical section are served once when it ends");
+}
+
+void test_critical_section_restores_basepri(void)
+{
+    uint32_t basepri = (STM32F4_SYSTEM_CRITICAL_PRIO + 2U) << (8U - __NVIC_PRIO_BITS); /* A caller that already masks the lowest priorities */
+
+    __set_BASEPRI(basepri);
+    port_system_enter_critical();
+    port_system_enter_critical();
+    UNITY_TEST_ASSERT_EQUAL_UINT32(STM32F4_SYSTEM_CRITICAL_BASEPRI, __get_BASEPRI(), __LINE__, "ERROR: The critical section must raise the masking level");
+    port_system_exit_critical();
+    UNITY_TEST_ASSERT_EQUAL_UINT32(STM32F4_SYSTEM_CRITICAL_BASEPRI, __get_BASEPRI(), __LINE__, "ERROR: A nested exit must keep the masking level");
+    port_system_exit_critical();
+    UNITY_TEST_ASSERT_EQUAL_UINT32(basepri, __get_BASEPRI(), __LINE__, "ERROR: The outermost exit must restore the BASEPRI of the caller");
+
+    __set_BASEPRI(0U);
+}
+
+int main(void)
+{
+    port_system_init();
+    UNITY_BEGIN();
+    RUN_TEST(test_systick_time_base);
+    RUN_TEST(test_delay_sleeps_until_the_tick);
+    RUN_TEST(test_sleep_with_interrupts_disabled);
+    RUN_TEST(test_echo_capture);
+    RUN_TEST(test_capture_flags);
+    RUN_TEST(test_exti_line);
+    RUN_TEST(test_critical_section_masks_the_tick);
+    RUN_TEST(test_critical_section_restores_basepri);
+    exit(UNITY_END());
+}
@@ -0,0 +1,71 @@
+/**
+ * @file test_fake_stm32f4_isr_stats.c
+ * @brief Unit test of the ISRs of the STM32F4 instrumented with `PORT_ISR_STATS`, on the register model of the STM32F4.
+ *
+ * The statistics must not change what the ISRs do. The echo ISR is the delicate one: reading CCR2 clears CC2IF, so the capture register must only be read where the edge is handled, and its latency given from that value.
+ *
+ * @date 2025-01-01
+ */
+
+/* Includes ------------------------------------------------------------------*/
+/* HW independent libraries */
+#include <stdlib.h>
+#include <unity.h>
+
+/* HW dependent libraries */
+#include "port_system.h"
+#include "port_ultrasound.h"
+#include "port_isr_stats.h"
+#include "stm32f4_system.h"
+#include "stm32f4_ultrasound.h"
+#include "fake_stm32f4.h"
+
+/* Defines and enums ----------------------------------------------------------*/
+#define TEST_PORT_REAR_PARKING_SENSOR_ID 0 /*!< Ultrasound identifier @hideinitializer */
+#define TEST_ECHO_WIDTH_US 580U            /*!< Width of the echo: 10 cm @hideinitializer */
+
+void setUp(void)
+{
+    port_isr_stats_reset();
+}
+
+void tearDown(void)
+{
+}
+
+void test_echo_capture_with_stats(void)
+{
+    port_ultrasound_init(TEST_PORT_REAR_PARKING_SENSOR_ID);
+    port_ultrasound_start_measurement(TEST_PORT_REAR_PARKING_SENSOR_ID);
+    fake_stm32f4_advance_us(100U);
+    port_ultrasound_stop_trigger_timer(TEST_PORT_REAR_PARKING_SENSOR_ID);
+
+    fake_stm32f4_gpio_set_input(STM32F4_REAR_PARKING_SENSOR_ECHO_GPIO, STM32F4_REAR_PARKING_SENSOR_ECHO_PIN, true);
+    fake_stm32f4_advance_us(TEST_ECHO_WIDTH_US);
+    fake_stm32f4_gpio_set_input(STM32F4_REAR_PARKING_SENSOR_ECHO_GPIO, STM32F4_REAR_PARKING_SENSOR_ECHO_PIN, false);
+
+    UNITY_TEST_ASSERT(port_ultrasound_get_echo_received(TEST_PORT_REAR_PARKING_SENSOR_ID), __LINE__, "ERROR: The echo ISR must handle the captures when it is instrumented");
+    uint32_t width = port_ultrasound_get_echo_end_tick(TEST_PORT_REAR_PARKING_SENSOR_ID) - port_ultrasound_get_echo_init_tick(TEST_PORT_REAR_PARKING_SENSOR_ID);
+    UNITY_TEST_ASSERT_INT_WITHIN(1, TEST_ECHO_WIDTH_US, (int32_t)width, __LINE__, "ERROR: The instrumented echo ISR must measure the width of the echo");
+
+    volatile port_isr_stats_t *p_stats = &port_isr_stats_arr[PORT_ISR_ID_ECHO];
+    uint32_t tick_cycles = TIM2->PSC + 1U;
+    UNITY_TEST_ASSERT_EQUAL_UINT32(2, p_stats->calls, __LINE__, "ERROR: The echo ISR must be accounted once per edge");
+    UNITY_TEST_ASSERT(p_stats->max_latency_cycles <= 2U * tick_cycles, __LINE__, "ERROR: The latency of a capture must be measured from the captured tick");
+    uint32_t latencies = 0;
+    for (uint32_t bucket = 0; bucket < PORT_ISR_STATS_NUM_BUCKETS; bucket++)
+    {
+        latencies += p_stats->latency_hist_arr[bucket];
+    }
+    UNITY_TEST_ASSERT_EQUAL_UINT32(2, latencies, __LINE__, "ERROR: Every capture must give its latency");
+
+    port_ultrasound_stop_ultrasound(TEST_PORT_REAR_PARKING_SENSOR_ID);
+}
+
+int main(void)
+{
+    port_system_init();
+    UNITY_BEGIN();
+    RUN_TEST(test_echo_capture_with_stats);
+    exit(UNITY_END());
+}
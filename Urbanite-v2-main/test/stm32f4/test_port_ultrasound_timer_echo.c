@@ -11,6 +11,7 @@
 /* Includes ------------------------------------------------------------------*/
 /* HW independent libraries */
 #include <stdlib.h>
+#include <math.h>
 #include <unity.h>
 
 /* HW dependent libraries */
@@ -246,6 +247,42 @@ void test_echo_timer_precison()
     UNITY_TEST_ASSERT_EQUAL_UINT32(prev_tim_echo_cr1_masked, curr_tim_echo_cr1_masked, __LINE__, "ERROR: The register CR1 of the ULTRASOUND timer for echo signal has been modified and it should not have been");
 }
 
+/**
+ * @brief Test the capture of the edges of the echo signal in the ISR of the echo timer. The captures are generated by software with the EGR register, as the pin is an input.
+ *
+ */
+void test_echo_timer_edges(void)
+{
+    // Call configuration function to set the echo signal and start the echo timer
+    port_ultrasound_init(TEST_PORT_REAR_PARKING_SENSOR_ID);
+    REAR_ECHO_TIMER->CNT = 0;
+    REAR_ECHO_TIMER->CR1 |= TIM_CR1_CEN;
+    port_system_delay_ms(1); // The counter must not be 0 at the first capture
+
+    // Rising edge
+    REAR_ECHO_TIMER->EGR = TIM_EGR_CC2G;
+    port_system_delay_ms(1);
+    uint32_t echo_init_tick = port_ultrasound_get_echo_init_tick(TEST_PORT_REAR_PARKING_SENSOR_ID);
+    UNITY_TEST_ASSERT(echo_init_tick > 0, __LINE__, "ERROR: The ISR of the echo timer must store the capture of the rising edge in echo_init_tick");
+    bool echo_received = port_ultrasound_get_echo_received(TEST_PORT_REAR_PARKING_SENSOR_ID);
+    UNITY_TEST_ASSERT_EQUAL_UINT32(false, echo_received, __LINE__, "ERROR: The rising edge must not end the echo");
+
+    // Falling edge
+    REAR_ECHO_TIMER->EGR = TIM_EGR_CC2G;
+    port_system_delay_ms(1);
+    uint32_t echo_end_tick = port_ultrasound_get_echo_end_tick(TEST_PORT_REAR_PARKING_SENSOR_ID);
+    echo_received = port_ultrasound_get_echo_received(TEST_PORT_REAR_PARKING_SENSOR_ID);
+    UNITY_TEST_ASSERT_EQUAL_UINT32(true, echo_received, __LINE__, "ERROR: The ISR of the echo timer must end the echo at the falling edge");
+    UNITY_TEST_ASSERT(echo_end_tick > echo_init_tick, __LINE__, "ERROR: The ISR of the echo timer must store the capture of the falling edge in echo_end_tick");
+    UNITY_TEST_ASSERT_EQUAL_UINT32(echo_init_tick, port_ultrasound_get_echo_init_tick(TEST_PORT_REAR_PARKING_SENSOR_ID), __LINE__, "ERROR: The falling edge must not change echo_init_tick");
+
+    // Leave the echo timer stopped
+    REAR_ECHO_TIMER->CR1 &= ~TIM_CR1_CEN;
+    NVIC_DisableIRQ(REAR_ECHO_TIMER_IRQ);
+    port_ultrasound_reset_echo_ticks(TEST_PORT_REAR_PARKING_SENSOR_ID);
+    port_ultrasound_set_echo_received(TEST_PORT_REAR_PARKING_SENSOR_ID, false);
+}
+
 /**
  * @brief Test the generalization of the echo port driver. Particularly, test that the port driver functions work with the ultrasounds_arr array and not with the specific GPIOx peripheral.
  */
@@ -324,6 +361,7 @@ int main(void)
     RUN_TEST(test_echo_timer_config);
     RUN_TEST(test_echo_timer_priority);
     RUN_TEST(test_echo_timer_precison);
+    RUN_TEST(test_echo_timer_edges);
 
     // Test generalization of the port driver
     RUN_TEST(test_echo_port_generalization);
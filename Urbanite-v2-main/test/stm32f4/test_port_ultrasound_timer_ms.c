@@ -18,6 +18,7 @@
 #include "port_system.h"
 #include "stm32f4_system.h"
 #include "stm32f4_ultrasound.h"
+#include "port_timer.h"
 #include "stm32f4xx.h"
 
 /* Defines and enums ----------------------------------------------------------*/
@@ -31,7 +32,7 @@
 #define REAR_ECHO_TIMER TIM2                             /*!< Echo signal timer @hideinitializer */
 #define REAR_ECHO_TIMER_IRQ TIM2_IRQn                    /*!< Echo signal timer IRQ @hideinitializer */
 
-// Measurement timer configuration
+// Measurement timer configuration. TIM5 is the time base of the software timers
 #define MEASUREMENT_TIMER TIM5                            /*!< Ultrasound measurement timer @hideinitializer */
 #define MEASUREMENT_TIMER_PER_BUS RCC->APB1ENR            /*!< Ultrasound measurement timer peripheral bus @hideinitializer */
 #define MEASUREMENT_TIMER_PER_BUS_MASK RCC_APB1ENR_TIM5EN /*!< Ultrasound measurement timer peripheral bus mask @hideinitializer */
@@ -65,49 +66,31 @@ void test_identifiers(void)
 /**
  * @brief Test the configuration of the timer that controls the measurement time of the ultrasound sensor.
  *
+ * The measurement time is a software timer of `port_timer.h`. TIM5 is the time base of all the software timers: it runs freely at 1 MHz over its 32 bits and only raises the compare-match interrupt of channel 1.
  */
 void test_meas_timer_config(void)
 {
-    // Retrieve previous configuration
-    uint32_t prev_tim_meas_cr1 = MEASUREMENT_TIMER->CR1;
-    uint32_t prev_tim_meas_dier = MEASUREMENT_TIMER->DIER;
-    uint32_t prev_tim_meas_sr = MEASUREMENT_TIMER->SR;
-
     // Call configuration function
     port_ultrasound_init(TEST_PORT_REAR_PARKING_SENSOR_ID);
 
-    // Check that the ULTRASOUND timer for measurement is enabled in RCC
+    // Check that the time base of the software timers is enabled in RCC
     uint32_t tim_meas_rcc = (MEASUREMENT_TIMER_PER_BUS)&MEASUREMENT_TIMER_PER_BUS_MASK;
-    UNITY_TEST_ASSERT_EQUAL_UINT32(MEASUREMENT_TIMER_PER_BUS_MASK, tim_meas_rcc, __LINE__, "ERROR: ULTRASOUND timer for measurement is not enabled in RCC");
+    UNITY_TEST_ASSERT_EQUAL_UINT32(MEASUREMENT_TIMER_PER_BUS_MASK, tim_meas_rcc, __LINE__, "ERROR: The time base of the software timers is not enabled in RCC");
 
-    // Check that the ULTRASOUND timer for measurement is disabled
+    // Check that the time base of the software timers is running
     uint32_t tim_meas_en = (MEASUREMENT_TIMER->CR1) & TIM_CR1_CEN_Msk;
-    UNITY_TEST_ASSERT_EQUAL_UINT32(0, tim_meas_en, __LINE__, "ERROR: ULTRASOUND timer for measurement must be disabled after configuration");
-
-    // Check that the ULTRASOUND timer for measurement is configured with auto-reload preload enabled
-    uint32_t tim_meas_arpe = (MEASUREMENT_TIMER->CR1) & TIM_CR1_ARPE_Msk;
-    UNITY_TEST_ASSERT_EQUAL_UINT32(TIM_CR1_ARPE_Msk, tim_meas_arpe, __LINE__, "ERROR: ULTRASOUND timer for measurement must be configured with auto-reload preload enabled");
+    UNITY_TEST_ASSERT_EQUAL_UINT32(TIM_CR1_CEN_Msk, tim_meas_en, __LINE__, "ERROR: The time base of the software timers must be running after the system initialization");
 
-    // Check that the ULTRASOUND timer for measurement has cleared the update interrupt
-    uint32_t tim_meas_sr = (MEASUREMENT_TIMER->SR) & TIM_SR_UIF_Msk;
-    UNITY_TEST_ASSERT_EQUAL_UINT32(0, tim_meas_sr, __LINE__, "ERROR: ULTRASOUND timer for measurement must have cleared the update interrupt");
+    // Check that the time base of the software timers counts over the 32 bits
+    UNITY_TEST_ASSERT_EQUAL_UINT32(0xFFFFFFFFU, MEASUREMENT_TIMER->ARR, __LINE__, "ERROR: The time base of the software timers must count over the 32 bits");
 
-    // Check that the ULTRASOUND timer for measurement has cleared the interrupt
+    // Check that only the compare-match interrupt is used
     uint32_t tim_meas_dier = (MEASUREMENT_TIMER->DIER) & TIM_DIER_UIE_Msk;
-    UNITY_TEST_ASSERT_EQUAL_UINT32(TIM_DIER_UIE_Msk, tim_meas_dier, __LINE__, "ERROR: ULTRASOUND timer for measurement must have enabled the interrupt");
-
-    // Check that no other bits other than the needed have been modified:
-    uint32_t prev_tim_meas_cr1_masked = prev_tim_meas_cr1 & ~(TIM_CR1_ARPE_Msk | TIM_CR1_CEN_Msk);
-    uint32_t prev_tim_meas_dier_masked = prev_tim_meas_dier & ~TIM_DIER_UIE_Msk;
-    uint32_t prev_tim_meas_sr_masked = prev_tim_meas_sr & ~TIM_SR_UIF_Msk;
+    UNITY_TEST_ASSERT_EQUAL_UINT32(0, tim_meas_dier, __LINE__, "ERROR: The time base of the software timers must not enable the update interrupt");
 
-    uint32_t curr_tim_meas_cr1_masked = MEASUREMENT_TIMER->CR1 & ~(TIM_CR1_ARPE_Msk | TIM_CR1_CEN_Msk);
-    uint32_t curr_tim_meas_dier_masked = MEASUREMENT_TIMER->DIER & ~TIM_DIER_UIE_Msk;
-    uint32_t curr_tim_meas_sr_masked = MEASUREMENT_TIMER->SR & ~TIM_SR_UIF_Msk;
-
-    UNITY_TEST_ASSERT_EQUAL_UINT32(prev_tim_meas_cr1_masked, curr_tim_meas_cr1_masked, __LINE__, "ERROR: The register CR1 of the ULTRASOUND timer for measurement has been modified for other bits than the needed");
-    UNITY_TEST_ASSERT_EQUAL_UINT32(prev_tim_meas_dier_masked, curr_tim_meas_dier_masked, __LINE__, "ERROR: The register DIER of the ULTRASOUND timer for measurement has been modified for other bits than the needed");
-    UNITY_TEST_ASSERT_EQUAL_UINT32(prev_tim_meas_sr_masked, curr_tim_meas_sr_masked, __LINE__, "ERROR: The register SR of the ULTRASOUND timer for measurement has been modified for other bits than the needed");
+    // Check that the configuration does not start the measurement timer
+    bool running = port_ultrasound_get_measurement_timer_running(TEST_PORT_REAR_PARKING_SENSOR_ID);
+    UNITY_TEST_ASSERT_EQUAL_UINT32(false, running, __LINE__, "ERROR: ULTRASOUND timer for measurements should not be running after setting the configuration");
 }
 
 /**
@@ -128,53 +111,45 @@ void test_meas_timer_priority(void)
 }
 
 /**
- * @brief Test the configuration of the ULTRASOUND measurement timer
+ * @brief Test the resolution of the time base of the software timers
  *
  */
 void test_meas_timer_duration()
 {
-    uint32_t prev_tim_meas_cr1 = MEASUREMENT_TIMER->CR1;
-
     // Call configuration function to set the measurement
     port_ultrasound_init(TEST_PORT_REAR_PARKING_SENSOR_ID);
 
-    // Disable ULTRASOUND measurement interrupts to avoid any interference
-    NVIC_DisableIRQ(MEASUREMENT_TIMER_IRQ);
-
-    // Check the computation of the ARR and PSC for the ULTRASOUND measurement
-    uint32_t ms_test = 100;
-    uint32_t arr = MEASUREMENT_TIMER->ARR;
+    // Check that the time base counts microseconds
     uint32_t psc = MEASUREMENT_TIMER->PSC;
-    uint32_t tim_meas_dur_ms = round((((double)(arr) + 1.0) / ((double)SystemCoreClock / 1000.0)) * ((double)(psc) + 1));
-    sprintf(msg, "ERROR: ULTRASOUND timer for measurement ARR and PSC are not configured correctly for a duration of %ld ms", ms_test);
-    UNITY_TEST_ASSERT_INT_WITHIN(1, ms_test, tim_meas_dur_ms, __LINE__, msg);
-
-    // Check that the ULTRASOUND timer for measurement is enabled
-    uint32_t tim_meas_en = (MEASUREMENT_TIMER->CR1) & TIM_CR1_CEN_Msk;
-    UNITY_TEST_ASSERT_EQUAL_UINT32(false, tim_meas_en, __LINE__, "ERROR: ULTRASOUND timer for measurements should not be enabled after setting the configuration");
+    uint32_t tick_freq = SystemCoreClock / (psc + 1U);
+    sprintf(msg, "ERROR: The PSC of the time base of the software timers is not configured for 1 MHz (%ld Hz)", tick_freq);
+    UNITY_TEST_ASSERT_EQUAL_UINT32(1000000U, tick_freq, __LINE__, msg);
 
-    // Check that no other bits other than the needed have been modified:
-    uint32_t prev_tim_meas_cr1_masked = prev_tim_meas_cr1 & ~TIM_CR1_CEN_Msk;
-    uint32_t curr_tim_meas_cr1_masked = MEASUREMENT_TIMER->CR1 & ~TIM_CR1_CEN_Msk;
-    UNITY_TEST_ASSERT_EQUAL_UINT32(prev_tim_meas_cr1_masked, curr_tim_meas_cr1_masked, __LINE__, "ERROR: The register CR1 of the ULTRASOUND timer for measurement has been modified for other bits than the needed");
+    // Check that the software timers see the same time as the System tick
+    uint32_t ms_test = 100;
+    uint32_t start_us = port_timer_get_micros();
+    port_system_delay_ms(ms_test);
+    uint32_t elapsed_us = port_timer_get_micros() - start_us;
+    sprintf(msg, "ERROR: The time base of the software timers counted %ld us in %ld ms", elapsed_us, ms_test);
+    UNITY_TEST_ASSERT_INT_WITHIN(1000, ms_test * 1000U, elapsed_us, __LINE__, msg);
 }
 
 void test_meas_timer_timeout(void)
 {
     // Call configuration function to set the measurement
     port_ultrasound_init(TEST_PORT_REAR_PARKING_SENSOR_ID);
+    port_ultrasound_set_trigger_ready(TEST_PORT_REAR_PARKING_SENSOR_ID, false);
 
-    // Enable ULTRASOUND measurement interrupts to test the timeout
-    NVIC_EnableIRQ(MEASUREMENT_TIMER_IRQ);
-
-    // Enable the timer
-    MEASUREMENT_TIMER->CR1 |= TIM_CR1_CEN;
+    // Start the measurement timer
+    port_ultrasound_start_new_measurement_timer();
+    UNITY_TEST_ASSERT_EQUAL_UINT32(true, port_ultrasound_get_measurement_timer_running(TEST_PORT_REAR_PARKING_SENSOR_ID), __LINE__, "ERROR: ULTRASOUND timer for measurements must be running after starting it");
 
     // Wait for the timeout
     port_system_delay_ms(101); // Wait a time higher than the measurement duration
 
-    // Disable ULTRASOUND measurement interrupts to avoid any interference
-    NVIC_DisableIRQ(MEASUREMENT_TIMER_IRQ);
+    // Stop the timer to avoid any interference
+    port_ultrasound_stop_new_measurement_timer();
+    UNITY_TEST_ASSERT_EQUAL_UINT32(false, port_ultrasound_get_measurement_timer_running(TEST_PORT_REAR_PARKING_SENSOR_ID), __LINE__, "ERROR: ULTRASOUND timer for measurements must not be running after stopping it");
 
     // Check that the meas_end flag is set
     bool trigger_ready = port_ultrasound_get_trigger_ready(TEST_PORT_REAR_PARKING_SENSOR_ID);
@@ -193,11 +168,12 @@ void test_start_measurement(void)
     uint32_t tim_trigger_irq = NVIC->ISER[REAR_TRIGGER_TIMER_IRQ / 32] & (1 << (REAR_TRIGGER_TIMER_IRQ % 32));
     uint32_t tim_echo_irq = NVIC->ISER[REAR_ECHO_TIMER_IRQ / 32] & (1 << (REAR_ECHO_TIMER_IRQ % 32));
     uint32_t tim_meas_irq = NVIC->ISER[MEASUREMENT_TIMER_IRQ / 32] & (1 << (MEASUREMENT_TIMER_IRQ % 32));
+    bool meas_running = port_ultrasound_get_measurement_timer_running(TEST_PORT_REAR_PARKING_SENSOR_ID);
 
-    // Disable all interrupts to avoid any interference
+    // Disable all interrupts to avoid any interference. The time base of the software timers is shared, so the measurement timer is stopped instead
     NVIC_DisableIRQ(REAR_TRIGGER_TIMER_IRQ);
     NVIC_DisableIRQ(REAR_ECHO_TIMER_IRQ);
-    NVIC_DisableIRQ(MEASUREMENT_TIMER_IRQ);
+    port_ultrasound_stop_new_measurement_timer();
 
     // Check that the trigger pin has been set to high
     uint32_t trigger_pin = STM32F4_REAR_PARKING_SENSOR_TRIGGER_GPIO->ODR & (1 << STM32F4_REAR_PARKING_SENSOR_TRIGGER_PIN);
@@ -209,7 +185,7 @@ void test_start_measurement(void)
 
     UNITY_TEST_ASSERT_EQUAL_UINT32(1 << (REAR_ECHO_TIMER_IRQ % 32), tim_echo_irq, __LINE__, "ERROR: The NVIC interrupt for the ULTRASOUND echo timer has not been enabled");
 
-    UNITY_TEST_ASSERT_EQUAL_UINT32(1 << (MEASUREMENT_TIMER_IRQ % 32), tim_meas_irq, __LINE__, "ERROR: The NVIC interrupt for the ULTRASOUND measurement timer has not been enabled");
+    UNITY_TEST_ASSERT_EQUAL_UINT32(1 << (MEASUREMENT_TIMER_IRQ % 32), tim_meas_irq, __LINE__, "ERROR: The NVIC interrupt for the time base of the software timers has not been enabled");
 
     // Check that all the timers have been enabled
     uint32_t tim_trigger_en = (REAR_TRIGGER_TIMER->CR1) & TIM_CR1_CEN_Msk;
@@ -218,8 +194,7 @@ void test_start_measurement(void)
     uint32_t tim_echo_en = (REAR_ECHO_TIMER->CR1) & TIM_CR1_CEN_Msk;
     UNITY_TEST_ASSERT_EQUAL_UINT32(TIM_CR1_CEN_Msk, tim_echo_en, __LINE__, "ERROR: The ULTRASOUND echo timer has not been enabled");
 
-    uint32_t tim_meas_en = (MEASUREMENT_TIMER->CR1) & TIM_CR1_CEN_Msk;
-    UNITY_TEST_ASSERT_EQUAL_UINT32(TIM_CR1_CEN_Msk, tim_meas_en, __LINE__, "ERROR: The ULTRASOUND measurement timer has not been enabled");
+    UNITY_TEST_ASSERT_EQUAL_UINT32(true, meas_running, __LINE__, "ERROR: The ULTRASOUND measurement timer has not been started");
 }
 
 int main(void)
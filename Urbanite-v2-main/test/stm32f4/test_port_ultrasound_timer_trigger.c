@@ -11,6 +11,7 @@
 /* Includes ------------------------------------------------------------------*/
 /* HW independent libraries */
 #include <stdlib.h>
+#include <math.h>
 #include <unity.h>
 
 /* HW dependent libraries */
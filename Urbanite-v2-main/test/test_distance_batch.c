@@ -0,0 +1,211 @@
+/**
+ * @file test_distance_batch.c
+ * @brief Unit test for the batch filter of the distances of several ultrasound sensors.
+ *
+ * The filter of the platform (packed instructions in the Cortex-M4, SSE2 in the host) must give the same results as the scalar filter and as the median of `do_set_distance()`.
+ *
+ * @date 2025-01-01
+ */
+/* System dependent libraries */
+#include <stdlib.h>
+#include <string.h>
+#include <unity.h>
+
+/* HW independent libraries */
+#include "port_system.h"
+
+/* Include project libraries */
+#include "distance_batch.h"
+
+/* Defines and enums ----------------------------------------------------------*/
+#define TEST_NUM_BATCHES 200U /*!< Pseudo-random batches compared between the filters @hideinitializer */
+
+/* Global variables ----------------------------------------------------------*/
+static distance_batch_t batch;          /*!< Batch under test */
+static distance_batch_result_t result;  /*!< Results of the filter of the platform */
+static distance_batch_result_t reference; /*!< Results of the scalar filter */
+static uint32_t seed = 1;               /*!< State of the pseudo-random generator */
+
+/* Private functions ---------------------------------------------------------*/
+/**
+ * @brief Next pseudo-random distance, with the extremes of the range more often than the rest
+ * @return Distance in cm
+ */
+static uint32_t _next_distance(void)
+{
+    seed = seed * 1103515245U + 12345U;
+    uint32_t r = seed >> 8;
+    switch (r % 8U)
+    {
+    case 0:
+        return 0;
+    case 1:
+        return UINT16_MAX;
+    case 2:
+        return 0x8000U + (r % 3U) - 1U; /* Around the bias of the signed comparisons */
+    default:
+        return (r >> 3) % 500U;
+    }
+}
+
+/**
+ * @brief Median of a window as `do_set_distance()` computes it
+ * @param sensor Lane of the window in the batch
+ * @return Median in cm
+ */
+static uint32_t _reference_median(uint32_t sensor)
+{
+    uint32_t values_arr[DISTANCE_BATCH_NUM_MEASUREMENTS];
+    for (uint32_t k = 0; k < DISTANCE_BATCH_NUM_MEASUREMENTS; k++)
+    {
+        values_arr[k] = batch.window_arr[k][sensor];
+    }
+    for (uint32_t i = 1; i < DISTANCE_BATCH_NUM_MEASUREMENTS; i++)
+    {
+        for (uint32_t j = i; (j > 0) && (values_arr[j - 1] > values_arr[j]); j--)
+        {
+            uint32_t tmp = values_arr[j];
+            values_arr[j] = values_arr[j - 1];
+            values_arr[j - 1] = tmp;
+        }
+    }
+    if (DISTANCE_BATCH_NUM_MEASUREMENTS % 2 == 1)
+    {
+        return values_arr[DISTANCE_BATCH_NUM_MEASUREMENTS / 2];
+    }
+    return (values_arr[DISTANCE_BATCH_NUM_MEASUREMENTS / 2 - 1] + values_arr[DISTANCE_BATCH_NUM_MEASUREMENTS / 2]) / 2;
+}
+
+void setUp(void)
+{
+    memset(&batch, 0, sizeof(batch));
+    memset(&result, 0, sizeof(result));
+    memset(&reference, 0, sizeof(reference));
+}
+
+void tearDown(void)
+{
+}
+
+/**
+ * @brief Test the minimum, maximum and median of known windows, each sensor with a different order of the measurements
+ */
+void test_known_windows(void)
+{
+    for (uint32_t sensor = 0; sensor < DISTANCE_BATCH_MAX_SENSORS; sensor++)
+    {
+        for (uint32_t k = 0; k < DISTANCE_BATCH_NUM_MEASUREMENTS; k++)
+        {
+            uint32_t position = (k + sensor) % DISTANCE_BATCH_NUM_MEASUREMENTS;
+            distance_batch_set(&batch, sensor, position, 100U * (sensor + 1U) + 10U * k);
+        }
+    }
+    distance_batch_filter(&batch, DISTANCE_BATCH_MAX_SENSORS, &result);
+
+    for (uint32_t sensor = 0; sensor < DISTANCE_BATCH_MAX_SENSORS; sensor++)
+    {
+        UNITY_TEST_ASSERT_EQUAL_UINT32(100U * (sensor + 1U), result.min_arr[sensor], __LINE__, "The minimum of a window is not correct");
+        UNITY_TEST_ASSERT_EQUAL_UINT32(100U * (sensor + 1U) + 10U * (DISTANCE_BATCH_NUM_MEASUREMENTS - 1U), result.max_arr[sensor], __LINE__, "The maximum of a window is not correct");
+        UNITY_TEST_ASSERT_EQUAL_UINT32(_reference_median(sensor), result.median_arr[sensor], __LINE__, "The median of a window is not the one of the ultrasound FSM");
+    }
+}
+
+/**
+ * @brief Test that a distance above the range of 16 bits is saturated
+ */
+void test_set_saturates(void)
+{
+    distance_batch_set(&batch, 3, 0, 70000);
+    UNITY_TEST_ASSERT_EQUAL_UINT32(UINT16_MAX, batch.window_arr[0][3], __LINE__, "A distance above 16 bits is not saturated");
+
+    distance_batch_set(&batch, DISTANCE_BATCH_MAX_SENSORS, 0, 1);
+    distance_batch_set(&batch, 0, DISTANCE_BATCH_NUM_MEASUREMENTS, 1);
+    for (uint32_t k = 0; k < DISTANCE_BATCH_NUM_MEASUREMENTS; k++)
+    {
+        UNITY_TEST_ASSERT_EQUAL_UINT32(0, batch.window_arr[k][0], __LINE__, "A measurement out of the batch is stored");
+    }
+}
+
+/**
+ * @brief Test that the filter of the platform gives the same results as the scalar filter and the median of the FSM for pseudo-random windows, including the extremes of the range
+ */
+void test_same_as_scalar(void)
+{
+    for (uint32_t n = 0; n < TEST_NUM_BATCHES; n++)
+    {
+        for (uint32_t sensor = 0; sensor < DISTANCE_BATCH_MAX_SENSORS; sensor++)
+        {
+            for (uint32_t k = 0; k < DISTANCE_BATCH_NUM_MEASUREMENTS; k++)
+            {
+                distance_batch_set(&batch, sensor, k, _next_distance());
+            }
+        }
+        distance_batch_filter(&batch, DISTANCE_BATCH_MAX_SENSORS, &result);
+        distance_batch_filter_scalar(&batch, DISTANCE_BATCH_MAX_SENSORS, &reference);
+
+        UNITY_TEST_ASSERT(memcmp(&result, &reference, sizeof(result)) == 0, __LINE__, "The filter of the platform and the scalar filter differ");
+        for (uint32_t sensor = 0; sensor < DISTANCE_BATCH_MAX_SENSORS; sensor++)
+        {
+            UNITY_TEST_ASSERT_EQUAL_UINT32(_reference_median(sensor), reference.median_arr[sensor], __LINE__, "The median of a window is not the one of the ultrasound FSM");
+        }
+    }
+}
+
+/**
+ * @brief Test that the scalar filter only writes the lanes of the sensors it is asked for
+ */
+void test_scalar_num_sensors(void)
+{
+    memset(&reference, 0xA5, sizeof(reference));
+    for (uint32_t k = 0; k < DISTANCE_BATCH_NUM_MEASUREMENTS; k++)
+    {
+        distance_batch_set(&batch, 0, k, 50);
+        distance_batch_set(&batch, 1, k, 60);
+    }
+    distance_batch_filter_scalar(&batch, 1, &reference);
+
+    UNITY_TEST_ASSERT_EQUAL_UINT32(50, reference.median_arr[0], __LINE__, "The median of the first sensor is not correct");
+    UNITY_TEST_ASSERT_EQUAL_UINT32(0xA5A5, reference.median_arr[1], __LINE__, "The scalar filter writes a lane that was not asked for");
+}
+
+/**
+ * @brief Test that the filter of one sensor gives the results of the scalar filter in its lane and does not write the other lanes
+ */
+void test_lane(void)
+{
+    for (uint32_t sensor = 0; sensor < DISTANCE_BATCH_MAX_SENSORS; sensor++)
+    {
+        for (uint32_t k = 0; k < DISTANCE_BATCH_NUM_MEASUREMENTS; k++)
+        {
+            distance_batch_set(&batch, sensor, k, _next_distance());
+        }
+    }
+    distance_batch_filter_scalar(&batch, DISTANCE_BATCH_MAX_SENSORS, &reference);
+
+    for (uint32_t sensor = 0; sensor < DISTANCE_BATCH_MAX_SENSORS; sensor++)
+    {
+        memset(&result, 0xA5, sizeof(result));
+        distance_batch_filter_lane(&batch, sensor, &result);
+        for (uint32_t lane = 0; lane < DISTANCE_BATCH_MAX_SENSORS; lane++)
+        {
+            uint32_t median = (lane == sensor) ? reference.median_arr[lane] : 0xA5A5;
+            UNITY_TEST_ASSERT_EQUAL_UINT32(median, result.median_arr[lane], __LINE__, "The filter of one sensor must only write its lane, with the median of the scalar filter");
+        }
+        UNITY_TEST_ASSERT_EQUAL_UINT32(reference.min_arr[sensor], result.min_arr[sensor], __LINE__, "The minimum of the filter of one sensor is not correct");
+        UNITY_TEST_ASSERT_EQUAL_UINT32(reference.max_arr[sensor], result.max_arr[sensor], __LINE__, "The maximum of the filter of one sensor is not correct");
+    }
+}
+
+int main(void)
+{
+    port_system_init();
+    UNITY_BEGIN();
+
+    RUN_TEST(test_known_windows);
+    RUN_TEST(test_set_saturates);
+    RUN_TEST(test_same_as_scalar);
+    RUN_TEST(test_scalar_num_sensors);
+    RUN_TEST(test_lane);
+
+    exit(UNITY_END());
+}
@@ -0,0 +1,315 @@
+/**
+ * @file test_distance_pipeline.c
+ * @brief Unit test for the distance pipeline of the ultrasound sensors.
+ *
+ * The default pipeline must give the medians of `do_set_distance()`. A pipeline of test stages checks that the stages run in the order of the list, that a dropped record does not reach the next stages, and that the lanes are independent. The outlier stage must drop the impossible jumps only and attach a confidence that falls with the spread of the distances.
+ *
+ * @date 2025-01-01
+ */
+/* System dependent libraries */
+#include <stdlib.h>
+#include <string.h>
+#include <unity.h>
+
+/* HW independent libraries */
+#include "port_system.h"
+
+/* Include project libraries */
+#include "distance_pipeline.h"
+
+/* Test stages -----------------------------------------------------------------*/
+/**
+ * @brief State of the test stage that drops every other record of a sensor
+ */
+typedef struct
+{
+    uint8_t count_arr[DISTANCE_PIPELINE_LANES]; /*!< Records received from every sensor */
+} distance_stage_decimate_t;
+
+/**
+ * @brief State of the test stage that adds the number of the records that got to it
+ */
+typedef struct
+{
+    uint16_t count_arr[DISTANCE_PIPELINE_LANES]; /*!< Records received from every sensor */
+} distance_stage_count_t;
+
+/**
+ * @brief Reset the count of a sensor of the decimate stage
+ */
+static inline void distance_stage_decimate_reset(distance_stage_decimate_t *p_state, uint32_t lane)
+{
+    p_state->count_arr[lane] = 0;
+}
+
+/**
+ * @brief Decimate stage: drop the first record of a sensor, keep the second one, and so on
+ */
+static inline bool distance_stage_decimate_process(distance_stage_decimate_t *p_state, uint32_t lane, distance_record_t *p_record)
+{
+    return (p_state->count_arr[lane]++ % 2U) == 1U;
+}
+
+/**
+ * @brief Reset the count of a sensor of the count stage
+ */
+static inline void distance_stage_count_reset(distance_stage_count_t *p_state, uint32_t lane)
+{
+    p_state->count_arr[lane] = 0;
+}
+
+/**
+ * @brief Count stage: add 1000 cm times the number of records of the sensor, so the test sees which stages the record went through
+ */
+static inline bool distance_stage_count_process(distance_stage_count_t *p_state, uint32_t lane, distance_record_t *p_record)
+{
+    p_record->distance_cm = (uint16_t)(p_record->distance_cm + 1000U * ++p_state->count_arr[lane]);
+    return true;
+}
+
+/* Defines and enums ----------------------------------------------------------*/
+#define TEST_PIPELINE_STAGES(STAGE) STAGE(decimate) STAGE(median) STAGE(count) /*!< Stages of the test pipeline @hideinitializer */
+#define TEST_OUTLIER_STAGES(STAGE) STAGE(outlier)                               /*!< Stages of the pipeline of the outlier stage alone @hideinitializer */
+#define TEST_PERIOD_MS 100U                                                     /*!< Time between two distances of the outlier tests @hideinitializer */
+
+DISTANCE_PIPELINE_DEFINE(test_pipeline, TEST_PIPELINE_STAGES)
+DISTANCE_PIPELINE_DEFINE(outlier_pipeline, TEST_OUTLIER_STAGES)
+
+/* Global variables ----------------------------------------------------------*/
+static distance_pipeline_t pipeline;   /*!< Default pipeline under test */
+static test_pipeline_t test_pipeline; /*!< Pipeline of test stages under test */
+static outlier_pipeline_t outlier_pipeline; /*!< Pipeline of the outlier stage under test */
+static uint32_t time_ms;                   /*!< System time of the next distance of the outlier tests */
+
+/* Private functions ---------------------------------------------------------*/
+/**
+ * @brief Record of a new measurement, as the ultrasound FSM pushes it
+ * @param distance_cm Distance in cm
+ * @return Record of the measurement
+ */
+static distance_record_t _test_record(uint16_t distance_cm)
+{
+    distance_record_t record = {.raw_distance_cm = distance_cm, .distance_cm = distance_cm, .time_ms = time_ms, .confidence = DISTANCE_RECORD_CONFIDENCE_MAX};
+    return record;
+}
+
+/**
+ * @brief Push a distance through the outlier stage, `TEST_PERIOD_MS` after the previous one
+ * @param distance_cm Distance in cm
+ * @param p_record Pointer to store the record out of the stage
+ * @return true if the distance is taken
+ */
+static bool _test_push_outlier(uint16_t distance_cm, distance_record_t *p_record)
+{
+    time_ms += TEST_PERIOD_MS;
+    *p_record = _test_record(distance_cm);
+    return outlier_pipeline_push(&outlier_pipeline, 0, p_record);
+}
+
+void setUp(void)
+{
+    memset(&pipeline, 0xA5, sizeof(pipeline)); /* The reset must not depend on the initial contents */
+    memset(&test_pipeline, 0xA5, sizeof(test_pipeline));
+    memset(&outlier_pipeline, 0xA5, sizeof(outlier_pipeline));
+    time_ms = 0;
+    for (uint32_t lane = 0; lane < DISTANCE_PIPELINE_LANES; lane++)
+    {
+        distance_pipeline_reset(&pipeline, lane);
+        test_pipeline_reset(&test_pipeline, lane);
+        outlier_pipeline_reset(&outlier_pipeline, lane);
+    }
+}
+
+void tearDown(void)
+{
+}
+
+/* Tests ---------------------------------------------------------------------*/
+/**
+ * @brief Test that the default pipeline reports the median of every full window, and nothing in between
+ */
+void test_default_median(void)
+{
+    static const uint16_t distance_arr[FSM_ULTRASOUND_NUM_MEASUREMENTS] = {40, 10, 50, 20, 30};
+    distance_record_t record;
+    for (uint32_t n = 0; n < 2U; n++)
+    {
+        for (uint32_t k = 0; k < FSM_ULTRASOUND_NUM_MEASUREMENTS; k++)
+        {
+            record = _test_record(distance_arr[k] + n);
+            bool accepted = distance_pipeline_push(&pipeline, 3, &record);
+            UNITY_TEST_ASSERT_EQUAL_UINT32(k == FSM_ULTRASOUND_NUM_MEASUREMENTS - 1U, accepted, __LINE__, "The pipeline must only report a distance when the window is full");
+            UNITY_TEST_ASSERT_EQUAL_UINT32(distance_arr[k] + n, record.raw_distance_cm, __LINE__, "The stages must not change the raw distance");
+        }
+        UNITY_TEST_ASSERT_EQUAL_UINT32(30U + n, record.distance_cm, __LINE__, "The distance out of the pipeline is not the median of the window");
+    }
+}
+
+/**
+ * @brief Test that the median stage lowers the confidence with the spread of the window
+ */
+void test_median_confidence(void)
+{
+    static const uint16_t steady_arr[FSM_ULTRASOUND_NUM_MEASUREMENTS] = {100, 103, 98, 101, 100};
+    static const uint16_t noisy_arr[FSM_ULTRASOUND_NUM_MEASUREMENTS] = {100, 110, 100, 100, 100};
+    static const uint16_t rain_arr[FSM_ULTRASOUND_NUM_MEASUREMENTS] = {100, 40, 160, 95, 30};
+    distance_record_t record;
+    for (uint32_t k = 0; k < FSM_ULTRASOUND_NUM_MEASUREMENTS; k++)
+    {
+        record = _test_record(steady_arr[k]);
+        distance_pipeline_push(&pipeline, 0, &record);
+    }
+    UNITY_TEST_ASSERT_EQUAL_UINT32(DISTANCE_RECORD_CONFIDENCE_MAX, record.confidence, __LINE__, "A window spread within the margin must keep the full confidence");
+
+    for (uint32_t k = 0; k < FSM_ULTRASOUND_NUM_MEASUREMENTS; k++)
+    {
+        record = _test_record(noisy_arr[k]);
+        distance_pipeline_push(&pipeline, 0, &record);
+    }
+    uint32_t spread_cm = 110U - 100U;
+    uint32_t expected = (DISTANCE_RECORD_CONFIDENCE_MAX * DISTANCE_STAGE_MEDIAN_CONFIDENCE_CM) / (DISTANCE_STAGE_MEDIAN_CONFIDENCE_CM + spread_cm - DISTANCE_STAGE_MEDIAN_SPREAD_MARGIN_CM);
+    UNITY_TEST_ASSERT_EQUAL_UINT32(100, record.distance_cm, __LINE__, "The median must reject the outlier of the window");
+    UNITY_TEST_ASSERT_EQUAL_UINT32(expected, record.confidence, __LINE__, "The confidence must fall with the spread of the window beyond the margin");
+    uint32_t noisy_confidence = record.confidence;
+
+    for (uint32_t k = 0; k < FSM_ULTRASOUND_NUM_MEASUREMENTS; k++)
+    {
+        record = _test_record(rain_arr[k]);
+        distance_pipeline_push(&pipeline, 0, &record);
+    }
+    UNITY_TEST_ASSERT(record.confidence < noisy_confidence, __LINE__, "A more spread window must have a lower confidence");
+    UNITY_TEST_ASSERT(record.confidence > 0, __LINE__, "A noisy median must not have zero confidence");
+}
+
+/**
+ * @brief Test that the stages run in order and that a dropped record does not reach the next stages
+ */
+void test_stage_order(void)
+{
+    distance_record_t record;
+    uint32_t accepted = 0;
+    for (uint32_t k = 0; k < 4U * FSM_ULTRASOUND_NUM_MEASUREMENTS; k++)
+    {
+        record = _test_record(100);
+        if (test_pipeline_push(&test_pipeline, 0, &record))
+        {
+            accepted++;
+            UNITY_TEST_ASSERT_EQUAL_UINT32(100U + 1000U * accepted, record.distance_cm, __LINE__, "The last stage must get the median of the stages before it");
+        }
+    }
+    UNITY_TEST_ASSERT_EQUAL_UINT32(2, accepted, __LINE__, "Only the records kept by the first stage must fill the window of the median");
+    UNITY_TEST_ASSERT_EQUAL_UINT32(2, test_pipeline.count.count_arr[0], __LINE__, "A dropped record must not reach the next stages");
+}
+
+/**
+ * @brief Test that the lanes of the sensors are independent, also when one of them is reset
+ */
+void test_independent_lanes(void)
+{
+    distance_record_t record;
+    for (uint32_t k = 0; k < FSM_ULTRASOUND_NUM_MEASUREMENTS - 1U; k++)
+    {
+        for (uint32_t lane = 0; lane < DISTANCE_PIPELINE_LANES; lane++)
+        {
+            record = _test_record(10U * (lane + 1U));
+            distance_pipeline_push(&pipeline, lane, &record);
+        }
+    }
+    distance_pipeline_reset(&pipeline, 1);
+
+    for (uint32_t lane = 0; lane < DISTANCE_PIPELINE_LANES; lane++)
+    {
+        record = _test_record(10U * (lane + 1U));
+        bool accepted = distance_pipeline_push(&pipeline, lane, &record);
+        UNITY_TEST_ASSERT_EQUAL_UINT32(lane != 1U, accepted, __LINE__, "The window of a sensor is changed by another sensor");
+        if (accepted)
+        {
+            UNITY_TEST_ASSERT_EQUAL_UINT32(10U * (lane + 1U), record.distance_cm, __LINE__, "The median of a sensor is not the one of its own window");
+        }
+    }
+}
+
+/**
+ * @brief Test that the confidence of a steady distance grows as the history fills, up to the maximum
+ */
+void test_outlier_steady(void)
+{
+    distance_record_t record;
+    uint32_t previous = 0;
+    for (uint32_t k = 0; k < DISTANCE_STAGE_OUTLIER_WINDOW; k++)
+    {
+        UNITY_TEST_ASSERT(_test_push_outlier(150, &record), __LINE__, "A steady distance must never be dropped");
+        UNITY_TEST_ASSERT(record.confidence > previous, __LINE__, "The confidence must grow while the history fills");
+        UNITY_TEST_ASSERT_EQUAL_UINT32(150, record.distance_cm, __LINE__, "The outlier stage must not change the distance");
+        previous = record.confidence;
+    }
+    UNITY_TEST_ASSERT_EQUAL_UINT32(DISTANCE_RECORD_CONFIDENCE_MAX, record.confidence, __LINE__, "A steady distance with a full history must have full confidence");
+}
+
+/**
+ * @brief Test that a jump faster than the maximum closing speed is dropped and a possible one is not
+ */
+void test_outlier_impossible_jump(void)
+{
+    distance_record_t record;
+    for (uint32_t k = 0; k < DISTANCE_STAGE_OUTLIER_WINDOW; k++)
+    {
+        _test_push_outlier(200, &record);
+    }
+    uint32_t possible_cm = (DISTANCE_STAGE_OUTLIER_MAX_SPEED_CM_S * TEST_PERIOD_MS) / 1000U + DISTANCE_STAGE_OUTLIER_MARGIN_CM;
+
+    UNITY_TEST_ASSERT(!_test_push_outlier((uint16_t)(200U - possible_cm - 1U), &record), __LINE__, "A jump faster than the maximum closing speed must be dropped");
+    UNITY_TEST_ASSERT(_test_push_outlier((uint16_t)(200U - possible_cm), &record), __LINE__, "A jump within the maximum closing speed must be taken");
+    UNITY_TEST_ASSERT(record.confidence < DISTANCE_RECORD_CONFIDENCE_MAX, __LINE__, "A distance away from the history must lower the confidence");
+}
+
+/**
+ * @brief Test that an impossible distance is taken after `DISTANCE_STAGE_OUTLIER_MAX_REJECTS` in a row, with the history started again from it
+ */
+void test_outlier_new_obstacle(void)
+{
+    distance_record_t record;
+    for (uint32_t k = 0; k < DISTANCE_STAGE_OUTLIER_WINDOW; k++)
+    {
+        _test_push_outlier(300, &record);
+    }
+    for (uint32_t k = 1; k < DISTANCE_STAGE_OUTLIER_MAX_REJECTS; k++)
+    {
+        UNITY_TEST_ASSERT(!_test_push_outlier(40, &record), __LINE__, "An impossible distance must be dropped");
+    }
+    UNITY_TEST_ASSERT(_test_push_outlier(40, &record), __LINE__, "A new obstacle must be taken after the maximum rejects in a row");
+    UNITY_TEST_ASSERT_EQUAL_UINT32((DISTANCE_RECORD_CONFIDENCE_MAX * 1U) / DISTANCE_STAGE_OUTLIER_WINDOW, record.confidence, __LINE__, "The first distance of a new obstacle must have the confidence of a history of one distance");
+    UNITY_TEST_ASSERT(_test_push_outlier(41, &record), __LINE__, "The distances of the new obstacle must be taken");
+}
+
+/**
+ * @brief Test that the spread of the distances lowers the confidence
+ */
+void test_outlier_noisy(void)
+{
+    distance_record_t record;
+    uint32_t noise_arr[] = {0, 12, 3, 15, 6, 9, 1, 14}; /* Within the jump allowed, but spread */
+    for (uint32_t k = 0; k < 2U * DISTANCE_STAGE_OUTLIER_WINDOW; k++)
+    {
+        UNITY_TEST_ASSERT(_test_push_outlier((uint16_t)(100U + noise_arr[k % 8U]), &record), __LINE__, "A noisy distance within the allowed jump must not be dropped");
+    }
+    UNITY_TEST_ASSERT(record.confidence <= DISTANCE_RECORD_CONFIDENCE_MAX / 2U, __LINE__, "A spread of the distances above the confidence scale must halve the confidence");
+    UNITY_TEST_ASSERT(record.confidence > 0, __LINE__, "A noisy distance must not have zero confidence");
+}
+
+int main(void)
+{
+    port_system_init();
+    UNITY_BEGIN();
+
+    RUN_TEST(test_default_median);
+    RUN_TEST(test_median_confidence);
+    RUN_TEST(test_stage_order);
+    RUN_TEST(test_independent_lanes);
+    RUN_TEST(test_outlier_steady);
+    RUN_TEST(test_outlier_impossible_jump);
+    RUN_TEST(test_outlier_new_obstacle);
+    RUN_TEST(test_outlier_noisy);
+
+    exit(UNITY_END());
+}
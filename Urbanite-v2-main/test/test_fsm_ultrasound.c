@@ -12,8 +12,12 @@
 /* HW independent libraries */
 #include "port_ultrasound.h"
 #include "port_system.h"
+#ifdef FAKE_PORT
+#include "fake_port.h"
+#else
 #include "stm32f4_system.h"
 #include "stm32f4_ultrasound.h"
+#endif
 
 /* Include FSM libraries */
 
@@ -24,10 +28,17 @@
 /* Defines */
 #define PORT_REAR_PARKING_SENSOR_ID 0 /*!< Ultrasound identifier @hideinitializer */
 
+#ifdef FAKE_PORT
+// Timers of the fake port (the common tests run on the host against the fake port, see fake_port.h)
+#define REAR_TRIGGER_TIMER_ENABLED() fake_port_get_trigger_timer_running(PORT_REAR_PARKING_SENSOR_ID) /*!< Trigger signal timer running @hideinitializer */
+#define REAR_ECHO_TIMER_ENABLED() fake_port_get_echo_timer_running(PORT_REAR_PARKING_SENSOR_ID)       /*!< Echo signal timer running @hideinitializer */
+#else
 // Trigger timer configuration
 #define REAR_TRIGGER_TIMER TIM3 /*!< Trigger signal timer @hideinitializer */
 #define REAR_ECHO_TIMER TIM2    /*!< Echo signal timer @hideinitializer */
-#define MEASUREMENT_TIMER TIM5  /*!< Ultrasound measurement timer @hideinitializer */
+#define REAR_TRIGGER_TIMER_ENABLED() ((REAR_TRIGGER_TIMER->CR1) & TIM_CR1_CEN_Msk) /*!< Trigger signal timer running @hideinitializer */
+#define REAR_ECHO_TIMER_ENABLED() ((REAR_ECHO_TIMER->CR1) & TIM_CR1_CEN_Msk)       /*!< Echo signal timer running @hideinitializer */
+#endif
 
 /* Global variables ----------------------------------------------------------*/
 static char msg[200];                      /*!< Buffer for the error messages */
@@ -96,7 +107,7 @@ void test_trigger_end(void)
     UNITY_TEST_ASSERT_EQUAL_UINT32(false, trigger_end, __LINE__, "The trigger pin should be lowered after the trigger signal has ended in the transition from TRIGGER_START to WAIT_ECHO_START");
 
     // Check that the trigger timer is disabled
-    uint32_t tim_trigger_en = (REAR_TRIGGER_TIMER->CR1) & TIM_CR1_CEN_Msk;
+    uint32_t tim_trigger_en = REAR_TRIGGER_TIMER_ENABLED();
     UNITY_TEST_ASSERT_EQUAL_UINT32(false, tim_trigger_en, __LINE__, "The trigger timer should be disabled after the trigger signal has ended in the transition from TRIGGER_START to WAIT_ECHO_START");
 }
 
@@ -220,14 +231,14 @@ void test_stop_measurement(void)
     UNITY_TEST_ASSERT_EQUAL_INT(WAIT_START, fsm_ultrasound_get_state(p_fsm_ultrasound), __LINE__, "The FSM did not change to WAIT_START from SET_DISTANCE after stopping the measurement");
 
     // Check that all the timers have been disabled
-    uint32_t tim_trigger_en = (REAR_TRIGGER_TIMER->CR1) & TIM_CR1_CEN_Msk;
+    uint32_t tim_trigger_en = REAR_TRIGGER_TIMER_ENABLED();
     UNITY_TEST_ASSERT_EQUAL_UINT32(false, tim_trigger_en, __LINE__, "The trigger timer should be disabled after stopping the measurement");
 
-    uint32_t tim_echo_en = (REAR_ECHO_TIMER->CR1) & TIM_CR1_CEN_Msk;
+    uint32_t tim_echo_en = REAR_ECHO_TIMER_ENABLED();
     UNITY_TEST_ASSERT_EQUAL_UINT32(false, tim_echo_en, __LINE__, "The echo timer should be disabled after stopping the measurement");
 
-    uint32_t tim_meas_en = (MEASUREMENT_TIMER->CR1) & TIM_CR1_CEN_Msk;
-    UNITY_TEST_ASSERT_EQUAL_UINT32(false, tim_meas_en, __LINE__, "The measurement timer should be disabled after stopping the measurement");
+    bool meas_running = port_ultrasound_get_measurement_timer_running(PORT_REAR_PARKING_SENSOR_ID);
+    UNITY_TEST_ASSERT_EQUAL_UINT32(false, meas_running, __LINE__, "The measurement timer should be stopped after stopping the measurement");
 
     // Check that all the ticks have been reset
     uint32_t echo_init_tick = port_ultrasound_get_echo_init_tick(PORT_REAR_PARKING_SENSOR_ID);
@@ -244,6 +255,54 @@ void test_stop_measurement(void)
     UNITY_TEST_ASSERT_EQUAL_UINT32(false, echo_received, __LINE__, "The echo signal should be cleared after stopping the measurement");
 }
 
+/**
+ * @brief Check that reading the distance consumes the new measurement
+ *
+ */
+void test_get_distance_clears_new_measurement(void)
+{
+    // Complete a window of measurements of 10 cm
+    for (uint32_t i = 0; i < FSM_ULTRASOUND_NUM_MEASUREMENTS; i++)
+    {
+        fsm_ultrasound_set_state(p_fsm_ultrasound, WAIT_ECHO_END); // Avoids jumping to the next state
+
+        port_ultrasound_set_echo_received(PORT_REAR_PARKING_SENSOR_ID, true);
+        port_ultrasound_set_echo_init_tick(PORT_REAR_PARKING_SENSOR_ID, 1);
+        port_ultrasound_set_echo_end_tick(PORT_REAR_PARKING_SENSOR_ID, 584);
+        port_ultrasound_set_echo_overflows(PORT_REAR_PARKING_SENSOR_ID, 0);
+        fsm_ultrasound_fire(p_fsm_ultrasound);
+    }
+
+    bool new_measurement = fsm_ultrasound_get_new_measurement_ready(p_fsm_ultrasound);
+    UNITY_TEST_ASSERT_EQUAL_UINT32(true, new_measurement, __LINE__, "A new measurement should be ready after a full window of measurements");
+
+    // Check that the distance is read and the flag is cleared
+    uint32_t distance = fsm_ultrasound_get_distance(p_fsm_ultrasound);
+    UNITY_TEST_ASSERT_INT_WITHIN(1, 10, distance, __LINE__, "The distance of the window is not correct");
+
+    new_measurement = fsm_ultrasound_get_new_measurement_ready(p_fsm_ultrasound);
+    UNITY_TEST_ASSERT_EQUAL_UINT32(false, new_measurement, __LINE__, "Reading the distance should clear the new measurement flag");
+}
+
+/**
+ * @brief Check that firing the ultrasound FSM fires its inner FSM
+ *
+ */
+void test_fire_inner_fsm(void)
+{
+    fsm_t *p_inner_fsm = fsm_ultrasound_get_inner_fsm(p_fsm_ultrasound);
+
+    // Set the state to WAIT_ECHO_START with a valid echo init tick
+    port_ultrasound_set_echo_init_tick(PORT_REAR_PARKING_SENSOR_ID, 1);
+    fsm_ultrasound_set_state(p_fsm_ultrasound, WAIT_ECHO_START);
+
+    // Check the transition in the inner FSM
+    fsm_ultrasound_fire(p_fsm_ultrasound);
+    UNITY_TEST_ASSERT_EQUAL_INT(WAIT_ECHO_END, fsm_get_state(p_inner_fsm), __LINE__, "The inner FSM did not change to WAIT_ECHO_END after firing the ultrasound FSM");
+
+    port_ultrasound_reset_echo_ticks(PORT_REAR_PARKING_SENSOR_ID);
+}
+
 int main(void)
 {
     port_system_init();
@@ -255,5 +314,7 @@ int main(void)
     RUN_TEST(test_echo_received_and_distance);
     RUN_TEST(test_new_measurement);
     RUN_TEST(test_stop_measurement);
+    RUN_TEST(test_fire_inner_fsm);
+    RUN_TEST(test_get_distance_clears_new_measurement);
     exit(UNITY_END());
 }
\ No newline at end of file
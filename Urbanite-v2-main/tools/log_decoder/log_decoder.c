@@ -0,0 +1,229 @@
+/**
+ * @file log_decoder.c
+ * @brief Host decoder of the deferred logger.
+ *
+ * It rebuilds the text of the records of port_log.h with the catalog of port_log_messages.h. The input can be:
+ * - a raw stream of records, as written by the native port (default),
+ * - an SWO capture of the ITM, with the packet framing of the ITM (`-i`),
+ * - a memory dump of `port_log_buffer` taken with the debugger (`-r`), e.g., `dump binary value log.bin port_log_buffer` in GDB.
+ *
+ * Usage: log_decoder [-i | -r] [file]. It reads from the standard input if no file is given.
+ *
+ * @date 2025-01-01
+ */
+
+/* Includes ------------------------------------------------------------------*/
+/* Standard C includes */
+#include <stdio.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+
+/* Project includes */
+#include "port_log.h"
+
+/* Defines and enums ----------------------------------------------------------*/
+#define LOG_DECODER_ITM_PORT 0U /*!< ITM stimulus port of the records */
+
+/* Global variables -----------------------------------------------------------*/
+static const char *formats_arr[PORT_LOG_NUM_MESSAGES] = {
+#define LOG_DECODER_X_FORMAT(id, format) [id] = format,
+    PORT_LOG_MESSAGES(LOG_DECODER_X_FORMAT)
+#undef LOG_DECODER_X_FORMAT
+}; /*!< Format of each message ID */
+
+static const char *levels_arr[] = {"NONE", "ERROR", "WARN", "INFO", "DEBUG"}; /*!< Name of each level */
+
+/* Private functions ----------------------------------------------------------*/
+/**
+ * @brief Print a record
+ * @param header Header of the record
+ * @param timestamp Timestamp in microseconds
+ * @param p_args Arguments of the record
+ */
+static void _log_decoder_print(uint32_t header, uint32_t timestamp, const uint32_t *p_args)
+{
+    uint32_t id = PORT_LOG_HEADER_ID(header);
+    uint32_t level = PORT_LOG_HEADER_LEVEL(header);
+    printf("[%5u.%06u] %-5s ", timestamp / 1000000U, timestamp % 1000000U, (level < sizeof(levels_arr) / sizeof(levels_arr[0])) ? levels_arr[level] : "?");
+    if (id < PORT_LOG_NUM_MESSAGES)
+    {
+        printf(formats_arr[id], p_args[0], p_args[1], p_args[2], p_args[3]);
+    }
+    else
+    {
+        printf("Unknown message %u (%u %u %u %u)", id, p_args[0], p_args[1], p_args[2], p_args[3]);
+    }
+    printf("\n");
+}
+
+/**
+ * @brief Decoder of a stream of words. The records are rebuilt word by word, so the same decoder serves all the inputs
+ */
+typedef struct
+{
+    uint32_t words[PORT_LOG_HEADER_WORDS + PORT_LOG_MAX_ARGS]; /*!< Words of the current record */
+    uint32_t count;                                            /*!< Number of words of the current record */
+    uint32_t records;                                          /*!< Records decoded */
+    uint32_t skipped;                                          /*!< Words skipped to find a header */
+} log_decoder_t;
+
+/**
+ * @brief Feed a word to the decoder
+ * @param p_decoder Pointer to the decoder
+ * @param word Next word of the stream
+ */
+static void _log_decoder_feed(log_decoder_t *p_decoder, uint32_t word)
+{
+    if ((p_decoder->count == 0U) && (!PORT_LOG_HEADER_IS_VALID(word) || (PORT_LOG_HEADER_NARGS(word) > PORT_LOG_MAX_ARGS)))
+    {
+        p_decoder->skipped++; /* Resynchronize after a corrupted or truncated record */
+        return;
+    }
+    p_decoder->words[p_decoder->count++] = word;
+    uint32_t nargs = PORT_LOG_HEADER_NARGS(p_decoder->words[0]);
+    if (p_decoder->count == (PORT_LOG_HEADER_WORDS + nargs))
+    {
+        uint32_t args[PORT_LOG_MAX_ARGS] = {0};
+        memcpy(args, &p_decoder->words[PORT_LOG_HEADER_WORDS], nargs * sizeof(uint32_t));
+        _log_decoder_print(p_decoder->words[0], p_decoder->words[1], args);
+        p_decoder->count = 0;
+        p_decoder->records++;
+    }
+}
+
+/**
+ * @brief Decode a raw stream of little-endian words
+ * @param p_file Input file
+ * @param p_decoder Pointer to the decoder
+ */
+static void _log_decoder_raw(FILE *p_file, log_decoder_t *p_decoder)
+{
+    uint8_t bytes[4];
+    while (fread(bytes, 1, sizeof(bytes), p_file) == sizeof(bytes))
+    {
+        _log_decoder_feed(p_decoder, (uint32_t)bytes[0] | ((uint32_t)bytes[1] << 8) | ((uint32_t)bytes[2] << 16) | ((uint32_t)bytes[3] << 24));
+    }
+}
+
+/**
+ * @brief Decode an SWO capture. Only the 32-bit writes to the stimulus port of the records are kept
+ * @param p_file Input file
+ * @param p_decoder Pointer to the decoder
+ */
+static void _log_decoder_itm(FILE *p_file, log_decoder_t *p_decoder)
+{
+    int c;
+    while ((c = fgetc(p_file)) != EOF)
+    {
+        uint8_t header = (uint8_t)c;
+        if ((header & 0x03U) != 0U)
+        {
+            /* Source packet: software (stimulus port) or hardware, with 1, 2 or 4 bytes of payload */
+            uint32_t size = ((header & 0x03U) == 3U) ? 4U : (header & 0x03U);
+            uint32_t payload = 0;
+            for (uint32_t i = 0; i < size; i++)
+            {
+                if ((c = fgetc(p_file)) == EOF)
+                {
+                    return;
+                }
+                payload |= (uint32_t)c << (8U * i);
+            }
+            if (((header & 0x04U) == 0U) && ((header >> 3) == LOG_DECODER_ITM_PORT) && (size == 4U))
+            {
+                _log_decoder_feed(p_decoder, payload);
+            }
+        }
+        else if (((header & 0x0FU) == 0U) && ((header & 0x80U) != 0U))
+        {
+            /* Timestamp packet with continuation bytes */
+            while (((c = fgetc(p_file)) != EOF) && ((c & 0x80) != 0))
+            {
+            }
+        }
+        /* Synchronization and overflow packets have no payload */
+    }
+}
+
+/**
+ * @brief Decode a memory dump of `port_log_buffer`. The records not sent yet are decoded
+ * @param p_file Input file
+ * @param p_decoder Pointer to the decoder
+ * @return true if the dump is valid
+ */
+static bool _log_decoder_ring(FILE *p_file, log_decoder_t *p_decoder)
+{
+    port_log_buffer_t buffer;
+    if ((fread(&buffer, 1, sizeof(buffer), p_file) != sizeof(buffer)) || (buffer.magic != PORT_LOG_MAGIC) || (buffer.size_words != PORT_LOG_BUFFER_WORDS))
+    {
+        return false;
+    }
+    for (uint32_t i = buffer.tail; i != buffer.head; i++)
+    {
+        _log_decoder_feed(p_decoder, buffer.words[i & (PORT_LOG_BUFFER_WORDS - 1U)]);
+    }
+    if (buffer.dropped > 0U)
+    {
+        printf("%u records lost (buffer full)\n", buffer.dropped);
+    }
+    return true;
+}
+
+int main(int argc, char *argv[])
+{
+    bool itm = false;
+    bool ring = false;
+    const char *p_path = NULL;
+    for (int i = 1; i < argc; i++)
+    {
+        if (strcmp(argv[i], "-i") == 0)
+        {
+            itm = true;
+        }
+        else if (strcmp(argv[i], "-r") == 0)
+        {
+            ring = true;
+        }
+        else
+        {
+            p_path = argv[i];
+        }
+    }
+
+    FILE *p_file = (p_path != NULL) ? fopen(p_path, "rb") : stdin;
+    if (p_file == NULL)
+    {
+        fprintf(stderr, "Cannot open %s\n", p_path);
+        return 1;
+    }
+
+    log_decoder_t decoder = {.count = 0, .records = 0, .skipped = 0};
+    int ret = 0;
+    if (ring)
+    {
+        if (!_log_decoder_ring(p_file, &decoder))
+        {
+            fprintf(stderr, "Not a dump of port_log_buffer\n");
+            ret = 1;
+        }
+    }
+    else if (itm)
+    {
+        _log_decoder_itm(p_file, &decoder);
+    }
+    else
+    {
+        _log_decoder_raw(p_file, &decoder);
+    }
+
+    if (decoder.skipped > 0U)
+    {
+        fprintf(stderr, "%u words skipped to resynchronize\n", decoder.skipped);
+    }
+    if (p_file != stdin)
+    {
+        fclose(p_file);
+    }
+    return ret;
+}
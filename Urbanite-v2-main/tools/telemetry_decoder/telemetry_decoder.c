@@ -0,0 +1,604 @@
+/**
+ * @file telemetry_decoder.c
+ * @brief Host decoder and live statistics of the telemetry stream.
+ *
+ * It decodes the frames of port_telemetry.h from one or more inputs (serial devices, pseudo-terminals, FIFOs or captured files) and computes, for each sensor of each input:
+ * - records, rate and last median distance,
+ * - interval between records and its jitter (standard deviation), from the timestamps of the board,
+ * - latency of the frames: arrival time in the host minus the timestamp of the board, above the lowest value seen, so the offset between both clocks cancels out,
+ * - dropped frames (gaps in the sequence numbers), CRC errors and records without echo,
+ * - histogram of the median distances.
+ *
+ * Each input is read and decoded by its own thread, which is the only writer of the statistics of its input. The counters are C11 atomics written with relaxed loads and stores (no read-modify-write is needed with a single writer) and read by the main thread, so the aggregation takes no lock and the readers never wait for the report.
+ *
+ * Usage: telemetry_decoder [-b baudrate] [-t seconds] [-c file.csv] [-j file.json] [-q] input...
+ * - `-b`: baud rate of the serial devices (default 115200). It is ignored for the other inputs.
+ * - `-t`: period of the live summary and of the CSV rows (default 1 s).
+ * - `-c`: append one CSV row per sensor and period.
+ * - `-j`: write a JSON summary with the histograms when all the inputs end or on Ctrl+C.
+ * - `-q`: no live summary.
+ *
+ * @date 2025-01-01
+ */
+
+/* Includes ------------------------------------------------------------------*/
+/* Standard C includes */
+#define _DEFAULT_SOURCE /* cfmakeraw(), extended baud rates */
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdatomic.h>
+#include <string.h>
+#include <math.h>
+#include <signal.h>
+#include <time.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <termios.h>
+#include <pthread.h>
+
+/* Project includes */
+#include "port_telemetry.h"
+
+/* Defines and enums ----------------------------------------------------------*/
+#define TELEMETRY_DECODER_MAX_SENSORS 256U      /*!< Sensor IDs are 8-bit */
+#define TELEMETRY_DECODER_HIST_BIN_CM 10U       /*!< Width of a bin of the histogram of distances */
+#define TELEMETRY_DECODER_HIST_BINS 41U         /*!< Bins of the histogram. The last one counts the distances of 400 cm or more */
+#define TELEMETRY_DECODER_READ_SIZE 65536U      /*!< Bytes read at once from an input */
+#define TELEMETRY_DECODER_DEFAULT_BAUD 115200U  /*!< Default baud rate of the serial devices */
+
+/* Typedefs --------------------------------------------------------------------*/
+/**
+ * @brief Statistics of a sensor. They are written by the thread of its input and read by the main thread
+ */
+typedef struct
+{
+    _Atomic uint64_t records;                                    /*!< Records decoded */
+    _Atomic uint64_t no_echo;                                    /*!< Records with `PORT_TELEMETRY_FLAG_NO_ECHO` */
+    _Atomic uint64_t intervals;                                  /*!< Intervals measured between consecutive records */
+    _Atomic uint64_t interval_sum_us;                            /*!< Sum of the intervals */
+    _Atomic uint64_t interval_sq_sum_us2;                        /*!< Sum of the squares of the intervals */
+    _Atomic uint32_t last_median_cm;                             /*!< Last median distance */
+    _Atomic uint32_t histogram_arr[TELEMETRY_DECODER_HIST_BINS]; /*!< Histogram of the median distances */
+    uint32_t last_timestamp_us;                                  /*!< Timestamp of the previous record. Private to the reader thread */
+    bool seen;                                                   /*!< A record has been decoded. Private to the reader thread */
+    uint64_t reported_records;                                   /*!< Records at the previous live summary. Private to the main thread */
+} sensor_stats_t;
+
+/**
+ * @brief Input stream and its decoder
+ */
+typedef struct
+{
+    const char *p_path;                                        /*!< Path of the input */
+    int fd;                                                    /*!< File descriptor */
+    pthread_t thread;                                          /*!< Reader thread */
+    _Atomic bool done;                                         /*!< The input has ended */
+    _Atomic uint64_t bytes;                                    /*!< Bytes read */
+    _Atomic uint64_t frames;                                   /*!< Valid frames */
+    _Atomic uint64_t crc_errors;                               /*!< Frames with a wrong CRC */
+    _Atomic uint64_t format_errors;                            /*!< Frames with a wrong COBS encoding, length or version */
+    _Atomic uint64_t lost_frames;                              /*!< Frames missing in the sequence numbers */
+    _Atomic uint64_t latency_count;                            /*!< Latencies measured */
+    _Atomic uint64_t latency_sum_us;                           /*!< Sum of the latencies */
+    _Atomic uint64_t latency_max_us;                           /*!< Maximum latency */
+    sensor_stats_t sensors_arr[TELEMETRY_DECODER_MAX_SENSORS]; /*!< Statistics of each sensor */
+    uint8_t encoded_arr[PORT_TELEMETRY_FRAME_MAX_SIZE];        /*!< Bytes of the frame being received. Private to the reader thread */
+    uint32_t encoded_len;                                      /*!< Bytes in `encoded_arr`. Private to the reader thread */
+    bool overrun;                                              /*!< The frame being received is too long. Private to the reader thread */
+    uint8_t last_seq;                                          /*!< Sequence number of the previous frame. Private to the reader thread */
+    bool seq_seen;                                             /*!< A frame has been decoded. Private to the reader thread */
+    int64_t min_offset_us;                                     /*!< Lowest difference between the host and the board clocks. Private to the reader thread */
+} input_t;
+
+/* Global variables -----------------------------------------------------------*/
+static input_t *inputs_arr = NULL;       /*!< Inputs */
+static uint32_t num_inputs = 0;          /*!< Number of inputs */
+static uint16_t crc_table_arr[256];      /*!< CRC-16/CCITT-FALSE of each byte */
+static volatile sig_atomic_t stop = 0;   /*!< Ctrl+C received */
+
+/* Private functions ----------------------------------------------------------*/
+/**
+ * @brief Add to a counter with a single writer. A relaxed load and store is enough and avoids the locked read-modify-write
+ * @param p_counter Pointer to the counter
+ * @param value Value to add
+ */
+static inline void _stat_add(_Atomic uint64_t *p_counter, uint64_t value)
+{
+    atomic_store_explicit(p_counter, atomic_load_explicit(p_counter, memory_order_relaxed) + value, memory_order_relaxed);
+}
+
+/**
+ * @brief Read a counter written by another thread
+ * @param p_counter Pointer to the counter
+ * @return Value of the counter
+ */
+static inline uint64_t _stat_get(_Atomic uint64_t *p_counter)
+{
+    return atomic_load_explicit(p_counter, memory_order_relaxed);
+}
+
+/**
+ * @brief Get the time of the host
+ * @return Monotonic time in microseconds
+ */
+static uint64_t _now_us(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ((uint64_t)ts.tv_sec * 1000000U) + ((uint64_t)ts.tv_nsec / 1000U);
+}
+
+/**
+ * @brief Build the table of the CRC. The board uses a nibble table to save flash; the host uses a byte table to go faster
+ */
+static void _crc_table_init(void)
+{
+    for (uint32_t byte = 0; byte < 256U; byte++)
+    {
+        uint16_t crc = (uint16_t)(byte << 8);
+        for (uint32_t bit = 0; bit < 8U; bit++)
+        {
+            crc = (crc & 0x8000U) ? (uint16_t)((crc << 1) ^ 0x1021U) : (uint16_t)(crc << 1);
+        }
+        crc_table_arr[byte] = crc;
+    }
+}
+
+/**
+ * @brief Decode a COBS frame without its delimiter
+ * @param p_encoded Encoded bytes
+ * @param length Number of encoded bytes
+ * @param p_payload Buffer for the decoded bytes. It must be as long as the encoded frame
+ * @return Number of decoded bytes. 0 if the encoding is wrong
+ */
+static uint32_t _cobs_decode(const uint8_t *p_encoded, uint32_t length, uint8_t *p_payload)
+{
+    uint32_t out = 0;
+    uint32_t idx = 0;
+    while (idx < length)
+    {
+        uint8_t code = p_encoded[idx++];
+        if ((code == 0U) || ((idx + code - 1U) > length))
+        {
+            return 0;
+        }
+        memcpy(&p_payload[out], &p_encoded[idx], code - 1U);
+        out += code - 1U;
+        idx += code - 1U;
+        if ((code != 0xFFU) && (idx < length))
+        {
+            p_payload[out++] = 0;
+        }
+    }
+    return out;
+}
+
+/**
+ * @brief Read a little-endian field
+ * @param p_bytes Pointer to the field
+ * @param size Bytes of the field
+ * @return Value of the field
+ */
+static uint32_t _get_le(const uint8_t *p_bytes, uint32_t size)
+{
+    uint32_t value = 0;
+    for (uint32_t i = 0; i < size; i++)
+    {
+        value |= (uint32_t)p_bytes[i] << (8U * i);
+    }
+    return value;
+}
+
+/**
+ * @brief Check and account a complete frame
+ * @param p_input Pointer to the input
+ * @param arrival_us Time of the host when the frame was read
+ */
+static void _process_frame(input_t *p_input, uint64_t arrival_us)
+{
+    uint8_t payload[PORT_TELEMETRY_FRAME_MAX_SIZE];
+    uint32_t length = _cobs_decode(p_input->encoded_arr, p_input->encoded_len, payload);
+    if ((length < (PORT_TELEMETRY_HEADER_SIZE + PORT_TELEMETRY_RECORD_SIZE + PORT_TELEMETRY_CRC_SIZE)) ||
+        (((length - PORT_TELEMETRY_HEADER_SIZE - PORT_TELEMETRY_CRC_SIZE) % PORT_TELEMETRY_RECORD_SIZE) != 0U) ||
+        (payload[0] != PORT_TELEMETRY_VERSION))
+    {
+        _stat_add(&p_input->format_errors, 1);
+        return;
+    }
+    uint16_t crc = PORT_TELEMETRY_CRC_INIT;
+    for (uint32_t i = 0; i < (length - PORT_TELEMETRY_CRC_SIZE); i++)
+    {
+        crc = (uint16_t)((crc << 8) ^ crc_table_arr[(crc >> 8) ^ payload[i]]);
+    }
+    if (crc != (uint16_t)_get_le(&payload[length - PORT_TELEMETRY_CRC_SIZE], PORT_TELEMETRY_CRC_SIZE))
+    {
+        _stat_add(&p_input->crc_errors, 1);
+        return;
+    }
+
+    uint8_t seq = payload[1];
+    if (p_input->seq_seen)
+    {
+        _stat_add(&p_input->lost_frames, (uint8_t)(seq - p_input->last_seq - 1U));
+    }
+    p_input->last_seq = seq;
+    p_input->seq_seen = true;
+    _stat_add(&p_input->frames, 1);
+
+    uint32_t num_records = (length - PORT_TELEMETRY_HEADER_SIZE - PORT_TELEMETRY_CRC_SIZE) / PORT_TELEMETRY_RECORD_SIZE;
+    uint32_t last_timestamp_us = 0;
+    for (uint32_t r = 0; r < num_records; r++)
+    {
+        const uint8_t *p_record = &payload[PORT_TELEMETRY_HEADER_SIZE + (r * PORT_TELEMETRY_RECORD_SIZE)];
+        sensor_stats_t *p_sensor = &p_input->sensors_arr[p_record[0]];
+        uint8_t flags = p_record[1];
+        uint32_t timestamp_us = _get_le(&p_record[2], 4U);
+        uint32_t median_cm = _get_le(&p_record[6], 2U);
+
+        if (p_sensor->seen)
+        {
+            uint64_t interval_us = (uint32_t)(timestamp_us - p_sensor->last_timestamp_us); /* The clock of the board wraps every 71 minutes */
+            _stat_add(&p_sensor->intervals, 1);
+            _stat_add(&p_sensor->interval_sum_us, interval_us);
+            _stat_add(&p_sensor->interval_sq_sum_us2, interval_us * interval_us);
+        }
+        p_sensor->last_timestamp_us = timestamp_us;
+        p_sensor->seen = true;
+
+        _stat_add(&p_sensor->records, 1);
+        if ((flags & PORT_TELEMETRY_FLAG_NO_ECHO) != 0U)
+        {
+            _stat_add(&p_sensor->no_echo, 1);
+        }
+        atomic_store_explicit(&p_sensor->last_median_cm, median_cm, memory_order_relaxed);
+        uint32_t bin = median_cm / TELEMETRY_DECODER_HIST_BIN_CM;
+        bin = (bin < TELEMETRY_DECODER_HIST_BINS) ? bin : (TELEMETRY_DECODER_HIST_BINS - 1U);
+        atomic_store_explicit(&p_sensor->histogram_arr[bin], atomic_load_explicit(&p_sensor->histogram_arr[bin], memory_order_relaxed) + 1U, memory_order_relaxed);
+        last_timestamp_us = timestamp_us;
+    }
+
+    /* The frame is sent when its last record is added, so the latency is measured from the last record */
+    int64_t offset_us = (int64_t)arrival_us - (int64_t)last_timestamp_us;
+    if ((_stat_get(&p_input->latency_count) == 0U) || (offset_us < p_input->min_offset_us))
+    {
+        p_input->min_offset_us = offset_us;
+    }
+    uint64_t latency_us = (uint64_t)(offset_us - p_input->min_offset_us);
+    _stat_add(&p_input->latency_count, 1);
+    _stat_add(&p_input->latency_sum_us, latency_us);
+    if (latency_us > _stat_get(&p_input->latency_max_us))
+    {
+        atomic_store_explicit(&p_input->latency_max_us, latency_us, memory_order_relaxed);
+    }
+}
+
+/**
+ * @brief Split the bytes of an input into frames
+ * @param p_input Pointer to the input
+ * @param p_bytes Bytes read
+ * @param length Number of bytes
+ * @param arrival_us Time of the host when the bytes were read
+ */
+static void _feed(input_t *p_input, const uint8_t *p_bytes, uint32_t length, uint64_t arrival_us)
+{
+    for (uint32_t i = 0; i < length; i++)
+    {
+        uint8_t byte = p_bytes[i];
+        if (byte == PORT_TELEMETRY_DELIMITER)
+        {
+            if (p_input->overrun)
+            {
+                _stat_add(&p_input->format_errors, 1);
+            }
+            else if (p_input->encoded_len > 0U)
+            {
+                _process_frame(p_input, arrival_us);
+            }
+            p_input->encoded_len = 0;
+            p_input->overrun = false;
+        }
+        else if (p_input->encoded_len < PORT_TELEMETRY_FRAME_MAX_SIZE)
+        {
+            p_input->encoded_arr[p_input->encoded_len++] = byte;
+        }
+        else
+        {
+            p_input->overrun = true; /* Resynchronize at the next delimiter */
+        }
+    }
+}
+
+/**
+ * @brief Reader thread of an input
+ * @param p_arg Pointer to the input
+ * @return NULL
+ */
+static void *_reader_thread(void *p_arg)
+{
+    input_t *p_input = (input_t *)p_arg;
+    uint8_t *p_buffer = malloc(TELEMETRY_DECODER_READ_SIZE);
+    while ((p_buffer != NULL) && !stop)
+    {
+        ssize_t n = read(p_input->fd, p_buffer, TELEMETRY_DECODER_READ_SIZE);
+        if ((n < 0) && (errno == EINTR))
+        {
+            continue;
+        }
+        if (n <= 0)
+        {
+            break; /* End of file, or the other side of the pseudo-terminal has been closed */
+        }
+        _stat_add(&p_input->bytes, (uint64_t)n);
+        _feed(p_input, p_buffer, (uint32_t)n, _now_us());
+    }
+    free(p_buffer);
+    atomic_store_explicit(&p_input->done, true, memory_order_release);
+    return NULL;
+}
+
+/**
+ * @brief Configure a serial device in raw mode
+ * @param fd File descriptor of the device
+ * @param baudrate Baud rate
+ */
+static void _configure_serial(int fd, uint32_t baudrate)
+{
+    static const struct
+    {
+        uint32_t baudrate;
+        speed_t speed;
+    } speeds_arr[] = {{9600, B9600}, {19200, B19200}, {38400, B38400}, {57600, B57600}, {115200, B115200}, {230400, B230400}, {460800, B460800}, {921600, B921600}, {1000000, B1000000}, {2000000, B2000000}, {3000000, B3000000}, {4000000, B4000000}};
+    struct termios tio;
+    if (tcgetattr(fd, &tio) != 0)
+    {
+        return;
+    }
+    cfmakeraw(&tio);
+    for (uint32_t i = 0; i < sizeof(speeds_arr) / sizeof(speeds_arr[0]); i++)
+    {
+        if (speeds_arr[i].baudrate == baudrate)
+        {
+            cfsetspeed(&tio, speeds_arr[i].speed);
+        }
+    }
+    tio.c_cc[VMIN] = 1;
+    tio.c_cc[VTIME] = 0;
+    tcsetattr(fd, TCSANOW, &tio);
+}
+
+/**
+ * @brief Print the live summary and append the CSV rows
+ * @param p_csv CSV file. NULL if not requested
+ * @param live Print the live summary
+ * @param elapsed_s Time since the start
+ * @param period_s Time since the previous summary
+ */
+static void _report(FILE *p_csv, bool live, double elapsed_s, double period_s)
+{
+    if (live)
+    {
+        if (isatty(STDOUT_FILENO))
+        {
+            printf("\033[H\033[2J"); /* Clear the terminal */
+        }
+        printf("%7.1f s\n%-20s %6s %10s %8s %9s %9s %9s %9s %7s %7s %7s\n", elapsed_s, "input", "sensor", "records", "rate/s", "lat ms", "lat max", "period ms", "jitter ms", "lost", "crc", "dist cm");
+    }
+    for (uint32_t i = 0; i < num_inputs; i++)
+    {
+        input_t *p_input = &inputs_arr[i];
+        uint64_t latency_count = _stat_get(&p_input->latency_count);
+        double latency_ms = (latency_count > 0U) ? ((double)_stat_get(&p_input->latency_sum_us) / (double)latency_count / 1000.0) : 0.0;
+        double latency_max_ms = (double)_stat_get(&p_input->latency_max_us) / 1000.0;
+        for (uint32_t s = 0; s < TELEMETRY_DECODER_MAX_SENSORS; s++)
+        {
+            sensor_stats_t *p_sensor = &p_input->sensors_arr[s];
+            uint64_t records = _stat_get(&p_sensor->records);
+            if (records == 0U)
+            {
+                continue;
+            }
+            double rate = (period_s > 0.0) ? ((double)(records - p_sensor->reported_records) / period_s) : 0.0;
+            p_sensor->reported_records = records;
+            uint64_t intervals = _stat_get(&p_sensor->intervals);
+            double mean_us = (intervals > 0U) ? ((double)_stat_get(&p_sensor->interval_sum_us) / (double)intervals) : 0.0;
+            double var_us2 = (intervals > 0U) ? (((double)_stat_get(&p_sensor->interval_sq_sum_us2) / (double)intervals) - (mean_us * mean_us)) : 0.0;
+            double jitter_ms = (var_us2 > 0.0) ? (sqrt(var_us2) / 1000.0) : 0.0;
+            uint32_t median_cm = atomic_load_explicit(&p_sensor->last_median_cm, memory_order_relaxed);
+            if (live)
+            {
+                printf("%-20.20s %6u %10llu %8.1f %9.2f %9.2f %9.2f %9.3f %7llu %7llu %7u\n", p_input->p_path, s, (unsigned long long)records, rate, latency_ms, latency_max_ms, mean_us / 1000.0, jitter_ms,
+                       (unsigned long long)_stat_get(&p_input->lost_frames), (unsigned long long)_stat_get(&p_input->crc_errors), median_cm);
+            }
+            if (p_csv != NULL)
+            {
+                fprintf(p_csv, "%.3f,%s,%u,%llu,%.3f,%.3f,%.3f,%.3f,%.3f,%llu,%llu,%llu,%llu,%u\n", elapsed_s, p_input->p_path, s, (unsigned long long)records, rate, latency_ms, latency_max_ms, mean_us / 1000.0, jitter_ms,
+                        (unsigned long long)_stat_get(&p_input->lost_frames), (unsigned long long)_stat_get(&p_input->crc_errors), (unsigned long long)_stat_get(&p_input->format_errors), (unsigned long long)_stat_get(&p_sensor->no_echo), median_cm);
+            }
+        }
+    }
+    if (live)
+    {
+        fflush(stdout);
+    }
+    if (p_csv != NULL)
+    {
+        fflush(p_csv);
+    }
+}
+
+/**
+ * @brief Write the JSON summary
+ * @param p_json JSON file
+ * @param elapsed_s Time since the start
+ */
+static void _write_json(FILE *p_json, double elapsed_s)
+{
+    fprintf(p_json, "{\n  \"elapsed_s\": %.3f,\n  \"histogram_bin_cm\": %u,\n  \"inputs\": [", elapsed_s, TELEMETRY_DECODER_HIST_BIN_CM);
+    for (uint32_t i = 0; i < num_inputs; i++)
+    {
+        input_t *p_input = &inputs_arr[i];
+        uint64_t latency_count = _stat_get(&p_input->latency_count);
+        fprintf(p_json, "%s\n    {\"path\": \"%s\", \"bytes\": %llu, \"frames\": %llu, \"lost_frames\": %llu, \"crc_errors\": %llu, \"format_errors\": %llu, \"latency_avg_ms\": %.3f, \"latency_max_ms\": %.3f, \"sensors\": [",
+                (i > 0U) ? "," : "", p_input->p_path, (unsigned long long)_stat_get(&p_input->bytes), (unsigned long long)_stat_get(&p_input->frames), (unsigned long long)_stat_get(&p_input->lost_frames),
+                (unsigned long long)_stat_get(&p_input->crc_errors), (unsigned long long)_stat_get(&p_input->format_errors),
+                (latency_count > 0U) ? ((double)_stat_get(&p_input->latency_sum_us) / (double)latency_count / 1000.0) : 0.0, (double)_stat_get(&p_input->latency_max_us) / 1000.0);
+        bool first = true;
+        for (uint32_t s = 0; s < TELEMETRY_DECODER_MAX_SENSORS; s++)
+        {
+            sensor_stats_t *p_sensor = &p_input->sensors_arr[s];
+            uint64_t records = _stat_get(&p_sensor->records);
+            if (records == 0U)
+            {
+                continue;
+            }
+            uint64_t intervals = _stat_get(&p_sensor->intervals);
+            double mean_us = (intervals > 0U) ? ((double)_stat_get(&p_sensor->interval_sum_us) / (double)intervals) : 0.0;
+            double var_us2 = (intervals > 0U) ? (((double)_stat_get(&p_sensor->interval_sq_sum_us2) / (double)intervals) - (mean_us * mean_us)) : 0.0;
+            fprintf(p_json, "%s\n      {\"id\": %u, \"records\": %llu, \"rate_hz\": %.3f, \"no_echo\": %llu, \"interval_avg_ms\": %.3f, \"jitter_ms\": %.3f, \"last_median_cm\": %u, \"histogram\": [",
+                    first ? "" : ",", s, (unsigned long long)records, (mean_us > 0.0) ? (1000000.0 / mean_us) : 0.0, (unsigned long long)_stat_get(&p_sensor->no_echo), mean_us / 1000.0,
+                    (var_us2 > 0.0) ? (sqrt(var_us2) / 1000.0) : 0.0, atomic_load_explicit(&p_sensor->last_median_cm, memory_order_relaxed));
+            for (uint32_t b = 0; b < TELEMETRY_DECODER_HIST_BINS; b++)
+            {
+                fprintf(p_json, "%s%u", (b > 0U) ? ", " : "", atomic_load_explicit(&p_sensor->histogram_arr[b], memory_order_relaxed));
+            }
+            fprintf(p_json, "]}");
+            first = false;
+        }
+        fprintf(p_json, "\n    ]}");
+    }
+    fprintf(p_json, "\n  ]\n}\n");
+}
+
+/**
+ * @brief Handler of Ctrl+C
+ * @param signum Signal number
+ */
+static void _on_signal(int signum)
+{
+    stop = 1;
+}
+
+int main(int argc, char *argv[])
+{
+    uint32_t baudrate = TELEMETRY_DECODER_DEFAULT_BAUD;
+    double period_s = 1.0;
+    const char *p_csv_path = NULL;
+    const char *p_json_path = NULL;
+    bool live = true;
+    int opt;
+    while ((opt = getopt(argc, argv, "b:t:c:j:q")) != -1)
+    {
+        switch (opt)
+        {
+        case 'b':
+            baudrate = (uint32_t)strtoul(optarg, NULL, 10);
+            break;
+        case 't':
+            period_s = strtod(optarg, NULL);
+            break;
+        case 'c':
+            p_csv_path = optarg;
+            break;
+        case 'j':
+            p_json_path = optarg;
+            break;
+        case 'q':
+            live = false;
+            break;
+        default:
+            fprintf(stderr, "Usage: %s [-b baudrate] [-t seconds] [-c file.csv] [-j file.json] [-q] input...\n", argv[0]);
+            return 1;
+        }
+    }
+    num_inputs = (uint32_t)(argc - optind);
+    if ((num_inputs == 0U) || (period_s <= 0.0))
+    {
+        fprintf(stderr, "Usage: %s [-b baudrate] [-t seconds] [-c file.csv] [-j file.json] [-q] input...\n", argv[0]);
+        return 1;
+    }
+
+    FILE *p_csv = NULL;
+    if (p_csv_path != NULL)
+    {
+        p_csv = fopen(p_csv_path, "w");
+        if (p_csv == NULL)
+        {
+            fprintf(stderr, "Cannot open %s\n", p_csv_path);
+            return 1;
+        }
+        fprintf(p_csv, "time_s,input,sensor,records,rate_hz,latency_avg_ms,latency_max_ms,interval_avg_ms,jitter_ms,lost_frames,crc_errors,format_errors,no_echo,last_median_cm\n");
+    }
+
+    _crc_table_init();
+    signal(SIGINT, _on_signal);
+    inputs_arr = calloc(num_inputs, sizeof(input_t));
+    if (inputs_arr == NULL)
+    {
+        return 1;
+    }
+    for (uint32_t i = 0; i < num_inputs; i++)
+    {
+        input_t *p_input = &inputs_arr[i];
+        p_input->p_path = argv[optind + (int)i];
+        p_input->fd = open(p_input->p_path, O_RDONLY | O_NOCTTY);
+        if (p_input->fd < 0)
+        {
+            fprintf(stderr, "Cannot open %s\n", p_input->p_path);
+            return 1;
+        }
+        if (isatty(p_input->fd))
+        {
+            _configure_serial(p_input->fd, baudrate);
+        }
+        pthread_create(&p_input->thread, NULL, _reader_thread, p_input);
+    }
+
+    uint64_t start_us = _now_us();
+    uint64_t last_report_us = start_us;
+    bool all_done = false;
+    while (!all_done && !stop)
+    {
+        struct timespec ts = {.tv_sec = 0, .tv_nsec = 50000000}; /* Check the end of the inputs every 50 ms */
+        nanosleep(&ts, NULL);
+        all_done = true;
+        for (uint32_t i = 0; i < num_inputs; i++)
+        {
+            all_done = all_done && atomic_load_explicit(&inputs_arr[i].done, memory_order_acquire);
+        }
+        uint64_t now_us = _now_us();
+        if (all_done || ((double)(now_us - last_report_us) >= (period_s * 1e6)))
+        {
+            _report(p_csv, live, (double)(now_us - start_us) / 1e6, (double)(now_us - last_report_us) / 1e6);
+            last_report_us = now_us;
+        }
+    }
+
+    for (uint32_t i = 0; i < num_inputs; i++)
+    {
+        if (!atomic_load_explicit(&inputs_arr[i].done, memory_order_acquire))
+        {
+            pthread_cancel(inputs_arr[i].thread); /* Blocked in read() */
+        }
+        pthread_join(inputs_arr[i].thread, NULL);
+        close(inputs_arr[i].fd);
+    }
+
+    if (p_json_path != NULL)
+    {
+        FILE *p_json = fopen(p_json_path, "w");
+        if (p_json != NULL)
+        {
+            _write_json(p_json, (double)(_now_us() - start_us) / 1e6);
+            fclose(p_json);
+        }
+    }
+    if (p_csv != NULL)
+    {
+        fclose(p_csv);
+    }
+    free(inputs_arr);
+    return 0;
+}